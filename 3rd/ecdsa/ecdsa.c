@@ -432,13 +432,13 @@ void point_multiply(const ecdsa_curve *curve, const bignum256 *k, const curve_po
 	assert (bn_is_less(k, &curve->order));
 
 	int i, j;
-	static CONFIDENTIAL bignum256 a;
+	bignum256 a;
 	uint32_t *aptr;
 	uint32_t abits;
 	int ashift;
 	uint32_t is_even = (k->val[0] & 1) - 1;
 	uint32_t bits, sign, nsign;
-	static CONFIDENTIAL jacobian_curve_point jres;
+	jacobian_curve_point jres;
 	curve_point pmult[8];
 	const bignum256 *prime = &curve->prime;
 
@@ -546,22 +546,24 @@ void point_multiply(const ecdsa_curve *curve, const bignum256 *k, const curve_po
 
 #if USE_PRECOMPUTED_CP
 
-// res = k * G
+#define CP_W     PRECOMPUTED_CP_WINDOW_BITS
+#define CP_MASK  ((1 << CP_W) - 1)
+
+// jres = k * G in jacobian coordinates, returns 0 if k is zero
 // k must be a normalized number with 0 <= k < curve->order
-void scalar_multiply(const ecdsa_curve *curve, const bignum256 *k, curve_point *res)
+static int scalar_multiply_jacobian(const ecdsa_curve *curve, const bignum256 *k, jacobian_curve_point *jres)
 {
 	assert (bn_is_less(k, &curve->order));
 
 	int i, j;
-	static CONFIDENTIAL bignum256 a;
+	bignum256 a;
 	uint32_t is_even = (k->val[0] & 1) - 1;
 	uint32_t lowbits;
-	static CONFIDENTIAL jacobian_curve_point jres;
 	const bignum256 *prime = &curve->prime;
 
 	// is_even = 0xffffffff if k is even, 0 otherwise.
 
-	// add 2^256.
+	// add 2^(w*R), which is 2^256 if w divides 256.
 	// make number odd: subtract curve->order if even
 	uint32_t tmp = 1;
 	uint32_t is_non_zero = 0;
@@ -572,66 +574,141 @@ void scalar_multiply(const ecdsa_curve *curve, const bignum256 *k, curve_point *
 		tmp >>= 30;
 	}
 	is_non_zero |= k->val[j];
-	a.val[j] = tmp + 0xffff + k->val[j] - (curve->order.val[j] & is_even);
+	a.val[j] = tmp + ((1u << (CP_W * PRECOMPUTED_CP_ROWS - 240)) - 1) + k->val[j] - (curve->order.val[j] & is_even);
 	assert((a.val[0] & 1) != 0);
 
 	// special case 0*G:  just return zero. We don't care about constant time.
 	if (!is_non_zero) {
-		point_set_infinity(res);
-		return;
+		return 0;
 	}
 
-	// Now a = k + 2^256 (mod curve->order) and a is odd.
+	// Now a = k + 2^(w*R) (mod curve->order) and a is odd, where w is the
+	// window width CP_W and R = PRECOMPUTED_CP_ROWS.
 	//
 	// The idea is to bring the new a into the form.
-	// sum_{i=0..64} a[i] 16^i,  where |a[i]| < 16 and a[i] is odd.
+	// sum_{i=0..R} a[i] 2^(w*i),  where |a[i]| < 2^w and a[i] is odd.
 	// a[0] is odd, since a is odd.  If a[i] would be even, we can
-	// add 1 to it and subtract 16 from a[i-1].  Afterwards,
-	// a[64] = 1, which is the 2^256 that we added before.
+	// add 1 to it and subtract 2^w from a[i-1].  Afterwards,
+	// a[R] = 1, which is the 2^(w*R) that we added before.
 	//
-	// Since k = a - 2^256 (mod curve->order), we can compute
-	//   k*G = sum_{i=0..63} a[i] 16^i * G
+	// Since k = a - 2^(w*R) (mod curve->order), we can compute
+	//   k*G = sum_{i=0..R-1} a[i] 2^(w*i) * G
 	//
 	// We have a big table curve->cp that stores all possible
-	// values of |a[i]| 16^i * G.
-	// curve->cp[i][j] = (2*j+1) * 16^i * G
+	// values of |a[i]| 2^(w*i) * G.
+	// curve->cp[i][j] = (2*j+1) * 2^(w*i) * G
 
-	// now compute  res = sum_{i=0..63} a[i] * 16^i * G step by step.
-	// initial res = |a[0]| * G.  Note that a[0] = a & 0xf if (a&0x10) != 0
-	// and - (16 - (a & 0xf)) otherwise.   We can compute this as
-	//   ((a ^ (((a >> 4) & 1) - 1)) & 0xf) >> 1
+	// now compute  res = sum_{i=0..R-1} a[i] * 2^(w*i) * G step by step.
+	// initial res = |a[0]| * G.  Note that a[0] = a & CP_MASK if (a >> w) & 1
+	// and - (2^w - (a & CP_MASK)) otherwise.   We can compute this as
+	//   ((a ^ (((a >> w) & 1) - 1)) & CP_MASK) >> 1
 	// since a is odd.
-	lowbits = a.val[0] & ((1 << 5) - 1);
-	lowbits ^= (lowbits >> 4) - 1;
-	lowbits &= 15;
-	curve_to_jacobian(&curve->cp[0][lowbits >> 1], &jres, prime);
-	for (i = 1; i < 64; i ++) {
-		// invariant res = sign(a[i-1]) sum_{j=0..i-1} (a[j] * 16^j * G)
-
-		// shift a by 4 places.
+	lowbits = a.val[0] & ((1 << (CP_W + 1)) - 1);
+	lowbits ^= (lowbits >> CP_W) - 1;
+	lowbits &= CP_MASK;
+	curve_to_jacobian(&curve->cp[0][lowbits >> 1], jres, prime);
+	for (i = 1; i < PRECOMPUTED_CP_ROWS; i ++) {
+		// invariant res = sign(a[i-1]) sum_{j=0..i-1} (a[j] * 2^(w*j) * G)
+
+		// shift a by w places.
 		for (j = 0; j < 8; j++) {
-			a.val[j] = (a.val[j] >> 4) | ((a.val[j + 1] & 0xf) << 26);
+			a.val[j] = (a.val[j] >> CP_W) | ((a.val[j + 1] & CP_MASK) << (30 - CP_W));
 		}
-		a.val[j] >>= 4;
-		// a = old(a)>>(4*i)
+		a.val[j] >>= CP_W;
+		// a = old(a)>>(w*i)
 		// a is even iff sign(a[i-1]) = -1
 
-		lowbits = a.val[0] & ((1 << 5) - 1);
-		lowbits ^= (lowbits >> 4) - 1;
-		lowbits &= 15;
+		lowbits = a.val[0] & ((1 << (CP_W + 1)) - 1);
+		lowbits ^= (lowbits >> CP_W) - 1;
+		lowbits &= CP_MASK;
 		// negate last result to make signs of this round and the
 		// last round equal.
-		conditional_negate((lowbits & 1) - 1, &jres.y, prime);
+		conditional_negate((lowbits & 1) - 1, &jres->y, prime);
 
 		// add odd factor
-		point_jacobian_add(&curve->cp[i][lowbits >> 1], &jres, curve);
+		point_jacobian_add(&curve->cp[i][lowbits >> 1], jres, curve);
 	}
-	conditional_negate(((a.val[0] >> 4) & 1) - 1, &jres.y, prime);
-	jacobian_to_curve(&jres, res, prime);
+	conditional_negate(((a.val[0] >> CP_W) & 1) - 1, &jres->y, prime);
 	memzero(&a, sizeof(a));
+	return 1;
+}
+
+#undef CP_W
+#undef CP_MASK
+
+// res = k * G
+// k must be a normalized number with 0 <= k < curve->order
+void scalar_multiply(const ecdsa_curve *curve, const bignum256 *k, curve_point *res)
+{
+	jacobian_curve_point jres;
+
+	if (!scalar_multiply_jacobian(curve, k, &jres)) {
+		point_set_infinity(res);
+		return;
+	}
+	jacobian_to_curve(&jres, res, &curve->prime);
 	memzero(&jres, sizeof(jres));
 }
 
+// res[i] = k[i] * G for i < n
+// The jacobian to affine conversion shares one field inversion per
+// SCALAR_MULTIPLY_BATCH points (Montgomery's trick), which is what makes
+// bulk key generation faster than calling scalar_multiply() n times.
+// k[i] must be normalized numbers with 0 < k[i] < curve->order
+void scalar_multiply_batch(const ecdsa_curve *curve, const bignum256 *k, curve_point *res, size_t n)
+{
+	jacobian_curve_point jres[SCALAR_MULTIPLY_BATCH];
+	const bignum256 *prime = &curve->prime;
+	bignum256 inv, zinv;
+	size_t i, m;
+
+	while (n > 0) {
+		m = n < SCALAR_MULTIPLY_BATCH ? n : SCALAR_MULTIPLY_BATCH;
+		for (i = 0; i < m; i++) {
+			int is_non_zero = scalar_multiply_jacobian(curve, &k[i], &jres[i]);
+			assert(is_non_zero);
+			(void)is_non_zero;
+		}
+
+		// res[i].x = z[0] * ... * z[i]
+		res[0].x = jres[0].z;
+		for (i = 1; i < m; i++) {
+			res[i].x = res[i - 1].x;
+			bn_multiply(&jres[i].z, &res[i].x, prime);
+		}
+		inv = res[m - 1].x;
+		bn_inverse(&inv, prime);
+		// inv = (z[0] * ... * z[m-1])^-1
+
+		for (i = m; i-- > 0; ) {
+			zinv = inv;
+			if (i > 0) {
+				bn_multiply(&res[i - 1].x, &zinv, prime);
+				// zinv = z[i]^-1
+				bn_multiply(&jres[i].z, &inv, prime);
+				// inv = (z[0] * ... * z[i-1])^-1
+			}
+			res[i].y = zinv;
+			bn_multiply(&zinv, &zinv, prime);
+			// zinv = z^-2
+			bn_multiply(&zinv, &res[i].y, prime);
+			// res[i].y = z^-3
+			res[i].x = zinv;
+			bn_multiply(&jres[i].x, &res[i].x, prime);
+			bn_multiply(&jres[i].y, &res[i].y, prime);
+			bn_mod(&res[i].x, prime);
+			bn_mod(&res[i].y, prime);
+		}
+
+		k += m;
+		res += m;
+		n -= m;
+	}
+	memzero(jres, sizeof(jres));
+	memzero(&inv, sizeof(inv));
+	memzero(&zinv, sizeof(zinv));
+}
+
 #else
 
 void scalar_multiply(const ecdsa_curve *curve, const bignum256 *k, curve_point *res)
@@ -639,6 +716,14 @@ void scalar_multiply(const ecdsa_curve *curve, const bignum256 *k, curve_point *
 	point_multiply(curve, k, &curve->G, res);
 }
 
+void scalar_multiply_batch(const ecdsa_curve *curve, const bignum256 *k, curve_point *res, size_t n)
+{
+	size_t i;
+	for (i = 0; i < n; i++) {
+		point_multiply(curve, &k[i], &curve->G, &res[i]);
+	}
+}
+
 #endif
 
 int ecdh_multiply(const ecdsa_curve *curve, const uint8_t *priv_key, const uint8_t *pub_key, uint8_t *session_key)
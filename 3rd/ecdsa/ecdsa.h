@@ -29,6 +29,15 @@
 #include "bignum.h"
 #include "hasher.h"
 
+#if USE_PRECOMPUTED_CP
+#if PRECOMPUTED_CP_WINDOW_BITS < 2 || PRECOMPUTED_CP_WINDOW_BITS > 8
+#error "PRECOMPUTED_CP_WINDOW_BITS must be between 2 and 8"
+#endif
+// cp[i][j] = (2*j+1) * 2^(PRECOMPUTED_CP_WINDOW_BITS*i) * G
+#define PRECOMPUTED_CP_ROWS ((256 + PRECOMPUTED_CP_WINDOW_BITS - 1) / PRECOMPUTED_CP_WINDOW_BITS)
+#define PRECOMPUTED_CP_COLS (1 << (PRECOMPUTED_CP_WINDOW_BITS - 1))
+#endif
+
 // curve point x and y
 typedef struct {
 	bignum256 x, y;
@@ -44,7 +53,7 @@ typedef struct {
 	bignum256 b;           // coefficient 'b' of the elliptic curve
 
 #if USE_PRECOMPUTED_CP
-	const curve_point cp[64][8];
+	const curve_point cp[PRECOMPUTED_CP_ROWS][PRECOMPUTED_CP_COLS];
 #endif
 
 } ecdsa_curve;
@@ -71,6 +80,7 @@ int point_is_infinity(const curve_point *p);
 int point_is_equal(const curve_point *p, const curve_point *q);
 int point_is_negative_of(const curve_point *p, const curve_point *q);
 void scalar_multiply(const ecdsa_curve *curve, const bignum256 *k, curve_point *res);
+void scalar_multiply_batch(const ecdsa_curve *curve, const bignum256 *k, curve_point *res, size_t n);
 int ecdh_multiply(const ecdsa_curve *curve, const uint8_t *priv_key, const uint8_t *pub_key, uint8_t *session_key);
 void uncompress_coords(const ecdsa_curve *curve, uint8_t odd, const bignum256 *x, bignum256 *y);
 int ecdsa_uncompress_pubkey(const ecdsa_curve *curve, const uint8_t *pub_key, uint8_t *uncompressed);
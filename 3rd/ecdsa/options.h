@@ -28,6 +28,18 @@
 #define USE_PRECOMPUTED_CP 1
 #endif
 
+// window width in bits of the precomputed Curve Points table (2..8)
+// the table holds (2*j+1) * 2^(w*i) * G, i.e. ceil(256/w) rows of 2^(w-1)
+// points; 4 is the checked-in secp256k1.table (36KB), 8 is the fastest (288KB)
+#ifndef PRECOMPUTED_CP_WINDOW_BITS
+#define PRECOMPUTED_CP_WINDOW_BITS 4
+#endif
+
+// number of points scalar_multiply_batch() converts to affine with one inversion
+#ifndef SCALAR_MULTIPLY_BATCH
+#define SCALAR_MULTIPLY_BATCH 16
+#endif
+
 // use fast inverse method
 #ifndef USE_INVERSE_FAST
 #define USE_INVERSE_FAST 1
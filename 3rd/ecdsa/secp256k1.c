@@ -50,7 +50,12 @@ const ecdsa_curve secp256k1 = {
 #if USE_PRECOMPUTED_CP
 	,
 	/* cp */ {
+#if PRECOMPUTED_CP_WINDOW_BITS == 4
 #include "secp256k1.table"
+#else
+// generated by tools/mktable.c at build time, see Makefile
+#include "secp256k1_cp.table"
+#endif
 	}
 #endif
 };
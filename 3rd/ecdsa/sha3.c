@@ -380,6 +380,209 @@ void keccak_512(const unsigned char* data, size_t len, unsigned char* digest)
 }
 #endif /* USE_KECCAK */
 
+#if USE_KECCAK
+/*
+ * Multi-buffer keccak-256.
+ *
+ * The state of N independent messages is kept interleaved, lane k of message l
+ * at S[k * N + l], so that the permutation runs on N-wide vectors built with the
+ * GCC/clang vector extension. Vectors are only used where they beat the scalar
+ * code, i.e. 4 lanes with AVX2 and 8 lanes with AVX-512; narrower SIMD units
+ * spill the 25-lane state and lose. Everywhere else, and in KECCAK_MB_SCALAR
+ * builds, the scalar permutation runs once per message.
+ */
+#if defined(__GNUC__) && !defined(KECCAK_MB_SCALAR) && defined(__AVX2__)
+#define KECCAK_MB_X4 1
+#if defined(__AVX512F__)
+#define KECCAK_MB_X8 1
+#endif
+#endif
+
+#define KECCAK_MB_MAX_LANES 8
+#define KECCAK_256_RATE_QWORDS (SHA3_256_BLOCK_LENGTH / 8)
+
+#if defined(KECCAK_MB_X4)
+
+/* rho() rotation of each lane, applied before pi() like in sha3_permutation() */
+static const unsigned keccak_rho_offsets[25] = {
+	 0,  1, 62, 28, 27, 36, 44,  6, 55, 20,  3, 10, 43,
+	25, 39, 41, 45, 15, 21,  8, 18,  2, 61, 56, 14
+};
+
+/* pi() as a cycle: A[keccak_pi_cycle[i]] = A[keccak_pi_cycle[i + 1]] */
+static const unsigned keccak_pi_cycle[25] = {
+	 1,  6,  9, 22, 14, 20,  2, 12, 13, 19, 23, 15,  4,
+	24, 21,  8, 16,  5,  3, 18, 17, 11,  7, 10,  1
+};
+
+#define KECCAK_MB_PERMUTATION(name, lane_t)                                   \
+static void name(uint64_t *S)                                                 \
+{                                                                             \
+	lane_t A[25], C[5], D, t;                                                 \
+	int round;                                                                \
+	unsigned x, y;                                                            \
+                                                                              \
+	memcpy(A, S, sizeof(A));                                                  \
+	for (round = 0; round < NumberOfRounds; round++) {                        \
+		/* theta */                                                           \
+		for (x = 0; x < 5; x++) {                                             \
+			C[x] = A[x] ^ A[x + 5] ^ A[x + 10] ^ A[x + 15] ^ A[x + 20];       \
+		}                                                                     \
+		for (x = 0; x < 5; x++) {                                             \
+			D = ROTL64(C[(x + 1) % 5], 1) ^ C[(x + 4) % 5];                   \
+			for (y = 0; y < 25; y += 5) {                                     \
+				A[x + y] ^= D;                                                \
+			}                                                                 \
+		}                                                                     \
+		/* rho */                                                             \
+		for (x = 1; x < 25; x++) {                                            \
+			A[x] = ROTL64(A[x], keccak_rho_offsets[x]);                       \
+		}                                                                     \
+		/* pi */                                                              \
+		t = A[1];                                                             \
+		for (x = 0; x < 23; x++) {                                            \
+			A[keccak_pi_cycle[x]] = A[keccak_pi_cycle[x + 1]];                \
+		}                                                                     \
+		A[keccak_pi_cycle[23]] = t;                                           \
+		/* chi */                                                             \
+		for (y = 0; y < 25; y += 5) {                                         \
+			for (x = 0; x < 5; x++) {                                         \
+				C[x] = A[x + y];                                              \
+			}                                                                 \
+			for (x = 0; x < 5; x++) {                                         \
+				A[x + y] = C[x] ^ (~C[(x + 1) % 5] & C[(x + 2) % 5]);         \
+			}                                                                 \
+		}                                                                     \
+		/* iota */                                                            \
+		A[0] ^= keccak_round_constants[round];                                \
+	}                                                                         \
+	memcpy(S, A, sizeof(A));                                                  \
+}
+
+typedef uint64_t keccak_lane_x4 __attribute__((vector_size(32)));
+KECCAK_MB_PERMUTATION(keccak_permutation_x4, keccak_lane_x4)
+
+#if defined(KECCAK_MB_X8)
+typedef uint64_t keccak_lane_x8 __attribute__((vector_size(64)));
+KECCAK_MB_PERMUTATION(keccak_permutation_x8, keccak_lane_x8)
+#endif
+
+static void keccak_permutation_mb(uint64_t *S, unsigned lanes)
+{
+#if defined(KECCAK_MB_X8)
+	if (lanes == 8) {
+		keccak_permutation_x8(S);
+		return;
+	}
+#endif
+	(void)lanes;
+	keccak_permutation_x4(S);
+}
+
+#else /* scalar fallback */
+
+static void keccak_permutation_mb(uint64_t *S, unsigned lanes)
+{
+	uint64_t A[25];
+	unsigned k, l;
+
+	for (l = 0; l < lanes; l++) {
+		for (k = 0; k < 25; k++) A[k] = S[k * lanes + l];
+		sha3_permutation(A);
+		for (k = 0; k < 25; k++) S[k * lanes + l] = A[k];
+	}
+}
+
+#endif
+
+static void keccak_256_mb(unsigned lanes, const unsigned char* const data[], const size_t len[], unsigned char* const digest[])
+{
+	uint64_t S[25 * KECCAK_MB_MAX_LANES];
+	uint64_t block[KECCAK_256_RATE_QWORDS];
+	size_t blocks, offset;
+	unsigned k, l;
+	int all_final = 1;
+
+	memset(S, 0, sizeof(S));
+
+	/* absorb the full blocks all messages have in common in parallel */
+	blocks = len[0] / SHA3_256_BLOCK_LENGTH;
+	for (l = 1; l < lanes; l++) {
+		if (len[l] / SHA3_256_BLOCK_LENGTH < blocks) blocks = len[l] / SHA3_256_BLOCK_LENGTH;
+	}
+	for (offset = 0; offset < blocks * SHA3_256_BLOCK_LENGTH; offset += SHA3_256_BLOCK_LENGTH) {
+		for (l = 0; l < lanes; l++) {
+			memcpy(block, data[l] + offset, SHA3_256_BLOCK_LENGTH);
+			for (k = 0; k < KECCAK_256_RATE_QWORDS; k++) S[k * lanes + l] ^= le2me_64(block[k]);
+		}
+		keccak_permutation_mb(S, lanes);
+	}
+	for (l = 0; l < lanes; l++) {
+		if (len[l] - offset >= SHA3_256_BLOCK_LENGTH) all_final = 0;
+	}
+
+	if (!all_final) {
+		/* lengths differ by a block or more: finish each message on its own */
+		for (l = 0; l < lanes; l++) {
+			SHA3_CTX ctx;
+			keccak_256_Init(&ctx);
+			for (k = 0; k < 25; k++) ctx.hash[k] = S[k * lanes + l];
+			keccak_Update(&ctx, data[l] + offset, len[l] - offset);
+			keccak_Final(&ctx, digest[l]);
+		}
+		return;
+	}
+
+	/* pad and absorb the last block of every message in parallel */
+	for (l = 0; l < lanes; l++) {
+		size_t rest = len[l] - offset;
+		memset(block, 0, sizeof(block));
+		memcpy(block, data[l] + offset, rest);
+		((unsigned char*)block)[rest] |= 0x01;
+		((unsigned char*)block)[SHA3_256_BLOCK_LENGTH - 1] |= 0x80;
+		for (k = 0; k < KECCAK_256_RATE_QWORDS; k++) S[k * lanes + l] ^= le2me_64(block[k]);
+	}
+	keccak_permutation_mb(S, lanes);
+
+	for (l = 0; l < lanes; l++) {
+		for (k = 0; k < sha3_256_hash_size / 8; k++) block[k] = S[k * lanes + l];
+		me64_to_le_str(digest[l], block, sha3_256_hash_size);
+	}
+	memzero(S, sizeof(S));
+	memzero(block, sizeof(block));
+}
+
+/**
+* Calculate keccak_256 of 4 independent messages at once.
+*
+* @param data the messages
+* @param len length of each message in bytes
+* @param digest calculated hash of each message in binary form
+*/
+void keccak_256_x4(const unsigned char* const data[4], const size_t len[4], unsigned char* const digest[4])
+{
+	keccak_256_mb(4, data, len, digest);
+}
+
+/**
+* Calculate keccak_256 of 8 independent messages at once.
+*
+* @param data the messages
+* @param len length of each message in bytes
+* @param digest calculated hash of each message in binary form
+*/
+void keccak_256_x8(const unsigned char* const data[8], const size_t len[8], unsigned char* const digest[8])
+{
+#if defined(KECCAK_MB_X4) && !defined(KECCAK_MB_X8)
+	/* two 4-lane passes, an 8-lane state does not fit in AVX2 registers */
+	keccak_256_mb(4, data, len, digest);
+	keccak_256_mb(4, data + 4, len + 4, digest + 4);
+#else
+	keccak_256_mb(8, data, len, digest);
+#endif
+}
+#endif /* USE_KECCAK */
+
 void sha3_256(const unsigned char* data, size_t len, unsigned char* digest)
 {
 	SHA3_CTX ctx;
@@ -77,6 +77,10 @@ void sha3_Final(SHA3_CTX *ctx, unsigned char* result);
 void keccak_Final(SHA3_CTX *ctx, unsigned char* result);
 void keccak_256(const unsigned char* data, size_t len, unsigned char* digest);
 void keccak_512(const unsigned char* data, size_t len, unsigned char* digest);
+
+/* multi-buffer keccak_256 of independent messages, SIMD where available */
+void keccak_256_x4(const unsigned char* const data[4], const size_t len[4], unsigned char* const digest[4]);
+void keccak_256_x8(const unsigned char* const data[8], const size_t len[8], unsigned char* const digest[8]);
 #endif
 
 void sha3_256(const unsigned char* data, size_t len, unsigned char* digest);
@@ -0,0 +1,103 @@
+/**
+ * Copyright (c) 2013-2014 Tomas Dzetkulic
+ * Copyright (c) 2013-2014 Pavol Rusnak
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+ * OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include "bignum.h"
+#include "ecdsa.h"
+#include "secp256k1.h"
+
+/*
+ * This program prints the contents of the ecdsa_curve.cp array of secp256k1
+ * for a window of WINDOW_BITS bits (2..8, default 4).
+ * The entry cp[i][j] contains the number (2*j+1)*2^(w*i)*G,
+ * where G is the generator of the curve.
+ *
+ * It must be linked against a library built with USE_PRECOMPUTED_CP=0.
+ * The output for a window of 4 bits is identical to secp256k1.table.
+ */
+int main(int argc, char **argv) {
+	int i, j, k;
+	int w = 4;
+	int rows, cols;
+
+	if (argc > 2) {
+		printf("Usage: %s [WINDOW_BITS]\n", argv[0]);
+		return 1;
+	}
+	if (argc == 2) {
+		w = atoi(argv[1]);
+	}
+	if (w < 2 || w > 8) {
+		fprintf(stderr, "WINDOW_BITS must be between 2 and 8\n");
+		return 1;
+	}
+	rows = (256 + w - 1) / w;
+	cols = 1 << (w - 1);
+
+	const ecdsa_curve *curve = &secp256k1;
+	curve_point ng = curve->G;
+	curve_point pow2ig = curve->G;
+	for (i = 0; i < rows; i++) {
+		// invariants:
+		//   pow2ig = 2^(w*i) * G
+		//   ng     = pow2ig
+		printf("\t{\n");
+		for (j = 0; j < cols; j++) {
+			// invariants:
+			//   pow2ig = 2^(w*i) * G
+			//   ng     = (2*j+1) * 2^(w*i) * G
+#ifndef NDEBUG
+			curve_point checkresult;
+			bignum256 a;
+			bn_read_uint32(2*j+1, &a);
+			for (k = 0; k < w*i; k++) {
+				bn_lshift(&a);
+				bn_mod(&a, &curve->order);
+			}
+			point_multiply(curve, &a, &curve->G, &checkresult);
+			assert(point_is_equal(&checkresult, &ng));
+#endif
+			printf("\t\t/* %2d*%d^%d*G: */\n\t\t{{{", 2*j + 1, 1 << w, i);
+			// print x coordinate
+			for (k = 0; k < 9; k++) {
+				printf((k < 8 ? "0x%08x, " : "0x%04x"), ng.x.val[k]);
+			}
+			printf("}},\n\t\t {{");
+			// print y coordinate
+			for (k = 0; k < 9; k++) {
+				printf((k < 8 ? "0x%08x, " : "0x%04x"), ng.y.val[k]);
+			}
+			if (j == cols - 1) {
+				printf("}}}\n\t},\n");
+			} else {
+				printf("}}},\n");
+				point_add(curve, &pow2ig, &ng);
+			}
+			point_add(curve, &pow2ig, &ng);
+		}
+		pow2ig = ng;
+	}
+	return 0;
+}
@@ -63,6 +63,10 @@ static int exit_signal = 0;
 // See Truffle Suite's documents for how to deploy a smart contract.
 CHAR *contract_address = "0xcfeb869f69431e42cdb54a4f4f105c19c080a601";
 
+// Locations are journaled here and sent in background, so that they are kept
+// while the network is unavailable
+CHAR *journal_path = "./gpstrace.journal";
+
 // Smart Contract GpsTraceContract (in solidity)
 /*
 pragma solidity >=0.4.16 <0.6.0;
@@ -72,12 +76,22 @@ contract GpsTraceContract {
 
     bytes32[] eventList;
 
+    event ListSaved(bytes32 newEvent);
+
     constructor () public {
         organizer = msg.sender;
     }
     
     function saveList(bytes32 newEvent) public {
         eventList.push(newEvent);
+        emit ListSaved(newEvent);
+    }
+
+    function saveListBatch(bytes32[] memory newEvents) public {
+        for (uint i = 0; i < newEvents.length; i++) {
+            eventList.push(newEvents[i]);
+            emit ListSaved(newEvents[i]);
+        }
     }
     
     function readListLength() public view returns (uint length_) {
@@ -101,25 +115,50 @@ contract GpsTraceContract {
 }
 */
 
-BOAT_RESULT CallSaveListSol(CHAR * contract_addr_str, CHAR * string_to_save)
+// Records per saveListBatch() transaction. Each record costs a storage slot,
+// i.e. ~20000 gas, so that a batch must fit in the gaslimit set in boatdemo.c.
+#define GPSTRACE_BATCH_MAX_RECORDS 50
+
+// Each bytes32 record is this tag followed by a codec record of the fix laid
+// out by BoatGpsFixToFields(), so that it's told from plain string records
+// saved by older versions
+#define GPSTRACE_RECORD_TAG 0xB1
+
+//!@brief Context of the fix callback
+typedef struct TGpsTraceFixCtx
+{
+    BoatGpsFix fix;         //!< The latest fix
+    BOATBOOL fix_ready;     //!< BOAT_TRUE if <fix> is not yet saved
+}GpsTraceFixCtx;
+
+//!@brief Context of CallSaveListBatchSol()
+typedef struct TGpsTraceBatchCtx
 {
+    BoatOutbox *outbox_ptr;
+    CHAR *contract_addr_str;
+}GpsTraceBatchCtx;
+
+// Submit function of the location batch, see BoatBatchSubmitFunc
+BOAT_RESULT CallSaveListBatchSol(void *submit_ctx_ptr, const UINT8 *data_ptr, UINT32 data_len, UINT32 record_num)
+{
+    GpsTraceBatchCtx *ctx_ptr = (GpsTraceBatchCtx *)submit_ctx_ptr;
+    CHAR *contract_addr_str;
     BoatAddress recipient;
-    CHAR *function_prototye_str;
-    UINT8 function_selector[32];
     TxFieldVariable data;
-    UINT8 data_array[36];
     BOAT_RESULT result;
+
+    // Only nonce and data change among saveListBatch() transactions
+    static BoatTxTemplate tx_template;
+    static BoatAddress tx_template_recipient;
+    static BOATBOOL tx_template_ready = BOAT_FALSE;
     
-    if( contract_addr_str == NULL )
+    if( ctx_ptr == NULL || ctx_ptr->outbox_ptr == NULL || ctx_ptr->contract_addr_str == NULL )
     {
         return BOAT_ERROR;
     }
+    contract_addr_str = ctx_ptr->contract_addr_str;
    
-    // Set nonce
-    result = BoatTxSetNonce();
-    if( result != BOAT_SUCCESS ) return BOAT_ERROR;
-
-    // Set recipient
+    // Nonce is assigned by the outbox
 
     UtilityHex2Bin(
                     recipient,
@@ -129,41 +168,40 @@ BOAT_RESULT CallSaveListSol(CHAR * contract_addr_str, CHAR * string_to_save)
                     BOAT_TRUE
                   );
 
-    result = BoatTxSetRecipient(recipient);
-
-    if( result != BOAT_SUCCESS ) return BOAT_ERROR;
-    
+    if( tx_template_ready == BOAT_FALSE || memcmp(recipient, tx_template_recipient, sizeof(BoatAddress)) != 0 )
+    {
+        // Set recipient
+        result = BoatTxSetRecipient(recipient);
+        if( result != BOAT_SUCCESS ) return BOAT_ERROR;
 
-    // Set value
+        // Set value
+        result =BoatTxSetValue(NULL);
+        if( result != BOAT_SUCCESS ) return BOAT_ERROR;
 
-    result =BoatTxSetValue(NULL);
-    if( result != BOAT_SUCCESS ) return BOAT_ERROR;
+        // Pre-encode gasprice, gaslimit, recipient and value
+        result = BoatTxTemplateInit(&tx_template);
+        if( result != BOAT_SUCCESS ) return BOAT_ERROR;
 
+        memcpy(tx_template_recipient, recipient, sizeof(BoatAddress));
+        tx_template_ready = BOAT_TRUE;
+    }
 
-    // Set data (Function Argument)
-    
-    function_prototye_str = "saveList(bytes32)";
-    keccak_256((UINT8 *)function_prototye_str, strlen(function_prototye_str), function_selector);
 
-    data.field_ptr = data_array;
-    
-    memcpy(data.field_ptr, function_selector, 4);
-    
-    // Truncate input string up to 31 characters plus '\0'
-    memset(data.field_ptr+4, 0x00, 32);
-    strncpy((CHAR*)data.field_ptr+4, string_to_save, 31);
-   
-    data.field_len = 36;
+    // Set data (Function selector and encoded records built by the batch)
+    data.field_ptr = (UINT8 *)data_ptr;
+    data.field_len = data_len;
      
     result = BoatTxSetData(&data);
     if( result != BOAT_SUCCESS ) return BOAT_ERROR;
 
     
-    // Perform the transaction
+    // Sign the transaction and journal it, it's sent in background
     // NOTE: Field v,r,s are calculated automatically
-    result = BoatTxSend();
+    result = BoatOutboxEnqueue(ctx_ptr->outbox_ptr, &g_boat_wallet_info, &tx_template, &g_tx_info);
     if( result != BOAT_SUCCESS ) return BOAT_ERROR;
 
+    BoatLog(BOAT_LOG_NORMAL, "%u locations are saved in one transaction.", record_num);
+
     return BOAT_SUCCESS;
 }
 
@@ -256,339 +294,126 @@ UINT32 CallReadListLength(CHAR * contract_addr_str)
 }
 
 
-BOAT_RESULT CallReadListByIndex(CHAR * contract_addr_str, UINT32 list_len)
+// Log a bytes32 record, either binary (see GPSTRACE_RECORD_TAG) or string
+void PrintGpsRecord(const UINT8 *record_ptr)
 {
+    UINT8 event_record[33];
+    BoatCodec codec;
+    SINT64 field[BOAT_GPS_FIELD_NUM];
+    UINT32 record_len;
 
-    UINT8 func_param[32];
-    CHAR *retval_str;
-    UINT32 list_index;
-
-    BOAT_RESULT result = BOAT_SUCCESS;
+    memcpy(event_record, record_ptr, 32);
+    event_record[32] = 0x00;
 
-    if( contract_addr_str == NULL )
+    // Every record is a key frame, decode it with a fresh state
+    BoatCodecInit(&codec, BOAT_GPS_FIELD_NUM);
+    if(    event_record[0] == GPSTRACE_RECORD_TAG
+        && BoatCodecDecode(&codec, event_record + 1, 31, field, &record_len) == BOAT_SUCCESS )
     {
-        return BOAT_ERROR;
+        BoatLog(BOAT_LOG_NORMAL, "lat: %lld e-7, lon: %lld e-7, UTC: %lld ms, alt: %lld cm",
+                (long long)field[BOAT_GPS_FIELD_LAT],
+                (long long)field[BOAT_GPS_FIELD_LON],
+                (long long)field[BOAT_GPS_FIELD_UTC],
+                (long long)field[BOAT_GPS_FIELD_ALT]);
     }
-
-    memset(func_param, 0x00, 32);
-    
-    for( list_index = 0; list_index < list_len; list_index++ )
+    else
     {
-        UtilityUint32ToBigend(func_param + 28, list_index, TRIMBIN_TRIM_NO);
+        BoatLog(BOAT_LOG_NORMAL, "%s", (CHAR *)event_record);
+    }
+}
 
-        retval_str = BoatCallContractFunc(
-                                          contract_addr_str,
-                                          "readListByIndex(uint256)",
-                                          func_param,
-                                          32);
 
-        if( retval_str != NULL && strlen(retval_str) != 0)
-        {
-            CHAR event_string[32];
-            UtilityHex2Bin(
-                        (UINT8*)event_string,
-                        32,
-                        retval_str,
-                        TRIMBIN_TRIM_NO,
-                        BOAT_FALSE
-                      );
-            BoatLog(BOAT_LOG_NORMAL, "%s", event_string);
-        }
-        else
-        {
-            BoatLog(BOAT_LOG_NORMAL, "Fail to call readListByIndex().");
-            result = BOAT_ERROR;
-            break;
-        }
-    }
+// Log callback of ListSaved(bytes32) events, see BoatLogSyncCatchUp()
+static BOAT_RESULT GpsTraceOnListSaved(void *log_ctx_ptr, const Web3Log *log_ptr)
+{
+    UINT32 *record_num_ptr = (UINT32 *)log_ctx_ptr;
 
-    return result;
+    if( log_ptr->removed == BOAT_TRUE || log_ptr->data_len != 32 ) return BOAT_SUCCESS;
+
+    PrintGpsRecord(log_ptr->data_ptr);
+    (*record_num_ptr)++;
+
+    return BOAT_SUCCESS;
 }
 
 
-//+CGPSINFO:[<lat>],[<N/S>],[<log>],[<E/W>],[<date>],[<UTCtime>],[<alt>],[<speed>],[<course>]
-typedef struct TStringWithLen
+// Read all records from ListSaved(bytes32) events, with a few eth_getLogs
+// instead of one readListByIndex() call per record
+BOAT_RESULT CallReadListByLogs(CHAR * contract_addr_str, UINT32 list_len)
 {
-    CHAR *string_ptr;
-    UINT32 string_len;
-}StringWithLen;
+    BoatAddress contract_addr;
+    BoatLogFilter filter;
+    BoatLogSync log_sync;
+    BoatLogSyncStats log_sync_stats;
+    UINT32 record_num = 0;
+    BOAT_RESULT result;
 
-typedef struct TCgpsinfo
-{
-    StringWithLen lat;
-    StringWithLen ns;
-    StringWithLen log;
-    StringWithLen ew;
-    StringWithLen date;
-    StringWithLen utctime;
-    StringWithLen alt;
-    StringWithLen speed;
-    StringWithLen course;
-}Cgpsinfo;
-
-BOAT_RESULT ParseCGPSINFO(const CHAR *cgpsinfo_str, BOAT_OUT Cgpsinfo *parsed_gpsinfo_ptr)
-{
-    CHAR *cgpsinfo_pos_ptr;
-    CHAR *field_start_pos_ptr;
-    CHAR c;
-    UINT32 field_len;
-    
-    if( cgpsinfo_str == NULL || parsed_gpsinfo_ptr == NULL )
+    if( contract_addr_str == NULL )
     {
-        BoatLog(BOAT_LOG_NORMAL, "Arguments cannot be NULL.");
         return BOAT_ERROR;
     }
 
-    // Check if the string contains "+CGPSINFO:"
-    cgpsinfo_pos_ptr = strstr(cgpsinfo_str, "+CGPSINFO:");
-    if( cgpsinfo_pos_ptr == NULL )
-    {
-        BoatLog(BOAT_LOG_NORMAL, "Unable to find \"+CGPSINFO:\" in string.");
-        return BOAT_ERROR;
-    }
-    
-    cgpsinfo_pos_ptr = cgpsinfo_pos_ptr + strlen("+CGPSINFO:");
-    
-    // Skip space
-    while( (c = *cgpsinfo_pos_ptr) == ' ' )
-    {
-        cgpsinfo_pos_ptr++;
-    }
+    UtilityHex2Bin(contract_addr, 20, contract_addr_str, TRIMBIN_TRIM_NO, BOAT_TRUE);
 
-   
-    // Extract every field
+    BoatLogFilterInit(&filter, contract_addr);
+    BoatLogFilterAddEvent(&filter, "ListSaved(bytes32)");
 
-    // Extract <lat>
-    field_start_pos_ptr = cgpsinfo_pos_ptr;
-    
-    while( (c = *cgpsinfo_pos_ptr) != '\0' )
-    {
-        if( c == ',' )     break;  // Note: cgpsinfo_pos_ptr points to ',' when loop exits
-        cgpsinfo_pos_ptr++;
-    }
-    
-    field_len = (UINT32)(cgpsinfo_pos_ptr - field_start_pos_ptr);
-    if( field_len != 0 )
-    {
-        parsed_gpsinfo_ptr->lat.string_ptr = field_start_pos_ptr;
-        parsed_gpsinfo_ptr->lat.string_len = field_len;
-        cgpsinfo_pos_ptr++;
-    }
-    else
-    {
-        parsed_gpsinfo_ptr->lat.string_ptr = NULL;
-        parsed_gpsinfo_ptr->lat.string_len = 0;
-        
-        if( c != '\0' )     cgpsinfo_pos_ptr++;
-    }
+    result = BoatLogSyncInit(&log_sync, &g_boat_wallet_info, &filter, 0, GpsTraceOnListSaved, &record_num);
+    if( result != BOAT_SUCCESS ) return BOAT_ERROR;
 
+    result = BoatLogSyncCatchUp(&log_sync, BOAT_LOG_BLOCK_LATEST);
 
-    // Extract <N/S>
-    field_start_pos_ptr = cgpsinfo_pos_ptr;
-    
-    while( (c = *cgpsinfo_pos_ptr) != '\0' )
-    {
-        if( c == ',' )     break;  // Note: cgpsinfo_pos_ptr points to ',' when loop exits
-        cgpsinfo_pos_ptr++;
-    }
-    
-    field_len = (UINT32)(cgpsinfo_pos_ptr - field_start_pos_ptr);
-    if( field_len != 0 )
-    {
-        parsed_gpsinfo_ptr->ns.string_ptr = field_start_pos_ptr;
-        parsed_gpsinfo_ptr->ns.string_len = field_len;
-        cgpsinfo_pos_ptr++;
-    }
-    else
-    {
-        parsed_gpsinfo_ptr->ns.string_ptr = NULL;
-        parsed_gpsinfo_ptr->ns.string_len = 0;
-        
-        if( c != '\0' )     cgpsinfo_pos_ptr++;
-    }
+    BoatLogSyncGetStats(&log_sync, &log_sync_stats);
+    BoatLogSyncDeInit(&log_sync);
 
-    
-    // Extract <log>
-    field_start_pos_ptr = cgpsinfo_pos_ptr;
-    
-    while( (c = *cgpsinfo_pos_ptr) != '\0' )
-    {
-        if( c == ',' )     break;  // Note: cgpsinfo_pos_ptr points to ',' when loop exits
-        cgpsinfo_pos_ptr++;
-    }
-    
-    field_len = (UINT32)(cgpsinfo_pos_ptr - field_start_pos_ptr);
-    if( field_len != 0 )
+    if( result != BOAT_SUCCESS )
     {
-        parsed_gpsinfo_ptr->log.string_ptr = field_start_pos_ptr;
-        parsed_gpsinfo_ptr->log.string_len = field_len;
-        cgpsinfo_pos_ptr++;
-    }
-    else
-    {
-        parsed_gpsinfo_ptr->log.string_ptr = NULL;
-        parsed_gpsinfo_ptr->log.string_len = 0;
-        
-        if( c != '\0' )     cgpsinfo_pos_ptr++;
+        BoatLog(BOAT_LOG_NORMAL, "Fail to read ListSaved events.");
+        return BOAT_ERROR;
     }
 
+    // Records saved before the event was added to the contract have no log
+    BoatLog(BOAT_LOG_NORMAL, "%u of %u records read in %llu requests.",
+            record_num, list_len, log_sync_stats.requests);
 
-    // Extract <E/W>
-    field_start_pos_ptr = cgpsinfo_pos_ptr;
-    
-    while( (c = *cgpsinfo_pos_ptr) != '\0' )
-    {
-        if( c == ',' )     break;  // Note: cgpsinfo_pos_ptr points to ',' when loop exits
-        cgpsinfo_pos_ptr++;
-    }
-    
-    field_len = (UINT32)(cgpsinfo_pos_ptr - field_start_pos_ptr);
-    if( field_len != 0 )
-    {
-        parsed_gpsinfo_ptr->ew.string_ptr = field_start_pos_ptr;
-        parsed_gpsinfo_ptr->ew.string_len = field_len;
-        cgpsinfo_pos_ptr++;
-    }
-    else
-    {
-        parsed_gpsinfo_ptr->ew.string_ptr = NULL;
-        parsed_gpsinfo_ptr->ew.string_len = 0;
-        
-        if( c != '\0' )     cgpsinfo_pos_ptr++;
-    }
+    return BOAT_SUCCESS;
+}
 
 
-    // Extract <date>
-    field_start_pos_ptr = cgpsinfo_pos_ptr;
-    
-    while( (c = *cgpsinfo_pos_ptr) != '\0' )
-    {
-        if( c == ',' )     break;  // Note: cgpsinfo_pos_ptr points to ',' when loop exits
-        cgpsinfo_pos_ptr++;
-    }
-    
-    field_len = (UINT32)(cgpsinfo_pos_ptr - field_start_pos_ptr);
-    if( field_len != 0 )
-    {
-        parsed_gpsinfo_ptr->date.string_ptr = field_start_pos_ptr;
-        parsed_gpsinfo_ptr->date.string_len = field_len;
-        cgpsinfo_pos_ptr++;
-    }
-    else
-    {
-        parsed_gpsinfo_ptr->date.string_ptr = NULL;
-        parsed_gpsinfo_ptr->date.string_len = 0;
-        
-        if( c != '\0' )     cgpsinfo_pos_ptr++;
-    }
+// Fix callback of the GPS sentence parser, keep the latest fix
+static void GpsTraceOnFix(void *fix_ctx_ptr, const BoatGpsFix *fix_ptr)
+{
+    GpsTraceFixCtx *ctx_ptr = (GpsTraceFixCtx *)fix_ctx_ptr;
 
+    memcpy(&ctx_ptr->fix, fix_ptr, sizeof(BoatGpsFix));
+    ctx_ptr->fix_ready = BOAT_TRUE;
+}
 
-    // Extract <UTCtime>
-    field_start_pos_ptr = cgpsinfo_pos_ptr;
-    
-    while( (c = *cgpsinfo_pos_ptr) != '\0' )
-    {
-        if( c == ',' )     break;  // Note: cgpsinfo_pos_ptr points to ',' when loop exits
-        cgpsinfo_pos_ptr++;
-    }
-    
-    field_len = (UINT32)(cgpsinfo_pos_ptr - field_start_pos_ptr);
-    if( field_len != 0 )
-    {
-        parsed_gpsinfo_ptr->utctime.string_ptr = field_start_pos_ptr;
-        parsed_gpsinfo_ptr->utctime.string_len = field_len;
-        cgpsinfo_pos_ptr++;
-    }
-    else
-    {
-        parsed_gpsinfo_ptr->utctime.string_ptr = NULL;
-        parsed_gpsinfo_ptr->utctime.string_len = 0;
-        
-        if( c != '\0' )     cgpsinfo_pos_ptr++;
-    }
 
+// Encode a fix into a bytes32 record, see GPSTRACE_RECORD_TAG
+BOAT_RESULT EncodeGpsRecord(const BoatGpsFix *fix_ptr, BOAT_OUT UINT8 *record_ptr, BOAT_OUT UINT32 *record_len_ptr)
+{
+    BoatCodec codec;
+    SINT64 field[BOAT_GPS_FIELD_NUM];
+    UINT32 encoded_len;
+    BOAT_RESULT result;
 
-    // Extract <alt>
-    field_start_pos_ptr = cgpsinfo_pos_ptr;
-    
-    while( (c = *cgpsinfo_pos_ptr) != '\0' )
-    {
-        if( c == ',' )     break;  // Note: cgpsinfo_pos_ptr points to ',' when loop exits
-        cgpsinfo_pos_ptr++;
-    }
-    
-    field_len = (UINT32)(cgpsinfo_pos_ptr - field_start_pos_ptr);
-    if( field_len != 0 )
-    {
-        parsed_gpsinfo_ptr->alt.string_ptr = field_start_pos_ptr;
-        parsed_gpsinfo_ptr->alt.string_len = field_len;
-        cgpsinfo_pos_ptr++;
-    }
-    else
-    {
-        parsed_gpsinfo_ptr->alt.string_ptr = NULL;
-        parsed_gpsinfo_ptr->alt.string_len = 0;
-        
-        if( c != '\0' )     cgpsinfo_pos_ptr++;
-    }
+    BoatGpsFixToFields(fix_ptr, field);
 
+    // Records are read back individually, so each one is a key frame
+    BoatCodecInit(&codec, BOAT_GPS_FIELD_NUM);
 
-    // Extract <speed>
-    field_start_pos_ptr = cgpsinfo_pos_ptr;
-    
-    while( (c = *cgpsinfo_pos_ptr) != '\0' )
-    {
-        if( c == ',' )     break;  // Note: cgpsinfo_pos_ptr points to ',' when loop exits
-        cgpsinfo_pos_ptr++;
-    }
-    
-    field_len = (UINT32)(cgpsinfo_pos_ptr - field_start_pos_ptr);
-    if( field_len != 0 )
-    {
-        parsed_gpsinfo_ptr->speed.string_ptr = field_start_pos_ptr;
-        parsed_gpsinfo_ptr->speed.string_len = field_len;
-        cgpsinfo_pos_ptr++;
-    }
-    else
-    {
-        parsed_gpsinfo_ptr->speed.string_ptr = NULL;
-        parsed_gpsinfo_ptr->speed.string_len = 0;
-        
-        if( c != '\0' )     cgpsinfo_pos_ptr++;
-    }
+    record_ptr[0] = GPSTRACE_RECORD_TAG;
+    result = BoatCodecEncode(&codec, field, record_ptr + 1, 31, &encoded_len);
+    if( result != BOAT_SUCCESS ) return BOAT_ERROR;
 
+    *record_len_ptr = encoded_len + 1;
 
-    // Extract <course>
-    field_start_pos_ptr = cgpsinfo_pos_ptr;
-    
-    while( (c = *cgpsinfo_pos_ptr) != '\0' )
-    {
-        if( c == ',' )     break;  // Note: cgpsinfo_pos_ptr points to ',' when loop exits
-        cgpsinfo_pos_ptr++;
-    }
-    
-    field_len = (UINT32)(cgpsinfo_pos_ptr - field_start_pos_ptr);
-    if( field_len != 0 )
-    {
-        parsed_gpsinfo_ptr->course.string_ptr = field_start_pos_ptr;
-        parsed_gpsinfo_ptr->course.string_len = field_len;
-        cgpsinfo_pos_ptr++;
-    }
-    else
-    {
-        parsed_gpsinfo_ptr->course.string_ptr = NULL;
-        parsed_gpsinfo_ptr->course.string_len = 0;
-        
-        if( c != '\0' )     cgpsinfo_pos_ptr++;
-    }
-    
     return BOAT_SUCCESS;
 }
 
 
 
-
-
 //CTRL-C:exit main process.
 static void handle_signal(int signum)
 {
@@ -603,13 +428,44 @@ BOAT_RESULT CaseGpsTraceMain(void)
     BOAT_RESULT result;
     UINT32 n;
     CHAR *gps_location_ptr;
-    CHAR truncated_gps_location_str[32];
+    UINT8 gps_record[32];
+    UINT32 gps_record_len;
+    BoatOutbox outbox;
+    BoatBatch batch;
+    BoatBatchStats batch_stats;
+    GpsTraceBatchCtx batch_ctx;
+    BoatNmeaParser gps_parser;
+    GpsTraceFixCtx fix_ctx;
     
 
     //signal-CTRL-C:exit main process.
     exit_signal = 0;
     signal(SIGINT, handle_signal);  
 
+    result = BoatOutboxOpen(&outbox, journal_path, &g_boat_wallet_info);
+    if( result != BOAT_SUCCESS ) return BOAT_ERROR;
+
+    // Locations are batched and saved with saveListBatch(bytes32[])
+    batch_ctx.outbox_ptr = &outbox;
+    batch_ctx.contract_addr_str = contract_address;
+    result = BoatBatchInit(&batch, "saveListBatch(bytes32[])", BOAT_BATCH_ENCODE_BYTES32_ARRAY,
+                           CallSaveListBatchSol, &batch_ctx);
+    if( result == BOAT_SUCCESS )
+    {
+        result = BoatBatchSetThresholds(&batch, BOAT_BATCH_MAX_DATA_SIZE,
+                                        GPSTRACE_BATCH_MAX_RECORDS, BOAT_BATCH_MAX_DELAY_MS);
+    }
+    if( result != BOAT_SUCCESS )
+    {
+        BoatOutboxClose(&outbox);
+        return BOAT_ERROR;
+    }
+
+    // A target reading NMEA sentences from a serial port could feed the parser
+    // with whatever it reads, at any rate
+    fix_ctx.fix_ready = BOAT_FALSE;
+    BoatNmeaInit(&gps_parser, GpsTraceOnFix, &fix_ctx);
+
     DemoEnableGPS();
    
     // Capture 10 location records
@@ -617,8 +473,6 @@ BOAT_RESULT CaseGpsTraceMain(void)
     {
 
         UINT32 k;
-        Cgpsinfo parsed_gpsinfo;
-        UINT32 location_string_len;
         
         for( k = 0; k < 30; k++ )
         {
@@ -634,80 +488,62 @@ BOAT_RESULT CaseGpsTraceMain(void)
         gps_location_ptr = DemoGetGPSLocation();
         if( gps_location_ptr == NULL ) goto CaseGpsTraceMain_destruct;
 
-        result = ParseCGPSINFO(gps_location_ptr, &parsed_gpsinfo);
-        if( result != BOAT_SUCCESS ) goto CaseGpsTraceMain_destruct;
-
-        // Save the location (first 4 fields in GPS information) to contract
-        if(   parsed_gpsinfo.lat.string_len
-            + parsed_gpsinfo.ns.string_len
-            + parsed_gpsinfo.log.string_len
-            + parsed_gpsinfo.ew.string_len
-            + 3 < 32 )  // +3 for three ','s
-        {
-            location_string_len = 0;
-            
-            // <lat>
-            memcpy( truncated_gps_location_str + location_string_len,
-                    parsed_gpsinfo.lat.string_ptr,
-                    parsed_gpsinfo.lat.string_len);
+        // AT response lines come without line terminator
+        BoatNmeaFeed(&gps_parser, gps_location_ptr, strlen(gps_location_ptr));
+        BoatNmeaFeed(&gps_parser, "\r\n", 2);
 
-            location_string_len += parsed_gpsinfo.lat.string_len;
-            truncated_gps_location_str[location_string_len++] = ',';
-            
-            // <N/S>
-            memcpy( truncated_gps_location_str + location_string_len,
-                    parsed_gpsinfo.ns.string_ptr,
-                    parsed_gpsinfo.ns.string_len);
-
-            location_string_len += parsed_gpsinfo.ns.string_len;
-            truncated_gps_location_str[location_string_len++] = ',';
-
-            // <log>
-            memcpy( truncated_gps_location_str + location_string_len,
-                    parsed_gpsinfo.log.string_ptr,
-                    parsed_gpsinfo.log.string_len);
-
-            location_string_len += parsed_gpsinfo.log.string_len;
-            truncated_gps_location_str[location_string_len++] = ',';
-
-            // <E/W>
-            memcpy( truncated_gps_location_str + location_string_len,
-                    parsed_gpsinfo.ew.string_ptr,
-                    parsed_gpsinfo.ew.string_len);
-
-            location_string_len += parsed_gpsinfo.ew.string_len;
-            truncated_gps_location_str[location_string_len++] = '\0';
-                        
-        }
-        
-        // Check for "+CGPSINFO: ,,,,,,,,", i.e. unable to obtain location due
+        // No fix from "+CGPSINFO: ,,,,,,,,", i.e. unable to obtain location due
         // to loss of GPS coverage, ignore it
-        if(   parsed_gpsinfo.lat.string_len
-            + parsed_gpsinfo.ns.string_len
-            + parsed_gpsinfo.log.string_len
-            + parsed_gpsinfo.ew.string_len
-              == 0 )
+        if( fix_ctx.fix_ready == BOAT_FALSE )
         {
             BoatLog(BOAT_LOG_NORMAL, "Out of GPS coverage, ignore.");
             continue;
         }
-      
-        result = CallSaveListSol(contract_address, truncated_gps_location_str);
-        if( result != BOAT_SUCCESS ) goto CaseGpsTraceMain_destruct;
+        fix_ctx.fix_ready = BOAT_FALSE;
+
+        // Save the location in compact binary
+        result = EncodeGpsRecord(&fix_ctx.fix, gps_record, &gps_record_len);
+        if( result != BOAT_SUCCESS ) continue;
+
+        // A location failing to be batched is lost, but later ones are still captured
+        result = BoatBatchAdd(&batch, gps_record, gps_record_len);
+        if( result != BOAT_SUCCESS ) BoatLog(BOAT_LOG_NORMAL, "Fail to save location.");
     }
 
+    // Save locations left in the batch
+    result = BoatBatchFlush(&batch);
+    if( result != BOAT_SUCCESS ) goto CaseGpsTraceMain_destruct;
+
+    BoatBatchGetStats(&batch, &batch_stats);
+    BoatLog(BOAT_LOG_NORMAL, "%llu locations in %llu transactions, %.2f locations/s, %.0f intrinsic gas per location.",
+            batch_stats.records, batch_stats.batches, batch_stats.records_per_sec, batch_stats.intrinsic_gas_per_record);
+
+    // Wait for all locations being accepted by the node, which doesn't mean mined
+    result = BoatOutboxWaitDrained(&outbox, BOAT_WAIT_PENDING_TX_TIMEOUT * 1000);
+    if( result != BOAT_SUCCESS )
+    {
+        BoatLog(BOAT_LOG_NORMAL, "Locations not yet sent are kept in %s.", journal_path);
+        goto CaseGpsTraceMain_destruct;
+    }
+
+    // Give the last transactions a block interval to be mined before reading back
+    sleep(BOAT_MINE_INTERVAL);
+
         
     // Read how many records are there in the contract
     list_len = CallReadListLength(contract_address);
     if( list_len == 0 ) goto CaseGpsTraceMain_destruct;
 
     // Read all records out
-    result = CallReadListByIndex(contract_address, list_len);
+    result = CallReadListByLogs(contract_address, list_len);
     if( result != BOAT_SUCCESS ) goto CaseGpsTraceMain_destruct;   
 
 CaseGpsTraceMain_destruct:
 
     DemoDisableGPS();
+
+    BoatBatchDeInit(&batch);
+    BoatOutboxClose(&outbox);
     
     return BOAT_SUCCESS;
 }
@@ -109,6 +109,33 @@ BOAT_RESULT SetCommonParam(CHAR *node_url_ptr)
 
 
 
+BOAT_RESULT KdfBenchmark(void)
+{
+    BoatKeystoreKdf kdf;
+    
+    // Legacy keccak_256 of password
+    kdf.type = BOAT_KEYSTORE_KDF_KECCAK;
+    kdf.cost = 0;
+    kdf.r = 0;
+    kdf.p = 0;
+    if( BoatKeystoreKdfBenchmark(&kdf, 100) == 0 ) return BOAT_ERROR;
+
+    // PBKDF2 with configured cost
+    kdf.type = BOAT_KEYSTORE_KDF_PBKDF2;
+    kdf.cost = BOAT_KEYSTORE_KDF_COST;
+    if( BoatKeystoreKdfBenchmark(&kdf, 10) == 0 ) return BOAT_ERROR;
+
+    // scrypt with configured cost (requires OpenSSL 1.1.0 or later)
+    kdf.type = BOAT_KEYSTORE_KDF_SCRYPT;
+    kdf.cost = BOAT_KEYSTORE_KDF_COST;
+    kdf.r = BOAT_KEYSTORE_KDF_SCRYPT_R;
+    kdf.p = BOAT_KEYSTORE_KDF_SCRYPT_P;
+    BoatKeystoreKdfBenchmark(&kdf, 10);
+
+    return BOAT_SUCCESS;
+}
+
+
 int main(int argc, char *argv[])
 {
     BOAT_RESULT result;
@@ -116,14 +143,24 @@ int main(int argc, char *argv[])
     
 
     // Usage Example: boatdemo http://127.0.0.1:7545
+    //                boatdemo -kdfbench
     
     if( argc != 2 )
     {
         BoatLog(BOAT_LOG_CRITICAL, "Usage: %s http://<IP Address or URL for node>:<port>\n", argv[0]);
+        BoatLog(BOAT_LOG_CRITICAL, "   or: %s -kdfbench\n", argv[0]);
         return BOAT_ERROR;
     }
 
     BoatWalletInit();
+
+    // Measure keystore load cost of each KDF on this hardware
+    if( strcmp(argv[1], "-kdfbench") == 0 )
+    {
+        result = KdfBenchmark();
+        BoatWalletDeInit();
+        return result;
+    }
     
 
     
@@ -34,6 +34,11 @@ randgenerate.c is the random number generator.
 #include <openssl/rand.h>
 #include "randgenerator.h"
 
+#if BOAT_RAND_USE_DRBG == 1
+#include <pthread.h>
+#include "memzero.h"
+#endif
+
 #else
 
 #include <stdio.h>
@@ -53,7 +58,7 @@ void rand_seed_init(void)
     return;
 }
 
-BOAT_RESULT random_stream(UINT8 *rand_buf, UINT16 len)
+static BOAT_RESULT random_stream_openssl(UINT8 *rand_buf, UINT16 len)
 {
     int rand_status;
     BOAT_RESULT result = BOAT_ERROR;
@@ -94,6 +99,220 @@ BOAT_RESULT random_stream(UINT8 *rand_buf, UINT16 len)
     return result;
 }
 
+#if BOAT_RAND_USE_DRBG == 1
+
+// Size of the buffered key stream. The first 32 bytes of every refill become
+// the next ChaCha20 key and are never output (fast key erasure).
+#define RAND_DRBG_POOL_SIZE 512
+#define RAND_DRBG_KEY_SIZE  32
+
+#if defined(__GNUC__)
+#define RAND_DRBG_THREAD_LOCAL __thread
+#else
+#define RAND_DRBG_THREAD_LOCAL
+#endif
+
+//!@brief Per-thread DRBG state
+typedef struct TRandDrbg
+{
+    UINT32 key[8];                      //!< Current ChaCha20 key
+    UINT8 pool[RAND_DRBG_POOL_SIZE];    //!< Buffered key stream
+    UINT32 pool_pos;                    //!< Next unused byte in <pool>
+    UINT32 output_since_reseed;         //!< Bytes output since last reseed
+    UINT32 fork_generation;             //!< g_rand_fork_generation when last reseeded
+    BOATBOOL seeded;                    //!< BOAT_TRUE once seeded
+}RandDrbg;
+
+static RAND_DRBG_THREAD_LOCAL RandDrbg g_rand_drbg;
+
+// Incremented in the child after every fork(), so that parent and child never
+// output the same buffered bytes
+static volatile UINT32 g_rand_fork_generation = 1;
+static pthread_once_t g_rand_atfork_once = PTHREAD_ONCE_INIT;
+
+
+static void rand_drbg_atfork_child(void)
+{
+    g_rand_fork_generation++;
+}
+
+
+static void rand_drbg_register_atfork(void)
+{
+    pthread_atfork(NULL, NULL, rand_drbg_atfork_child);
+}
+
+
+#define RAND_ROTL32(v, n) (((v) << (n)) | ((v) >> (32 - (n))))
+#define RAND_QUARTERROUND(a, b, c, d) \
+    a += b; d ^= a; d = RAND_ROTL32(d, 16); \
+    c += d; b ^= c; b = RAND_ROTL32(b, 12); \
+    a += b; d ^= a; d = RAND_ROTL32(d,  8); \
+    c += d; b ^= c; b = RAND_ROTL32(b,  7);
+
+/*!*****************************************************************************
+@brief Generate one 64-byte ChaCha20 block
+
+Function: rand_chacha20_block()
+
+    This function generates the ChaCha20 (RFC 7539) key stream block <counter>
+    with a zero nonce.
+
+@return This function doesn't return any thing.
+
+@param[in] key
+    256-bit ChaCha20 key.
+
+@param[in] counter
+    Block counter.
+
+@param[out] out
+    64-byte key stream block.
+*******************************************************************************/
+static void rand_chacha20_block(const UINT32 key[8], UINT32 counter, BOAT_OUT UINT8 out[64])
+{
+    UINT32 x[16];
+    UINT32 input[16];
+    UINT32 i;
+
+    input[0] = 0x61707865;
+    input[1] = 0x3320646e;
+    input[2] = 0x79622d32;
+    input[3] = 0x6b206574;
+    for( i = 0; i < 8; i++ )
+    {
+        input[4 + i] = key[i];
+    }
+    input[12] = counter;
+    input[13] = 0;
+    input[14] = 0;
+    input[15] = 0;
+
+    memcpy(x, input, sizeof(x));
+    for( i = 0; i < 10; i++ )
+    {
+        RAND_QUARTERROUND(x[0], x[4], x[ 8], x[12]);
+        RAND_QUARTERROUND(x[1], x[5], x[ 9], x[13]);
+        RAND_QUARTERROUND(x[2], x[6], x[10], x[14]);
+        RAND_QUARTERROUND(x[3], x[7], x[11], x[15]);
+        RAND_QUARTERROUND(x[0], x[5], x[10], x[15]);
+        RAND_QUARTERROUND(x[1], x[6], x[11], x[12]);
+        RAND_QUARTERROUND(x[2], x[7], x[ 8], x[13]);
+        RAND_QUARTERROUND(x[3], x[4], x[ 9], x[14]);
+    }
+
+    for( i = 0; i < 16; i++ )
+    {
+        x[i] += input[i];
+        out[4 * i + 0] = (UINT8)(x[i]);
+        out[4 * i + 1] = (UINT8)(x[i] >> 8);
+        out[4 * i + 2] = (UINT8)(x[i] >> 16);
+        out[4 * i + 3] = (UINT8)(x[i] >> 24);
+    }
+
+    memzero(x, sizeof(x));
+    memzero(input, sizeof(input));
+}
+
+
+// Refill the pool and replace the key with the first 32 bytes of it
+static void rand_drbg_refill(RandDrbg *drbg_ptr)
+{
+    UINT32 i;
+
+    for( i = 0; i < RAND_DRBG_POOL_SIZE / 64; i++ )
+    {
+        rand_chacha20_block(drbg_ptr->key, i, drbg_ptr->pool + 64 * i);
+    }
+
+    memcpy(drbg_ptr->key, drbg_ptr->pool, RAND_DRBG_KEY_SIZE);
+    memzero(drbg_ptr->pool, RAND_DRBG_KEY_SIZE);
+    drbg_ptr->pool_pos = RAND_DRBG_KEY_SIZE;
+}
+
+
+// Mix fresh platform entropy into the key and discard the buffered stream
+static BOAT_RESULT rand_drbg_reseed(RandDrbg *drbg_ptr)
+{
+    UINT32 seed[8];
+    UINT32 i;
+    BOAT_RESULT result;
+
+    result = random_stream_openssl((UINT8 *)seed, sizeof(seed));
+
+    if( result == BOAT_SUCCESS )
+    {
+        for( i = 0; i < 8; i++ )
+        {
+            drbg_ptr->key[i] ^= seed[i];
+        }
+
+        rand_drbg_refill(drbg_ptr);
+        drbg_ptr->output_since_reseed = 0;
+        drbg_ptr->fork_generation = g_rand_fork_generation;
+        drbg_ptr->seeded = BOAT_TRUE;
+    }
+
+    memzero(seed, sizeof(seed));
+
+    return result;
+}
+
+
+BOAT_RESULT random_stream(UINT8 *rand_buf, UINT16 len)
+{
+    RandDrbg *drbg_ptr = &g_rand_drbg;
+    UINT32 copy_len;
+
+    if( drbg_ptr->seeded != BOAT_TRUE
+        || drbg_ptr->fork_generation != g_rand_fork_generation
+        || drbg_ptr->output_since_reseed >= BOAT_RAND_RESEED_INTERVAL )
+    {
+        pthread_once(&g_rand_atfork_once, rand_drbg_register_atfork);
+
+        if( rand_drbg_reseed(drbg_ptr) != BOAT_SUCCESS )
+        {
+            return BOAT_ERROR;
+        }
+    }
+
+    drbg_ptr->output_since_reseed += len;
+
+    while( len > 0 )
+    {
+        if( drbg_ptr->pool_pos == RAND_DRBG_POOL_SIZE )
+        {
+            rand_drbg_refill(drbg_ptr);
+        }
+
+        copy_len = RAND_DRBG_POOL_SIZE - drbg_ptr->pool_pos;
+        if( copy_len > len )
+        {
+            copy_len = len;
+        }
+
+        // Output bytes are erased from the pool so they can't be recovered later
+        memcpy(rand_buf, drbg_ptr->pool + drbg_ptr->pool_pos, copy_len);
+        memzero(drbg_ptr->pool + drbg_ptr->pool_pos, copy_len);
+        drbg_ptr->pool_pos += copy_len;
+
+        rand_buf += copy_len;
+        len -= copy_len;
+    }
+
+    return BOAT_SUCCESS;
+}
+
+#else // else of #if BOAT_RAND_USE_DRBG == 1
+
+BOAT_RESULT random_stream(UINT8 *rand_buf, UINT16 len)
+{
+    return random_stream_openssl(rand_buf, len);
+}
+
+#endif // else of #if BOAT_RAND_USE_DRBG == 1
+
+
 UINT32 random32(void)
 {
     BOAT_RESULT result;
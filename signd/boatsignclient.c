@@ -0,0 +1,425 @@
+/******************************************************************************
+Copyright (C) 2018-2019 AITOS.IO
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+of the Software, and to permit persons to whom the Software is furnished to do
+so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+******************************************************************************/
+
+/*!@brief Client of the boatsignd signing daemon
+
+@file
+boatsignclient.c contains the client API of boatsignd. Each call sends one
+request and blocks until its response arrives.
+*/
+
+#include "boatsignclient.h"
+
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <arpa/inet.h>
+
+
+static UINT32 g_request_id_counter = 0;
+
+
+// Write all bytes, retrying on partial writes
+static BOAT_RESULT SignClientWriteAll(int fd, const UINT8 *data_ptr, UINT32 data_len)
+{
+    ssize_t written_len;
+
+    while( data_len > 0 )
+    {
+        written_len = send(fd, data_ptr, data_len, MSG_NOSIGNAL);
+        if( written_len < 0 )
+        {
+            if( errno == EINTR )
+            {
+                continue;
+            }
+            return BOAT_ERROR;
+        }
+        data_ptr += written_len;
+        data_len -= written_len;
+    }
+
+    return BOAT_SUCCESS;
+}
+
+
+// Read exactly <data_len> bytes
+static BOAT_RESULT SignClientReadAll(int fd, UINT8 *data_ptr, UINT32 data_len)
+{
+    ssize_t read_len;
+
+    while( data_len > 0 )
+    {
+        read_len = recv(fd, data_ptr, data_len, 0);
+        if( read_len == 0 )
+        {
+            return BOAT_ERROR;
+        }
+        if( read_len < 0 )
+        {
+            if( errno == EINTR )
+            {
+                continue;
+            }
+            return BOAT_ERROR;
+        }
+        data_ptr += read_len;
+        data_len -= read_len;
+    }
+
+    return BOAT_SUCCESS;
+}
+
+
+/*!*****************************************************************************
+@brief Send a request to boatsignd and wait for its response
+
+Function: SignClientCall()
+
+    This function sends a request frame and reads response frames until the
+    one with the same request ID arrives. Responses of other requests are
+    discarded.
+
+@return
+    This function returns BOAT_SUCCESS if the daemon processed the request\n
+    with BOATSIGN_STATUS_OK.\n
+    Otherwise it returns one of the error codes.
+
+@param[in] fd
+    Connection returned by BoatSignClientConnect().
+
+@param[in] op
+    Operation, see BoatSignOp.
+
+@param[in] body_ptr
+    Request body.
+
+@param[in] body_len
+    Length of request body.
+
+@param[out] response_ptr
+    Buffer to hold the response body.
+
+@param[in] response_size
+    Size of <response_ptr>.
+
+@param[out] response_len_ptr
+    Length of the response body.
+*******************************************************************************/
+static BOAT_RESULT SignClientCall(int fd,
+                                  UINT8 op,
+                                  const UINT8 *body_ptr,
+                                  UINT32 body_len,
+                                  BOAT_OUT UINT8 *response_ptr,
+                                  UINT32 response_size,
+                                  BOAT_OUT UINT32 *response_len_ptr)
+{
+    UINT8 header[BOATSIGN_FRAME_HEADER_SIZE + 1];
+    UINT8 discard[256];
+    UINT32 frame_len;
+    UINT32 body_left;
+    UINT32 chunk_len;
+    UINT32 request_id;
+    BOATBOOL matched;
+
+    if( body_len > BOATSIGN_FRAME_MAX_LEN - (BOATSIGN_FRAME_HEADER_SIZE - 4) )
+    {
+        return BOAT_ERROR_INVALID_LENGTH;
+    }
+
+    request_id = htonl(++g_request_id_counter);
+
+    frame_len = htonl(BOATSIGN_FRAME_HEADER_SIZE - 4 + body_len);
+    memcpy(header, &frame_len, 4);
+    header[4] = op;
+    memcpy(header + 5, &request_id, 4);
+
+    if(    SignClientWriteAll(fd, header, BOATSIGN_FRAME_HEADER_SIZE) != BOAT_SUCCESS
+        || SignClientWriteAll(fd, body_ptr, body_len) != BOAT_SUCCESS )
+    {
+        return BOAT_ERROR_RPC_FAIL;
+    }
+
+    while( 1 )
+    {
+        if( SignClientReadAll(fd, header, sizeof(header)) != BOAT_SUCCESS )
+        {
+            return BOAT_ERROR_RPC_FAIL;
+        }
+
+        memcpy(&frame_len, header, 4);
+        frame_len = ntohl(frame_len);
+        if( frame_len < sizeof(header) - 4 || frame_len > BOATSIGN_FRAME_MAX_LEN )
+        {
+            return BOAT_ERROR_RPC_FAIL;
+        }
+        body_left = frame_len - (sizeof(header) - 4);
+
+        matched = (header[4] == op && memcmp(header + 5, &request_id, 4) == 0) ? BOAT_TRUE : BOAT_FALSE;
+
+        if( matched == BOAT_TRUE && header[9] == BOATSIGN_STATUS_OK && body_left <= response_size )
+        {
+            if( SignClientReadAll(fd, response_ptr, body_left) != BOAT_SUCCESS )
+            {
+                return BOAT_ERROR_RPC_FAIL;
+            }
+            *response_len_ptr = body_left;
+            return BOAT_SUCCESS;
+        }
+
+        // Skip the body
+        while( body_left > 0 )
+        {
+            chunk_len = body_left < sizeof(discard) ? body_left : sizeof(discard);
+            if( SignClientReadAll(fd, discard, chunk_len) != BOAT_SUCCESS )
+            {
+                return BOAT_ERROR_RPC_FAIL;
+            }
+            body_left -= chunk_len;
+        }
+
+        if( matched == BOAT_TRUE )
+        {
+            return header[9] == BOATSIGN_STATUS_OK ? BOAT_ERROR_INVALID_LENGTH : BOAT_ERROR;
+        }
+    }
+}
+
+
+/*!*****************************************************************************
+@brief Connect to boatsignd
+
+Function: BoatSignClientConnect()
+
+@return
+    This function returns the connected socket if successful.\n
+    Otherwise it returns -1.
+
+@param[in] socket_path_str
+    Path of the daemon's Unix domain socket. If it's NULL,\n
+    BOATSIGN_DEFAULT_SOCKET_PATH is used.
+*******************************************************************************/
+int BoatSignClientConnect(const CHAR *socket_path_str)
+{
+    struct sockaddr_un addr;
+    int fd;
+
+    if( socket_path_str == NULL )
+    {
+        socket_path_str = BOATSIGN_DEFAULT_SOCKET_PATH;
+    }
+
+    if( strlen(socket_path_str) >= sizeof(addr.sun_path) )
+    {
+        return -1;
+    }
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strcpy(addr.sun_path, socket_path_str);
+
+    fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if( fd < 0 )
+    {
+        return -1;
+    }
+
+    if( connect(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0 )
+    {
+        close(fd);
+        return -1;
+    }
+
+    return fd;
+}
+
+
+/*!*****************************************************************************
+@brief Close a connection to boatsignd
+
+Function: BoatSignClientClose()
+
+@return This function doesn't return any thing.
+
+@param[in] fd
+    Connection returned by BoatSignClientConnect().
+*******************************************************************************/
+void BoatSignClientClose(int fd)
+{
+    if( fd >= 0 )
+    {
+        close(fd);
+    }
+}
+
+
+/*!*****************************************************************************
+@brief Compute public key and address of a private key with boatsignd
+
+Function: BoatSignClientDeriveAddress()
+
+@return
+    This function returns BOAT_SUCCESS if successful.\n
+    Otherwise it returns one of the error codes.
+
+@param[in] fd
+    Connection returned by BoatSignClientConnect().
+
+@param[in] priv_key_array
+    The private key.
+
+@param[out] pub_key_array
+    The 64-byte public key, without the leading 0x04.
+
+@param[out] address
+    The account address.
+*******************************************************************************/
+BOAT_RESULT BoatSignClientDeriveAddress(int fd,
+                                        const UINT8 priv_key_array[32],
+                                        BOAT_OUT UINT8 pub_key_array[64],
+                                        BOAT_OUT BoatAddress address)
+{
+    UINT8 response[64 + sizeof(BoatAddress)];
+    UINT32 response_len;
+    BOAT_RESULT result;
+
+    if( priv_key_array == NULL || pub_key_array == NULL || address == NULL )
+    {
+        return BOAT_ERROR_NULL_POINTER;
+    }
+
+    result = SignClientCall(fd, BOATSIGN_OP_DERIVE_ADDRESS, priv_key_array, 32, response, sizeof(response), &response_len);
+    if( result != BOAT_SUCCESS )
+    {
+        return result;
+    }
+
+    if( response_len != sizeof(response) )
+    {
+        return BOAT_ERROR_INVALID_LENGTH;
+    }
+
+    memcpy(pub_key_array, response, 64);
+    memcpy(address, response + 64, sizeof(BoatAddress));
+
+    return BOAT_SUCCESS;
+}
+
+
+/*!*****************************************************************************
+@brief Sign a raw transaction with boatsignd
+
+Function: BoatSignClientSignRawtx()
+
+    This function asks boatsignd to sign a raw transaction with the account
+    of <sender>. The signed transaction is RLP encoded and ready for
+    eth_sendRawTransaction. The sig and tx_hash in <rawtx_fields_ptr> are
+    ignored.
+
+@return
+    This function returns BOAT_SUCCESS if successful.\n
+    It returns BOAT_ERROR if the daemon doesn't hold the sender or fails.\n
+    It returns BOAT_ERROR_INVALID_LENGTH if <signed_tx_size> is too small.
+
+@param[in] fd
+    Connection returned by BoatSignClientConnect().
+
+@param[in] sender
+    Address of the account to sign with.
+
+@param[in] rawtx_fields_ptr
+    The transaction to sign.
+
+@param[out] signed_tx_ptr
+    Buffer to hold the signed transaction.
+
+@param[in] signed_tx_size
+    Size of <signed_tx_ptr>.
+
+@param[out] signed_tx_len_ptr
+    Length of the signed transaction.
+*******************************************************************************/
+BOAT_RESULT BoatSignClientSignRawtx(int fd,
+                                    const BoatAddress sender,
+                                    const RawtxFields *rawtx_fields_ptr,
+                                    BOAT_OUT UINT8 *signed_tx_ptr,
+                                    UINT32 signed_tx_size,
+                                    BOAT_OUT UINT32 *signed_tx_len_ptr)
+{
+    UINT8 request[BOATSIGN_FRAME_MAX_LEN];
+    const TxFieldMax32B *field_array[3];
+    UINT32 data_len_big;
+    UINT32 pos;
+    UINT32 i;
+
+    if( sender == NULL || rawtx_fields_ptr == NULL || signed_tx_ptr == NULL || signed_tx_len_ptr == NULL )
+    {
+        return BOAT_ERROR_NULL_POINTER;
+    }
+
+    if(    rawtx_fields_ptr->data.field_len > sizeof(request) - (sizeof(BoatAddress) * 2 + (1 + 32) * 4 + 4 + BOATSIGN_FRAME_HEADER_SIZE)
+        || (rawtx_fields_ptr->data.field_len != 0 && rawtx_fields_ptr->data.field_ptr == NULL) )
+    {
+        return BOAT_ERROR_INVALID_LENGTH;
+    }
+
+    memcpy(request, sender, sizeof(BoatAddress));
+    pos = sizeof(BoatAddress);
+
+    field_array[0] = &rawtx_fields_ptr->nonce;
+    field_array[1] = &rawtx_fields_ptr->gasprice;
+    field_array[2] = &rawtx_fields_ptr->gaslimit;
+    for( i = 0; i < 3; i++ )
+    {
+        if( field_array[i]->field_len > 32 )
+        {
+            return BOAT_ERROR_INVALID_LENGTH;
+        }
+        request[pos++] = (UINT8)field_array[i]->field_len;
+        memcpy(request + pos, field_array[i]->field, field_array[i]->field_len);
+        pos += field_array[i]->field_len;
+    }
+
+    memcpy(request + pos, rawtx_fields_ptr->recipient, sizeof(BoatAddress));
+    pos += sizeof(BoatAddress);
+
+    if( rawtx_fields_ptr->value.field_len > 32 )
+    {
+        return BOAT_ERROR_INVALID_LENGTH;
+    }
+    request[pos++] = (UINT8)rawtx_fields_ptr->value.field_len;
+    memcpy(request + pos, rawtx_fields_ptr->value.field, rawtx_fields_ptr->value.field_len);
+    pos += rawtx_fields_ptr->value.field_len;
+
+    data_len_big = htonl(rawtx_fields_ptr->data.field_len);
+    memcpy(request + pos, &data_len_big, sizeof(UINT32));
+    pos += sizeof(UINT32);
+    if( rawtx_fields_ptr->data.field_len != 0 )
+    {
+        memcpy(request + pos, rawtx_fields_ptr->data.field_ptr, rawtx_fields_ptr->data.field_len);
+        pos += rawtx_fields_ptr->data.field_len;
+    }
+
+    return SignClientCall(fd, BOATSIGN_OP_SIGN_RAWTX, request, pos, signed_tx_ptr, signed_tx_size, signed_tx_len_ptr);
+}
@@ -0,0 +1,61 @@
+/******************************************************************************
+Copyright (C) 2018-2019 AITOS.IO
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+of the Software, and to permit persons to whom the Software is furnished to do
+so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+******************************************************************************/
+
+/*!@brief Client of the boatsignd signing daemon
+
+@file
+boatsignclient.h declares the client API of boatsignd. The client only depends
+on libc, so that an application signing through boatsignd doesn't have to link
+the crypto libraries.
+*/
+
+#ifndef __BOATSIGNCLIENT_H__
+#define __BOATSIGNCLIENT_H__
+
+#include "boatsignproto.h"
+#include "wallet/boattypes.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+int BoatSignClientConnect(const CHAR *socket_path_str);
+
+void BoatSignClientClose(int fd);
+
+BOAT_RESULT BoatSignClientDeriveAddress(int fd,
+                                        const UINT8 priv_key_array[32],
+                                        BOAT_OUT UINT8 pub_key_array[64],
+                                        BOAT_OUT BoatAddress address);
+
+BOAT_RESULT BoatSignClientSignRawtx(int fd,
+                                    const BoatAddress sender,
+                                    const RawtxFields *rawtx_fields_ptr,
+                                    BOAT_OUT UINT8 *signed_tx_ptr,
+                                    UINT32 signed_tx_size,
+                                    BOAT_OUT UINT32 *signed_tx_len_ptr);
+
+#ifdef __cplusplus
+}
+#endif /* end of __cplusplus */
+
+#endif
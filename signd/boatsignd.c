@@ -0,0 +1,1137 @@
+/******************************************************************************
+Copyright (C) 2018-2019 AITOS.IO
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+of the Software, and to permit persons to whom the Software is furnished to do
+so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+******************************************************************************/
+
+/*!@brief Offline signing daemon
+
+@file
+boatsignd.c is a long-running daemon that holds decrypted wallet accounts and
+signs raw transactions for client processes over a Unix domain socket. See
+boatsignproto.h for the request protocol.
+
+The main thread runs an epoll event loop that accepts connections, splits
+the incoming byte streams into request frames and writes responses back.
+Requests are processed by a pool of signer threads, so a slow signature
+never blocks other clients. Signer threads hand responses back to the main
+thread through a queue and an eventfd.
+
+Usage:
+    BOATSIGND_PASSWD=<password> boatsignd [-s socket] [-c container | -k keystore] [-t threads] [-n slots]
+
+    -s socket     Path of the Unix domain socket, default BOATSIGN_DEFAULT_SOCKET_PATH
+    -c container  Keystore container holding the accounts, see keystore.h
+    -k keystore   Keystore file holding a single account
+    -t threads    Number of signer threads, default BOATSIGND_DEFAULT_THREAD_NUM
+    -n slots      Number of decrypted accounts cached from the container
+
+The password is taken from environment variable BOATSIGND_PASSWD rather than
+the command line, so that it's not visible to other users. Only the owner
+of the daemon can connect to the socket.
+*/
+
+// For accept4(), getopt() and unsetenv()
+#define _GNU_SOURCE
+
+#include "wallet/boatwallet.h"
+#include "boatsignproto.h"
+
+#include <errno.h>
+#include <signal.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+
+
+//! Environment variable holding the keystore password
+#define BOATSIGND_PASSWD_ENV "BOATSIGND_PASSWD"
+
+//! Number of signer threads if not specified
+#define BOATSIGND_DEFAULT_THREAD_NUM 4
+
+//! Maximum number of requests of one connection being processed at a time
+#define BOATSIGND_MAX_PENDING_NUM 64
+
+//! Maximum number of events handled per epoll_wait()
+#define BOATSIGND_MAX_EVENT_NUM 64
+
+//! Size of the response header: Length, Op, Request ID and Status
+#define BOATSIGND_RESPONSE_HEADER_SIZE (BOATSIGN_FRAME_HEADER_SIZE + 1)
+
+
+//!@brief A request being processed
+typedef struct TSignJob
+{
+    struct TSignJob *next_ptr;
+    int fd;                     //!< Connection the request came from
+    UINT32 conn_id;             //!< ID of the connection, to detect fd reuse
+    UINT8 op;                   //!< Operation, see BoatSignOp
+    UINT32 request_id;          //!< Request ID in BigEndian, echoed as is
+    UINT8 *body_ptr;            //!< Request body
+    UINT32 body_len;            //!< Length of request body
+    UINT8 *response_ptr;        //!< Response frame
+    UINT32 response_len;        //!< Length of response frame
+}SignJob;
+
+//!@brief Job queue between the event loop and signer threads
+typedef struct TSignJobQueue
+{
+    SignJob *head_ptr;
+    SignJob *tail_ptr;
+    BOATBOOL stop;              //!< BOAT_TRUE to stop the signer threads
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+}SignJobQueue;
+
+//!@brief A client connection
+typedef struct TSignConn
+{
+    int fd;
+    UINT32 conn_id;
+    UINT8 *in_buf;              //!< Received bytes not yet split into frames
+    UINT32 in_len;
+    UINT8 *out_buf;             //!< Response bytes not yet sent
+    UINT32 out_pos;             //!< Offset of the first byte not yet sent
+    UINT32 out_len;
+    UINT32 out_capacity;
+    UINT32 pending_num;         //!< Number of requests being processed
+}SignConn;
+
+
+static SignJobQueue g_job_queue = {NULL, NULL, BOAT_FALSE, PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER};
+static SignJobQueue g_done_queue = {NULL, NULL, BOAT_FALSE, PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER};
+
+static int g_epoll_fd = -1;
+static int g_event_fd = -1;
+static int g_listen_fd = -1;
+static SignConn **g_conn_array = NULL;  // Indexed by fd
+static int g_conn_capacity = 0;
+static UINT32 g_conn_id_counter = 0;
+static volatile sig_atomic_t g_stop = 0;
+
+static pthread_mutex_t g_account_mutex = PTHREAD_MUTEX_INITIALIZER;
+static BoatWalletInfo g_single_wallet;
+static BOATBOOL g_single_wallet_loaded = BOAT_FALSE;
+static BoatKeystoreMap g_keystore_map;
+static BOATBOOL g_keystore_map_opened = BOAT_FALSE;
+static UINT8 *g_passwd_ptr = NULL;
+static UINT32 g_passwd_len = 0;
+
+
+static void SignJobFree(SignJob *job_ptr)
+{
+    if( job_ptr->body_ptr != NULL )
+    {
+        BoatFree(job_ptr->body_ptr);
+    }
+
+    if( job_ptr->response_ptr != NULL )
+    {
+        BoatFree(job_ptr->response_ptr);
+    }
+
+    BoatFree(job_ptr);
+}
+
+
+static void SignJobQueuePush(SignJobQueue *queue_ptr, SignJob *job_ptr)
+{
+    job_ptr->next_ptr = NULL;
+
+    pthread_mutex_lock(&queue_ptr->mutex);
+    if( queue_ptr->tail_ptr == NULL )
+    {
+        queue_ptr->head_ptr = job_ptr;
+    }
+    else
+    {
+        queue_ptr->tail_ptr->next_ptr = job_ptr;
+    }
+    queue_ptr->tail_ptr = job_ptr;
+    pthread_cond_signal(&queue_ptr->cond);
+    pthread_mutex_unlock(&queue_ptr->mutex);
+}
+
+
+// Pop a job. If <wait> is BOAT_TRUE, block until a job comes or the queue is stopped.
+static SignJob *SignJobQueuePop(SignJobQueue *queue_ptr, BOATBOOL wait)
+{
+    SignJob *job_ptr;
+
+    pthread_mutex_lock(&queue_ptr->mutex);
+    while( wait == BOAT_TRUE && queue_ptr->head_ptr == NULL && queue_ptr->stop != BOAT_TRUE )
+    {
+        pthread_cond_wait(&queue_ptr->cond, &queue_ptr->mutex);
+    }
+
+    job_ptr = queue_ptr->head_ptr;
+    if( job_ptr != NULL )
+    {
+        queue_ptr->head_ptr = job_ptr->next_ptr;
+        if( queue_ptr->head_ptr == NULL )
+        {
+            queue_ptr->tail_ptr = NULL;
+        }
+    }
+    pthread_mutex_unlock(&queue_ptr->mutex);
+
+    return job_ptr;
+}
+
+
+/*!*****************************************************************************
+@brief Get an account held by the daemon
+
+Function: SignerGetAccount()
+
+    This function copies the account and network information of the address
+    into <wallet_info_ptr>. Accounts in a keystore container are decrypted on
+    first use and cached in the locked arena of the keystore map.
+
+    The caller MUST wipe the account information after use. The node URL
+    pointer is set to NULL.
+
+@return
+    This function returns BOAT_SUCCESS if the account is held by the daemon.\n
+    Otherwise it returns BOAT_ERROR.
+
+@param[in] address
+    Address of the account.
+
+@param[out] wallet_info_ptr
+    The account.
+*******************************************************************************/
+static BOAT_RESULT SignerGetAccount(const BoatAddress address, BOAT_OUT BoatWalletInfo *wallet_info_ptr)
+{
+    const BoatWalletInfo *found_wallet_ptr = NULL;
+
+    pthread_mutex_lock(&g_account_mutex);
+
+    if(    g_single_wallet_loaded == BOAT_TRUE
+        && memcmp(g_single_wallet.account_info.address, address, sizeof(BoatAddress)) == 0 )
+    {
+        found_wallet_ptr = &g_single_wallet;
+    }
+    else if( g_keystore_map_opened == BOAT_TRUE )
+    {
+        found_wallet_ptr = BoatKeystoreMapGet(&g_keystore_map, address, g_passwd_ptr, g_passwd_len);
+    }
+
+    if( found_wallet_ptr != NULL )
+    {
+        wallet_info_ptr->account_info = found_wallet_ptr->account_info;
+        wallet_info_ptr->network_info.chain_id = found_wallet_ptr->network_info.chain_id;
+        wallet_info_ptr->network_info.eip155_compatibility = found_wallet_ptr->network_info.eip155_compatibility;
+        wallet_info_ptr->network_info.node_url_ptr = NULL;
+    }
+
+    pthread_mutex_unlock(&g_account_mutex);
+
+    return found_wallet_ptr != NULL ? BOAT_SUCCESS : BOAT_ERROR;
+}
+
+
+// Parse a 1-byte-length-prefixed field of up to 32 bytes
+static BOAT_RESULT SignerParseField(const UINT8 *body_ptr, UINT32 body_len, UINT32 *pos_ptr, BOAT_OUT TxFieldMax32B *field_ptr)
+{
+    UINT32 field_len;
+
+    if( *pos_ptr + 1 > body_len )
+    {
+        return BOAT_ERROR;
+    }
+
+    field_len = body_ptr[(*pos_ptr)++];
+    if( field_len > sizeof(field_ptr->field) || *pos_ptr + field_len > body_len )
+    {
+        return BOAT_ERROR;
+    }
+
+    memcpy(field_ptr->field, body_ptr + *pos_ptr, field_len);
+    field_ptr->field_len = field_len;
+    *pos_ptr += field_len;
+
+    return BOAT_SUCCESS;
+}
+
+
+/*!*****************************************************************************
+@brief Process a request
+
+Function: SignerProcessJob()
+
+    This function processes a request in a signer thread and builds the
+    response frame in the job.
+
+@return This function doesn't return any thing.
+
+@param[in] job_ptr
+    The request.
+*******************************************************************************/
+static void SignerProcessJob(SignJob *job_ptr)
+{
+    UINT8 status = BOATSIGN_STATUS_OK;
+    UINT32 response_capacity = BOATSIGND_RESPONSE_HEADER_SIZE;
+    UINT32 response_body_len = 0;
+    UINT32 frame_len_big;
+    UINT32 data_len_big;
+    UINT32 pos = 0;
+    UINT8 pub_key65[65];
+    BoatAddress sender;
+    BoatWalletInfo wallet_info;
+    TxInfo tx_info;
+
+    memset(&wallet_info, 0, sizeof(wallet_info));
+    memset(&tx_info, 0, sizeof(tx_info));
+
+    switch( job_ptr->op )
+    {
+        case BOATSIGN_OP_DERIVE_ADDRESS:
+            if(    job_ptr->body_len != 32
+                || BoatWalletCheckPrivkey(job_ptr->body_ptr) != BOAT_SUCCESS )
+            {
+                status = BOATSIGN_STATUS_BAD_REQUEST;
+                break;
+            }
+            response_capacity += 64 + sizeof(BoatAddress);
+            break;
+
+        case BOATSIGN_OP_SIGN_RAWTX:
+            if( job_ptr->body_len < sizeof(BoatAddress) )
+            {
+                status = BOATSIGN_STATUS_BAD_REQUEST;
+                break;
+            }
+            memcpy(sender, job_ptr->body_ptr, sizeof(BoatAddress));
+            pos = sizeof(BoatAddress);
+
+            if(    SignerParseField(job_ptr->body_ptr, job_ptr->body_len, &pos, &tx_info.rawtx_fields.nonce) != BOAT_SUCCESS
+                || SignerParseField(job_ptr->body_ptr, job_ptr->body_len, &pos, &tx_info.rawtx_fields.gasprice) != BOAT_SUCCESS
+                || SignerParseField(job_ptr->body_ptr, job_ptr->body_len, &pos, &tx_info.rawtx_fields.gaslimit) != BOAT_SUCCESS
+                || pos + sizeof(BoatAddress) > job_ptr->body_len )
+            {
+                status = BOATSIGN_STATUS_BAD_REQUEST;
+                break;
+            }
+            memcpy(tx_info.rawtx_fields.recipient, job_ptr->body_ptr + pos, sizeof(BoatAddress));
+            pos += sizeof(BoatAddress);
+
+            if(    SignerParseField(job_ptr->body_ptr, job_ptr->body_len, &pos, &tx_info.rawtx_fields.value) != BOAT_SUCCESS
+                || pos + sizeof(UINT32) > job_ptr->body_len )
+            {
+                status = BOATSIGN_STATUS_BAD_REQUEST;
+                break;
+            }
+            memcpy(&data_len_big, job_ptr->body_ptr + pos, sizeof(UINT32));
+            pos += sizeof(UINT32);
+            tx_info.rawtx_fields.data.field_len = Utilityntohl(data_len_big);
+            tx_info.rawtx_fields.data.field_ptr = job_ptr->body_ptr + pos;
+
+            if( tx_info.rawtx_fields.data.field_len != job_ptr->body_len - pos )
+            {
+                status = BOATSIGN_STATUS_BAD_REQUEST;
+                break;
+            }
+
+            if( SignerGetAccount(sender, &wallet_info) != BOAT_SUCCESS )
+            {
+                status = BOATSIGN_STATUS_NO_ACCOUNT;
+                break;
+            }
+
+            response_capacity += TxRlpStreamSizeEstimate(&tx_info);
+            break;
+
+        default:
+            status = BOATSIGN_STATUS_BAD_REQUEST;
+            break;
+    }
+
+    job_ptr->response_ptr = BoatMalloc(response_capacity);
+    if( job_ptr->response_ptr == NULL )
+    {
+        BoatLog(BOAT_LOG_CRITICAL, "Fail to allocate memory.");
+        memset(&wallet_info.account_info, 0, sizeof(wallet_info.account_info));
+        return;
+    }
+
+    if( status == BOATSIGN_STATUS_OK && job_ptr->op == BOATSIGN_OP_DERIVE_ADDRESS )
+    {
+        // Public key and address, see BoatWalletSetPrivkey()
+        ecdsa_get_public_key65(&secp256k1, job_ptr->body_ptr, pub_key65);
+        memcpy(job_ptr->response_ptr + BOATSIGND_RESPONSE_HEADER_SIZE, &pub_key65[1], 64);
+        keccak_256(&pub_key65[1], 64, pub_key65);
+        memcpy(job_ptr->response_ptr + BOATSIGND_RESPONSE_HEADER_SIZE + 64, &pub_key65[32 - sizeof(BoatAddress)], sizeof(BoatAddress));
+        response_body_len = 64 + sizeof(BoatAddress);
+    }
+    else if( status == BOATSIGN_STATUS_OK && job_ptr->op == BOATSIGN_OP_SIGN_RAWTX )
+    {
+        if( RawtxSign(&wallet_info,
+                      &tx_info,
+                      job_ptr->response_ptr + BOATSIGND_RESPONSE_HEADER_SIZE,
+                      response_capacity - BOATSIGND_RESPONSE_HEADER_SIZE,
+                      &response_body_len) != BOAT_SUCCESS )
+        {
+            status = BOATSIGN_STATUS_FAIL;
+            response_body_len = 0;
+        }
+    }
+
+    // Destroy sensitive information
+    memset(&wallet_info.account_info, 0, sizeof(wallet_info.account_info));
+
+    frame_len_big = Utilityhtonl(BOATSIGND_RESPONSE_HEADER_SIZE - sizeof(UINT32) + response_body_len);
+    memcpy(job_ptr->response_ptr, &frame_len_big, sizeof(UINT32));
+    job_ptr->response_ptr[4] = job_ptr->op;
+    memcpy(job_ptr->response_ptr + 5, &job_ptr->request_id, sizeof(UINT32));
+    job_ptr->response_ptr[9] = status;
+    job_ptr->response_len = BOATSIGND_RESPONSE_HEADER_SIZE + response_body_len;
+}
+
+
+// Signer thread
+static void *SignerThread(void *arg)
+{
+    SignJob *job_ptr;
+    UINT64 wakeup = 1;
+
+    (void)arg;
+
+    while( (job_ptr = SignJobQueuePop(&g_job_queue, BOAT_TRUE)) != NULL )
+    {
+        SignerProcessJob(job_ptr);
+
+        // The request body may hold a private key
+        memset(job_ptr->body_ptr, 0, job_ptr->body_len);
+
+        SignJobQueuePush(&g_done_queue, job_ptr);
+        if( write(g_event_fd, &wakeup, sizeof(wakeup)) != sizeof(wakeup) )
+        {
+            BoatLog(BOAT_LOG_NORMAL, "Fail to wake up event loop.");
+        }
+    }
+
+    return NULL;
+}
+
+
+static void ConnUpdateEvents(SignConn *conn_ptr)
+{
+    struct epoll_event event;
+
+    memset(&event, 0, sizeof(event));
+    event.data.fd = conn_ptr->fd;
+
+    // Stop reading while too many requests are being processed
+    if( conn_ptr->pending_num < BOATSIGND_MAX_PENDING_NUM )
+    {
+        event.events |= EPOLLIN;
+    }
+
+    if( conn_ptr->out_pos < conn_ptr->out_len )
+    {
+        event.events |= EPOLLOUT;
+    }
+
+    epoll_ctl(g_epoll_fd, EPOLL_CTL_MOD, conn_ptr->fd, &event);
+}
+
+
+static void ConnClose(SignConn *conn_ptr)
+{
+    epoll_ctl(g_epoll_fd, EPOLL_CTL_DEL, conn_ptr->fd, NULL);
+    close(conn_ptr->fd);
+    g_conn_array[conn_ptr->fd] = NULL;
+
+    // Responses of requests still being processed are dropped on arrival
+    if( conn_ptr->in_buf != NULL )
+    {
+        memset(conn_ptr->in_buf, 0, conn_ptr->in_len);
+        BoatFree(conn_ptr->in_buf);
+    }
+
+    if( conn_ptr->out_buf != NULL )
+    {
+        BoatFree(conn_ptr->out_buf);
+    }
+
+    BoatFree(conn_ptr);
+}
+
+
+static void ConnAccept(void)
+{
+    struct epoll_event event;
+    SignConn *conn_ptr;
+    SignConn **conn_array;
+    int conn_capacity;
+    int fd;
+
+    while( (fd = accept4(g_listen_fd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC)) >= 0 )
+    {
+        if( fd >= g_conn_capacity )
+        {
+            conn_capacity = g_conn_capacity == 0 ? 64 : g_conn_capacity;
+            while( conn_capacity <= fd )
+            {
+                conn_capacity *= 2;
+            }
+
+            conn_array = BoatMalloc(conn_capacity * sizeof(SignConn *));
+            if( conn_array == NULL )
+            {
+                BoatLog(BOAT_LOG_CRITICAL, "Fail to allocate memory.");
+                close(fd);
+                continue;
+            }
+            memset(conn_array, 0, conn_capacity * sizeof(SignConn *));
+
+            if( g_conn_array != NULL )
+            {
+                memcpy(conn_array, g_conn_array, g_conn_capacity * sizeof(SignConn *));
+                BoatFree(g_conn_array);
+            }
+            g_conn_array = conn_array;
+            g_conn_capacity = conn_capacity;
+        }
+
+        conn_ptr = BoatMalloc(sizeof(SignConn));
+        if( conn_ptr == NULL )
+        {
+            BoatLog(BOAT_LOG_CRITICAL, "Fail to allocate memory.");
+            close(fd);
+            continue;
+        }
+        memset(conn_ptr, 0, sizeof(SignConn));
+
+        conn_ptr->in_buf = BoatMalloc(sizeof(UINT32) + BOATSIGN_FRAME_MAX_LEN);
+        if( conn_ptr->in_buf == NULL )
+        {
+            BoatLog(BOAT_LOG_CRITICAL, "Fail to allocate memory.");
+            BoatFree(conn_ptr);
+            close(fd);
+            continue;
+        }
+
+        conn_ptr->fd = fd;
+        if( ++g_conn_id_counter == 0 )
+        {
+            ++g_conn_id_counter;
+        }
+        conn_ptr->conn_id = g_conn_id_counter;
+        g_conn_array[fd] = conn_ptr;
+
+        memset(&event, 0, sizeof(event));
+        event.events = EPOLLIN;
+        event.data.fd = fd;
+        if( epoll_ctl(g_epoll_fd, EPOLL_CTL_ADD, fd, &event) != 0 )
+        {
+            ConnClose(conn_ptr);
+        }
+    }
+}
+
+
+/*!*****************************************************************************
+@brief Split received bytes of a connection into requests
+
+Function: ConnParseFrames()
+
+    This function splits complete frames off the receive buffer and queues
+    them to the signer threads, as long as the connection has fewer than
+    BOATSIGND_MAX_PENDING_NUM requests being processed.
+
+@return
+    This function returns BOAT_SUCCESS if successful.\n
+    If a frame is malformed, it returns BOAT_ERROR and the connection should\n
+    be closed.
+
+@param[in] conn_ptr
+    The connection.
+*******************************************************************************/
+static BOAT_RESULT ConnParseFrames(SignConn *conn_ptr)
+{
+    SignJob *job_ptr;
+    UINT32 frame_len_big;
+    UINT32 frame_len;
+    UINT32 parsed_len = 0;
+
+    while( conn_ptr->pending_num < BOATSIGND_MAX_PENDING_NUM
+           && conn_ptr->in_len - parsed_len >= sizeof(UINT32) )
+    {
+        memcpy(&frame_len_big, conn_ptr->in_buf + parsed_len, sizeof(UINT32));
+        frame_len = Utilityntohl(frame_len_big);
+
+        if( frame_len < BOATSIGN_FRAME_HEADER_SIZE - sizeof(UINT32) || frame_len > BOATSIGN_FRAME_MAX_LEN )
+        {
+            BoatLog(BOAT_LOG_NORMAL, "Malformed request frame.");
+            return BOAT_ERROR;
+        }
+
+        if( conn_ptr->in_len - parsed_len < sizeof(UINT32) + frame_len )
+        {
+            break;
+        }
+
+        job_ptr = BoatMalloc(sizeof(SignJob));
+        if( job_ptr == NULL )
+        {
+            BoatLog(BOAT_LOG_CRITICAL, "Fail to allocate memory.");
+            return BOAT_ERROR;
+        }
+        memset(job_ptr, 0, sizeof(SignJob));
+
+        job_ptr->fd = conn_ptr->fd;
+        job_ptr->conn_id = conn_ptr->conn_id;
+        job_ptr->op = conn_ptr->in_buf[parsed_len + 4];
+        memcpy(&job_ptr->request_id, conn_ptr->in_buf + parsed_len + 5, sizeof(UINT32));
+        job_ptr->body_len = frame_len - (BOATSIGN_FRAME_HEADER_SIZE - sizeof(UINT32));
+
+        // +1 so that an empty body still gets a buffer
+        job_ptr->body_ptr = BoatMalloc(job_ptr->body_len + 1);
+        if( job_ptr->body_ptr == NULL )
+        {
+            BoatLog(BOAT_LOG_CRITICAL, "Fail to allocate memory.");
+            BoatFree(job_ptr);
+            return BOAT_ERROR;
+        }
+        memcpy(job_ptr->body_ptr, conn_ptr->in_buf + parsed_len + BOATSIGN_FRAME_HEADER_SIZE, job_ptr->body_len);
+
+        SignJobQueuePush(&g_job_queue, job_ptr);
+        conn_ptr->pending_num++;
+        parsed_len += sizeof(UINT32) + frame_len;
+    }
+
+    if( parsed_len > 0 )
+    {
+        memmove(conn_ptr->in_buf, conn_ptr->in_buf + parsed_len, conn_ptr->in_len - parsed_len);
+        memset(conn_ptr->in_buf + conn_ptr->in_len - parsed_len, 0, parsed_len);
+        conn_ptr->in_len -= parsed_len;
+    }
+
+    return BOAT_SUCCESS;
+}
+
+
+// Send as many pending response bytes as the socket accepts
+static BOAT_RESULT ConnFlush(SignConn *conn_ptr)
+{
+    ssize_t sent_len;
+
+    while( conn_ptr->out_pos < conn_ptr->out_len )
+    {
+        sent_len = send(conn_ptr->fd,
+                        conn_ptr->out_buf + conn_ptr->out_pos,
+                        conn_ptr->out_len - conn_ptr->out_pos,
+                        MSG_NOSIGNAL);
+        if( sent_len < 0 )
+        {
+            if( errno == EAGAIN || errno == EWOULDBLOCK )
+            {
+                break;
+            }
+            if( errno == EINTR )
+            {
+                continue;
+            }
+            return BOAT_ERROR;
+        }
+        conn_ptr->out_pos += sent_len;
+    }
+
+    if( conn_ptr->out_pos == conn_ptr->out_len )
+    {
+        conn_ptr->out_pos = 0;
+        conn_ptr->out_len = 0;
+    }
+
+    return BOAT_SUCCESS;
+}
+
+
+// Read from a connection and queue complete requests
+static BOAT_RESULT ConnRead(SignConn *conn_ptr)
+{
+    ssize_t read_len;
+
+    read_len = recv(conn_ptr->fd,
+                    conn_ptr->in_buf + conn_ptr->in_len,
+                    sizeof(UINT32) + BOATSIGN_FRAME_MAX_LEN - conn_ptr->in_len,
+                    0);
+    if( read_len == 0 )
+    {
+        return BOAT_ERROR;
+    }
+    if( read_len < 0 )
+    {
+        return (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) ? BOAT_SUCCESS : BOAT_ERROR;
+    }
+    conn_ptr->in_len += read_len;
+
+    return ConnParseFrames(conn_ptr);
+}
+
+
+// Hand finished responses to their connections
+static void DeliverResponses(void)
+{
+    SignJob *job_ptr;
+    SignConn *conn_ptr;
+    UINT8 *out_buf;
+    UINT32 out_capacity;
+    UINT64 counter;
+
+    if( read(g_event_fd, &counter, sizeof(counter)) != sizeof(counter) )
+    {
+        // Nothing to read, responses were delivered on an earlier wake-up
+    }
+
+    while( (job_ptr = SignJobQueuePop(&g_done_queue, BOAT_FALSE)) != NULL )
+    {
+        conn_ptr = job_ptr->fd < g_conn_capacity ? g_conn_array[job_ptr->fd] : NULL;
+
+        if( conn_ptr == NULL || conn_ptr->conn_id != job_ptr->conn_id || job_ptr->response_ptr == NULL )
+        {
+            if( conn_ptr != NULL && conn_ptr->conn_id == job_ptr->conn_id )
+            {
+                // Out of memory while processing: the client would wait forever
+                ConnClose(conn_ptr);
+            }
+            SignJobFree(job_ptr);
+            continue;
+        }
+
+        conn_ptr->pending_num--;
+
+        if( conn_ptr->out_len + job_ptr->response_len > conn_ptr->out_capacity )
+        {
+            out_capacity = conn_ptr->out_capacity == 0 ? 4096 : conn_ptr->out_capacity;
+            while( out_capacity < conn_ptr->out_len + job_ptr->response_len )
+            {
+                out_capacity *= 2;
+            }
+
+            out_buf = BoatMalloc(out_capacity);
+            if( out_buf == NULL )
+            {
+                BoatLog(BOAT_LOG_CRITICAL, "Fail to allocate memory.");
+                ConnClose(conn_ptr);
+                SignJobFree(job_ptr);
+                continue;
+            }
+
+            if( conn_ptr->out_buf != NULL )
+            {
+                memcpy(out_buf, conn_ptr->out_buf + conn_ptr->out_pos, conn_ptr->out_len - conn_ptr->out_pos);
+                BoatFree(conn_ptr->out_buf);
+            }
+            conn_ptr->out_len -= conn_ptr->out_pos;
+            conn_ptr->out_pos = 0;
+            conn_ptr->out_buf = out_buf;
+            conn_ptr->out_capacity = out_capacity;
+        }
+
+        memcpy(conn_ptr->out_buf + conn_ptr->out_len, job_ptr->response_ptr, job_ptr->response_len);
+        conn_ptr->out_len += job_ptr->response_len;
+        SignJobFree(job_ptr);
+
+        // Requests held back by the pending limit may now be queued
+        if(    ConnParseFrames(conn_ptr) != BOAT_SUCCESS
+            || ConnFlush(conn_ptr) != BOAT_SUCCESS )
+        {
+            ConnClose(conn_ptr);
+            continue;
+        }
+
+        ConnUpdateEvents(conn_ptr);
+    }
+}
+
+
+static void SignalHandler(int signal_num)
+{
+    (void)signal_num;
+    g_stop = 1;
+}
+
+
+/*!*****************************************************************************
+@brief Open the listening socket
+
+Function: ListenOpen()
+
+@return
+    This function returns BOAT_SUCCESS if the socket is listening.\n
+    Otherwise it returns BOAT_ERROR.
+
+@param[in] socket_path_str
+    Path of the Unix domain socket.
+*******************************************************************************/
+static BOAT_RESULT ListenOpen(const CHAR *socket_path_str)
+{
+    struct sockaddr_un addr;
+    mode_t old_umask;
+
+    if( strlen(socket_path_str) >= sizeof(addr.sun_path) )
+    {
+        BoatLog(BOAT_LOG_CRITICAL, "Socket path is too long: %s.", socket_path_str);
+        return BOAT_ERROR;
+    }
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strcpy(addr.sun_path, socket_path_str);
+
+    g_listen_fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if( g_listen_fd < 0 )
+    {
+        BoatLog(BOAT_LOG_CRITICAL, "Fail to create socket.");
+        return BOAT_ERROR;
+    }
+
+    unlink(socket_path_str);
+
+    // Only the owner may connect
+    old_umask = umask(0177);
+    if( bind(g_listen_fd, (struct sockaddr *)&addr, sizeof(addr)) != 0 )
+    {
+        umask(old_umask);
+        BoatLog(BOAT_LOG_CRITICAL, "Fail to bind socket: %s.", socket_path_str);
+        return BOAT_ERROR;
+    }
+    umask(old_umask);
+
+    if( listen(g_listen_fd, SOMAXCONN) != 0 )
+    {
+        BoatLog(BOAT_LOG_CRITICAL, "Fail to listen on socket: %s.", socket_path_str);
+        return BOAT_ERROR;
+    }
+
+    return BOAT_SUCCESS;
+}
+
+
+/*!*****************************************************************************
+@brief Load the accounts to hold
+
+Function: AccountsLoad()
+
+@return
+    This function returns BOAT_SUCCESS if the accounts are loaded.\n
+    Otherwise it returns BOAT_ERROR.
+
+@param[in] container_path_str
+    Path of the keystore container, or NULL.
+
+@param[in] keystore_path_str
+    Path of the single-account keystore file, or NULL.
+
+@param[in] slot_num
+    Number of decrypted accounts cached from the container.
+*******************************************************************************/
+static BOAT_RESULT AccountsLoad(const CHAR *container_path_str, const CHAR *keystore_path_str, UINT32 slot_num)
+{
+    const CHAR *passwd_str;
+
+    passwd_str = getenv(BOATSIGND_PASSWD_ENV);
+    if( passwd_str == NULL || passwd_str[0] == '\0' )
+    {
+        BoatLog(BOAT_LOG_CRITICAL, "Keystore password must be set in environment variable %s.", BOATSIGND_PASSWD_ENV);
+        return BOAT_ERROR;
+    }
+
+    g_passwd_len = strlen(passwd_str);
+    g_passwd_ptr = BoatMalloc(g_passwd_len);
+    if( g_passwd_ptr == NULL )
+    {
+        BoatLog(BOAT_LOG_CRITICAL, "Fail to allocate memory.");
+        return BOAT_ERROR;
+    }
+    memcpy(g_passwd_ptr, passwd_str, g_passwd_len);
+    mlock(g_passwd_ptr, g_passwd_len);
+
+    // Don't pass the password on
+    unsetenv(BOATSIGND_PASSWD_ENV);
+
+    if( keystore_path_str != NULL )
+    {
+        mlock(&g_single_wallet, sizeof(g_single_wallet));
+        if( BoatWalletLoadWalletEx(&g_single_wallet, g_passwd_ptr, g_passwd_len, keystore_path_str) != BOAT_SUCCESS )
+        {
+            BoatLog(BOAT_LOG_CRITICAL, "Fail to load keystore: %s.", keystore_path_str);
+            return BOAT_ERROR;
+        }
+        g_single_wallet_loaded = BOAT_TRUE;
+    }
+
+    if( container_path_str != NULL )
+    {
+        if( BoatKeystoreMapOpen(&g_keystore_map, container_path_str, slot_num) != BOAT_SUCCESS )
+        {
+            BoatLog(BOAT_LOG_CRITICAL, "Fail to open keystore container: %s.", container_path_str);
+            return BOAT_ERROR;
+        }
+        g_keystore_map_opened = BOAT_TRUE;
+        BoatLog(BOAT_LOG_NORMAL, "%u accounts in keystore container.", g_keystore_map.index_num);
+    }
+
+    return BOAT_SUCCESS;
+}
+
+
+static void AccountsUnload(void)
+{
+    if( g_keystore_map_opened == BOAT_TRUE )
+    {
+        BoatKeystoreMapClose(&g_keystore_map);
+        g_keystore_map_opened = BOAT_FALSE;
+    }
+
+    if( g_single_wallet.network_info.node_url_ptr != NULL )
+    {
+        BoatFree(g_single_wallet.network_info.node_url_ptr);
+    }
+    memset(&g_single_wallet, 0, sizeof(g_single_wallet));
+    g_single_wallet_loaded = BOAT_FALSE;
+
+    if( g_passwd_ptr != NULL )
+    {
+        memset(g_passwd_ptr, 0, g_passwd_len);
+        BoatFree(g_passwd_ptr);
+        g_passwd_ptr = NULL;
+    }
+
+    BoatKeystoreKdfCacheFlush();
+}
+
+
+int main(int argc, char *argv[])
+{
+    const CHAR *socket_path_str = BOATSIGN_DEFAULT_SOCKET_PATH;
+    const CHAR *container_path_str = NULL;
+    const CHAR *keystore_path_str = NULL;
+    UINT32 thread_num = BOATSIGND_DEFAULT_THREAD_NUM;
+    UINT32 slot_num = 0;
+    pthread_t *thread_array = NULL;
+    UINT32 started_thread_num = 0;
+    struct epoll_event event;
+    struct epoll_event event_array[BOATSIGND_MAX_EVENT_NUM];
+    struct sigaction signal_action;
+    SignConn *conn_ptr;
+    SignJob *job_ptr;
+    int event_num;
+    int opt;
+    int i;
+
+    BOAT_RESULT result = BOAT_SUCCESS;
+    boat_try_declare;
+
+    while( (opt = getopt(argc, argv, "s:c:k:t:n:")) != -1 )
+    {
+        switch( opt )
+        {
+            case 's': socket_path_str = optarg; break;
+            case 'c': container_path_str = optarg; break;
+            case 'k': keystore_path_str = optarg; break;
+            case 't': thread_num = (UINT32)atoi(optarg); break;
+            case 'n': slot_num = (UINT32)atoi(optarg); break;
+            default:
+                BoatLog(BOAT_LOG_CRITICAL, "Usage: %s=<password> %s [-s socket] [-c container | -k keystore] [-t threads] [-n slots]",
+                        BOATSIGND_PASSWD_ENV, argv[0]);
+                return BOAT_ERROR;
+        }
+    }
+
+    if( (container_path_str == NULL && keystore_path_str == NULL) || thread_num == 0 )
+    {
+        BoatLog(BOAT_LOG_CRITICAL, "Usage: %s=<password> %s [-s socket] [-c container | -k keystore] [-t threads] [-n slots]",
+                BOATSIGND_PASSWD_ENV, argv[0]);
+        return BOAT_ERROR;
+    }
+
+    BoatWalletInit();
+
+    memset(&signal_action, 0, sizeof(signal_action));
+    signal_action.sa_handler = SignalHandler;
+    sigaction(SIGINT, &signal_action, NULL);
+    sigaction(SIGTERM, &signal_action, NULL);
+    signal(SIGPIPE, SIG_IGN);
+
+    if( AccountsLoad(container_path_str, keystore_path_str, slot_num) != BOAT_SUCCESS )
+    {
+        boat_throw(BOAT_ERROR, main_cleanup);
+    }
+
+    g_epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    g_event_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if( g_epoll_fd < 0 || g_event_fd < 0 )
+    {
+        BoatLog(BOAT_LOG_CRITICAL, "Fail to create event loop.");
+        boat_throw(BOAT_ERROR, main_cleanup);
+    }
+
+    if( ListenOpen(socket_path_str) != BOAT_SUCCESS )
+    {
+        boat_throw(BOAT_ERROR, main_cleanup);
+    }
+
+    memset(&event, 0, sizeof(event));
+    event.events = EPOLLIN;
+    event.data.fd = g_listen_fd;
+    epoll_ctl(g_epoll_fd, EPOLL_CTL_ADD, g_listen_fd, &event);
+    event.data.fd = g_event_fd;
+    epoll_ctl(g_epoll_fd, EPOLL_CTL_ADD, g_event_fd, &event);
+
+    thread_array = BoatMalloc(thread_num * sizeof(pthread_t));
+    if( thread_array == NULL )
+    {
+        BoatLog(BOAT_LOG_CRITICAL, "Fail to allocate memory.");
+        boat_throw(BOAT_ERROR, main_cleanup);
+    }
+
+    for( started_thread_num = 0; started_thread_num < thread_num; started_thread_num++ )
+    {
+        if( pthread_create(&thread_array[started_thread_num], NULL, SignerThread, NULL) != 0 )
+        {
+            BoatLog(BOAT_LOG_CRITICAL, "Fail to start signer thread.");
+            boat_throw(BOAT_ERROR, main_cleanup);
+        }
+    }
+
+    BoatLog(BOAT_LOG_NORMAL, "boatsignd is listening on %s with %u signer threads.", socket_path_str, thread_num);
+
+    while( g_stop == 0 )
+    {
+        event_num = epoll_wait(g_epoll_fd, event_array, BOATSIGND_MAX_EVENT_NUM, -1);
+        if( event_num < 0 )
+        {
+            if( errno == EINTR )
+            {
+                continue;
+            }
+            BoatLog(BOAT_LOG_CRITICAL, "epoll_wait failed.");
+            break;
+        }
+
+        for( i = 0; i < event_num; i++ )
+        {
+            if( event_array[i].data.fd == g_listen_fd )
+            {
+                ConnAccept();
+                continue;
+            }
+
+            if( event_array[i].data.fd == g_event_fd )
+            {
+                DeliverResponses();
+                continue;
+            }
+
+            // The connection may have been closed by an earlier event of this round
+            conn_ptr = event_array[i].data.fd < g_conn_capacity ? g_conn_array[event_array[i].data.fd] : NULL;
+            if( conn_ptr == NULL )
+            {
+                continue;
+            }
+
+            if(    ((event_array[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR)) && ConnRead(conn_ptr) != BOAT_SUCCESS)
+                || ((event_array[i].events & EPOLLOUT) && ConnFlush(conn_ptr) != BOAT_SUCCESS) )
+            {
+                ConnClose(conn_ptr);
+                continue;
+            }
+
+            ConnUpdateEvents(conn_ptr);
+        }
+    }
+
+    BoatLog(BOAT_LOG_NORMAL, "boatsignd is stopping.");
+
+    boat_catch(main_cleanup)
+    {
+        result = boat_exception;
+    }
+
+    // Stop signer threads
+    pthread_mutex_lock(&g_job_queue.mutex);
+    g_job_queue.stop = BOAT_TRUE;
+    pthread_cond_broadcast(&g_job_queue.cond);
+    pthread_mutex_unlock(&g_job_queue.mutex);
+
+    for( i = 0; i < (int)started_thread_num; i++ )
+    {
+        pthread_join(thread_array[i], NULL);
+    }
+
+    while( (job_ptr = SignJobQueuePop(&g_job_queue, BOAT_FALSE)) != NULL )
+    {
+        memset(job_ptr->body_ptr, 0, job_ptr->body_len);
+        SignJobFree(job_ptr);
+    }
+
+    while( (job_ptr = SignJobQueuePop(&g_done_queue, BOAT_FALSE)) != NULL )
+    {
+        SignJobFree(job_ptr);
+    }
+
+    for( i = 0; i < g_conn_capacity; i++ )
+    {
+        if( g_conn_array[i] != NULL )
+        {
+            ConnClose(g_conn_array[i]);
+        }
+    }
+
+    if( g_conn_array != NULL )
+    {
+        BoatFree(g_conn_array);
+    }
+
+    if( thread_array != NULL )
+    {
+        BoatFree(thread_array);
+    }
+
+    if( g_listen_fd >= 0 )
+    {
+        close(g_listen_fd);
+        unlink(socket_path_str);
+    }
+
+    if( g_event_fd >= 0 )
+    {
+        close(g_event_fd);
+    }
+
+    if( g_epoll_fd >= 0 )
+    {
+        close(g_epoll_fd);
+    }
+
+    AccountsUnload();
+
+    BoatWalletDeInit();
+
+    return result;
+}
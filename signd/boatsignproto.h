@@ -0,0 +1,93 @@
+/******************************************************************************
+Copyright (C) 2018-2019 AITOS.IO
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+of the Software, and to permit persons to whom the Software is furnished to do
+so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+******************************************************************************/
+
+/*!@brief Binary request protocol of the boatsignd signing daemon
+
+@file
+boatsignproto.h defines the frames exchanged between boatsignd and its clients
+over a Unix domain socket.
+
+Every request and response is a frame:
+
+    -------------------------------------------
+    | Length | Op | Request ID | Status | Body |
+    -------------------------------------------
+
+    Length:     4 bytes length of the rest of the frame, in BigEndian
+    Op:         1 byte operation, see BoatSignOp
+    Request ID: 4 bytes ID chosen by the client and echoed in the response,
+                in BigEndian
+    Status:     1 byte status, see BoatSignStatus. Only in responses.
+    Body:       Operation specific
+
+BOATSIGN_OP_DERIVE_ADDRESS
+    Request body:  32 bytes private key
+    Response body: 64 bytes public key, 20 bytes address
+
+BOATSIGN_OP_SIGN_RAWTX
+    Request body:  20 bytes sender address, i.e. which account held by
+                   boatsignd signs the transaction, followed by:
+                   nonce, gasprice, gaslimit: each 1 byte length (0~32) and
+                   the big-endian value;
+                   20 bytes recipient;
+                   value: 1 byte length (0~32) and the big-endian value;
+                   data: 4 bytes length in BigEndian and the data.
+    Response body: RLP encoded signed transaction, ready for
+                   eth_sendRawTransaction. The chain ID and EIP-155
+                   compatibility are those saved in the sender's keystore.
+
+A client may send many requests without waiting for responses. Responses
+of one connection may come in a different order than the requests.
+*/
+
+#ifndef __BOATSIGNPROTO_H__
+#define __BOATSIGNPROTO_H__
+
+#include "wallet/boattypes.h"
+
+//! Default path of the daemon's Unix domain socket
+#define BOATSIGN_DEFAULT_SOCKET_PATH "/tmp/boatsignd.sock"
+
+//! Size of the Length, Op and Request ID fields
+#define BOATSIGN_FRAME_HEADER_SIZE 9
+
+//! Maximum value of the Length field
+#define BOATSIGN_FRAME_MAX_LEN (BOAT_REASONABLE_MAX_LEN + 256)
+
+
+//!@brief Operation of a boatsignd request
+typedef enum
+{
+    BOATSIGN_OP_DERIVE_ADDRESS = 1,     //!< Compute public key and address of a private key
+    BOATSIGN_OP_SIGN_RAWTX = 2          //!< Sign a raw transaction with an account held by the daemon
+}BoatSignOp;
+
+//!@brief Status of a boatsignd response
+typedef enum
+{
+    BOATSIGN_STATUS_OK = 0,             //!< Success, the body is valid
+    BOATSIGN_STATUS_BAD_REQUEST,        //!< Malformed request or unknown operation
+    BOATSIGN_STATUS_NO_ACCOUNT,         //!< The sender is not held by the daemon
+    BOATSIGN_STATUS_FAIL                //!< The operation failed
+}BoatSignStatus;
+
+#endif
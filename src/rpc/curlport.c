@@ -25,35 +25,1300 @@ SOFTWARE.
 @file
 curlport.c is the libcurl porting of RPC.
 
+REQUESTs are performed as transfers on an engine wrapping a curl multi handle,
+so that connections are kept alive and reused. With BOAT_CURL_HTTP_VERSION set
+to HTTP/2, REQUESTs outstanding at a time (see RpcRequestAsync()) run as
+concurrent streams multiplexed over one connection. The engine is shared by
+all threads with BOAT_CURL_SHARE_CONNECTIONS set to 1, or is per thread.
+
+Resolved node addresses are cached for BOAT_CURL_DNS_CACHE_TTL seconds in a
+curl share handle used by all engines, so that only the first REQUEST to a node
+waits for DNS. Addresses pinned by CurlPortPinAddress() never wait for DNS.
+TLS sessions are kept in the share handle as well, so that a new connection to
+an https:// node resumes the session instead of a full handshake. With
+BOAT_CURL_SSL_VERIFY, the CA bundle is parsed once into an OpenSSL X509_STORE
+that every TLS connection of all engines verifies against, so no connection
+reads the bundle again within BOAT_CURL_CA_CACHE_TTL.
+
+Any thread waiting for a RESPONSE may drive the engine. One of them at a time
+calls curl_multi_perform() and curl_multi_wait() without holding the engine
+mutex. The others wait on the engine condition until their transfers complete
+or the driver steps down.
+
 DO NOT call functions in this file directly. Instead call wrapper functions
 provided by rpcport.
 
-To use libcurl porting, RPC_USE_LIBCURL in boatoptions.h must set to 1.
-*/
+To use libcurl porting, RPC_USE_LIBCURL in boatoptions.h must set to 1.
+*/
+
+// For pthread_condattr_setclock()
+#define _DEFAULT_SOURCE
+
+#include "wallet/boattypes.h"
+
+#if RPC_USE_LIBCURL == 1
+#include "utilities/utility.h"
+#include "rpc/rpcport.h"
+#include "rpc/curlport.h"
+#include "rpc/rpcmsg.h"
+#include "curl/curl.h"
+
+#include <pthread.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#if BOAT_CURL_COMPRESS_REQUEST == 1
+#include <zlib.h>
+#endif
+#if BOAT_CURL_SSL_VERIFY == 1
+// SHA-2 contexts of OpenSSL clash with those of 3rd/ecdsa, and aren't used here
+#define SHA256_CTX CURLPORT_OPENSSL_SHA256_CTX
+#define SHA512_CTX CURLPORT_OPENSSL_SHA512_CTX
+#include <openssl/ssl.h>
+#include <openssl/x509.h>
+#undef SHA256_CTX
+#undef SHA512_CTX
+#endif
+
+//!Whether all TLS connections share one CA store, which needs SSL_CTX_set1_cert_store()
+#if BOAT_CURL_SSL_VERIFY == 1 && OPENSSL_VERSION_NUMBER >= 0x10100000L
+#define CURLPORT_SHARE_CA_STORE 1
+#else
+#define CURLPORT_SHARE_CA_STORE 0
+#endif
+
+#if BOAT_CURL_SSL_VERIFY == 1 && CURLPORT_SHARE_CA_STORE == 0 && LIBCURL_VERSION_NUM < 0x075700
+#warning "The CA bundle is read for each TLS connection, which needs OpenSSL 1.1.0 or libcurl 7.87.0 to be cached"
+#endif
+
+//!@brief Defines the buffer size to receive response from peer.
+
+
+//!The step to dynamically expand the receiving buffer.
+#define CURLPORT_RECV_BUF_SIZE_STEP 1024
+
+//!@brief A struct to maintain a dynamic length string.
+typedef struct TCurlPortStringWithLen
+{
+    CHAR *string_ptr;   //!< address of the string storage
+    UINT32 string_len;  //!< string length in byte excluding NULL terminator, equal to strlen(string_ptr)
+    UINT32 string_space;//!< size of the space <string_ptr> pointing to, including null terminator
+}CurlPortStringWithLen;
+
+//!@brief A REQUEST performed on an engine
+typedef struct TCurlPortTransfer
+{
+    CURL *curl_ctx_ptr;                 //!< Easy handle of the REQUEST
+    SINT64 id;                          //!< JSON-RPC "id" of the REQUEST, -1 if none
+    CurlPortStringWithLen response;     //!< The RESPONSE being received
+    UINT32 request_len;                 //!< Length of the REQUEST
+    UINT32 request_wire_len;            //!< Length of the REQUEST body as POSTed, after compression
+    BOATBOOL is_added;                  //!< Whether it's added to the multi handle
+    BOATBOOL is_done;                   //!< Whether it has completed
+    CURLcode curl_result;               //!< Result of the completed transfer
+    struct curl_slist *resolve_list_ptr;//!< Pinned addresses given to the transfer
+    struct TCurlPortTransfer *next_ptr;         //!< Next transfer of the engine
+    struct TCurlPortTransfer *thread_next_ptr;  //!< Next transfer sent by CurlPortSend() in the same thread
+}CurlPortTransfer;
+
+//!@brief A curl multi handle and the transfers on it
+typedef struct TCurlPortEngine
+{
+    CURLM *multi_ptr;                   //!< The multi handle
+    struct curl_slist *curl_opt_list_ptr;   //!< HTTP HEADER options of all transfers
+    struct curl_slist *curl_gzip_opt_list_ptr;  //!< HTTP HEADER options of transfers with gzip compressed REQUEST
+    BOATBOOL is_decoding;               //!< Whether libcurl could decode compressed RESPONSEs
+    pthread_mutex_t mutex;              //!< Protects the fields below and the multi handle if not driving
+    pthread_cond_t cond;                //!< Broadcast when transfers complete or the driver steps down
+    BOATBOOL is_driving;                //!< Whether a thread is driving the multi handle
+    UINT32 stopping_num;                //!< Threads waiting for the driver to step down to remove transfers
+    CurlPortTransfer *transfer_list_ptr;//!< Transfers not taken yet, in the order they are sent
+    UINT32 added_num;                   //!< Number of transfers added to the multi handle
+    int wakeup_fd[2];                   //!< Pipe to wake the driver up for new or cancelled transfers
+}CurlPortEngine;
+
+RPC_THREAD_LOCAL CurlPortStringWithLen g_curlport_response = {NULL, 0, 0}; 
+
+//!@brief Byte counts of the last REQUEST taken and of all REQUESTs taken by the thread
+RPC_THREAD_LOCAL RpcByteStats g_curlport_last_bytes;
+RPC_THREAD_LOCAL RpcByteStats g_curlport_total_bytes;
+
+//!@brief Transfers sent by CurlPortSend() and not taken by CurlPortRecv() yet
+RPC_THREAD_LOCAL CurlPortTransfer *g_curlport_sent_list_ptr = NULL;
+
+#if BOAT_CURL_SHARE_CONNECTIONS == 1
+//!@brief The engine shared by all threads
+static CurlPortEngine *g_curlport_shared_engine_ptr = NULL;
+static pthread_mutex_t g_curlport_shared_engine_mutex = PTHREAD_MUTEX_INITIALIZER;
+#endif
+
+//!@brief Share handle with the DNS and TLS session caches of all engines, and addresses pinned by CurlPortPinAddress()
+static CURLSH *g_curlport_share_ptr = NULL;
+static struct curl_slist *g_curlport_pinned_list_ptr = NULL;
+static pthread_mutex_t g_curlport_share_mutex = PTHREAD_MUTEX_INITIALIZER;
+//!@brief Lock of data in the share handle, taken by libcurl
+static pthread_mutex_t g_curlport_share_data_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+#if CURLPORT_SHARE_CA_STORE == 1
+//!@brief CA store of all TLS connections and when it's loaded, protected by g_curlport_share_mutex
+static X509_STORE *g_curlport_ca_store_ptr = NULL;
+static UINT64 g_curlport_ca_loaded_ms = 0;
+#endif
+
+//!@brief Key whose destructor frees the RPC state of a non-main thread on its exit.
+static pthread_key_t g_curlport_response_key;
+static pthread_once_t g_curlport_response_key_once = PTHREAD_ONCE_INIT;
+
+
+static void CurlPortEngineCancel(CurlPortEngine *engine_ptr, CurlPortTransfer *transfer_ptr);
+static void CurlPortEngineDestroy(CurlPortEngine *engine_ptr);
+
+
+static void CurlPortFreeTransfer(CurlPortTransfer *transfer_ptr)
+{
+    if( transfer_ptr->curl_ctx_ptr != NULL ) curl_easy_cleanup(transfer_ptr->curl_ctx_ptr);
+    if( transfer_ptr->response.string_ptr != NULL ) BoatFree(transfer_ptr->response.string_ptr);
+    curl_slist_free_all(transfer_ptr->resolve_list_ptr);
+
+    BoatFree(transfer_ptr);
+}
+
+
+static void CurlPortFreeResponse(void *response_ptr)
+{
+    CurlPortStringWithLen *mem = (CurlPortStringWithLen *)response_ptr;
+    CurlPortTransfer *transfer_ptr;
+
+    while( g_curlport_sent_list_ptr != NULL )
+    {
+        transfer_ptr = g_curlport_sent_list_ptr;
+        g_curlport_sent_list_ptr = transfer_ptr->thread_next_ptr;
+        CurlPortEngineCancel(g_rpc_ctx.curl_engine_ptr, transfer_ptr);
+    }
+
+#if BOAT_CURL_SHARE_CONNECTIONS == 0
+    if( g_rpc_ctx.curl_engine_ptr != NULL ) CurlPortEngineDestroy(g_rpc_ctx.curl_engine_ptr);
+#endif
+    g_rpc_ctx.curl_engine_ptr = NULL;
+
+    if( mem != NULL && mem->string_ptr != NULL )
+    {
+        BoatFree(mem->string_ptr);
+        mem->string_ptr = NULL;
+        mem->string_space = 0;
+        mem->string_len = 0;
+    }
+}
+
+
+static void CurlPortCreateResponseKey(void)
+{
+    pthread_key_create(&g_curlport_response_key, CurlPortFreeResponse);
+}
+
+
+/*!*****************************************************************************
+@brief Callback function to write received data from the peer to the user specified buffer.
+
+Function: CurlPortWriteMemoryCallback()
+
+    This function is a callback function as per libcurl CURLOPT_WRITEFUNCTION option.
+    libcurl will call this function (possibly) multiple times to write received
+    data from peer to the buffer specified by this function. The received data
+    are typically some RESPONSE from the HTTP server.
+
+    The receiving buffer is dynamically allocated. If the received data from
+    the peer exceeds the current buffer size, a new buffer that could hold all
+    data will be allocated and previously received data will be copied to the
+    new buffer as well as the newly received data.
+
+    
+@see https://curl.haxx.se/libcurl/c/CURLOPT_WRITEFUNCTION.html
+    
+
+@return
+    This function returns how many bytes are written into the user buffer.
+    If the returned size differs from <size>*<nmemb>, libcurl will treat it as
+    a failure.
+    
+
+@param[in] data_ptr
+    A pointer given by libcurl, pointing to the received data from peer.
+
+@param[in] size
+    For historic reasons, libcurl will always call with <size> = 1.
+
+@param[in] nmemb
+    <nmemb> is the size of the data chunk to write. It doesn't include null
+    terminator even if the data were string.\n
+    For backward compatibility, use <size> * <nmemb> to calculate the size of
+    the received data.
+
+@param[in] userdata
+    <userdata> is the value previously set by CURLOPT_WRITEDATA option.
+    Typically it's a pointer to a struct which contains information about the
+    receiving buffer.
+
+*******************************************************************************/
+size_t CurlPortWriteMemoryCallback(void *data_ptr, size_t size, size_t nmemb, void *userdata)
+{
+    size_t data_size;
+    CurlPortStringWithLen *mem;
+    UINT32 expand_size;
+    UINT32 expand_steps;
+    CHAR *expanded_str;
+    UINT32 expanded_to_space;
+    
+    mem = (CurlPortStringWithLen*)userdata;
+
+    // NOTE: For historic reasons, argument size is always 1 and nmemb is the
+    // size of the data chunk to write. And size * nmemb doesn't include null
+    // terminator even if the data were string.
+    data_size = size * nmemb;
+    
+    // If response buffer has enough space:
+    if( mem->string_space - mem->string_len > data_size ) // 1 more byte reserved for null terminator
+    {
+        memcpy(mem->string_ptr + mem->string_len, data_ptr, data_size);
+        mem->string_len += data_size;
+        mem->string_ptr[mem->string_len] = '\0';
+    }
+    else  // If response buffer has no enough space
+    {
+
+        // If malloc is supported, expand the response buffer in steps of
+        // CURLPORT_RECV_BUF_SIZE_STEP.
+        
+        expand_size = data_size - (mem->string_space - mem->string_len) + 1; // plus 1 for null terminator
+        expand_steps = (expand_size - 1) / CURLPORT_RECV_BUF_SIZE_STEP + 1;
+        expanded_to_space = expand_steps * CURLPORT_RECV_BUF_SIZE_STEP + mem->string_space;
+    
+        expanded_str = BoatMalloc(expanded_to_space);
+
+        if( expanded_str != NULL )
+        {
+            memcpy(expanded_str, mem->string_ptr, mem->string_len);
+            memcpy(expanded_str + mem->string_len, data_ptr, data_size);
+            BoatFree(mem->string_ptr);
+            mem->string_ptr = expanded_str;
+            mem->string_space = expanded_to_space;
+            mem->string_len += data_size;
+            mem->string_ptr[mem->string_len] = '\0';
+        }
+
+    }
+
+    return data_size;
+
+}
+
+
+/*!*****************************************************************************
+@brief Create the list of HTTP HEADER options of REQUESTs
+
+Function: CurlPortNewHeaderList()
+
+@return
+    This function returns the list, or NULL if it fails.
+
+@param[in] is_gzip
+    Whether the REQUEST body is gzip compressed.
+*******************************************************************************/
+static struct curl_slist *CurlPortNewHeaderList(BOATBOOL is_gzip)
+{
+    static const CHAR *header_str[] = {
+        "Content-Type:application/json;charset=UTF-8",
+        "Accept:application/json, text/javascript, */*;q=0.01",
+        "Accept-Language:zh-CN,zh;q=0.8",
+        "Content-Encoding:gzip"
+    };
+    struct curl_slist *curl_opt_list_ptr = NULL;
+    struct curl_slist *appended_list_ptr;
+    UINT32 header_num;
+    UINT32 i;
+
+    header_num = sizeof(header_str) / sizeof(header_str[0]) - (is_gzip ? 0 : 1);
+
+    for( i = 0; i < header_num; i++ )
+    {
+        appended_list_ptr = curl_slist_append(curl_opt_list_ptr, header_str[i]);
+        if( appended_list_ptr == NULL )
+        {
+            curl_slist_free_all(curl_opt_list_ptr);
+            return NULL;
+        }
+        curl_opt_list_ptr = appended_list_ptr;
+    }
+
+    return curl_opt_list_ptr;
+}
+
+
+#if BOAT_CURL_COMPRESS_REQUEST == 1
+/*!*****************************************************************************
+@brief Compress a REQUEST body in gzip format
+
+Function: CurlPortGzip()
+
+@return
+    This function returns the compressed body allocated by BoatMalloc(), or
+    NULL if it fails or the compressed body isn't smaller.
+
+@param[in] request_str
+    The REQUEST body.
+
+@param[in] request_len
+    The length of <request_str>.
+
+@param[out] gzip_len_ptr
+    The length of the compressed body.
+*******************************************************************************/
+static UINT8 *CurlPortGzip(const CHAR *request_str, UINT32 request_len, BOAT_OUT UINT32 *gzip_len_ptr)
+{
+    z_stream stream;
+    UINT8 *gzip_ptr;
+    int z_result;
+
+    memset(&stream, 0, sizeof(stream));
+
+    // windowBits 15 + 16 for gzip instead of zlib wrapper
+    if( deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK )
+    {
+        return NULL;
+    }
+
+    // Stop as soon as the body doesn't get smaller
+    gzip_ptr = BoatMalloc(request_len);
+    if( gzip_ptr != NULL )
+    {
+        stream.next_in = (Bytef *)request_str;
+        stream.avail_in = request_len;
+        stream.next_out = gzip_ptr;
+        stream.avail_out = request_len;
+
+        z_result = deflate(&stream, Z_FINISH);
+        if( z_result == Z_STREAM_END )
+        {
+            *gzip_len_ptr = stream.total_out;
+        }
+        else
+        {
+            BoatFree(gzip_ptr);
+            gzip_ptr = NULL;
+        }
+    }
+
+    deflateEnd(&stream);
+
+    return gzip_ptr;
+}
+#endif
+
+
+static void CurlPortShareLock(CURL *curl_ctx_ptr, curl_lock_data data, curl_lock_access access, void *user_ptr)
+{
+    pthread_mutex_lock(&g_curlport_share_data_mutex);
+}
+
+
+static void CurlPortShareUnlock(CURL *curl_ctx_ptr, curl_lock_data data, void *user_ptr)
+{
+    pthread_mutex_unlock(&g_curlport_share_data_mutex);
+}
+
+
+/*!*****************************************************************************
+@brief Get the share handle of all engines
+
+Function: CurlPortGetShareLocked()
+
+    The share handle is created on the first call. Its DNS and TLS session
+    caches outlive transfers, engines and threads, until CurlPortDeinit().
+
+@return
+    This function returns the share handle, or NULL if it fails to create one.
+    Transfers then use the caches of their engine.
+
+@param This function doesn't take any argument.
+*******************************************************************************/
+static CURLSH *CurlPortGetShareLocked(void)
+{
+    if( g_curlport_share_ptr != NULL ) return g_curlport_share_ptr;
+
+    g_curlport_share_ptr = curl_share_init();
+    if( g_curlport_share_ptr == NULL )
+    {
+        BoatLog(BOAT_LOG_NORMAL, "curl_share_init() fails.");
+        return NULL;
+    }
+
+    curl_share_setopt(g_curlport_share_ptr, CURLSHOPT_LOCKFUNC, CurlPortShareLock);
+    curl_share_setopt(g_curlport_share_ptr, CURLSHOPT_UNLOCKFUNC, CurlPortShareUnlock);
+    curl_share_setopt(g_curlport_share_ptr, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+    curl_share_setopt(g_curlport_share_ptr, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+
+    return g_curlport_share_ptr;
+}
+
+
+#if CURLPORT_SHARE_CA_STORE == 1
+/*!*****************************************************************************
+@brief Get the CA store of all TLS connections
+
+Function: CurlPortGetCaStoreLocked()
+
+    The store is loaded on the first call from BOAT_CURL_CA_BUNDLE, or from the
+    default CA locations of OpenSSL if it's "", and loaded again once it's
+    older than BOAT_CURL_CA_CACHE_TTL seconds. If loading again fails, the old
+    store is kept. Connections keep a reference to the store they're given.
+
+@return
+    This function returns the CA store, or NULL if it fails to load one.
+
+@param This function doesn't take any argument.
+*******************************************************************************/
+static X509_STORE *CurlPortGetCaStoreLocked(void)
+{
+    X509_STORE *store_ptr;
+    UINT64 now_ms = BoatGetTimeMs();
+    int ssl_ret = 0;
+
+    if(    g_curlport_ca_store_ptr != NULL
+        && (   BOAT_CURL_CA_CACHE_TTL < 0
+            || now_ms - g_curlport_ca_loaded_ms < (UINT64)BOAT_CURL_CA_CACHE_TTL * 1000) )
+    {
+        return g_curlport_ca_store_ptr;
+    }
+
+    store_ptr = X509_STORE_new();
+    if( store_ptr != NULL )
+    {
+        if( BOAT_CURL_CA_BUNDLE[0] != '\0' )
+        {
+            ssl_ret = X509_STORE_load_locations(store_ptr, BOAT_CURL_CA_BUNDLE, NULL);
+        }
+        else
+        {
+            ssl_ret = X509_STORE_set_default_paths(store_ptr);
+        }
+    }
+
+    if( ssl_ret != 1 )
+    {
+        BoatLog(BOAT_LOG_NORMAL, "Fail to load CA bundle %s.",
+                BOAT_CURL_CA_BUNDLE[0] != '\0' ? BOAT_CURL_CA_BUNDLE : "of OpenSSL");
+        X509_STORE_free(store_ptr);
+        return g_curlport_ca_store_ptr;
+    }
+
+    X509_STORE_free(g_curlport_ca_store_ptr);
+    g_curlport_ca_store_ptr = store_ptr;
+    g_curlport_ca_loaded_ms = now_ms;
+
+    return g_curlport_ca_store_ptr;
+}
+
+
+/*!*****************************************************************************
+@brief Give a TLS connection the shared CA store
+
+Function: CurlPortSslCtxCallback()
+
+    This function is a callback function as per libcurl CURLOPT_SSL_CTX_FUNCTION
+    option. It's called for each new TLS connection, which then verifies the
+    node against the CA store of CurlPortGetCaStoreLocked() instead of
+    reading the CA bundle itself.
+
+@see https://curl.haxx.se/libcurl/c/CURLOPT_SSL_CTX_FUNCTION.html
+
+@return
+    This function returns CURLE_OK, or CURLE_SSL_CACERT_BADFILE if no CA store
+    could be loaded.
+
+@param[in] curl_ctx_ptr
+    The easy handle of the transfer.
+
+@param[in] ssl_ctx_ptr
+    The OpenSSL SSL_CTX of the connection.
+
+@param[in] userdata_ptr
+    Not used.
+*******************************************************************************/
+static CURLcode CurlPortSslCtxCallback(CURL *curl_ctx_ptr, void *ssl_ctx_ptr, void *userdata_ptr)
+{
+    X509_STORE *store_ptr;
+
+    (void)curl_ctx_ptr;
+    (void)userdata_ptr;
+
+    pthread_mutex_lock(&g_curlport_share_mutex);
+    store_ptr = CurlPortGetCaStoreLocked();
+    if( store_ptr != NULL )
+    {
+        SSL_CTX_set1_cert_store((SSL_CTX *)ssl_ctx_ptr, store_ptr);
+    }
+    pthread_mutex_unlock(&g_curlport_share_mutex);
+
+    return store_ptr != NULL ? CURLE_OK : CURLE_SSL_CACERT_BADFILE;
+}
+#endif
+
+
+/*!*****************************************************************************
+@brief Let a transfer use the shared DNS and TLS session caches and pinned addresses
+
+Function: CurlPortSetShare()
+
+@return
+    This function returns BOAT_SUCCESS, or BOAT_ERROR_OUT_OF_MEMORY if it fails
+    to copy the pinned addresses.
+
+@param[in] transfer_ptr
+    The transfer, not started yet.
+*******************************************************************************/
+static BOAT_RESULT CurlPortSetShare(CurlPortTransfer *transfer_ptr)
+{
+    struct curl_slist *pinned_ptr;
+    struct curl_slist *list_ptr;
+    CURLSH *share_ptr;
+    BOAT_RESULT result = BOAT_SUCCESS;
+
+    pthread_mutex_lock(&g_curlport_share_mutex);
+
+    share_ptr = CurlPortGetShareLocked();
+    if( share_ptr != NULL )
+    {
+        curl_easy_setopt(transfer_ptr->curl_ctx_ptr, CURLOPT_SHARE, share_ptr);
+    }
+
+    // libcurl reads the list when the transfer starts, so each transfer has its own copy
+    for( pinned_ptr = g_curlport_pinned_list_ptr; pinned_ptr != NULL; pinned_ptr = pinned_ptr->next )
+    {
+        list_ptr = curl_slist_append(transfer_ptr->resolve_list_ptr, pinned_ptr->data);
+        if( list_ptr == NULL )
+        {
+            result = BOAT_ERROR_OUT_OF_MEMORY;
+            break;
+        }
+        transfer_ptr->resolve_list_ptr = list_ptr;
+    }
+
+    pthread_mutex_unlock(&g_curlport_share_mutex);
+
+    if( transfer_ptr->resolve_list_ptr != NULL )
+    {
+        curl_easy_setopt(transfer_ptr->curl_ctx_ptr, CURLOPT_RESOLVE, transfer_ptr->resolve_list_ptr);
+    }
+
+    // -1 to cache forever, 0 to resolve each time a connection is opened
+    curl_easy_setopt(transfer_ptr->curl_ctx_ptr, CURLOPT_DNS_CACHE_TIMEOUT, (long)BOAT_CURL_DNS_CACHE_TTL);
+
+    return result;
+}
+
+
+/*!*****************************************************************************
+@brief Create an engine
+
+Function: CurlPortEngineCreate()
+
+@return
+    This function returns the engine if successful, or NULL.
+
+@param This function doesn't take any argument.
+*******************************************************************************/
+static CurlPortEngine *CurlPortEngineCreate(void)
+{
+    CurlPortEngine *engine_ptr;
+    pthread_condattr_t cond_attr;
+
+    engine_ptr = BoatMalloc(sizeof(CurlPortEngine));
+    if( engine_ptr == NULL ) return NULL;
+
+    memset(engine_ptr, 0, sizeof(CurlPortEngine));
+
+    engine_ptr->multi_ptr = curl_multi_init();
+    if( engine_ptr->multi_ptr == NULL )
+    {
+        BoatLog(BOAT_LOG_CRITICAL, "curl_multi_init() fails.");
+        BoatFree(engine_ptr);
+        return NULL;
+    }
+
+#if BOAT_CURL_HTTP_VERSION != 0
+    // Run concurrent transfers to the same node as streams of one connection
+    curl_multi_setopt(engine_ptr->multi_ptr, CURLMOPT_PIPELINING, CURLPIPE_MULTIPLEX);
+#endif
+
+    engine_ptr->curl_opt_list_ptr = CurlPortNewHeaderList(BOAT_FALSE);
+#if BOAT_CURL_COMPRESS_REQUEST == 1
+    engine_ptr->curl_gzip_opt_list_ptr = CurlPortNewHeaderList(BOAT_TRUE);
+#endif
+
+    if( engine_ptr->curl_opt_list_ptr == NULL
+#if BOAT_CURL_COMPRESS_REQUEST == 1
+       || engine_ptr->curl_gzip_opt_list_ptr == NULL
+#endif
+       || pipe(engine_ptr->wakeup_fd) != 0 )
+    {
+        BoatLog(BOAT_LOG_CRITICAL, "Fail to create curl engine.");
+        curl_slist_free_all(engine_ptr->curl_opt_list_ptr);
+        curl_slist_free_all(engine_ptr->curl_gzip_opt_list_ptr);
+        curl_multi_cleanup(engine_ptr->multi_ptr);
+        BoatFree(engine_ptr);
+        return NULL;
+    }
+
+#if BOAT_CURL_ACCEPT_ENCODING == 1
+    // libcurl without zlib can't decode gzip or deflate
+    engine_ptr->is_decoding = (curl_version_info(CURLVERSION_NOW)->features & CURL_VERSION_LIBZ) != 0;
+    if( !engine_ptr->is_decoding )
+    {
+        BoatLog(BOAT_LOG_NORMAL, "libcurl doesn't support compressed RESPONSE.");
+    }
+#endif
+
+    fcntl(engine_ptr->wakeup_fd[0], F_SETFL, fcntl(engine_ptr->wakeup_fd[0], F_GETFL) | O_NONBLOCK);
+    fcntl(engine_ptr->wakeup_fd[1], F_SETFL, fcntl(engine_ptr->wakeup_fd[1], F_GETFL) | O_NONBLOCK);
+
+    // Deadlines are given by BoatGetTimeMs()
+    pthread_mutex_init(&engine_ptr->mutex, NULL);
+    pthread_condattr_init(&cond_attr);
+    pthread_condattr_setclock(&cond_attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&engine_ptr->cond, &cond_attr);
+    pthread_condattr_destroy(&cond_attr);
+
+    return engine_ptr;
+}
+
+
+/*!*****************************************************************************
+@brief Destroy an engine
+
+Function: CurlPortEngineDestroy()
+
+    Transfers not taken yet are aborted. No thread may be using the engine.
+
+@return This function doesn't return any value.
+
+@param[in] engine_ptr
+    The engine.
+*******************************************************************************/
+static void CurlPortEngineDestroy(CurlPortEngine *engine_ptr)
+{
+    CurlPortTransfer *transfer_ptr;
+
+    while( engine_ptr->transfer_list_ptr != NULL )
+    {
+        transfer_ptr = engine_ptr->transfer_list_ptr;
+        engine_ptr->transfer_list_ptr = transfer_ptr->next_ptr;
+
+        if( transfer_ptr->is_added ) curl_multi_remove_handle(engine_ptr->multi_ptr, transfer_ptr->curl_ctx_ptr);
+        CurlPortFreeTransfer(transfer_ptr);
+    }
+
+    curl_multi_cleanup(engine_ptr->multi_ptr);
+    curl_slist_free_all(engine_ptr->curl_opt_list_ptr);
+    curl_slist_free_all(engine_ptr->curl_gzip_opt_list_ptr);
+    close(engine_ptr->wakeup_fd[0]);
+    close(engine_ptr->wakeup_fd[1]);
+    pthread_mutex_destroy(&engine_ptr->mutex);
+    pthread_cond_destroy(&engine_ptr->cond);
+
+    BoatFree(engine_ptr);
+}
+
+
+/*!*****************************************************************************
+@brief Get the engine of the calling thread
+
+Function: CurlPortGetEngine()
+
+    The engine is created on the first call of the process (if shared) or of
+    the thread. A non-main thread also allocates its receiving buffer, which is
+    freed with its other RPC state when the thread exits.
+
+@return
+    This function returns the engine, or NULL if it fails to create one.
+
+@param This function doesn't take any argument.
+*******************************************************************************/
+static CurlPortEngine *CurlPortGetEngine(void)
+{
+    if( g_curlport_response.string_ptr == NULL )
+    {
+        g_curlport_response.string_ptr = BoatMalloc(CURLPORT_RECV_BUF_SIZE_STEP);
+        if( g_curlport_response.string_ptr == NULL )
+        {
+            BoatLog(BOAT_LOG_CRITICAL, "Fail to allocate Curl RESPONSE buffer.");
+            return NULL;
+        }
+        g_curlport_response.string_ptr[0] = '\0';
+        g_curlport_response.string_len = 0;
+        g_curlport_response.string_space = CURLPORT_RECV_BUF_SIZE_STEP;
+
+        pthread_once(&g_curlport_response_key_once, CurlPortCreateResponseKey);
+        pthread_setspecific(g_curlport_response_key, &g_curlport_response);
+    }
+
+    if( g_rpc_ctx.curl_engine_ptr == NULL )
+    {
+#if BOAT_CURL_SHARE_CONNECTIONS == 1
+        pthread_mutex_lock(&g_curlport_shared_engine_mutex);
+        if( g_curlport_shared_engine_ptr == NULL )
+        {
+            g_curlport_shared_engine_ptr = CurlPortEngineCreate();
+        }
+        g_rpc_ctx.curl_engine_ptr = g_curlport_shared_engine_ptr;
+        pthread_mutex_unlock(&g_curlport_shared_engine_mutex);
+#else
+        g_rpc_ctx.curl_engine_ptr = CurlPortEngineCreate();
+#endif
+    }
+
+    return g_rpc_ctx.curl_engine_ptr;
+}
+
+
+static void CurlPortEngineWakeup(CurlPortEngine *engine_ptr)
+{
+    UINT8 wakeup = 0;
+
+    // A full pipe already wakes the driver up
+    if( write(engine_ptr->wakeup_fd[1], &wakeup, 1) < 0 ) return;
+}
+
+
+/*!*****************************************************************************
+@brief Drive an engine for one step
+
+Function: CurlPortEngineDriveLocked()
+
+    This function adds transfers not yet added to the multi handle up to
+    BOAT_CURL_MAX_STREAMS, performs them until something happens on their
+    connections or <deadline_ms> passes, and marks completed transfers.
+
+    The engine mutex must be held and no thread may be driving. It's released
+    while waiting.
+
+@return This function doesn't return any value.
+
+@param[in] engine_ptr
+    The engine.
+
+@param[in] deadline_ms
+    The deadline as per BoatGetTimeMs().
+*******************************************************************************/
+static void CurlPortEngineDriveLocked(CurlPortEngine *engine_ptr, UINT64 deadline_ms)
+{
+    CurlPortTransfer *transfer_ptr;
+    struct curl_waitfd wakeup_waitfd;
+    CURLMsg *curl_msg_ptr;
+    UINT8 wakeup[16];
+    UINT64 now_ms;
+    int running_num;
+    int msg_num;
+
+    engine_ptr->is_driving = BOAT_TRUE;
+
+    for( transfer_ptr = engine_ptr->transfer_list_ptr;
+         transfer_ptr != NULL && engine_ptr->added_num < BOAT_CURL_MAX_STREAMS;
+         transfer_ptr = transfer_ptr->next_ptr )
+    {
+        if( transfer_ptr->is_added || transfer_ptr->is_done ) continue;
+
+        if( curl_multi_add_handle(engine_ptr->multi_ptr, transfer_ptr->curl_ctx_ptr) == CURLM_OK )
+        {
+            transfer_ptr->is_added = BOAT_TRUE;
+            engine_ptr->added_num++;
+        }
+        else
+        {
+            transfer_ptr->curl_result = CURLE_FAILED_INIT;
+            transfer_ptr->is_done = BOAT_TRUE;
+        }
+    }
+
+    pthread_mutex_unlock(&engine_ptr->mutex);
+
+    curl_multi_perform(engine_ptr->multi_ptr, &running_num);
+
+    now_ms = BoatGetTimeMs();
+    if( running_num > 0 && now_ms < deadline_ms )
+    {
+        wakeup_waitfd.fd = engine_ptr->wakeup_fd[0];
+        wakeup_waitfd.events = CURL_WAIT_POLLIN;
+        wakeup_waitfd.revents = 0;
+
+        curl_multi_wait(engine_ptr->multi_ptr, &wakeup_waitfd, 1, (int)(deadline_ms - now_ms), NULL);
+        while( read(engine_ptr->wakeup_fd[0], wakeup, sizeof(wakeup)) > 0 );
+
+        curl_multi_perform(engine_ptr->multi_ptr, &running_num);
+    }
+
+    pthread_mutex_lock(&engine_ptr->mutex);
+
+    while( (curl_msg_ptr = curl_multi_info_read(engine_ptr->multi_ptr, &msg_num)) != NULL )
+    {
+        if( curl_msg_ptr->msg != CURLMSG_DONE ) continue;
+
+        curl_easy_getinfo(curl_msg_ptr->easy_handle, CURLINFO_PRIVATE, (char **)&transfer_ptr);
+        transfer_ptr->curl_result = curl_msg_ptr->data.result;
+
+        curl_multi_remove_handle(engine_ptr->multi_ptr, transfer_ptr->curl_ctx_ptr);
+        transfer_ptr->is_added = BOAT_FALSE;
+        transfer_ptr->is_done = BOAT_TRUE;
+        engine_ptr->added_num--;
+    }
+
+    engine_ptr->is_driving = BOAT_FALSE;
+    pthread_cond_broadcast(&engine_ptr->cond);
+}
+
+
+/*!*****************************************************************************
+@brief Remove a transfer from an engine
+
+Function: CurlPortEngineUnlinkLocked()
+
+    A transfer not completed yet is still on the multi handle. It's removed
+    once the driving thread steps down, while no other thread starts driving.
+
+    The engine mutex must be held. It's released while waiting.
+
+@return This function doesn't return any value.
+
+@param[in] engine_ptr
+    The engine.
+
+@param[in] transfer_ptr
+    The transfer to remove. It's not freed.
+*******************************************************************************/
+static void CurlPortEngineUnlinkLocked(CurlPortEngine *engine_ptr, CurlPortTransfer *transfer_ptr)
+{
+    CurlPortTransfer **link_pptr;
+
+    if( transfer_ptr->is_added )
+    {
+        engine_ptr->stopping_num++;
+        while( engine_ptr->is_driving )
+        {
+            CurlPortEngineWakeup(engine_ptr);
+            pthread_cond_wait(&engine_ptr->cond, &engine_ptr->mutex);
+        }
+        engine_ptr->stopping_num--;
+
+        // It may have completed meanwhile
+        if( transfer_ptr->is_added )
+        {
+            curl_multi_remove_handle(engine_ptr->multi_ptr, transfer_ptr->curl_ctx_ptr);
+            transfer_ptr->is_added = BOAT_FALSE;
+            engine_ptr->added_num--;
+        }
+
+        pthread_cond_broadcast(&engine_ptr->cond);
+    }
+
+    for( link_pptr = &engine_ptr->transfer_list_ptr; *link_pptr != NULL; link_pptr = &(*link_pptr)->next_ptr )
+    {
+        if( *link_pptr == transfer_ptr )
+        {
+            *link_pptr = transfer_ptr->next_ptr;
+            break;
+        }
+    }
+}
+
+
+/*!*****************************************************************************
+@brief Give up and free a transfer
+
+Function: CurlPortEngineCancel()
+
+@return This function doesn't return any value.
+
+@param[in] engine_ptr
+    The engine of the transfer.
+
+@param[in] transfer_ptr
+    The transfer.
+*******************************************************************************/
+static void CurlPortEngineCancel(CurlPortEngine *engine_ptr, CurlPortTransfer *transfer_ptr)
+{
+    pthread_mutex_lock(&engine_ptr->mutex);
+
+    CurlPortEngineUnlinkLocked(engine_ptr, transfer_ptr);
+
+    pthread_mutex_unlock(&engine_ptr->mutex);
+
+    CurlPortFreeTransfer(transfer_ptr);
+}
+
+
+/*!*****************************************************************************
+@brief Create a transfer of a REQUEST and start it
+
+Function: CurlPortEngineSend()
+
+    This function creates an easy handle to POST <request_str> and adds it to
+    the engine. If no thread is driving the engine, it's driven for one step
+    without waiting, so that the REQUEST goes out at once.
+
+@return
+    This function returns the transfer, or NULL if it fails.
+
+@param[in] engine_ptr
+    The engine.
+
+@param[in] request_str
+    The REQUEST to POST. It's copied.
+
+@param[in] request_len
+    The length of <request_str>.
+*******************************************************************************/
+static CurlPortTransfer *CurlPortEngineSend(CurlPortEngine *engine_ptr, const CHAR *request_str, UINT32 request_len)
+{
+    CurlPortTransfer *transfer_ptr;
+    CurlPortTransfer **link_pptr;
+    CURL *curl_ctx_ptr;
+    CURLcode curl_result;
+#if BOAT_CURL_COMPRESS_REQUEST == 1
+    UINT8 *gzip_ptr = NULL;
+    UINT32 gzip_len = 0;
+#endif
+
+    transfer_ptr = BoatMalloc(sizeof(CurlPortTransfer));
+    if( transfer_ptr == NULL ) return NULL;
+
+    memset(transfer_ptr, 0, sizeof(CurlPortTransfer));
+    RpcMsgScan(request_str, request_len, &transfer_ptr->id);
+
+    transfer_ptr->response.string_ptr = BoatMalloc(CURLPORT_RECV_BUF_SIZE_STEP);
+    curl_ctx_ptr = curl_easy_init();
+    transfer_ptr->curl_ctx_ptr = curl_ctx_ptr;
+
+    if( transfer_ptr->response.string_ptr == NULL || curl_ctx_ptr == NULL )
+    {
+        BoatLog(BOAT_LOG_CRITICAL, "curl_easy_init() fails.");
+        CurlPortFreeTransfer(transfer_ptr);
+        return NULL;
+    }
+    transfer_ptr->response.string_ptr[0] = '\0';
+    transfer_ptr->response.string_space = CURLPORT_RECV_BUF_SIZE_STEP;
+
+    // Set RPC URL in format "<protocol>://<target name or IP>:<port>". e.g. "http://192.168.56.1:7545"
+    curl_result = curl_easy_setopt(curl_ctx_ptr, CURLOPT_URL, g_rpc_option.node_url_str);
+    if( curl_result != CURLE_OK )
+    {
+        BoatLog(BOAT_LOG_NORMAL, "Unknown URL: %s", g_rpc_option.node_url_str);
+        CurlPortFreeTransfer(transfer_ptr);
+        return NULL;
+    }
+
+    // Configure all protocols to be supported
+    curl_easy_setopt(curl_ctx_ptr, CURLOPT_PROTOCOLS, CURLPROTO_ALL);
+                   
+    // Configure SSL Certification Verification
+    // See: https://curl.haxx.se/libcurl/c/CURLOPT_SSL_VERIFYPEER.html
+#if BOAT_CURL_SSL_VERIFY == 1
+    curl_easy_setopt(curl_ctx_ptr, CURLOPT_SSL_VERIFYPEER, 1L);
+    curl_easy_setopt(curl_ctx_ptr, CURLOPT_SSL_VERIFYHOST, 2L);
+
+#if CURLPORT_SHARE_CA_STORE == 1
+    // The shared CA store replaces the bundle libcurl would read per connection.
+    // A TLS backend other than OpenSSL refuses the callback and reads the bundle.
+    if( curl_easy_setopt(curl_ctx_ptr, CURLOPT_SSL_CTX_FUNCTION, CurlPortSslCtxCallback) == CURLE_OK )
+    {
+        curl_easy_setopt(curl_ctx_ptr, CURLOPT_CAINFO, NULL);
+        curl_easy_setopt(curl_ctx_ptr, CURLOPT_CAPATH, NULL);
+    }
+    else
+#endif
+    {
+        if( BOAT_CURL_CA_BUNDLE[0] != '\0' )
+        {
+            curl_easy_setopt(curl_ctx_ptr, CURLOPT_CAINFO, BOAT_CURL_CA_BUNDLE);
+        }
+#if LIBCURL_VERSION_NUM >= 0x075700
+        // The parsed CA bundle is kept by the multi handle of the engine
+        curl_easy_setopt(curl_ctx_ptr, CURLOPT_CA_CACHE_TIMEOUT, (long)BOAT_CURL_CA_CACHE_TTL);
+#endif
+    }
+#else
+    curl_easy_setopt(curl_ctx_ptr, CURLOPT_SSL_VERIFYPEER, 0L);
+    curl_easy_setopt(curl_ctx_ptr, CURLOPT_SSL_VERIFYHOST, 0L);
+#endif
+
+    // Verbose Debug Info.
+    // curl_easy_setopt(curl_ctx_ptr, CURLOPT_VERBOSE, 1);
+
+
+    // Set HTTP Type: POST
+    curl_easy_setopt(curl_ctx_ptr, CURLOPT_POST, 1L);
+
+    // Set redirection: No
+    curl_easy_setopt(curl_ctx_ptr, CURLOPT_FOLLOWLOCATION, 0);
+
+#if BOAT_CURL_HTTP_VERSION == 1
+    // Negotiate HTTP/2 over TLS, falling back to HTTP/1.1
+    curl_result = curl_easy_setopt(curl_ctx_ptr, CURLOPT_HTTP_VERSION, (long)CURL_HTTP_VERSION_2TLS);
+#elif BOAT_CURL_HTTP_VERSION == 2
+    // HTTP/2 without HTTP/1.1 Upgrade, also for plain http://
+    curl_result = curl_easy_setopt(curl_ctx_ptr, CURLOPT_HTTP_VERSION, (long)CURL_HTTP_VERSION_2_PRIOR_KNOWLEDGE);
+#endif
+#if BOAT_CURL_HTTP_VERSION != 0
+    if( curl_result != CURLE_OK )
+    {
+        BoatLog(BOAT_LOG_VERBOSE, "libcurl doesn't support HTTP/2, use HTTP/1.1.");
+    }
+
+    // Wait for the connection being opened to multiplex on it rather than open another
+    curl_easy_setopt(curl_ctx_ptr, CURLOPT_PIPEWAIT, 1L);
+#endif
+
+    // Set entire curl timeout in millisecond, as given by rpcintf. This time includes DNS resloving.
+    curl_easy_setopt(curl_ctx_ptr, CURLOPT_TIMEOUT_MS, (long)g_rpc_ctx.timeout_ms);
+
+    // Set Connection timeout in millisecond
+    curl_easy_setopt(curl_ctx_ptr, CURLOPT_CONNECTTIMEOUT_MS,
+                     (long)(g_rpc_ctx.timeout_ms < BOAT_RPC_CONNECT_TIMEOUT_MS ? g_rpc_ctx.timeout_ms : BOAT_RPC_CONNECT_TIMEOUT_MS));
+
+    // Resolve with the DNS cache of all engines
+    if( CurlPortSetShare(transfer_ptr) != BOAT_SUCCESS )
+    {
+        BoatLog(BOAT_LOG_CRITICAL, "Fail to set pinned addresses.");
+        CurlPortFreeTransfer(transfer_ptr);
+        return NULL;
+    }
+
+    // Set HTTP HEADER Options
+    curl_easy_setopt(curl_ctx_ptr, CURLOPT_HTTPHEADER, engine_ptr->curl_opt_list_ptr);
+
+    // Set callback and receive buffer for RESPONSE
+    curl_easy_setopt(curl_ctx_ptr, CURLOPT_WRITEDATA, &transfer_ptr->response);
+    curl_easy_setopt(curl_ctx_ptr, CURLOPT_WRITEFUNCTION, CurlPortWriteMemoryCallback);
+    curl_easy_setopt(curl_ctx_ptr, CURLOPT_PRIVATE, (char *)transfer_ptr);
+
+#if BOAT_CURL_ACCEPT_ENCODING == 1
+    // Ask for gzip or deflate compressed RESPONSE, which libcurl decodes
+    if( engine_ptr->is_decoding )
+    {
+        curl_easy_setopt(curl_ctx_ptr, CURLOPT_ACCEPT_ENCODING, "gzip, deflate");
+    }
+#endif
+
+    transfer_ptr->request_len = request_len;
+    transfer_ptr->request_wire_len = request_len;
+
+#if BOAT_CURL_COMPRESS_REQUEST == 1
+    if( request_len >= BOAT_CURL_COMPRESS_MIN_SIZE )
+    {
+        gzip_ptr = CurlPortGzip(request_str, request_len, &gzip_len);
+    }
+
+    if( gzip_ptr != NULL )
+    {
+        curl_easy_setopt(curl_ctx_ptr, CURLOPT_HTTPHEADER, engine_ptr->curl_gzip_opt_list_ptr);
+        transfer_ptr->request_wire_len = gzip_len;
+    }
+#endif
+
+    // Set content to POST. It's copied since the transfer outlives the caller's buffer.
+    curl_easy_setopt(curl_ctx_ptr, CURLOPT_POSTFIELDSIZE, (long)transfer_ptr->request_wire_len);
+#if BOAT_CURL_COMPRESS_REQUEST == 1
+    if( gzip_ptr != NULL )
+    {
+        curl_result = curl_easy_setopt(curl_ctx_ptr, CURLOPT_COPYPOSTFIELDS, gzip_ptr);
+        BoatFree(gzip_ptr);
+    }
+    else
+#endif
+    {
+        curl_result = curl_easy_setopt(curl_ctx_ptr, CURLOPT_COPYPOSTFIELDS, request_str);
+    }
+    if( curl_result != CURLE_OK )
+    {
+        CurlPortFreeTransfer(transfer_ptr);
+        return NULL;
+    }
+
+    BoatLog(BOAT_LOG_VERBOSE, "Post: %s", request_str);
+
+    pthread_mutex_lock(&engine_ptr->mutex);
+
+    for( link_pptr = &engine_ptr->transfer_list_ptr; *link_pptr != NULL; link_pptr = &(*link_pptr)->next_ptr );
+    *link_pptr = transfer_ptr;
+
+    if( engine_ptr->is_driving )
+    {
+        CurlPortEngineWakeup(engine_ptr);
+    }
+    else if( engine_ptr->stopping_num == 0 )
+    {
+        CurlPortEngineDriveLocked(engine_ptr, 0);
+    }
+
+    pthread_mutex_unlock(&engine_ptr->mutex);
+
+    return transfer_ptr;
+}
+
+
+/*!*****************************************************************************
+@brief Count bytes of a completed transfer into the thread's byte statistics
+
+Function: CurlPortCountBytes()
+
+@return This function doesn't return any value.
+
+@param[in] transfer_ptr
+    The transfer.
+*******************************************************************************/
+static void CurlPortCountBytes(CurlPortTransfer *transfer_ptr)
+{
+    curl_off_t download_size = 0;
+
+    // Body bytes as received, before content decoding
+    if( curl_easy_getinfo(transfer_ptr->curl_ctx_ptr, CURLINFO_SIZE_DOWNLOAD_T, &download_size) != CURLE_OK )
+    {
+        download_size = transfer_ptr->response.string_len;
+    }
+
+    g_curlport_last_bytes.request_bytes = transfer_ptr->request_len;
+    g_curlport_last_bytes.request_wire_bytes = transfer_ptr->request_wire_len;
+    g_curlport_last_bytes.response_bytes = transfer_ptr->response.string_len;
+    g_curlport_last_bytes.response_wire_bytes = (UINT64)download_size;
+
+    g_curlport_total_bytes.request_bytes += g_curlport_last_bytes.request_bytes;
+    g_curlport_total_bytes.request_wire_bytes += g_curlport_last_bytes.request_wire_bytes;
+    g_curlport_total_bytes.response_bytes += g_curlport_last_bytes.response_bytes;
+    g_curlport_total_bytes.response_wire_bytes += g_curlport_last_bytes.response_wire_bytes;
+}
+
+
+/*!*****************************************************************************
+@brief Wait for a transfer to complete and take it from the engine
+
+Function: CurlPortEngineWait()
+
+    This function drives the engine if no other thread does, or waits for the
+    driving thread to complete the transfer. The transfer is taken from the
+    engine whether it completes or not.
+
+@return
+    This function returns BOAT_SUCCESS if the node responds with HTTP status
+    200 or 201, BOAT_ERROR_RPC_TIMEOUT if the transfer doesn't complete by
+    <deadline_ms> or times out, BOAT_ERROR_RPC_THROTTLED if the node responds
+    with HTTP status 429, BOAT_ERROR_RPC_SERVER with HTTP status 5xx, or
+    BOAT_ERROR_EXT_MODULE_OPERATION_FAIL.
+
+@param[in] engine_ptr
+    The engine.
+
+@param[in] transfer_ptr
+    The transfer.
+
+@param[in] deadline_ms
+    The deadline as per BoatGetTimeMs().
+*******************************************************************************/
+static BOAT_RESULT CurlPortEngineWait(CurlPortEngine *engine_ptr, CurlPortTransfer *transfer_ptr, UINT64 deadline_ms)
+{
+    struct timespec deadline;
+    long info = 0;
+    CURLcode curl_result;
+
+    pthread_mutex_lock(&engine_ptr->mutex);
+
+    while( !transfer_ptr->is_done && BoatGetTimeMs() < deadline_ms )
+    {
+        if( !engine_ptr->is_driving && engine_ptr->stopping_num == 0 )
+        {
+            CurlPortEngineDriveLocked(engine_ptr, deadline_ms);
+        }
+        else
+        {
+            deadline.tv_sec = deadline_ms / 1000u;
+            deadline.tv_nsec = (deadline_ms % 1000u) * 1000000u;
+            pthread_cond_timedwait(&engine_ptr->cond, &engine_ptr->mutex, &deadline);
+        }
+    }
 
-#include "wallet/boattypes.h"
+    CurlPortEngineUnlinkLocked(engine_ptr, transfer_ptr);
 
-#if RPC_USE_LIBCURL == 1
-#include "utilities/utility.h"
-#include "rpc/rpcport.h"
-#include "rpc/curlport.h"
-#include "curl/curl.h"
+    pthread_mutex_unlock(&engine_ptr->mutex);
 
-//!@brief Defines the buffer size to receive response from peer.
+    if( !transfer_ptr->is_done ) return BOAT_ERROR_RPC_TIMEOUT;
 
+    CurlPortCountBytes(transfer_ptr);
 
-//!The step to dynamically expand the receiving buffer.
-#define CURLPORT_RECV_BUF_SIZE_STEP 1024
+    if( transfer_ptr->curl_result != CURLE_OK )
+    {
+        BoatLog(BOAT_LOG_NORMAL, "curl_easy_perform fails with CURLcode: %d.", transfer_ptr->curl_result);
+        if( transfer_ptr->curl_result == CURLE_OPERATION_TIMEDOUT ) return BOAT_ERROR_RPC_TIMEOUT;
+        // Not worth retrying until the node or the CA bundle is fixed
+        if(    transfer_ptr->curl_result == CURLE_PEER_FAILED_VERIFICATION
+            || transfer_ptr->curl_result == CURLE_SSL_CACERT
+            || transfer_ptr->curl_result == CURLE_SSL_CACERT_BADFILE )
+        {
+            return BOAT_ERROR_RPC_UNTRUSTED;
+        }
+        return BOAT_ERROR_EXT_MODULE_OPERATION_FAIL;
+    }
 
-//!@brief A struct to maintain a dynamic length string.
-typedef struct TCurlPortStringWithLen
+    curl_result = curl_easy_getinfo(transfer_ptr->curl_ctx_ptr, CURLINFO_RESPONSE_CODE, &info);
+
+    if(( curl_result == CURLE_OK ) && (info == 200 || info == 201))
+    {
+        BoatLog(BOAT_LOG_VERBOSE, "Result Code: %ld", info);
+        BoatLog(BOAT_LOG_VERBOSE, "Response: %s", transfer_ptr->response.string_ptr);
+    }
+    else
+    {
+        BoatLog(BOAT_LOG_NORMAL, "curl_easy_getinfo fails with CURLcode: %d, HTTP response code %ld.", curl_result, info);
+        // Tell throttling and server errors from others, so that callers could back off
+        if( curl_result == CURLE_OK && info == 429 ) return BOAT_ERROR_RPC_THROTTLED;
+        if( curl_result == CURLE_OK && info >= 500 && info < 600 ) return BOAT_ERROR_RPC_SERVER;
+        return BOAT_ERROR_EXT_MODULE_OPERATION_FAIL;
+    }
+
+    return BOAT_SUCCESS;
+}
+
+
+/*!*****************************************************************************
+@brief Return the RESPONSE of a completed transfer and free the transfer
+
+Function: CurlPortReturnResponse()
+
+    The RESPONSE buffer of the transfer becomes the receiving buffer of the
+    thread, whose old buffer is freed.
+
+@return This function doesn't return any value.
+
+@param[in] transfer_ptr
+    The transfer.
+
+@param[out] response_str_ptr
+    The address of a CHAR* pointer to hold the address of the RESPONSE.
+
+@param[out] response_len_ptr
+    The address of a UINT32 integer to hold the length of the RESPONSE.
+*******************************************************************************/
+static void CurlPortReturnResponse(CurlPortTransfer *transfer_ptr,
+                                   BOAT_OUT CHAR **response_str_ptr,
+                                   BOAT_OUT UINT32 *response_len_ptr)
 {
-    CHAR *string_ptr;   //!< address of the string storage
-    UINT32 string_len;  //!< string length in byte excluding NULL terminator, equal to strlen(string_ptr)
-    UINT32 string_space;//!< size of the space <string_ptr> pointing to, including null terminator
-}CurlPortStringWithLen;
+    CurlPortStringWithLen swap;
 
-CurlPortStringWithLen g_curlport_response = {NULL, 0, 0}; 
+    swap = g_curlport_response;
+    g_curlport_response = transfer_ptr->response;
+    transfer_ptr->response = swap;
+
+    *response_str_ptr = g_curlport_response.string_ptr;
+    *response_len_ptr = g_curlport_response.string_len;
+
+    CurlPortFreeTransfer(transfer_ptr);
+}
 
 
 
@@ -101,6 +1366,7 @@ BOAT_RESULT CurlPortInit(void)
         }
         else
         {
+            g_curlport_response.string_ptr[0] = '\0';
             result = BOAT_SUCCESS;
         }
 
@@ -117,7 +1383,9 @@ BOAT_RESULT CurlPortInit(void)
 Function: CurlPortDeinit()
 
     This function de-initializes libcurl. It also frees the dynamically
-    allocated storage to receive response from the peer.
+    allocated storage to receive response from the peer, the engine with
+    its connections, the DNS cache, the CA store and pinned addresses. Other threads must
+    have stopped RPC.
     
 
 @return
@@ -129,19 +1397,33 @@ Function: CurlPortDeinit()
 *******************************************************************************/
 void CurlPortDeinit(void)
 {
-    curl_global_cleanup();
+    CurlPortFreeResponse(&g_curlport_response);
 
-    g_curlport_response.string_space = 0;
-    g_curlport_response.string_len = 0;
-
-
-    if( g_curlport_response.string_ptr != NULL )
+#if BOAT_CURL_SHARE_CONNECTIONS == 1
+    pthread_mutex_lock(&g_curlport_shared_engine_mutex);
+    if( g_curlport_shared_engine_ptr != NULL )
     {
-        BoatFree(g_curlport_response.string_ptr);
+        CurlPortEngineDestroy(g_curlport_shared_engine_ptr);
+        g_curlport_shared_engine_ptr = NULL;
     }
+    pthread_mutex_unlock(&g_curlport_shared_engine_mutex);
+#endif
 
+    pthread_mutex_lock(&g_curlport_share_mutex);
+    if( g_curlport_share_ptr != NULL )
+    {
+        curl_share_cleanup(g_curlport_share_ptr);
+        g_curlport_share_ptr = NULL;
+    }
+    curl_slist_free_all(g_curlport_pinned_list_ptr);
+    g_curlport_pinned_list_ptr = NULL;
+#if CURLPORT_SHARE_CA_STORE == 1
+    X509_STORE_free(g_curlport_ca_store_ptr);
+    g_curlport_ca_store_ptr = NULL;
+#endif
+    pthread_mutex_unlock(&g_curlport_share_mutex);
 
-    g_curlport_response.string_ptr = NULL;
+    curl_global_cleanup();
 
     return;
 }
@@ -153,7 +1435,7 @@ void CurlPortDeinit(void)
 Function: CurlPortSetOpt()
 
     This function is a dummy function for compatible with RPC Port skeleton.
-    curl_easy_setopt() is actually called in CurlPortRequestSync() because some
+    curl_easy_setopt() is actually called for each REQUEST because some
     options are per-session effective.
     
 
@@ -172,98 +1454,85 @@ BOAT_RESULT CurlPortSetOpt(const RpcOption *rpc_option_ptr)
 
 
 /*!*****************************************************************************
-@brief Callback function to write received data from the peer to the user specified buffer.
+@brief Pin the address of a host, so that REQUESTs to it never wait for DNS.
 
-Function: CurlPortWriteMemoryCallback()
+Function: CurlPortPinAddress()
 
-    This function is a callback function as per libcurl CURLOPT_WRITEFUNCTION option.
-    libcurl will call this function (possibly) multiple times to write received
-    data from peer to the buffer specified by this function. The received data
-    are typically some RESPONSE from the HTTP server.
+    This function gives libcurl the address of <host_str>:<port> the way
+    CURLOPT_RESOLVE does, for all threads. Pinning the same host and port
+    again replaces its addresses. Pins last until CurlPortDeinit().
 
-    The receiving buffer is dynamically allocated. If the received data from
-    the peer exceeds the current buffer size, a new buffer that could hold all
-    data will be allocated and previously received data will be copied to the
-    new buffer as well as the newly received data.
+    A connection already open to the host is kept.
 
-    
-@see https://curl.haxx.se/libcurl/c/CURLOPT_WRITEFUNCTION.html
-    
 
 @return
-    This function returns how many bytes are written into the user buffer.
-    If the returned size differs from <size>*<nmemb>, libcurl will treat it as
-    a failure.
-    
+    This function returns BOAT_SUCCESS if successful, BOAT_ERROR_INVALID_LENGTH
+    if an argument is too long, or BOAT_ERROR_OUT_OF_MEMORY.
 
-@param[in] data_ptr
-    A pointer given by libcurl, pointing to the received data from peer.
 
-@param[in] size
-    For historic reasons, libcurl will always call with <size> = 1.
+@param[in] host_str
+    The host name as in node URLs, e.g. "node.example.com".
 
-@param[in] nmemb
-    <nmemb> is the size of the data chunk to write. It doesn't include null
-    terminator even if the data were string.\n
-    For backward compatibility, use <size> * <nmemb> to calculate the size of
-    the received data.
+@param[in] port
+    The port as in node URLs, e.g. 8545, or 443 for "https://" without one.
 
-@param[in] userdata
-    <userdata> is the value previously set by CURLOPT_WRITEDATA option.
-    Typically it's a pointer to a struct which contains information about the
-    receiving buffer.
+@param[in] address_str
+    The IP address, or comma separated addresses tried in turn, e.g.
+    "192.0.2.10" or "192.0.2.10,[2001:db8::10]".
 
 *******************************************************************************/
-size_t CurlPortWriteMemoryCallback(void *data_ptr, size_t size, size_t nmemb, void *userdata)
+BOAT_RESULT CurlPortPinAddress(const CHAR *host_str, UINT16 port, const CHAR *address_str)
 {
-    size_t data_size;
-    CurlPortStringWithLen *mem;
-    UINT32 expand_size;
-    UINT32 expand_steps;
-    CHAR *expanded_str;
-    UINT32 expanded_to_space;
-    
-    mem = (CurlPortStringWithLen*)userdata;
-
-    // NOTE: For historic reasons, argument size is always 1 and nmemb is the
-    // size of the data chunk to write. And size * nmemb doesn't include null
-    // terminator even if the data were string.
-    data_size = size * nmemb;
-    
-    // If response buffer has enough space:
-    if( mem->string_space - mem->string_len > data_size ) // 1 more byte reserved for null terminator
+    CHAR entry_str[256];
+    UINT32 prefix_len;
+    struct curl_slist *list_ptr = NULL;
+    struct curl_slist *pinned_ptr;
+    struct curl_slist *new_list_ptr;
+    BOAT_RESULT result = BOAT_SUCCESS;
+
+    if( host_str == NULL || address_str == NULL )
     {
-        memcpy(mem->string_ptr + mem->string_len, data_ptr, data_size);
-        mem->string_len += data_size;
-        mem->string_ptr[mem->string_len] = '\0';
+        BoatLog(BOAT_LOG_CRITICAL, "Argument cannot be NULL.");
+        return BOAT_ERROR_NULL_POINTER;
     }
-    else  // If response buffer has no enough space
+
+    // "<host>:<port>:<address>[,<address>...]"
+    prefix_len = snprintf(entry_str, sizeof(entry_str), "%s:%u:", host_str, (unsigned int)port);
+    if( prefix_len + strlen(address_str) >= sizeof(entry_str) )
     {
+        BoatLog(BOAT_LOG_NORMAL, "Host or address is too long.");
+        return BOAT_ERROR_INVALID_LENGTH;
+    }
+    strcat(entry_str, address_str);
 
-        // If malloc is supported, expand the response buffer in steps of
-        // CURLPORT_RECV_BUF_SIZE_STEP.
-        
-        expand_size = data_size - (mem->string_space - mem->string_len) + 1; // plus 1 for null terminator
-        expand_steps = (expand_size - 1) / CURLPORT_RECV_BUF_SIZE_STEP + 1;
-        expanded_to_space = expand_steps * CURLPORT_RECV_BUF_SIZE_STEP + mem->string_space;
-    
-        expanded_str = BoatMalloc(expanded_to_space);
+    pthread_mutex_lock(&g_curlport_share_mutex);
 
-        if( expanded_str != NULL )
-        {
-            memcpy(expanded_str, mem->string_ptr, mem->string_len);
-            memcpy(expanded_str + mem->string_len, data_ptr, data_size);
-            BoatFree(mem->string_ptr);
-            mem->string_ptr = expanded_str;
-            mem->string_space = expanded_to_space;
-            mem->string_len += data_size;
-            mem->string_ptr[mem->string_len] = '\0';
-        }
+    // Copy the other pins, so that nothing is freed if out of memory
+    for( pinned_ptr = g_curlport_pinned_list_ptr; pinned_ptr != NULL; pinned_ptr = pinned_ptr->next )
+    {
+        if( strncmp(pinned_ptr->data, entry_str, prefix_len) == 0 ) continue;
 
+        new_list_ptr = curl_slist_append(list_ptr, pinned_ptr->data);
+        if( new_list_ptr == NULL ) break;
+        list_ptr = new_list_ptr;
     }
 
-    return data_size;
+    new_list_ptr = pinned_ptr == NULL ? curl_slist_append(list_ptr, entry_str) : NULL;
+    if( new_list_ptr == NULL )
+    {
+        BoatLog(BOAT_LOG_CRITICAL, "Fail to pin address of %s.", host_str);
+        curl_slist_free_all(list_ptr);
+        result = BOAT_ERROR_OUT_OF_MEMORY;
+    }
+    else
+    {
+        curl_slist_free_all(g_curlport_pinned_list_ptr);
+        g_curlport_pinned_list_ptr = new_list_ptr;
+    }
 
+    pthread_mutex_unlock(&g_curlport_share_mutex);
+
+    return result;
 }
 
 
@@ -272,8 +1541,8 @@ size_t CurlPortWriteMemoryCallback(void *data_ptr, size_t size, size_t nmemb, vo
 
 Function: CurlPortRequestSync()
 
-    This function initiates a curl session, performs a synchronous HTTP POST
-    and waits for its response.
+    This function performs a HTTP POST on the engine and waits for its
+    response. The connection is reused by later REQUESTs.
 
     is a callback function as per libcurl CURLOPT_WRITEFUNCTION option.
     libcurl will call this function (possibly) multiple times to write received
@@ -316,11 +1585,8 @@ BOAT_RESULT CurlPortRequestSync(const CHAR *request_str,
                                BOAT_OUT CHAR **response_str_ptr,
                                BOAT_OUT UINT32 *response_len_ptr)
 {
-    CURL *curl_ctx_ptr = NULL;
-    struct curl_slist *curl_opt_list_ptr = NULL;
-    CURLcode curl_result;
-    
-    long info;
+    CurlPortEngine *engine_ptr;
+    CurlPortTransfer *transfer_ptr;
     BOAT_RESULT result = BOAT_ERROR;
     boat_try_declare;
 
@@ -331,144 +1597,180 @@ BOAT_RESULT CurlPortRequestSync(const CHAR *request_str,
        || response_len_ptr == NULL )
     {
         BoatLog(BOAT_LOG_CRITICAL, "Argument cannot be NULL.");
-        result = BOAT_ERROR;
         boat_throw(BOAT_ERROR_NULL_POINTER, CurlPortRequestSync_cleanup);
     }
 
-    curl_ctx_ptr = curl_easy_init();
-    
-    if(curl_ctx_ptr != NULL)
-    {
-        g_rpc_ctx.curl_ctx_ptr = curl_ctx_ptr;
-    }
-    else
+    engine_ptr = CurlPortGetEngine();
+    if( engine_ptr == NULL ) boat_throw(BOAT_ERROR_EXT_MODULE_OPERATION_FAIL, CurlPortRequestSync_cleanup);
+
+    transfer_ptr = CurlPortEngineSend(engine_ptr, request_str, request_len);
+    if( transfer_ptr == NULL ) boat_throw(BOAT_ERROR_EXT_MODULE_OPERATION_FAIL, CurlPortRequestSync_cleanup);
+
+    result = CurlPortEngineWait(engine_ptr, transfer_ptr, BoatGetTimeMs() + g_rpc_ctx.timeout_ms);
+    if( result != BOAT_SUCCESS )
     {
-        BoatLog(BOAT_LOG_CRITICAL, "curl_easy_init() fails.");
-        result = BOAT_ERROR_EXT_MODULE_OPERATION_FAIL;
-        boat_throw(BOAT_ERROR_EXT_MODULE_OPERATION_FAIL, CurlPortRequestSync_cleanup);
+        CurlPortFreeTransfer(transfer_ptr);
+        boat_throw(result, CurlPortRequestSync_cleanup);
     }
+
+    CurlPortReturnResponse(transfer_ptr, response_str_ptr, response_len_ptr);
     
-    // Set RPC URL in format "<protocol>://<target name or IP>:<port>". e.g. "http://192.168.56.1:7545"
-    curl_result = curl_easy_setopt(curl_ctx_ptr, CURLOPT_URL, g_rpc_option.node_url_str);
-    if( curl_result != CURLE_OK )
+    result = BOAT_SUCCESS;
+
+
+    // Exceptional Clean Up
+    boat_catch(CurlPortRequestSync_cleanup)
     {
-        BoatLog(BOAT_LOG_NORMAL, "Unknown URL: %s", g_rpc_option.node_url_str);
-        boat_throw(BOAT_ERROR_EXT_MODULE_OPERATION_FAIL, CurlPortRequestSync_cleanup);
+        BoatLog(BOAT_LOG_NORMAL, "Exception: %d", boat_exception);
+        result = boat_exception;
     }
+    
+    return result;
+    
+}
 
-    // Configure all protocols to be supported
-    curl_easy_setopt(curl_ctx_ptr, CURLOPT_PROTOCOLS, CURLPROTO_ALL);
-                   
-    // Configure SSL Certification Verification
-    // If certification file is not available, set them to 0.
-    // See: https://curl.haxx.se/libcurl/c/CURLOPT_SSL_VERIFYPEER.html
-    curl_easy_setopt(curl_ctx_ptr, CURLOPT_SSL_VERIFYPEER, 0);
-    curl_easy_setopt(curl_ctx_ptr, CURLOPT_SSL_VERIFYHOST, 0);
 
-    // To specify a certificate file or specify a path containing certification files
-    // Only make sense when CURLOPT_SSL_VERIFYPEER is set to non-zero.
-    // curl_easy_setopt(curl_ctx_ptr, CURLOPT_CAINFO, "/etc/certs/cabundle.pem");
-    // curl_easy_setopt(curl_ctx_ptr, CURLOPT_CAPATH, "/etc/cert-dir");
+/*!*****************************************************************************
+@brief Start a HTTP POST without waiting for its response.
 
-    // Allow Re-direction
-    curl_easy_setopt(curl_ctx_ptr, CURLOPT_FOLLOWLOCATION,1); 
+Function: CurlPortSend()
 
-    // Verbose Debug Info.
-    // curl_easy_setopt(curl_ctx_ptr, CURLOPT_VERBOSE, 1);
+    This function adds a transfer POSTing <request_str> to the engine. Its
+    RESPONSE is taken later with CurlPortRecv() by the "id" of the REQUEST.
+    Transfers outstanding at a time are performed concurrently, as streams of
+    one connection with HTTP/2.
+    
 
+@return
+    This function returns BOAT_SUCCESS if successful. Otherwise it returns an
+    error code.
+    
 
-    // Set HTTP Type: POST
-    curl_easy_setopt(curl_ctx_ptr, CURLOPT_POST, 1L);
+@param[in] request_str
+    A pointer to the request string to POST.
 
-    // Set redirection: No
-    curl_easy_setopt(curl_ctx_ptr, CURLOPT_FOLLOWLOCATION, 0);
+@param[in] request_len
+    The length of <request_str> excluding NULL terminator.
 
-    // Set entire curl timeout in millisecond. This time includes DNS resloving.
-    curl_easy_setopt(curl_ctx_ptr, CURLOPT_TIMEOUT_MS, 30000L);
+*******************************************************************************/
+BOAT_RESULT CurlPortSend(const CHAR *request_str, UINT32 request_len)
+{
+    CurlPortEngine *engine_ptr;
+    CurlPortTransfer *transfer_ptr;
+    CurlPortTransfer **link_pptr;
 
-    // Set Connection timeout in millisecond
-    curl_easy_setopt(curl_ctx_ptr, CURLOPT_CONNECTTIMEOUT_MS, 10000L);
+    if( g_rpc_option.node_url_str == NULL || request_str == NULL )
+    {
+        BoatLog(BOAT_LOG_CRITICAL, "Argument cannot be NULL.");
+        return BOAT_ERROR_NULL_POINTER;
+    }
 
-    // Set HTTP HEADER Options
-    curl_opt_list_ptr = curl_slist_append(curl_opt_list_ptr,"Content-Type:application/json;charset=UTF-8");
-    if( curl_opt_list_ptr == NULL ) boat_throw(BOAT_ERROR_EXT_MODULE_OPERATION_FAIL, CurlPortRequestSync_cleanup);
+    engine_ptr = CurlPortGetEngine();
+    if( engine_ptr == NULL ) return BOAT_ERROR_EXT_MODULE_OPERATION_FAIL;
+
+    transfer_ptr = CurlPortEngineSend(engine_ptr, request_str, request_len);
+    if( transfer_ptr == NULL ) return BOAT_ERROR_EXT_MODULE_OPERATION_FAIL;
+
+    for( link_pptr = &g_curlport_sent_list_ptr; *link_pptr != NULL; link_pptr = &(*link_pptr)->thread_next_ptr );
+    *link_pptr = transfer_ptr;
+
+    return BOAT_SUCCESS;
+}
+
+
+/*!*****************************************************************************
+@brief Wait for the response to a HTTP POST started by CurlPortSend().
+
+Function: CurlPortRecv()
+
+    This function waits for the transfer of the REQUEST with the given "id" to
+    complete, and returns its RESPONSE. The transfer is given up if it doesn't
+    complete in time.
     
-    curl_opt_list_ptr = curl_slist_append(curl_opt_list_ptr,"Accept:application/json, text/javascript, */*;q=0.01");
-    if( curl_opt_list_ptr == NULL ) boat_throw(BOAT_ERROR_EXT_MODULE_OPERATION_FAIL, CurlPortRequestSync_cleanup);
 
-    curl_opt_list_ptr = curl_slist_append(curl_opt_list_ptr,"Accept-Language:zh-CN,zh;q=0.8");
-    if( curl_opt_list_ptr == NULL ) boat_throw(BOAT_ERROR_EXT_MODULE_OPERATION_FAIL, CurlPortRequestSync_cleanup);
+@return
+    This function returns BOAT_SUCCESS if successful, BOAT_ERROR_RPC_TIMEOUT
+    if the RESPONSE doesn't arrive in time, BOAT_ERROR_RPC_FAIL if no REQUEST
+    of <id> is outstanding, or other error codes.
+    
 
-    curl_easy_setopt(curl_ctx_ptr, CURLOPT_HTTPHEADER, curl_opt_list_ptr);
+@param[in] id
+    The "id" of the REQUEST, or -1 to take the oldest REQUEST.
 
+@param[in] timeout_ms
+    Max time to wait, in millisecond.
 
-    // Set callback and receive buffer for RESPONSE
-    // Clean up response buffer
-    g_curlport_response.string_ptr[0] = '\0';
-    g_curlport_response.string_len = 0;
-    curl_easy_setopt(curl_ctx_ptr, CURLOPT_WRITEDATA, &g_curlport_response);
-    curl_easy_setopt(curl_ctx_ptr, CURLOPT_WRITEFUNCTION, CurlPortWriteMemoryCallback);
+@param[out] response_str_ptr
+    The address of a CHAR* pointer (i.e. a double pointer) to hold the address
+    of the receiving buffer, which is the same as CurlPortRequestSync().
 
-    // Set content to POST    
-    curl_easy_setopt(curl_ctx_ptr, CURLOPT_POSTFIELDS, request_str);
-    curl_easy_setopt(curl_ctx_ptr, CURLOPT_POSTFIELDSIZE, request_len);
+@param[out] response_len_ptr
+    The address of a UINT32 integer to hold the effective length of
+    <response_str_ptr> excluding NULL terminator.
 
+*******************************************************************************/
+BOAT_RESULT CurlPortRecv(SINT64 id,
+                        UINT32 timeout_ms,
+                        BOAT_OUT CHAR **response_str_ptr,
+                        BOAT_OUT UINT32 *response_len_ptr)
+{
+    CurlPortTransfer *transfer_ptr;
+    CurlPortTransfer **link_pptr;
+    BOAT_RESULT result;
 
-    // Perform the RPC request
-    curl_result = curl_easy_perform(curl_ctx_ptr);
+    if( response_str_ptr == NULL || response_len_ptr == NULL )
+    {
+        BoatLog(BOAT_LOG_CRITICAL, "Argument cannot be NULL.");
+        return BOAT_ERROR_NULL_POINTER;
+    }
 
-    if( curl_result != CURLE_OK )
+    for( link_pptr = &g_curlport_sent_list_ptr; *link_pptr != NULL; link_pptr = &(*link_pptr)->thread_next_ptr )
     {
-        BoatLog(BOAT_LOG_NORMAL, "curl_easy_perform fails with CURLcode: %d.", curl_result);
-        boat_throw(BOAT_ERROR_EXT_MODULE_OPERATION_FAIL, CurlPortRequestSync_cleanup);
+        if( id < 0 || (*link_pptr)->id == id ) break;
     }
-    
 
-    curl_result = curl_easy_getinfo(curl_ctx_ptr, CURLINFO_RESPONSE_CODE, &info);
+    transfer_ptr = *link_pptr;
+    if( transfer_ptr == NULL ) return BOAT_ERROR_RPC_FAIL;
+    *link_pptr = transfer_ptr->thread_next_ptr;
 
-    if(( curl_result == CURLE_OK ) && (info == 200 || info == 201))
+    result = CurlPortEngineWait(g_rpc_ctx.curl_engine_ptr, transfer_ptr, BoatGetTimeMs() + timeout_ms);
+    if( result != BOAT_SUCCESS )
     {
-        *response_str_ptr = g_curlport_response.string_ptr;
-        *response_len_ptr = g_curlport_response.string_len;
-        
-        BoatLog(BOAT_LOG_VERBOSE, "Post: %s", request_str);
-        BoatLog(BOAT_LOG_VERBOSE, "Result Code: %ld", info);
-        BoatLog(BOAT_LOG_VERBOSE, "Response: %s", *response_str_ptr);
+        CurlPortFreeTransfer(transfer_ptr);
+        return result;
     }
-    else
-    {
-        BoatLog(BOAT_LOG_NORMAL, "curl_easy_getinfo fails with CURLcode: %d, HTTP response code %ld.", curl_result, info);
-        boat_throw(BOAT_ERROR_EXT_MODULE_OPERATION_FAIL, CurlPortRequestSync_cleanup);
-    }    
 
-    // Clean Up
-    curl_slist_free_all(curl_opt_list_ptr);
-    curl_easy_cleanup(curl_ctx_ptr);
-    g_rpc_ctx.curl_ctx_ptr = NULL;
-    
-    result = BOAT_SUCCESS;
+    CurlPortReturnResponse(transfer_ptr, response_str_ptr, response_len_ptr);
 
+    return BOAT_SUCCESS;
+}
 
-    // Exceptional Clean Up
-    boat_catch(CurlPortRequestSync_cleanup)
-    {
-        BoatLog(BOAT_LOG_NORMAL, "Exception: %d", boat_exception);
-        
-        if( curl_opt_list_ptr != NULL )
-        {
-            curl_slist_free_all(curl_opt_list_ptr);
-        }
 
-        if( curl_ctx_ptr != NULL )
-        {
-            curl_easy_cleanup(curl_ctx_ptr);
-            g_rpc_ctx.curl_ctx_ptr = NULL;
-        }
-        result = boat_exception;
-    }
+
+/*!*****************************************************************************
+@brief Get byte counts of REQUESTs and RESPONSEs
+
+Function: CurlPortGetByteStats()
+
+    Only REQUESTs whose RESPONSEs are taken by the calling thread are counted.
+    HTTP HEADERs aren't counted.
     
-    return result;
+
+@return
+    This function doesn't return any value.
     
+
+@param[out] last_ptr
+    Byte counts of the last REQUEST. It may be NULL.
+
+@param[out] total_ptr
+    Byte counts of all REQUESTs. It may be NULL.
+
+*******************************************************************************/
+void CurlPortGetByteStats(BOAT_OUT RpcByteStats *last_ptr, BOAT_OUT RpcByteStats *total_ptr)
+{
+    if( last_ptr != NULL ) *last_ptr = g_curlport_last_bytes;
+    if( total_ptr != NULL ) *total_ptr = g_curlport_total_bytes;
 }
 
 #endif // end of #if RPC_USE_LIBCURL == 1
@@ -54,6 +54,17 @@ BOAT_RESULT CurlPortRequestSync(const CHAR *request_str,
                                BOAT_OUT CHAR **response_str_ptr,
                                BOAT_OUT UINT32 *response_len_ptr);
 
+BOAT_RESULT CurlPortSend(const CHAR *request_str, UINT32 request_len);
+
+BOAT_RESULT CurlPortRecv(SINT64 id,
+                        UINT32 timeout_ms,
+                        BOAT_OUT CHAR **response_str_ptr,
+                        BOAT_OUT UINT32 *response_len_ptr);
+
+void CurlPortGetByteStats(BOAT_OUT RpcByteStats *last_ptr, BOAT_OUT RpcByteStats *total_ptr);
+
+BOAT_RESULT CurlPortPinAddress(const CHAR *host_str, UINT16 port, const CHAR *address_str);
+
 
 #ifdef __cplusplus
 }
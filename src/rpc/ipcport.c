@@ -0,0 +1,1014 @@
+/******************************************************************************
+Copyright (C) 2018-2019 AITOS.IO
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+of the Software, and to permit persons to whom the Software is furnished to do
+so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+******************************************************************************/
+
+/*!@brief IPC porting for RPC
+
+@file
+ipcport.c is the IPC porting of RPC, for a node running on the same host, e.g.
+geth with its "geth.ipc" Unix domain socket.
+
+REQUESTs are written as JSON-RPC text followed by a newline. The node writes
+RESPONSEs and subscription notifications as a stream of JSON values, which are
+delimited here by matching brackets, so that newlines between them are
+optional. All REQUESTs of a thread are sent over one persistent connection,
+which is opened on the first request and re-opened if the node closes it.
+
+Several REQUESTs could be outstanding at a time: IpcPortSend() writes a REQUEST
+without waiting and IpcPortRecv() takes the RESPONSE with a given "id".
+RESPONSEs arriving before they're asked for are kept until then.
+
+DO NOT call functions in this file directly. Instead call wrapper functions
+provided by rpcport.
+
+To use IPC porting, RPC_USE_IPC in boatoptions.h must set to 1.
+*/
+
+// For MSG_NOSIGNAL
+#define _DEFAULT_SOURCE
+
+#include "wallet/boattypes.h"
+
+#if RPC_USE_IPC == 1
+#include "utilities/utility.h"
+#include "rpc/rpcport.h"
+#include "rpc/ipcport.h"
+#include "rpc/rpcmsg.h"
+
+#include <pthread.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <poll.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+
+
+//!The step to dynamically expand the receiving buffer.
+#define IPCPORT_RECV_BUF_SIZE_STEP 1024
+
+//!Size of the read-ahead buffer of the socket
+#define IPCPORT_READ_AHEAD_SIZE 4096
+
+//!@brief A struct to maintain a dynamic length string.
+typedef struct TIpcPortStringWithLen
+{
+    CHAR *string_ptr;   //!< address of the string storage
+    UINT32 string_len;  //!< string length in byte excluding NULL terminator
+    UINT32 string_space;//!< size of the space <string_ptr> pointing to, including null terminator
+}IpcPortStringWithLen;
+
+//!@brief A persistent connection of a thread
+typedef struct TIpcPortConn
+{
+    int socket_fd;                  //!< Socket of the connection, -1 if not connected
+    CHAR *path_str;                 //!< Copy of the socket path the connection is opened to
+    UINT8 read_ahead[IPCPORT_READ_AHEAD_SIZE]; //!< Bytes received but not consumed yet
+    UINT32 read_ahead_pos;          //!< Offset of the first unconsumed byte in <read_ahead>
+    UINT32 read_ahead_len;          //!< Number of bytes in <read_ahead>
+    IpcPortStringWithLen message;   //!< The message being received
+    UINT32 scan_depth;              //!< Bracket depth of <message>, 0 between messages
+    BOATBOOL scan_in_string;        //!< Whether <message> ends inside a string
+    BOATBOOL scan_escaped;          //!< Whether <message> ends with an escaping backslash in a string
+    IpcPortStringWithLen response;  //!< The last message returned to the caller
+    RpcMsgQueue notifications;      //!< Subscription notifications not taken yet
+    RpcMsgQueue responses;          //!< RESPONSEs received before they're asked for
+}IpcPortConn;
+
+//!@brief Key whose destructor closes the connection of a non-main thread on its exit.
+static pthread_key_t g_ipcport_conn_key;
+static pthread_once_t g_ipcport_conn_key_once = PTHREAD_ONCE_INIT;
+
+
+static void IpcPortDisconnect(IpcPortConn *conn_ptr)
+{
+    if( conn_ptr->socket_fd >= 0 )
+    {
+        close(conn_ptr->socket_fd);
+        conn_ptr->socket_fd = -1;
+    }
+
+    conn_ptr->read_ahead_pos = 0;
+    conn_ptr->read_ahead_len = 0;
+    conn_ptr->message.string_len = 0;
+    conn_ptr->scan_depth = 0;
+    conn_ptr->scan_in_string = BOAT_FALSE;
+    conn_ptr->scan_escaped = BOAT_FALSE;
+
+    // RESPONSEs to REQUESTs sent over a lost connection never arrive
+    RpcMsgQueueClear(&conn_ptr->responses);
+}
+
+
+static void IpcPortFreeConn(void *conn)
+{
+    IpcPortConn *conn_ptr = (IpcPortConn *)conn;
+
+    if( conn_ptr == NULL ) return;
+
+    IpcPortDisconnect(conn_ptr);
+    RpcMsgQueueClear(&conn_ptr->notifications);
+
+    if( conn_ptr->path_str != NULL ) BoatFree(conn_ptr->path_str);
+    if( conn_ptr->message.string_ptr != NULL ) BoatFree(conn_ptr->message.string_ptr);
+    if( conn_ptr->response.string_ptr != NULL ) BoatFree(conn_ptr->response.string_ptr);
+
+    BoatFree(conn_ptr);
+}
+
+
+static void IpcPortCreateConnKey(void)
+{
+    pthread_key_create(&g_ipcport_conn_key, IpcPortFreeConn);
+}
+
+
+/*!*****************************************************************************
+@brief Make room in a dynamic length string
+
+Function: IpcPortStringReserve()
+
+    This function expands <mem> in steps of IPCPORT_RECV_BUF_SIZE_STEP so that
+    <more_len> bytes plus a null terminator could be appended.
+
+@return
+    This function returns BOAT_SUCCESS if successful, or
+    BOAT_ERROR_OUT_OF_MEMORY.
+
+@param[in] mem
+    The string to expand.
+
+@param[in] more_len
+    The number of bytes to append.
+*******************************************************************************/
+static BOAT_RESULT IpcPortStringReserve(IpcPortStringWithLen *mem, UINT32 more_len)
+{
+    UINT32 expand_size;
+    UINT32 expand_steps;
+    UINT32 expanded_to_space;
+    CHAR *expanded_str;
+
+    if( mem->string_space > mem->string_len && mem->string_space - mem->string_len > more_len )
+    {
+        return BOAT_SUCCESS;
+    }
+
+    expand_size = more_len - (mem->string_space - mem->string_len) + 1; // plus 1 for null terminator
+    expand_steps = (expand_size - 1) / IPCPORT_RECV_BUF_SIZE_STEP + 1;
+    expanded_to_space = expand_steps * IPCPORT_RECV_BUF_SIZE_STEP + mem->string_space;
+
+    expanded_str = BoatMalloc(expanded_to_space);
+    if( expanded_str == NULL )
+    {
+        BoatLog(BOAT_LOG_CRITICAL, "Fail to expand IPC buffer to %u bytes.", expanded_to_space);
+        return BOAT_ERROR_OUT_OF_MEMORY;
+    }
+
+    if( mem->string_ptr != NULL )
+    {
+        memcpy(expanded_str, mem->string_ptr, mem->string_len);
+        BoatFree(mem->string_ptr);
+    }
+
+    mem->string_ptr = expanded_str;
+    mem->string_space = expanded_to_space;
+
+    return BOAT_SUCCESS;
+}
+
+
+/*!*****************************************************************************
+@brief Get the connection of the calling thread
+
+Function: IpcPortGetConn()
+
+    This function returns the connection of the calling thread, which is
+    allocated on the thread's first call. It's freed on IpcPortDeinit() or when
+    the thread exits.
+
+@return
+    This function returns the connection, or NULL if out of memory.
+
+@param This function doesn't take any argument.
+*******************************************************************************/
+static IpcPortConn *IpcPortGetConn(void)
+{
+    IpcPortConn *conn_ptr;
+
+    if( g_rpc_ctx.ipc_conn_ptr != NULL ) return g_rpc_ctx.ipc_conn_ptr;
+
+    conn_ptr = BoatMalloc(sizeof(IpcPortConn));
+    if( conn_ptr == NULL )
+    {
+        BoatLog(BOAT_LOG_CRITICAL, "Fail to allocate IPC connection.");
+        return NULL;
+    }
+
+    memset(conn_ptr, 0, sizeof(IpcPortConn));
+    conn_ptr->socket_fd = -1;
+
+    if(    IpcPortStringReserve(&conn_ptr->message, IPCPORT_RECV_BUF_SIZE_STEP - 1) != BOAT_SUCCESS
+        || IpcPortStringReserve(&conn_ptr->response, IPCPORT_RECV_BUF_SIZE_STEP - 1) != BOAT_SUCCESS )
+    {
+        BoatLog(BOAT_LOG_CRITICAL, "Fail to allocate IPC RESPONSE buffer.");
+        IpcPortFreeConn(conn_ptr);
+        return NULL;
+    }
+    conn_ptr->response.string_ptr[0] = '\0';
+
+    pthread_once(&g_ipcport_conn_key_once, IpcPortCreateConnKey);
+    pthread_setspecific(g_ipcport_conn_key, conn_ptr);
+
+    g_rpc_ctx.ipc_conn_ptr = conn_ptr;
+
+    return conn_ptr;
+}
+
+
+static UINT32 IpcPortRemainingMs(UINT64 deadline_ms)
+{
+    UINT64 now_ms = BoatGetTimeMs();
+
+    return now_ms < deadline_ms ? (UINT32)(deadline_ms - now_ms) : 0;
+}
+
+
+/*!*****************************************************************************
+@brief Wait for a socket to become ready
+
+Function: IpcPortPoll()
+
+@return
+    This function returns BOAT_SUCCESS if the socket is ready,
+    BOAT_ERROR_RPC_TIMEOUT if <deadline_ms> passes, or BOAT_ERROR_RPC_FAIL.
+
+@param[in] socket_fd
+    The socket.
+
+@param[in] events
+    POLLIN or POLLOUT.
+
+@param[in] deadline_ms
+    The deadline as per BoatGetTimeMs().
+*******************************************************************************/
+static BOAT_RESULT IpcPortPoll(int socket_fd, short events, UINT64 deadline_ms)
+{
+    struct pollfd poll_fd;
+    int poll_result;
+
+    poll_fd.fd = socket_fd;
+    poll_fd.events = events;
+
+    do
+    {
+        poll_fd.revents = 0;
+        poll_result = poll(&poll_fd, 1, (int)IpcPortRemainingMs(deadline_ms));
+    }while( poll_result < 0 && errno == EINTR );
+
+    if( poll_result == 0 ) return BOAT_ERROR_RPC_TIMEOUT;
+    if( poll_result < 0 ) return BOAT_ERROR_RPC_FAIL;
+
+    // POLLHUP and POLLERR are left to the following recv() or send() to report
+    return BOAT_SUCCESS;
+}
+
+
+static BOAT_RESULT IpcPortSendAll(IpcPortConn *conn_ptr, const UINT8 *data_ptr, UINT32 data_len, UINT64 deadline_ms)
+{
+    ssize_t sent_len;
+    BOAT_RESULT result;
+
+    while( data_len > 0 )
+    {
+        sent_len = send(conn_ptr->socket_fd, data_ptr, data_len, MSG_NOSIGNAL);
+
+        if( sent_len > 0 )
+        {
+            data_ptr += sent_len;
+            data_len -= (UINT32)sent_len;
+        }
+        else if( sent_len < 0 && (errno == EAGAIN || errno == EWOULDBLOCK) )
+        {
+            result = IpcPortPoll(conn_ptr->socket_fd, POLLOUT, deadline_ms);
+            if( result != BOAT_SUCCESS ) return result;
+        }
+        else if( sent_len < 0 && errno == EINTR )
+        {
+            continue;
+        }
+        else
+        {
+            BoatLog(BOAT_LOG_NORMAL, "IPC send() fails with errno %d.", errno);
+            return BOAT_ERROR_RPC_FAIL;
+        }
+    }
+
+    return BOAT_SUCCESS;
+}
+
+
+/*!*****************************************************************************
+@brief Receive a message
+
+Function: IpcPortRecvMessage()
+
+    This function receives the next JSON value from the node into
+    <conn_ptr>->message. A value ends where its outermost bracket closes.
+    Whitespaces (including newlines) between values are skipped.
+
+    If <deadline_ms> passes in the middle of a message, the part received is
+    kept and the next call goes on with it.
+
+@return
+    This function returns BOAT_SUCCESS if a message is received,
+    BOAT_ERROR_RPC_TIMEOUT if <deadline_ms> passes, or other error codes.
+
+@param[in] conn_ptr
+    The connection.
+
+@param[in] deadline_ms
+    The deadline as per BoatGetTimeMs().
+*******************************************************************************/
+static BOAT_RESULT IpcPortRecvMessage(IpcPortConn *conn_ptr, UINT64 deadline_ms)
+{
+    const UINT8 *data_ptr;
+    UINT32 data_len;
+    UINT32 start;
+    UINT32 i;
+    BOATBOOL is_complete = BOAT_FALSE;
+    ssize_t recv_len;
+    BOAT_RESULT result;
+
+    while( 1 )
+    {
+        while( conn_ptr->read_ahead_len > 0 )
+        {
+            data_ptr = conn_ptr->read_ahead + conn_ptr->read_ahead_pos;
+            data_len = conn_ptr->read_ahead_len;
+            start = 0;
+
+            // Skip anything between messages
+            if( conn_ptr->scan_depth == 0 )
+            {
+                while( start < data_len && data_ptr[start] != '{' && data_ptr[start] != '[' ) start++;
+                conn_ptr->message.string_len = 0;
+            }
+
+            for( i = start; i < data_len; i++ )
+            {
+                if( conn_ptr->scan_in_string )
+                {
+                    if( conn_ptr->scan_escaped )             conn_ptr->scan_escaped = BOAT_FALSE;
+                    else if( data_ptr[i] == '\\' )           conn_ptr->scan_escaped = BOAT_TRUE;
+                    else if( data_ptr[i] == '"' )            conn_ptr->scan_in_string = BOAT_FALSE;
+                }
+                else if( data_ptr[i] == '"' )
+                {
+                    conn_ptr->scan_in_string = BOAT_TRUE;
+                }
+                else if( data_ptr[i] == '{' || data_ptr[i] == '[' )
+                {
+                    conn_ptr->scan_depth++;
+                }
+                else if( data_ptr[i] == '}' || data_ptr[i] == ']' )
+                {
+                    if( --conn_ptr->scan_depth == 0 )
+                    {
+                        i++;
+                        is_complete = BOAT_TRUE;
+                        break;
+                    }
+                }
+            }
+
+            if( i > start )
+            {
+                result = IpcPortStringReserve(&conn_ptr->message, i - start);
+                if( result != BOAT_SUCCESS )
+                {
+                    IpcPortDisconnect(conn_ptr);
+                    return result;
+                }
+                memcpy(conn_ptr->message.string_ptr + conn_ptr->message.string_len, data_ptr + start, i - start);
+                conn_ptr->message.string_len += i - start;
+            }
+
+            conn_ptr->read_ahead_pos += i;
+            conn_ptr->read_ahead_len -= i;
+
+            if( is_complete )
+            {
+                conn_ptr->message.string_ptr[conn_ptr->message.string_len] = '\0';
+                return BOAT_SUCCESS;
+            }
+        }
+
+        conn_ptr->read_ahead_pos = 0;
+
+        recv_len = recv(conn_ptr->socket_fd, conn_ptr->read_ahead, IPCPORT_READ_AHEAD_SIZE, 0);
+
+        if( recv_len > 0 )
+        {
+            conn_ptr->read_ahead_len = (UINT32)recv_len;
+        }
+        else if( recv_len < 0 && (errno == EAGAIN || errno == EWOULDBLOCK) )
+        {
+            result = IpcPortPoll(conn_ptr->socket_fd, POLLIN, deadline_ms);
+            if( result != BOAT_SUCCESS ) return result;
+        }
+        else if( recv_len < 0 && errno == EINTR )
+        {
+            continue;
+        }
+        else
+        {
+            BoatLog(BOAT_LOG_NORMAL, "IPC connection is closed by the node.");
+            IpcPortDisconnect(conn_ptr);
+            return BOAT_ERROR_RPC_FAIL;
+        }
+    }
+}
+
+
+/*!*****************************************************************************
+@brief Return the received message to the caller
+
+Function: IpcPortReturnMessage()
+
+    This function swaps the received message into <conn_ptr>->response, so
+    that receiving goes on in the other buffer.
+
+@return
+    This function doesn't return any value.
+
+@param[in] conn_ptr
+    The connection.
+
+@param[out] response_str_ptr
+    The address of a CHAR* pointer to hold the address of the message.
+
+@param[out] response_len_ptr
+    The address of a UINT32 integer to hold the length of the message.
+*******************************************************************************/
+static void IpcPortReturnMessage(IpcPortConn *conn_ptr,
+                                 BOAT_OUT CHAR **response_str_ptr,
+                                 BOAT_OUT UINT32 *response_len_ptr)
+{
+    IpcPortStringWithLen swap;
+
+    swap = conn_ptr->response;
+    conn_ptr->response = conn_ptr->message;
+    conn_ptr->message = swap;
+    conn_ptr->message.string_len = 0;
+
+    *response_str_ptr = conn_ptr->response.string_ptr;
+    *response_len_ptr = conn_ptr->response.string_len;
+}
+
+
+/*!*****************************************************************************
+@brief Return a kept message to the caller
+
+Function: IpcPortReturnKept()
+
+    This function copies a message taken from a RpcMsgQueue into
+    <conn_ptr>->response and frees it.
+
+@return
+    This function returns BOAT_SUCCESS if successful, or
+    BOAT_ERROR_OUT_OF_MEMORY.
+
+@param[in] conn_ptr
+    The connection.
+
+@param[in] kept_ptr
+    The message taken from a RpcMsgQueue.
+
+@param[in] kept_len
+    Length of <kept_ptr>.
+
+@param[out] response_str_ptr
+    The address of a CHAR* pointer to hold the address of the message.
+
+@param[out] response_len_ptr
+    The address of a UINT32 integer to hold the length of the message.
+*******************************************************************************/
+static BOAT_RESULT IpcPortReturnKept(IpcPortConn *conn_ptr,
+                                     CHAR *kept_ptr,
+                                     UINT32 kept_len,
+                                     BOAT_OUT CHAR **response_str_ptr,
+                                     BOAT_OUT UINT32 *response_len_ptr)
+{
+    BOAT_RESULT result;
+
+    conn_ptr->response.string_len = 0;
+    result = IpcPortStringReserve(&conn_ptr->response, kept_len);
+    if( result == BOAT_SUCCESS )
+    {
+        memcpy(conn_ptr->response.string_ptr, kept_ptr, kept_len + 1);
+        conn_ptr->response.string_len = kept_len;
+
+        *response_str_ptr = conn_ptr->response.string_ptr;
+        *response_len_ptr = conn_ptr->response.string_len;
+    }
+
+    BoatFree(kept_ptr);
+
+    return result;
+}
+
+
+
+/*!*****************************************************************************
+@brief Initialize IPC porting.
+
+Function: IpcPortInit()
+
+    This function allocates the connection of the calling thread. Other threads
+    allocate theirs on their first request. The connection is opened on the
+    first request.
+    
+
+@return
+    This function returns BOAT_SUCCESS if successful. Otherwise it returns
+    BOAT_ERROR_OUT_OF_MEMORY.
+    
+
+@param This function doesn't take any argument.
+
+*******************************************************************************/
+BOAT_RESULT IpcPortInit(void)
+{
+    return IpcPortGetConn() != NULL ? BOAT_SUCCESS : BOAT_ERROR_OUT_OF_MEMORY;
+}
+
+
+/*!*****************************************************************************
+@brief Deinitialize IPC porting.
+
+Function: IpcPortDeinit()
+
+    This function closes the connection of the calling thread and frees its
+    buffers and kept messages.
+    
+
+@return
+    This function doesn't return any value.
+    
+
+@param This function doesn't take any argument.
+
+*******************************************************************************/
+void IpcPortDeinit(void)
+{
+    if( g_rpc_ctx.ipc_conn_ptr != NULL )
+    {
+        pthread_setspecific(g_ipcport_conn_key, NULL);
+        IpcPortFreeConn(g_rpc_ctx.ipc_conn_ptr);
+        g_rpc_ctx.ipc_conn_ptr = NULL;
+    }
+
+    return;
+}
+
+
+/*!*****************************************************************************
+@brief Set options for use with IPC porting.
+
+Function: IpcPortSetOpt()
+
+    This function closes the connection of the calling thread if it's open to
+    a socket other than <rpc_option_ptr>->node_url_str. The connection to the
+    new socket is opened on the next request.
+    
+
+@return
+    This function always returns BOAT_SUCCESS.
+    
+
+@param[in] rpc_option_ptr
+    A pointer to the option struct of RpcOption.
+
+*******************************************************************************/
+BOAT_RESULT IpcPortSetOpt(const RpcOption *rpc_option_ptr)
+{
+    IpcPortConn *conn_ptr = g_rpc_ctx.ipc_conn_ptr;
+
+    if(    conn_ptr != NULL && conn_ptr->socket_fd >= 0
+        && (   rpc_option_ptr->node_url_str == NULL || conn_ptr->path_str == NULL
+            || strcmp(rpc_option_ptr->node_url_str, conn_ptr->path_str) != 0) )
+    {
+        IpcPortDisconnect(conn_ptr);
+    }
+
+    return BOAT_SUCCESS;
+}
+
+
+/*!*****************************************************************************
+@brief Open the connection of the calling thread if it's not open
+
+Function: IpcPortEnsureConnected()
+
+    This function connects to the Unix domain socket at
+    <g_rpc_option>.node_url_str, e.g. "/home/user/.ethereum/geth.ipc".
+
+@return
+    This function returns BOAT_SUCCESS if the connection is open. Otherwise it
+    returns an error code.
+
+@param[in] conn_ptr
+    The connection.
+*******************************************************************************/
+static BOAT_RESULT IpcPortEnsureConnected(IpcPortConn *conn_ptr)
+{
+    struct sockaddr_un addr;
+    UINT32 path_len;
+    int socket_fd;
+
+    if( conn_ptr->socket_fd >= 0 ) return BOAT_SUCCESS;
+
+    path_len = strlen(g_rpc_option.node_url_str);
+    if( path_len == 0 || path_len >= sizeof(addr.sun_path) )
+    {
+        BoatLog(BOAT_LOG_NORMAL, "Invalid IPC socket path: %s", g_rpc_option.node_url_str);
+        return BOAT_ERROR_INCOMPATIBLE_ARGUMENTS;
+    }
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    memcpy(addr.sun_path, g_rpc_option.node_url_str, path_len + 1);
+
+    socket_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if( socket_fd < 0 ) return BOAT_ERROR_RPC_FAIL;
+
+    // Connecting a local socket doesn't wait for the peer
+    if( connect(socket_fd, (struct sockaddr *)&addr, sizeof(addr)) != 0 )
+    {
+        BoatLog(BOAT_LOG_NORMAL, "Fail to connect %s with errno %d.", g_rpc_option.node_url_str, errno);
+        close(socket_fd);
+        return BOAT_ERROR_RPC_FAIL;
+    }
+
+    fcntl(socket_fd, F_SETFL, fcntl(socket_fd, F_GETFL, 0) | O_NONBLOCK);
+    fcntl(socket_fd, F_SETFD, FD_CLOEXEC);
+
+    if( conn_ptr->path_str == NULL || strcmp(conn_ptr->path_str, g_rpc_option.node_url_str) != 0 )
+    {
+        if( conn_ptr->path_str != NULL ) BoatFree(conn_ptr->path_str);
+
+        conn_ptr->path_str = BoatMalloc(path_len + 1);
+        if( conn_ptr->path_str == NULL )
+        {
+            close(socket_fd);
+            return BOAT_ERROR_OUT_OF_MEMORY;
+        }
+        memcpy(conn_ptr->path_str, g_rpc_option.node_url_str, path_len + 1);
+    }
+
+    conn_ptr->socket_fd = socket_fd;
+
+    BoatLog(BOAT_LOG_VERBOSE, "IPC connection to %s is open.", g_rpc_option.node_url_str);
+
+    return BOAT_SUCCESS;
+}
+
+
+/*!*****************************************************************************
+@brief Send a REQUEST over IPC without waiting for its RESPONSE.
+
+Function: IpcPortSend()
+
+    This function writes <request_str> and a newline to the connection of the
+    calling thread, opening it if needed. The RESPONSE is taken later with
+    IpcPortRecv() by the "id" of the REQUEST.
+
+
+@return
+    This function returns BOAT_SUCCESS if successful. Otherwise it returns an
+    error code.
+    
+
+@param[in] request_str
+    A pointer to the request string to send.
+
+@param[in] request_len
+    The length of <request_str> excluding NULL terminator.
+
+*******************************************************************************/
+BOAT_RESULT IpcPortSend(const CHAR *request_str, UINT32 request_len)
+{
+    IpcPortConn *conn_ptr;
+    UINT64 deadline_ms;
+    BOAT_RESULT result;
+
+    if( g_rpc_option.node_url_str == NULL || request_str == NULL )
+    {
+        BoatLog(BOAT_LOG_CRITICAL, "Argument cannot be NULL.");
+        return BOAT_ERROR_NULL_POINTER;
+    }
+
+    conn_ptr = IpcPortGetConn();
+    if( conn_ptr == NULL ) return BOAT_ERROR_OUT_OF_MEMORY;
+
+    result = IpcPortEnsureConnected(conn_ptr);
+    if( result != BOAT_SUCCESS ) return result;
+
+    // Timeout of the REQUEST as given by rpcintf
+    deadline_ms = BoatGetTimeMs() + g_rpc_ctx.timeout_ms;
+
+    result = IpcPortSendAll(conn_ptr, (const UINT8 *)request_str, request_len, deadline_ms);
+    if( result == BOAT_SUCCESS )
+    {
+        result = IpcPortSendAll(conn_ptr, (const UINT8 *)"\n", 1, deadline_ms);
+    }
+
+    // A partially sent REQUEST can't be resumed
+    if( result != BOAT_SUCCESS ) IpcPortDisconnect(conn_ptr);
+
+    BoatLog(BOAT_LOG_VERBOSE, "Post: %s", request_str);
+
+    return result;
+}
+
+
+/*!*****************************************************************************
+@brief Wait for the RESPONSE to a REQUEST sent over IPC.
+
+Function: IpcPortRecv()
+
+    This function returns the RESPONSE with the given "id", either kept from
+    an earlier receipt or read from the connection. RESPONSEs to other
+    outstanding REQUESTs and subscription notifications received meanwhile are
+    kept for later.
+
+
+@return
+    This function returns BOAT_SUCCESS if successful, BOAT_ERROR_RPC_TIMEOUT
+    if the RESPONSE doesn't arrive in time, or other error codes.
+    
+
+@param[in] id
+    The "id" of the REQUEST, or -1 to take the next RESPONSE whatever its "id".
+
+@param[in] timeout_ms
+    Max time to wait, in millisecond.
+
+@param[out] response_str_ptr
+    The address of a CHAR* pointer (i.e. a double pointer) to hold the address
+    of the receiving buffer.\n
+    The receiving buffer is internally maintained by ipcport and the caller
+    shall only read from the buffer. DO NOT modify the buffer or save the address
+    for later use.
+
+@param[out] response_len_ptr
+    The address of a UINT32 integer to hold the effective length of
+    <response_str_ptr> excluding NULL terminator.
+
+*******************************************************************************/
+BOAT_RESULT IpcPortRecv(SINT64 id,
+                       UINT32 timeout_ms,
+                       BOAT_OUT CHAR **response_str_ptr,
+                       BOAT_OUT UINT32 *response_len_ptr)
+{
+    IpcPortConn *conn_ptr = g_rpc_ctx.ipc_conn_ptr;
+    UINT64 deadline_ms;
+    SINT64 message_id;
+    CHAR *kept_ptr;
+    UINT32 kept_len;
+    BOAT_RESULT result;
+
+    if( response_str_ptr == NULL || response_len_ptr == NULL )
+    {
+        BoatLog(BOAT_LOG_CRITICAL, "Argument cannot be NULL.");
+        return BOAT_ERROR_NULL_POINTER;
+    }
+
+    if( conn_ptr == NULL ) return BOAT_ERROR_RPC_FAIL;
+
+    if( id >= 0 )
+    {
+        kept_ptr = RpcMsgQueueTake(&conn_ptr->responses, id, &kept_len);
+        if( kept_ptr != NULL )
+        {
+            return IpcPortReturnKept(conn_ptr, kept_ptr, kept_len, response_str_ptr, response_len_ptr);
+        }
+    }
+
+    if( conn_ptr->socket_fd < 0 ) return BOAT_ERROR_RPC_FAIL;
+
+    deadline_ms = BoatGetTimeMs() + timeout_ms;
+
+    while( 1 )
+    {
+        result = IpcPortRecvMessage(conn_ptr, deadline_ms);
+        if( result != BOAT_SUCCESS ) return result;
+
+        if( RpcMsgScan(conn_ptr->message.string_ptr, conn_ptr->message.string_len, &message_id) )
+        {
+            RpcMsgQueuePush(&conn_ptr->notifications, conn_ptr->message.string_ptr, conn_ptr->message.string_len, -1);
+        }
+        else if( id < 0 || message_id == id )
+        {
+            break;
+        }
+        else
+        {
+            RpcMsgQueuePush(&conn_ptr->responses, conn_ptr->message.string_ptr, conn_ptr->message.string_len, message_id);
+        }
+    }
+
+    IpcPortReturnMessage(conn_ptr, response_str_ptr, response_len_ptr);
+
+    BoatLog(BOAT_LOG_VERBOSE, "Response: %s", *response_str_ptr);
+
+    return BOAT_SUCCESS;
+}
+
+
+/*!*****************************************************************************
+@brief Send a REQUEST over IPC and wait for its RESPONSE.
+
+Function: IpcPortRequestSync()
+
+    This function sends <request_str> with IpcPortSend() and waits for the
+    RESPONSE with the same "id" with IpcPortRecv().
+
+    If the node has closed the connection since the last request, the
+    connection is re-opened and the REQUEST is sent again once.
+
+
+@return
+    This function returns BOAT_SUCCESS if successful, BOAT_ERROR_RPC_TIMEOUT
+    if no RESPONSE arrives in time, or other error codes.
+    
+
+@param[in] request_str
+    A pointer to the request string to send.
+
+@param[in] request_len
+    The length of <request_str> excluding NULL terminator.
+
+@param[out] response_str_ptr
+    The address of a CHAR* pointer (i.e. a double pointer) to hold the address
+    of the receiving buffer.\n
+    The receiving buffer is internally maintained by ipcport and the caller
+    shall only read from the buffer. DO NOT modify the buffer or save the address
+    for later use.
+
+@param[out] response_len_ptr
+    The address of a UINT32 integer to hold the effective length of
+    <response_str_ptr> excluding NULL terminator.
+
+*******************************************************************************/
+BOAT_RESULT IpcPortRequestSync(const CHAR *request_str,
+                              UINT32 request_len,
+                              BOAT_OUT CHAR **response_str_ptr,
+                              BOAT_OUT UINT32 *response_len_ptr)
+{
+    SINT64 request_id;
+    BOATBOOL is_reused;
+    BOATBOOL is_retried = BOAT_FALSE;
+    BOAT_RESULT result;
+    boat_try_declare;
+
+    if( request_str == NULL || response_str_ptr == NULL || response_len_ptr == NULL )
+    {
+        BoatLog(BOAT_LOG_CRITICAL, "Argument cannot be NULL.");
+        boat_throw(BOAT_ERROR_NULL_POINTER, IpcPortRequestSync_cleanup);
+    }
+
+    RpcMsgScan(request_str, request_len, &request_id);
+
+    while( 1 )
+    {
+        is_reused = g_rpc_ctx.ipc_conn_ptr != NULL && g_rpc_ctx.ipc_conn_ptr->socket_fd >= 0;
+
+        result = IpcPortSend(request_str, request_len);
+        if( result == BOAT_SUCCESS )
+        {
+            result = IpcPortRecv(request_id, g_rpc_ctx.timeout_ms, response_str_ptr, response_len_ptr);
+        }
+
+        if( result == BOAT_SUCCESS ) break;
+
+        // The node may have been restarted
+        if(    result == BOAT_ERROR_RPC_TIMEOUT || result == BOAT_ERROR_NULL_POINTER
+            || !is_reused || is_retried )
+        {
+            boat_throw(result, IpcPortRequestSync_cleanup);
+        }
+
+        is_retried = BOAT_TRUE;
+    }
+
+    result = BOAT_SUCCESS;
+
+
+    // Exceptional Clean Up
+    boat_catch(IpcPortRequestSync_cleanup)
+    {
+        BoatLog(BOAT_LOG_NORMAL, "Exception: %d", boat_exception);
+        result = boat_exception;
+    }
+
+    return result;
+}
+
+
+/*!*****************************************************************************
+@brief Wait for a subscription notification.
+
+Function: IpcPortWaitNotification()
+
+    This function returns the oldest kept subscription notification, or waits
+    for one to arrive on the connection of the calling thread. RESPONSEs
+    received meanwhile are kept for IpcPortRecv().
+
+    The connection must have been opened by a REQUEST, typically eth_subscribe.
+
+
+@return
+    This function returns BOAT_SUCCESS if a notification is received,
+    BOAT_ERROR_RPC_TIMEOUT if none arrives in <timeout_ms>, or other error
+    codes, e.g. BOAT_ERROR_RPC_FAIL if the connection is lost and thus the
+    subscriptions on it.
+    
+
+@param[in] timeout_ms
+    Max time to wait, in millisecond.
+
+@param[out] notification_str_ptr
+    The address of a CHAR* pointer to hold the address of the notification.
+    The buffer is internally maintained by ipcport. It's valid until the next
+    call to ipcport.
+
+@param[out] notification_len_ptr
+    The address of a UINT32 integer to hold the length of the notification
+    excluding NULL terminator.
+
+*******************************************************************************/
+BOAT_RESULT IpcPortWaitNotification(UINT32 timeout_ms,
+                                   BOAT_OUT CHAR **notification_str_ptr,
+                                   BOAT_OUT UINT32 *notification_len_ptr)
+{
+    IpcPortConn *conn_ptr = g_rpc_ctx.ipc_conn_ptr;
+    UINT64 deadline_ms;
+    SINT64 message_id;
+    CHAR *kept_ptr;
+    UINT32 kept_len;
+    BOAT_RESULT result;
+
+    if( notification_str_ptr == NULL || notification_len_ptr == NULL )
+    {
+        BoatLog(BOAT_LOG_CRITICAL, "Argument cannot be NULL.");
+        return BOAT_ERROR_NULL_POINTER;
+    }
+
+    if( conn_ptr == NULL ) return BOAT_ERROR_RPC_FAIL;
+
+    kept_ptr = RpcMsgQueueTake(&conn_ptr->notifications, -1, &kept_len);
+    if( kept_ptr != NULL )
+    {
+        return IpcPortReturnKept(conn_ptr, kept_ptr, kept_len, notification_str_ptr, notification_len_ptr);
+    }
+
+    if( conn_ptr->socket_fd < 0 ) return BOAT_ERROR_RPC_FAIL;
+
+    deadline_ms = BoatGetTimeMs() + timeout_ms;
+
+    while( 1 )
+    {
+        result = IpcPortRecvMessage(conn_ptr, deadline_ms);
+        if( result != BOAT_SUCCESS ) return result;
+
+        if( RpcMsgScan(conn_ptr->message.string_ptr, conn_ptr->message.string_len, &message_id) ) break;
+
+        RpcMsgQueuePush(&conn_ptr->responses, conn_ptr->message.string_ptr, conn_ptr->message.string_len, message_id);
+    }
+
+    IpcPortReturnMessage(conn_ptr, notification_str_ptr, notification_len_ptr);
+
+    return BOAT_SUCCESS;
+}
+
+#endif // end of #if RPC_USE_IPC == 1
@@ -0,0 +1,75 @@
+/******************************************************************************
+Copyright (C) 2018-2019 AITOS.IO
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+of the Software, and to permit persons to whom the Software is furnished to do
+so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+******************************************************************************/
+
+/*!@brief IPC porting header file
+
+@file
+ipcport.h is the header file of IPC (Unix domain socket) porting of RPC.
+
+DO NOT call functions in this file directly. Instead call wrapper functions
+provided by rpcport.
+
+To use IPC porting, RPC_USE_IPC in boatoptions.h must set to 1.
+*/
+
+#ifndef __IPCPORT_H__
+#define __IPCPORT_H__
+
+#if RPC_USE_IPC == 1
+
+#include "wallet/boattypes.h"
+#include "wallet/boatoptions.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+BOAT_RESULT IpcPortInit(void);
+
+void IpcPortDeinit(void);
+
+BOAT_RESULT IpcPortSetOpt(const RpcOption *rpc_option_ptr);
+
+BOAT_RESULT IpcPortSend(const CHAR *request_str, UINT32 request_len);
+
+BOAT_RESULT IpcPortRecv(SINT64 id,
+                       UINT32 timeout_ms,
+                       BOAT_OUT CHAR **response_str_ptr,
+                       BOAT_OUT UINT32 *response_len_ptr);
+
+BOAT_RESULT IpcPortRequestSync(const CHAR *request_str,
+                              UINT32 request_len,
+                              BOAT_OUT CHAR **response_str_ptr,
+                              BOAT_OUT UINT32 *response_len_ptr);
+
+BOAT_RESULT IpcPortWaitNotification(UINT32 timeout_ms,
+                                   BOAT_OUT CHAR **notification_str_ptr,
+                                   BOAT_OUT UINT32 *notification_len_ptr);
+
+
+#ifdef __cplusplus
+}
+#endif /* end of __cplusplus */
+
+#endif // end of #if RPC_USE_IPC == 1
+
+#endif
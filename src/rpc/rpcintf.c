@@ -29,13 +29,66 @@ RPC_USE_XXX macros.
 */
 
 #include "wallet/boattypes.h"
+#include "utilities/utility.h"
 #include "rpc/rpcport.h"
+#include "rpc/rpcmsg.h"
+#include "rpc/rpclimit.h"
+#include "rpc/rpcretry.h"
 
 //!@brief  Context for RPC
-RpcCtx g_rpc_ctx;
+RPC_THREAD_LOCAL RpcCtx g_rpc_ctx;
 
 //!@brief  Options struct for RPC
-RpcOption g_rpc_option;
+RPC_THREAD_LOCAL RpcOption g_rpc_option;
+
+//!@brief "id" of REQUESTs sent by RpcRequestAsync() whose RESPONSEs are not taken yet
+RPC_THREAD_LOCAL UINT64 g_rpc_inflight_id[BOAT_RPC_PIPELINE_DEPTH];
+RPC_THREAD_LOCAL RpcLimitTicket g_rpc_inflight_ticket[BOAT_RPC_PIPELINE_DEPTH];
+RPC_THREAD_LOCAL UINT32 g_rpc_inflight_num;
+
+#if BOAT_RPC_PIPELINE_DEPTH > RPC_MSG_QUEUE_LEN
+#error "BOAT_RPC_PIPELINE_DEPTH must not exceed RPC_MSG_QUEUE_LEN"
+#endif
+
+//!Node whose limits apply to REQUESTs, NULL for no limits without a node URL
+#if RPC_OPTION_HAS_NODE_URL
+#define RPC_LIMIT_NODE_URL (g_rpc_option.node_url_str)
+#else
+#define RPC_LIMIT_NODE_URL NULL
+#endif
+
+
+/*!*****************************************************************************
+@brief Get when a REQUEST times out
+
+Function: RpcGetRequestDeadline()
+
+@return
+    This function returns <timeout_ms> from now, or the deadline set by
+    RpcSetDeadline() if it's earlier, as per BoatGetTimeMs().
+
+@param[in] timeout_ms
+    Timeout of the REQUEST.
+*******************************************************************************/
+static UINT64 RpcGetRequestDeadline(UINT32 timeout_ms)
+{
+    UINT64 deadline_ms = BoatGetTimeMs() + timeout_ms;
+
+    if( g_rpc_ctx.deadline_ms != 0 && g_rpc_ctx.deadline_ms < deadline_ms )
+    {
+        deadline_ms = g_rpc_ctx.deadline_ms;
+    }
+
+    return deadline_ms;
+}
+
+
+static UINT32 RpcGetTimeLeft(UINT64 deadline_ms)
+{
+    UINT64 now_ms = BoatGetTimeMs();
+
+    return now_ms < deadline_ms ? (UINT32)(deadline_ms - now_ms) : 0;
+}
 
 
 /*!*****************************************************************************
@@ -63,6 +116,14 @@ BOAT_RESULT RpcInit(void)
     result = CurlPortInit();
 #endif
 
+#if RPC_USE_WEBSOCKET == 1
+    result = WsPortInit();
+#endif
+
+#if RPC_USE_IPC == 1
+    result = IpcPortInit();
+#endif
+
     return result;
 
 }
@@ -91,6 +152,14 @@ void RpcDeinit(void)
     CurlPortDeinit();
 #endif
 
+#if RPC_USE_WEBSOCKET == 1
+    WsPortDeinit();
+#endif
+
+#if RPC_USE_IPC == 1
+    IpcPortDeinit();
+#endif
+
     return;
 }
 
@@ -124,10 +193,114 @@ BOAT_RESULT RpcSetOpt(const RpcOption *rpc_option_ptr)
     result = CurlPortSetOpt(&g_rpc_option);
 #endif
 
+#if RPC_USE_WEBSOCKET == 1
+    result = WsPortSetOpt(&g_rpc_option);
+#endif
+
+#if RPC_USE_IPC == 1
+    result = IpcPortSetOpt(&g_rpc_option);
+#endif
+
     return result;
 }
 
 
+/*!******************************************************************************
+@brief Set the deadline of REQUESTs of the calling thread.
+
+Function: RpcSetDeadline()
+
+    This function bounds the time of all following REQUESTs of the calling
+    thread, including retries and waits for RESPONSEs, so that an operation
+    made of several REQUESTs fits in an overall budget. Each REQUEST still
+    times out after BOAT_RPC_TIMEOUT_MS or BOAT_RPC_TIMEOUT_SHORT_MS if that
+    comes first. REQUESTs made after the deadline fail at once with
+    BOAT_ERROR_RPC_TIMEOUT.
+
+    For example, to send a transaction and wait for it being mined in 5s:
+        prev_deadline_ms = RpcSetDeadline(BoatGetTimeMs() + 5000);
+        result = BoatTxSend();
+        RpcSetDeadline(prev_deadline_ms);
+
+
+@return
+    This function returns the previous deadline.
+
+
+@param[in] deadline_ms
+        The deadline as per BoatGetTimeMs(), or 0 for no deadline.
+
+*******************************************************************************/
+UINT64 RpcSetDeadline(UINT64 deadline_ms)
+{
+    UINT64 prev_deadline_ms = g_rpc_ctx.deadline_ms;
+
+    g_rpc_ctx.deadline_ms = deadline_ms;
+
+    return prev_deadline_ms;
+}
+
+
+/*!******************************************************************************
+@brief Get the deadline of REQUESTs of the calling thread.
+
+Function: RpcGetDeadline()
+
+
+@return
+    This function returns the deadline set by RpcSetDeadline() as per
+    BoatGetTimeMs(), or 0 if none.
+
+
+@param This function doesn't take any argument.
+
+*******************************************************************************/
+UINT64 RpcGetDeadline(void)
+{
+    return g_rpc_ctx.deadline_ms;
+}
+
+
+/*!******************************************************************************
+@brief Wrapper function to pin the address of a node host.
+
+Function: RpcPinAddress()
+
+    This function makes REQUESTs of all threads to <host_str>:<port> connect
+    to <address_str> without resolving <host_str>, e.g. to skip DNS on the
+    first REQUEST over a cellular link, or where DNS isn't available. The host
+    name is still used for the TLS handshake and the HTTP "Host" HEADER.
+
+    Only RPC_USE_LIBCURL pins addresses. Other resolved addresses are cached
+    for BOAT_CURL_DNS_CACHE_TTL seconds.
+
+
+@return
+    This function returns BOAT_SUCCESS if successful,
+    BOAT_ERROR_INCOMPATIBLE_ARGUMENTS if the RPC mechanism doesn't pin
+    addresses, or the error code returned by the wrapped function.
+
+
+@param[in] host_str
+        The host name as in node URLs, e.g. "node.example.com".
+
+@param[in] port
+        The port as in node URLs, e.g. 8545, or 443 for "https://" without one.
+
+@param[in] address_str
+        The IP address, or comma separated addresses tried in turn.
+
+*******************************************************************************/
+BOAT_RESULT RpcPinAddress(const CHAR *host_str, UINT16 port, const CHAR *address_str)
+{
+#if RPC_USE_LIBCURL == 1
+    return CurlPortPinAddress(host_str, port, address_str);
+#else
+    return BOAT_ERROR_INCOMPATIBLE_ARGUMENTS;
+#endif
+}
+
+
 /*!******************************************************************************
 @brief Wrapper function to perform RPC request and receive its response synchronously.
 
@@ -146,9 +319,20 @@ Function: RpcRequestSync()
     buffer. The caller MUST NOT modify, free the response buffer or save the
     address of the response buffer for later use.
 
+    A REQUEST failed with timeout, HTTP 429, HTTP 5xx or connection failure
+    is attempted again after a backoff delay if its method is safe to retry,
+    see rpcretry.c. Each attempt times out after the timeout of its method or
+    at the deadline set by RpcSetDeadline(), whichever comes first.
+
 
 @return
     This function returns BOAT_SUCCESS if the RPC call is successful.\n
+    It returns BOAT_ERROR_RPC_BUSY if the REQUEST isn't admitted by the client
+    side limits of the node (see rpclimit.c) in time, or immediately if the
+    thread has REQUESTs outstanding by RpcRequestAsync() and the limit is
+    reached. It returns BOAT_ERROR_RPC_UNAVAILABLE at once while the circuit
+    breaker of the node is open, and BOAT_ERROR_RPC_UNTRUSTED without retrying
+    if the certificate of an https:// node can't be verified.\n
     If any error occurs or RPC REQUEST timeouts, it transfers the error code
     returned by the wrapped function.
     
@@ -178,15 +362,418 @@ BOAT_RESULT RpcRequestSync(const UINT8 *request_ptr,
                           BOAT_OUT UINT8 **response_pptr,
                           BOAT_OUT UINT32 *response_len_ptr)
 {
+    RpcLimitTicket ticket;
+    RpcRetryCtx retry_ctx;
+    UINT64 deadline_ms;
     BOAT_RESULT result;
+
+    RpcRetryBegin(&retry_ctx, (const CHAR *)request_ptr, request_len, g_rpc_ctx.deadline_ms);
+
+    do
+    {
+        deadline_ms = RpcGetRequestDeadline(retry_ctx.timeout_ms);
+        if( RpcGetTimeLeft(deadline_ms) == 0 )
+        {
+            BoatLog(BOAT_LOG_NORMAL, "Deadline passed, REQUEST is not sent.");
+            return BOAT_ERROR_RPC_TIMEOUT;
+        }
+
+        // Only wait to be admitted if RESPONSEs freeing the limits aren't left to this thread
+        result = RpcLimitAcquire(RPC_LIMIT_NODE_URL,
+                                 g_rpc_inflight_num == 0 ? RpcGetTimeLeft(deadline_ms) : 0,
+                                 &ticket);
+        if( result != BOAT_SUCCESS ) return result;
+
+        // The port gives up the REQUEST at the deadline
+        g_rpc_ctx.timeout_ms = RpcGetTimeLeft(deadline_ms);
+        if( g_rpc_ctx.timeout_ms == 0 ) g_rpc_ctx.timeout_ms = 1;
+
+#if RPC_USE_LIBCURL == 1
+        result = CurlPortRequestSync((const CHAR *)request_ptr, request_len, (BOAT_OUT CHAR **)response_pptr, response_len_ptr);
+#endif
+
+#if RPC_USE_WEBSOCKET == 1
+        result = WsPortRequestSync((const CHAR *)request_ptr, request_len, (BOAT_OUT CHAR **)response_pptr, response_len_ptr);
+#endif
+
+#if RPC_USE_IPC == 1
+        result = IpcPortRequestSync((const CHAR *)request_ptr, request_len, (BOAT_OUT CHAR **)response_pptr, response_len_ptr);
+#endif
+
+        // A REQUEST cut by the deadline says nothing about the node
+        RpcLimitRelease(&ticket,
+                        result == BOAT_ERROR_RPC_TIMEOUT && deadline_ms == g_rpc_ctx.deadline_ms ? BOAT_ERROR : result);
+    }while( RpcRetryAgain(&retry_ctx, &result, (CHAR **)response_pptr, response_len_ptr) );
+
+    return result;
+}
+
+
+/*!******************************************************************************
+@brief Wrapper function to send an RPC request without waiting for its response.
+
+Function: RpcRequestAsync()
+
+    This function sends a REQUEST and returns at once, so that several
+    REQUESTs could be written back to back over one connection. Their
+    RESPONSEs are then taken with RpcWaitResponse() by the JSON-RPC "id" of
+    each REQUEST, e.g. g_web3_message_id as incremented for the REQUEST. A
+    batch of N REQUESTs thus takes about one round trip instead of N.
+
+    At most BOAT_RPC_PIPELINE_DEPTH REQUESTs of a thread could be outstanding,
+    and fewer if the client side limits of the node (see rpclimit.c) are
+    reached. Then the caller must take a RESPONSE before sending more.
+
+    With RPC_USE_LIBCURL, outstanding REQUESTs are performed concurrently, as
+    streams of one connection with HTTP/2 (see BOAT_CURL_HTTP_VERSION).
+
+    The REQUEST times out as per its method (see rpcretry.c), or at the
+    deadline set by RpcSetDeadline() if it's earlier.
+
+
+@return
+    This function returns BOAT_SUCCESS if the REQUEST is sent.\n
+    It returns BOAT_ERROR_RPC_TIMEOUT if the deadline has passed,
+    BOAT_ERROR_RPC_BUSY if BOAT_RPC_PIPELINE_DEPTH REQUESTs are
+    outstanding or the REQUEST isn't admitted by the client side limits of the
+    node, BOAT_ERROR_RPC_UNAVAILABLE if the circuit breaker of the node is
+    open, BOAT_ERROR_INCOMPATIBLE_ARGUMENTS if the REQUEST has no
+    numeric "id" or one already outstanding, or the error code returned by the
+    wrapped function.
     
+
+@param[in] request_ptr
+        A pointer to the buffer containing RPC REQUEST. It could be reused
+        once this function returns.
+
+@param[in] request_len
+        The length of the RPC REQUEST in bytes.
+        
+*******************************************************************************/
+BOAT_RESULT RpcRequestAsync(const UINT8 *request_ptr, UINT32 request_len)
+{
+    RpcLimitTicket ticket;
+    RpcRetryCtx retry_ctx;
+    SINT64 request_id;
+    UINT64 deadline_ms;
+    UINT32 i;
+    BOAT_RESULT result;
+
+    if( request_ptr == NULL )
+    {
+        BoatLog(BOAT_LOG_CRITICAL, "Argument cannot be NULL.");
+        return BOAT_ERROR_NULL_POINTER;
+    }
+
+    if( g_rpc_inflight_num >= BOAT_RPC_PIPELINE_DEPTH )
+    {
+        BoatLog(BOAT_LOG_VERBOSE, "%u REQUESTs are outstanding.", g_rpc_inflight_num);
+        return BOAT_ERROR_RPC_BUSY;
+    }
+
+    RpcMsgScan((const CHAR *)request_ptr, request_len, &request_id);
+
+    if( request_id < 0 )
+    {
+        BoatLog(BOAT_LOG_NORMAL, "REQUEST without numeric id can't be pipelined.");
+        return BOAT_ERROR_INCOMPATIBLE_ARGUMENTS;
+    }
+
+    for( i = 0; i < g_rpc_inflight_num; i++ )
+    {
+        if( g_rpc_inflight_id[i] == (UINT64)request_id )
+        {
+            BoatLog(BOAT_LOG_NORMAL, "REQUEST of id %lld is already outstanding.", (long long)request_id);
+            return BOAT_ERROR_INCOMPATIBLE_ARGUMENTS;
+        }
+    }
+
+    // Only the timeout of the method is taken, pipelined REQUESTs are not retried
+    RpcRetryBegin(&retry_ctx, (const CHAR *)request_ptr, request_len, g_rpc_ctx.deadline_ms);
+
+    deadline_ms = RpcGetRequestDeadline(retry_ctx.timeout_ms);
+    if( RpcGetTimeLeft(deadline_ms) == 0 )
+    {
+        BoatLog(BOAT_LOG_NORMAL, "Deadline passed, REQUEST is not sent.");
+        return BOAT_ERROR_RPC_TIMEOUT;
+    }
+
+    // Only wait to be admitted if RESPONSEs freeing the limits aren't left to this thread
+    result = RpcLimitAcquire(RPC_LIMIT_NODE_URL,
+                             g_rpc_inflight_num == 0 ? RpcGetTimeLeft(deadline_ms) : 0,
+                             &ticket);
+    if( result != BOAT_SUCCESS ) return result;
+
+    g_rpc_ctx.timeout_ms = RpcGetTimeLeft(deadline_ms);
+    if( g_rpc_ctx.timeout_ms == 0 ) g_rpc_ctx.timeout_ms = 1;
+
 #if RPC_USE_LIBCURL == 1
-    result = CurlPortRequestSync((const CHAR *)request_ptr, request_len, (BOAT_OUT CHAR **)response_pptr, response_len_ptr);
+    result = CurlPortSend((const CHAR *)request_ptr, request_len);
+#endif
+
+#if RPC_USE_WEBSOCKET == 1
+    result = WsPortSend((const CHAR *)request_ptr, request_len);
+#endif
+
+#if RPC_USE_IPC == 1
+    result = IpcPortSend((const CHAR *)request_ptr, request_len);
 #endif
 
+    if( result == BOAT_SUCCESS )
+    {
+        g_rpc_inflight_id[g_rpc_inflight_num] = (UINT64)request_id;
+        g_rpc_inflight_ticket[g_rpc_inflight_num] = ticket;
+        g_rpc_inflight_num++;
+    }
+    else
+    {
+        RpcLimitRelease(&ticket, result);
+    }
+
     return result;
 }
 
 
+/*!******************************************************************************
+@brief Wrapper function to wait for the response to a request sent by RpcRequestAsync().
+
+Function: RpcWaitResponse()
+
+    This function returns the RESPONSE with the given "id", waiting up to
+    <timeout_ms> for it to arrive. RESPONSEs could be taken in any order.
+
+    Once this function returns, the REQUEST is no longer outstanding whether
+    its RESPONSE is received or not. Call it with <timeout_ms> 0 to give up a
+    REQUEST whose RESPONSE is no longer wanted.
+
+    The wait ends at the deadline set by RpcSetDeadline() if it's earlier.
+
+    The caller MUST NOT modify, free the response buffer or save its address
+    for later use.
+
+
+@return
+    This function returns BOAT_SUCCESS if the RESPONSE is received,
+    BOAT_ERROR_RPC_TIMEOUT if it doesn't arrive in time, BOAT_ERROR_RPC_FAIL
+    if no REQUEST of <id> is outstanding, or the error code returned by the
+    wrapped function.
+
+
+@param[in] id
+        The "id" of the REQUEST.
+
+@param[in] timeout_ms
+        Max time to wait, in millisecond.
+
+@param[out] response_pptr
+        The address of a (UINT8 *) pointer to hold the address of the
+        RESPONSE, a NULL terminated string.
+
+@param[out] response_len_ptr
+        The address of a UINT32 to hold the length of the RESPONSE.
+
+*******************************************************************************/
+BOAT_RESULT RpcWaitResponse(UINT64 id,
+                            UINT32 timeout_ms,
+                            BOAT_OUT UINT8 **response_pptr,
+                            BOAT_OUT UINT32 *response_len_ptr)
+{
+    RpcLimitTicket ticket;
+    UINT32 wait_ms = timeout_ms;
+    UINT32 i;
+    BOAT_RESULT result;
+
+    for( i = 0; i < g_rpc_inflight_num; i++ )
+    {
+        if( g_rpc_inflight_id[i] == id ) break;
+    }
+
+    if( i == g_rpc_inflight_num )
+    {
+        BoatLog(BOAT_LOG_NORMAL, "No REQUEST of id %llu is outstanding.", (unsigned long long)id);
+        return BOAT_ERROR_RPC_FAIL;
+    }
+
+    ticket = g_rpc_inflight_ticket[i];
+    g_rpc_inflight_num--;
+    memmove(&g_rpc_inflight_id[i], &g_rpc_inflight_id[i + 1], (g_rpc_inflight_num - i) * sizeof(UINT64));
+    memmove(&g_rpc_inflight_ticket[i], &g_rpc_inflight_ticket[i + 1], (g_rpc_inflight_num - i) * sizeof(RpcLimitTicket));
+
+    if( g_rpc_ctx.deadline_ms != 0 && timeout_ms != 0 )
+    {
+        wait_ms = RpcGetTimeLeft(RpcGetRequestDeadline(timeout_ms));
+    }
+
+#if RPC_USE_LIBCURL == 1
+    result = CurlPortRecv((SINT64)id, wait_ms, (BOAT_OUT CHAR **)response_pptr, response_len_ptr);
+#endif
+
+#if RPC_USE_WEBSOCKET == 1
+    result = WsPortRecv((SINT64)id, wait_ms, (BOAT_OUT CHAR **)response_pptr, response_len_ptr);
+#endif
+
+#if RPC_USE_IPC == 1
+    result = IpcPortRecv((SINT64)id, wait_ms, (BOAT_OUT CHAR **)response_pptr, response_len_ptr);
+#endif
+
+    // A REQUEST given up or cut by the deadline says nothing about the node
+    RpcLimitRelease(&ticket,
+                    timeout_ms == 0 || (result == BOAT_ERROR_RPC_TIMEOUT && wait_ms < timeout_ms) ? BOAT_ERROR : result);
+
+    // RESPONSEs to the other outstanding REQUESTs are lost with the connection
+    if( result != BOAT_SUCCESS && result != BOAT_ERROR_RPC_TIMEOUT )
+    {
+        for( i = 0; i < g_rpc_inflight_num; i++ )
+        {
+            RpcLimitRelease(&g_rpc_inflight_ticket[i], BOAT_ERROR);
+        }
+        g_rpc_inflight_num = 0;
+    }
+
+    return result;
+}
+
+
+/*!******************************************************************************
+@brief Wrapper function to get byte counts of REQUESTs and RESPONSEs.
+
+Function: RpcGetByteStats()
+
+    This function reports how many bytes of REQUEST and RESPONSE bodies the
+    calling thread has exchanged with the node, before and after compression
+    (see BOAT_CURL_ACCEPT_ENCODING and BOAT_CURL_COMPRESS_REQUEST). A REQUEST is
+    counted when its RESPONSE is taken.
+
+    Only RPC_USE_LIBCURL counts bytes. With other RPC mechanisms, all counts
+    are 0.
+
+
+@return
+    This function doesn't return any value.
+
+
+@param[out] last_ptr
+        Byte counts of the last REQUEST. It may be NULL.
+
+@param[out] total_ptr
+        Byte counts of all REQUESTs of the thread. It may be NULL.
+
+*******************************************************************************/
+void RpcGetByteStats(BOAT_OUT RpcByteStats *last_ptr, BOAT_OUT RpcByteStats *total_ptr)
+{
+#if RPC_USE_LIBCURL == 1
+    CurlPortGetByteStats(last_ptr, total_ptr);
+#else
+    if( last_ptr != NULL ) memset(last_ptr, 0, sizeof(RpcByteStats));
+    if( total_ptr != NULL ) memset(total_ptr, 0, sizeof(RpcByteStats));
+#endif
+}
+
+/*!******************************************************************************
+@brief Get client side limits of REQUESTs to the node and their statistics.
+
+Function: RpcGetLimitStats()
+
+    This function reports the rate limiter, adaptive concurrency limit and
+    circuit breaker (see rpclimit.c) of the node set by RpcSetOpt() in the
+    calling thread. They're shared by all threads talking to the node.
+
+
+@return
+    This function doesn't return any value.
+
+
+@param[out] stats_ptr
+        The limits and statistics.
+
+*******************************************************************************/
+void RpcGetLimitStats(BOAT_OUT RpcLimitStats *stats_ptr)
+{
+    if( stats_ptr == NULL ) return;
+
+    RpcLimitGetStats(RPC_LIMIT_NODE_URL, stats_ptr);
+}
+
+
+/*!******************************************************************************
+@brief Get statistics of REQUESTs retried by RpcRequestSync().
+
+Function: RpcGetRetryStats()
+
+    This function reports how many REQUESTs of all threads are retried and how
+    they end, see rpcretry.c. Trips of the circuit breaker of a node are
+    reported by RpcGetLimitStats().
+
+
+@return
+    This function doesn't return any value.
+
+
+@param[out] stats_ptr
+        The statistics.
+
+*******************************************************************************/
+void RpcGetRetryStats(BOAT_OUT RpcRetryStats *stats_ptr)
+{
+    if( stats_ptr == NULL ) return;
+
+    RpcRetryGetStats(stats_ptr);
+}
+
+
+#if RPC_SUPPORT_NOTIFICATION
+/*!******************************************************************************
+@brief Wrapper function to wait for a subscription notification.
+
+Function: RpcWaitNotification()
+
+    This function returns the next notification pushed by the node for a
+    subscription made with eth_subscribe, waiting up to <timeout_ms> for one
+    to arrive. Notifications received while waiting for a RESPONSE in
+    RpcRequestSync() are queued and returned first.
+
+    It's only available with an RPC mechanism keeping a connection open, i.e.
+    RPC_USE_WEBSOCKET or RPC_USE_IPC.
+
+    The caller MUST NOT modify, free the notification buffer or save its
+    address for later use.
+
+
+@return
+    This function returns BOAT_SUCCESS if a notification is received,
+    BOAT_ERROR_RPC_TIMEOUT if none arrives in time, or the error code returned
+    by the wrapped function.
+
+
+@param[in] timeout_ms
+        Max time to wait, in millisecond.
+
+@param[out] notification_pptr
+        The address of a (UINT8 *) pointer to hold the address of the
+        notification, a NULL terminated string.
+
+@param[out] notification_len_ptr
+        The address of a UINT32 to hold the length of the notification.
+
+*******************************************************************************/
+BOAT_RESULT RpcWaitNotification(UINT32 timeout_ms,
+                                BOAT_OUT UINT8 **notification_pptr,
+                                BOAT_OUT UINT32 *notification_len_ptr)
+{
+    BOAT_RESULT result;
+
+#if RPC_USE_WEBSOCKET == 1
+    result = WsPortWaitNotification(timeout_ms, (BOAT_OUT CHAR **)notification_pptr, notification_len_ptr);
+#endif
+
+#if RPC_USE_IPC == 1
+    result = IpcPortWaitNotification(timeout_ms, (BOAT_OUT CHAR **)notification_pptr, notification_len_ptr);
+#endif
+
+    return result;
+}
+#endif
+
+
 
 
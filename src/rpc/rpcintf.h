@@ -40,8 +40,16 @@ RPC_USE_XXX macros.
 //!@brief Context for RPC
 typedef struct TRpcCtx
 {
+    UINT64 deadline_ms;     //!< Deadline of REQUESTs as per BoatGetTimeMs(), 0 for none, see RpcSetDeadline()
+    UINT32 timeout_ms;      //!< Timeout of the REQUEST being sent, set by rpcintf for the port
 #if RPC_USE_LIBCURL == 1
-    CURL *curl_ctx_ptr;     //!< CURL pointer returned by curl_easy_init()
+    struct TCurlPortEngine *curl_engine_ptr;    //!< Engine performing REQUESTs of the thread, see curlport.c
+#endif
+#if RPC_USE_WEBSOCKET == 1
+    struct TWsPortConn *ws_conn_ptr;    //!< Persistent connection of the thread, see wsport.c
+#endif
+#if RPC_USE_IPC == 1
+    struct TIpcPortConn *ipc_conn_ptr;  //!< Persistent connection of the thread, see ipcport.c
 #endif
 }RpcCtx;
 
@@ -51,8 +59,56 @@ typedef struct TRpcOption
 #if RPC_USE_LIBCURL == 1
     const CHAR *node_url_str;   //!< The URL of blockchain node, in a form of "http://a.b.com:7545"
 #endif
+#if RPC_USE_WEBSOCKET == 1
+    const CHAR *node_url_str;   //!< The URL of blockchain node, in a form of "ws://a.b.com:8546"
+#endif
+#if RPC_USE_IPC == 1
+    const CHAR *node_url_str;   //!< The path of blockchain node's IPC socket, e.g. "/home/user/.ethereum/geth.ipc"
+#endif
 }RpcOption;
 
+//!@brief Byte counts of RPC REQUESTs and RESPONSEs, excluding protocol HEADERs
+typedef struct TRpcByteStats
+{
+    UINT64 request_bytes;       //!< REQUEST bodies
+    UINT64 request_wire_bytes;  //!< REQUEST bodies as sent, after compression
+    UINT64 response_bytes;      //!< RESPONSE bodies
+    UINT64 response_wire_bytes; //!< RESPONSE bodies as received, before decompression
+}RpcByteStats;
+
+//!@brief State of the circuit breaker of a node
+typedef enum
+{
+    RPC_BREAKER_CLOSED = 0,     //!< REQUESTs are sent to the node
+    RPC_BREAKER_OPEN,           //!< REQUESTs fail with BOAT_ERROR_RPC_UNAVAILABLE
+    RPC_BREAKER_HALF_OPEN       //!< One REQUEST probes whether the node is back
+}RPC_BREAKER_STATE;
+
+//!@brief Client side limits of REQUESTs to a node and their statistics
+typedef struct TRpcLimitStats
+{
+    double concurrency_limit;   //!< Current limit of outstanding REQUESTs
+    UINT32 inflight_num;        //!< Outstanding REQUESTs
+    double tokens;              //!< Tokens in the rate limiter bucket
+    UINT64 admitted_num;        //!< REQUESTs admitted
+    UINT64 delayed_num;         //!< REQUESTs admitted or refused after waiting
+    UINT64 rejected_num;        //!< REQUESTs refused with BOAT_ERROR_RPC_BUSY
+    UINT64 congestion_num;      //!< REQUESTs failed with HTTP 429, HTTP 5xx or timeout
+    UINT64 backoff_num;         //!< Times the concurrency limit is halved
+    RPC_BREAKER_STATE breaker_state;    //!< State of the circuit breaker
+    UINT64 trip_num;            //!< Times the circuit breaker is opened
+    UINT64 short_circuit_num;   //!< REQUESTs refused with BOAT_ERROR_RPC_UNAVAILABLE
+}RpcLimitStats;
+
+//!@brief Statistics of REQUESTs retried by RpcRequestSync()
+typedef struct TRpcRetryStats
+{
+    UINT64 retry_num;           //!< Retries
+    UINT64 recovered_num;       //!< REQUESTs succeeded after retries
+    UINT64 giveup_num;          //!< REQUESTs failed after all attempts
+    UINT64 dedup_num;           //!< Transactions found already known by the node on a retry
+}RpcRetryStats;
+
 
 
 #ifdef __cplusplus
@@ -65,11 +121,36 @@ void RpcDeinit(void);
 
 BOAT_RESULT RpcSetOpt(const RpcOption *rpc_option_ptr);
 
+UINT64 RpcSetDeadline(UINT64 deadline_ms);
+
+UINT64 RpcGetDeadline(void);
+
+BOAT_RESULT RpcPinAddress(const CHAR *host_str, UINT16 port, const CHAR *address_str);
+
 BOAT_RESULT RpcRequestSync(const UINT8 *request_ptr,
                           UINT32 request_len,
                           BOAT_OUT UINT8 **response_pptr,
                           BOAT_OUT UINT32 *response_len_ptr);
 
+BOAT_RESULT RpcRequestAsync(const UINT8 *request_ptr, UINT32 request_len);
+
+BOAT_RESULT RpcWaitResponse(UINT64 id,
+                            UINT32 timeout_ms,
+                            BOAT_OUT UINT8 **response_pptr,
+                            BOAT_OUT UINT32 *response_len_ptr);
+
+void RpcGetByteStats(BOAT_OUT RpcByteStats *last_ptr, BOAT_OUT RpcByteStats *total_ptr);
+
+void RpcGetLimitStats(BOAT_OUT RpcLimitStats *stats_ptr);
+
+void RpcGetRetryStats(BOAT_OUT RpcRetryStats *stats_ptr);
+
+#if RPC_SUPPORT_NOTIFICATION
+BOAT_RESULT RpcWaitNotification(UINT32 timeout_ms,
+                                BOAT_OUT UINT8 **notification_pptr,
+                                BOAT_OUT UINT32 *notification_len_ptr);
+#endif
+
 #ifdef __cplusplus
 }
 #endif /* end of __cplusplus */
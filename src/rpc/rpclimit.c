@@ -0,0 +1,504 @@
+/******************************************************************************
+Copyright (C) 2018-2019 AITOS.IO
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+of the Software, and to permit persons to whom the Software is furnished to do
+so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+******************************************************************************/
+
+/*!@brief Client side limits of RPC REQUESTs
+
+@file
+rpclimit.c limits REQUESTs to each node, so that throughput stays at what the
+node accepts instead of alternating between bursts and throttling errors.
+
+A token bucket refilled at BOAT_RPC_RATE_LIMIT REQUESTs per second, up to
+BOAT_RPC_RATE_BURST tokens, limits the rate of REQUESTs. The number of
+outstanding REQUESTs is limited by a window adapted the way TCP adapts its
+congestion window (AIMD): it grows by about 1 for each window of successful
+REQUESTs, and is halved when a REQUEST fails with HTTP 429, HTTP 5xx or
+timeout. REQUESTs admitted before a cut don't cut the window again.
+
+A circuit breaker stops REQUESTs to a node failing BOAT_RPC_BREAKER_THRESHOLD
+REQUESTs in a row with timeout, HTTP 5xx or connection failure, so that callers
+fail fast instead of each waiting for a timeout. After BOAT_RPC_BREAKER_OPEN_MS,
+one REQUEST probes the node and the breaker closes once any REQUEST gets an
+answer from the node.
+
+Limits are shared by all threads talking to the same node URL.
+*/
+
+// For pthread_condattr_setclock()
+#define _DEFAULT_SOURCE
+
+#include "wallet/boattypes.h"
+#include "utilities/utility.h"
+#include "rpc/rpclimit.h"
+
+#include <pthread.h>
+#include <time.h>
+
+//!@brief Limits of a node
+typedef struct TRpcLimitNode
+{
+    CHAR *node_url_str;         //!< Copy of the node URL, NULL if the entry is free
+    double tokens;              //!< Tokens in the bucket
+    UINT64 refilled_ms;         //!< When the bucket was last refilled, as per BoatGetTimeMs()
+    double concurrency_limit;   //!< Max outstanding REQUESTs
+    UINT32 inflight_num;        //!< Outstanding REQUESTs
+    UINT32 epoch;               //!< Incremented each time <concurrency_limit> is cut
+    UINT64 used_ms;             //!< When a REQUEST was last admitted
+    RPC_BREAKER_STATE breaker_state;    //!< State of the circuit breaker
+    UINT32 failure_num;         //!< REQUESTs failed in a row
+    UINT64 opened_ms;           //!< When the circuit breaker was last opened
+    BOATBOOL is_probing;        //!< Whether a probing REQUEST is outstanding
+    RpcLimitStats stats;        //!< Counters reported by RpcLimitGetStats()
+}RpcLimitNode;
+
+static RpcLimitNode g_rpclimit_node[BOAT_RPC_LIMIT_NODE_NUM];
+static pthread_mutex_t g_rpclimit_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t g_rpclimit_cond;
+static pthread_once_t g_rpclimit_cond_once = PTHREAD_ONCE_INIT;
+
+
+static void RpcLimitInitCond(void)
+{
+    pthread_condattr_t cond_attr;
+
+    // Deadlines are given by BoatGetTimeMs()
+    pthread_condattr_init(&cond_attr);
+    pthread_condattr_setclock(&cond_attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&g_rpclimit_cond, &cond_attr);
+    pthread_condattr_destroy(&cond_attr);
+}
+
+
+/*!*****************************************************************************
+@brief Find the limits of a node, or create them
+
+Function: RpcLimitFindNodeLocked()
+
+    If the node table is full, the entry of the least recently used node
+    without outstanding REQUESTs is reused.
+
+@return
+    This function returns the index of the node in the node table, or -1 if
+    the table is full of nodes with outstanding REQUESTs.
+
+@param[in] node_url_str
+    The node URL.
+
+@param[in] now_ms
+    The current time as per BoatGetTimeMs().
+*******************************************************************************/
+static SINT32 RpcLimitFindNodeLocked(const CHAR *node_url_str, UINT64 now_ms)
+{
+    RpcLimitNode *node_ptr;
+    CHAR *url_copy_str;
+    SINT32 free_index = -1;
+    SINT32 i;
+
+    for( i = 0; i < BOAT_RPC_LIMIT_NODE_NUM; i++ )
+    {
+        node_ptr = &g_rpclimit_node[i];
+
+        if( node_ptr->node_url_str != NULL && strcmp(node_ptr->node_url_str, node_url_str) == 0 )
+        {
+            return i;
+        }
+
+        if( node_ptr->inflight_num == 0
+           && (free_index < 0
+               || node_ptr->node_url_str == NULL
+               || (g_rpclimit_node[free_index].node_url_str != NULL
+                   && node_ptr->used_ms < g_rpclimit_node[free_index].used_ms)) )
+        {
+            free_index = i;
+        }
+    }
+
+    if( free_index < 0 ) return -1;
+
+    url_copy_str = BoatMalloc(strlen(node_url_str) + 1);
+    if( url_copy_str == NULL ) return -1;
+    strcpy(url_copy_str, node_url_str);
+
+    node_ptr = &g_rpclimit_node[free_index];
+    if( node_ptr->node_url_str != NULL ) BoatFree(node_ptr->node_url_str);
+
+    memset(node_ptr, 0, sizeof(RpcLimitNode));
+    node_ptr->node_url_str = url_copy_str;
+    node_ptr->tokens = BOAT_RPC_RATE_BURST;
+    node_ptr->refilled_ms = now_ms;
+    node_ptr->concurrency_limit = BOAT_RPC_CONCURRENCY_INIT;
+
+    return free_index;
+}
+
+
+static void RpcLimitRefillLocked(RpcLimitNode *node_ptr, UINT64 now_ms)
+{
+#if BOAT_RPC_RATE_LIMIT != 0
+    node_ptr->tokens += (double)(now_ms - node_ptr->refilled_ms) * BOAT_RPC_RATE_LIMIT / 1000.0;
+    if( node_ptr->tokens > BOAT_RPC_RATE_BURST ) node_ptr->tokens = BOAT_RPC_RATE_BURST;
+#endif
+    node_ptr->refilled_ms = now_ms;
+}
+
+
+#if BOAT_RPC_BREAKER_THRESHOLD != 0
+/*!*****************************************************************************
+@brief Check the circuit breaker of a node for a REQUEST
+
+Function: RpcLimitBreakerAdmitLocked()
+
+    An open breaker refuses REQUESTs until BOAT_RPC_BREAKER_OPEN_MS has passed
+    since it was opened. Then it's half open and lets one probing REQUEST at a
+    time through.
+
+@return
+    This function returns BOAT_TRUE if the REQUEST could be sent.
+
+@param[in] node_ptr
+    The node.
+
+@param[in] now_ms
+    The current time as per BoatGetTimeMs().
+
+@param[out] is_probe_ptr
+    Whether the REQUEST is the probe of a half open breaker.
+*******************************************************************************/
+static BOATBOOL RpcLimitBreakerAdmitLocked(RpcLimitNode *node_ptr, UINT64 now_ms, BOAT_OUT BOATBOOL *is_probe_ptr)
+{
+    *is_probe_ptr = BOAT_FALSE;
+
+    if( node_ptr->breaker_state == RPC_BREAKER_CLOSED ) return BOAT_TRUE;
+
+    if(    node_ptr->breaker_state == RPC_BREAKER_OPEN
+        && now_ms - node_ptr->opened_ms >= BOAT_RPC_BREAKER_OPEN_MS )
+    {
+        node_ptr->breaker_state = RPC_BREAKER_HALF_OPEN;
+    }
+
+    if( node_ptr->breaker_state == RPC_BREAKER_HALF_OPEN && !node_ptr->is_probing )
+    {
+        node_ptr->is_probing = BOAT_TRUE;
+        *is_probe_ptr = BOAT_TRUE;
+        return BOAT_TRUE;
+    }
+
+    return BOAT_FALSE;
+}
+#endif
+
+
+/*!*****************************************************************************
+@brief Admit a REQUEST to a node
+
+Function: RpcLimitAcquire()
+
+    This function admits a REQUEST if the node has a token and fewer
+    outstanding REQUESTs than its concurrency limit. Otherwise it waits up to
+    <wait_ms>. Each admitted REQUEST must be released by RpcLimitRelease().
+
+@return
+    This function returns BOAT_SUCCESS if the REQUEST is admitted,
+    BOAT_ERROR_RPC_UNAVAILABLE if the circuit breaker of the node is open, or
+    BOAT_ERROR_RPC_BUSY.
+
+@param[in] node_url_str
+    The node URL. REQUESTs are not limited if it's NULL.
+
+@param[in] wait_ms
+    Max time to wait for the REQUEST to be admitted, in millisecond. A thread
+    with outstanding REQUESTs must not wait since only it could take their
+    RESPONSEs.
+
+@param[out] ticket_ptr
+    The ticket to pass to RpcLimitRelease().
+*******************************************************************************/
+BOAT_RESULT RpcLimitAcquire(const CHAR *node_url_str,
+                            UINT32 wait_ms,
+                            BOAT_OUT RpcLimitTicket *ticket_ptr)
+{
+    RpcLimitNode *node_ptr;
+    struct timespec deadline;
+    BOATBOOL is_delayed = BOAT_FALSE;
+    BOATBOOL is_probe = BOAT_FALSE;
+    UINT64 now_ms;
+    UINT64 deadline_ms;
+    UINT64 wait_until_ms;
+    SINT32 node_index;
+
+    ticket_ptr->node_index = -1;
+    ticket_ptr->epoch = 0;
+    ticket_ptr->is_probe = BOAT_FALSE;
+
+    if( node_url_str == NULL ) return BOAT_SUCCESS;
+
+    pthread_once(&g_rpclimit_cond_once, RpcLimitInitCond);
+    pthread_mutex_lock(&g_rpclimit_mutex);
+
+    now_ms = BoatGetTimeMs();
+    deadline_ms = now_ms + wait_ms;
+
+    node_index = RpcLimitFindNodeLocked(node_url_str, now_ms);
+    if( node_index < 0 )
+    {
+        pthread_mutex_unlock(&g_rpclimit_mutex);
+        BoatLog(BOAT_LOG_VERBOSE, "Too many nodes, REQUEST to %s is not limited.", node_url_str);
+        return BOAT_SUCCESS;
+    }
+    node_ptr = &g_rpclimit_node[node_index];
+
+    while( 1 )
+    {
+        RpcLimitRefillLocked(node_ptr, now_ms);
+
+        if( node_ptr->inflight_num < (UINT32)node_ptr->concurrency_limit
+#if BOAT_RPC_RATE_LIMIT != 0
+           && node_ptr->tokens >= 1.0
+#endif
+          )
+        {
+            break;
+        }
+
+        if( now_ms >= deadline_ms )
+        {
+            node_ptr->stats.rejected_num++;
+            pthread_mutex_unlock(&g_rpclimit_mutex);
+            BoatLog(BOAT_LOG_VERBOSE, "REQUEST to %s is not admitted, %u outstanding.",
+                    node_url_str, node_ptr->inflight_num);
+            return BOAT_ERROR_RPC_BUSY;
+        }
+
+        if( !is_delayed )
+        {
+            node_ptr->stats.delayed_num++;
+            is_delayed = BOAT_TRUE;
+        }
+
+        // Wait for a REQUEST to complete, or for the next token
+        wait_until_ms = deadline_ms;
+#if BOAT_RPC_RATE_LIMIT != 0
+        if( node_ptr->inflight_num < (UINT32)node_ptr->concurrency_limit )
+        {
+            wait_until_ms = now_ms + (UINT64)((1.0 - node_ptr->tokens) * 1000.0 / BOAT_RPC_RATE_LIMIT) + 1;
+            if( wait_until_ms > deadline_ms ) wait_until_ms = deadline_ms;
+        }
+#endif
+        deadline.tv_sec = wait_until_ms / 1000u;
+        deadline.tv_nsec = (wait_until_ms % 1000u) * 1000000u;
+        pthread_cond_timedwait(&g_rpclimit_cond, &g_rpclimit_mutex, &deadline);
+
+        now_ms = BoatGetTimeMs();
+    }
+
+#if BOAT_RPC_BREAKER_THRESHOLD != 0
+    if( !RpcLimitBreakerAdmitLocked(node_ptr, now_ms, &is_probe) )
+    {
+        node_ptr->stats.short_circuit_num++;
+        pthread_mutex_unlock(&g_rpclimit_mutex);
+        BoatLog(BOAT_LOG_VERBOSE, "Node %s is unavailable.", node_url_str);
+        return BOAT_ERROR_RPC_UNAVAILABLE;
+    }
+#endif
+
+#if BOAT_RPC_RATE_LIMIT != 0
+    node_ptr->tokens -= 1.0;
+#endif
+    node_ptr->inflight_num++;
+    node_ptr->used_ms = now_ms;
+    node_ptr->stats.admitted_num++;
+
+    ticket_ptr->node_index = node_index;
+    ticket_ptr->epoch = node_ptr->epoch;
+    ticket_ptr->is_probe = is_probe;
+
+    pthread_mutex_unlock(&g_rpclimit_mutex);
+
+    return BOAT_SUCCESS;
+}
+
+
+#if BOAT_RPC_BREAKER_THRESHOLD != 0
+static void RpcLimitBreakerReleaseLocked(RpcLimitNode *node_ptr,
+                                         const RpcLimitTicket *ticket_ptr,
+                                         BOAT_RESULT result)
+{
+    if( ticket_ptr->is_probe ) node_ptr->is_probing = BOAT_FALSE;
+
+    if(    result == BOAT_ERROR_RPC_TIMEOUT
+        || result == BOAT_ERROR_RPC_SERVER
+        || result == BOAT_ERROR_RPC_FAIL
+        || result == BOAT_ERROR_RPC_UNTRUSTED
+        || result == BOAT_ERROR_EXT_MODULE_OPERATION_FAIL )
+    {
+        node_ptr->failure_num++;
+
+        if(    ticket_ptr->is_probe
+            || (node_ptr->breaker_state == RPC_BREAKER_CLOSED
+                && node_ptr->failure_num >= BOAT_RPC_BREAKER_THRESHOLD) )
+        {
+            node_ptr->breaker_state = RPC_BREAKER_OPEN;
+            node_ptr->opened_ms = BoatGetTimeMs();
+            node_ptr->stats.trip_num++;
+
+            BoatLog(BOAT_LOG_NORMAL, "Node %s failed %u REQUESTs in a row (%d), stop sending for %u ms.",
+                    node_ptr->node_url_str, node_ptr->failure_num, result, (UINT32)BOAT_RPC_BREAKER_OPEN_MS);
+        }
+    }
+    else if( result != BOAT_ERROR )
+    {
+        // The node answered, even if with an error
+        node_ptr->failure_num = 0;
+
+        if( node_ptr->breaker_state != RPC_BREAKER_CLOSED )
+        {
+            node_ptr->breaker_state = RPC_BREAKER_CLOSED;
+            BoatLog(BOAT_LOG_NORMAL, "Node %s is available again.", node_ptr->node_url_str);
+        }
+    }
+}
+#endif
+
+
+/*!*****************************************************************************
+@brief Release a REQUEST admitted by RpcLimitAcquire()
+
+Function: RpcLimitRelease()
+
+    The concurrency limit of the node grows if the REQUEST succeeded, and is
+    halved if it failed with BOAT_ERROR_RPC_THROTTLED, BOAT_ERROR_RPC_SERVER
+    or BOAT_ERROR_RPC_TIMEOUT. A throttled REQUEST also empties the token
+    bucket. Other results leave the limits as they are.
+
+    The circuit breaker of the node opens once BOAT_RPC_BREAKER_THRESHOLD
+    REQUESTs in a row fail with BOAT_ERROR_RPC_TIMEOUT, BOAT_ERROR_RPC_SERVER,
+    BOAT_ERROR_RPC_FAIL, BOAT_ERROR_RPC_UNTRUSTED or
+    BOAT_ERROR_EXT_MODULE_OPERATION_FAIL, or its probe does. A node failing TLS
+    verification hasn't answered, so it doesn't close the breaker. Any other
+    result but BOAT_ERROR closes it.
+
+@return This function doesn't return any value.
+
+@param[in] ticket_ptr
+    The ticket given by RpcLimitAcquire().
+
+@param[in] result
+    Result of the REQUEST.
+*******************************************************************************/
+void RpcLimitRelease(const RpcLimitTicket *ticket_ptr, BOAT_RESULT result)
+{
+    RpcLimitNode *node_ptr;
+
+    if( ticket_ptr->node_index < 0 ) return;
+
+    pthread_mutex_lock(&g_rpclimit_mutex);
+
+    node_ptr = &g_rpclimit_node[ticket_ptr->node_index];
+    node_ptr->inflight_num--;
+
+#if BOAT_RPC_BREAKER_THRESHOLD != 0
+    RpcLimitBreakerReleaseLocked(node_ptr, ticket_ptr, result);
+#endif
+
+    if( result == BOAT_SUCCESS )
+    {
+        node_ptr->concurrency_limit += 1.0 / node_ptr->concurrency_limit;
+        if( node_ptr->concurrency_limit > BOAT_RPC_CONCURRENCY_MAX )
+        {
+            node_ptr->concurrency_limit = BOAT_RPC_CONCURRENCY_MAX;
+        }
+    }
+    else if( result == BOAT_ERROR_RPC_THROTTLED
+            || result == BOAT_ERROR_RPC_SERVER
+            || result == BOAT_ERROR_RPC_TIMEOUT )
+    {
+        node_ptr->stats.congestion_num++;
+
+        // Only the first failure after the last cut cuts again
+        if( ticket_ptr->epoch == node_ptr->epoch )
+        {
+            node_ptr->concurrency_limit /= 2.0;
+            if( node_ptr->concurrency_limit < BOAT_RPC_CONCURRENCY_MIN )
+            {
+                node_ptr->concurrency_limit = BOAT_RPC_CONCURRENCY_MIN;
+            }
+            node_ptr->epoch++;
+            node_ptr->stats.backoff_num++;
+
+            BoatLog(BOAT_LOG_NORMAL, "Node %s is congested (%d), limit to %u outstanding REQUESTs.",
+                    node_ptr->node_url_str, result, (UINT32)node_ptr->concurrency_limit);
+        }
+
+#if BOAT_RPC_RATE_LIMIT != 0
+        if( result == BOAT_ERROR_RPC_THROTTLED && node_ptr->tokens > 0.0 )
+        {
+            node_ptr->tokens = 0.0;
+        }
+#endif
+    }
+
+    pthread_cond_broadcast(&g_rpclimit_cond);
+    pthread_mutex_unlock(&g_rpclimit_mutex);
+}
+
+
+/*!*****************************************************************************
+@brief Get the limits and statistics of a node
+
+Function: RpcLimitGetStats()
+
+@return This function doesn't return any value.
+
+@param[in] node_url_str
+    The node URL.
+
+@param[out] stats_ptr
+    The statistics. They're all 0 if no REQUEST has been admitted to the node.
+*******************************************************************************/
+void RpcLimitGetStats(const CHAR *node_url_str, BOAT_OUT RpcLimitStats *stats_ptr)
+{
+    RpcLimitNode *node_ptr;
+    UINT32 i;
+
+    memset(stats_ptr, 0, sizeof(RpcLimitStats));
+    if( node_url_str == NULL ) return;
+
+    pthread_mutex_lock(&g_rpclimit_mutex);
+
+    for( i = 0; i < BOAT_RPC_LIMIT_NODE_NUM; i++ )
+    {
+        node_ptr = &g_rpclimit_node[i];
+
+        if( node_ptr->node_url_str != NULL && strcmp(node_ptr->node_url_str, node_url_str) == 0 )
+        {
+            RpcLimitRefillLocked(node_ptr, BoatGetTimeMs());
+
+            *stats_ptr = node_ptr->stats;
+            stats_ptr->concurrency_limit = node_ptr->concurrency_limit;
+            stats_ptr->inflight_num = node_ptr->inflight_num;
+            stats_ptr->tokens = node_ptr->tokens;
+            stats_ptr->breaker_state = node_ptr->breaker_state;
+            break;
+        }
+    }
+
+    pthread_mutex_unlock(&g_rpclimit_mutex);
+}
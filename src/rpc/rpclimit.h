@@ -0,0 +1,62 @@
+/******************************************************************************
+Copyright (C) 2018-2019 AITOS.IO
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+of the Software, and to permit persons to whom the Software is furnished to do
+so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+******************************************************************************/
+
+/*!@brief Client side limits of RPC REQUESTs header file internally used by RPC
+
+@file
+rpclimit.h is header file of the rate limiter, adaptive concurrency limit and
+circuit breaker applied by rpcintf to REQUESTs to each node. Upper layer should include
+rpcintf.h instead.
+*/
+
+#ifndef __RPCLIMIT_H__
+#define __RPCLIMIT_H__
+
+#include "wallet/boattypes.h"
+#include "rpc/rpcintf.h"
+
+//!@brief A REQUEST admitted by RpcLimitAcquire()
+typedef struct TRpcLimitTicket
+{
+    SINT32 node_index;  //!< Index of the node in the node table, -1 if not limited
+    UINT32 epoch;       //!< Backoff epoch of the node when admitted
+    BOATBOOL is_probe;  //!< Whether the REQUEST probes a node whose circuit breaker is open
+}RpcLimitTicket;
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+BOAT_RESULT RpcLimitAcquire(const CHAR *node_url_str,
+                            UINT32 wait_ms,
+                            BOAT_OUT RpcLimitTicket *ticket_ptr);
+
+void RpcLimitRelease(const RpcLimitTicket *ticket_ptr, BOAT_RESULT result);
+
+void RpcLimitGetStats(const CHAR *node_url_str, BOAT_OUT RpcLimitStats *stats_ptr);
+
+#ifdef __cplusplus
+}
+#endif /* end of __cplusplus */
+
+#endif
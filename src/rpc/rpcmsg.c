@@ -0,0 +1,340 @@
+/******************************************************************************
+Copyright (C) 2018-2019 AITOS.IO
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+of the Software, and to permit persons to whom the Software is furnished to do
+so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+******************************************************************************/
+
+/*!@brief JSON-RPC message helpers for RPC porting
+
+@file
+rpcmsg.c contains helpers shared by RPC Portings that keep a connection open,
+to tell RESPONSEs from subscription notifications and to keep messages that
+arrive before they're asked for.
+*/
+
+#include "wallet/boattypes.h"
+#include "utilities/utility.h"
+#include "rpc/rpcmsg.h"
+
+
+static const CHAR *RpcMsgSkipString(const CHAR *p, const CHAR *end)
+{
+    // <p> points to the opening quote
+    for( p++; p < end && *p != '"'; p++ )
+    {
+        if( *p == '\\' ) p++;
+    }
+
+    return p < end ? p + 1 : end;
+}
+
+
+static const CHAR *RpcMsgSkipValue(const CHAR *p, const CHAR *end)
+{
+    UINT32 depth = 0;
+
+    while( p < end )
+    {
+        if( *p == '"' )
+        {
+            p = RpcMsgSkipString(p, end);
+            continue;
+        }
+
+        if( *p == '{' || *p == '[' )
+        {
+            depth++;
+        }
+        else if( *p == '}' || *p == ']' )
+        {
+            if( depth == 0 ) break;
+            depth--;
+        }
+        else if( *p == ',' && depth == 0 )
+        {
+            break;
+        }
+
+        p++;
+    }
+
+    return p;
+}
+
+
+/*!*****************************************************************************
+@brief Classify a JSON-RPC message
+
+Function: RpcMsgScan()
+
+    This function scans the top level members of a JSON-RPC message for "id"
+    and "method" without parsing nested values, and stops as soon as it knows
+    what the message is. Nodes typically put "id" or "method" first, while
+    REQUESTs composed by web3intf put "id" last.
+
+@return
+    This function returns BOAT_TRUE if the message is a subscription
+    notification, i.e. its "method" is "eth_subscription".
+
+@param[in] message_str
+    The message.
+
+@param[in] message_len
+    Length of <message_str>.
+
+@param[out] id_ptr
+    The numeric "id" of the message, or -1 if it has none.
+*******************************************************************************/
+BOATBOOL RpcMsgScan(const CHAR *message_str, UINT32 message_len, BOAT_OUT SINT64 *id_ptr)
+{
+    const CHAR *p = message_str;
+    const CHAR *end = message_str + message_len;
+    const CHAR *key_ptr;
+    UINT32 key_len;
+    SINT64 id;
+
+    *id_ptr = -1;
+
+    while( p < end && *p != '{' ) p++;
+    if( p < end ) p++;
+
+    while( p < end )
+    {
+        while( p < end && (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n' || *p == ',') ) p++;
+        if( p >= end || *p != '"' ) break;
+
+        key_ptr = p + 1;
+        p = RpcMsgSkipString(p, end);
+        key_len = (UINT32)(p - key_ptr - 1);
+
+        while( p < end && (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n' || *p == ':') ) p++;
+
+        if( key_len == 2 && memcmp(key_ptr, "id", 2) == 0 && p < end && *p >= '0' && *p <= '9' )
+        {
+            for( id = 0; p < end && *p >= '0' && *p <= '9'; p++ ) id = id * 10 + (*p - '0');
+            *id_ptr = id;
+            return BOAT_FALSE;
+        }
+
+        if(    key_len == 6 && memcmp(key_ptr, "method", 6) == 0
+            && end - p >= 18 && memcmp(p, "\"eth_subscription\"", 18) == 0 )
+        {
+            return BOAT_TRUE;
+        }
+
+        p = RpcMsgSkipValue(p, end);
+    }
+
+    return BOAT_FALSE;
+}
+
+
+/*!*****************************************************************************
+@brief Find a top level member of a JSON-RPC message
+
+Function: RpcMsgGetMember()
+
+    This function scans the top level members of a JSON-RPC message the same
+    way as RpcMsgScan(), e.g. for the "method" of a REQUEST or the "error" of
+    a RESPONSE.
+
+@return
+    This function returns the address of the value of the member in
+    <message_str>, still in JSON (a string value keeps its quotes), or NULL if
+    the message has no such member.
+
+@param[in] message_str
+    The message.
+
+@param[in] message_len
+    Length of <message_str>.
+
+@param[in] key_str
+    Name of the member.
+
+@param[out] value_len_ptr
+    Length of the value.
+*******************************************************************************/
+const CHAR *RpcMsgGetMember(const CHAR *message_str,
+                            UINT32 message_len,
+                            const CHAR *key_str,
+                            BOAT_OUT UINT32 *value_len_ptr)
+{
+    const CHAR *p = message_str;
+    const CHAR *end = message_str + message_len;
+    const CHAR *key_ptr;
+    const CHAR *value_ptr;
+    UINT32 key_len;
+
+    while( p < end && *p != '{' ) p++;
+    if( p < end ) p++;
+
+    while( p < end )
+    {
+        while( p < end && (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n' || *p == ',') ) p++;
+        if( p >= end || *p != '"' ) break;
+
+        key_ptr = p + 1;
+        p = RpcMsgSkipString(p, end);
+        key_len = (UINT32)(p - key_ptr - 1);
+
+        while( p < end && (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n' || *p == ':') ) p++;
+
+        value_ptr = p;
+        p = RpcMsgSkipValue(p, end);
+
+        if( key_len == strlen(key_str) && memcmp(key_ptr, key_str, key_len) == 0 )
+        {
+            // Trailing blanks of a value are skipped along with it
+            while( p > value_ptr && (p[-1] == ' ' || p[-1] == '\t' || p[-1] == '\r' || p[-1] == '\n') ) p--;
+            *value_len_ptr = (UINT32)(p - value_ptr);
+            return value_ptr;
+        }
+    }
+
+    return NULL;
+}
+
+
+/*!*****************************************************************************
+@brief Keep a copy of a message
+
+Function: RpcMsgQueuePush()
+
+    This function appends a copy of <message_str> to the queue. If the queue is
+    full, the oldest message is dropped.
+
+@return
+    This function doesn't return any value.
+
+@param[in] queue_ptr
+    The queue.
+
+@param[in] message_str
+    The message. It's copied with a null terminator.
+
+@param[in] message_len
+    Length of <message_str>.
+
+@param[in] id
+    The "id" of the message, or -1.
+*******************************************************************************/
+void RpcMsgQueuePush(RpcMsgQueue *queue_ptr, const CHAR *message_str, UINT32 message_len, SINT64 id)
+{
+    CHAR *message_copy_ptr;
+    UINT32 tail;
+
+    message_copy_ptr = BoatMalloc(message_len + 1);
+    if( message_copy_ptr == NULL )
+    {
+        BoatLog(BOAT_LOG_NORMAL, "Fail to allocate storage for a message. It's dropped.");
+        return;
+    }
+    memcpy(message_copy_ptr, message_str, message_len);
+    message_copy_ptr[message_len] = '\0';
+
+    if( queue_ptr->num == RPC_MSG_QUEUE_LEN )
+    {
+        BoatLog(BOAT_LOG_NORMAL, "Message queue is full. The oldest one is dropped.");
+        BoatFree(queue_ptr->message_ptr[queue_ptr->head]);
+        queue_ptr->head = (queue_ptr->head + 1) % RPC_MSG_QUEUE_LEN;
+        queue_ptr->num--;
+    }
+
+    tail = (queue_ptr->head + queue_ptr->num) % RPC_MSG_QUEUE_LEN;
+    queue_ptr->message_ptr[tail] = message_copy_ptr;
+    queue_ptr->message_len[tail] = message_len;
+    queue_ptr->message_id[tail] = id;
+    queue_ptr->num++;
+}
+
+
+/*!*****************************************************************************
+@brief Take the oldest message with the given "id" out of a queue
+
+Function: RpcMsgQueueTake()
+
+@return
+    This function returns the message, which the caller must free with
+    BoatFree(), or NULL if there's none with <id>.
+
+@param[in] queue_ptr
+    The queue.
+
+@param[in] id
+    The "id" to look for. -1 takes the oldest message without "id".
+
+@param[out] message_len_ptr
+    Length of the returned message.
+*******************************************************************************/
+CHAR *RpcMsgQueueTake(RpcMsgQueue *queue_ptr, SINT64 id, BOAT_OUT UINT32 *message_len_ptr)
+{
+    CHAR *message_ptr;
+    UINT32 i;
+    UINT32 from;
+    UINT32 to;
+
+    for( i = 0; i < queue_ptr->num; i++ )
+    {
+        from = (queue_ptr->head + i) % RPC_MSG_QUEUE_LEN;
+        if( queue_ptr->message_id[from] == id ) break;
+    }
+
+    if( i == queue_ptr->num ) return NULL;
+
+    message_ptr = queue_ptr->message_ptr[from];
+    *message_len_ptr = queue_ptr->message_len[from];
+
+    // Close the gap, keeping the order of the rest
+    for( ; i + 1 < queue_ptr->num; i++ )
+    {
+        to = (queue_ptr->head + i) % RPC_MSG_QUEUE_LEN;
+        from = (queue_ptr->head + i + 1) % RPC_MSG_QUEUE_LEN;
+        queue_ptr->message_ptr[to] = queue_ptr->message_ptr[from];
+        queue_ptr->message_len[to] = queue_ptr->message_len[from];
+        queue_ptr->message_id[to] = queue_ptr->message_id[from];
+    }
+    queue_ptr->num--;
+
+    return message_ptr;
+}
+
+
+/*!*****************************************************************************
+@brief Free all messages in a queue
+
+Function: RpcMsgQueueClear()
+
+@return
+    This function doesn't return any value.
+
+@param[in] queue_ptr
+    The queue.
+*******************************************************************************/
+void RpcMsgQueueClear(RpcMsgQueue *queue_ptr)
+{
+    while( queue_ptr->num > 0 )
+    {
+        BoatFree(queue_ptr->message_ptr[queue_ptr->head]);
+        queue_ptr->head = (queue_ptr->head + 1) % RPC_MSG_QUEUE_LEN;
+        queue_ptr->num--;
+    }
+
+    queue_ptr->head = 0;
+}
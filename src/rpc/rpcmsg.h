@@ -0,0 +1,72 @@
+/******************************************************************************
+Copyright (C) 2018-2019 AITOS.IO
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+of the Software, and to permit persons to whom the Software is furnished to do
+so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+******************************************************************************/
+
+/*!@brief JSON-RPC message helpers header file internally used by RPC porting
+
+@file
+rpcmsg.h is header file of helpers shared by RPC Portings that could have
+several REQUESTs outstanding and thus receive messages not in the order of
+REQUESTs, such as wsport and ipcport. Upper layer should include rpcintf.h
+instead.
+*/
+
+#ifndef __RPCMSG_H__
+#define __RPCMSG_H__
+
+#include "wallet/boattypes.h"
+
+//!Max number of messages in a RpcMsgQueue. The oldest is dropped when full.
+#define RPC_MSG_QUEUE_LEN 16
+
+//!@brief A FIFO of received messages kept for later retrieval
+typedef struct TRpcMsgQueue
+{
+    CHAR *message_ptr[RPC_MSG_QUEUE_LEN];   //!< Copies of the messages
+    UINT32 message_len[RPC_MSG_QUEUE_LEN];  //!< Lengths of the messages
+    SINT64 message_id[RPC_MSG_QUEUE_LEN];   //!< JSON-RPC "id" of the messages, -1 if none
+    UINT32 head;                            //!< Index of the oldest message
+    UINT32 num;                             //!< Number of messages
+}RpcMsgQueue;
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+BOATBOOL RpcMsgScan(const CHAR *message_str, UINT32 message_len, BOAT_OUT SINT64 *id_ptr);
+
+const CHAR *RpcMsgGetMember(const CHAR *message_str,
+                            UINT32 message_len,
+                            const CHAR *key_str,
+                            BOAT_OUT UINT32 *value_len_ptr);
+
+void RpcMsgQueuePush(RpcMsgQueue *queue_ptr, const CHAR *message_str, UINT32 message_len, SINT64 id);
+
+CHAR *RpcMsgQueueTake(RpcMsgQueue *queue_ptr, SINT64 id, BOAT_OUT UINT32 *message_len_ptr);
+
+void RpcMsgQueueClear(RpcMsgQueue *queue_ptr);
+
+#ifdef __cplusplus
+}
+#endif /* end of __cplusplus */
+
+#endif
@@ -41,11 +41,29 @@ RPC_USE_XXX macros.
 #include "rpc/curlport.h"
 #endif
 
+#if RPC_USE_WEBSOCKET == 1
+#include "rpc/wsport.h"
+#endif
+
+#if RPC_USE_IPC == 1
+#include "rpc/ipcport.h"
+#endif
 
 
-#if RPC_USE_LIBCURL == 1
-extern RpcCtx g_rpc_ctx;
-extern RpcOption g_rpc_option;
+
+//!@brief Storage class of RPC state.
+//! RPC context, options and receiving buffer are kept per thread, so that a
+//! background thread (e.g. the outbox flusher) could issue RPC requests of its
+//! own. Each thread must call RpcSetOpt() before its first RpcRequestSync().
+#if defined(__GNUC__)
+#define RPC_THREAD_LOCAL __thread
+#else
+#define RPC_THREAD_LOCAL
+#endif
+
+#if RPC_USE_LIBCURL == 1 || RPC_USE_WEBSOCKET == 1 || RPC_USE_IPC == 1
+extern RPC_THREAD_LOCAL RpcCtx g_rpc_ctx;
+extern RPC_THREAD_LOCAL RpcOption g_rpc_option;
 #endif
 
 
@@ -0,0 +1,424 @@
+/******************************************************************************
+Copyright (C) 2018-2019 AITOS.IO
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+of the Software, and to permit persons to whom the Software is furnished to do
+so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+******************************************************************************/
+
+/*!@brief Retries of RPC REQUESTs
+
+@file
+rpcretry.c decides whether RpcRequestSync() attempts a failed REQUEST again,
+and when.
+
+Only failures that may be transient are retried: timeout, HTTP 429, HTTP 5xx
+and connection failures. Whether a REQUEST is retried at all depends on its
+method:
+
+- Methods only reading the chain are idempotent, and are attempted up to
+  BOAT_RPC_RETRY_READ_ATTEMPTS times.
+- eth_sendRawTransaction is attempted up to BOAT_RPC_RETRY_SEND_ATTEMPTS times.
+  A failed attempt may still have reached the node, so on a retry the node may
+  reply that it already knows the transaction. That RESPONSE is replaced with
+  the one of a successful attempt, i.e. the transaction hash.
+- Other methods, e.g. eth_getFilterChanges, change state on the node and are
+  attempted once.
+
+Retries are delayed by exponential backoff with jitter, so that clients failed
+at the same time don't retry at the same time.
+
+Each attempt times out after BOAT_RPC_TIMEOUT_SHORT_MS for cheap methods, e.g.
+eth_gasPrice, or after BOAT_RPC_TIMEOUT_MS for others, e.g. eth_getLogs.
+*/
+
+#include "wallet/boattypes.h"
+#include "utilities/utility.h"
+#include "rpc/rpcport.h"
+#include "rpc/rpcmsg.h"
+#include "rpc/rpcretry.h"
+#include "randgenerator.h"
+
+#include <pthread.h>
+
+//!@brief Retry policy of methods
+typedef struct TRpcRetryPolicy
+{
+    const CHAR *method_str;         //!< Method name, or its prefix
+    BOATBOOL is_prefix;             //!< Whether <method_str> is a prefix
+    RPC_RETRY_CLASS retry_class;    //!< How the methods are retried
+    UINT32 timeout_ms;              //!< Timeout of each attempt
+}RpcRetryPolicy;
+
+// The first matching entry applies. Unlisted methods are not retried and time
+// out after BOAT_RPC_TIMEOUT_MS.
+static const RpcRetryPolicy g_rpcretry_policy[] =
+{
+    {"eth_getFilterChanges",        BOAT_FALSE, RPC_RETRY_NONE, BOAT_RPC_TIMEOUT_SHORT_MS},  // Changes are taken once
+    {"eth_getLogs",                 BOAT_FALSE, RPC_RETRY_READ, BOAT_RPC_TIMEOUT_MS},
+    {"eth_getBlockBy",              BOAT_TRUE,  RPC_RETRY_READ, BOAT_RPC_TIMEOUT_MS},
+    {"eth_get",                     BOAT_TRUE,  RPC_RETRY_READ, BOAT_RPC_TIMEOUT_SHORT_MS},
+    {"eth_call",                    BOAT_FALSE, RPC_RETRY_READ, BOAT_RPC_TIMEOUT_MS},
+    {"eth_estimateGas",             BOAT_FALSE, RPC_RETRY_READ, BOAT_RPC_TIMEOUT_MS},
+    {"eth_gasPrice",                BOAT_FALSE, RPC_RETRY_READ, BOAT_RPC_TIMEOUT_SHORT_MS},
+    {"eth_blockNumber",             BOAT_FALSE, RPC_RETRY_READ, BOAT_RPC_TIMEOUT_SHORT_MS},
+    {"eth_chainId",                 BOAT_FALSE, RPC_RETRY_READ, BOAT_RPC_TIMEOUT_SHORT_MS},
+    {"eth_feeHistory",              BOAT_FALSE, RPC_RETRY_READ, BOAT_RPC_TIMEOUT_SHORT_MS},
+    {"eth_maxPriorityFeePerGas",    BOAT_FALSE, RPC_RETRY_READ, BOAT_RPC_TIMEOUT_SHORT_MS},
+    {"eth_syncing",                 BOAT_FALSE, RPC_RETRY_READ, BOAT_RPC_TIMEOUT_SHORT_MS},
+    {"net_",                        BOAT_TRUE,  RPC_RETRY_READ, BOAT_RPC_TIMEOUT_SHORT_MS},
+    {"web3_",                       BOAT_TRUE,  RPC_RETRY_READ, BOAT_RPC_TIMEOUT_SHORT_MS},
+    {"eth_sendRawTransaction",      BOAT_FALSE, RPC_RETRY_SEND, BOAT_RPC_TIMEOUT_MS},
+};
+
+// Error messages of nodes (geth, OpenEthereum, Nethermind) meaning the
+// transaction is already in their pool or chain, in lower case
+static const CHAR * const g_rpcretry_known_tx_str[] =
+{
+    "already known",
+    "known transaction",
+    "already imported",
+    "alreadyknown",
+};
+
+//!@brief RESPONSE replacing a node's "already known" error, see RpcRetryDedup()
+static RPC_THREAD_LOCAL CHAR g_rpcretry_response_str[128];
+
+static RpcRetryStats g_rpcretry_stats;
+static pthread_mutex_t g_rpcretry_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+
+static const RpcRetryPolicy *RpcRetryGetPolicy(const CHAR *request_str, UINT32 request_len)
+{
+    const CHAR *method_ptr;
+    UINT32 method_len;
+    UINT32 name_len;
+    UINT32 i;
+
+    method_ptr = RpcMsgGetMember(request_str, request_len, "method", &method_len);
+    if( method_ptr == NULL || method_len < 2 || method_ptr[0] != '"' ) return NULL;
+
+    // Strip the quotes
+    method_ptr++;
+    method_len -= 2;
+
+    for( i = 0; i < sizeof(g_rpcretry_policy) / sizeof(g_rpcretry_policy[0]); i++ )
+    {
+        name_len = strlen(g_rpcretry_policy[i].method_str);
+
+        if(    (name_len == method_len || (g_rpcretry_policy[i].is_prefix && name_len < method_len))
+            && memcmp(method_ptr, g_rpcretry_policy[i].method_str, name_len) == 0 )
+        {
+            return &g_rpcretry_policy[i];
+        }
+    }
+
+    return NULL;
+}
+
+
+static BOATBOOL RpcRetryIsKnownTx(const CHAR *error_ptr, UINT32 error_len)
+{
+    const CHAR *known_str;
+    UINT32 known_len;
+    UINT32 i;
+    UINT32 j;
+    UINT32 k;
+
+    for( i = 0; i < sizeof(g_rpcretry_known_tx_str) / sizeof(g_rpcretry_known_tx_str[0]); i++ )
+    {
+        known_str = g_rpcretry_known_tx_str[i];
+        known_len = strlen(known_str);
+
+        for( j = 0; j + known_len <= error_len; j++ )
+        {
+            for( k = 0; k < known_len; k++ )
+            {
+                CHAR c = error_ptr[j + k];
+                if( c >= 'A' && c <= 'Z' ) c += 'a' - 'A';
+                if( c != known_str[k] ) break;
+            }
+
+            if( k == known_len ) return BOAT_TRUE;
+        }
+    }
+
+    return BOAT_FALSE;
+}
+
+
+/*!*****************************************************************************
+@brief Replace a node's "already known" error to eth_sendRawTransaction
+
+Function: RpcRetryDedup()
+
+    A retried eth_sendRawTransaction may find that an earlier attempt did
+    reach the node. This function then makes the RESPONSE the node would have
+    returned to that attempt: the keccak-256 hash of the raw transaction.
+
+@return
+    This function returns BOAT_TRUE if <response_str> is replaced.
+
+@param[in] retry_ctx_ptr
+    The attempts of the REQUEST.
+
+@param[in,out] response_pptr
+    The RESPONSE.
+
+@param[in,out] response_len_ptr
+    Length of the RESPONSE.
+*******************************************************************************/
+static BOATBOOL RpcRetryDedup(const RpcRetryCtx *retry_ctx_ptr,
+                              CHAR **response_pptr,
+                              UINT32 *response_len_ptr)
+{
+    const CHAR *error_ptr;
+    const CHAR *params_ptr;
+    const CHAR *rawtx_hex_ptr;
+    CHAR *rawtx_hex_str;
+    UINT8 *rawtx_ptr;
+    UINT8 tx_hash[32];
+    CHAR tx_hash_str[67];
+    UINT32 error_len;
+    UINT32 params_len;
+    UINT32 rawtx_hex_len;
+    UINT32 rawtx_len;
+    SINT64 request_id;
+
+    error_ptr = RpcMsgGetMember(*response_pptr, *response_len_ptr, "error", &error_len);
+    if( error_ptr == NULL || !RpcRetryIsKnownTx(error_ptr, error_len) ) return BOAT_FALSE;
+
+    RpcMsgScan(retry_ctx_ptr->request_str, retry_ctx_ptr->request_len, &request_id);
+    if( request_id < 0 ) return BOAT_FALSE;
+
+    // "params":["0x<raw transaction>"]
+    params_ptr = RpcMsgGetMember(retry_ctx_ptr->request_str, retry_ctx_ptr->request_len, "params", &params_len);
+    if( params_ptr == NULL ) return BOAT_FALSE;
+
+    rawtx_hex_ptr = memchr(params_ptr, '"', params_len);
+    if( rawtx_hex_ptr == NULL ) return BOAT_FALSE;
+    rawtx_hex_ptr++;
+    rawtx_hex_len = 0;
+    while( rawtx_hex_ptr + rawtx_hex_len < params_ptr + params_len && rawtx_hex_ptr[rawtx_hex_len] != '"' ) rawtx_hex_len++;
+
+    rawtx_hex_str = BoatMalloc(rawtx_hex_len + 1);
+    rawtx_ptr = BoatMalloc(rawtx_hex_len / 2 + 1);
+    if( rawtx_hex_str == NULL || rawtx_ptr == NULL )
+    {
+        if( rawtx_hex_str != NULL ) BoatFree(rawtx_hex_str);
+        if( rawtx_ptr != NULL ) BoatFree(rawtx_ptr);
+        return BOAT_FALSE;
+    }
+
+    memcpy(rawtx_hex_str, rawtx_hex_ptr, rawtx_hex_len);
+    rawtx_hex_str[rawtx_hex_len] = '\0';
+    rawtx_len = UtilityHex2Bin(rawtx_ptr, rawtx_hex_len / 2 + 1, rawtx_hex_str, TRIMBIN_TRIM_NO, BOAT_FALSE);
+
+    keccak_256(rawtx_ptr, rawtx_len, tx_hash);
+
+    BoatFree(rawtx_hex_str);
+    BoatFree(rawtx_ptr);
+
+    if( rawtx_len == 0 ) return BOAT_FALSE;
+
+    UtilityBin2Hex(tx_hash_str, tx_hash, 32, BIN2HEX_TRIM_NO, BIN2HEX_PREFIX_0x_YES, BOAT_FALSE);
+
+    *response_len_ptr = (UINT32)snprintf(g_rpcretry_response_str, sizeof(g_rpcretry_response_str),
+                                         "{\"jsonrpc\":\"2.0\",\"id\":%lld,\"result\":\"%s\"}",
+                                         (long long)request_id, tx_hash_str);
+    *response_pptr = g_rpcretry_response_str;
+
+    BoatLog(BOAT_LOG_NORMAL, "Transaction %s is already known by the node.", tx_hash_str);
+
+    return BOAT_TRUE;
+}
+
+
+/*!*****************************************************************************
+@brief Start the attempts of a REQUEST
+
+Function: RpcRetryBegin()
+
+@return This function doesn't return any value.
+
+@param[out] retry_ctx_ptr
+    The attempts of the REQUEST, to pass to RpcRetryAgain() after each attempt.
+
+@param[in] request_str
+    The REQUEST. It must stay unchanged until the last attempt.
+
+@param[in] request_len
+    Length of <request_str>.
+
+@param[in] deadline_ms
+    No attempt starts after it, as per BoatGetTimeMs(), or 0 for no deadline.
+*******************************************************************************/
+void RpcRetryBegin(BOAT_OUT RpcRetryCtx *retry_ctx_ptr,
+                   const CHAR *request_str,
+                   UINT32 request_len,
+                   UINT64 deadline_ms)
+{
+    const RpcRetryPolicy *policy_ptr;
+
+    policy_ptr = RpcRetryGetPolicy(request_str, request_len);
+
+    retry_ctx_ptr->request_str = request_str;
+    retry_ctx_ptr->request_len = request_len;
+    retry_ctx_ptr->retry_class = policy_ptr != NULL ? policy_ptr->retry_class : RPC_RETRY_NONE;
+    retry_ctx_ptr->timeout_ms = policy_ptr != NULL ? policy_ptr->timeout_ms : BOAT_RPC_TIMEOUT_MS;
+    retry_ctx_ptr->deadline_ms = deadline_ms;
+    retry_ctx_ptr->attempt_num = 0;
+
+    if( retry_ctx_ptr->retry_class == RPC_RETRY_READ )
+    {
+        retry_ctx_ptr->max_attempt_num = BOAT_RPC_RETRY_READ_ATTEMPTS;
+    }
+    else if( retry_ctx_ptr->retry_class == RPC_RETRY_SEND )
+    {
+        retry_ctx_ptr->max_attempt_num = BOAT_RPC_RETRY_SEND_ATTEMPTS;
+    }
+    else
+    {
+        retry_ctx_ptr->max_attempt_num = 1;
+    }
+}
+
+
+/*!*****************************************************************************
+@brief Decide whether to attempt a REQUEST again
+
+Function: RpcRetryAgain()
+
+    This function is called after each attempt of a REQUEST. If the attempt
+    failed in a way worth retrying and attempts are left, it sleeps for the
+    backoff delay and returns BOAT_TRUE, unless the deadline would pass.
+
+@return
+    This function returns BOAT_TRUE if the REQUEST is to be attempted again.
+
+@param[in,out] retry_ctx_ptr
+    The attempts of the REQUEST.
+
+@param[in,out] result_ptr
+    Result of the attempt.
+
+@param[in,out] response_pptr
+    The RESPONSE of the attempt. It may be replaced, see RpcRetryDedup().
+
+@param[in,out] response_len_ptr
+    Length of the RESPONSE.
+*******************************************************************************/
+BOATBOOL RpcRetryAgain(RpcRetryCtx *retry_ctx_ptr,
+                       BOAT_RESULT *result_ptr,
+                       CHAR **response_pptr,
+                       UINT32 *response_len_ptr)
+{
+    UINT32 delay_ms;
+    UINT32 i;
+
+    retry_ctx_ptr->attempt_num++;
+
+    if( *result_ptr == BOAT_SUCCESS )
+    {
+        if( retry_ctx_ptr->attempt_num > 1 )
+        {
+            BOATBOOL is_dedup = retry_ctx_ptr->retry_class == RPC_RETRY_SEND
+                                && RpcRetryDedup(retry_ctx_ptr, response_pptr, response_len_ptr);
+
+            pthread_mutex_lock(&g_rpcretry_mutex);
+            g_rpcretry_stats.recovered_num++;
+            if( is_dedup ) g_rpcretry_stats.dedup_num++;
+            pthread_mutex_unlock(&g_rpcretry_mutex);
+        }
+
+        return BOAT_FALSE;
+    }
+
+    if(    *result_ptr != BOAT_ERROR_RPC_TIMEOUT
+        && *result_ptr != BOAT_ERROR_RPC_THROTTLED
+        && *result_ptr != BOAT_ERROR_RPC_SERVER
+        && *result_ptr != BOAT_ERROR_RPC_FAIL
+        && *result_ptr != BOAT_ERROR_EXT_MODULE_OPERATION_FAIL )
+    {
+        return BOAT_FALSE;
+    }
+
+    if( retry_ctx_ptr->attempt_num >= retry_ctx_ptr->max_attempt_num )
+    {
+        if( retry_ctx_ptr->attempt_num > 1 )
+        {
+            BoatLog(BOAT_LOG_NORMAL, "REQUEST fails after %u attempts (%d).",
+                    retry_ctx_ptr->attempt_num, *result_ptr);
+
+            pthread_mutex_lock(&g_rpcretry_mutex);
+            g_rpcretry_stats.giveup_num++;
+            pthread_mutex_unlock(&g_rpcretry_mutex);
+        }
+
+        return BOAT_FALSE;
+    }
+
+    // Up to BASE * 2^(attempt - 1), jittered within its upper half
+    delay_ms = BOAT_RPC_RETRY_BASE_MS;
+    for( i = 1; i < retry_ctx_ptr->attempt_num && delay_ms < BOAT_RPC_RETRY_MAX_MS; i++ )
+    {
+        delay_ms *= 2;
+    }
+    if( delay_ms > BOAT_RPC_RETRY_MAX_MS ) delay_ms = BOAT_RPC_RETRY_MAX_MS;
+    delay_ms = delay_ms / 2 + random32() % (delay_ms / 2 + 1);
+
+    if( retry_ctx_ptr->deadline_ms != 0 && BoatGetTimeMs() + delay_ms >= retry_ctx_ptr->deadline_ms )
+    {
+        BoatLog(BOAT_LOG_NORMAL, "REQUEST attempt %u fails (%d), no time left to retry.",
+                retry_ctx_ptr->attempt_num, *result_ptr);
+
+        pthread_mutex_lock(&g_rpcretry_mutex);
+        g_rpcretry_stats.giveup_num++;
+        pthread_mutex_unlock(&g_rpcretry_mutex);
+
+        return BOAT_FALSE;
+    }
+
+    BoatLog(BOAT_LOG_NORMAL, "REQUEST attempt %u fails (%d), retry in %u ms.",
+            retry_ctx_ptr->attempt_num, *result_ptr, delay_ms);
+
+    pthread_mutex_lock(&g_rpcretry_mutex);
+    g_rpcretry_stats.retry_num++;
+    pthread_mutex_unlock(&g_rpcretry_mutex);
+
+    BoatSleepMs(delay_ms);
+
+    return BOAT_TRUE;
+}
+
+
+/*!*****************************************************************************
+@brief Get statistics of retried REQUESTs of all threads
+
+Function: RpcRetryGetStats()
+
+@return This function doesn't return any value.
+
+@param[out] stats_ptr
+    The statistics.
+*******************************************************************************/
+void RpcRetryGetStats(BOAT_OUT RpcRetryStats *stats_ptr)
+{
+    pthread_mutex_lock(&g_rpcretry_mutex);
+    *stats_ptr = g_rpcretry_stats;
+    pthread_mutex_unlock(&g_rpcretry_mutex);
+}
@@ -0,0 +1,78 @@
+/******************************************************************************
+Copyright (C) 2018-2019 AITOS.IO
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+of the Software, and to permit persons to whom the Software is furnished to do
+so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+******************************************************************************/
+
+/*!@brief Retries of RPC REQUESTs header file internally used by RPC
+
+@file
+rpcretry.h is header file of the retry policies and timeouts of methods
+applied by rpcintf.
+Upper layer should include rpcintf.h instead.
+*/
+
+#ifndef __RPCRETRY_H__
+#define __RPCRETRY_H__
+
+#include "wallet/boattypes.h"
+#include "rpc/rpcintf.h"
+
+//!@brief How a method is retried
+typedef enum
+{
+    RPC_RETRY_NONE = 0, //!< Not retried, e.g. methods changing state on the node
+    RPC_RETRY_READ,     //!< Idempotent, only reading the chain
+    RPC_RETRY_SEND      //!< eth_sendRawTransaction, deduplicated by transaction hash
+}RPC_RETRY_CLASS;
+
+//!@brief Attempts of a REQUEST
+typedef struct TRpcRetryCtx
+{
+    const CHAR *request_str;        //!< The REQUEST
+    UINT32 request_len;             //!< Length of <request_str>
+    RPC_RETRY_CLASS retry_class;    //!< How the method of the REQUEST is retried
+    UINT32 max_attempt_num;         //!< Max attempts of the REQUEST
+    UINT32 attempt_num;             //!< Attempts made so far
+    UINT32 timeout_ms;              //!< Timeout of each attempt
+    UINT64 deadline_ms;             //!< No attempt starts after it, 0 for none
+}RpcRetryCtx;
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void RpcRetryBegin(BOAT_OUT RpcRetryCtx *retry_ctx_ptr,
+                   const CHAR *request_str,
+                   UINT32 request_len,
+                   UINT64 deadline_ms);
+
+BOATBOOL RpcRetryAgain(RpcRetryCtx *retry_ctx_ptr,
+                       BOAT_RESULT *result_ptr,
+                       CHAR **response_pptr,
+                       UINT32 *response_len_ptr);
+
+void RpcRetryGetStats(BOAT_OUT RpcRetryStats *stats_ptr);
+
+#ifdef __cplusplus
+}
+#endif /* end of __cplusplus */
+
+#endif
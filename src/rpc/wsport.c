@@ -0,0 +1,1459 @@
+/******************************************************************************
+Copyright (C) 2018-2019 AITOS.IO
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+of the Software, and to permit persons to whom the Software is furnished to do
+so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+******************************************************************************/
+
+/*!@brief WebSocket porting for RPC
+
+@file
+wsport.c is the WebSocket (RFC 6455) porting of RPC.
+
+All RPC REQUESTs of a thread are sent over one persistent connection to the
+node (e.g. "ws://127.0.0.1:8546"), which is opened on the first request and
+re-opened if the node closes it. A RESPONSE is matched to its REQUEST by the
+JSON-RPC "id". Subscription notifications (method "eth_subscription") received
+meanwhile are queued for RpcWaitNotification().
+
+Several REQUESTs could be outstanding at a time: WsPortSend() sends a REQUEST
+without waiting and WsPortRecv() takes the RESPONSE with a given "id".
+RESPONSEs arriving before they're asked for are kept until then.
+
+Only plain "ws://" is supported. A "wss://" node could be reached through a
+local TLS tunnel.
+
+DO NOT call functions in this file directly. Instead call wrapper functions
+provided by rpcport.
+
+To use WebSocket porting, RPC_USE_WEBSOCKET in boatoptions.h must set to 1.
+*/
+
+// For getaddrinfo() and MSG_NOSIGNAL
+#define _DEFAULT_SOURCE
+
+#include "wallet/boattypes.h"
+
+#if RPC_USE_WEBSOCKET == 1
+#include "utilities/utility.h"
+#include "rpc/rpcport.h"
+#include "rpc/wsport.h"
+#include "rpc/rpcmsg.h"
+#include "randgenerator.h"
+#include "sha2.h"
+
+#include <pthread.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <netdb.h>
+#include <poll.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <strings.h>
+
+
+//!The step to dynamically expand the receiving buffer.
+#define WSPORT_RECV_BUF_SIZE_STEP 1024
+
+//!Size of the read-ahead buffer of the socket
+#define WSPORT_READ_AHEAD_SIZE 4096
+
+//!Max length of the HTTP response to the opening handshake
+#define WSPORT_HANDSHAKE_MAX_LEN 2048
+
+//!Max length of a message, i.e. RESPONSE or notification, reassembled from its frames
+#define WSPORT_MAX_MESSAGE_LEN (16u * 1024u * 1024u)
+
+//!Opcodes of WebSocket frames
+#define WSPORT_OPCODE_CONTINUATION 0x0
+#define WSPORT_OPCODE_TEXT 0x1
+#define WSPORT_OPCODE_BINARY 0x2
+#define WSPORT_OPCODE_CLOSE 0x8
+#define WSPORT_OPCODE_PING 0x9
+#define WSPORT_OPCODE_PONG 0xA
+
+//!@brief A struct to maintain a dynamic length string.
+typedef struct TWsPortStringWithLen
+{
+    CHAR *string_ptr;   //!< address of the string storage
+    UINT32 string_len;  //!< string length in byte excluding NULL terminator
+    UINT32 string_space;//!< size of the space <string_ptr> pointing to, including null terminator
+}WsPortStringWithLen;
+
+//!@brief A persistent connection of a thread
+typedef struct TWsPortConn
+{
+    int socket_fd;                  //!< Socket of the connection, -1 if not connected
+    CHAR *url_str;                  //!< Copy of the URL the connection is opened to
+    UINT8 read_ahead[WSPORT_READ_AHEAD_SIZE]; //!< Bytes received but not consumed yet
+    UINT32 read_ahead_pos;          //!< Offset of the first unconsumed byte in <read_ahead>
+    UINT32 read_ahead_len;          //!< Number of bytes in <read_ahead>
+    WsPortStringWithLen message;    //!< The last received message, i.e. RESPONSE or notification
+    WsPortStringWithLen frame;      //!< Storage to compose a frame to send
+    RpcMsgQueue notifications;      //!< Subscription notifications not taken yet
+    RpcMsgQueue responses;          //!< RESPONSEs received before they're asked for
+}WsPortConn;
+
+//!@brief GUID concatenated to Sec-WebSocket-Key as per RFC 6455
+static const CHAR *g_wsport_guid_str = "258EAFA5-E914-47DA-95CA-C5AB0DC85B11";
+
+//!@brief Key whose destructor closes the connection of a non-main thread on its exit.
+static pthread_key_t g_wsport_conn_key;
+static pthread_once_t g_wsport_conn_key_once = PTHREAD_ONCE_INIT;
+
+
+static void WsPortDisconnect(WsPortConn *conn_ptr)
+{
+    if( conn_ptr->socket_fd >= 0 )
+    {
+        close(conn_ptr->socket_fd);
+        conn_ptr->socket_fd = -1;
+    }
+
+    conn_ptr->read_ahead_pos = 0;
+    conn_ptr->read_ahead_len = 0;
+
+    // RESPONSEs to REQUESTs sent over a lost connection never arrive
+    RpcMsgQueueClear(&conn_ptr->responses);
+}
+
+
+static void WsPortFreeConn(void *conn)
+{
+    WsPortConn *conn_ptr = (WsPortConn *)conn;
+
+    if( conn_ptr == NULL ) return;
+
+    WsPortDisconnect(conn_ptr);
+
+    if( conn_ptr->url_str != NULL ) BoatFree(conn_ptr->url_str);
+    if( conn_ptr->message.string_ptr != NULL ) BoatFree(conn_ptr->message.string_ptr);
+    if( conn_ptr->frame.string_ptr != NULL ) BoatFree(conn_ptr->frame.string_ptr);
+
+    RpcMsgQueueClear(&conn_ptr->notifications);
+
+    BoatFree(conn_ptr);
+}
+
+
+static void WsPortCreateConnKey(void)
+{
+    pthread_key_create(&g_wsport_conn_key, WsPortFreeConn);
+}
+
+
+/*!*****************************************************************************
+@brief Get the connection of the calling thread
+
+Function: WsPortGetConn()
+
+    This function returns the connection of the calling thread, which is
+    allocated on the thread's first call. It's freed on WsPortDeinit() or when
+    the thread exits.
+
+@return
+    This function returns the connection, or NULL if out of memory.
+
+@param This function doesn't take any argument.
+*******************************************************************************/
+static WsPortConn *WsPortGetConn(void)
+{
+    WsPortConn *conn_ptr;
+
+    if( g_rpc_ctx.ws_conn_ptr != NULL ) return g_rpc_ctx.ws_conn_ptr;
+
+    conn_ptr = BoatMalloc(sizeof(WsPortConn));
+    if( conn_ptr == NULL )
+    {
+        BoatLog(BOAT_LOG_CRITICAL, "Fail to allocate WebSocket connection.");
+        return NULL;
+    }
+
+    memset(conn_ptr, 0, sizeof(WsPortConn));
+    conn_ptr->socket_fd = -1;
+
+    conn_ptr->message.string_ptr = BoatMalloc(WSPORT_RECV_BUF_SIZE_STEP);
+    if( conn_ptr->message.string_ptr == NULL )
+    {
+        BoatLog(BOAT_LOG_CRITICAL, "Fail to allocate WebSocket RESPONSE buffer.");
+        BoatFree(conn_ptr);
+        return NULL;
+    }
+    conn_ptr->message.string_ptr[0] = '\0';
+    conn_ptr->message.string_space = WSPORT_RECV_BUF_SIZE_STEP;
+
+    pthread_once(&g_wsport_conn_key_once, WsPortCreateConnKey);
+    pthread_setspecific(g_wsport_conn_key, conn_ptr);
+
+    g_rpc_ctx.ws_conn_ptr = conn_ptr;
+
+    return conn_ptr;
+}
+
+
+/*!*****************************************************************************
+@brief Make room in a dynamic length string
+
+Function: WsPortStringReserve()
+
+    This function expands <mem> in steps of WSPORT_RECV_BUF_SIZE_STEP so that
+    <more_len> bytes plus a null terminator could be appended.
+
+@return
+    This function returns BOAT_SUCCESS if successful, or
+    BOAT_ERROR_OUT_OF_MEMORY.
+
+@param[in] mem
+    The string to expand.
+
+@param[in] more_len
+    The number of bytes to append.
+*******************************************************************************/
+static BOAT_RESULT WsPortStringReserve(WsPortStringWithLen *mem, UINT32 more_len)
+{
+    UINT32 expand_size;
+    UINT32 expand_steps;
+    UINT32 expanded_to_space;
+    CHAR *expanded_str;
+
+    if( mem->string_space > mem->string_len && mem->string_space - mem->string_len > more_len )
+    {
+        return BOAT_SUCCESS;
+    }
+
+    expand_size = more_len - (mem->string_space - mem->string_len) + 1; // plus 1 for null terminator
+    expand_steps = (expand_size - 1) / WSPORT_RECV_BUF_SIZE_STEP + 1;
+    expanded_to_space = expand_steps * WSPORT_RECV_BUF_SIZE_STEP + mem->string_space;
+
+    expanded_str = BoatMalloc(expanded_to_space);
+    if( expanded_str == NULL )
+    {
+        BoatLog(BOAT_LOG_CRITICAL, "Fail to expand WebSocket buffer to %u bytes.", expanded_to_space);
+        return BOAT_ERROR_OUT_OF_MEMORY;
+    }
+
+    if( mem->string_ptr != NULL )
+    {
+        memcpy(expanded_str, mem->string_ptr, mem->string_len);
+        BoatFree(mem->string_ptr);
+    }
+
+    mem->string_ptr = expanded_str;
+    mem->string_space = expanded_to_space;
+
+    return BOAT_SUCCESS;
+}
+
+
+static UINT32 WsPortRemainingMs(UINT64 deadline_ms)
+{
+    UINT64 now_ms = BoatGetTimeMs();
+
+    return now_ms < deadline_ms ? (UINT32)(deadline_ms - now_ms) : 0;
+}
+
+
+/*!*****************************************************************************
+@brief Wait for a socket to become ready
+
+Function: WsPortPoll()
+
+@return
+    This function returns BOAT_SUCCESS if the socket is ready,
+    BOAT_ERROR_RPC_TIMEOUT if <deadline_ms> passes, or BOAT_ERROR_RPC_FAIL.
+
+@param[in] socket_fd
+    The socket.
+
+@param[in] events
+    POLLIN or POLLOUT.
+
+@param[in] deadline_ms
+    The deadline as per BoatGetTimeMs().
+*******************************************************************************/
+static BOAT_RESULT WsPortPoll(int socket_fd, short events, UINT64 deadline_ms)
+{
+    struct pollfd poll_fd;
+    int poll_result;
+
+    poll_fd.fd = socket_fd;
+    poll_fd.events = events;
+
+    do
+    {
+        poll_fd.revents = 0;
+        poll_result = poll(&poll_fd, 1, (int)WsPortRemainingMs(deadline_ms));
+    }while( poll_result < 0 && errno == EINTR );
+
+    if( poll_result == 0 ) return BOAT_ERROR_RPC_TIMEOUT;
+    if( poll_result < 0 ) return BOAT_ERROR_RPC_FAIL;
+
+    // POLLHUP and POLLERR are left to the following recv() or send() to report
+    return BOAT_SUCCESS;
+}
+
+
+static BOAT_RESULT WsPortSendAll(WsPortConn *conn_ptr, const UINT8 *data_ptr, UINT32 data_len, UINT64 deadline_ms)
+{
+    ssize_t sent_len;
+    BOAT_RESULT result;
+
+    while( data_len > 0 )
+    {
+        sent_len = send(conn_ptr->socket_fd, data_ptr, data_len, MSG_NOSIGNAL);
+
+        if( sent_len > 0 )
+        {
+            data_ptr += sent_len;
+            data_len -= (UINT32)sent_len;
+        }
+        else if( sent_len < 0 && (errno == EAGAIN || errno == EWOULDBLOCK) )
+        {
+            result = WsPortPoll(conn_ptr->socket_fd, POLLOUT, deadline_ms);
+            if( result != BOAT_SUCCESS ) return result;
+        }
+        else if( sent_len < 0 && errno == EINTR )
+        {
+            continue;
+        }
+        else
+        {
+            BoatLog(BOAT_LOG_NORMAL, "WebSocket send() fails with errno %d.", errno);
+            return BOAT_ERROR_RPC_FAIL;
+        }
+    }
+
+    return BOAT_SUCCESS;
+}
+
+
+/*!*****************************************************************************
+@brief Receive exactly the given number of bytes
+
+Function: WsPortRecvAll()
+
+    This function takes bytes from the read-ahead buffer first. Long reads go
+    to <data_ptr> directly, while short ones refill the read-ahead buffer.
+
+@return
+    This function returns BOAT_SUCCESS if successful, BOAT_ERROR_RPC_TIMEOUT if
+    <deadline_ms> passes, or BOAT_ERROR_RPC_FAIL if the node closes the
+    connection.
+
+@param[in] conn_ptr
+    The connection.
+
+@param[out] data_ptr
+    The buffer to receive bytes, or NULL to discard them.
+
+@param[in] data_len
+    The number of bytes to receive.
+
+@param[in] deadline_ms
+    The deadline as per BoatGetTimeMs().
+*******************************************************************************/
+static BOAT_RESULT WsPortRecvAll(WsPortConn *conn_ptr, UINT8 *data_ptr, UINT32 data_len, UINT64 deadline_ms)
+{
+    UINT32 copy_len;
+    ssize_t recv_len;
+    BOAT_RESULT result;
+
+    while( data_len > 0 )
+    {
+        if( conn_ptr->read_ahead_len > 0 )
+        {
+            copy_len = data_len < conn_ptr->read_ahead_len ? data_len : conn_ptr->read_ahead_len;
+            if( data_ptr != NULL )
+            {
+                memcpy(data_ptr, conn_ptr->read_ahead + conn_ptr->read_ahead_pos, copy_len);
+                data_ptr += copy_len;
+            }
+            conn_ptr->read_ahead_pos += copy_len;
+            conn_ptr->read_ahead_len -= copy_len;
+            data_len -= copy_len;
+            continue;
+        }
+
+        conn_ptr->read_ahead_pos = 0;
+
+        if( data_ptr != NULL && data_len >= WSPORT_READ_AHEAD_SIZE )
+        {
+            recv_len = recv(conn_ptr->socket_fd, data_ptr, data_len, 0);
+        }
+        else
+        {
+            recv_len = recv(conn_ptr->socket_fd, conn_ptr->read_ahead, WSPORT_READ_AHEAD_SIZE, 0);
+        }
+
+        if( recv_len > 0 )
+        {
+            if( data_ptr != NULL && data_len >= WSPORT_READ_AHEAD_SIZE )
+            {
+                data_ptr += recv_len;
+                data_len -= (UINT32)recv_len;
+            }
+            else
+            {
+                conn_ptr->read_ahead_len = (UINT32)recv_len;
+            }
+        }
+        else if( recv_len < 0 && (errno == EAGAIN || errno == EWOULDBLOCK) )
+        {
+            result = WsPortPoll(conn_ptr->socket_fd, POLLIN, deadline_ms);
+            if( result != BOAT_SUCCESS ) return result;
+        }
+        else if( recv_len < 0 && errno == EINTR )
+        {
+            continue;
+        }
+        else
+        {
+            BoatLog(BOAT_LOG_NORMAL, "WebSocket connection is closed by the node.");
+            return BOAT_ERROR_RPC_FAIL;
+        }
+    }
+
+    return BOAT_SUCCESS;
+}
+
+
+/*!*****************************************************************************
+@brief Send a masked frame
+
+Function: WsPortSendFrame()
+
+    This function composes a frame of a single fragment as per RFC 6455 and
+    sends it. Frames from a client must be masked with a random key.
+
+@return
+    This function returns BOAT_SUCCESS if successful. Otherwise it returns an
+    error code.
+
+@param[in] conn_ptr
+    The connection.
+
+@param[in] opcode
+    WSPORT_OPCODE_XXX.
+
+@param[in] payload_ptr
+    The payload.
+
+@param[in] payload_len
+    Length of <payload_ptr>.
+
+@param[in] deadline_ms
+    The deadline as per BoatGetTimeMs().
+*******************************************************************************/
+static BOAT_RESULT WsPortSendFrame(WsPortConn *conn_ptr,
+                                   UINT8 opcode,
+                                   const UINT8 *payload_ptr,
+                                   UINT32 payload_len,
+                                   UINT64 deadline_ms)
+{
+    UINT8 *frame_ptr;
+    UINT32 header_len;
+    UINT32 mask_key;
+    UINT8 mask[4];
+    UINT32 i;
+    BOAT_RESULT result;
+
+    conn_ptr->frame.string_len = 0;
+    result = WsPortStringReserve(&conn_ptr->frame, payload_len + 14);
+    if( result != BOAT_SUCCESS ) return result;
+
+    frame_ptr = (UINT8 *)conn_ptr->frame.string_ptr;
+
+    frame_ptr[0] = 0x80 | opcode;   // FIN
+
+    if( payload_len < 126 )
+    {
+        frame_ptr[1] = 0x80 | (UINT8)payload_len;
+        header_len = 2;
+    }
+    else if( payload_len <= 0xFFFF )
+    {
+        frame_ptr[1] = 0x80 | 126;
+        frame_ptr[2] = (UINT8)(payload_len >> 8);
+        frame_ptr[3] = (UINT8)payload_len;
+        header_len = 4;
+    }
+    else
+    {
+        frame_ptr[1] = 0x80 | 127;
+        memset(frame_ptr + 2, 0, 4);
+        frame_ptr[6] = (UINT8)(payload_len >> 24);
+        frame_ptr[7] = (UINT8)(payload_len >> 16);
+        frame_ptr[8] = (UINT8)(payload_len >> 8);
+        frame_ptr[9] = (UINT8)payload_len;
+        header_len = 10;
+    }
+
+    mask_key = random32();
+    mask[0] = (UINT8)(mask_key >> 24);
+    mask[1] = (UINT8)(mask_key >> 16);
+    mask[2] = (UINT8)(mask_key >> 8);
+    mask[3] = (UINT8)mask_key;
+    memcpy(frame_ptr + header_len, mask, 4);
+    header_len += 4;
+
+    for( i = 0; i < payload_len; i++ )
+    {
+        frame_ptr[header_len + i] = payload_ptr[i] ^ mask[i & 3];
+    }
+
+    result = WsPortSendAll(conn_ptr, frame_ptr, header_len + payload_len, deadline_ms);
+
+    // A partially sent frame can't be resumed
+    if( result != BOAT_SUCCESS ) WsPortDisconnect(conn_ptr);
+
+    return result;
+}
+
+
+/*!*****************************************************************************
+@brief Receive a message
+
+Function: WsPortRecvMessage()
+
+    This function receives a text or binary message, which may be fragmented
+    into several frames, into <conn_ptr>->message. Control frames interleaved
+    are handled here: a ping is answered with a pong and a close closes the
+    connection.
+
+    If <deadline_ms> passes before the first byte of a message arrives, the
+    connection is kept. If it passes in the middle of a message, the
+    connection is closed because the rest of the message can't be told from
+    the next one. A message longer than WSPORT_MAX_MESSAGE_LEN also closes the
+    connection before its payload is buffered.
+
+@return
+    This function returns BOAT_SUCCESS if a message is received,
+    BOAT_ERROR_RPC_TIMEOUT if <deadline_ms> passes, or other error codes.
+
+@param[in] conn_ptr
+    The connection.
+
+@param[in] deadline_ms
+    The deadline as per BoatGetTimeMs().
+*******************************************************************************/
+static BOAT_RESULT WsPortRecvMessage(WsPortConn *conn_ptr, UINT64 deadline_ms)
+{
+    UINT8 header[8];
+    UINT8 mask[4];
+    UINT8 opcode;
+    BOATBOOL is_fin;
+    BOATBOOL is_masked;
+    BOATBOOL is_started = BOAT_FALSE;
+    UINT64 payload_len;
+    UINT8 *payload_ptr;
+    UINT8 control_payload[125];
+    UINT32 i;
+    BOAT_RESULT result;
+
+    conn_ptr->message.string_len = 0;
+    conn_ptr->message.string_ptr[0] = '\0';
+
+    while( 1 )
+    {
+        // Once a byte of the header is taken, the connection can't be kept on timeout
+        result = WsPortRecvAll(conn_ptr, header, 1, deadline_ms);
+        if( result != BOAT_SUCCESS ) break;
+        is_started = BOAT_TRUE;
+
+        result = WsPortRecvAll(conn_ptr, header + 1, 1, deadline_ms);
+        if( result != BOAT_SUCCESS ) break;
+
+        is_fin = (header[0] & 0x80) != 0;
+        opcode = header[0] & 0x0F;
+        is_masked = (header[1] & 0x80) != 0;
+        payload_len = header[1] & 0x7F;
+
+        if( payload_len == 126 )
+        {
+            result = WsPortRecvAll(conn_ptr, header, 2, deadline_ms);
+            if( result != BOAT_SUCCESS ) break;
+            payload_len = ((UINT64)header[0] << 8) | header[1];
+        }
+        else if( payload_len == 127 )
+        {
+            result = WsPortRecvAll(conn_ptr, header, 8, deadline_ms);
+            if( result != BOAT_SUCCESS ) break;
+            payload_len = 0;
+            for( i = 0; i < 8; i++ ) payload_len = (payload_len << 8) | header[i];
+        }
+
+        if( is_masked )
+        {
+            result = WsPortRecvAll(conn_ptr, mask, 4, deadline_ms);
+            if( result != BOAT_SUCCESS ) break;
+        }
+
+        if( opcode >= WSPORT_OPCODE_CLOSE )
+        {
+            // Control frames are never fragmented and at most 125 bytes
+            if( payload_len > sizeof(control_payload) || !is_fin )
+            {
+                BoatLog(BOAT_LOG_NORMAL, "Malformed WebSocket control frame.");
+                result = BOAT_ERROR_RPC_FAIL;
+                break;
+            }
+
+            result = WsPortRecvAll(conn_ptr, control_payload, (UINT32)payload_len, deadline_ms);
+            if( result != BOAT_SUCCESS ) break;
+
+            if( is_masked )
+            {
+                for( i = 0; i < payload_len; i++ ) control_payload[i] ^= mask[i & 3];
+            }
+
+            if( opcode == WSPORT_OPCODE_PING )
+            {
+                result = WsPortSendFrame(conn_ptr, WSPORT_OPCODE_PONG, control_payload, (UINT32)payload_len, deadline_ms);
+                if( result != BOAT_SUCCESS ) break;
+            }
+            else if( opcode == WSPORT_OPCODE_CLOSE )
+            {
+                // Echo the status code and close
+                WsPortSendFrame(conn_ptr, WSPORT_OPCODE_CLOSE, control_payload, payload_len >= 2 ? 2 : 0, deadline_ms);
+                BoatLog(BOAT_LOG_NORMAL, "WebSocket connection is closed by the node.");
+                result = BOAT_ERROR_RPC_FAIL;
+                break;
+            }
+
+            // A pong is ignored. A control frame doesn't start a message.
+            if( conn_ptr->message.string_len == 0 && opcode != WSPORT_OPCODE_CONTINUATION )
+            {
+                is_started = BOAT_FALSE;
+            }
+            continue;
+        }
+
+        if( payload_len > WSPORT_MAX_MESSAGE_LEN - conn_ptr->message.string_len )
+        {
+            BoatLog(BOAT_LOG_NORMAL, "WebSocket message is longer than %u bytes.", WSPORT_MAX_MESSAGE_LEN);
+            result = BOAT_ERROR_RPC_FAIL;
+            break;
+        }
+
+        result = WsPortStringReserve(&conn_ptr->message, (UINT32)payload_len);
+        if( result != BOAT_SUCCESS ) break;
+
+        payload_ptr = (UINT8 *)conn_ptr->message.string_ptr + conn_ptr->message.string_len;
+        result = WsPortRecvAll(conn_ptr, payload_ptr, (UINT32)payload_len, deadline_ms);
+        if( result != BOAT_SUCCESS ) break;
+
+        if( is_masked )
+        {
+            for( i = 0; i < payload_len; i++ ) payload_ptr[i] ^= mask[i & 3];
+        }
+
+        conn_ptr->message.string_len += (UINT32)payload_len;
+        conn_ptr->message.string_ptr[conn_ptr->message.string_len] = '\0';
+
+        if( is_fin ) return BOAT_SUCCESS;
+    }
+
+    if( result != BOAT_ERROR_RPC_TIMEOUT || is_started )
+    {
+        WsPortDisconnect(conn_ptr);
+    }
+
+    return result;
+}
+
+
+static UINT32 WsPortBase64Encode(CHAR *base64_str, const UINT8 *data_ptr, UINT32 data_len)
+{
+    static const CHAR *base64_table = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    UINT32 bits;
+    UINT32 i;
+    UINT32 j = 0;
+
+    for( i = 0; i < data_len; i += 3 )
+    {
+        bits = (UINT32)data_ptr[i] << 16;
+        if( i + 1 < data_len ) bits |= (UINT32)data_ptr[i + 1] << 8;
+        if( i + 2 < data_len ) bits |= data_ptr[i + 2];
+
+        base64_str[j++] = base64_table[(bits >> 18) & 0x3F];
+        base64_str[j++] = base64_table[(bits >> 12) & 0x3F];
+        base64_str[j++] = i + 1 < data_len ? base64_table[(bits >> 6) & 0x3F] : '=';
+        base64_str[j++] = i + 2 < data_len ? base64_table[bits & 0x3F] : '=';
+    }
+
+    base64_str[j] = '\0';
+
+    return j;
+}
+
+
+/*!*****************************************************************************
+@brief Open a TCP connection with timeout
+
+Function: WsPortConnectTcp()
+
+@return
+    This function returns the non-blocking socket connected, or -1.
+
+@param[in] host_str
+    Host name or IP address.
+
+@param[in] port_str
+    Port.
+
+@param[in] deadline_ms
+    The deadline as per BoatGetTimeMs().
+*******************************************************************************/
+static int WsPortConnectTcp(const CHAR *host_str, const CHAR *port_str, UINT64 deadline_ms)
+{
+    struct addrinfo hints;
+    struct addrinfo *addr_list_ptr;
+    struct addrinfo *addr_ptr;
+    int socket_fd = -1;
+    int socket_error;
+    socklen_t socket_error_len;
+    int flag;
+
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+
+    if( getaddrinfo(host_str, port_str, &hints, &addr_list_ptr) != 0 )
+    {
+        BoatLog(BOAT_LOG_NORMAL, "Fail to resolve %s.", host_str);
+        return -1;
+    }
+
+    for( addr_ptr = addr_list_ptr; addr_ptr != NULL; addr_ptr = addr_ptr->ai_next )
+    {
+        socket_fd = socket(addr_ptr->ai_family, addr_ptr->ai_socktype, addr_ptr->ai_protocol);
+        if( socket_fd < 0 ) continue;
+
+        fcntl(socket_fd, F_SETFL, fcntl(socket_fd, F_GETFL, 0) | O_NONBLOCK);
+        fcntl(socket_fd, F_SETFD, FD_CLOEXEC);
+
+        if( connect(socket_fd, addr_ptr->ai_addr, addr_ptr->ai_addrlen) == 0 ) break;
+
+        if( errno == EINPROGRESS && WsPortPoll(socket_fd, POLLOUT, deadline_ms) == BOAT_SUCCESS )
+        {
+            socket_error_len = sizeof(socket_error);
+            if(    getsockopt(socket_fd, SOL_SOCKET, SO_ERROR, &socket_error, &socket_error_len) == 0
+                && socket_error == 0 )
+            {
+                break;
+            }
+        }
+
+        close(socket_fd);
+        socket_fd = -1;
+    }
+
+    freeaddrinfo(addr_list_ptr);
+
+    if( socket_fd >= 0 )
+    {
+        // A REQUEST is sent in one frame. Don't wait for more to coalesce.
+        flag = 1;
+        setsockopt(socket_fd, IPPROTO_TCP, TCP_NODELAY, &flag, sizeof(flag));
+    }
+
+    return socket_fd;
+}
+
+
+/*!*****************************************************************************
+@brief Open the connection and perform the opening handshake
+
+Function: WsPortConnect()
+
+    This function connects to the node in <g_rpc_option>.node_url_str, in a
+    form of "ws://host[:port][/path]", and upgrades the connection to WebSocket.
+
+@return
+    This function returns BOAT_SUCCESS if successful. Otherwise it returns an
+    error code.
+
+@param[in] conn_ptr
+    The connection, which must be closed.
+
+@param[in] deadline_ms
+    The deadline as per BoatGetTimeMs().
+*******************************************************************************/
+static BOAT_RESULT WsPortConnect(WsPortConn *conn_ptr, UINT64 deadline_ms)
+{
+    const CHAR *url_str = g_rpc_option.node_url_str;
+    const CHAR *host_start_ptr;
+    const CHAR *host_end_ptr;
+    const CHAR *port_ptr;
+    const CHAR *path_ptr;
+    CHAR host_str[256];
+    CHAR port_str[8];
+    UINT8 key[16];
+    CHAR key_str[25];
+    CHAR accept_str[29];
+    UINT8 digest[SHA1_DIGEST_LENGTH];
+    SHA1_CTX sha1_ctx;
+    CHAR handshake_str[WSPORT_HANDSHAKE_MAX_LEN + 1];
+    UINT32 handshake_len;
+    CHAR *field_ptr;
+    BOAT_RESULT result;
+
+    if( strncmp(url_str, "ws://", 5) != 0 )
+    {
+        BoatLog(BOAT_LOG_NORMAL, "Unsupported URL: %s. Only ws:// is supported.", url_str);
+        return BOAT_ERROR_INCOMPATIBLE_ARGUMENTS;
+    }
+
+    // Split "ws://host[:port][/path]", where host may be "[IPv6 address]"
+    host_start_ptr = url_str + 5;
+    path_ptr = strchr(host_start_ptr, '/');
+    if( path_ptr == NULL ) path_ptr = host_start_ptr + strlen(host_start_ptr);
+
+    if( *host_start_ptr == '[' )
+    {
+        host_start_ptr++;
+        host_end_ptr = strchr(host_start_ptr, ']');
+        if( host_end_ptr == NULL || host_end_ptr > path_ptr ) host_end_ptr = path_ptr;
+        port_ptr = host_end_ptr + 1 < path_ptr && host_end_ptr[1] == ':' ? host_end_ptr + 2 : NULL;
+    }
+    else
+    {
+        for( host_end_ptr = host_start_ptr; host_end_ptr < path_ptr && *host_end_ptr != ':'; host_end_ptr++ );
+        port_ptr = host_end_ptr < path_ptr ? host_end_ptr + 1 : NULL;
+    }
+
+    if(    host_end_ptr == host_start_ptr
+        || (UINT32)(host_end_ptr - host_start_ptr) >= sizeof(host_str)
+        || (port_ptr != NULL && (port_ptr == path_ptr || (UINT32)(path_ptr - port_ptr) >= sizeof(port_str))) )
+    {
+        BoatLog(BOAT_LOG_NORMAL, "Unknown URL: %s", url_str);
+        return BOAT_ERROR_INCOMPATIBLE_ARGUMENTS;
+    }
+
+    memcpy(host_str, host_start_ptr, host_end_ptr - host_start_ptr);
+    host_str[host_end_ptr - host_start_ptr] = '\0';
+
+    if( port_ptr != NULL )
+    {
+        memcpy(port_str, port_ptr, path_ptr - port_ptr);
+        port_str[path_ptr - port_ptr] = '\0';
+    }
+    else
+    {
+        strcpy(port_str, "80");
+    }
+
+    conn_ptr->socket_fd = WsPortConnectTcp(host_str, port_str, deadline_ms);
+    if( conn_ptr->socket_fd < 0 )
+    {
+        BoatLog(BOAT_LOG_NORMAL, "Fail to connect %s.", url_str);
+        return BOAT_ERROR_RPC_FAIL;
+    }
+
+    // Opening handshake
+    random_stream(key, sizeof(key));
+    WsPortBase64Encode(key_str, key, sizeof(key));
+
+    handshake_len = snprintf(handshake_str, sizeof(handshake_str),
+                             "GET %s HTTP/1.1\r\n"
+                             "Host: %.*s\r\n"
+                             "Upgrade: websocket\r\n"
+                             "Connection: Upgrade\r\n"
+                             "Sec-WebSocket-Key: %s\r\n"
+                             "Sec-WebSocket-Version: 13\r\n\r\n",
+                             *path_ptr != '\0' ? path_ptr : "/",
+                             (int)(path_ptr - (url_str + 5)), url_str + 5,
+                             key_str);
+    if( handshake_len >= sizeof(handshake_str) )
+    {
+        BoatLog(BOAT_LOG_NORMAL, "URL is too long: %s", url_str);
+        WsPortDisconnect(conn_ptr);
+        return BOAT_ERROR_INCOMPATIBLE_ARGUMENTS;
+    }
+
+    result = WsPortSendAll(conn_ptr, (const UINT8 *)handshake_str, handshake_len, deadline_ms);
+    if( result != BOAT_SUCCESS )
+    {
+        WsPortDisconnect(conn_ptr);
+        return result;
+    }
+
+    // Read the HTTP response up to the empty line. Frames following it are
+    // left in the read-ahead buffer.
+    handshake_len = 0;
+    while( 1 )
+    {
+        if( handshake_len >= WSPORT_HANDSHAKE_MAX_LEN )
+        {
+            result = BOAT_ERROR_RPC_FAIL;
+            break;
+        }
+
+        result = WsPortRecvAll(conn_ptr, (UINT8 *)handshake_str + handshake_len, 1, deadline_ms);
+        if( result != BOAT_SUCCESS ) break;
+        handshake_len++;
+
+        if( handshake_len >= 4 && memcmp(handshake_str + handshake_len - 4, "\r\n\r\n", 4) == 0 ) break;
+    }
+    handshake_str[handshake_len] = '\0';
+
+    if( result == BOAT_SUCCESS && strncmp(handshake_str, "HTTP/1.1 101", 12) != 0 )
+    {
+        BoatLog(BOAT_LOG_NORMAL, "Node refuses WebSocket upgrade: %.*s", (int)strcspn(handshake_str, "\r\n"), handshake_str);
+        result = BOAT_ERROR_RPC_FAIL;
+    }
+
+    if( result == BOAT_SUCCESS )
+    {
+        // Sec-WebSocket-Accept = base64(SHA1(Sec-WebSocket-Key + GUID))
+        sha1_Init(&sha1_ctx);
+        sha1_Update(&sha1_ctx, (const UINT8 *)key_str, strlen(key_str));
+        sha1_Update(&sha1_ctx, (const UINT8 *)g_wsport_guid_str, strlen(g_wsport_guid_str));
+        sha1_Final(&sha1_ctx, digest);
+        WsPortBase64Encode(accept_str, digest, sizeof(digest));
+
+        // Header field names are case-insensitive
+        for( field_ptr = strstr(handshake_str, "\r\n"); field_ptr != NULL; field_ptr = strstr(field_ptr, "\r\n") )
+        {
+            field_ptr += 2;
+            if( strncasecmp(field_ptr, "sec-websocket-accept:", 21) == 0 )
+            {
+                field_ptr += 21;
+                while( *field_ptr == ' ' || *field_ptr == '\t' ) field_ptr++;
+                break;
+            }
+        }
+
+        if( field_ptr == NULL || strncmp(field_ptr, accept_str, strlen(accept_str)) != 0 )
+        {
+            BoatLog(BOAT_LOG_NORMAL, "Node answers WebSocket upgrade with a wrong Sec-WebSocket-Accept.");
+            result = BOAT_ERROR_RPC_FAIL;
+        }
+    }
+
+    if( result != BOAT_SUCCESS )
+    {
+        WsPortDisconnect(conn_ptr);
+        return result;
+    }
+
+    BoatLog(BOAT_LOG_VERBOSE, "WebSocket connection to %s is open.", url_str);
+
+    return BOAT_SUCCESS;
+}
+
+
+/*!*****************************************************************************
+@brief Initialize WebSocket porting.
+
+Function: WsPortInit()
+
+    This function allocates the connection of the calling thread. Other threads
+    allocate theirs on their first request. The connection is opened on the
+    first request.
+    
+
+@return
+    This function returns BOAT_SUCCESS if successful. Otherwise it returns
+    BOAT_ERROR_OUT_OF_MEMORY.
+    
+
+@param This function doesn't take any argument.
+
+*******************************************************************************/
+BOAT_RESULT WsPortInit(void)
+{
+    return WsPortGetConn() != NULL ? BOAT_SUCCESS : BOAT_ERROR_OUT_OF_MEMORY;
+}
+
+
+/*!*****************************************************************************
+@brief Deinitialize WebSocket porting.
+
+Function: WsPortDeinit()
+
+    This function closes the connection of the calling thread and frees its
+    buffers and queued notifications.
+    
+
+@return
+    This function doesn't return any value.
+    
+
+@param This function doesn't take any argument.
+
+*******************************************************************************/
+void WsPortDeinit(void)
+{
+    if( g_rpc_ctx.ws_conn_ptr != NULL )
+    {
+        pthread_setspecific(g_wsport_conn_key, NULL);
+        WsPortFreeConn(g_rpc_ctx.ws_conn_ptr);
+        g_rpc_ctx.ws_conn_ptr = NULL;
+    }
+
+    return;
+}
+
+
+/*!*****************************************************************************
+@brief Set options for use with WebSocket porting.
+
+Function: WsPortSetOpt()
+
+    This function closes the connection of the calling thread if it's open to
+    a node other than <rpc_option_ptr>->node_url_str. The connection to the new
+    node is opened on the next request.
+    
+
+@return
+    This function always returns BOAT_SUCCESS.
+    
+
+@param[in] rpc_option_ptr
+    A pointer to the option struct of RpcOption.
+
+*******************************************************************************/
+BOAT_RESULT WsPortSetOpt(const RpcOption *rpc_option_ptr)
+{
+    WsPortConn *conn_ptr = g_rpc_ctx.ws_conn_ptr;
+
+    if(    conn_ptr != NULL && conn_ptr->socket_fd >= 0
+        && (   rpc_option_ptr->node_url_str == NULL || conn_ptr->url_str == NULL
+            || strcmp(rpc_option_ptr->node_url_str, conn_ptr->url_str) != 0) )
+    {
+        WsPortDisconnect(conn_ptr);
+    }
+
+    return BOAT_SUCCESS;
+}
+
+
+/*!*****************************************************************************
+@brief Open the connection of the calling thread if it's not open
+
+Function: WsPortEnsureConnected()
+
+@return
+    This function returns BOAT_SUCCESS if the connection is open. Otherwise it
+    returns an error code.
+
+@param[in] conn_ptr
+    The connection.
+
+@param[in] deadline_ms
+    The deadline as per BoatGetTimeMs().
+*******************************************************************************/
+static BOAT_RESULT WsPortEnsureConnected(WsPortConn *conn_ptr, UINT64 deadline_ms)
+{
+    UINT64 connect_deadline_ms;
+    UINT32 url_len;
+    BOAT_RESULT result;
+
+    if( conn_ptr->socket_fd >= 0 ) return BOAT_SUCCESS;
+
+    connect_deadline_ms = BoatGetTimeMs() + BOAT_RPC_CONNECT_TIMEOUT_MS;
+    if( connect_deadline_ms > deadline_ms ) connect_deadline_ms = deadline_ms;
+
+    result = WsPortConnect(conn_ptr, connect_deadline_ms);
+    if( result != BOAT_SUCCESS ) return result;
+
+    if( conn_ptr->url_str == NULL || strcmp(conn_ptr->url_str, g_rpc_option.node_url_str) != 0 )
+    {
+        if( conn_ptr->url_str != NULL ) BoatFree(conn_ptr->url_str);
+
+        url_len = strlen(g_rpc_option.node_url_str);
+        conn_ptr->url_str = BoatMalloc(url_len + 1);
+        if( conn_ptr->url_str == NULL )
+        {
+            WsPortDisconnect(conn_ptr);
+            return BOAT_ERROR_OUT_OF_MEMORY;
+        }
+        memcpy(conn_ptr->url_str, g_rpc_option.node_url_str, url_len + 1);
+    }
+
+    return BOAT_SUCCESS;
+}
+
+
+/*!*****************************************************************************
+@brief Return a kept message to the caller
+
+Function: WsPortReturnKept()
+
+    This function copies a message taken from a RpcMsgQueue into
+    <conn_ptr>->message and frees it.
+
+@return
+    This function returns BOAT_SUCCESS if successful, or
+    BOAT_ERROR_OUT_OF_MEMORY.
+
+@param[in] conn_ptr
+    The connection.
+
+@param[in] kept_ptr
+    The message taken from a RpcMsgQueue.
+
+@param[in] kept_len
+    Length of <kept_ptr>.
+*******************************************************************************/
+static BOAT_RESULT WsPortReturnKept(WsPortConn *conn_ptr, CHAR *kept_ptr, UINT32 kept_len)
+{
+    BOAT_RESULT result;
+
+    conn_ptr->message.string_len = 0;
+    result = WsPortStringReserve(&conn_ptr->message, kept_len);
+    if( result == BOAT_SUCCESS )
+    {
+        memcpy(conn_ptr->message.string_ptr, kept_ptr, kept_len + 1);
+        conn_ptr->message.string_len = kept_len;
+    }
+
+    BoatFree(kept_ptr);
+
+    return result;
+}
+
+
+/*!*****************************************************************************
+@brief Send a REQUEST over WebSocket without waiting for its RESPONSE.
+
+Function: WsPortSend()
+
+    This function sends <request_str> as a text message over the connection of
+    the calling thread, opening it if needed. The RESPONSE is taken later with
+    WsPortRecv() by the "id" of the REQUEST.
+
+
+@return
+    This function returns BOAT_SUCCESS if successful. Otherwise it returns an
+    error code.
+    
+
+@param[in] request_str
+    A pointer to the request string to send.
+
+@param[in] request_len
+    The length of <request_str> excluding NULL terminator.
+
+*******************************************************************************/
+BOAT_RESULT WsPortSend(const CHAR *request_str, UINT32 request_len)
+{
+    WsPortConn *conn_ptr;
+    UINT64 deadline_ms;
+    BOAT_RESULT result;
+
+    if( g_rpc_option.node_url_str == NULL || request_str == NULL )
+    {
+        BoatLog(BOAT_LOG_CRITICAL, "Argument cannot be NULL.");
+        return BOAT_ERROR_NULL_POINTER;
+    }
+
+    conn_ptr = WsPortGetConn();
+    if( conn_ptr == NULL ) return BOAT_ERROR_OUT_OF_MEMORY;
+
+    // Timeout of the REQUEST, including connecting, as given by rpcintf
+    deadline_ms = BoatGetTimeMs() + g_rpc_ctx.timeout_ms;
+
+    result = WsPortEnsureConnected(conn_ptr, deadline_ms);
+    if( result != BOAT_SUCCESS ) return result;
+
+    // The connection is closed if the frame is partially sent
+    result = WsPortSendFrame(conn_ptr, WSPORT_OPCODE_TEXT, (const UINT8 *)request_str, request_len, deadline_ms);
+
+    BoatLog(BOAT_LOG_VERBOSE, "Post: %s", request_str);
+
+    return result;
+}
+
+
+/*!*****************************************************************************
+@brief Wait for the RESPONSE to a REQUEST sent over WebSocket.
+
+Function: WsPortRecv()
+
+    This function returns the RESPONSE with the given "id", either kept from
+    an earlier receipt or read from the connection. RESPONSEs to other
+    outstanding REQUESTs and subscription notifications received meanwhile are
+    kept for later.
+
+
+@return
+    This function returns BOAT_SUCCESS if successful, BOAT_ERROR_RPC_TIMEOUT
+    if the RESPONSE doesn't arrive in time, or other error codes.
+    
+
+@param[in] id
+    The "id" of the REQUEST, or -1 to take the next RESPONSE whatever its "id".
+
+@param[in] timeout_ms
+    Max time to wait, in millisecond.
+
+@param[out] response_str_ptr
+    The address of a CHAR* pointer (i.e. a double pointer) to hold the address
+    of the receiving buffer.\n
+    The receiving buffer is internally maintained by wsport and the caller
+    shall only read from the buffer. DO NOT modify the buffer or save the address
+    for later use.
+
+@param[out] response_len_ptr
+    The address of a UINT32 integer to hold the effective length of
+    <response_str_ptr> excluding NULL terminator.
+
+*******************************************************************************/
+BOAT_RESULT WsPortRecv(SINT64 id,
+                      UINT32 timeout_ms,
+                      BOAT_OUT CHAR **response_str_ptr,
+                      BOAT_OUT UINT32 *response_len_ptr)
+{
+    WsPortConn *conn_ptr = g_rpc_ctx.ws_conn_ptr;
+    UINT64 deadline_ms;
+    SINT64 message_id;
+    CHAR *kept_ptr;
+    UINT32 kept_len;
+    BOAT_RESULT result;
+
+    if( response_str_ptr == NULL || response_len_ptr == NULL )
+    {
+        BoatLog(BOAT_LOG_CRITICAL, "Argument cannot be NULL.");
+        return BOAT_ERROR_NULL_POINTER;
+    }
+
+    if( conn_ptr == NULL ) return BOAT_ERROR_RPC_FAIL;
+
+    kept_ptr = NULL;
+    if( id >= 0 ) kept_ptr = RpcMsgQueueTake(&conn_ptr->responses, id, &kept_len);
+
+    if( kept_ptr != NULL )
+    {
+        result = WsPortReturnKept(conn_ptr, kept_ptr, kept_len);
+        if( result != BOAT_SUCCESS ) return result;
+    }
+    else
+    {
+        if( conn_ptr->socket_fd < 0 ) return BOAT_ERROR_RPC_FAIL;
+
+        deadline_ms = BoatGetTimeMs() + timeout_ms;
+
+        while( 1 )
+        {
+            result = WsPortRecvMessage(conn_ptr, deadline_ms);
+            if( result != BOAT_SUCCESS ) return result;
+
+            // Any non-notification message answers a REQUEST without "id"
+            if( RpcMsgScan(conn_ptr->message.string_ptr, conn_ptr->message.string_len, &message_id) )
+            {
+                RpcMsgQueuePush(&conn_ptr->notifications, conn_ptr->message.string_ptr, conn_ptr->message.string_len, -1);
+            }
+            else if( id < 0 || message_id == id )
+            {
+                break;
+            }
+            else
+            {
+                RpcMsgQueuePush(&conn_ptr->responses, conn_ptr->message.string_ptr, conn_ptr->message.string_len, message_id);
+            }
+        }
+    }
+
+    *response_str_ptr = conn_ptr->message.string_ptr;
+    *response_len_ptr = conn_ptr->message.string_len;
+
+    BoatLog(BOAT_LOG_VERBOSE, "Response: %s", *response_str_ptr);
+
+    return BOAT_SUCCESS;
+}
+
+
+/*!*****************************************************************************
+@brief Send a REQUEST over WebSocket and wait for its RESPONSE.
+
+Function: WsPortRequestSync()
+
+    This function sends <request_str> with WsPortSend() and waits for the
+    RESPONSE with the same "id" with WsPortRecv().
+
+    If the node has closed an idle connection, the connection is re-opened and
+    the REQUEST is sent again once.
+
+
+@return
+    This function returns BOAT_SUCCESS if successful, BOAT_ERROR_RPC_TIMEOUT
+    if no RESPONSE arrives in time, or other error codes.
+    
+
+@param[in] request_str
+    A pointer to the request string to send.
+
+@param[in] request_len
+    The length of <request_str> excluding NULL terminator.
+
+@param[out] response_str_ptr
+    The address of a CHAR* pointer (i.e. a double pointer) to hold the address
+    of the receiving buffer.\n
+    The receiving buffer is internally maintained by wsport and the caller
+    shall only read from the buffer. DO NOT modify the buffer or save the address
+    for later use.
+
+@param[out] response_len_ptr
+    The address of a UINT32 integer to hold the effective length of
+    <response_str_ptr> excluding NULL terminator.
+
+*******************************************************************************/
+BOAT_RESULT WsPortRequestSync(const CHAR *request_str,
+                             UINT32 request_len,
+                             BOAT_OUT CHAR **response_str_ptr,
+                             BOAT_OUT UINT32 *response_len_ptr)
+{
+    SINT64 request_id;
+    BOATBOOL is_reused;
+    BOATBOOL is_retried = BOAT_FALSE;
+    BOAT_RESULT result;
+    boat_try_declare;
+
+
+    if( request_str == NULL || response_str_ptr == NULL || response_len_ptr == NULL )
+    {
+        BoatLog(BOAT_LOG_CRITICAL, "Argument cannot be NULL.");
+        boat_throw(BOAT_ERROR_NULL_POINTER, WsPortRequestSync_cleanup);
+    }
+
+    RpcMsgScan(request_str, request_len, &request_id);
+
+    while( 1 )
+    {
+        is_reused = g_rpc_ctx.ws_conn_ptr != NULL && g_rpc_ctx.ws_conn_ptr->socket_fd >= 0;
+
+        result = WsPortSend(request_str, request_len);
+        if( result == BOAT_SUCCESS )
+        {
+            result = WsPortRecv(request_id, g_rpc_ctx.timeout_ms, response_str_ptr, response_len_ptr);
+        }
+
+        if( result == BOAT_SUCCESS ) break;
+
+        // An idle connection may have been closed by the node
+        if(    result == BOAT_ERROR_RPC_TIMEOUT || result == BOAT_ERROR_NULL_POINTER
+            || !is_reused || is_retried )
+        {
+            boat_throw(result, WsPortRequestSync_cleanup);
+        }
+
+        is_retried = BOAT_TRUE;
+    }
+
+    result = BOAT_SUCCESS;
+
+
+    // Exceptional Clean Up
+    boat_catch(WsPortRequestSync_cleanup)
+    {
+        BoatLog(BOAT_LOG_NORMAL, "Exception: %d", boat_exception);
+        result = boat_exception;
+    }
+
+    return result;
+}
+
+
+/*!*****************************************************************************
+@brief Wait for a subscription notification.
+
+Function: WsPortWaitNotification()
+
+    This function returns the oldest queued subscription notification, or
+    waits for one to arrive on the connection of the calling thread. RESPONSEs
+    received meanwhile are kept for WsPortRecv().
+
+    The connection must have been opened by a REQUEST, typically eth_subscribe.
+
+
+@return
+    This function returns BOAT_SUCCESS if a notification is received,
+    BOAT_ERROR_RPC_TIMEOUT if none arrives in <timeout_ms>, or other error
+    codes, e.g. BOAT_ERROR_RPC_FAIL if the connection is lost and thus the
+    subscriptions on it.
+    
+
+@param[in] timeout_ms
+    Max time to wait, in millisecond.
+
+@param[out] notification_str_ptr
+    The address of a CHAR* pointer to hold the address of the notification,
+    e.g. {"jsonrpc":"2.0","method":"eth_subscription","params":{...}}.\n
+    The buffer is internally maintained by wsport. It's valid until the next
+    call to wsport.
+
+@param[out] notification_len_ptr
+    The address of a UINT32 integer to hold the length of the notification
+    excluding NULL terminator.
+
+*******************************************************************************/
+BOAT_RESULT WsPortWaitNotification(UINT32 timeout_ms,
+                                  BOAT_OUT CHAR **notification_str_ptr,
+                                  BOAT_OUT UINT32 *notification_len_ptr)
+{
+    WsPortConn *conn_ptr = g_rpc_ctx.ws_conn_ptr;
+    UINT64 deadline_ms;
+    SINT64 message_id;
+    CHAR *notification_ptr;
+    UINT32 notification_len;
+    BOAT_RESULT result;
+
+    if( notification_str_ptr == NULL || notification_len_ptr == NULL )
+    {
+        BoatLog(BOAT_LOG_CRITICAL, "Argument cannot be NULL.");
+        return BOAT_ERROR_NULL_POINTER;
+    }
+
+    if( conn_ptr == NULL ) return BOAT_ERROR_RPC_FAIL;
+
+    notification_ptr = RpcMsgQueueTake(&conn_ptr->notifications, -1, &notification_len);
+
+    if( notification_ptr != NULL )
+    {
+        result = WsPortReturnKept(conn_ptr, notification_ptr, notification_len);
+        if( result != BOAT_SUCCESS ) return result;
+    }
+    else
+    {
+        if( conn_ptr->socket_fd < 0 ) return BOAT_ERROR_RPC_FAIL;
+
+        deadline_ms = BoatGetTimeMs() + timeout_ms;
+
+        while( 1 )
+        {
+            result = WsPortRecvMessage(conn_ptr, deadline_ms);
+            if( result != BOAT_SUCCESS ) return result;
+
+            if( RpcMsgScan(conn_ptr->message.string_ptr, conn_ptr->message.string_len, &message_id) ) break;
+
+            RpcMsgQueuePush(&conn_ptr->responses, conn_ptr->message.string_ptr, conn_ptr->message.string_len, message_id);
+        }
+    }
+
+    *notification_str_ptr = conn_ptr->message.string_ptr;
+    *notification_len_ptr = conn_ptr->message.string_len;
+
+    return BOAT_SUCCESS;
+}
+
+#endif // end of #if RPC_USE_WEBSOCKET == 1
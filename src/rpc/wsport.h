@@ -0,0 +1,75 @@
+/******************************************************************************
+Copyright (C) 2018-2019 AITOS.IO
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+of the Software, and to permit persons to whom the Software is furnished to do
+so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+******************************************************************************/
+
+/*!@brief WebSocket porting header file
+
+@file
+wsport.h is the header file of WebSocket porting of RPC.
+
+DO NOT call functions in this file directly. Instead call wrapper functions
+provided by rpcport.
+
+To use WebSocket porting, RPC_USE_WEBSOCKET in boatoptions.h must set to 1.
+*/
+
+#ifndef __WSPORT_H__
+#define __WSPORT_H__
+
+#if RPC_USE_WEBSOCKET == 1
+
+#include "wallet/boattypes.h"
+#include "wallet/boatoptions.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+BOAT_RESULT WsPortInit(void);
+
+void WsPortDeinit(void);
+
+BOAT_RESULT WsPortSetOpt(const RpcOption *rpc_option_ptr);
+
+BOAT_RESULT WsPortSend(const CHAR *request_str, UINT32 request_len);
+
+BOAT_RESULT WsPortRecv(SINT64 id,
+                      UINT32 timeout_ms,
+                      BOAT_OUT CHAR **response_str_ptr,
+                      BOAT_OUT UINT32 *response_len_ptr);
+
+BOAT_RESULT WsPortRequestSync(const CHAR *request_str,
+                             UINT32 request_len,
+                             BOAT_OUT CHAR **response_str_ptr,
+                             BOAT_OUT UINT32 *response_len_ptr);
+
+BOAT_RESULT WsPortWaitNotification(UINT32 timeout_ms,
+                                  BOAT_OUT CHAR **notification_str_ptr,
+                                  BOAT_OUT UINT32 *notification_len_ptr);
+
+
+#ifdef __cplusplus
+}
+#endif /* end of __cplusplus */
+
+#endif // end of #if RPC_USE_WEBSOCKET == 1
+
+#endif
@@ -0,0 +1,692 @@
+/******************************************************************************
+Copyright (C) 2018-2019 AITOS.IO
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+of the Software, and to permit persons to whom the Software is furnished to do
+so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+******************************************************************************/
+
+/*!@brief Compact payload codec for telemetry
+
+@file
+codec.c encodes fixed-point telemetry records as delta varints and compresses
+blocks of them.
+*/
+
+#include "wallet/boattypes.h"
+#include "utilities/utility.h"
+#include "utilities/codec.h"
+
+
+//! Map signed to unsigned so that small magnitudes have short varints
+#define CODEC_ZIGZAG(v) (((UINT64)(v) << 1) ^ (UINT64)((SINT64)(v) >> 63))
+#define CODEC_UNZIGZAG(u) ((SINT64)(((u) >> 1) ^ (~((u) & 1) + 1)))
+
+
+/*!*****************************************************************************
+@brief Encode an unsigned integer as varint
+
+Function: BoatCodecPutVarint()
+
+    The integer is stored 7 bits per byte, least significant group first. The
+    most significant bit of a byte is set if more bytes follow.
+
+@return
+    This function returns the length of the varint, 1 to BOAT_CODEC_VARINT_MAX_LEN.
+
+@param[out] to_ptr
+    Buffer of at least BOAT_CODEC_VARINT_MAX_LEN bytes.
+
+@param[in] value
+    The integer to encode.
+*******************************************************************************/
+UINT32 BoatCodecPutVarint(BOAT_OUT UINT8 *to_ptr, UINT64 value)
+{
+    UINT32 len = 0;
+
+    while( value >= 0x80 )
+    {
+        to_ptr[len++] = (UINT8)(value | 0x80);
+        value >>= 7;
+    }
+    to_ptr[len++] = (UINT8)value;
+
+    return len;
+}
+
+
+/*!*****************************************************************************
+@brief Decode a varint
+
+Function: BoatCodecGetVarint()
+
+@return
+    This function returns the length of the varint consumed.\n
+    It returns 0 if the varint is truncated or longer than 64 bits.
+
+@param[in] from_ptr
+    The varint.
+
+@param[in] from_len
+    Bytes available at <from_ptr>.
+
+@param[out] value_ptr
+    The decoded integer.
+*******************************************************************************/
+UINT32 BoatCodecGetVarint(const UINT8 *from_ptr, UINT32 from_len, BOAT_OUT UINT64 *value_ptr)
+{
+    UINT64 value = 0;
+    UINT32 shift = 0;
+    UINT32 i;
+
+    for( i = 0; i < from_len && i < BOAT_CODEC_VARINT_MAX_LEN; i++ )
+    {
+        value |= (UINT64)(from_ptr[i] & 0x7F) << shift;
+
+        if( (from_ptr[i] & 0x80) == 0 )
+        {
+            // The 10th byte may only carry the most significant bit
+            if( i == BOAT_CODEC_VARINT_MAX_LEN - 1 && from_ptr[i] > 1 ) return 0;
+
+            *value_ptr = value;
+            return i + 1;
+        }
+
+        shift += 7;
+    }
+
+    return 0;
+}
+
+
+/*!*****************************************************************************
+@brief Convert a decimal string to fixed-point integer
+
+Function: BoatCodecFixedFromString()
+
+    This function converts e.g. "-12.3456" with <frac_digits> = 6 to -12345600
+    without using float. Fractional digits beyond <frac_digits> are truncated.
+
+@return
+    This function returns BOAT_SUCCESS if successful.\n
+    It returns BOAT_ERROR_INVALID_LENGTH if the string is empty or the value
+    overflows, or BOAT_ERROR if it's not a decimal number.
+
+@param[in] from_str
+    The decimal string, need not be null terminated.
+
+@param[in] from_len
+    Length of <from_str>.
+
+@param[in] frac_digits
+    Number of fractional digits of the fixed-point integer.
+
+@param[out] value_ptr
+    The fixed-point integer, i.e. the decimal multiplied by 10^<frac_digits>.
+*******************************************************************************/
+BOAT_RESULT BoatCodecFixedFromString(const CHAR *from_str,
+                                     UINT32 from_len,
+                                     UINT32 frac_digits,
+                                     BOAT_OUT SINT64 *value_ptr)
+{
+    UINT64 value = 0;
+    UINT32 digit_num = 0;
+    UINT32 frac_num = 0;
+    BOATBOOL negative = BOAT_FALSE;
+    BOATBOOL in_frac = BOAT_FALSE;
+    UINT32 i = 0;
+    CHAR c;
+
+    if( from_str == NULL || value_ptr == NULL ) return BOAT_ERROR_NULL_POINTER;
+
+    if( i < from_len && (from_str[i] == '-' || from_str[i] == '+') )
+    {
+        negative = (from_str[i] == '-');
+        i++;
+    }
+
+    for( ; i < from_len; i++ )
+    {
+        c = from_str[i];
+
+        if( c == '.' && in_frac == BOAT_FALSE )
+        {
+            in_frac = BOAT_TRUE;
+            continue;
+        }
+
+        if( c < '0' || c > '9' ) return BOAT_ERROR;
+
+        digit_num++;
+        if( in_frac == BOAT_TRUE )
+        {
+            if( frac_num == frac_digits ) continue;
+            frac_num++;
+        }
+
+        // 18 significant digits always fit in SINT64
+        if( value == 0 && c == '0' ) continue;
+        if( value >= 100000000000000000ull ) return BOAT_ERROR_INVALID_LENGTH;
+        value = value * 10 + (c - '0');
+    }
+
+    if( digit_num == 0 ) return BOAT_ERROR_INVALID_LENGTH;
+
+    for( ; frac_num < frac_digits; frac_num++ )
+    {
+        if( value >= 100000000000000000ull ) return BOAT_ERROR_INVALID_LENGTH;
+        value *= 10;
+    }
+
+    *value_ptr = (negative == BOAT_TRUE) ? -(SINT64)value : (SINT64)value;
+
+    return BOAT_SUCCESS;
+}
+
+
+/*!*****************************************************************************
+@brief Initialize the state of a record stream
+
+Function: BoatCodecInit()
+
+@return
+    This function returns BOAT_SUCCESS if successful.\n
+    It returns BOAT_ERROR_INVALID_LENGTH if <field_num> is 0 or exceeds
+    BOAT_CODEC_MAX_FIELDS.
+
+@param[out] codec_ptr
+    The state to initialize. The first record is a key frame.
+
+@param[in] field_num
+    Number of fields per record.
+*******************************************************************************/
+BOAT_RESULT BoatCodecInit(BOAT_OUT BoatCodec *codec_ptr, UINT32 field_num)
+{
+    if( codec_ptr == NULL ) return BOAT_ERROR_NULL_POINTER;
+
+    if( field_num == 0 || field_num > BOAT_CODEC_MAX_FIELDS )
+    {
+        BoatLog(BOAT_LOG_NORMAL, "Record of %u fields is not supported.", field_num);
+        return BOAT_ERROR_INVALID_LENGTH;
+    }
+
+    memset(codec_ptr, 0, sizeof(BoatCodec));
+    codec_ptr->field_num = field_num;
+    codec_ptr->key_frame = BOAT_TRUE;
+
+    return BOAT_SUCCESS;
+}
+
+
+/*!*****************************************************************************
+@brief Make the next record a key frame
+
+Function: BoatCodecReset()
+
+    Call it at the start of every independently decodable unit, e.g. a batch
+    or a storage slot.
+
+@return This function doesn't return any thing.
+
+@param[in] codec_ptr
+    The state of the record stream.
+*******************************************************************************/
+void BoatCodecReset(BoatCodec *codec_ptr)
+{
+    if( codec_ptr != NULL ) codec_ptr->key_frame = BOAT_TRUE;
+}
+
+
+/*!*****************************************************************************
+@brief Encode a record
+
+Function: BoatCodecEncode()
+
+@return
+    This function returns BOAT_SUCCESS if successful.\n
+    It returns BOAT_ERROR_INVALID_LENGTH if <to_size> is too small, in which
+    case the state is untouched.
+
+@param[in] codec_ptr
+    The state of the record stream.
+
+@param[in] field_array
+    The fixed-point fields of the record.
+
+@param[out] to_ptr
+    Buffer for the encoded record.
+
+@param[in] to_size
+    Size of <to_ptr>. BOAT_CODEC_RECORD_MAX_LEN(field_num) always suffices.
+
+@param[out] to_len_ptr
+    Length of the encoded record.
+*******************************************************************************/
+BOAT_RESULT BoatCodecEncode(BoatCodec *codec_ptr,
+                            const SINT64 *field_array,
+                            BOAT_OUT UINT8 *to_ptr,
+                            UINT32 to_size,
+                            BOAT_OUT UINT32 *to_len_ptr)
+{
+    UINT8 varint[BOAT_CODEC_VARINT_MAX_LEN];
+    UINT32 varint_len;
+    UINT32 to_len = 0;
+    UINT64 delta;
+    UINT32 i;
+
+    if( codec_ptr == NULL || field_array == NULL || to_ptr == NULL || to_len_ptr == NULL )
+    {
+        return BOAT_ERROR_NULL_POINTER;
+    }
+
+    for( i = 0; i < codec_ptr->field_num; i++ )
+    {
+        // Wrap-around subtraction, so that any delta round-trips
+        if( codec_ptr->key_frame == BOAT_TRUE )
+        {
+            delta = (UINT64)field_array[i];
+        }
+        else
+        {
+            delta = (UINT64)field_array[i] - (UINT64)codec_ptr->last[i];
+        }
+
+        varint_len = BoatCodecPutVarint(varint, CODEC_ZIGZAG(delta));
+        if( to_len + varint_len > to_size ) return BOAT_ERROR_INVALID_LENGTH;
+
+        memcpy(to_ptr + to_len, varint, varint_len);
+        to_len += varint_len;
+    }
+
+    memcpy(codec_ptr->last, field_array, codec_ptr->field_num * sizeof(SINT64));
+    codec_ptr->key_frame = BOAT_FALSE;
+    *to_len_ptr = to_len;
+
+    return BOAT_SUCCESS;
+}
+
+
+/*!*****************************************************************************
+@brief Decode a record
+
+Function: BoatCodecDecode()
+
+@return
+    This function returns BOAT_SUCCESS if successful.\n
+    It returns BOAT_ERROR_INVALID_LENGTH if the record is truncated or
+    malformed, in which case the state is untouched.
+
+@param[in] codec_ptr
+    The state of the record stream.
+
+@param[in] from_ptr
+    The encoded record, possibly followed by more records.
+
+@param[in] from_len
+    Bytes available at <from_ptr>.
+
+@param[out] field_array
+    The fixed-point fields of the record.
+
+@param[out] from_used_len_ptr
+    Length of the encoded record consumed.
+*******************************************************************************/
+BOAT_RESULT BoatCodecDecode(BoatCodec *codec_ptr,
+                            const UINT8 *from_ptr,
+                            UINT32 from_len,
+                            BOAT_OUT SINT64 *field_array,
+                            BOAT_OUT UINT32 *from_used_len_ptr)
+{
+    UINT64 zigzag;
+    SINT64 field[BOAT_CODEC_MAX_FIELDS];
+    UINT32 varint_len;
+    UINT32 from_used_len = 0;
+    UINT32 i;
+
+    if( codec_ptr == NULL || from_ptr == NULL || field_array == NULL || from_used_len_ptr == NULL )
+    {
+        return BOAT_ERROR_NULL_POINTER;
+    }
+
+    for( i = 0; i < codec_ptr->field_num; i++ )
+    {
+        varint_len = BoatCodecGetVarint(from_ptr + from_used_len, from_len - from_used_len, &zigzag);
+        if( varint_len == 0 ) return BOAT_ERROR_INVALID_LENGTH;
+        from_used_len += varint_len;
+
+        if( codec_ptr->key_frame == BOAT_TRUE )
+        {
+            field[i] = CODEC_UNZIGZAG(zigzag);
+        }
+        else
+        {
+            field[i] = (SINT64)((UINT64)codec_ptr->last[i] + (UINT64)CODEC_UNZIGZAG(zigzag));
+        }
+    }
+
+    memcpy(field_array, field, codec_ptr->field_num * sizeof(SINT64));
+    memcpy(codec_ptr->last, field, codec_ptr->field_num * sizeof(SINT64));
+    codec_ptr->key_frame = BOAT_FALSE;
+    *from_used_len_ptr = from_used_len;
+
+    return BOAT_SUCCESS;
+}
+
+
+#if BOAT_CODEC_USE_LZ == 1
+
+//! Shortest match worth encoding
+#define CODEC_LZ_MIN_MATCH 4
+//! Farthest match, limited by the 2-byte offset
+#define CODEC_LZ_MAX_OFFSET 0xFFFF
+
+static UINT32 CodecLzRead32(const UINT8 *from_ptr)
+{
+    return   (UINT32)from_ptr[0] | ((UINT32)from_ptr[1] << 8)
+           | ((UINT32)from_ptr[2] << 16) | ((UINT32)from_ptr[3] << 24);
+}
+
+
+static UINT32 CodecLzHash(UINT32 sequence)
+{
+    return (sequence * 2654435761u) >> (32 - BOAT_CODEC_LZ_HASH_BITS);
+}
+
+
+/*!*****************************************************************************
+@brief Write a length nibble extension
+
+Function: CodecLzPutLength()
+
+@return
+    This function returns the new output position, or NULL if it overflows.
+
+@param[out] to_ptr
+    Output position.
+
+@param[in] to_end_ptr
+    End of output buffer.
+
+@param[in] length
+    Length in excess of the nibble, i.e. length - 15.
+*******************************************************************************/
+static UINT8 *CodecLzPutLength(UINT8 *to_ptr, const UINT8 *to_end_ptr, UINT32 length)
+{
+    while( length >= 255 )
+    {
+        if( to_ptr >= to_end_ptr ) return NULL;
+        *to_ptr++ = 255;
+        length -= 255;
+    }
+
+    if( to_ptr >= to_end_ptr ) return NULL;
+    *to_ptr++ = (UINT8)length;
+
+    return to_ptr;
+}
+
+
+/*!*****************************************************************************
+@brief Write a sequence of literals optionally followed by a match
+
+Function: CodecLzPutSequence()
+
+@return
+    This function returns the new output position, or NULL if it overflows.
+
+@param[out] to_ptr
+    Output position.
+
+@param[in] to_end_ptr
+    End of output buffer.
+
+@param[in] literal_ptr
+    The literals.
+
+@param[in] literal_len
+    Number of literals.
+
+@param[in] offset
+    Distance of the match, 0 for the last sequence without match.
+
+@param[in] match_len
+    Length of the match, at least CODEC_LZ_MIN_MATCH if <offset> is not 0.
+*******************************************************************************/
+static UINT8 *CodecLzPutSequence(UINT8 *to_ptr, const UINT8 *to_end_ptr,
+                                 const UINT8 *literal_ptr, UINT32 literal_len,
+                                 UINT32 offset, UINT32 match_len)
+{
+    UINT8 *token_ptr;
+    UINT32 match_code = (offset != 0) ? match_len - CODEC_LZ_MIN_MATCH : 0;
+
+    if( to_ptr >= to_end_ptr ) return NULL;
+    token_ptr = to_ptr++;
+    *token_ptr = (UINT8)(((literal_len < 15 ? literal_len : 15) << 4) | (match_code < 15 ? match_code : 15));
+
+    if( literal_len >= 15 )
+    {
+        to_ptr = CodecLzPutLength(to_ptr, to_end_ptr, literal_len - 15);
+        if( to_ptr == NULL ) return NULL;
+    }
+
+    if( (UINT32)(to_end_ptr - to_ptr) < literal_len ) return NULL;
+    memcpy(to_ptr, literal_ptr, literal_len);
+    to_ptr += literal_len;
+
+    if( offset != 0 )
+    {
+        if( to_end_ptr - to_ptr < 2 ) return NULL;
+        *to_ptr++ = (UINT8)offset;
+        *to_ptr++ = (UINT8)(offset >> 8);
+
+        if( match_code >= 15 )
+        {
+            to_ptr = CodecLzPutLength(to_ptr, to_end_ptr, match_code - 15);
+        }
+    }
+
+    return to_ptr;
+}
+
+
+/*!*****************************************************************************
+@brief Compress a block
+
+Function: BoatCodecLzCompress()
+
+    This function compresses with greedy matching over a hash table of
+    2^BOAT_CODEC_LZ_HASH_BITS entries kept on stack. It suits repetitive
+    payloads such as batched telemetry records.
+
+@return
+    This function returns BOAT_SUCCESS if successful.\n
+    It returns BOAT_ERROR_INVALID_LENGTH if the compressed block doesn't fit
+    in <to_size>. BOAT_CODEC_LZ_BOUND(from_len) always suffices.
+
+@param[in] from_ptr
+    The data to compress.
+
+@param[in] from_len
+    Length of <from_ptr>.
+
+@param[out] to_ptr
+    Buffer for the compressed block.
+
+@param[in] to_size
+    Size of <to_ptr>.
+
+@param[out] to_len_ptr
+    Length of the compressed block.
+*******************************************************************************/
+BOAT_RESULT BoatCodecLzCompress(const UINT8 *from_ptr,
+                                UINT32 from_len,
+                                BOAT_OUT UINT8 *to_ptr,
+                                UINT32 to_size,
+                                BOAT_OUT UINT32 *to_len_ptr)
+{
+    UINT32 hash_table[1u << BOAT_CODEC_LZ_HASH_BITS];
+    const UINT8 *to_end_ptr = to_ptr + to_size;
+    UINT8 *out_ptr = to_ptr;
+    UINT32 anchor = 0;
+    UINT32 pos = 0;
+    UINT32 ref;
+    UINT32 hash;
+    UINT32 match_len;
+
+    if( from_ptr == NULL || to_ptr == NULL || to_len_ptr == NULL ) return BOAT_ERROR_NULL_POINTER;
+
+    memset(hash_table, 0xFF, sizeof(hash_table));
+
+    while( from_len >= CODEC_LZ_MIN_MATCH && pos <= from_len - CODEC_LZ_MIN_MATCH )
+    {
+        hash = CodecLzHash(CodecLzRead32(from_ptr + pos));
+        ref = hash_table[hash];
+        hash_table[hash] = pos;
+
+        if(    ref == 0xFFFFFFFF
+            || pos - ref > CODEC_LZ_MAX_OFFSET
+            || memcmp(from_ptr + ref, from_ptr + pos, CODEC_LZ_MIN_MATCH) != 0 )
+        {
+            pos++;
+            continue;
+        }
+
+        match_len = CODEC_LZ_MIN_MATCH;
+        while( pos + match_len < from_len && from_ptr[ref + match_len] == from_ptr[pos + match_len] )
+        {
+            match_len++;
+        }
+
+        out_ptr = CodecLzPutSequence(out_ptr, to_end_ptr,
+                                     from_ptr + anchor, pos - anchor,
+                                     pos - ref, match_len);
+        if( out_ptr == NULL ) return BOAT_ERROR_INVALID_LENGTH;
+
+        pos += match_len;
+        anchor = pos;
+    }
+
+    // Last sequence with the remaining literals, possibly none
+    out_ptr = CodecLzPutSequence(out_ptr, to_end_ptr, from_ptr + anchor, from_len - anchor, 0, 0);
+    if( out_ptr == NULL ) return BOAT_ERROR_INVALID_LENGTH;
+
+    *to_len_ptr = (UINT32)(out_ptr - to_ptr);
+
+    return BOAT_SUCCESS;
+}
+
+
+/*!*****************************************************************************
+@brief Decompress a block
+
+Function: BoatCodecLzDecompress()
+
+    Every length and offset is checked against the input and output buffers,
+    so a corrupted block fails without overrun.
+
+@return
+    This function returns BOAT_SUCCESS if successful.\n
+    It returns BOAT_ERROR_INVALID_LENGTH if the block is malformed or the
+    decompressed data don't fit in <to_size>.
+
+@param[in] from_ptr
+    The compressed block.
+
+@param[in] from_len
+    Length of <from_ptr>.
+
+@param[out] to_ptr
+    Buffer for the decompressed data.
+
+@param[in] to_size
+    Size of <to_ptr>.
+
+@param[out] to_len_ptr
+    Length of the decompressed data.
+*******************************************************************************/
+BOAT_RESULT BoatCodecLzDecompress(const UINT8 *from_ptr,
+                                  UINT32 from_len,
+                                  BOAT_OUT UINT8 *to_ptr,
+                                  UINT32 to_size,
+                                  BOAT_OUT UINT32 *to_len_ptr)
+{
+    UINT32 in_pos = 0;
+    UINT32 out_pos = 0;
+    UINT32 token;
+    UINT32 length;
+    UINT32 offset;
+    UINT8 extension;
+
+    if( from_ptr == NULL || to_ptr == NULL || to_len_ptr == NULL ) return BOAT_ERROR_NULL_POINTER;
+
+    while( in_pos < from_len )
+    {
+        token = from_ptr[in_pos++];
+
+        // Literals
+        length = token >> 4;
+        if( length == 15 )
+        {
+            do
+            {
+                if( in_pos >= from_len ) return BOAT_ERROR_INVALID_LENGTH;
+                extension = from_ptr[in_pos++];
+                length += extension;
+            }while( extension == 255 );
+        }
+
+        if( length > from_len - in_pos || length > to_size - out_pos ) return BOAT_ERROR_INVALID_LENGTH;
+        memcpy(to_ptr + out_pos, from_ptr + in_pos, length);
+        in_pos += length;
+        out_pos += length;
+
+        // The last sequence has no match
+        if( in_pos == from_len ) break;
+
+        // Match
+        if( from_len - in_pos < 2 ) return BOAT_ERROR_INVALID_LENGTH;
+        offset = from_ptr[in_pos] | ((UINT32)from_ptr[in_pos + 1] << 8);
+        in_pos += 2;
+
+        length = token & 0x0F;
+        if( length == 15 )
+        {
+            do
+            {
+                if( in_pos >= from_len ) return BOAT_ERROR_INVALID_LENGTH;
+                extension = from_ptr[in_pos++];
+                length += extension;
+            }while( extension == 255 );
+        }
+        length += CODEC_LZ_MIN_MATCH;
+
+        if( offset == 0 || offset > out_pos || length > to_size - out_pos ) return BOAT_ERROR_INVALID_LENGTH;
+
+        // Byte by byte, the match may overlap what it produces
+        for( ; length > 0; length-- )
+        {
+            to_ptr[out_pos] = to_ptr[out_pos - offset];
+            out_pos++;
+        }
+    }
+
+    *to_len_ptr = out_pos;
+
+    return BOAT_SUCCESS;
+}
+
+#endif // end of #if BOAT_CODEC_USE_LZ == 1
@@ -0,0 +1,117 @@
+/******************************************************************************
+Copyright (C) 2018-2019 AITOS.IO
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+of the Software, and to permit persons to whom the Software is furnished to do
+so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+******************************************************************************/
+
+/*!@brief Compact payload codec for telemetry
+
+@file
+codec.h is header file for the payload codec.
+
+Numeric telemetry (coordinates, timestamps, readings) is carried as fixed-point
+integers. A record of such fields is encoded as zigzag varints, each being the
+delta from the same field of the previous record, except for the first record
+after BoatCodecReset(), i.e. a key frame, whose fields are absolute. The
+decoder must see the same sequence of records and resets.
+
+Batches of encoded records could be further compressed by an LZ77 style block
+compressor (BOAT_CODEC_USE_LZ). A compressed block is a series of sequences:
+@verbatim
+token | [literal length extension] | literals | offset LE2 | [match length extension]
+@endverbatim
+The high 4 bits of the token are the literal length and the low 4 bits are the
+match length minus 4. A nibble of 15 is followed by extension bytes added to
+it, terminated by a byte less than 255. The last sequence has literals only.
+*/
+
+#ifndef __CODEC_H__
+#define __CODEC_H__
+
+#include "wallet/boattypes.h"
+
+//! Maximum fields per record
+#define BOAT_CODEC_MAX_FIELDS 16
+
+//! Maximum length of a varint
+#define BOAT_CODEC_VARINT_MAX_LEN 10
+
+//! Maximum length of an encoded record of <field_num> fields
+#define BOAT_CODEC_RECORD_MAX_LEN(field_num) ((field_num) * BOAT_CODEC_VARINT_MAX_LEN)
+
+//! Maximum length of a compressed block of <len> bytes
+#define BOAT_CODEC_LZ_BOUND(len) ((len) + (len) / 255 + 16)
+
+//!@brief Delta encoding state of a record stream
+typedef struct TBoatCodec
+{
+    UINT32 field_num;                       //!< Fields per record
+    BOATBOOL key_frame;                     //!< BOAT_TRUE if the next record is absolute
+    SINT64 last[BOAT_CODEC_MAX_FIELDS];     //!< Fields of the previous record
+}BoatCodec;
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+UINT32 BoatCodecPutVarint(BOAT_OUT UINT8 *to_ptr, UINT64 value);
+
+UINT32 BoatCodecGetVarint(const UINT8 *from_ptr, UINT32 from_len, BOAT_OUT UINT64 *value_ptr);
+
+BOAT_RESULT BoatCodecFixedFromString(const CHAR *from_str,
+                                     UINT32 from_len,
+                                     UINT32 frac_digits,
+                                     BOAT_OUT SINT64 *value_ptr);
+
+BOAT_RESULT BoatCodecInit(BOAT_OUT BoatCodec *codec_ptr, UINT32 field_num);
+
+void BoatCodecReset(BoatCodec *codec_ptr);
+
+BOAT_RESULT BoatCodecEncode(BoatCodec *codec_ptr,
+                            const SINT64 *field_array,
+                            BOAT_OUT UINT8 *to_ptr,
+                            UINT32 to_size,
+                            BOAT_OUT UINT32 *to_len_ptr);
+
+BOAT_RESULT BoatCodecDecode(BoatCodec *codec_ptr,
+                            const UINT8 *from_ptr,
+                            UINT32 from_len,
+                            BOAT_OUT SINT64 *field_array,
+                            BOAT_OUT UINT32 *from_used_len_ptr);
+
+#if BOAT_CODEC_USE_LZ == 1
+BOAT_RESULT BoatCodecLzCompress(const UINT8 *from_ptr,
+                                UINT32 from_len,
+                                BOAT_OUT UINT8 *to_ptr,
+                                UINT32 to_size,
+                                BOAT_OUT UINT32 *to_len_ptr);
+
+BOAT_RESULT BoatCodecLzDecompress(const UINT8 *from_ptr,
+                                  UINT32 from_len,
+                                  BOAT_OUT UINT8 *to_ptr,
+                                  UINT32 to_size,
+                                  BOAT_OUT UINT32 *to_len_ptr);
+#endif
+
+#ifdef __cplusplus
+}
+#endif /* end of __cplusplus */
+
+#endif
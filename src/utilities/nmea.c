@@ -0,0 +1,703 @@
+/******************************************************************************
+Copyright (C) 2018-2019 AITOS.IO
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+of the Software, and to permit persons to whom the Software is furnished to do
+so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+******************************************************************************/
+
+/*!@brief Streaming parser of GPS sentences
+
+@file
+nmea.c parses NMEA 0183 and +CGPSINFO sentences into fixed-point fixes.
+*/
+
+#include "wallet/boattypes.h"
+#include "utilities/utility.h"
+#include "utilities/nmea.h"
+
+
+// Parser states
+#define NMEA_STATE_IDLE     0   // Waiting for '$' or '+'
+#define NMEA_STATE_HEADER   1   // In sentence header, e.g. "$GPRMC"
+#define NMEA_STATE_FIELDS   2   // In comma separated fields
+#define NMEA_STATE_CHECKSUM 3   // After '*'
+#define NMEA_STATE_SKIP     4   // Discarding until end of line
+
+// Kinds of fields
+#define NMEA_FIELD_NONE     0
+#define NMEA_FIELD_TIME     1   // hhmmss.sss
+#define NMEA_FIELD_DATE     2   // ddmmyy
+#define NMEA_FIELD_LAT      3   // ddmm.mmmm
+#define NMEA_FIELD_NS       4   // N or S
+#define NMEA_FIELD_LON      5   // dddmm.mmmm
+#define NMEA_FIELD_EW       6   // E or W
+#define NMEA_FIELD_STATUS   7   // A (valid) or V (invalid)
+#define NMEA_FIELD_QUALITY  8   // 0 for invalid
+#define NMEA_FIELD_ALT      9   // meter
+#define NMEA_FIELD_SPEED    10  // knot
+#define NMEA_FIELD_COURSE   11  // degree
+
+// Bits of coord_present
+#define NMEA_COORD_LAT      0x01
+#define NMEA_COORD_NS       0x02
+#define NMEA_COORD_LON      0x04
+#define NMEA_COORD_EW       0x08
+#define NMEA_COORD_ALL      0x0F
+#define NMEA_COORD_SOUTH    0x10
+#define NMEA_COORD_WEST     0x20
+
+// Fractional digits beyond it are truncated while being read
+#define NMEA_MAX_FRAC_DIGITS 9
+// Significant digits always fitting in UINT64 after scaling
+#define NMEA_MAX_DIGITS 18
+
+
+// Field kinds of each sentence type, indexed by field index (0 is the header)
+static const UINT8 g_nmea_rmc_fields[] =
+{
+    NMEA_FIELD_NONE, NMEA_FIELD_TIME, NMEA_FIELD_STATUS, NMEA_FIELD_LAT, NMEA_FIELD_NS,
+    NMEA_FIELD_LON, NMEA_FIELD_EW, NMEA_FIELD_SPEED, NMEA_FIELD_COURSE, NMEA_FIELD_DATE
+};
+
+static const UINT8 g_nmea_gga_fields[] =
+{
+    NMEA_FIELD_NONE, NMEA_FIELD_TIME, NMEA_FIELD_LAT, NMEA_FIELD_NS, NMEA_FIELD_LON,
+    NMEA_FIELD_EW, NMEA_FIELD_QUALITY, NMEA_FIELD_NONE, NMEA_FIELD_NONE, NMEA_FIELD_ALT
+};
+
+//+CGPSINFO:[<lat>],[<N/S>],[<log>],[<E/W>],[<date>],[<UTCtime>],[<alt>],[<speed>],[<course>]
+static const UINT8 g_nmea_cgpsinfo_fields[] =
+{
+    NMEA_FIELD_NONE, NMEA_FIELD_LAT, NMEA_FIELD_NS, NMEA_FIELD_LON, NMEA_FIELD_EW,
+    NMEA_FIELD_DATE, NMEA_FIELD_TIME, NMEA_FIELD_ALT, NMEA_FIELD_SPEED, NMEA_FIELD_COURSE
+};
+
+
+/*!*****************************************************************************
+@brief Convert the accumulated field to fixed-point
+
+Function: NmeaFieldFixed()
+
+@return
+    This function returns BOAT_TRUE if the field is a number that fits.
+
+@param[in] field_ptr
+    The accumulated field.
+
+@param[in] frac_digits
+    Number of fractional digits of the fixed-point integer.
+
+@param[out] value_ptr
+    The fixed-point integer.
+*******************************************************************************/
+static BOATBOOL NmeaFieldFixed(const BoatNmeaField *field_ptr, UINT32 frac_digits, BOAT_OUT SINT64 *value_ptr)
+{
+    UINT64 value = field_ptr->mantissa;
+    UINT32 frac_num = field_ptr->frac_num;
+    UINT32 digit_num = field_ptr->digit_num;
+
+    if( field_ptr->malformed == BOAT_TRUE ) return BOAT_FALSE;
+
+    for( ; frac_num < frac_digits; frac_num++ )
+    {
+        if( ++digit_num > NMEA_MAX_DIGITS ) return BOAT_FALSE;
+        value *= 10;
+    }
+
+    for( ; frac_num > frac_digits; frac_num-- )
+    {
+        value /= 10;
+    }
+
+    *value_ptr = (field_ptr->negative == BOAT_TRUE) ? -(SINT64)value : (SINT64)value;
+
+    return BOAT_TRUE;
+}
+
+
+// Convert ddmm.mmmm (or dddmm.mmmm) in 10^-7 minute to 10^-7 degree
+static BOATBOOL NmeaCoordinate(SINT64 ddmm_e7, UINT32 max_degree, BOAT_OUT SINT32 *degree_e7_ptr)
+{
+    SINT64 degree;
+    SINT64 minute_e7;
+
+    if( ddmm_e7 < 0 ) return BOAT_FALSE;
+
+    degree = ddmm_e7 / 1000000000;
+    minute_e7 = ddmm_e7 % 1000000000;
+
+    if( minute_e7 >= 600000000 ) return BOAT_FALSE;
+
+    // Round to nearest
+    ddmm_e7 = degree * 10000000 + (minute_e7 + 30) / 60;
+    if( ddmm_e7 > (SINT64)max_degree * 10000000 ) return BOAT_FALSE;
+
+    *degree_e7_ptr = (SINT32)ddmm_e7;
+
+    return BOAT_TRUE;
+}
+
+
+// Days since 1970-01-01 of a date in proleptic Gregorian calendar
+static UINT64 NmeaDaysFromCivil(UINT32 year, UINT32 month, UINT32 day)
+{
+    UINT32 era;
+    UINT32 year_of_era;
+    UINT32 day_of_year;
+    UINT32 day_of_era;
+
+    year -= (month <= 2);
+    era = year / 400;
+    year_of_era = year - era * 400;
+    day_of_year = (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 + day - 1;
+    day_of_era = year_of_era * 365 + year_of_era / 4 - year_of_era / 100 + day_of_year;
+
+    return (UINT64)era * 146097 + day_of_era - 719468;
+}
+
+
+/*!*****************************************************************************
+@brief Store a complete field into the fix being built
+
+Function: NmeaCommitField()
+
+@return This function doesn't return any thing.
+
+@param[in] parser_ptr
+    The parser whose current field is complete.
+*******************************************************************************/
+static void NmeaCommitField(BoatNmeaParser *parser_ptr)
+{
+    BoatNmeaField *field_ptr = &parser_ptr->field;
+    BoatGpsFix *fix_ptr = &parser_ptr->fix;
+    UINT32 kind;
+    SINT64 value;
+    BOATBOOL ok = BOAT_TRUE;
+
+    if( parser_ptr->field_index >= parser_ptr->field_kind_num ) return;
+
+    kind = parser_ptr->field_kind_ptr[parser_ptr->field_index];
+
+    // Empty fields are absent
+    if( kind == NMEA_FIELD_NONE || field_ptr->len == 0 ) return;
+
+    switch( kind )
+    {
+        case NMEA_FIELD_TIME:
+            ok = NmeaFieldFixed(field_ptr, 3, &value);
+            if( ok == BOAT_TRUE )
+            {
+                UINT32 hour = (UINT32)(value / 10000000);
+                UINT32 minute = (UINT32)(value / 100000 % 100);
+                UINT32 second_ms = (UINT32)(value % 100000);
+
+                // Allow for leap second
+                ok = (value >= 0 && hour < 24 && minute < 60 && second_ms < 61000);
+                fix_ptr->time_ms = hour * 3600000 + minute * 60000 + second_ms;
+                fix_ptr->flags |= BOAT_GPS_HAS_TIME;
+            }
+            break;
+
+        case NMEA_FIELD_DATE:
+            ok = NmeaFieldFixed(field_ptr, 0, &value);
+            if( ok == BOAT_TRUE )
+            {
+                ok = (value > 0 && value / 10000 >= 1 && value / 10000 <= 31
+                      && value / 100 % 100 >= 1 && value / 100 % 100 <= 12);
+                parser_ptr->date = (UINT32)value;
+            }
+            break;
+
+        case NMEA_FIELD_LAT:
+        case NMEA_FIELD_LON:
+            ok = NmeaFieldFixed(field_ptr, 7, &value);
+            if( ok == BOAT_TRUE )
+            {
+                if( kind == NMEA_FIELD_LAT )
+                {
+                    ok = NmeaCoordinate(value, 90, &fix_ptr->lat_e7);
+                    parser_ptr->coord_present |= NMEA_COORD_LAT;
+                }
+                else
+                {
+                    ok = NmeaCoordinate(value, 180, &fix_ptr->lon_e7);
+                    parser_ptr->coord_present |= NMEA_COORD_LON;
+                }
+            }
+            break;
+
+        case NMEA_FIELD_NS:
+            ok = (field_ptr->len == 1 && (field_ptr->first_char == 'N' || field_ptr->first_char == 'S'));
+            parser_ptr->coord_present |= NMEA_COORD_NS;
+            if( field_ptr->first_char == 'S' ) parser_ptr->coord_present |= NMEA_COORD_SOUTH;
+            break;
+
+        case NMEA_FIELD_EW:
+            ok = (field_ptr->len == 1 && (field_ptr->first_char == 'E' || field_ptr->first_char == 'W'));
+            parser_ptr->coord_present |= NMEA_COORD_EW;
+            if( field_ptr->first_char == 'W' ) parser_ptr->coord_present |= NMEA_COORD_WEST;
+            break;
+
+        case NMEA_FIELD_STATUS:
+            if( field_ptr->first_char != 'A' ) parser_ptr->valid = BOAT_FALSE;
+            break;
+
+        case NMEA_FIELD_QUALITY:
+            ok = NmeaFieldFixed(field_ptr, 0, &value);
+            if( ok == BOAT_TRUE && value == 0 ) parser_ptr->valid = BOAT_FALSE;
+            break;
+
+        case NMEA_FIELD_ALT:
+            ok = NmeaFieldFixed(field_ptr, 2, &value);
+            if( ok == BOAT_TRUE )
+            {
+                ok = (value >= -2000000000 && value <= 2000000000);
+                fix_ptr->alt_cm = (SINT32)value;
+                fix_ptr->flags |= BOAT_GPS_HAS_ALTITUDE;
+            }
+            break;
+
+        case NMEA_FIELD_SPEED:
+            ok = NmeaFieldFixed(field_ptr, 3, &value);
+            if( ok == BOAT_TRUE )
+            {
+                // 1 knot = 514.444 mm/s
+                ok = (value >= 0 && value <= 8000000);
+                fix_ptr->speed_mmps = (UINT32)((value * 514444 + 500000) / 1000000);
+                fix_ptr->flags |= BOAT_GPS_HAS_SPEED;
+            }
+            break;
+
+        case NMEA_FIELD_COURSE:
+            ok = NmeaFieldFixed(field_ptr, 2, &value);
+            if( ok == BOAT_TRUE )
+            {
+                ok = (value >= 0 && value <= 36000);
+                fix_ptr->course_e2 = (UINT32)value;
+                fix_ptr->flags |= BOAT_GPS_HAS_COURSE;
+            }
+            break;
+
+        default:
+            break;
+    }
+
+    if( ok == BOAT_FALSE ) parser_ptr->malformed = BOAT_TRUE;
+}
+
+
+/*!*****************************************************************************
+@brief Finish the current sentence at end of line
+
+Function: NmeaEndSentence()
+
+@return This function doesn't return any thing.
+
+@param[in] parser_ptr
+    The parser at end of line.
+*******************************************************************************/
+static void NmeaEndSentence(BoatNmeaParser *parser_ptr)
+{
+    BoatGpsFix *fix_ptr = &parser_ptr->fix;
+
+    if( parser_ptr->state == NMEA_STATE_FIELDS )
+    {
+        NmeaCommitField(parser_ptr);
+    }
+
+    parser_ptr->stats.sentences++;
+
+    // A $ sentence must end with a checksum of exactly 2 hex digits
+    if( parser_ptr->header[0] == '$' )
+    {
+        if(    parser_ptr->state != NMEA_STATE_CHECKSUM
+            || parser_ptr->checksum_digits != 2
+            || parser_ptr->checksum_read != parser_ptr->checksum )
+        {
+            parser_ptr->stats.checksum_errors++;
+            return;
+        }
+    }
+
+    if( parser_ptr->malformed == BOAT_TRUE )
+    {
+        parser_ptr->stats.malformed++;
+        return;
+    }
+
+    if( (parser_ptr->coord_present & NMEA_COORD_ALL) == NMEA_COORD_ALL )
+    {
+        if( parser_ptr->coord_present & NMEA_COORD_SOUTH ) fix_ptr->lat_e7 = -fix_ptr->lat_e7;
+        if( parser_ptr->coord_present & NMEA_COORD_WEST ) fix_ptr->lon_e7 = -fix_ptr->lon_e7;
+        fix_ptr->flags |= BOAT_GPS_HAS_POSITION;
+    }
+
+    if( parser_ptr->date != 0 && (fix_ptr->flags & BOAT_GPS_HAS_TIME) )
+    {
+        UINT32 year = parser_ptr->date % 100;
+
+        // Two-digit years from 80 are of the 20th century
+        year += (year < 80) ? 2000 : 1900;
+        fix_ptr->utc_ms =   NmeaDaysFromCivil(year, parser_ptr->date / 100 % 100, parser_ptr->date / 10000) * 86400000
+                          + fix_ptr->time_ms;
+        fix_ptr->flags |= BOAT_GPS_HAS_DATE;
+    }
+
+    // Sentences without valid position, e.g. "+CGPSINFO: ,,,,,,,," are not fixes
+    if( parser_ptr->valid == BOAT_FALSE || !(fix_ptr->flags & BOAT_GPS_HAS_POSITION) ) return;
+
+    parser_ptr->stats.fixes++;
+
+    if( parser_ptr->fix_func != NULL )
+    {
+        parser_ptr->fix_func(parser_ptr->fix_ctx_ptr, fix_ptr);
+    }
+}
+
+
+// Identify the sentence type once its header is complete
+static BOATBOOL NmeaStartFields(BoatNmeaParser *parser_ptr)
+{
+    const CHAR *header_ptr = parser_ptr->header;
+
+    // Talker ID ("GP", "GN", "GL", ...) is not checked
+    if( parser_ptr->header_len == 6 && header_ptr[0] == '$' )
+    {
+        if( memcmp(header_ptr + 3, "RMC", 3) == 0 )
+        {
+            parser_ptr->fix.sentence = BOAT_NMEA_SENTENCE_RMC;
+            parser_ptr->field_kind_ptr = g_nmea_rmc_fields;
+            parser_ptr->field_kind_num = sizeof(g_nmea_rmc_fields);
+        }
+        else if( memcmp(header_ptr + 3, "GGA", 3) == 0 )
+        {
+            parser_ptr->fix.sentence = BOAT_NMEA_SENTENCE_GGA;
+            parser_ptr->field_kind_ptr = g_nmea_gga_fields;
+            parser_ptr->field_kind_num = sizeof(g_nmea_gga_fields);
+        }
+    }
+    else if( parser_ptr->header_len == 9 && memcmp(header_ptr, "+CGPSINFO", 9) == 0 )
+    {
+        parser_ptr->fix.sentence = BOAT_NMEA_SENTENCE_CGPSINFO;
+        parser_ptr->field_kind_ptr = g_nmea_cgpsinfo_fields;
+        parser_ptr->field_kind_num = sizeof(g_nmea_cgpsinfo_fields);
+    }
+
+    if( parser_ptr->fix.sentence == BOAT_NMEA_SENTENCE_NONE ) return BOAT_FALSE;
+
+    parser_ptr->field_index = 1;
+    memset(&parser_ptr->field, 0, sizeof(BoatNmeaField));
+    parser_ptr->state = NMEA_STATE_FIELDS;
+
+    return BOAT_TRUE;
+}
+
+
+// Accumulate a character of the current field
+static void NmeaFieldChar(BoatNmeaField *field_ptr, CHAR c)
+{
+    // Space (e.g. after "+CGPSINFO:") is not part of the field
+    if( c == ' ' ) return;
+
+    if( field_ptr->len == 0 ) field_ptr->first_char = c;
+    if( field_ptr->len < 0xFF ) field_ptr->len++;
+
+    if( c >= '0' && c <= '9' )
+    {
+        if( field_ptr->in_frac == BOAT_TRUE )
+        {
+            if( field_ptr->frac_num >= NMEA_MAX_FRAC_DIGITS ) return;
+            field_ptr->frac_num++;
+        }
+
+        if( field_ptr->mantissa != 0 || c != '0' )
+        {
+            if( field_ptr->digit_num >= NMEA_MAX_DIGITS )
+            {
+                field_ptr->malformed = BOAT_TRUE;
+                return;
+            }
+            field_ptr->digit_num++;
+        }
+
+        field_ptr->mantissa = field_ptr->mantissa * 10 + (UINT32)(c - '0');
+    }
+    else if( c == '.' && field_ptr->in_frac == BOAT_FALSE )
+    {
+        field_ptr->in_frac = BOAT_TRUE;
+    }
+    else if( c == '-' && field_ptr->len == 1 )
+    {
+        field_ptr->negative = BOAT_TRUE;
+    }
+    else
+    {
+        // Not a number, but may be a character field like N/S
+        field_ptr->malformed = BOAT_TRUE;
+    }
+}
+
+
+/*!*****************************************************************************
+@brief Initialize a parser
+
+Function: BoatNmeaInit()
+
+@return
+    This function returns BOAT_SUCCESS if successful.\n
+    It returns BOAT_ERROR_NULL_POINTER if <parser_ptr> is NULL.
+
+@param[out] parser_ptr
+    The parser to initialize.
+
+@param[in] fix_func
+    Callback for each fix, or NULL to only count them.
+
+@param[in] fix_ctx_ptr
+    Context passed to <fix_func>.
+*******************************************************************************/
+BOAT_RESULT BoatNmeaInit(BOAT_OUT BoatNmeaParser *parser_ptr, BoatNmeaFixFunc fix_func, void *fix_ctx_ptr)
+{
+    if( parser_ptr == NULL ) return BOAT_ERROR_NULL_POINTER;
+
+    memset(parser_ptr, 0, sizeof(BoatNmeaParser));
+    parser_ptr->fix_func = fix_func;
+    parser_ptr->fix_ctx_ptr = fix_ctx_ptr;
+    parser_ptr->state = NMEA_STATE_IDLE;
+
+    return BOAT_SUCCESS;
+}
+
+
+/*!*****************************************************************************
+@brief Discard the partial sentence
+
+Function: BoatNmeaReset()
+
+    Call it when the stream is interrupted, e.g. the serial port is reopened.
+    Statistics are kept.
+
+@return This function doesn't return any thing.
+
+@param[in] parser_ptr
+    The parser.
+*******************************************************************************/
+void BoatNmeaReset(BoatNmeaParser *parser_ptr)
+{
+    if( parser_ptr != NULL ) parser_ptr->state = NMEA_STATE_IDLE;
+}
+
+
+/*!*****************************************************************************
+@brief Feed a chunk of the sentence stream
+
+Function: BoatNmeaFeed()
+
+    A chunk may contain any part of one or more sentences. Each complete
+    sentence is parsed as its line terminator (CR or LF) is fed, and reported
+    to the fix callback if it contains a valid position. Characters outside
+    sentences, e.g. "OK" of an AT channel, are ignored.
+
+@return
+    This function returns BOAT_SUCCESS if successful.\n
+    It returns BOAT_ERROR_NULL_POINTER if any argument is NULL.
+
+@param[in] parser_ptr
+    The parser.
+
+@param[in] chunk_ptr
+    The chunk, need not be null terminated.
+
+@param[in] chunk_len
+    Length of <chunk_ptr>.
+*******************************************************************************/
+BOAT_RESULT BoatNmeaFeed(BoatNmeaParser *parser_ptr, const CHAR *chunk_ptr, UINT32 chunk_len)
+{
+    UINT32 i;
+    CHAR c;
+    UINT8 hex;
+
+    if( parser_ptr == NULL || chunk_ptr == NULL ) return BOAT_ERROR_NULL_POINTER;
+
+    for( i = 0; i < chunk_len; i++ )
+    {
+        c = chunk_ptr[i];
+
+        if( c == '\r' || c == '\n' )
+        {
+            if( parser_ptr->state == NMEA_STATE_FIELDS || parser_ptr->state == NMEA_STATE_CHECKSUM )
+            {
+                NmeaEndSentence(parser_ptr);
+            }
+            parser_ptr->state = NMEA_STATE_IDLE;
+            continue;
+        }
+
+        if( parser_ptr->state == NMEA_STATE_IDLE )
+        {
+            if( c != '$' && c != '+' ) continue;
+
+            // Start of a sentence
+            memset(&parser_ptr->fix, 0, sizeof(BoatGpsFix));
+            parser_ptr->header[0] = c;
+            parser_ptr->header_len = 1;
+            parser_ptr->checksum = 0;
+            parser_ptr->checksum_read = 0;
+            parser_ptr->checksum_digits = 0;
+            parser_ptr->line_len = 0;
+            parser_ptr->field_kind_ptr = NULL;
+            parser_ptr->field_kind_num = 0;
+            parser_ptr->valid = BOAT_TRUE;
+            parser_ptr->malformed = BOAT_FALSE;
+            parser_ptr->coord_present = 0;
+            parser_ptr->date = 0;
+            parser_ptr->state = NMEA_STATE_HEADER;
+            continue;
+        }
+
+        if( ++parser_ptr->line_len > BOAT_NMEA_MAX_SENTENCE_LEN && parser_ptr->state != NMEA_STATE_SKIP )
+        {
+            if( parser_ptr->state != NMEA_STATE_HEADER ) parser_ptr->stats.malformed++;
+            parser_ptr->state = NMEA_STATE_SKIP;
+        }
+
+        switch( parser_ptr->state )
+        {
+            case NMEA_STATE_HEADER:
+                if( parser_ptr->header[0] == '$' ) parser_ptr->checksum ^= (UINT8)c;
+
+                if( c == ',' || c == ':' )
+                {
+                    // Unsupported sentences are skipped
+                    if( NmeaStartFields(parser_ptr) == BOAT_FALSE ) parser_ptr->state = NMEA_STATE_SKIP;
+                }
+                else if( parser_ptr->header_len < BOAT_NMEA_MAX_HEADER_LEN )
+                {
+                    parser_ptr->header[parser_ptr->header_len++] = c;
+                }
+                else
+                {
+                    parser_ptr->state = NMEA_STATE_SKIP;
+                }
+                break;
+
+            case NMEA_STATE_FIELDS:
+                if( c == '*' )
+                {
+                    NmeaCommitField(parser_ptr);
+                    parser_ptr->state = NMEA_STATE_CHECKSUM;
+                    break;
+                }
+
+                parser_ptr->checksum ^= (UINT8)c;
+
+                if( c == ',' )
+                {
+                    NmeaCommitField(parser_ptr);
+                    parser_ptr->field_index++;
+                    memset(&parser_ptr->field, 0, sizeof(BoatNmeaField));
+                }
+                else
+                {
+                    NmeaFieldChar(&parser_ptr->field, c);
+                }
+                break;
+
+            case NMEA_STATE_CHECKSUM:
+                if( c >= '0' && c <= '9' )      hex = c - '0';
+                else if( c >= 'A' && c <= 'F' ) hex = c - 'A' + 10;
+                else if( c >= 'a' && c <= 'f' ) hex = c - 'a' + 10;
+                else                            hex = 0xFF;
+
+                // More than 2 digits or non-hex digits fail the checksum
+                if( hex == 0xFF || parser_ptr->checksum_digits >= 2 )
+                {
+                    parser_ptr->checksum_digits = 0xFF;
+                }
+                else
+                {
+                    parser_ptr->checksum_read = (parser_ptr->checksum_read << 4) | hex;
+                    parser_ptr->checksum_digits++;
+                }
+                break;
+
+            default:
+                break;
+        }
+    }
+
+    return BOAT_SUCCESS;
+}
+
+
+/*!*****************************************************************************
+@brief Get parser statistics
+
+Function: BoatNmeaGetStats()
+
+@return This function doesn't return any thing.
+
+@param[in] parser_ptr
+    The parser.
+
+@param[out] stats_ptr
+    The statistics.
+*******************************************************************************/
+void BoatNmeaGetStats(const BoatNmeaParser *parser_ptr, BOAT_OUT BoatNmeaStats *stats_ptr)
+{
+    if( parser_ptr == NULL || stats_ptr == NULL ) return;
+
+    memcpy(stats_ptr, &parser_ptr->stats, sizeof(BoatNmeaStats));
+}
+
+
+/*!*****************************************************************************
+@brief Lay out a fix as fixed-point fields
+
+Function: BoatGpsFixToFields()
+
+    The fields are laid out as BOAT_GPS_FIELD_XXX, ready for BoatCodecEncode().
+    Absent fields are 0. If the fix has no date, BOAT_GPS_FIELD_UTC is the
+    time of day.
+
+@return This function doesn't return any thing.
+
+@param[in] fix_ptr
+    The fix.
+
+@param[out] field_array
+    Array of BOAT_GPS_FIELD_NUM fields.
+*******************************************************************************/
+void BoatGpsFixToFields(const BoatGpsFix *fix_ptr, BOAT_OUT SINT64 *field_array)
+{
+    if( fix_ptr == NULL || field_array == NULL ) return;
+
+    field_array[BOAT_GPS_FIELD_LAT] = fix_ptr->lat_e7;
+    field_array[BOAT_GPS_FIELD_LON] = fix_ptr->lon_e7;
+
+    if( fix_ptr->flags & BOAT_GPS_HAS_DATE )
+    {
+        field_array[BOAT_GPS_FIELD_UTC] = (SINT64)fix_ptr->utc_ms;
+    }
+    else
+    {
+        field_array[BOAT_GPS_FIELD_UTC] = fix_ptr->time_ms;
+    }
+
+    field_array[BOAT_GPS_FIELD_ALT] = fix_ptr->alt_cm;
+}
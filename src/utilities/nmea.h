@@ -0,0 +1,163 @@
+/******************************************************************************
+Copyright (C) 2018-2019 AITOS.IO
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+of the Software, and to permit persons to whom the Software is furnished to do
+so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+******************************************************************************/
+
+/*!@brief Streaming parser of GPS sentences
+
+@file
+nmea.h is header file for the streaming parser of NMEA 0183 and +CGPSINFO
+sentences.
+
+The parser is fed with chunks of arbitrary size as they are read from a serial
+port or AT channel, e.g. at 10Hz or more. Every character is examined once and
+numeric fields are accumulated into fixed-point integers on the fly. Nothing is
+buffered or allocated per field. When a line ends, a complete and valid sentence
+is reported to the fix callback as a BoatGpsFix.
+
+Supported sentences are $--RMC, $--GGA (any talker) and +CGPSINFO. A $ sentence
+must carry a correct "*hh" checksum.
+*/
+
+#ifndef __NMEA_H__
+#define __NMEA_H__
+
+#include "wallet/boattypes.h"
+
+//! Longer lines are discarded (NMEA 0183 limits a sentence to 82 characters)
+#define BOAT_NMEA_MAX_SENTENCE_LEN 128
+//! Longest sentence header, e.g. "+CGPSINFO:"
+#define BOAT_NMEA_MAX_HEADER_LEN 12
+
+//! Flags of fields present in BoatGpsFix
+#define BOAT_GPS_HAS_POSITION 0x01      //!< lat_e7 and lon_e7
+#define BOAT_GPS_HAS_TIME     0x02      //!< time_ms
+#define BOAT_GPS_HAS_DATE     0x04      //!< utc_ms, together with BOAT_GPS_HAS_TIME
+#define BOAT_GPS_HAS_ALTITUDE 0x08      //!< alt_cm
+#define BOAT_GPS_HAS_SPEED    0x10      //!< speed_mmps
+#define BOAT_GPS_HAS_COURSE   0x20      //!< course_e2
+
+//! Field layout of BoatGpsFixToFields(), e.g. for BoatCodecEncode()
+#define BOAT_GPS_FIELD_LAT 0
+#define BOAT_GPS_FIELD_LON 1
+#define BOAT_GPS_FIELD_UTC 2
+#define BOAT_GPS_FIELD_ALT 3
+#define BOAT_GPS_FIELD_NUM 4
+
+
+//!@brief Sentence types
+typedef enum
+{
+    BOAT_NMEA_SENTENCE_NONE = 0,
+    BOAT_NMEA_SENTENCE_RMC,         //!< $--RMC, recommended minimum data
+    BOAT_NMEA_SENTENCE_GGA,         //!< $--GGA, fix data without date
+    BOAT_NMEA_SENTENCE_CGPSINFO     //!< +CGPSINFO AT response
+}BoatNmeaSentence;
+
+//!@brief A position fix in fixed-point integers
+typedef struct TBoatGpsFix
+{
+    BoatNmeaSentence sentence;  //!< Sentence the fix is parsed from
+    UINT32 flags;               //!< BOAT_GPS_HAS_XXX of the fields present
+    SINT32 lat_e7;              //!< Latitude in 10^-7 degree, negative for south
+    SINT32 lon_e7;              //!< Longitude in 10^-7 degree, negative for west
+    UINT32 time_ms;             //!< UTC time of day in millisecond
+    UINT64 utc_ms;              //!< UTC time in millisecond since 1970-01-01
+    SINT32 alt_cm;              //!< Altitude in centimeter
+    UINT32 speed_mmps;          //!< Speed over ground in mm/s
+    UINT32 course_e2;           //!< Course over ground in 10^-2 degree
+}BoatGpsFix;
+
+//!@brief Parser statistics
+typedef struct TBoatNmeaStats
+{
+    UINT64 sentences;           //!< Lines of supported sentences
+    UINT64 fixes;               //!< Fixes reported
+    UINT64 checksum_errors;     //!< Sentences with bad or missing checksum
+    UINT64 malformed;           //!< Sentences with malformed fields or overlong lines
+}BoatNmeaStats;
+
+/*!@brief Fix callback
+
+A fix callback is called from BoatNmeaFeed() for each valid sentence. <fix_ptr>
+is only valid during the call.
+*/
+typedef void (*BoatNmeaFixFunc)(void *fix_ctx_ptr, const BoatGpsFix *fix_ptr);
+
+//!@brief Accumulator of the numeric field being parsed
+typedef struct TBoatNmeaField
+{
+    UINT64 mantissa;            //!< Digits read so far without decimal point
+    UINT8 digit_num;            //!< Significant digits in mantissa
+    UINT8 frac_num;             //!< Fractional digits in mantissa
+    BOATBOOL in_frac;           //!< BOAT_TRUE after the decimal point
+    BOATBOOL negative;          //!< BOAT_TRUE if led by '-'
+    BOATBOOL malformed;         //!< BOAT_TRUE on unexpected characters or overflow
+    UINT8 len;                  //!< Characters in the field
+    CHAR first_char;            //!< The first character, for fields like N/S
+}BoatNmeaField;
+
+//!@brief Parser state
+typedef struct TBoatNmeaParser
+{
+    BoatNmeaFixFunc fix_func;
+    void *fix_ctx_ptr;
+
+    UINT8 state;                //!< Internal state of the sentence being parsed
+    UINT8 checksum;             //!< XOR of characters between '$' and '*'
+    UINT8 checksum_read;        //!< Checksum following '*'
+    UINT8 checksum_digits;      //!< Hex digits of checksum read
+    UINT32 line_len;            //!< Characters of the current line
+    UINT32 field_index;         //!< Field being parsed, 0 for the header
+    CHAR header[BOAT_NMEA_MAX_HEADER_LEN];
+    UINT8 header_len;
+    const UINT8 *field_kind_ptr;//!< Kind of each field of the sentence type
+    UINT32 field_kind_num;
+
+    BoatNmeaField field;        //!< Field being parsed
+    BoatGpsFix fix;             //!< Fix being built from the current sentence
+    BOATBOOL valid;             //!< BOAT_FALSE if the sentence reports no fix
+    BOATBOOL malformed;         //!< BOAT_TRUE if any field is malformed
+    UINT8 coord_present;        //!< Bit 0..3: lat, N/S, lon, E/W present
+    UINT32 date;                //!< ddmmyy of the current sentence
+
+    BoatNmeaStats stats;
+}BoatNmeaParser;
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+BOAT_RESULT BoatNmeaInit(BOAT_OUT BoatNmeaParser *parser_ptr, BoatNmeaFixFunc fix_func, void *fix_ctx_ptr);
+
+void BoatNmeaReset(BoatNmeaParser *parser_ptr);
+
+BOAT_RESULT BoatNmeaFeed(BoatNmeaParser *parser_ptr, const CHAR *chunk_ptr, UINT32 chunk_len);
+
+void BoatNmeaGetStats(const BoatNmeaParser *parser_ptr, BOAT_OUT BoatNmeaStats *stats_ptr);
+
+void BoatGpsFixToFields(const BoatGpsFix *fix_ptr, BOAT_OUT SINT64 *field_array);
+
+#ifdef __cplusplus
+}
+#endif /* end of __cplusplus */
+
+#endif
@@ -26,9 +26,15 @@ SOFTWARE.
 utility.c contains utility functions for boatwallet.
 */
 
+// For clock_gettime(), nanosleep() and fsync()
+#define _DEFAULT_SOURCE
+
 #include "wallet/boattypes.h"
 #include "utilities/utility.h"
 
+#include <errno.h>
+#include <fcntl.h>
+
 //!@brief Literal representation of log level
 const CHAR  * const g_log_level_name_str[] = 
 {
@@ -932,5 +938,116 @@ void BoatFree(void *mem_ptr)
 }
 
 
+/*!*****************************************************************************
+@brief Wrapper function to get a millisecond tick
+
+Function: BoatGetTimeMs()
+
+    This function returns a monotonic time in millisecond, for measuring
+    intervals only.
+
+    It typically wraps clock_gettime(CLOCK_MONOTONIC) in a linux system.
+    For RTOS it depends on the specification of the RTOS.
+
+
+@return
+    This function returns the time in millisecond since an unspecified point.
+    
+
+@param This function doesn't take any argument.
+
+*******************************************************************************/
+UINT64 BoatGetTimeMs(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (UINT64)now.tv_sec * 1000u + now.tv_nsec / 1000000u;
+}
+
+
+/*!*****************************************************************************
+@brief Wrapper function to sleep for some milliseconds
+
+Function: BoatSleepMs()
+
+    It typically wraps nanosleep() in a linux system.
+    For RTOS it depends on the specification of the RTOS.
+
+
+@return
+    This function doesn't return anything.
+    
+
+@param[in] time_ms
+    Time to sleep, in millisecond.
+
+*******************************************************************************/
+void BoatSleepMs(UINT32 time_ms)
+{
+    struct timespec remaining;
+
+    remaining.tv_sec = time_ms / 1000u;
+    remaining.tv_nsec = (time_ms % 1000u) * 1000000u;
+
+    while( nanosleep(&remaining, &remaining) != 0 && errno == EINTR );
+}
+
+
+/*!*****************************************************************************
+@brief Make the directory entry of a file durable
+
+Function: UtilitySyncDir()
+
+    This function fsync()s the directory containing <file_path_str>, so that
+    a file just created or renamed there survives a power cut. The file
+    itself must be fsync()ed before.
+
+
+@return
+    This function returns BOAT_SUCCESS if the directory is synced.\n
+    Otherwise it returns BOAT_ERROR.
+    
+
+@param[in] file_path_str
+    Path of the file, whose directory is the current one if it has no "/".
+
+*******************************************************************************/
+BOAT_RESULT UtilitySyncDir(const CHAR *file_path_str)
+{
+    CHAR *dir_path_str;
+    const CHAR *slash_ptr;
+    size_t dir_len;
+    int dir_fd;
+    BOAT_RESULT result = BOAT_SUCCESS;
+
+    slash_ptr = strrchr(file_path_str, '/');
+    if( slash_ptr == NULL )
+    {
+        dir_fd = open(".", O_RDONLY);
+    }
+    else
+    {
+        // A file in "/" keeps the slash as its directory
+        dir_len = slash_ptr == file_path_str ? 1 : (size_t)(slash_ptr - file_path_str);
 
+        // +1 for NULL Terminator
+        dir_path_str = BoatMalloc(dir_len + 1);
+        if( dir_path_str == NULL ) return BOAT_ERROR;
 
+        memcpy(dir_path_str, file_path_str, dir_len);
+        dir_path_str[dir_len] = '\0';
+
+        dir_fd = open(dir_path_str, O_RDONLY);
+        BoatFree(dir_path_str);
+    }
+
+    if( dir_fd < 0 ) return BOAT_ERROR;
+
+    if( fsync(dir_fd) != 0 ) result = BOAT_ERROR;
+
+    close(dir_fd);
+
+    return result;
+}
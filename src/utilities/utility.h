@@ -136,6 +136,10 @@ double UtilityWeiStrToEthDouble(const CHAR *wei_str);
 
 void *BoatMalloc(UINT32 size);
 void BoatFree(void *mem_ptr);
+UINT64 BoatGetTimeMs(void);
+void BoatSleepMs(UINT32 time_ms);
+
+BOAT_RESULT UtilitySyncDir(const CHAR *file_path_str);
 
 
 
@@ -0,0 +1,510 @@
+/******************************************************************************
+Copyright (C) 2018-2019 AITOS.IO
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+of the Software, and to permit persons to whom the Software is furnished to do
+so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+******************************************************************************/
+
+/*!@brief Batching of application records into contract calls
+
+@file
+batch.c accumulates records into ABI encoded call data and submits them when
+a size or time threshold is reached.
+*/
+
+#include "wallet/boatwallet.h"
+#include "wallet/batch.h"
+
+
+//! Call data length padded to 32 bytes
+#define BATCH_PADDED_LEN(len) (((len) + 31u) & ~31u)
+
+
+/*!*****************************************************************************
+@brief Compute the encoded size of a record
+
+Function: BatchRecordSize()
+
+@return
+    This function returns the size the record occupies in the array, or 0 if
+    it can't be encoded.
+
+@param[in] encoding
+    Encoding of the batch.
+
+@param[in] record_len
+    Length of the record.
+*******************************************************************************/
+static UINT32 BatchRecordSize(BoatBatchEncoding encoding, UINT32 record_len)
+{
+    if( encoding == BOAT_BATCH_ENCODE_BYTES32_ARRAY )
+    {
+        return (record_len <= 32) ? 32 : 0;
+    }
+    else
+    {
+        return (record_len <= 0xFFFF) ? 2 + record_len : 0;
+    }
+}
+
+
+/*!*****************************************************************************
+@brief Compute the intrinsic gas of a transaction carrying the call data
+
+Function: BatchIntrinsicGas()
+
+@return
+    This function returns the gas.
+
+@param[in] data_ptr
+    The call data.
+
+@param[in] data_len
+    Length of <data_ptr>.
+*******************************************************************************/
+static UINT64 BatchIntrinsicGas(const UINT8 *data_ptr, UINT32 data_len)
+{
+    UINT64 gas = BOAT_BATCH_GAS_TX;
+    UINT32 i;
+
+    for( i = 0; i < data_len; i++ )
+    {
+        gas += (data_ptr[i] == 0) ? BOAT_BATCH_GAS_ZERO_BYTE : BOAT_BATCH_GAS_NONZERO_BYTE;
+    }
+
+    return gas;
+}
+
+
+/*!*****************************************************************************
+@brief Initialize a batch
+
+Function: BoatBatchInit()
+
+    This function initializes a batch whose records are the array argument of
+    <func_proto_str>. The thresholds are BOAT_BATCH_MAX_DATA_SIZE,
+    BOAT_BATCH_MAX_RECORDS and BOAT_BATCH_MAX_DELAY_MS, and could be changed
+    with BoatBatchSetThresholds().
+
+@return
+    This function returns BOAT_SUCCESS if successful. Otherwise it returns one
+    of BOAT_ERROR_XXX.
+
+@param[out] batch_ptr
+    The batch to initialize.
+
+@param[in] func_proto_str
+    Prototype of the contract function, e.g. "saveListBatch(bytes32[])". Its
+    only argument must match <encoding>.
+
+@param[in] encoding
+    Encoding of records.
+
+@param[in] submit_func
+    Function to submit call data of a full batch.
+
+@param[in] submit_ctx_ptr
+    Context passed to <submit_func>.
+*******************************************************************************/
+BOAT_RESULT BoatBatchInit(BOAT_OUT BoatBatch *batch_ptr,
+                          const CHAR *func_proto_str,
+                          BoatBatchEncoding encoding,
+                          BoatBatchSubmitFunc submit_func,
+                          void *submit_ctx_ptr)
+{
+    UINT8 function_selector[32];
+
+    if( batch_ptr == NULL || func_proto_str == NULL || submit_func == NULL )
+    {
+        BoatLog(BOAT_LOG_NORMAL, "Arguments cannot be NULL.");
+        return BOAT_ERROR_NULL_POINTER;
+    }
+
+    memset(batch_ptr, 0, sizeof(BoatBatch));
+
+    batch_ptr->data_ptr = BoatMalloc(BOAT_BATCH_MAX_DATA_SIZE);
+    if( batch_ptr->data_ptr == NULL )
+    {
+        BoatLog(BOAT_LOG_CRITICAL, "Fail to allocate batch buffer.");
+        return BOAT_ERROR_OUT_OF_MEMORY;
+    }
+
+    keccak_256((const UINT8 *)func_proto_str, strlen(func_proto_str), function_selector);
+    memcpy(batch_ptr->data_ptr, function_selector, 4);
+
+    batch_ptr->encoding = encoding;
+    batch_ptr->data_len = BOAT_BATCH_HEADER_SIZE;
+    batch_ptr->max_data_size = BOAT_BATCH_MAX_DATA_SIZE;
+    batch_ptr->max_records = BOAT_BATCH_MAX_RECORDS;
+    batch_ptr->max_delay_ms = BOAT_BATCH_MAX_DELAY_MS;
+    batch_ptr->submit_func = submit_func;
+    batch_ptr->submit_ctx_ptr = submit_ctx_ptr;
+
+    return BOAT_SUCCESS;
+}
+
+
+/*!*****************************************************************************
+@brief De-initialize a batch
+
+Function: BoatBatchDeInit()
+
+    Records not yet submitted are discarded. Call BoatBatchFlush() before if
+    they are to be kept.
+
+@return This function doesn't return any thing.
+
+@param[in] batch_ptr
+    The batch.
+*******************************************************************************/
+void BoatBatchDeInit(BoatBatch *batch_ptr)
+{
+    if( batch_ptr == NULL ) return;
+
+    if( batch_ptr->record_num != 0 )
+    {
+        BoatLog(BOAT_LOG_NORMAL, "Discard %u records not yet submitted.", batch_ptr->record_num);
+    }
+
+    if( batch_ptr->data_ptr != NULL ) BoatFree(batch_ptr->data_ptr);
+
+    memset(batch_ptr, 0, sizeof(BoatBatch));
+}
+
+
+/*!*****************************************************************************
+@brief Change thresholds of a batch
+
+Function: BoatBatchSetThresholds()
+
+    The batch must be empty, i.e. just initialized or flushed.
+
+@return
+    This function returns BOAT_SUCCESS if successful.\n
+    It returns BOAT_ERROR_INCOMPATIBLE_ARGUMENTS if the batch is not empty, or
+    BOAT_ERROR_INVALID_LENGTH if <max_data_size> can't hold one record.
+
+@param[in] batch_ptr
+    The batch.
+
+@param[in] max_data_size
+    Maximum size of the call data in bytes. Typically it's limited by the
+    block gas limit and node's maximum transaction size.
+
+@param[in] max_records
+    The batch is submitted once it holds so many records. 0 for no limit.
+
+@param[in] max_delay_ms
+    The batch is submitted once its oldest record is so old, in millisecond.
+    0 for no limit.
+*******************************************************************************/
+BOAT_RESULT BoatBatchSetThresholds(BoatBatch *batch_ptr,
+                                   UINT32 max_data_size,
+                                   UINT32 max_records,
+                                   UINT32 max_delay_ms)
+{
+    UINT8 *data_ptr;
+
+    if( batch_ptr == NULL || batch_ptr->data_ptr == NULL ) return BOAT_ERROR_NULL_POINTER;
+
+    if( batch_ptr->record_num != 0 )
+    {
+        BoatLog(BOAT_LOG_NORMAL, "Cannot change thresholds of a non-empty batch.");
+        return BOAT_ERROR_INCOMPATIBLE_ARGUMENTS;
+    }
+
+    if( max_data_size < BOAT_BATCH_HEADER_SIZE + 32 )
+    {
+        BoatLog(BOAT_LOG_NORMAL, "Maximum call data size %u is too small.", max_data_size);
+        return BOAT_ERROR_INVALID_LENGTH;
+    }
+
+    if( max_data_size != batch_ptr->max_data_size )
+    {
+        data_ptr = BoatMalloc(max_data_size);
+        if( data_ptr == NULL ) return BOAT_ERROR_OUT_OF_MEMORY;
+
+        memcpy(data_ptr, batch_ptr->data_ptr, 4);
+        BoatFree(batch_ptr->data_ptr);
+        batch_ptr->data_ptr = data_ptr;
+        batch_ptr->max_data_size = max_data_size;
+    }
+
+    batch_ptr->max_records = max_records;
+    batch_ptr->max_delay_ms = max_delay_ms;
+
+    return BOAT_SUCCESS;
+}
+
+
+/*!*****************************************************************************
+@brief Submit all records in a batch
+
+Function: BoatBatchFlush()
+
+    This function completes the ABI encoding of the call data and passes it to
+    the submit function. An empty batch is not submitted.
+
+@return
+    This function returns BOAT_SUCCESS if successful. Otherwise it returns
+    what the submit function returns, and the records are kept.
+
+@param[in] batch_ptr
+    The batch.
+*******************************************************************************/
+BOAT_RESULT BoatBatchFlush(BoatBatch *batch_ptr)
+{
+    UINT8 *data_ptr;
+    UINT32 padded_len;
+    UINT32 array_len;
+    BOAT_RESULT result;
+
+    if( batch_ptr == NULL || batch_ptr->data_ptr == NULL ) return BOAT_ERROR_NULL_POINTER;
+
+    if( batch_ptr->record_num == 0 ) return BOAT_SUCCESS;
+
+    data_ptr = batch_ptr->data_ptr;
+
+    // Offset of the dynamic argument, right after the head of one slot
+    memset(data_ptr + 4, 0x00, 64);
+    data_ptr[4 + 31] = 0x20;
+
+    // Length of the array, in elements for bytes32[] or in bytes for bytes
+    if( batch_ptr->encoding == BOAT_BATCH_ENCODE_BYTES32_ARRAY )
+    {
+        array_len = batch_ptr->record_num;
+    }
+    else
+    {
+        array_len = batch_ptr->data_len - BOAT_BATCH_HEADER_SIZE;
+    }
+    UtilityUint32ToBigend(data_ptr + 4 + 32 + 28, array_len, TRIMBIN_TRIM_NO);
+
+    padded_len = BOAT_BATCH_HEADER_SIZE + BATCH_PADDED_LEN(batch_ptr->data_len - BOAT_BATCH_HEADER_SIZE);
+    memset(data_ptr + batch_ptr->data_len, 0x00, padded_len - batch_ptr->data_len);
+
+    result = batch_ptr->submit_func(batch_ptr->submit_ctx_ptr, data_ptr, padded_len, batch_ptr->record_num);
+    if( result != BOAT_SUCCESS )
+    {
+        BoatLog(BOAT_LOG_NORMAL, "Fail to submit batch of %u records.", batch_ptr->record_num);
+        return result;
+    }
+
+    batch_ptr->submitted_records += batch_ptr->record_num;
+    batch_ptr->submitted_batches++;
+    batch_ptr->submitted_bytes += padded_len;
+    batch_ptr->intrinsic_gas += BatchIntrinsicGas(data_ptr, padded_len);
+
+    batch_ptr->data_len = BOAT_BATCH_HEADER_SIZE;
+    batch_ptr->record_num = 0;
+
+    return BOAT_SUCCESS;
+}
+
+
+/*!*****************************************************************************
+@brief Submit a batch if its oldest record is old enough
+
+Function: BoatBatchPoll()
+
+    The SDK doesn't run a timer. The application should call this function
+    periodically for the time threshold to take effect while no record is
+    added.
+
+@return
+    This function returns BOAT_SUCCESS if the batch is not due or successfully
+    submitted. Otherwise it returns what BoatBatchFlush() returns.
+
+@param[in] batch_ptr
+    The batch.
+*******************************************************************************/
+BOAT_RESULT BoatBatchPoll(BoatBatch *batch_ptr)
+{
+    if( batch_ptr == NULL ) return BOAT_ERROR_NULL_POINTER;
+
+    if(    batch_ptr->record_num != 0
+        && batch_ptr->max_delay_ms != 0
+        && BoatGetTimeMs() - batch_ptr->first_record_ms >= batch_ptr->max_delay_ms )
+    {
+        return BoatBatchFlush(batch_ptr);
+    }
+
+    return BOAT_SUCCESS;
+}
+
+
+/*!*****************************************************************************
+@brief Add a record to a batch
+
+Function: BoatBatchAdd()
+
+    If the record doesn't fit in the batch, the batch is submitted first. The
+    batch is also submitted after the record is added if it reaches
+    max_records or its oldest record is older than max_delay_ms.
+
+@return
+    This function returns BOAT_SUCCESS if the record is added, whether or not
+    the batch is submitted afterwards.\n
+    It returns BOAT_ERROR_INVALID_LENGTH if the record is too long for the
+    encoding or an empty batch. If the batch must be submitted before adding
+    and that fails, it returns what BoatBatchFlush() returns and the record
+    is not added.
+
+@param[in] batch_ptr
+    The batch.
+
+@param[in] record_ptr
+    The record.
+
+@param[in] record_len
+    Length of the record. It's at most 32 for BOAT_BATCH_ENCODE_BYTES32_ARRAY.
+*******************************************************************************/
+BOAT_RESULT BoatBatchAdd(BoatBatch *batch_ptr, const UINT8 *record_ptr, UINT32 record_len)
+{
+    UINT32 record_size;
+    UINT8 *record_pos_ptr;
+    UINT64 now_ms;
+    BOAT_RESULT result;
+
+    if( batch_ptr == NULL || batch_ptr->data_ptr == NULL || (record_ptr == NULL && record_len != 0) )
+    {
+        BoatLog(BOAT_LOG_NORMAL, "Arguments cannot be NULL.");
+        return BOAT_ERROR_NULL_POINTER;
+    }
+
+    record_size = BatchRecordSize(batch_ptr->encoding, record_len);
+    if(    record_size == 0
+        || BOAT_BATCH_HEADER_SIZE + BATCH_PADDED_LEN(record_size) > batch_ptr->max_data_size )
+    {
+        BoatLog(BOAT_LOG_NORMAL, "Record of %u bytes is too long to batch.", record_len);
+        return BOAT_ERROR_INVALID_LENGTH;
+    }
+
+    if(   BOAT_BATCH_HEADER_SIZE
+        + BATCH_PADDED_LEN(batch_ptr->data_len - BOAT_BATCH_HEADER_SIZE + record_size)
+        > batch_ptr->max_data_size )
+    {
+        result = BoatBatchFlush(batch_ptr);
+        if( result != BOAT_SUCCESS ) return result;
+    }
+
+    now_ms = BoatGetTimeMs();
+    if( batch_ptr->record_num == 0 ) batch_ptr->first_record_ms = now_ms;
+    if( batch_ptr->start_ms == 0 ) batch_ptr->start_ms = now_ms;
+
+    record_pos_ptr = batch_ptr->data_ptr + batch_ptr->data_len;
+    if( batch_ptr->encoding == BOAT_BATCH_ENCODE_BYTES32_ARRAY )
+    {
+        memcpy(record_pos_ptr, record_ptr, record_len);
+        memset(record_pos_ptr + record_len, 0x00, 32 - record_len);
+    }
+    else
+    {
+        record_pos_ptr[0] = (UINT8)(record_len >> 8);
+        record_pos_ptr[1] = (UINT8)record_len;
+        memcpy(record_pos_ptr + 2, record_ptr, record_len);
+    }
+    batch_ptr->data_len += record_size;
+    batch_ptr->record_num++;
+
+    if(    (batch_ptr->max_records != 0 && batch_ptr->record_num >= batch_ptr->max_records)
+        || (batch_ptr->max_delay_ms != 0 && now_ms - batch_ptr->first_record_ms >= batch_ptr->max_delay_ms) )
+    {
+        // The record is kept in the batch if submitting fails, try again later
+        BoatBatchFlush(batch_ptr);
+    }
+
+    return BOAT_SUCCESS;
+}
+
+
+/*!*****************************************************************************
+@brief Report gas used by submitted batches
+
+Function: BoatBatchReportGasUsed()
+
+    The gas actually used depends on the contract and is only known from the
+    transaction receipt. Call this function with the gasUsed of receipts for
+    BoatBatchGetStats() to report gas per record.
+
+@return This function doesn't return any thing.
+
+@param[in] batch_ptr
+    The batch.
+
+@param[in] record_num
+    Number of records in the transactions the receipts are for.
+
+@param[in] gas_used
+    Sum of gasUsed of the receipts.
+*******************************************************************************/
+void BoatBatchReportGasUsed(BoatBatch *batch_ptr, UINT32 record_num, UINT64 gas_used)
+{
+    if( batch_ptr == NULL ) return;
+
+    batch_ptr->reported_records += record_num;
+    batch_ptr->reported_gas += gas_used;
+}
+
+
+/*!*****************************************************************************
+@brief Get statistics of a batch
+
+Function: BoatBatchGetStats()
+
+@return This function doesn't return any thing.
+
+@param[in] batch_ptr
+    The batch.
+
+@param[out] stats_ptr
+    The statistics.
+*******************************************************************************/
+void BoatBatchGetStats(const BoatBatch *batch_ptr, BOAT_OUT BoatBatchStats *stats_ptr)
+{
+    UINT64 elapsed_ms;
+
+    if( batch_ptr == NULL || stats_ptr == NULL ) return;
+
+    memset(stats_ptr, 0, sizeof(BoatBatchStats));
+
+    stats_ptr->records = batch_ptr->submitted_records;
+    stats_ptr->batches = batch_ptr->submitted_batches;
+    stats_ptr->bytes = batch_ptr->submitted_bytes;
+
+    if( batch_ptr->submitted_batches != 0 )
+    {
+        stats_ptr->records_per_batch = (double)batch_ptr->submitted_records / batch_ptr->submitted_batches;
+    }
+
+    if( batch_ptr->submitted_records != 0 )
+    {
+        elapsed_ms = BoatGetTimeMs() - batch_ptr->start_ms;
+        if( elapsed_ms != 0 )
+        {
+            stats_ptr->records_per_sec = (double)batch_ptr->submitted_records * 1000.0 / elapsed_ms;
+        }
+
+        stats_ptr->intrinsic_gas_per_record = (double)batch_ptr->intrinsic_gas / batch_ptr->submitted_records;
+    }
+
+    if( batch_ptr->reported_records != 0 )
+    {
+        stats_ptr->gas_per_record = (double)batch_ptr->reported_gas / batch_ptr->reported_records;
+    }
+}
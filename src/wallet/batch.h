@@ -0,0 +1,149 @@
+/******************************************************************************
+Copyright (C) 2018-2019 AITOS.IO
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+of the Software, and to permit persons to whom the Software is furnished to do
+so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+******************************************************************************/
+
+/*!@brief Batching of application records into contract calls
+
+@file
+batch.h is header file for record batching.
+
+Records added to a batch are accumulated as the single array argument of a
+contract function, and the encoded call data are handed to a submit function
+when the batch is full or its oldest record is BOAT_BATCH_MAX_DELAY_MS old.
+Two encodings are supported:
+
+- BOAT_BATCH_ENCODE_BYTES32_ARRAY, for a function like f(bytes32[]). Each
+  record of up to 32 bytes is one element, right-padded with zeros.
+- BOAT_BATCH_ENCODE_BYTES, for a function like f(bytes). Records of any length
+  are concatenated, each prefixed with its length in 2 bytes bigendian.
+*/
+
+#ifndef __BATCH_H__
+#define __BATCH_H__
+
+#include "wallet/boattypes.h"
+
+//! Size of the call data preceding the array: selector | offset | length
+#define BOAT_BATCH_HEADER_SIZE (4 + 32 + 32)
+
+/*!
+Enum Type BoatBatchEncoding
+*/
+typedef enum
+{
+    BOAT_BATCH_ENCODE_BYTES32_ARRAY = 0,    //!< One bytes32 element per record
+    BOAT_BATCH_ENCODE_BYTES                 //!< Length-prefixed records in a bytes
+}BoatBatchEncoding;
+
+/*!
+@brief Function to submit the call data of a batch
+
+@return
+    It returns BOAT_SUCCESS if the call data are accepted, e.g. sent or
+    enqueued to an outbox. Otherwise the records are kept in the batch.
+
+@param[in] submit_ctx_ptr
+    The context passed to BoatBatchInit().
+
+@param[in] data_ptr
+    The call data, i.e. function selector followed by ABI encoded records.
+
+@param[in] data_len
+    Length of <data_ptr>.
+
+@param[in] record_num
+    Number of records in the call data.
+*/
+typedef BOAT_RESULT (*BoatBatchSubmitFunc)(void *submit_ctx_ptr,
+                                           const UINT8 *data_ptr,
+                                           UINT32 data_len,
+                                           UINT32 record_num);
+
+//!@brief Batch of records
+typedef struct TBoatBatch
+{
+    BoatBatchEncoding encoding;         //!< Encoding of records
+    UINT8 *data_ptr;                    //!< Call data being built
+    UINT32 data_len;                    //!< Length of <data_ptr> excluding padding
+    UINT32 record_num;                  //!< Number of records in <data_ptr>
+    UINT64 first_record_ms;             //!< Time the oldest record was added
+
+    UINT32 max_data_size;               //!< Flush before call data exceed this size
+    UINT32 max_records;                 //!< Flush once so many records are added
+    UINT32 max_delay_ms;                //!< Flush once the oldest record is so old
+
+    BoatBatchSubmitFunc submit_func;    //!< Function to submit call data
+    void *submit_ctx_ptr;               //!< Context of <submit_func>
+
+    UINT64 start_ms;                    //!< Time the first record was added, for statistics
+    UINT64 submitted_records;           //!< Statistics, see BoatBatchStats
+    UINT64 submitted_batches;
+    UINT64 submitted_bytes;
+    UINT64 intrinsic_gas;
+    UINT64 reported_records;
+    UINT64 reported_gas;
+}BoatBatch;
+
+//!@brief Statistics of a batch
+typedef struct TBoatBatchStats
+{
+    UINT64 records;                 //!< Records submitted
+    UINT64 batches;                 //!< Batches submitted
+    UINT64 bytes;                   //!< Call data submitted, in bytes
+    double records_per_batch;       //!< Average records per batch
+    double records_per_sec;         //!< Records submitted per second since the first record
+    double intrinsic_gas_per_record;//!< Transaction and call data gas per record
+    double gas_per_record;          //!< Gas used per record as reported by BoatBatchReportGasUsed(), 0 if never reported
+}BoatBatchStats;
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+BOAT_RESULT BoatBatchInit(BOAT_OUT BoatBatch *batch_ptr,
+                          const CHAR *func_proto_str,
+                          BoatBatchEncoding encoding,
+                          BoatBatchSubmitFunc submit_func,
+                          void *submit_ctx_ptr);
+
+void BoatBatchDeInit(BoatBatch *batch_ptr);
+
+BOAT_RESULT BoatBatchSetThresholds(BoatBatch *batch_ptr,
+                                   UINT32 max_data_size,
+                                   UINT32 max_records,
+                                   UINT32 max_delay_ms);
+
+BOAT_RESULT BoatBatchAdd(BoatBatch *batch_ptr, const UINT8 *record_ptr, UINT32 record_len);
+
+BOAT_RESULT BoatBatchPoll(BoatBatch *batch_ptr);
+
+BOAT_RESULT BoatBatchFlush(BoatBatch *batch_ptr);
+
+void BoatBatchReportGasUsed(BoatBatch *batch_ptr, UINT32 record_num, UINT64 gas_used);
+
+void BoatBatchGetStats(const BoatBatch *batch_ptr, BOAT_OUT BoatBatchStats *stats_ptr);
+
+#ifdef __cplusplus
+}
+#endif /* end of __cplusplus */
+
+#endif
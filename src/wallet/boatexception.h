@@ -55,6 +55,13 @@ boatexception.h defines error catching mechanism and error codes.
 #define BOAT_ERROR_EXT_MODULE_OPERATION_FAIL (-105)
 #define BOAT_ERROR_JSON_PARSE_FAIL (-106)
 #define BOAT_ERROR_RPC_FAIL (-107)
+#define BOAT_ERROR_RPC_NODE_ERROR (-108)
+#define BOAT_ERROR_RPC_TIMEOUT (-109)
+#define BOAT_ERROR_RPC_BUSY (-110)
+#define BOAT_ERROR_RPC_THROTTLED (-111)
+#define BOAT_ERROR_RPC_SERVER (-112)
+#define BOAT_ERROR_RPC_UNAVAILABLE (-113)
+#define BOAT_ERROR_RPC_UNTRUSTED (-114)
 
 
 #endif
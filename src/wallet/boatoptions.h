@@ -50,18 +50,155 @@ boatoptions.h defines options for compiling.
 // OpenSSL OPTION: Use OpenSSL for key generation
 #define BOAT_USE_OPENSSL 1
 
+// Random number OPTION: Buffer random_stream() in a per-thread ChaCha20 DRBG
+// seeded from OpenSSL, instead of calling RAND_bytes() on every request.
+// The DRBG is reseeded after BOAT_RAND_RESEED_INTERVAL output bytes and in
+// the child after fork(). Only effective if BOAT_USE_OPENSSL is 1.
+#define BOAT_RAND_USE_DRBG 1
+#define BOAT_RAND_RESEED_INTERVAL (1024u * 1024u)  // in bytes
+
+
+// Keystore OPTION: Key derivation function for the AES key of saved keystores
+// 0: keccak_256 of the password (legacy format without KDF header)
+// 1: PBKDF2-HMAC-SHA256, BOAT_KEYSTORE_KDF_COST is the iteration count
+// 2: scrypt, BOAT_KEYSTORE_KDF_COST is N, with r and p below
+// Keystores of any KDF can be loaded regardless of this option. Can be changed
+// at runtime by BoatKeystoreSetKdf().
+#define BOAT_KEYSTORE_KDF 1
+#define BOAT_KEYSTORE_KDF_COST 16384
+#define BOAT_KEYSTORE_KDF_SCRYPT_R 8
+#define BOAT_KEYSTORE_KDF_SCRYPT_P 1
+#define BOAT_KEYSTORE_KDF_CACHE_NUM 8  // Number of derived keys cached per process
+
+
+// Outbox OPTION: Journal of signed transactions sent by a background flusher,
+// see outbox.h
+#define BOAT_OUTBOX_SYNC_BATCH 16               // Sync the journal after so many entries are appended
+#define BOAT_OUTBOX_SYNC_INTERVAL_MS 1000       // or when the oldest of them is so old, in millisecond
+#define BOAT_OUTBOX_CHECKPOINT_INTERVAL 32      // Save checkpoint after so many entries are sent
+#define BOAT_OUTBOX_COMPACT_SIZE (256u * 1024u) // Truncate the drained journal if larger, in bytes
+#define BOAT_OUTBOX_RETRY_MIN_MS 1000           // Backoff range if the node is unreachable, in millisecond
+#define BOAT_OUTBOX_RETRY_MAX_MS 60000
+#define BOAT_OUTBOX_MAX_REJECTS 5               // Stop at an entry after the node rejects it so many times
+#define BOAT_OUTBOX_MAX_TX_SIZE (64u * 1024u)   // Maximum size of a signed transaction, in bytes
+
+
+// Batch OPTION: Default thresholds to submit a batch of records, and gas
+// schedule to estimate its intrinsic gas, see batch.h
+#define BOAT_BATCH_MAX_DATA_SIZE 4096       // Maximum call data size, in bytes
+#define BOAT_BATCH_MAX_RECORDS 100          // Maximum records per batch
+#define BOAT_BATCH_MAX_DELAY_MS 600000      // Maximum age of a record before submitted, in millisecond
+#define BOAT_BATCH_GAS_TX 21000             // Gas per transaction
+#define BOAT_BATCH_GAS_ZERO_BYTE 4          // Gas per zero byte of call data
+#define BOAT_BATCH_GAS_NONZERO_BYTE 16      // Gas per non-zero byte of call data (68 before EIP-2028)
+
+
+// Codec OPTION: LZ block compressor of the payload codec, see codec.h
+// Its hash table of (4 << BOAT_CODEC_LZ_HASH_BITS) bytes is on stack.
+#define BOAT_CODEC_USE_LZ 1
+#define BOAT_CODEC_LZ_HASH_BITS 10
+
+
+// Event log OPTION: block range of eth_getLogs chunks adapts between 1 and
+// BOAT_LOG_BLOCK_RANGE_MAX, aiming at BOAT_LOG_TARGET_PER_REQUEST logs per chunk
+#define BOAT_LOG_BLOCK_RANGE_INIT 1000
+#define BOAT_LOG_BLOCK_RANGE_MAX 100000
+#define BOAT_LOG_TARGET_PER_REQUEST 1000
+// Alternatives per topic position of a log filter
+#define BOAT_LOG_FILTER_MAX_ALTERNATIVES 4
 
 
 // RPC USE OPTION: One and only one RPC_USE option shall be set to 1
 #define RPC_USE_LIBCURL 1
+#define RPC_USE_WEBSOCKET 0  // Persistent "ws://" connection, with eth_subscribe
+#define RPC_USE_IPC 0        // Persistent Unix domain socket to a local node, with eth_subscribe
 #define RPC_USE_NOTHING 0
 
-#define RPC_USE_COUNT (RPC_USE_LIBCURL + RPC_USE_NOTHING)
+#define RPC_USE_COUNT (RPC_USE_LIBCURL + RPC_USE_WEBSOCKET + RPC_USE_IPC + RPC_USE_NOTHING)
 #if RPC_USE_COUNT != 1
 #error "One and only one RPC_USE option shall be set to 1"
 #endif
 #undef RPC_USE_COUNT
 
+// Derived from RPC_USE options, DO NOT modify:
+// whether the node is given by URL (or socket path) and could push notifications
+#define RPC_OPTION_HAS_NODE_URL (RPC_USE_LIBCURL + RPC_USE_WEBSOCKET + RPC_USE_IPC)
+#define RPC_SUPPORT_NOTIFICATION (RPC_USE_WEBSOCKET + RPC_USE_IPC)
+
+// Max REQUESTs sent by RpcRequestAsync() whose RESPONSEs are not taken yet.
+#define BOAT_RPC_PIPELINE_DEPTH 8
+
+// Timeout of a REQUEST in millisecond, including waiting to be admitted and
+// connecting. Cheap methods (see rpcretry.c) get BOAT_RPC_TIMEOUT_SHORT_MS.
+// Both are cut to the time left before the deadline set by RpcSetDeadline().
+#define BOAT_RPC_TIMEOUT_MS 30000
+#define BOAT_RPC_TIMEOUT_SHORT_MS 5000
+// Timeout of connecting to the node in millisecond, if shorter than the above
+#define BOAT_RPC_CONNECT_TIMEOUT_MS 10000
+
+// Client side limits of REQUESTs to each node, shared by all threads.
+// Rate limit in REQUESTs per second (0 for no limit) and its burst size.
+#define BOAT_RPC_RATE_LIMIT 0
+#define BOAT_RPC_RATE_BURST 10
+// Outstanding REQUESTs to a node adapt between MIN and MAX, starting at INIT.
+// The limit grows with successful REQUESTs, and is halved on HTTP 429, HTTP 5xx
+// or timeout.
+#define BOAT_RPC_CONCURRENCY_INIT 8
+#define BOAT_RPC_CONCURRENCY_MIN 1
+#define BOAT_RPC_CONCURRENCY_MAX 32
+// Max nodes whose limits are tracked at a time
+#define BOAT_RPC_LIMIT_NODE_NUM 4
+
+// Attempts of a REQUEST by RpcRequestSync() on timeout, HTTP 429, HTTP 5xx or
+// connection failure, for methods only reading the chain and for
+// eth_sendRawTransaction. Other methods are attempted once. See rpcretry.c.
+#define BOAT_RPC_RETRY_READ_ATTEMPTS 3
+#define BOAT_RPC_RETRY_SEND_ATTEMPTS 3
+// Retries are delayed by a random time up to BASE * 2^(retry - 1), capped at MAX,
+// in millisecond.
+#define BOAT_RPC_RETRY_BASE_MS 200
+#define BOAT_RPC_RETRY_MAX_MS 5000
+// A node failing THRESHOLD REQUESTs in a row (0 for never) is not sent any
+// REQUEST for OPEN_MS millisecond, after which one REQUEST probes it.
+#define BOAT_RPC_BREAKER_THRESHOLD 5
+#define BOAT_RPC_BREAKER_OPEN_MS 10000
+
+// HTTP version used with RPC_USE_LIBCURL:
+// 0: HTTP/1.1, one connection per outstanding REQUEST
+// 1: HTTP/2 negotiated for https:// nodes, HTTP/1.1 otherwise
+// 2: HTTP/2 without negotiation, also for http:// nodes (h2c)
+// With HTTP/2, outstanding REQUESTs run as concurrent streams over one connection.
+#define BOAT_CURL_HTTP_VERSION 1
+
+// Max REQUESTs performed at a time on a curl engine. The rest wait in order.
+#define BOAT_CURL_MAX_STREAMS 16
+
+// Set to 1 to share one curl engine (and its connections) among all threads
+// and wallets, or 0 for each thread to have its own.
+#define BOAT_CURL_SHARE_CONNECTIONS 1
+
+// Set to 1 to accept gzip or deflate compressed RESPONSEs with libcurl.
+#define BOAT_CURL_ACCEPT_ENCODING 0
+
+// Set to 1 to gzip REQUEST bodies of at least BOAT_CURL_COMPRESS_MIN_SIZE bytes
+// with libcurl. Only for nodes or gateways accepting "Content-Encoding: gzip".
+#define BOAT_CURL_COMPRESS_REQUEST 0
+#define BOAT_CURL_COMPRESS_MIN_SIZE 1024
+
+// Seconds to cache resolved node addresses with libcurl, shared by all threads.
+// -1 to cache forever, 0 to resolve each time a connection is opened.
+#define BOAT_CURL_DNS_CACHE_TTL 300
+
+// Set to 1 to verify the certificate of https:// nodes with libcurl, against
+// the CA bundle file BOAT_CURL_CA_BUNDLE or the default CA locations of
+// OpenSSL if "". The bundle is parsed once into a CA store shared by all
+// connections and parsed again after BOAT_CURL_CA_CACHE_TTL seconds (-1 for
+// never). This needs libcurl built with OpenSSL and OpenSSL 1.1.0 or later,
+// otherwise libcurl reads the bundle itself, caching it only from 7.87.0 on.
+#define BOAT_CURL_SSL_VERIFY 1
+#define BOAT_CURL_CA_BUNDLE ""
+#define BOAT_CURL_CA_CACHE_TTL 86400
+
 
 // Mining interval and Pending transaction timeout
 #define BOAT_MINE_INTERVAL 3  // Mining Interval of the blockchain, in seconds
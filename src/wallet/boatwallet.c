@@ -31,11 +31,6 @@ boatwallet.c is the SDK main entry.
 #include "bignum.h"
 #include "cJSON.h"
 
-#if BOAT_USE_OPENSSL != 0
-#include <openssl/evp.h>
-#include <openssl/aes.h>
-#endif
-
 BoatWalletInfo g_boat_wallet_info;
 TxInfo g_tx_info;
 
@@ -495,15 +490,6 @@ CHAR * BoatWalletGetBalance(void)
 
 
 
-#define KEYSTORE_SIZE_EXCLUDE_URL \
-  ( sizeof(g_boat_wallet_info.account_info.priv_key_array)\
-  + sizeof(g_boat_wallet_info.account_info.pub_key_array)\
-  + sizeof(g_boat_wallet_info.account_info.address)\
-  + sizeof(g_boat_wallet_info.network_info.chain_id)\
-  + sizeof(g_boat_wallet_info.network_info.eip155_compatibility)\
-  + sizeof(UINT32) )
-
-
 /*!*****************************************************************************
 @brief Save specified wallet information to keystore file with AES encryption
 
@@ -550,6 +536,11 @@ Function: BoatWalletSaveWalletEx()
     hash of the user specified password, and thus no matter how long the password
     is, the key is always 256 bit.
 
+    Unless BOAT_KEYSTORE_KDF is 0 or BoatKeystoreSetKdf() selects
+    BOAT_KEYSTORE_KDF_KECCAK, the AES key is instead derived by PBKDF2 or
+    scrypt with a salt, and a KDF header with the KDF's parameters and salt
+    precedes IH. See BoatKeystoreRecordEncode() for the header format.
+
     AES is a block cipher algorithm with a block size of 16 bytes. To encrypt
     plain text of any size, some block cipher mode of operation is performed.
     AES-CBC is one of the most popular modes. It XORs every plain text block
@@ -633,36 +624,11 @@ Function: BoatWalletSaveWalletEx()
 *******************************************************************************/
 BOAT_RESULT BoatWalletSaveWalletEx(const BoatWalletInfo *wallet_info_ptr, const UINT8 *passwd_ptr, UINT32 passwd_len, const CHAR *file_path_str)
 {
-    UINT8 aes256key[32];
-    UINT8 iv[16];  // Initial Vector is used for AES-CBC encryption and not for AES-ECB
-
-    UINT8 *plain_wallet_info_array = NULL;
-    UINT8 *encrypted_wallet_info_array = NULL;
-
-    UINT8 wallet_info_hash_array[32];
-
-#if BOAT_USE_OPENSSL != 0
-#if OPENSSL_VERSION_NUMBER < 0x10100000L
-    EVP_CIPHER_CTX ctx;
-    EVP_CIPHER_CTX *ctx_ptr = &ctx;
-#else
-    EVP_CIPHER_CTX *ctx_ptr = NULL;
-#endif
-
-    int openssl_ret;
-#endif
-
-    UINT32 node_url_str_len;
-    UINT32 node_url_str_len_big;
-    int openssl_len = 0;
-    UINT32 plain_wallet_info_len = 0;
-    UINT32 plain_wallet_info_len_big;
-    UINT32 encrypted_total_len = 0;
-    UINT32 chain_id_big;
-
+    UINT8 *record_ptr = NULL;
+    UINT32 record_size = 0;
+    UINT32 record_len = 0;
     size_t written_len;
 
-
     FILE *key_store_file_ptr = NULL;
 
     BOAT_RESULT result = BOAT_SUCCESS;
@@ -674,34 +640,23 @@ BOAT_RESULT BoatWalletSaveWalletEx(const BoatWalletInfo *wallet_info_ptr, const
         return BOAT_ERROR;
     }
 
-    if( wallet_info_ptr->network_info.node_url_ptr == NULL )
+    record_size = BoatKeystoreRecordSize(wallet_info_ptr);
+    if( record_size == 0 )
     {
         BoatLog(BOAT_LOG_NORMAL, "Node URL cannot be NULL.");
         return BOAT_ERROR;
     }
 
-    node_url_str_len = strlen(wallet_info_ptr->network_info.node_url_ptr);
-    
-
-    // doesn't include node url's NULL Terminator
-    plain_wallet_info_array = BoatMalloc(  AES_BLOCK_SIZE
-                                        + ROUNDUP(KEYSTORE_SIZE_EXCLUDE_URL + node_url_str_len, AES_BLOCK_SIZE));
-
-    // encrypted node url doesn't include the NULL terminator
-    encrypted_wallet_info_array = BoatMalloc(  AES_BLOCK_SIZE
-                                          + ROUNDUP(KEYSTORE_SIZE_EXCLUDE_URL + node_url_str_len, AES_BLOCK_SIZE));
-
-    if( plain_wallet_info_array == NULL || encrypted_wallet_info_array == NULL )
+    record_ptr = BoatMalloc(record_size);
+    if( record_ptr == NULL )
     {
         BoatLog(BOAT_LOG_NORMAL, "Fail to allocate memory.");
         boat_throw(BOAT_ERROR, BoatWalletSaveWallet_cleanup);
     }
-    
-    result = BoatWalletCheckPrivkey(wallet_info_ptr->account_info.priv_key_array);
 
+    result = BoatKeystoreRecordEncode(wallet_info_ptr, passwd_ptr, passwd_len, record_ptr, record_size, &record_len);
     if( result != BOAT_SUCCESS )
     {
-        BoatLog(BOAT_LOG_NORMAL, "Private key is not valid.");
         boat_throw(BOAT_ERROR, BoatWalletSaveWallet_cleanup);
     }
 
@@ -713,152 +668,28 @@ BOAT_RESULT BoatWalletSaveWalletEx(const BoatWalletInfo *wallet_info_ptr, const
         boat_throw(BOAT_ERROR, BoatWalletSaveWallet_cleanup);
     }
 
-    // Use random number for the initial vector
-    result = random_stream(iv, 16);
-
-
-    // Hash the password to generate the AES key
-    keccak_256(passwd_ptr, passwd_len, aes256key);
-
-
-    // Initialize OpenSSL EVP context for cipher/decipher
-#if OPENSSL_VERSION_NUMBER < 0x10100000L
-    EVP_CIPHER_CTX_init(ctx_ptr);
-#else
-    ctx_ptr = EVP_CIPHER_CTX_new();
-#endif
-
-    // Specify AES256-CBC Algorithm, AES key and initial vector of CBC
-    openssl_ret = EVP_EncryptInit_ex(ctx_ptr, EVP_aes_256_cbc(), NULL, aes256key, iv);
-    if( openssl_ret != 1 )
-    {
-        BoatLog(BOAT_LOG_NORMAL, "EVP_EncryptInit_ex failed.");
-        boat_throw(BOAT_ERROR, BoatWalletSaveWallet_cleanup);
-    }
-
-    // Disable default padding, because default PKCS padding cannot be distinguished
-    // from effective data in some extreme case.
-    EVP_CIPHER_CTX_set_padding(ctx_ptr, 0);
-
-    // Encryption
-    // Reserve beginning AES_BLOCK_SIZE bytes for IV-independent decryption
-
-    plain_wallet_info_len = AES_BLOCK_SIZE;
-
-    memcpy(plain_wallet_info_array + plain_wallet_info_len, &wallet_info_ptr->account_info.priv_key_array, sizeof(wallet_info_ptr->account_info.priv_key_array));
-    plain_wallet_info_len += sizeof(wallet_info_ptr->account_info.priv_key_array);
-
-    memcpy(plain_wallet_info_array + plain_wallet_info_len, &wallet_info_ptr->account_info.pub_key_array, sizeof(wallet_info_ptr->account_info.pub_key_array));
-    plain_wallet_info_len += sizeof(wallet_info_ptr->account_info.pub_key_array);
-    
-    memcpy(plain_wallet_info_array + plain_wallet_info_len, &wallet_info_ptr->account_info.address, sizeof(wallet_info_ptr->account_info.address));
-    plain_wallet_info_len += sizeof(wallet_info_ptr->account_info.address);
-
-    chain_id_big = Utilityhtonl(wallet_info_ptr->network_info.chain_id);
-    memcpy(plain_wallet_info_array + plain_wallet_info_len, &chain_id_big, sizeof(UINT32));
-    plain_wallet_info_len += sizeof(UINT32);
-
-    memcpy(plain_wallet_info_array + plain_wallet_info_len, &wallet_info_ptr->network_info.eip155_compatibility, sizeof(wallet_info_ptr->network_info.eip155_compatibility));
-    plain_wallet_info_len += sizeof(wallet_info_ptr->network_info.eip155_compatibility);
-
-    node_url_str_len_big = Utilityhtonl(node_url_str_len);
-    memcpy(plain_wallet_info_array + plain_wallet_info_len, &node_url_str_len_big, sizeof(UINT32));
-    plain_wallet_info_len += sizeof(UINT32);
-
-    memcpy(plain_wallet_info_array + plain_wallet_info_len, wallet_info_ptr->network_info.node_url_ptr, node_url_str_len);
-    plain_wallet_info_len += node_url_str_len;
-
-
-    // Encrypt wallet info
-    
-    encrypted_total_len = 0;
-    
-    openssl_ret = EVP_EncryptUpdate(ctx_ptr, encrypted_wallet_info_array + encrypted_total_len, &openssl_len, plain_wallet_info_array, ((plain_wallet_info_len - 1)/AES_BLOCK_SIZE + 1) * AES_BLOCK_SIZE);
-    if( openssl_ret != 1 )
-    {
-        BoatLog(BOAT_LOG_NORMAL, "EVP_EncryptUpdate failed.");
-        boat_throw(BOAT_ERROR, BoatWalletSaveWallet_cleanup);
-    }
-    encrypted_total_len += openssl_len;
-
-    
-    // Finalize encryption
-    openssl_ret = EVP_EncryptFinal_ex(ctx_ptr, encrypted_wallet_info_array + encrypted_total_len, &openssl_len);
-    if( openssl_ret != 1 )
-    {
-        BoatLog(BOAT_LOG_NORMAL, "EVP_EncryptFinal_ex failed.");
-        boat_throw(BOAT_ERROR, BoatWalletSaveWallet_cleanup);
-    }
-    encrypted_total_len += openssl_len;
-
-
-
-    // Write AES encrypted Wallet Info to keystore file
-
-
-    // Write wallet info hash
-    keccak_256(plain_wallet_info_array + AES_BLOCK_SIZE, plain_wallet_info_len - AES_BLOCK_SIZE, wallet_info_hash_array);
-    written_len = fwrite(wallet_info_hash_array, 1, sizeof(wallet_info_hash_array), key_store_file_ptr);
-    if( written_len != sizeof(wallet_info_hash_array) )
+    written_len = fwrite(record_ptr, 1, record_len, key_store_file_ptr);
+    if( written_len != record_len )
     {
         BoatLog(BOAT_LOG_NORMAL, "Fail to write to keystore file.");
         boat_throw(BOAT_ERROR, BoatWalletSaveWallet_cleanup);
     }
 
-    // Write plain wallet info length (excluding padding) in big endian
-    plain_wallet_info_len_big = Utilityhtonl(plain_wallet_info_len);
-    written_len = fwrite(&plain_wallet_info_len_big, 1, sizeof(UINT32), key_store_file_ptr);
-    if( written_len != sizeof(UINT32) )
-    {
-        BoatLog(BOAT_LOG_NORMAL, "Fail to write to keystore file.");
-        boat_throw(BOAT_ERROR, BoatWalletSaveWallet_cleanup);
-    }
-
-    // Write Encrypted Wallet Info
-    written_len = fwrite(encrypted_wallet_info_array, 1, encrypted_total_len, key_store_file_ptr);
-    if( written_len != encrypted_total_len )
-    {
-        BoatLog(BOAT_LOG_NORMAL, "Fail to write to keystore file.");
-        boat_throw(BOAT_ERROR, BoatWalletSaveWallet_cleanup);
-    }
-    
-
     boat_catch(BoatWalletSaveWallet_cleanup)
     {
         result = boat_exception;
     }
 
-#if OPENSSL_VERSION_NUMBER < 0x10100000L
-    EVP_CIPHER_CTX_cleanup(&ctx);
-#else
-    if( ctx_ptr != NULL )
-    {
-        EVP_CIPHER_CTX_free(ctx_ptr);
-    }
-#endif
-
-    // Destroy sensitive information
-    memset(aes256key, 0, sizeof(aes256key));
-    memset(encrypted_wallet_info_array, 0, encrypted_total_len);
-    memset(plain_wallet_info_array, 0, plain_wallet_info_len);
-    memset(wallet_info_hash_array, 0, sizeof(wallet_info_hash_array));
-
     if( key_store_file_ptr != NULL )
     {
         fclose(key_store_file_ptr);
     }
-    
 
-    if( encrypted_wallet_info_array != NULL )
+    if( record_ptr != NULL )
     {
-        BoatFree(encrypted_wallet_info_array);
+        memset(record_ptr, 0, record_size);
+        BoatFree(record_ptr);
     }
-    
-    if( plain_wallet_info_array != NULL )
-    {
-        BoatFree(plain_wallet_info_array);
-    }
-
 
     return result;
 }
@@ -950,41 +781,18 @@ Function: BoatWalletLoadWalletEx()
 *******************************************************************************/
 BOAT_RESULT BoatWalletLoadWalletEx(BoatWalletInfo *wallet_info_ptr, const UINT8 *passwd_ptr, UINT32 passwd_len, const CHAR *file_path_str)
 {
-    UINT8 aes256key[32];
-    UINT8 iv[16];  // Exact value of Initial Vector is not care for IV-independent decryption
-
-    UINT8 *plain_wallet_info_array = NULL;
-    UINT8 *encrypted_wallet_info_array = NULL;
-
-#if OPENSSL_VERSION_NUMBER < 0x10100000L
-    EVP_CIPHER_CTX ctx;
-    EVP_CIPHER_CTX *ctx_ptr = &ctx;
-#else
-    EVP_CIPHER_CTX *ctx_ptr = NULL;
-#endif
-
-    int openssl_ret;
-
-    int openssl_len;
-    UINT32 plain_wallet_info_len = 0;
-    UINT32 plain_wallet_info_len_no_pad;
-    UINT32 plain_wallet_info_len_no_pad_big;
-    UINT32 plain_wallet_info_field_index;
-    UINT32 encrypted_total_len = 0;
-    UINT32 node_url_str_len;
-    UINT32 node_url_str_len_big;
-    UINT32 chain_id_big;
+    UINT8 *record_ptr = NULL;
+    UINT32 record_len = 0;
+    long file_size;
+    CHAR *old_node_url_ptr;
     size_t read_len;
 
-
     FILE *key_store_file_ptr = NULL;
-    UINT8 wallet_info_hash_array[32];
-    UINT8 stored_wallet_info_hash_array[32];
 
     BOAT_RESULT result = BOAT_SUCCESS;
     boat_try_declare;
 
-    if( passwd_ptr == NULL || file_path_str == NULL  || passwd_len == 0)
+    if( wallet_info_ptr == NULL || passwd_ptr == NULL || file_path_str == NULL  || passwd_len == 0)
     {
         BoatLog(BOAT_LOG_NORMAL, "Arguments cannot be NULL.");
         return BOAT_ERROR;
@@ -999,210 +807,60 @@ BOAT_RESULT BoatWalletLoadWalletEx(BoatWalletInfo *wallet_info_ptr, const UINT8
         return BOAT_ERROR;
     }
 
-    // Read encrypted wallet info from keystore file
-
-    // Read wallet info hash
-    read_len = fread(stored_wallet_info_hash_array, 1, sizeof(stored_wallet_info_hash_array), key_store_file_ptr);
-    if( read_len != sizeof(stored_wallet_info_hash_array) )
+    // The whole file is one keystore record
+    if(    fseek(key_store_file_ptr, 0, SEEK_END) != 0
+        || (file_size = ftell(key_store_file_ptr)) < 0
+        || file_size < BOAT_KEYSTORE_RECORD_HEADER_SIZE
+        || file_size > BOAT_KEYSTORE_RECORD_MAX_SIZE )
     {
         BoatLog(BOAT_LOG_NORMAL, "Fail to read from keystore file.");
         boat_throw(BOAT_ERROR, BoatWalletLoadWallet_cleanup);
     }
+    record_len = (UINT32)file_size;
 
-    
-    // Read effective wallet info length in big endian
-    read_len = fread(&plain_wallet_info_len_no_pad_big, 1, sizeof(UINT32), key_store_file_ptr);
-    plain_wallet_info_len_no_pad = Utilityntohl(plain_wallet_info_len_no_pad_big);
-    if( read_len != sizeof(UINT32) || plain_wallet_info_len_no_pad > BOAT_REASONABLE_MAX_LEN )
-    {
-        BoatLog(BOAT_LOG_NORMAL, "Fail to read from keystore file.");
-        boat_throw(BOAT_ERROR, BoatWalletLoadWallet_cleanup);
-    }
-
-    // Encrypted length (with padding) is round up to the nearest multiple of AES_BLOCK_SIZE
-    encrypted_total_len = ROUNDUP(plain_wallet_info_len_no_pad, AES_BLOCK_SIZE);
-    
-    encrypted_wallet_info_array = BoatMalloc(encrypted_total_len);
-    plain_wallet_info_array =  BoatMalloc(encrypted_total_len);
-
-    if( encrypted_wallet_info_array == NULL || plain_wallet_info_array == NULL )
+    record_ptr = BoatMalloc(record_len);
+    if( record_ptr == NULL )
     {
         BoatLog(BOAT_LOG_NORMAL, "Fail to allocate memory.");
         boat_throw(BOAT_ERROR, BoatWalletLoadWallet_cleanup);
     }
 
-    // Read encrypted wallet info
-    read_len = fread(encrypted_wallet_info_array, 1, encrypted_total_len, key_store_file_ptr);
-    if( read_len != encrypted_total_len )
+    rewind(key_store_file_ptr);
+    read_len = fread(record_ptr, 1, record_len, key_store_file_ptr);
+    if( read_len != record_len )
     {
         BoatLog(BOAT_LOG_NORMAL, "Fail to read from keystore file.");
         boat_throw(BOAT_ERROR, BoatWalletLoadWallet_cleanup);
     }
 
+    old_node_url_ptr = wallet_info_ptr->network_info.node_url_ptr;
 
-    // Hash the password to generate the AES key
-    keccak_256(passwd_ptr, passwd_len, aes256key);
-
-
-    // Initialize OpenSSL EVP context for cipher/decipher
-#if OPENSSL_VERSION_NUMBER < 0x10100000L
-    EVP_CIPHER_CTX_init(ctx_ptr);
-#else
-    ctx_ptr = EVP_CIPHER_CTX_new();
-#endif
-
-    // Specify AES256-CBC Algorithm, AES key and initial vector of CBC (IV is not care)
-    openssl_ret = EVP_DecryptInit_ex(ctx_ptr, EVP_aes_256_cbc(), NULL, aes256key, iv);
-    if( openssl_ret != 1 )
-    {
-        BoatLog(BOAT_LOG_NORMAL, "EVP_DecryptInit_ex failed.");
-        boat_throw(BOAT_ERROR, BoatWalletLoadWallet_cleanup);
-    }
-
-    // Disable default padding, because default PKCS padding cannot be distinguished
-    // from effective data in some extreme case.
-    EVP_CIPHER_CTX_set_padding(ctx_ptr, 0);
-
-    plain_wallet_info_len = 0;
-    openssl_ret = EVP_DecryptUpdate(ctx_ptr, plain_wallet_info_array + plain_wallet_info_len, &openssl_len, encrypted_wallet_info_array, encrypted_total_len);
-    if( openssl_ret != 1 )
-    {
-        BoatLog(BOAT_LOG_NORMAL, "EVP_DecryptUpdate failed.");
-        boat_throw(BOAT_ERROR, BoatWalletLoadWallet_cleanup);
-    }
-    plain_wallet_info_len += openssl_len;
-
-    openssl_ret = EVP_DecryptFinal_ex(ctx_ptr, plain_wallet_info_array + plain_wallet_info_len, &openssl_len);
-    if( openssl_ret != 1 )
-    {
-        BoatLog(BOAT_LOG_NORMAL, "EVP_DecryptFinal_ex failed.");
-        boat_throw(BOAT_ERROR, BoatWalletLoadWallet_cleanup);
-    }
-    plain_wallet_info_len += openssl_len;
-
-
-    // Check decrypted plain wallet info's hash
-    // NOTE: IV-independent decryption: ingore firest AES block
-    keccak_256(plain_wallet_info_array + AES_BLOCK_SIZE, plain_wallet_info_len_no_pad - AES_BLOCK_SIZE, wallet_info_hash_array);
-    if( memcmp(wallet_info_hash_array, stored_wallet_info_hash_array, sizeof(wallet_info_hash_array)) != 0 )
-    {
-        BoatLog(BOAT_LOG_NORMAL, "Load wallet info fails: bad checksum.");
-        boat_throw(BOAT_ERROR, BoatWalletLoadWallet_cleanup);
-    }
-
-
-    result = BoatWalletCheckPrivkey(((BoatWalletInfo*)(plain_wallet_info_array + AES_BLOCK_SIZE))->account_info.priv_key_array);
-
+    result = BoatKeystoreRecordDecode(wallet_info_ptr, passwd_ptr, passwd_len, record_ptr, record_len);
     if( result != BOAT_SUCCESS )
     {
-        BoatLog(BOAT_LOG_NORMAL, "Load wallet info fails: invalid private key.");
         boat_throw(BOAT_ERROR, BoatWalletLoadWallet_cleanup);
     }
 
-    // copy wallet info to g_boat_wallet_info
-
-    // Ignore the beginning 16 bytes for IV-dependent decryption
-    plain_wallet_info_field_index = AES_BLOCK_SIZE;
-    
-    memcpy(&g_boat_wallet_info.account_info.priv_key_array, plain_wallet_info_array + plain_wallet_info_field_index, sizeof(g_boat_wallet_info.account_info.priv_key_array));
-    plain_wallet_info_field_index += sizeof(g_boat_wallet_info.account_info.priv_key_array);
-
-    memcpy(&g_boat_wallet_info.account_info.pub_key_array, plain_wallet_info_array + plain_wallet_info_field_index, sizeof(g_boat_wallet_info.account_info.pub_key_array));
-    plain_wallet_info_field_index += sizeof(g_boat_wallet_info.account_info.pub_key_array);
-    
-    memcpy(&g_boat_wallet_info.account_info.address, plain_wallet_info_array + plain_wallet_info_field_index, sizeof(g_boat_wallet_info.account_info.address));
-    plain_wallet_info_field_index += sizeof(g_boat_wallet_info.account_info.address);
-
-    
-    memcpy(&chain_id_big, plain_wallet_info_array + plain_wallet_info_field_index, sizeof(UINT32));
-    g_boat_wallet_info.network_info.chain_id = Utilityntohl(chain_id_big);
-    plain_wallet_info_field_index += sizeof(UINT32);
-
-    memcpy(&g_boat_wallet_info.network_info.eip155_compatibility, plain_wallet_info_array + plain_wallet_info_field_index, sizeof(g_boat_wallet_info.network_info.eip155_compatibility));
-    plain_wallet_info_field_index += sizeof(g_boat_wallet_info.network_info.eip155_compatibility);
-
-    memcpy(&node_url_str_len_big, plain_wallet_info_array + plain_wallet_info_field_index, sizeof(UINT32));
-    plain_wallet_info_field_index += sizeof(UINT32);
-
-    node_url_str_len = Utilityhtonl(node_url_str_len_big);
-
-    if( node_url_str_len !=
-          plain_wallet_info_len_no_pad
-        - AES_BLOCK_SIZE
-        - sizeof(g_boat_wallet_info.account_info.priv_key_array)
-        - sizeof(g_boat_wallet_info.account_info.pub_key_array)
-        - sizeof(g_boat_wallet_info.account_info.address)
-        - sizeof(g_boat_wallet_info.network_info.chain_id)
-        - sizeof(g_boat_wallet_info.network_info.eip155_compatibility)
-        - sizeof(UINT32))  // UINT32 for node url's length itself
+    if( old_node_url_ptr != NULL )
     {
-        BoatLog(BOAT_LOG_NORMAL, "Incorrect node url length");
-        boat_throw(BOAT_ERROR, BoatWalletLoadWallet_cleanup);
+        BoatFree(old_node_url_ptr);
     }
-    
-
-    if( g_boat_wallet_info.network_info.node_url_ptr != NULL )
-    {
-        BoatFree(g_boat_wallet_info.network_info.node_url_ptr);
-    }
-
-    // +1 for NULL Terminator
-    g_boat_wallet_info.network_info.node_url_ptr = BoatMalloc(node_url_str_len + 1);
-
-    if( g_boat_wallet_info.network_info.node_url_ptr == NULL )
-    {
-        BoatLog(BOAT_LOG_NORMAL, "Fail to allocate memory.");
-        boat_throw(BOAT_ERROR, BoatWalletLoadWallet_cleanup);
-    }
-
-    memcpy(g_boat_wallet_info.network_info.node_url_ptr, plain_wallet_info_array + plain_wallet_info_field_index, node_url_str_len);
-    plain_wallet_info_field_index += node_url_str_len;
-
-    // Add a NULL teriminator
-    g_boat_wallet_info.network_info.node_url_ptr[node_url_str_len] = '\0';
-
-
-    ///
 
     boat_catch(BoatWalletLoadWallet_cleanup)
     {
         result = boat_exception;
     }
 
-
-#if OPENSSL_VERSION_NUMBER < 0x10100000L
-    EVP_CIPHER_CTX_cleanup(&ctx);
-#else
-    if( ctx_ptr != NULL )
-    {
-        EVP_CIPHER_CTX_free(ctx_ptr);
-    }
-#endif
-
-
-    // Destroy sensitive information
-    memset(aes256key, 0, sizeof(aes256key));
-    memset(encrypted_wallet_info_array, 0, encrypted_total_len);
-    memset(plain_wallet_info_array, 0, plain_wallet_info_len);
-    memset(wallet_info_hash_array, 0, sizeof(wallet_info_hash_array));
-    memset(stored_wallet_info_hash_array, 0, sizeof(stored_wallet_info_hash_array));
-
     if( key_store_file_ptr != NULL )
     {
         fclose(key_store_file_ptr);
     }
-    
 
-    if( encrypted_wallet_info_array != NULL )
+    if( record_ptr != NULL )
     {
-        BoatFree(encrypted_wallet_info_array);
+        memset(record_ptr, 0, record_len);
+        BoatFree(record_ptr);
     }
-    
-    if( plain_wallet_info_array != NULL )
-    {
-        BoatFree(plain_wallet_info_array);
-    }
-
 
     return result;
 }
@@ -1588,6 +1246,66 @@ BOAT_RESULT BoatTxSend(void)
 }
 
 
+/*!*****************************************************************************
+@brief Initialize a transaction template from current transaction settings
+
+Function: BoatTxTemplateInit()
+
+    This function pre-encodes the gasprice, gaslimit, recipient and value set
+    by BoatTxSetXXX(), as well as the chain set by BoatWalletSetXXX(), into
+    <tx_template_ptr>.
+
+    For a series of transactions that differ only in nonce and data, e.g.
+    periodically saving telemetry data into a contract, initialize a template
+    once and send each transaction with BoatTxTemplateSend() after
+    BoatTxSetNonce() and BoatTxSetData(). It saves re-encoding the constant
+    fields for every transaction.
+
+    The template must be initialized again after the chain or any of the
+    constant fields changes.
+
+@see BoatTxTemplateSend()
+
+@return
+    This function returns BOAT_SUCCESS if initialization is successful.\n
+    Otherwise it returns one of the error codes.
+
+
+@param[out] tx_template_ptr
+    The template to initialize.
+*******************************************************************************/
+BOAT_RESULT BoatTxTemplateInit(BOAT_OUT BoatTxTemplate *tx_template_ptr)
+{
+    return RawtxTemplateInit(tx_template_ptr, &g_boat_wallet_info, &g_tx_info.rawtx_fields);
+}
+
+
+/*!*****************************************************************************
+@brief Sign and send a transaction built from a template
+
+Function: BoatTxTemplateSend()
+
+    This function does the same as BoatTxSend(), except that gasprice,
+    gaslimit, recipient and value are taken from <tx_template_ptr> instead of
+    current transaction settings. Only the nonce and data set by
+    BoatTxSetNonce() and BoatTxSetData() are used.
+
+@see BoatTxTemplateInit() BoatTxSend()
+
+@return
+    This function returns BOAT_SUCCESS if the transaction is successful.\n
+    Otherwise it returns one of the error codes.
+
+
+@param[in] tx_template_ptr
+    The template initialized by BoatTxTemplateInit().
+*******************************************************************************/
+BOAT_RESULT BoatTxTemplateSend(const BoatTxTemplate *tx_template_ptr)
+{
+    return RawtxTemplatePerform(&g_boat_wallet_info, tx_template_ptr, &g_tx_info);
+}
+
+
 /*!*****************************************************************************
 @brief Call a state-less contract function
 
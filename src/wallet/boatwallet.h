@@ -32,7 +32,15 @@ boatwallet.h is the SDK header file.
 #include "wallet/boattypes.h"
 #include "web3/web3intf.h"
 #include "utilities/utility.h"
+#include "utilities/codec.h"
+#include "utilities/nmea.h"
 #include "wallet/rawtx.h"
+#include "wallet/bulkkey.h"
+#include "wallet/keystore.h"
+#include "wallet/keymap.h"
+#include "wallet/outbox.h"
+#include "wallet/batch.h"
+#include "wallet/eventlog.h"
 #include "rpc/rpcintf.h"
 
 
@@ -83,6 +91,10 @@ BOAT_RESULT BoatTxSetData(TxFieldVariable *data_ptr);
 
 BOAT_RESULT BoatTxSend(void);
 
+BOAT_RESULT BoatTxTemplateInit(BOAT_OUT BoatTxTemplate *tx_template_ptr);
+
+BOAT_RESULT BoatTxTemplateSend(const BoatTxTemplate *tx_template_ptr);
+
 CHAR * BoatCallContractFunc(
                     CHAR * contract_addr_str,
                     CHAR *func_proto_str,
@@ -0,0 +1,613 @@
+/******************************************************************************
+Copyright (C) 2018-2019 AITOS.IO
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+of the Software, and to permit persons to whom the Software is furnished to do
+so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+******************************************************************************/
+
+/*!@brief Bulk key generation
+
+@file
+bulkkey.c generates private keys, public keys and addresses in bulk and
+streams them into a manifest or keystore files.
+*/
+
+// For fdopen(), fsync()
+#define _DEFAULT_SOURCE
+
+#include "wallet/boatwallet.h"
+#include "wallet/bulkkey.h"
+#include "randgenerator.h"
+#include "bignum.h"
+
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+//!@brief Scratch buffers for one chunk of accounts
+typedef struct TBulkKeyChunk
+{
+    UINT8 priv_key_array[BOAT_BULKKEY_CHUNK_NUM][32];
+    bignum256 priv_key_bn256[BOAT_BULKKEY_CHUNK_NUM];
+    curve_point pub_key_point[BOAT_BULKKEY_CHUNK_NUM];
+    UINT8 pub_key_digest[BOAT_BULKKEY_CHUNK_NUM][32];
+}BulkKeyChunk;
+
+
+/*!*****************************************************************************
+@brief Draw private keys for a chunk of accounts
+
+Function: BulkKeyDrawPrivkeys()
+
+    This function draws the entropy of <key_num> private keys by a single
+    random_stream() call. Any key out of [1, n-1] (see BoatWalletCheckPrivkey())
+    is drawn again on its own.
+
+@return
+    This function returns BOAT_SUCCESS if all keys are drawn.\n
+    Otherwise it returns BOAT_ERROR.
+
+@param[inout] chunk_ptr
+    The chunk to fill <priv_key_array> and <priv_key_bn256> of.
+
+@param[in] key_num
+    Number of keys to draw, up to BOAT_BULKKEY_CHUNK_NUM.
+*******************************************************************************/
+static BOAT_RESULT BulkKeyDrawPrivkeys(BOAT_INOUT BulkKeyChunk *chunk_ptr, UINT32 key_num)
+{
+    UINT32 i;
+    UINT32 key_try_count;
+    BOAT_RESULT result;
+
+    result = random_stream(chunk_ptr->priv_key_array[0], (UINT16)(key_num * 32));
+
+    for( i = 0; i < key_num && result == BOAT_SUCCESS; i++ )
+    {
+        for( key_try_count = 0; key_try_count < 100; key_try_count++ )
+        {
+            bn_read_be(chunk_ptr->priv_key_array[i], &chunk_ptr->priv_key_bn256[i]);
+
+            if( !bn_is_zero(&chunk_ptr->priv_key_bn256[i])
+                && bn_is_less(&chunk_ptr->priv_key_bn256[i], &secp256k1.order) )
+            {
+                break;
+            }
+
+            result = random_stream(chunk_ptr->priv_key_array[i], 32);
+            if( result != BOAT_SUCCESS )
+            {
+                break;
+            }
+        }
+
+        if( key_try_count == 100 )
+        {
+            result = BOAT_ERROR;
+        }
+    }
+
+    if( result != BOAT_SUCCESS )
+    {
+        BoatLog(BOAT_LOG_CRITICAL, "Fail to generate private key.");
+    }
+
+    return result;
+}
+
+
+/*!*****************************************************************************
+@brief Generate a chunk of accounts
+
+Function: BulkKeyGenerateChunk()
+
+    This function generates up to BOAT_BULKKEY_CHUNK_NUM accounts. Public keys
+    are computed by scalar_multiply_batch(), which shares one field inversion
+    among several points, and addresses are hashed 8 at a time by
+    keccak_256_x8().
+
+@return
+    This function returns BOAT_SUCCESS if the accounts are generated.\n
+    Otherwise it returns BOAT_ERROR.
+
+@param[in] chunk_ptr
+    Scratch buffers for the chunk.
+
+@param[out] account_info_array
+    The accounts to generate.
+
+@param[in] account_num
+    Number of accounts to generate, up to BOAT_BULKKEY_CHUNK_NUM.
+*******************************************************************************/
+static BOAT_RESULT BulkKeyGenerateChunk(BulkKeyChunk *chunk_ptr, BOAT_OUT AccountInfo *account_info_array, UINT32 account_num)
+{
+    const unsigned char *pub_key_ptr[8];
+    size_t pub_key_len[8];
+    unsigned char *digest_ptr[8];
+    UINT32 i;
+    UINT32 j;
+
+    if( BulkKeyDrawPrivkeys(chunk_ptr, account_num) != BOAT_SUCCESS )
+    {
+        return BOAT_ERROR;
+    }
+
+    scalar_multiply_batch(&secp256k1, chunk_ptr->priv_key_bn256, chunk_ptr->pub_key_point, account_num);
+
+    for( i = 0; i < account_num; i++ )
+    {
+        memcpy(account_info_array[i].priv_key_array, chunk_ptr->priv_key_array[i], 32);
+        bn_write_be(&chunk_ptr->pub_key_point[i].x, account_info_array[i].pub_key_array);
+        bn_write_be(&chunk_ptr->pub_key_point[i].y, account_info_array[i].pub_key_array + 32);
+    }
+
+    // Address is the least significant 20 bytes of public key's hash
+    for( i = 0; i + 8 <= account_num; i += 8 )
+    {
+        for( j = 0; j < 8; j++ )
+        {
+            pub_key_ptr[j] = account_info_array[i + j].pub_key_array;
+            pub_key_len[j] = 64;
+            digest_ptr[j] = chunk_ptr->pub_key_digest[i + j];
+        }
+        keccak_256_x8(pub_key_ptr, pub_key_len, digest_ptr);
+    }
+    for( ; i < account_num; i++ )
+    {
+        keccak_256(account_info_array[i].pub_key_array, 64, chunk_ptr->pub_key_digest[i]);
+    }
+
+    for( i = 0; i < account_num; i++ )
+    {
+        memcpy(account_info_array[i].address, chunk_ptr->pub_key_digest[i] + 12, 20);
+    }
+
+    return BOAT_SUCCESS;
+}
+
+
+/*!*****************************************************************************
+@brief Generate accounts in bulk
+
+Function: BoatWalletBulkGenerateAccount()
+
+    This function generates <account_num> accounts, i.e. private key, public
+    key and address of each, equivalent to calling BoatWalletGeneratePrivkey()
+    and BoatWalletSetPrivkey() <account_num> times, but without touching
+    g_boat_wallet_info.
+
+    Accounts are generated BOAT_BULKKEY_CHUNK_NUM at a time: entropy is drawn
+    in one chunk, public keys share batched affine conversion and addresses
+    are hashed with multi-buffer keccak.
+
+    NOTE: Be very careful to PROTECT the private keys.
+
+@see
+    BoatWalletBulkGenerate() BoatWalletGeneratePrivkey() BoatWalletSetPrivkey()
+
+@return
+    This function returns BOAT_SUCCESS if all accounts are generated.\n
+    Otherwise it returns BOAT_ERROR.
+
+@param[out] account_info_array
+    An array of <account_num> accounts to generate.
+
+@param[in] account_num
+    Number of accounts to generate.
+*******************************************************************************/
+BOAT_RESULT BoatWalletBulkGenerateAccount(BOAT_OUT AccountInfo *account_info_array, UINT32 account_num)
+{
+    BulkKeyChunk *chunk_ptr;
+    UINT32 generated_num;
+    UINT32 chunk_num;
+    BOAT_RESULT result = BOAT_SUCCESS;
+
+    if( account_info_array == NULL )
+    {
+        BoatLog(BOAT_LOG_NORMAL, "Arguments cannot be NULL.");
+        return BOAT_ERROR;
+    }
+
+    chunk_ptr = BoatMalloc(sizeof(BulkKeyChunk));
+    if( chunk_ptr == NULL )
+    {
+        BoatLog(BOAT_LOG_NORMAL, "Fail to allocate memory.");
+        return BOAT_ERROR;
+    }
+
+    for( generated_num = 0; generated_num < account_num; generated_num += chunk_num )
+    {
+        chunk_num = account_num - generated_num;
+        if( chunk_num > BOAT_BULKKEY_CHUNK_NUM )
+        {
+            chunk_num = BOAT_BULKKEY_CHUNK_NUM;
+        }
+
+        result = BulkKeyGenerateChunk(chunk_ptr, account_info_array + generated_num, chunk_num);
+        if( result != BOAT_SUCCESS )
+        {
+            break;
+        }
+    }
+
+    // Destroy sensitive information
+    memset(chunk_ptr, 0, sizeof(BulkKeyChunk));
+    BoatFree(chunk_ptr);
+
+    return result;
+}
+
+
+/*!*****************************************************************************
+@brief Create a manifest only readable by the owner
+
+Function: BulkKeyCreateManifest()
+
+    The file is created with mode 0600 regardless of umask, as manifests may
+    hold private keys in plain. An existing file is never truncated.
+
+@return
+    This function returns the opened file, or NULL if the file exists or
+    can't be created.
+
+@param[in] path_str
+    Path of the manifest.
+
+@param[in] mode_str
+    Mode of the returned stream, "w" or "wb".
+*******************************************************************************/
+static FILE *BulkKeyCreateManifest(const CHAR *path_str, const CHAR *mode_str)
+{
+    FILE *file_ptr;
+    int fd;
+
+    fd = open(path_str, O_WRONLY | O_CREAT | O_EXCL, S_IRUSR | S_IWUSR);
+    if( fd < 0 )
+    {
+        BoatLog(BOAT_LOG_NORMAL, "Fail to create %s, it may already exist.", path_str);
+        return NULL;
+    }
+
+    file_ptr = fdopen(fd, mode_str);
+    if( file_ptr == NULL )
+    {
+        close(fd);
+        unlink(path_str);
+    }
+
+    return file_ptr;
+}
+
+
+/*!*****************************************************************************
+@brief Close a manifest created by BulkKeyCreateManifest()
+
+Function: BulkKeyCloseManifest()
+
+    A complete manifest is flushed and fsync()ed together with its directory
+    entry. An incomplete one, or one failing to be written out, is removed, so
+    that no truncated manifest is left behind.
+
+@return
+    This function returns BOAT_SUCCESS if a complete manifest is made durable.\n
+    Otherwise it returns BOAT_ERROR.
+
+@param[in] file_ptr
+    The manifest.
+
+@param[in] path_str
+    Path of the manifest.
+
+@param[in] is_complete
+    BOAT_TRUE if all accounts are written to the manifest.
+*******************************************************************************/
+static BOAT_RESULT BulkKeyCloseManifest(FILE *file_ptr, const CHAR *path_str, BOATBOOL is_complete)
+{
+    BOAT_RESULT result = is_complete == BOAT_TRUE ? BOAT_SUCCESS : BOAT_ERROR;
+
+    if(    result == BOAT_SUCCESS
+        && (fflush(file_ptr) != 0 || fsync(fileno(file_ptr)) != 0) )
+    {
+        result = BOAT_ERROR;
+    }
+
+    if( fclose(file_ptr) != 0 )
+    {
+        result = BOAT_ERROR;
+    }
+
+    if( result == BOAT_SUCCESS )
+    {
+        result = UtilitySyncDir(path_str);
+    }
+    else if( is_complete == BOAT_TRUE )
+    {
+        BoatLog(BOAT_LOG_NORMAL, "Fail to write out manifest %s.", path_str);
+    }
+
+    if( result != BOAT_SUCCESS )
+    {
+        unlink(path_str);
+    }
+
+    return result;
+}
+
+
+/*!*****************************************************************************
+@brief Generate accounts in bulk and save them
+
+Function: BoatWalletBulkGenerate()
+
+    This function generates <account_num> accounts with
+    BoatWalletBulkGenerateAccount() and streams them, one chunk at a time, to:
+
+    BOAT_BULKKEY_OUTPUT_CSV:
+        A text manifest <output_path_str>. The first line is a header,
+        followed by one "index,address,private key" line per account, with
+        address and private key in "0x" prefixed HEX.
+
+    BOAT_BULKKEY_OUTPUT_BINARY:
+        A binary manifest <output_path_str>. It starts with the 4-byte magic
+        BOAT_BULKKEY_MANIFEST_MAGIC and a 4-byte record count in BigEndian,
+        followed by one record per account:
+        32 bytes private key, 64 bytes public key and 20 bytes address.
+
+    BOAT_BULKKEY_OUTPUT_KEYSTORE:
+        One keystore file per account in the existing directory
+        <output_path_str>, named "0x<address>.keystore" and saved by
+        BoatWalletSaveWalletEx() with <network_info_ptr> and <passwd_ptr>.
+        A "manifest.csv" listing index, address and keystore file name, but
+        not the private key, is written to the same directory.
+
+    NOTE: CSV and binary manifests hold private keys in plain. They are meant
+    to be consumed by a provisioning line and destroyed afterwards. Manifests
+    are created readable by the owner only, and never overwrite an existing
+    file. A manifest is fsync()ed before success is returned, and removed if
+    any account fails to be generated or written.
+
+@see
+    BoatWalletBulkGenerateAccount() BoatWalletSaveWalletEx()
+
+@return
+    This function returns BOAT_SUCCESS if all accounts are generated and saved.\n
+    Otherwise it returns BOAT_ERROR, including if the manifest already exists.
+
+@param[in] account_num
+    Number of accounts to generate.
+
+@param[in] output_type
+    Output format, see BoatBulkKeyOutputType.
+
+@param[in] output_path_str
+    Manifest file path, or keystore directory for BOAT_BULKKEY_OUTPUT_KEYSTORE.
+
+@param[in] network_info_ptr
+    Network information saved in every keystore. Only used for\n
+    BOAT_BULKKEY_OUTPUT_KEYSTORE, otherwise it can be NULL.
+
+@param[in] passwd_ptr
+    Password to encrypt every keystore. Only used for\n
+    BOAT_BULKKEY_OUTPUT_KEYSTORE, otherwise it can be NULL.
+
+@param[in] passwd_len
+    Length of <passwd_ptr> in byte.
+*******************************************************************************/
+BOAT_RESULT BoatWalletBulkGenerate(UINT32 account_num,
+                                   BoatBulkKeyOutputType output_type,
+                                   const CHAR *output_path_str,
+                                   const NetworkInfo *network_info_ptr,
+                                   const UINT8 *passwd_ptr,
+                                   UINT32 passwd_len)
+{
+    AccountInfo *account_info_array = NULL;
+    BoatWalletInfo wallet_info;
+    FILE *manifest_file_ptr = NULL;
+    CHAR *manifest_path_str = NULL;
+    CHAR *file_path_str = NULL;
+    CHAR address_str[43];
+    CHAR priv_key_str[67];
+    UINT32 file_path_size = 0;
+    UINT32 account_num_big;
+    UINT32 generated_num;
+    UINT32 chunk_num;
+    UINT32 i;
+
+    BOAT_RESULT result = BOAT_SUCCESS;
+    boat_try_declare;
+
+    if( output_path_str == NULL )
+    {
+        BoatLog(BOAT_LOG_NORMAL, "Arguments cannot be NULL.");
+        return BOAT_ERROR;
+    }
+
+    if( output_type == BOAT_BULKKEY_OUTPUT_KEYSTORE
+        && (network_info_ptr == NULL || passwd_ptr == NULL || passwd_len == 0) )
+    {
+        BoatLog(BOAT_LOG_NORMAL, "Keystore output needs network info and password.");
+        return BOAT_ERROR;
+    }
+
+    account_info_array = BoatMalloc(BOAT_BULKKEY_CHUNK_NUM * sizeof(AccountInfo));
+    if( account_info_array == NULL )
+    {
+        BoatLog(BOAT_LOG_NORMAL, "Fail to allocate memory.");
+        boat_throw(BOAT_ERROR, BoatWalletBulkGenerate_cleanup);
+    }
+
+    // "/" + "0x" + 40 HEX + ".keystore" + null terminator
+    file_path_size = strlen(output_path_str) + 64;
+    file_path_str = BoatMalloc(file_path_size);
+    manifest_path_str = BoatMalloc(file_path_size);
+    if( file_path_str == NULL || manifest_path_str == NULL )
+    {
+        BoatLog(BOAT_LOG_NORMAL, "Fail to allocate memory.");
+        boat_throw(BOAT_ERROR, BoatWalletBulkGenerate_cleanup);
+    }
+
+    // Open the manifest
+    switch( output_type )
+    {
+        case BOAT_BULKKEY_OUTPUT_CSV:
+            snprintf(manifest_path_str, file_path_size, "%s", output_path_str);
+            manifest_file_ptr = BulkKeyCreateManifest(manifest_path_str, "w");
+        break;
+
+        case BOAT_BULKKEY_OUTPUT_BINARY:
+            snprintf(manifest_path_str, file_path_size, "%s", output_path_str);
+            manifest_file_ptr = BulkKeyCreateManifest(manifest_path_str, "wb");
+        break;
+
+        case BOAT_BULKKEY_OUTPUT_KEYSTORE:
+            snprintf(manifest_path_str, file_path_size, "%s/manifest.csv", output_path_str);
+            manifest_file_ptr = BulkKeyCreateManifest(manifest_path_str, "w");
+        break;
+
+        default:
+            BoatLog(BOAT_LOG_NORMAL, "Unknown output type: %d.", output_type);
+            boat_throw(BOAT_ERROR, BoatWalletBulkGenerate_cleanup);
+        break;
+    }
+
+    if( manifest_file_ptr == NULL )
+    {
+        BoatLog(BOAT_LOG_NORMAL, "Unable to create manifest in: %s.", output_path_str);
+        boat_throw(BOAT_ERROR, BoatWalletBulkGenerate_cleanup);
+    }
+
+    // Write the manifest header
+    if( output_type == BOAT_BULKKEY_OUTPUT_BINARY )
+    {
+        account_num_big = Utilityhtonl(account_num);
+        if( fwrite(BOAT_BULKKEY_MANIFEST_MAGIC, 1, 4, manifest_file_ptr) != 4
+            || fwrite(&account_num_big, 1, sizeof(UINT32), manifest_file_ptr) != sizeof(UINT32) )
+        {
+            BoatLog(BOAT_LOG_NORMAL, "Fail to write to manifest.");
+            boat_throw(BOAT_ERROR, BoatWalletBulkGenerate_cleanup);
+        }
+    }
+    else if( fprintf(manifest_file_ptr, "index,address,%s\n",
+                     output_type == BOAT_BULKKEY_OUTPUT_CSV ? "private_key" : "keystore") < 0 )
+    {
+        BoatLog(BOAT_LOG_NORMAL, "Fail to write to manifest.");
+        boat_throw(BOAT_ERROR, BoatWalletBulkGenerate_cleanup);
+    }
+
+    // Generate and stream out one chunk at a time
+    for( generated_num = 0; generated_num < account_num; generated_num += chunk_num )
+    {
+        chunk_num = account_num - generated_num;
+        if( chunk_num > BOAT_BULKKEY_CHUNK_NUM )
+        {
+            chunk_num = BOAT_BULKKEY_CHUNK_NUM;
+        }
+
+        result = BoatWalletBulkGenerateAccount(account_info_array, chunk_num);
+        if( result != BOAT_SUCCESS )
+        {
+            boat_throw(BOAT_ERROR, BoatWalletBulkGenerate_cleanup);
+        }
+
+        for( i = 0; i < chunk_num; i++ )
+        {
+            if( output_type == BOAT_BULKKEY_OUTPUT_BINARY )
+            {
+                if( fwrite(account_info_array[i].priv_key_array, 1, 32, manifest_file_ptr) != 32
+                    || fwrite(account_info_array[i].pub_key_array, 1, 64, manifest_file_ptr) != 64
+                    || fwrite(account_info_array[i].address, 1, 20, manifest_file_ptr) != 20 )
+                {
+                    BoatLog(BOAT_LOG_NORMAL, "Fail to write to manifest.");
+                    boat_throw(BOAT_ERROR, BoatWalletBulkGenerate_cleanup);
+                }
+                continue;
+            }
+
+            UtilityBin2Hex(address_str, account_info_array[i].address, 20,
+                           BIN2HEX_TRIM_NO, BIN2HEX_PREFIX_0x_YES, BOAT_FALSE);
+
+            if( output_type == BOAT_BULKKEY_OUTPUT_CSV )
+            {
+                UtilityBin2Hex(priv_key_str, account_info_array[i].priv_key_array, 32,
+                               BIN2HEX_TRIM_NO, BIN2HEX_PREFIX_0x_YES, BOAT_FALSE);
+                if( fprintf(manifest_file_ptr, "%u,%s,%s\n", generated_num + i, address_str, priv_key_str) < 0 )
+                {
+                    BoatLog(BOAT_LOG_NORMAL, "Fail to write to manifest.");
+                    boat_throw(BOAT_ERROR, BoatWalletBulkGenerate_cleanup);
+                }
+            }
+            else
+            {
+                wallet_info.account_info = account_info_array[i];
+                wallet_info.network_info = *network_info_ptr;
+
+                snprintf(file_path_str, file_path_size, "%s/%s.keystore", output_path_str, address_str);
+                result = BoatWalletSaveWalletEx(&wallet_info, passwd_ptr, passwd_len, file_path_str);
+                memset(&wallet_info.account_info, 0, sizeof(wallet_info.account_info));
+                if( result != BOAT_SUCCESS )
+                {
+                    boat_throw(BOAT_ERROR, BoatWalletBulkGenerate_cleanup);
+                }
+
+                if( fprintf(manifest_file_ptr, "%u,%s,%s.keystore\n", generated_num + i, address_str, address_str) < 0 )
+                {
+                    BoatLog(BOAT_LOG_NORMAL, "Fail to write to manifest.");
+                    boat_throw(BOAT_ERROR, BoatWalletBulkGenerate_cleanup);
+                }
+            }
+        }
+    }
+
+    if( ferror(manifest_file_ptr) )
+    {
+        BoatLog(BOAT_LOG_NORMAL, "Fail to write to manifest.");
+        boat_throw(BOAT_ERROR, BoatWalletBulkGenerate_cleanup);
+    }
+
+
+    boat_catch(BoatWalletBulkGenerate_cleanup)
+    {
+        result = boat_exception;
+    }
+
+    // Destroy sensitive information
+    memset(priv_key_str, 0, sizeof(priv_key_str));
+
+    if( manifest_file_ptr != NULL )
+    {
+        result = BulkKeyCloseManifest(manifest_file_ptr, manifest_path_str,
+                                      result == BOAT_SUCCESS ? BOAT_TRUE : BOAT_FALSE);
+    }
+
+    if( manifest_path_str != NULL )
+    {
+        BoatFree(manifest_path_str);
+    }
+
+    if( file_path_str != NULL )
+    {
+        BoatFree(file_path_str);
+    }
+
+    if( account_info_array != NULL )
+    {
+        memset(account_info_array, 0, BOAT_BULKKEY_CHUNK_NUM * sizeof(AccountInfo));
+        BoatFree(account_info_array);
+    }
+
+    return result;
+}
@@ -0,0 +1,70 @@
+/******************************************************************************
+Copyright (C) 2018-2019 AITOS.IO
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+of the Software, and to permit persons to whom the Software is furnished to do
+so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+******************************************************************************/
+
+/*!@brief Header file for bulk key generation
+
+@file
+bulkkey.h is header file for generating accounts in bulk, e.g. for factory
+provisioning of a batch of devices.
+*/
+
+#ifndef __BULKKEY_H__
+#define __BULKKEY_H__
+
+#include "wallet/boattypes.h"
+
+//! Number of accounts generated per chunk. Entropy for a whole chunk is drawn
+//! by one random_stream() call, so BOAT_BULKKEY_CHUNK_NUM * 32 MUST NOT exceed
+//! 65535 bytes.
+#define BOAT_BULKKEY_CHUNK_NUM 64
+
+//! Binary manifest file header magic, followed by 4-byte record count in BigEndian
+#define BOAT_BULKKEY_MANIFEST_MAGIC "BKEY"
+
+/*!
+Enum Type BoatBulkKeyOutputType
+*/
+typedef enum
+{
+    BOAT_BULKKEY_OUTPUT_CSV = 0,    //!< Text manifest, one "index,address,private key" line per account
+    BOAT_BULKKEY_OUTPUT_BINARY,     //!< Binary manifest, one 116-byte "private key|public key|address" record per account
+    BOAT_BULKKEY_OUTPUT_KEYSTORE    //!< One keystore file per account in a directory, plus a manifest.csv without private keys
+}BoatBulkKeyOutputType;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+BOAT_RESULT BoatWalletBulkGenerateAccount(BOAT_OUT AccountInfo *account_info_array, UINT32 account_num);
+
+BOAT_RESULT BoatWalletBulkGenerate(UINT32 account_num,
+                                   BoatBulkKeyOutputType output_type,
+                                   const CHAR *output_path_str,
+                                   const NetworkInfo *network_info_ptr,
+                                   const UINT8 *passwd_ptr,
+                                   UINT32 passwd_len);
+
+#ifdef __cplusplus
+}
+#endif /* end of __cplusplus */
+
+#endif
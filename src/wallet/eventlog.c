@@ -0,0 +1,611 @@
+/******************************************************************************
+Copyright (C) 2018-2019 AITOS.IO
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+of the Software, and to permit persons to whom the Software is furnished to do
+so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+******************************************************************************/
+
+/*!@brief Event log filtering and synchronization
+
+@file
+eventlog.c contains log filters and adaptive log synchronization.
+*/
+
+#include "wallet/boatwallet.h"
+#include "wallet/eventlog.h"
+#include "sha3.h"
+
+#include <stdlib.h>
+
+
+/*!*****************************************************************************
+@brief Initialize a log filter
+
+Function: BoatLogFilterInit()
+
+    The filter matches any log of the contract until topics are added.
+
+@return
+    This function returns BOAT_SUCCESS if successful.\n
+    It returns BOAT_ERROR_NULL_POINTER if <filter_ptr> is NULL.
+
+@param[out] filter_ptr
+    The filter to initialize.
+
+@param[in] address_ptr
+    The 20-byte contract address, or NULL for any contract.
+*******************************************************************************/
+BOAT_RESULT BoatLogFilterInit(BOAT_OUT BoatLogFilter *filter_ptr, const UINT8 *address_ptr)
+{
+    if( filter_ptr == NULL ) return BOAT_ERROR_NULL_POINTER;
+
+    memset(filter_ptr, 0, sizeof(BoatLogFilter));
+
+    if( address_ptr != NULL )
+    {
+        memcpy(filter_ptr->address, address_ptr, sizeof(BoatAddress));
+        filter_ptr->address_valid = BOAT_TRUE;
+    }
+
+    return BOAT_SUCCESS;
+}
+
+
+/*!*****************************************************************************
+@brief Add an alternative topic to a position of the filter
+
+Function: BoatLogFilterAddTopic()
+
+    A log matches the filter if, at every position having topics, its topic
+    equals any of them.
+
+@return
+    This function returns BOAT_SUCCESS if successful.\n
+    It returns BOAT_ERROR_INVALID_LENGTH if <position> is out of range or the
+    position already has BOAT_LOG_FILTER_MAX_ALTERNATIVES topics.
+
+@param[in] filter_ptr
+    The filter.
+
+@param[in] position
+    Topic position, 0 to WEB3_LOG_MAX_TOPICS - 1. Position 0 is the event
+    signature.
+
+@param[in] topic
+    The 32-byte topic, e.g. an indexed argument padded as in ABI.
+*******************************************************************************/
+BOAT_RESULT BoatLogFilterAddTopic(BoatLogFilter *filter_ptr, UINT32 position, const UINT8 topic[32])
+{
+    if( filter_ptr == NULL || topic == NULL ) return BOAT_ERROR_NULL_POINTER;
+
+    if(    position >= WEB3_LOG_MAX_TOPICS
+        || filter_ptr->topic_num[position] >= BOAT_LOG_FILTER_MAX_ALTERNATIVES )
+    {
+        BoatLog(BOAT_LOG_NORMAL, "Too many topics at position %u.", position);
+        return BOAT_ERROR_INVALID_LENGTH;
+    }
+
+    memcpy(filter_ptr->topics[position][filter_ptr->topic_num[position]], topic, 32);
+    filter_ptr->topic_num[position]++;
+
+    return BOAT_SUCCESS;
+}
+
+
+/*!*****************************************************************************
+@brief Add an event to the filter
+
+Function: BoatLogFilterAddEvent()
+
+    This function adds the event signature hash as an alternative of topic 0.
+
+@return
+    This function returns BOAT_SUCCESS if successful. Otherwise it returns an
+    error code.
+
+@param[in] filter_ptr
+    The filter.
+
+@param[in] event_proto_str
+    Event prototype, e.g. "ListSaved(bytes32)".
+*******************************************************************************/
+BOAT_RESULT BoatLogFilterAddEvent(BoatLogFilter *filter_ptr, const CHAR *event_proto_str)
+{
+    UINT8 topic[32];
+
+    if( filter_ptr == NULL || event_proto_str == NULL ) return BOAT_ERROR_NULL_POINTER;
+
+    keccak_256((const UINT8 *)event_proto_str, strlen(event_proto_str), topic);
+
+    return BoatLogFilterAddTopic(filter_ptr, 0, topic);
+}
+
+
+/*!*****************************************************************************
+@brief Check if a log matches the filter
+
+Function: BoatLogFilterMatch()
+
+@return
+    This function returns BOAT_TRUE if <log_ptr> matches <filter_ptr>.
+
+@param[in] filter_ptr
+    The filter.
+
+@param[in] log_ptr
+    The decoded log.
+*******************************************************************************/
+BOATBOOL BoatLogFilterMatch(const BoatLogFilter *filter_ptr, const Web3Log *log_ptr)
+{
+    UINT32 position;
+    UINT32 i;
+
+    if( filter_ptr == NULL || log_ptr == NULL ) return BOAT_FALSE;
+
+    if(    filter_ptr->address_valid == BOAT_TRUE
+        && memcmp(filter_ptr->address, log_ptr->address, sizeof(BoatAddress)) != 0 )
+    {
+        return BOAT_FALSE;
+    }
+
+    for( position = 0; position < WEB3_LOG_MAX_TOPICS; position++ )
+    {
+        if( filter_ptr->topic_num[position] == 0 ) continue;
+
+        if( position >= log_ptr->topic_num ) return BOAT_FALSE;
+
+        for( i = 0; i < filter_ptr->topic_num[position]; i++ )
+        {
+            if( memcmp(filter_ptr->topics[position][i], log_ptr->topics[position], 32) == 0 ) break;
+        }
+
+        if( i == filter_ptr->topic_num[position] ) return BOAT_FALSE;
+    }
+
+    return BOAT_TRUE;
+}
+
+
+// Write the topics of the filter as a JSON array, or empty string if any topic matches
+static void LogFilterTopicsToJson(const BoatLogFilter *filter_ptr, BOAT_OUT CHAR *topics_str)
+{
+    UINT32 position_num = 0;
+    UINT32 position;
+    UINT32 i;
+    UINT32 len = 0;
+
+    for( position = 0; position < WEB3_LOG_MAX_TOPICS; position++ )
+    {
+        if( filter_ptr->topic_num[position] != 0 ) position_num = position + 1;
+    }
+
+    if( position_num == 0 )
+    {
+        topics_str[0] = '\0';
+        return;
+    }
+
+    topics_str[len++] = '[';
+
+    for( position = 0; position < position_num; position++ )
+    {
+        if( position != 0 ) topics_str[len++] = ',';
+
+        if( filter_ptr->topic_num[position] == 0 )
+        {
+            memcpy(topics_str + len, "null", 4);
+            len += 4;
+            continue;
+        }
+
+        if( filter_ptr->topic_num[position] > 1 ) topics_str[len++] = '[';
+
+        for( i = 0; i < filter_ptr->topic_num[position]; i++ )
+        {
+            if( i != 0 ) topics_str[len++] = ',';
+            topics_str[len++] = '"';
+            len += UtilityBin2Hex(topics_str + len, filter_ptr->topics[position][i], 32,
+                                  BIN2HEX_TRIM_NO, BIN2HEX_PREFIX_0x_YES, BOAT_FALSE);
+            topics_str[len++] = '"';
+        }
+
+        if( filter_ptr->topic_num[position] > 1 ) topics_str[len++] = ']';
+    }
+
+    topics_str[len++] = ']';
+    topics_str[len] = '\0';
+}
+
+
+/*!*****************************************************************************
+@brief Log callback wrapping the user's one
+
+Function: LogSyncOnLog()
+
+    Logs are matched locally and those up to the last delivered position are
+    skipped. Removed logs of a chain reorganization are always delivered, and
+    rewind the position to just before them, so that logs re-emitted at the
+    same or a lower position by the new chain are delivered again.
+
+@return
+    This function returns BOAT_SUCCESS, or the result of the user's callback.
+
+@param[in] log_ctx_ptr
+    The BoatLogSync.
+
+@param[in] log_ptr
+    The decoded log.
+*******************************************************************************/
+static BOAT_RESULT LogSyncOnLog(void *log_ctx_ptr, const Web3Log *log_ptr)
+{
+    BoatLogSync *sync_ptr = (BoatLogSync *)log_ctx_ptr;
+    BOAT_RESULT result;
+
+    sync_ptr->stats.logs++;
+
+    if(    log_ptr->removed == BOAT_FALSE
+        && sync_ptr->delivered_any == BOAT_TRUE
+        && (   log_ptr->block_number < sync_ptr->last_block
+            || (   log_ptr->block_number == sync_ptr->last_block
+                && log_ptr->log_index <= sync_ptr->last_log_index)) )
+    {
+        sync_ptr->stats.duplicates++;
+        return BOAT_SUCCESS;
+    }
+
+    if( BoatLogFilterMatch(&sync_ptr->filter, log_ptr) == BOAT_FALSE ) return BOAT_SUCCESS;
+
+    // A log the callback fails is delivered again by the next request
+    result = sync_ptr->log_func(sync_ptr->log_ctx_ptr, log_ptr);
+    if( result != BOAT_SUCCESS ) return result;
+
+    if( log_ptr->removed == BOAT_FALSE )
+    {
+        sync_ptr->last_block = log_ptr->block_number;
+        sync_ptr->last_log_index = log_ptr->log_index;
+        sync_ptr->delivered_any = BOAT_TRUE;
+    }
+    else if(    sync_ptr->delivered_any == BOAT_TRUE
+             && (   log_ptr->block_number < sync_ptr->last_block
+                 || (   log_ptr->block_number == sync_ptr->last_block
+                     && log_ptr->log_index <= sync_ptr->last_log_index)) )
+    {
+        if( log_ptr->log_index != 0 )
+        {
+            sync_ptr->last_block = log_ptr->block_number;
+            sync_ptr->last_log_index = log_ptr->log_index - 1;
+        }
+        else if( log_ptr->block_number != 0 )
+        {
+            sync_ptr->last_block = log_ptr->block_number - 1;
+            sync_ptr->last_log_index = 0xFFFFFFFF;
+        }
+        else
+        {
+            sync_ptr->delivered_any = BOAT_FALSE;
+        }
+
+        // A re-installed filter catches up from the reorganized block
+        if( sync_ptr->next_block > log_ptr->block_number ) sync_ptr->next_block = log_ptr->block_number;
+    }
+
+    sync_ptr->stats.delivered++;
+
+    return BOAT_SUCCESS;
+}
+
+
+/*!*****************************************************************************
+@brief Initialize a log synchronization
+
+Function: BoatLogSyncInit()
+
+@return
+    This function returns BOAT_SUCCESS if successful. Otherwise it returns an
+    error code.
+
+@param[out] sync_ptr
+    The log synchronization to initialize.
+
+@param[in] boat_wallet_info_ptr
+    The wallet whose node URL is used.
+
+@param[in] filter_ptr
+    The filter of logs, copied.
+
+@param[in] from_block
+    The first block to catch up from.
+
+@param[in] log_func
+    Callback for each log matching the filter, in block order.
+
+@param[in] log_ctx_ptr
+    Context passed to <log_func>.
+*******************************************************************************/
+BOAT_RESULT BoatLogSyncInit(BOAT_OUT BoatLogSync *sync_ptr,
+                            const BoatWalletInfo *boat_wallet_info_ptr,
+                            const BoatLogFilter *filter_ptr,
+                            UINT64 from_block,
+                            Web3LogFunc log_func,
+                            void *log_ctx_ptr)
+{
+    if(    sync_ptr == NULL || boat_wallet_info_ptr == NULL || filter_ptr == NULL || log_func == NULL
+        || boat_wallet_info_ptr->network_info.node_url_ptr == NULL )
+    {
+        BoatLog(BOAT_LOG_NORMAL, "Arguments cannot be NULL.");
+        return BOAT_ERROR_NULL_POINTER;
+    }
+
+    memset(sync_ptr, 0, sizeof(BoatLogSync));
+
+    sync_ptr->node_url_str = BoatMalloc(strlen(boat_wallet_info_ptr->network_info.node_url_ptr) + 1);
+    if( sync_ptr->node_url_str == NULL )
+    {
+        BoatLog(BOAT_LOG_CRITICAL, "Fail to allocate node URL.");
+        return BOAT_ERROR_OUT_OF_MEMORY;
+    }
+    strcpy(sync_ptr->node_url_str, boat_wallet_info_ptr->network_info.node_url_ptr);
+
+    memcpy(&sync_ptr->filter, filter_ptr, sizeof(BoatLogFilter));
+
+    if( filter_ptr->address_valid == BOAT_TRUE )
+    {
+        UtilityBin2Hex(sync_ptr->address_str, filter_ptr->address, sizeof(BoatAddress),
+                       BIN2HEX_TRIM_NO, BIN2HEX_PREFIX_0x_YES, BOAT_FALSE);
+    }
+    LogFilterTopicsToJson(filter_ptr, sync_ptr->topics_str);
+
+    sync_ptr->log_func = log_func;
+    sync_ptr->log_ctx_ptr = log_ctx_ptr;
+    sync_ptr->next_block = from_block;
+    sync_ptr->block_range = BOAT_LOG_BLOCK_RANGE_INIT;
+    sync_ptr->block_range_limit = BOAT_LOG_BLOCK_RANGE_MAX;
+
+    return BOAT_SUCCESS;
+}
+
+
+/*!*****************************************************************************
+@brief De-initialize a log synchronization
+
+Function: BoatLogSyncDeInit()
+
+    The filter installed on the node, if any, is uninstalled.
+
+@return This function doesn't return any thing.
+
+@param[in] sync_ptr
+    The log synchronization.
+*******************************************************************************/
+void BoatLogSyncDeInit(BoatLogSync *sync_ptr)
+{
+    Param_eth_getFilterChanges param_eth_uninstallFilter;
+
+    if( sync_ptr == NULL || sync_ptr->node_url_str == NULL ) return;
+
+    if( sync_ptr->filter_id_str[0] != '\0' )
+    {
+        param_eth_uninstallFilter.filter_id_str = sync_ptr->filter_id_str;
+        web3_eth_uninstallFilter(sync_ptr->node_url_str, &param_eth_uninstallFilter);
+        sync_ptr->filter_id_str[0] = '\0';
+    }
+
+    BoatFree(sync_ptr->node_url_str);
+    sync_ptr->node_url_str = NULL;
+}
+
+
+// Fill block range and filter into eth_getLogs or eth_newFilter parameter
+static void LogSyncSetParam(BoatLogSync *sync_ptr, BOAT_OUT Param_eth_getLogs *param_ptr)
+{
+    param_ptr->address_str = (sync_ptr->address_str[0] != '\0') ? sync_ptr->address_str : NULL;
+    param_ptr->topics_str = (sync_ptr->topics_str[0] != '\0') ? sync_ptr->topics_str : NULL;
+}
+
+
+/*!*****************************************************************************
+@brief Catch up on past logs
+
+Function: BoatLogSyncCatchUp()
+
+    This function delivers logs of blocks from the next block not yet caught up
+    to <to_block> with eth_getLogs, one chunk of blocks per request.
+
+    The block range of a chunk starts with BOAT_LOG_BLOCK_RANGE_INIT. It's
+    doubled (up to BOAT_LOG_BLOCK_RANGE_MAX) after a chunk of fewer than a
+    quarter of BOAT_LOG_TARGET_PER_REQUEST logs and halved after a chunk of
+    more. If the node refuses a chunk, e.g. for too many results, the chunk is
+    retried with half the range, and the range grows only by 1/8 per chunk
+    near that limit afterwards.
+
+@return
+    This function returns BOAT_SUCCESS if all logs up to <to_block> are
+    delivered. Otherwise it returns an error code and could be called again to
+    resume.
+
+@param[in] sync_ptr
+    The log synchronization.
+
+@param[in] to_block
+    The last block to catch up to, or BOAT_LOG_BLOCK_LATEST.
+*******************************************************************************/
+BOAT_RESULT BoatLogSyncCatchUp(BoatLogSync *sync_ptr, UINT64 to_block)
+{
+    Param_eth_getLogs param_eth_getLogs;
+    CHAR from_block_str[19];
+    CHAR to_block_str[19];
+    CHAR *block_number_str;
+    UINT64 end_block;
+    UINT32 log_num;
+    BOAT_RESULT result;
+
+    if( sync_ptr == NULL || sync_ptr->node_url_str == NULL ) return BOAT_ERROR_NULL_POINTER;
+
+    if( to_block == BOAT_LOG_BLOCK_LATEST )
+    {
+        block_number_str = web3_eth_blockNumber(sync_ptr->node_url_str);
+        if( block_number_str == NULL ) return BOAT_ERROR_RPC_FAIL;
+        to_block = strtoull(block_number_str, NULL, 16);
+    }
+
+    LogSyncSetParam(sync_ptr, &param_eth_getLogs);
+    param_eth_getLogs.from_block_str = from_block_str;
+    param_eth_getLogs.to_block_str = to_block_str;
+
+    while( sync_ptr->next_block <= to_block )
+    {
+        end_block = sync_ptr->next_block + sync_ptr->block_range - 1;
+        if( end_block > to_block || end_block < sync_ptr->next_block ) end_block = to_block;
+
+        snprintf(from_block_str, sizeof(from_block_str), "0x%llx", sync_ptr->next_block);
+        snprintf(to_block_str, sizeof(to_block_str), "0x%llx", end_block);
+
+        result = web3_eth_getLogs(sync_ptr->node_url_str, &param_eth_getLogs,
+                                  LogSyncOnLog, sync_ptr, &log_num);
+        sync_ptr->stats.requests++;
+
+        if( result == BOAT_ERROR_RPC_NODE_ERROR && end_block > sync_ptr->next_block )
+        {
+            sync_ptr->block_range = (UINT32)((end_block - sync_ptr->next_block + 1) / 2);
+            sync_ptr->block_range_limit = sync_ptr->block_range;
+            sync_ptr->stats.range_shrinks++;
+            BoatLog(BOAT_LOG_VERBOSE, "Retry with block range %u.", sync_ptr->block_range);
+            continue;
+        }
+
+        if( result != BOAT_SUCCESS ) return result;
+
+        sync_ptr->next_block = end_block + 1;
+
+        if( log_num > BOAT_LOG_TARGET_PER_REQUEST )
+        {
+            if( sync_ptr->block_range > 1 ) sync_ptr->block_range /= 2;
+        }
+        else if( log_num < BOAT_LOG_TARGET_PER_REQUEST / 4 )
+        {
+            // Near the range the node refused, grow by 1/8 instead of doubling
+            if( sync_ptr->block_range >= sync_ptr->block_range_limit / 2 )
+            {
+                sync_ptr->block_range_limit += sync_ptr->block_range_limit / 8 + 1;
+                if( sync_ptr->block_range_limit > BOAT_LOG_BLOCK_RANGE_MAX ) sync_ptr->block_range_limit = BOAT_LOG_BLOCK_RANGE_MAX;
+                sync_ptr->block_range = sync_ptr->block_range_limit;
+            }
+            else
+            {
+                sync_ptr->block_range *= 2;
+            }
+        }
+    }
+
+    return BOAT_SUCCESS;
+}
+
+
+/*!*****************************************************************************
+@brief Deliver new logs
+
+Function: BoatLogSyncPoll()
+
+    On the first call, this function installs a filter on the node and then
+    catches up to the latest block. Later calls deliver logs of new blocks with
+    eth_getFilterChanges. If the node loses the filter, e.g. after a restart or
+    not being polled for a while, it's re-installed and blocks since the last
+    delivered log are caught up again.
+
+@return
+    This function returns BOAT_SUCCESS if successful. Otherwise it returns an
+    error code.
+
+@param[in] sync_ptr
+    The log synchronization.
+*******************************************************************************/
+BOAT_RESULT BoatLogSyncPoll(BoatLogSync *sync_ptr)
+{
+    Param_eth_getLogs param_eth_newFilter;
+    Param_eth_getFilterChanges param_eth_getFilterChanges;
+    CHAR from_block_str[19];
+    CHAR *filter_id_str;
+    UINT32 log_num;
+    BOAT_RESULT result;
+
+    if( sync_ptr == NULL || sync_ptr->node_url_str == NULL ) return BOAT_ERROR_NULL_POINTER;
+
+    if( sync_ptr->filter_id_str[0] != '\0' )
+    {
+        param_eth_getFilterChanges.filter_id_str = sync_ptr->filter_id_str;
+        result = web3_eth_getFilterChanges(sync_ptr->node_url_str, &param_eth_getFilterChanges,
+                                           LogSyncOnLog, sync_ptr, &log_num);
+        sync_ptr->stats.requests++;
+
+        if( result != BOAT_ERROR_RPC_NODE_ERROR )
+        {
+            // The last delivered block is caught up again by a re-installed filter,
+            // since a chain reorganization may still re-emit logs into it
+            if( sync_ptr->delivered_any == BOAT_TRUE && sync_ptr->last_block > sync_ptr->next_block )
+            {
+                sync_ptr->next_block = sync_ptr->last_block;
+            }
+            return result;
+        }
+
+        BoatLog(BOAT_LOG_NORMAL, "Filter %s is lost, re-install it.", sync_ptr->filter_id_str);
+        sync_ptr->filter_id_str[0] = '\0';
+    }
+
+    // Install the filter before catching up, so that no block falls in between.
+    // Logs of blocks both caught up and polled are skipped as duplicates.
+    LogSyncSetParam(sync_ptr, &param_eth_newFilter);
+    snprintf(from_block_str, sizeof(from_block_str), "0x%llx", sync_ptr->next_block);
+    param_eth_newFilter.from_block_str = from_block_str;
+    param_eth_newFilter.to_block_str = "latest";
+
+    filter_id_str = web3_eth_newFilter(sync_ptr->node_url_str, &param_eth_newFilter);
+    if( filter_id_str == NULL ) return BOAT_ERROR_RPC_FAIL;
+
+    if( strlen(filter_id_str) >= sizeof(sync_ptr->filter_id_str) )
+    {
+        BoatLog(BOAT_LOG_NORMAL, "Filter ID is too long: %s.", filter_id_str);
+        return BOAT_ERROR_INVALID_LENGTH;
+    }
+    strcpy(sync_ptr->filter_id_str, filter_id_str);
+
+    return BoatLogSyncCatchUp(sync_ptr, BOAT_LOG_BLOCK_LATEST);
+}
+
+
+/*!*****************************************************************************
+@brief Get statistics of a log synchronization
+
+Function: BoatLogSyncGetStats()
+
+@return This function doesn't return any thing.
+
+@param[in] sync_ptr
+    The log synchronization.
+
+@param[out] stats_ptr
+    The statistics.
+*******************************************************************************/
+void BoatLogSyncGetStats(const BoatLogSync *sync_ptr, BOAT_OUT BoatLogSyncStats *stats_ptr)
+{
+    if( sync_ptr == NULL || stats_ptr == NULL ) return;
+
+    memcpy(stats_ptr, &sync_ptr->stats, sizeof(BoatLogSyncStats));
+    stats_ptr->block_range = sync_ptr->block_range;
+    stats_ptr->next_block = sync_ptr->next_block;
+}
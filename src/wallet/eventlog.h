@@ -0,0 +1,127 @@
+/******************************************************************************
+Copyright (C) 2018-2019 AITOS.IO
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+of the Software, and to permit persons to whom the Software is furnished to do
+so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+******************************************************************************/
+
+/*!@brief Event log filtering and synchronization
+
+@file
+eventlog.h is header file for event log filters and log synchronization.
+
+A BoatLogSync delivers logs matching a BoatLogFilter in block order. It first
+catches up on past blocks with eth_getLogs, splitting the block range into
+chunks whose size adapts to the density of logs and to the limits of the node.
+Then it polls new logs with eth_newFilter and eth_getFilterChanges. Logs are
+decoded from RPC RESPONSE as a stream and matched locally against the binary
+topics of the filter. Logs already delivered are not delivered again, even if
+a lost filter is re-installed, unless a chain reorganization removes them and
+the new chain emits them again.
+*/
+
+#ifndef __EVENTLOG_H__
+#define __EVENTLOG_H__
+
+#include "wallet/boattypes.h"
+#include "web3/web3intf.h"
+
+//! Pass as <to_block> to BoatLogSyncCatchUp() to catch up to the latest block
+#define BOAT_LOG_BLOCK_LATEST 0xFFFFFFFFFFFFFFFFull
+
+//! Length of the JSON topics array of the filter, see BoatLogFilterToJson()
+#define BOAT_LOG_TOPICS_STR_MAX_LEN \
+    (2 + WEB3_LOG_MAX_TOPICS * (3 + BOAT_LOG_FILTER_MAX_ALTERNATIVES * 69))
+
+//!@brief Filter of logs
+typedef struct TBoatLogFilter
+{
+    BoatAddress address;                //!< Contract emitting the logs
+    BOATBOOL address_valid;             //!< BOAT_FALSE for any contract
+    //! Alternatives of each topic position, any of which matches
+    UINT8 topics[WEB3_LOG_MAX_TOPICS][BOAT_LOG_FILTER_MAX_ALTERNATIVES][32];
+    UINT8 topic_num[WEB3_LOG_MAX_TOPICS]; //!< Number of alternatives, 0 for any topic
+}BoatLogFilter;
+
+//!@brief Statistics of a log synchronization
+typedef struct TBoatLogSyncStats
+{
+    UINT64 requests;        //!< eth_getLogs and eth_getFilterChanges requests
+    UINT64 logs;            //!< Logs decoded from RESPONSE
+    UINT64 delivered;       //!< Logs delivered to the log callback
+    UINT64 duplicates;      //!< Logs skipped as already delivered
+    UINT32 range_shrinks;   //!< Chunks retried with a smaller block range
+    UINT32 block_range;     //!< Current block range of a chunk
+    UINT64 next_block;      //!< First block not yet caught up
+}BoatLogSyncStats;
+
+//!@brief Log synchronization state
+typedef struct TBoatLogSync
+{
+    CHAR *node_url_str;                 //!< URL of the blockchain node, copied from the wallet
+    BoatLogFilter filter;
+    CHAR address_str[43];               //!< Contract address in HEX, empty for any
+    CHAR topics_str[BOAT_LOG_TOPICS_STR_MAX_LEN]; //!< Topics of the filter in JSON, empty for any
+    Web3LogFunc log_func;
+    void *log_ctx_ptr;
+
+    UINT64 next_block;                  //!< First block not yet caught up
+    UINT32 block_range;                 //!< Block range of the next chunk
+    UINT32 block_range_limit;           //!< Range below the one the node last refused
+    CHAR filter_id_str[67];             //!< ID of the installed filter, empty if none
+
+    BOATBOOL delivered_any;             //!< BOAT_TRUE if <last_block> and <last_log_index> are valid
+    UINT64 last_block;                  //!< Position of the last delivered log
+    UINT32 last_log_index;
+
+    BoatLogSyncStats stats;
+}BoatLogSync;
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+BOAT_RESULT BoatLogFilterInit(BOAT_OUT BoatLogFilter *filter_ptr, const UINT8 *address_ptr);
+
+BOAT_RESULT BoatLogFilterAddTopic(BoatLogFilter *filter_ptr, UINT32 position, const UINT8 topic[32]);
+
+BOAT_RESULT BoatLogFilterAddEvent(BoatLogFilter *filter_ptr, const CHAR *event_proto_str);
+
+BOATBOOL BoatLogFilterMatch(const BoatLogFilter *filter_ptr, const Web3Log *log_ptr);
+
+BOAT_RESULT BoatLogSyncInit(BOAT_OUT BoatLogSync *sync_ptr,
+                            const BoatWalletInfo *boat_wallet_info_ptr,
+                            const BoatLogFilter *filter_ptr,
+                            UINT64 from_block,
+                            Web3LogFunc log_func,
+                            void *log_ctx_ptr);
+
+void BoatLogSyncDeInit(BoatLogSync *sync_ptr);
+
+BOAT_RESULT BoatLogSyncCatchUp(BoatLogSync *sync_ptr, UINT64 to_block);
+
+BOAT_RESULT BoatLogSyncPoll(BoatLogSync *sync_ptr);
+
+void BoatLogSyncGetStats(const BoatLogSync *sync_ptr, BOAT_OUT BoatLogSyncStats *stats_ptr);
+
+#ifdef __cplusplus
+}
+#endif /* end of __cplusplus */
+
+#endif
@@ -0,0 +1,518 @@
+/******************************************************************************
+Copyright (C) 2018-2019 AITOS.IO
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+of the Software, and to permit persons to whom the Software is furnished to do
+so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+******************************************************************************/
+
+/*!@brief Memory-mapped keystore container with decrypted key cache
+
+@file
+keymap.c maps a keystore container read-only and decrypts its records on
+first use into a locked cache.
+*/
+
+// For MAP_ANONYMOUS and madvise()
+#define _DEFAULT_SOURCE
+
+#include "wallet/boatwallet.h"
+#include "wallet/keystore.h"
+#include "wallet/keymap.h"
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+
+
+/*!*****************************************************************************
+@brief Wipe a cache slot
+
+Function: KeystoreMapWipeSlot()
+
+@return This function doesn't return any thing.
+
+@param[in] slot_ptr
+    The cache slot to wipe.
+*******************************************************************************/
+static void KeystoreMapWipeSlot(BoatKeystoreMapSlot *slot_ptr)
+{
+    if( slot_ptr->wallet_info.network_info.node_url_ptr != NULL )
+    {
+        BoatFree(slot_ptr->wallet_info.network_info.node_url_ptr);
+    }
+
+    memset(slot_ptr, 0, sizeof(BoatKeystoreMapSlot));
+}
+
+
+/*!*****************************************************************************
+@brief Find the index entry of an address in a mapped keystore container
+
+Function: KeystoreMapFind()
+
+@return
+    This function returns the file offset of the account's record.\n
+    If the address is not in the container, it returns 0.
+
+@param[in] map_ptr
+    The mapped keystore container.
+
+@param[in] address
+    Address to find.
+*******************************************************************************/
+static UINT32 KeystoreMapFind(const BoatKeystoreMap *map_ptr, const BoatAddress address)
+{
+    const UINT8 *index_entry_ptr;
+    UINT32 record_offset_big;
+    UINT32 slot;
+    UINT32 entry_index;
+
+    if( map_ptr->hash_table_size == 0 )
+    {
+        return 0;
+    }
+
+    slot = BOAT_KEYSTORE_HASH_SLOT(address, map_ptr->hash_table_size);
+
+    while( (entry_index = map_ptr->hash_table[slot]) != 0 )
+    {
+        index_entry_ptr = map_ptr->index_ptr + (entry_index - 1) * BOAT_KEYSTORE_CONTAINER_INDEX_ENTRY_SIZE;
+        if( memcmp(index_entry_ptr, address, sizeof(BoatAddress)) == 0 )
+        {
+            memcpy(&record_offset_big, index_entry_ptr + sizeof(BoatAddress), sizeof(UINT32));
+            return Utilityntohl(record_offset_big);
+        }
+        slot = (slot + 1) & (map_ptr->hash_table_size - 1);
+    }
+
+    return 0;
+}
+
+
+/*!*****************************************************************************
+@brief Open a keystore container as a memory-mapped, read-only keystore
+
+Function: BoatKeystoreMapOpen()
+
+    This function maps a keystore container file created by
+    BoatKeystoreContainerOpen() and builds a hash table over its index in
+    place. No record is read or decrypted, so opening costs the same no matter
+    how many accounts are in the container.
+
+    It also allocates the cache arena for <slot_num> decrypted accounts and
+    locks it in memory so that decrypted private keys are never swapped out.
+    If the arena can't be locked (e.g. RLIMIT_MEMLOCK is too small), the map
+    still works with an unlocked arena.
+
+    The mapping is a snapshot of the index at open time. Accounts appended
+    to the container later are not visible until it's reopened.
+
+    BoatKeystoreMapClose() MUST be called after use of the map.
+
+@see
+    BoatKeystoreMapGet() BoatKeystoreMapClose()
+
+@return
+    This function returns BOAT_SUCCESS if the container is mapped.\n
+    Otherwise it returns BOAT_ERROR.
+
+@param[out] map_ptr
+    The keystore map to initialize.
+
+@param[in] file_path_str
+    Container file's path.
+
+@param[in] slot_num
+    Number of decrypted accounts to cache.\n
+    0 for BOAT_KEYSTORE_MAP_DEFAULT_SLOT_NUM.
+*******************************************************************************/
+BOAT_RESULT BoatKeystoreMapOpen(BOAT_OUT BoatKeystoreMap *map_ptr, const CHAR *file_path_str, UINT32 slot_num)
+{
+    int fd = -1;
+    struct stat file_stat;
+    void *mmap_ptr;
+    UINT32 value_big;
+    UINT32 index_offset;
+    UINT32 slot;
+    UINT32 i;
+
+    BOAT_RESULT result = BOAT_SUCCESS;
+    boat_try_declare;
+
+    if( map_ptr == NULL || file_path_str == NULL )
+    {
+        BoatLog(BOAT_LOG_NORMAL, "Arguments cannot be NULL.");
+        return BOAT_ERROR;
+    }
+
+    memset(map_ptr, 0, sizeof(BoatKeystoreMap));
+
+    fd = open(file_path_str, O_RDONLY);
+    if( fd < 0 || fstat(fd, &file_stat) != 0 )
+    {
+        BoatLog(BOAT_LOG_NORMAL, "Unable to open keystore container: %s.", file_path_str);
+        boat_throw(BOAT_ERROR, BoatKeystoreMapOpen_cleanup);
+    }
+
+    if( file_stat.st_size < BOAT_KEYSTORE_CONTAINER_HEADER_SIZE || file_stat.st_size > 0xFFFFFFFF )
+    {
+        BoatLog(BOAT_LOG_NORMAL, "Not a keystore container: %s.", file_path_str);
+        boat_throw(BOAT_ERROR, BoatKeystoreMapOpen_cleanup);
+    }
+
+    mmap_ptr = mmap(NULL, file_stat.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    if( mmap_ptr == MAP_FAILED )
+    {
+        BoatLog(BOAT_LOG_NORMAL, "Unable to map keystore container: %s.", file_path_str);
+        boat_throw(BOAT_ERROR, BoatKeystoreMapOpen_cleanup);
+    }
+    map_ptr->map_ptr = mmap_ptr;
+    map_ptr->map_size = (UINT32)file_stat.st_size;
+
+    // Records are read in random order, one account at a time
+    madvise(mmap_ptr, map_ptr->map_size, MADV_RANDOM);
+
+    if( memcmp(map_ptr->map_ptr, BOAT_KEYSTORE_CONTAINER_MAGIC, 4) != 0 )
+    {
+        BoatLog(BOAT_LOG_NORMAL, "Not a keystore container: %s.", file_path_str);
+        boat_throw(BOAT_ERROR, BoatKeystoreMapOpen_cleanup);
+    }
+
+    memcpy(&value_big, map_ptr->map_ptr + 4, sizeof(UINT32));
+    if( Utilityntohl(value_big) != BOAT_KEYSTORE_CONTAINER_VERSION )
+    {
+        BoatLog(BOAT_LOG_NORMAL, "Unsupported keystore container version: %u.", Utilityntohl(value_big));
+        boat_throw(BOAT_ERROR, BoatKeystoreMapOpen_cleanup);
+    }
+
+    memcpy(&value_big, map_ptr->map_ptr + 8, sizeof(UINT32));
+    index_offset = Utilityntohl(value_big);
+    memcpy(&value_big, map_ptr->map_ptr + 12, sizeof(UINT32));
+    map_ptr->index_num = Utilityntohl(value_big);
+
+    if(    index_offset > map_ptr->map_size
+        || map_ptr->index_num > (map_ptr->map_size - index_offset) / BOAT_KEYSTORE_CONTAINER_INDEX_ENTRY_SIZE )
+    {
+        BoatLog(BOAT_LOG_NORMAL, "Keystore container index is out of file: %s.", file_path_str);
+        boat_throw(BOAT_ERROR, BoatKeystoreMapOpen_cleanup);
+    }
+    map_ptr->index_ptr = map_ptr->map_ptr + index_offset;
+
+    // Hash table is kept at most half full
+    map_ptr->hash_table_size = 128;
+    while( map_ptr->hash_table_size < map_ptr->index_num * 2 )
+    {
+        map_ptr->hash_table_size *= 2;
+    }
+
+    map_ptr->hash_table = BoatMalloc(map_ptr->hash_table_size * sizeof(UINT32));
+    if( map_ptr->hash_table == NULL )
+    {
+        BoatLog(BOAT_LOG_NORMAL, "Fail to allocate memory.");
+        boat_throw(BOAT_ERROR, BoatKeystoreMapOpen_cleanup);
+    }
+    memset(map_ptr->hash_table, 0, map_ptr->hash_table_size * sizeof(UINT32));
+
+    for( i = 0; i < map_ptr->index_num; i++ )
+    {
+        slot = BOAT_KEYSTORE_HASH_SLOT(map_ptr->index_ptr + i * BOAT_KEYSTORE_CONTAINER_INDEX_ENTRY_SIZE, map_ptr->hash_table_size);
+        while( map_ptr->hash_table[slot] != 0 )
+        {
+            slot = (slot + 1) & (map_ptr->hash_table_size - 1);
+        }
+        map_ptr->hash_table[slot] = i + 1;
+    }
+
+    // Allocate the cache arena in its own pages, so that locking it doesn't
+    // lock anything else and it can be excluded from core dumps. The slot
+    // after the cache slots is where records are decrypted into.
+    map_ptr->slot_num = slot_num == 0 ? BOAT_KEYSTORE_MAP_DEFAULT_SLOT_NUM : slot_num;
+    map_ptr->arena_size = (map_ptr->slot_num + 1) * sizeof(BoatKeystoreMapSlot);
+
+    mmap_ptr = mmap(NULL, map_ptr->arena_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if( mmap_ptr == MAP_FAILED )
+    {
+        BoatLog(BOAT_LOG_NORMAL, "Fail to allocate memory.");
+        boat_throw(BOAT_ERROR, BoatKeystoreMapOpen_cleanup);
+    }
+    map_ptr->slot_array = mmap_ptr;
+
+#ifdef MADV_DONTDUMP
+    madvise(mmap_ptr, map_ptr->arena_size, MADV_DONTDUMP);
+#endif
+
+    if( mlock(mmap_ptr, map_ptr->arena_size) == 0 )
+    {
+        map_ptr->arena_locked = BOAT_TRUE;
+    }
+    else
+    {
+        BoatLog(BOAT_LOG_NORMAL, "Fail to lock keystore cache in memory, decrypted keys may be swapped out.");
+        map_ptr->arena_locked = BOAT_FALSE;
+    }
+
+    boat_catch(BoatKeystoreMapOpen_cleanup)
+    {
+        result = boat_exception;
+        BoatKeystoreMapClose(map_ptr);
+    }
+
+    // The mapping doesn't need the file descriptor
+    if( fd >= 0 )
+    {
+        close(fd);
+    }
+
+    return result;
+}
+
+
+/*!*****************************************************************************
+@brief Close a memory-mapped keystore
+
+Function: BoatKeystoreMapClose()
+
+    This function wipes all cached accounts, unlocks and frees the cache arena
+    and unmaps the container file.
+
+@return This function doesn't return any thing.
+
+@param[in] map_ptr
+    The keystore map to close.
+*******************************************************************************/
+void BoatKeystoreMapClose(BoatKeystoreMap *map_ptr)
+{
+    UINT32 i;
+
+    if( map_ptr == NULL )
+    {
+        return;
+    }
+
+    if( map_ptr->slot_array != NULL )
+    {
+        for( i = 0; i <= map_ptr->slot_num; i++ )
+        {
+            KeystoreMapWipeSlot(&map_ptr->slot_array[i]);
+        }
+
+        if( map_ptr->arena_locked == BOAT_TRUE )
+        {
+            munlock(map_ptr->slot_array, map_ptr->arena_size);
+        }
+        munmap(map_ptr->slot_array, map_ptr->arena_size);
+    }
+
+    if( map_ptr->hash_table != NULL )
+    {
+        BoatFree(map_ptr->hash_table);
+    }
+
+    if( map_ptr->map_ptr != NULL )
+    {
+        munmap((void *)map_ptr->map_ptr, map_ptr->map_size);
+    }
+
+    memset(map_ptr, 0, sizeof(BoatKeystoreMap));
+}
+
+
+/*!*****************************************************************************
+@brief Get a decrypted account from a memory-mapped keystore
+
+Function: BoatKeystoreMapGet()
+
+    This function returns the decrypted account of the address. On first use
+    of the account, its record is decrypted from the mapping into the cache,
+    evicting the least recently used account if the cache is full. Nothing is
+    evicted if the record fails to decrypt, e.g. with a wrong password. Later
+    uses are served from the cache after checking the password.
+
+    The returned account is owned by the map and lives in the locked arena.
+    Don't copy the private key out of it unless necessary. It's valid until
+    the next call to BoatKeystoreMapGet(), BoatKeystoreMapEvict() or
+    BoatKeystoreMapClose().
+
+@return
+    This function returns the decrypted account.\n
+    If the address is not in the container or the password is wrong, it\n
+    returns NULL.
+
+@param[in] map_ptr
+    The keystore map.
+
+@param[in] address
+    Address of the account.
+
+@param[in] passwd_ptr
+    Password to decrypt the account.
+
+@param[in] passwd_len
+    Length of <passwd_ptr> in byte.
+*******************************************************************************/
+const BoatWalletInfo *BoatKeystoreMapGet(BoatKeystoreMap *map_ptr,
+                                         const BoatAddress address,
+                                         const UINT8 *passwd_ptr,
+                                         UINT32 passwd_len)
+{
+    BoatKeystoreMapSlot *slot_ptr = NULL;
+    BoatKeystoreMapSlot *decode_slot_ptr;
+    UINT8 passwd_hash[32];
+    UINT32 record_offset;
+    UINT32 record_len_big;
+    UINT32 record_len;
+    UINT32 i;
+
+    if( map_ptr == NULL || map_ptr->map_ptr == NULL || address == NULL || passwd_ptr == NULL || passwd_len == 0 )
+    {
+        BoatLog(BOAT_LOG_NORMAL, "Arguments cannot be NULL.");
+        return NULL;
+    }
+
+    keccak_256(passwd_ptr, passwd_len, passwd_hash);
+
+    // Renumber use ticks on wrap around to keep LRU order roughly
+    if( ++map_ptr->use_tick == 0 )
+    {
+        for( i = 0; i < map_ptr->slot_num; i++ )
+        {
+            if( map_ptr->slot_array[i].last_use != 0 )
+            {
+                map_ptr->slot_array[i].last_use = 1;
+            }
+        }
+        map_ptr->use_tick = 2;
+    }
+
+    // Look up the cache, and find the slot to evict in case of miss
+    for( i = 0; i < map_ptr->slot_num; i++ )
+    {
+        if(    map_ptr->slot_array[i].last_use != 0
+            && memcmp(map_ptr->slot_array[i].wallet_info.account_info.address, address, sizeof(BoatAddress)) == 0 )
+        {
+            if( memcmp(map_ptr->slot_array[i].passwd_hash, passwd_hash, sizeof(passwd_hash)) != 0 )
+            {
+                BoatLog(BOAT_LOG_NORMAL, "Load wallet info fails: wrong password.");
+                memset(passwd_hash, 0, sizeof(passwd_hash));
+                return NULL;
+            }
+
+            memset(passwd_hash, 0, sizeof(passwd_hash));
+            map_ptr->slot_array[i].last_use = map_ptr->use_tick;
+            return &map_ptr->slot_array[i].wallet_info;
+        }
+
+        if( slot_ptr == NULL || map_ptr->slot_array[i].last_use < slot_ptr->last_use )
+        {
+            slot_ptr = &map_ptr->slot_array[i];
+        }
+    }
+
+    // Cache miss: decrypt the record from the mapping
+    record_offset = KeystoreMapFind(map_ptr, address);
+    if(    record_offset == 0
+        || record_offset > map_ptr->map_size - sizeof(UINT32) )
+    {
+        BoatLog(BOAT_LOG_VERBOSE, "Account is not in keystore container.");
+        memset(passwd_hash, 0, sizeof(passwd_hash));
+        return NULL;
+    }
+
+    memcpy(&record_len_big, map_ptr->map_ptr + record_offset, sizeof(UINT32));
+    record_len = Utilityntohl(record_len_big);
+    if( record_len > map_ptr->map_size - record_offset - sizeof(UINT32) )
+    {
+        BoatLog(BOAT_LOG_NORMAL, "Keystore record is out of file.");
+        memset(passwd_hash, 0, sizeof(passwd_hash));
+        return NULL;
+    }
+
+    // Decrypt into the spare slot, so that a wrong password doesn't evict
+    // the least recently used account
+    decode_slot_ptr = &map_ptr->slot_array[map_ptr->slot_num];
+    KeystoreMapWipeSlot(decode_slot_ptr);
+
+    if( BoatKeystoreRecordDecode(&decode_slot_ptr->wallet_info,
+                                 passwd_ptr,
+                                 passwd_len,
+                                 map_ptr->map_ptr + record_offset + sizeof(UINT32),
+                                 record_len) != BOAT_SUCCESS )
+    {
+        KeystoreMapWipeSlot(decode_slot_ptr);
+        memset(passwd_hash, 0, sizeof(passwd_hash));
+        return NULL;
+    }
+
+    if( memcmp(decode_slot_ptr->wallet_info.account_info.address, address, sizeof(BoatAddress)) != 0 )
+    {
+        BoatLog(BOAT_LOG_NORMAL, "Keystore container index doesn't match record.");
+        KeystoreMapWipeSlot(decode_slot_ptr);
+        memset(passwd_hash, 0, sizeof(passwd_hash));
+        return NULL;
+    }
+
+    // The decrypted account replaces the evicted one. The node URL moves
+    // with the copy, so the spare slot is cleared rather than wiped.
+    KeystoreMapWipeSlot(slot_ptr);
+    memcpy(slot_ptr, decode_slot_ptr, sizeof(BoatKeystoreMapSlot));
+    memset(decode_slot_ptr, 0, sizeof(BoatKeystoreMapSlot));
+
+    memcpy(slot_ptr->passwd_hash, passwd_hash, sizeof(passwd_hash));
+    slot_ptr->last_use = map_ptr->use_tick;
+    memset(passwd_hash, 0, sizeof(passwd_hash));
+
+    return &slot_ptr->wallet_info;
+}
+
+
+/*!*****************************************************************************
+@brief Evict an account from the cache of a memory-mapped keystore
+
+Function: BoatKeystoreMapEvict()
+
+    This function wipes the decrypted account of the address from the cache,
+    e.g. when the account won't be used for a while. It's decrypted again on
+    its next use.
+
+@return This function doesn't return any thing.
+
+@param[in] map_ptr
+    The keystore map.
+
+@param[in] address
+    Address of the account to evict.
+*******************************************************************************/
+void BoatKeystoreMapEvict(BoatKeystoreMap *map_ptr, const BoatAddress address)
+{
+    UINT32 i;
+
+    if( map_ptr == NULL || map_ptr->slot_array == NULL || address == NULL )
+    {
+        return;
+    }
+
+    for( i = 0; i < map_ptr->slot_num; i++ )
+    {
+        if(    map_ptr->slot_array[i].last_use != 0
+            && memcmp(map_ptr->slot_array[i].wallet_info.account_info.address, address, sizeof(BoatAddress)) == 0 )
+        {
+            KeystoreMapWipeSlot(&map_ptr->slot_array[i]);
+        }
+    }
+}
@@ -0,0 +1,89 @@
+/******************************************************************************
+Copyright (C) 2018-2019 AITOS.IO
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+of the Software, and to permit persons to whom the Software is furnished to do
+so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+******************************************************************************/
+
+/*!@brief Memory-mapped keystore container with decrypted key cache
+
+@file
+keymap.h is header file for read-only, memory-mapped access to a keystore
+container with a locked cache of decrypted accounts.
+*/
+
+#ifndef __KEYMAP_H__
+#define __KEYMAP_H__
+
+#include "wallet/boattypes.h"
+
+//! Number of cached accounts if 0 is passed to BoatKeystoreMapOpen()
+#define BOAT_KEYSTORE_MAP_DEFAULT_SLOT_NUM 16
+
+//!@brief Cached decrypted account of a mapped keystore container
+typedef struct TBoatKeystoreMapSlot
+{
+    BoatWalletInfo wallet_info;     //!< Decrypted wallet account
+    UINT8 passwd_hash[32];          //!< keccak_256 of the password used to decrypt it
+    UINT32 last_use;                //!< Use tick for LRU eviction, 0 if the slot is empty
+}BoatKeystoreMapSlot;
+
+//!@brief Memory-mapped keystore container
+
+//! The container file is mapped read-only and its index is used in place.
+//! A record is decrypted on first use of its account and kept in a cache of
+//! <slot_num> slots. The cache lives in a locked arena that is never swapped
+//! out or dumped, and the least recently used account is evicted and wiped
+//! when the cache is full. A record is decrypted into one more slot of the
+//! arena first, so that a failing decryption evicts nothing.
+typedef struct TBoatKeystoreMap
+{
+    const UINT8 *map_ptr;               //!< Mapped container file
+    UINT32 map_size;                    //!< Size of the mapping in byte
+    const UINT8 *index_ptr;             //!< Index of the container inside the mapping
+    UINT32 index_num;                   //!< Number of entries in the index
+    UINT32 *hash_table;                 //!< Index entry + 1 of each slot, 0 for empty slot
+    UINT32 hash_table_size;             //!< Number of slots, power of 2
+    BoatKeystoreMapSlot *slot_array;    //!< Locked cache arena, <slot_num> + 1 slots
+    UINT32 slot_num;                    //!< Number of cache slots in <slot_array>
+    UINT32 arena_size;                  //!< Size of the arena in byte
+    BOATBOOL arena_locked;              //!< BOAT_TRUE if the arena is locked in memory
+    UINT32 use_tick;                    //!< Tick of the latest use
+}BoatKeystoreMap;
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+BOAT_RESULT BoatKeystoreMapOpen(BOAT_OUT BoatKeystoreMap *map_ptr, const CHAR *file_path_str, UINT32 slot_num);
+
+void BoatKeystoreMapClose(BoatKeystoreMap *map_ptr);
+
+const BoatWalletInfo *BoatKeystoreMapGet(BoatKeystoreMap *map_ptr,
+                                         const BoatAddress address,
+                                         const UINT8 *passwd_ptr,
+                                         UINT32 passwd_len);
+
+void BoatKeystoreMapEvict(BoatKeystoreMap *map_ptr, const BoatAddress address);
+
+#ifdef __cplusplus
+}
+#endif /* end of __cplusplus */
+
+#endif
@@ -0,0 +1,1980 @@
+/******************************************************************************
+Copyright (C) 2018-2019 AITOS.IO
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+of the Software, and to permit persons to whom the Software is furnished to do
+so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+******************************************************************************/
+
+/*!@brief Keystore records and multi-account keystore container
+
+@file
+keystore.c encodes and decodes password protected keystore records and
+manages the multi-account keystore container.
+*/
+
+// For fileno(), fsync() and fstat()
+#define _DEFAULT_SOURCE
+
+#include "wallet/boatwallet.h"
+#include "wallet/keystore.h"
+#include "randgenerator.h"
+
+#if BOAT_USE_OPENSSL != 0
+#include <openssl/evp.h>
+#include <openssl/aes.h>
+#endif
+
+#include <pthread.h>
+#include <sys/stat.h>
+
+
+// Size of the "I" field excluding the node URL string, see BoatWalletSaveWalletEx()
+#define KEYSTORE_SIZE_EXCLUDE_URL \
+  ( sizeof(((AccountInfo *)0)->priv_key_array)\
+  + sizeof(((AccountInfo *)0)->pub_key_array)\
+  + sizeof(((AccountInfo *)0)->address)\
+  + sizeof(((NetworkInfo *)0)->chain_id)\
+  + sizeof(((NetworkInfo *)0)->eip155_compatibility)\
+  + sizeof(UINT32) )
+
+
+/*!*****************************************************************************
+@brief AES256-CBC encrypt or decrypt without padding
+
+Function: KeystoreAes256Cbc()
+
+    This function encrypts or decrypts <len> bytes with AES256-CBC. OpenSSL's
+    default PKCS padding is disabled, see BoatWalletSaveWalletEx() for why.
+
+@return
+    This function returns BOAT_SUCCESS if successful.\n
+    Otherwise it returns BOAT_ERROR.
+
+@param[in] encrypt
+    BOAT_TRUE to encrypt, BOAT_FALSE to decrypt.
+
+@param[in] aes256key
+    32-byte AES key.
+
+@param[in] iv
+    16-byte initial vector.
+
+@param[in] in_ptr
+    Input text.
+
+@param[out] out_ptr
+    Output text, at least <len> bytes.
+
+@param[in] len
+    Length of <in_ptr> in byte, multiple of AES_BLOCK_SIZE.
+*******************************************************************************/
+static BOAT_RESULT KeystoreAes256Cbc(BOATBOOL encrypt,
+                                     const UINT8 aes256key[32],
+                                     const UINT8 iv[16],
+                                     const UINT8 *in_ptr,
+                                     BOAT_OUT UINT8 *out_ptr,
+                                     UINT32 len)
+{
+#if OPENSSL_VERSION_NUMBER < 0x10100000L
+    EVP_CIPHER_CTX ctx;
+    EVP_CIPHER_CTX *ctx_ptr = &ctx;
+#else
+    EVP_CIPHER_CTX *ctx_ptr = NULL;
+#endif
+    int openssl_ret;
+    int openssl_len;
+    UINT32 total_len = 0;
+
+    BOAT_RESULT result = BOAT_SUCCESS;
+    boat_try_declare;
+
+    // Initialize OpenSSL EVP context for cipher/decipher
+#if OPENSSL_VERSION_NUMBER < 0x10100000L
+    EVP_CIPHER_CTX_init(ctx_ptr);
+#else
+    ctx_ptr = EVP_CIPHER_CTX_new();
+    if( ctx_ptr == NULL )
+    {
+        BoatLog(BOAT_LOG_NORMAL, "EVP_CIPHER_CTX_new failed.");
+        boat_throw(BOAT_ERROR, KeystoreAes256Cbc_cleanup);
+    }
+#endif
+
+    // Specify AES256-CBC Algorithm, AES key and initial vector of CBC
+    openssl_ret = EVP_CipherInit_ex(ctx_ptr, EVP_aes_256_cbc(), NULL, aes256key, iv, encrypt ? 1 : 0);
+    if( openssl_ret != 1 )
+    {
+        BoatLog(BOAT_LOG_NORMAL, "EVP_CipherInit_ex failed.");
+        boat_throw(BOAT_ERROR, KeystoreAes256Cbc_cleanup);
+    }
+
+    // Disable default padding, because default PKCS padding cannot be distinguished
+    // from effective data in some extreme case.
+    EVP_CIPHER_CTX_set_padding(ctx_ptr, 0);
+
+    openssl_ret = EVP_CipherUpdate(ctx_ptr, out_ptr, &openssl_len, in_ptr, len);
+    if( openssl_ret != 1 )
+    {
+        BoatLog(BOAT_LOG_NORMAL, "EVP_CipherUpdate failed.");
+        boat_throw(BOAT_ERROR, KeystoreAes256Cbc_cleanup);
+    }
+    total_len += openssl_len;
+
+    openssl_ret = EVP_CipherFinal_ex(ctx_ptr, out_ptr + total_len, &openssl_len);
+    if( openssl_ret != 1 )
+    {
+        BoatLog(BOAT_LOG_NORMAL, "EVP_CipherFinal_ex failed.");
+        boat_throw(BOAT_ERROR, KeystoreAes256Cbc_cleanup);
+    }
+
+    boat_catch(KeystoreAes256Cbc_cleanup)
+    {
+        result = boat_exception;
+    }
+
+#if OPENSSL_VERSION_NUMBER < 0x10100000L
+    EVP_CIPHER_CTX_cleanup(&ctx);
+#else
+    if( ctx_ptr != NULL )
+    {
+        EVP_CIPHER_CTX_free(ctx_ptr);
+    }
+#endif
+
+    return result;
+}
+
+
+// Process-level KDF for new records and derived key cache. See BoatKeystoreSetKdf().
+static BoatKeystoreKdf g_keystore_kdf =
+{
+    (BoatKeystoreKdfType)BOAT_KEYSTORE_KDF,
+    BOAT_KEYSTORE_KDF_COST,
+    BOAT_KEYSTORE_KDF_SCRYPT_R,
+    BOAT_KEYSTORE_KDF_SCRYPT_P
+};
+static UINT8 g_keystore_kdf_salt[BOAT_KEYSTORE_KDF_SALT_SIZE];
+static BOATBOOL g_keystore_kdf_salt_ready = BOAT_FALSE;
+
+//!@brief Derived key cache entry
+typedef struct TKeystoreKdfCacheEntry
+{
+    UINT8 tag[32];          // keccak_256 of KDF parameters, salt and password
+    UINT8 aes256key[32];    // Derived key
+    UINT32 last_use;        // Use tick for LRU replacement, 0 if the entry is empty
+}KeystoreKdfCacheEntry;
+
+static KeystoreKdfCacheEntry g_keystore_kdf_cache[BOAT_KEYSTORE_KDF_CACHE_NUM];
+static UINT32 g_keystore_kdf_cache_tick = 0;
+static BOATBOOL g_keystore_kdf_cache_bypass = BOAT_FALSE;
+static pthread_mutex_t g_keystore_kdf_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+
+/*!*****************************************************************************
+@brief Check KDF parameters
+
+Function: KeystoreCheckKdf()
+
+@return
+    This function returns BOAT_SUCCESS if the KDF and its parameters are supported.\n
+    Otherwise it returns BOAT_ERROR.
+
+@param[in] kdf_ptr
+    The KDF to check.
+*******************************************************************************/
+static BOAT_RESULT KeystoreCheckKdf(const BoatKeystoreKdf *kdf_ptr)
+{
+    switch( kdf_ptr->type )
+    {
+        case BOAT_KEYSTORE_KDF_KECCAK:
+            return BOAT_SUCCESS;
+
+        case BOAT_KEYSTORE_KDF_PBKDF2:
+            if( kdf_ptr->cost == 0 || kdf_ptr->cost > BOAT_KEYSTORE_KDF_COST_MAX )
+            {
+                BoatLog(BOAT_LOG_NORMAL, "Invalid PBKDF2 iteration count: %u.", kdf_ptr->cost);
+                return BOAT_ERROR;
+            }
+            return BOAT_SUCCESS;
+
+        case BOAT_KEYSTORE_KDF_SCRYPT:
+#if OPENSSL_VERSION_NUMBER < 0x10100000L
+            BoatLog(BOAT_LOG_NORMAL, "scrypt requires OpenSSL 1.1.0 or later.");
+            return BOAT_ERROR;
+#else
+            if(    kdf_ptr->cost < 2 || kdf_ptr->cost > BOAT_KEYSTORE_KDF_COST_MAX
+                || (kdf_ptr->cost & (kdf_ptr->cost - 1)) != 0
+                || kdf_ptr->r == 0 || kdf_ptr->p == 0
+                || (UINT64)kdf_ptr->r * kdf_ptr->p >= (1u << 30)
+                || (UINT64)128 * kdf_ptr->r * ((UINT64)kdf_ptr->cost + kdf_ptr->p + 2) > BOAT_KEYSTORE_KDF_SCRYPT_MAX_MEM )
+            {
+                BoatLog(BOAT_LOG_NORMAL, "Invalid scrypt parameters: N=%u r=%u p=%u.", kdf_ptr->cost, kdf_ptr->r, kdf_ptr->p);
+                return BOAT_ERROR;
+            }
+            return BOAT_SUCCESS;
+#endif
+
+        default:
+            BoatLog(BOAT_LOG_NORMAL, "Unknown keystore KDF: %d.", (int)kdf_ptr->type);
+            return BOAT_ERROR;
+    }
+}
+
+
+/*!*****************************************************************************
+@brief Derive the AES key of a keystore record from the password
+
+Function: KeystoreDeriveKey()
+
+    This function derives the AES-256 key from the user specified password
+    with the specified KDF. No matter how long the password is, the key is
+    always 256 bit.
+
+    For BOAT_KEYSTORE_KDF_KECCAK, the key is the keccak_256 hash of the
+    password and <salt> is ignored.
+
+    Keys derived by PBKDF2 and scrypt are cached per process, keyed by the
+    KDF parameters, the salt and the password. Records written by one process
+    share a salt (see BoatKeystoreSetKdf()), so loading many records protected
+    by the same password costs one derivation.
+
+@return
+    This function returns BOAT_SUCCESS if the key is derived.\n
+    Otherwise it returns BOAT_ERROR.
+
+@param[in] kdf_ptr
+    The KDF and its parameters.
+
+@param[in] salt
+    BOAT_KEYSTORE_KDF_SALT_SIZE bytes salt.
+
+@param[in] passwd_ptr
+    Password.
+
+@param[in] passwd_len
+    Length of <passwd_ptr> in byte.
+
+@param[out] aes256key
+    The derived 32-byte AES key.
+*******************************************************************************/
+static BOAT_RESULT KeystoreDeriveKey(const BoatKeystoreKdf *kdf_ptr,
+                                     const UINT8 salt[BOAT_KEYSTORE_KDF_SALT_SIZE],
+                                     const UINT8 *passwd_ptr,
+                                     UINT32 passwd_len,
+                                     BOAT_OUT UINT8 aes256key[32])
+{
+    SHA3_CTX sha3_ctx;
+    UINT8 kdf_param_array[12];
+    UINT8 tag[32];
+    UINT32 value_big;
+    KeystoreKdfCacheEntry *entry_ptr = NULL;
+    int openssl_ret = 0;
+    UINT32 i;
+
+    if( kdf_ptr->type == BOAT_KEYSTORE_KDF_KECCAK )
+    {
+        keccak_256(passwd_ptr, passwd_len, aes256key);
+        return BOAT_SUCCESS;
+    }
+
+    if( KeystoreCheckKdf(kdf_ptr) != BOAT_SUCCESS )
+    {
+        return BOAT_ERROR;
+    }
+
+    // Cache tag covers everything the derived key depends on
+    value_big = Utilityhtonl((UINT32)kdf_ptr->type);
+    memcpy(kdf_param_array, &value_big, sizeof(UINT32));
+    value_big = Utilityhtonl(kdf_ptr->cost);
+    memcpy(kdf_param_array + 4, &value_big, sizeof(UINT32));
+    value_big = Utilityhtonl(((UINT32)kdf_ptr->r << 16) | kdf_ptr->p);
+    memcpy(kdf_param_array + 8, &value_big, sizeof(UINT32));
+
+    keccak_256_Init(&sha3_ctx);
+    keccak_Update(&sha3_ctx, kdf_param_array, sizeof(kdf_param_array));
+    keccak_Update(&sha3_ctx, salt, BOAT_KEYSTORE_KDF_SALT_SIZE);
+    keccak_Update(&sha3_ctx, passwd_ptr, passwd_len);
+    keccak_Final(&sha3_ctx, tag);
+
+    if( g_keystore_kdf_cache_bypass != BOAT_TRUE )
+    {
+        pthread_mutex_lock(&g_keystore_kdf_mutex);
+        for( i = 0; i < BOAT_KEYSTORE_KDF_CACHE_NUM; i++ )
+        {
+            if(    g_keystore_kdf_cache[i].last_use != 0
+                && memcmp(g_keystore_kdf_cache[i].tag, tag, sizeof(tag)) == 0 )
+            {
+                g_keystore_kdf_cache[i].last_use = ++g_keystore_kdf_cache_tick;
+                memcpy(aes256key, g_keystore_kdf_cache[i].aes256key, 32);
+                pthread_mutex_unlock(&g_keystore_kdf_mutex);
+                memset(tag, 0, sizeof(tag));
+                return BOAT_SUCCESS;
+            }
+        }
+        pthread_mutex_unlock(&g_keystore_kdf_mutex);
+    }
+
+    // Derive outside the lock, it may take long by design
+    if( kdf_ptr->type == BOAT_KEYSTORE_KDF_PBKDF2 )
+    {
+        openssl_ret = PKCS5_PBKDF2_HMAC((const char *)passwd_ptr, passwd_len,
+                                        salt, BOAT_KEYSTORE_KDF_SALT_SIZE,
+                                        kdf_ptr->cost, EVP_sha256(),
+                                        32, aes256key);
+    }
+#if OPENSSL_VERSION_NUMBER >= 0x10100000L
+    else
+    {
+        // OpenSSL refuses to use more memory than maxmem, which is 128*r*(N+p+2)
+        openssl_ret = EVP_PBE_scrypt((const char *)passwd_ptr, passwd_len,
+                                     salt, BOAT_KEYSTORE_KDF_SALT_SIZE,
+                                     kdf_ptr->cost, kdf_ptr->r, kdf_ptr->p,
+                                     (UINT64)128 * kdf_ptr->r * ((UINT64)kdf_ptr->cost + kdf_ptr->p + 2),
+                                     aes256key, 32);
+    }
+#endif
+
+    if( openssl_ret != 1 )
+    {
+        BoatLog(BOAT_LOG_NORMAL, "Keystore key derivation failed.");
+        memset(tag, 0, sizeof(tag));
+        return BOAT_ERROR;
+    }
+
+    if( g_keystore_kdf_cache_bypass != BOAT_TRUE )
+    {
+        pthread_mutex_lock(&g_keystore_kdf_mutex);
+        for( i = 0; i < BOAT_KEYSTORE_KDF_CACHE_NUM; i++ )
+        {
+            if( entry_ptr == NULL || g_keystore_kdf_cache[i].last_use < entry_ptr->last_use )
+            {
+                entry_ptr = &g_keystore_kdf_cache[i];
+            }
+        }
+        memcpy(entry_ptr->tag, tag, sizeof(tag));
+        memcpy(entry_ptr->aes256key, aes256key, 32);
+        entry_ptr->last_use = ++g_keystore_kdf_cache_tick;
+        pthread_mutex_unlock(&g_keystore_kdf_mutex);
+    }
+
+    memset(tag, 0, sizeof(tag));
+
+    return BOAT_SUCCESS;
+}
+
+
+/*!*****************************************************************************
+@brief Set the KDF of keystore records saved by this process
+
+Function: BoatKeystoreSetKdf()
+
+    This function sets the key derivation function and its cost for keystore
+    records encoded afterwards, including those saved by
+    BoatWalletSaveWalletEx() and appended to keystore containers. Records of
+    any KDF can be decoded regardless of this setting, because the KDF and
+    its parameters are stored in the record's KDF header.
+
+    The default is BOAT_KEYSTORE_KDF in boatoptions.h. BOAT_KEYSTORE_KDF_KECCAK
+    writes records in the legacy format without KDF header, which are
+    readable by older versions of BoAT SDK.
+
+    All records encoded by this process with the same KDF share one random
+    salt, so that bulk loads of records with the same password derive the
+    key only once. Calling this function picks a new salt.
+
+    Records being encoded concurrently keep the KDF and salt they started with.
+
+@return
+    This function returns BOAT_SUCCESS if the KDF is set.\n
+    Otherwise it returns BOAT_ERROR.
+
+@param[in] kdf_ptr
+    The KDF and its parameters.\n
+    NULL to restore the defaults in boatoptions.h.
+*******************************************************************************/
+BOAT_RESULT BoatKeystoreSetKdf(const BoatKeystoreKdf *kdf_ptr)
+{
+    BoatKeystoreKdf kdf_default =
+    {
+        (BoatKeystoreKdfType)BOAT_KEYSTORE_KDF,
+        BOAT_KEYSTORE_KDF_COST,
+        BOAT_KEYSTORE_KDF_SCRYPT_R,
+        BOAT_KEYSTORE_KDF_SCRYPT_P
+    };
+
+    if( kdf_ptr == NULL )
+    {
+        kdf_ptr = &kdf_default;
+    }
+
+    if( KeystoreCheckKdf(kdf_ptr) != BOAT_SUCCESS )
+    {
+        return BOAT_ERROR;
+    }
+
+    pthread_mutex_lock(&g_keystore_kdf_mutex);
+    g_keystore_kdf = *kdf_ptr;
+    g_keystore_kdf_salt_ready = BOAT_FALSE;
+    pthread_mutex_unlock(&g_keystore_kdf_mutex);
+
+    return BOAT_SUCCESS;
+}
+
+
+/*!*****************************************************************************
+@brief Wipe the derived key cache
+
+Function: BoatKeystoreKdfCacheFlush()
+
+    This function wipes all keys cached by keystore key derivation, e.g. after
+    bulk loading is done, so that no derived key stays in memory.
+
+@return This function doesn't return any thing.
+
+@param This function doesn't take any argument.
+*******************************************************************************/
+void BoatKeystoreKdfCacheFlush(void)
+{
+    pthread_mutex_lock(&g_keystore_kdf_mutex);
+    memset(g_keystore_kdf_cache, 0, sizeof(g_keystore_kdf_cache));
+    g_keystore_kdf_cache_tick = 0;
+    pthread_mutex_unlock(&g_keystore_kdf_mutex);
+}
+
+
+/*!*****************************************************************************
+@brief Measure the cost of loading a keystore record with a KDF
+
+Function: BoatKeystoreKdfBenchmark()
+
+    This function encodes a keystore record of a random account with the
+    specified KDF and decodes it <rounds> times with the derived key cache
+    bypassed, i.e. as loading a keystore protected by a password not seen
+    before. It logs the average cost per load and per cached load on the
+    running hardware, so that BOAT_KEYSTORE_KDF_COST can be tuned to the
+    acceptable load time of the target.
+
+    The cost is measured in processor time, which is the cost of key
+    derivation as it's CPU-bound.
+
+    This function temporarily changes the process-level KDF and is not
+    thread-safe.
+
+@return
+    This function returns average microseconds per load without cache.\n
+    If any error occurs, it returns 0.
+
+@param[in] kdf_ptr
+    The KDF and its parameters to measure.
+
+@param[in] rounds
+    Number of loads to measure.
+*******************************************************************************/
+UINT32 BoatKeystoreKdfBenchmark(const BoatKeystoreKdf *kdf_ptr, UINT32 rounds)
+{
+    BoatKeystoreKdf kdf_saved = g_keystore_kdf;
+    BoatWalletInfo wallet_info;
+    BoatWalletInfo loaded_wallet_info;
+    UINT8 *record_ptr = NULL;
+    UINT32 record_size = 0;
+    UINT32 record_len = 0;
+    clock_t start_clock;
+    UINT32 load_us = 0;
+    UINT32 cached_load_us = 0;
+    UINT32 round_index;
+    UINT32 i;
+
+    BOAT_RESULT result = BOAT_SUCCESS;
+    boat_try_declare;
+
+    if( kdf_ptr == NULL || rounds == 0 )
+    {
+        BoatLog(BOAT_LOG_NORMAL, "Arguments cannot be NULL.");
+        return 0;
+    }
+
+    memset(&wallet_info, 0, sizeof(wallet_info));
+    wallet_info.network_info.node_url_ptr = "http://127.0.0.1:7545";
+
+    if(    BoatKeystoreSetKdf(kdf_ptr) != BOAT_SUCCESS
+        || BoatWalletBulkGenerateAccount(&wallet_info.account_info, 1) != BOAT_SUCCESS )
+    {
+        boat_throw(BOAT_ERROR, BoatKeystoreKdfBenchmark_cleanup);
+    }
+
+    record_size = BoatKeystoreRecordSize(&wallet_info);
+    record_ptr = BoatMalloc(record_size);
+    if( record_ptr == NULL )
+    {
+        BoatLog(BOAT_LOG_NORMAL, "Fail to allocate memory.");
+        boat_throw(BOAT_ERROR, BoatKeystoreKdfBenchmark_cleanup);
+    }
+
+    if( BoatKeystoreRecordEncode(&wallet_info, (const UINT8 *)"benchmark", 9, record_ptr, record_size, &record_len) != BOAT_SUCCESS )
+    {
+        boat_throw(BOAT_ERROR, BoatKeystoreKdfBenchmark_cleanup);
+    }
+
+    for( i = 0; i < 2; i++ )
+    {
+        g_keystore_kdf_cache_bypass = (i == 0) ? BOAT_TRUE : BOAT_FALSE;
+
+        start_clock = clock();
+        for( round_index = 0; round_index < rounds; round_index++ )
+        {
+            if( BoatKeystoreRecordDecode(&loaded_wallet_info, (const UINT8 *)"benchmark", 9, record_ptr, record_len) != BOAT_SUCCESS )
+            {
+                boat_throw(BOAT_ERROR, BoatKeystoreKdfBenchmark_cleanup);
+            }
+            BoatFree(loaded_wallet_info.network_info.node_url_ptr);
+        }
+
+        if( i == 0 )
+        {
+            load_us = (UINT32)((double)(clock() - start_clock) * 1000000 / CLOCKS_PER_SEC / rounds);
+        }
+        else
+        {
+            cached_load_us = (UINT32)((double)(clock() - start_clock) * 1000000 / CLOCKS_PER_SEC / rounds);
+        }
+    }
+
+    BoatLog(BOAT_LOG_CRITICAL, "Keystore KDF %d (cost %u, r %u, p %u): %u us per load, %u us per cached load.",
+            (int)kdf_ptr->type, kdf_ptr->cost, kdf_ptr->r, kdf_ptr->p, load_us, cached_load_us);
+
+    boat_catch(BoatKeystoreKdfBenchmark_cleanup)
+    {
+        result = boat_exception;
+        load_us = 0;
+    }
+
+    g_keystore_kdf_cache_bypass = BOAT_FALSE;
+    pthread_mutex_lock(&g_keystore_kdf_mutex);
+    g_keystore_kdf = kdf_saved;
+    g_keystore_kdf_salt_ready = BOAT_FALSE;
+    pthread_mutex_unlock(&g_keystore_kdf_mutex);
+
+    memset(&wallet_info.account_info, 0, sizeof(wallet_info.account_info));
+    memset(&loaded_wallet_info.account_info, 0, sizeof(loaded_wallet_info.account_info));
+
+    if( record_ptr != NULL )
+    {
+        BoatFree(record_ptr);
+    }
+
+    return (result == BOAT_SUCCESS) ? load_us : 0;
+}
+
+
+/*!*****************************************************************************
+@brief Get the size of the keystore record of a wallet account
+
+Function: BoatKeystoreRecordSize()
+
+    This function returns the size in byte of the keystore record that
+    BoatKeystoreRecordEncode() generates for the wallet account.
+
+@return
+    This function returns the record size in byte.\n
+    If <wallet_info_ptr> or its node URL is NULL, it returns 0.
+
+@param[in] wallet_info_ptr
+    Pointer to the wallet account.
+*******************************************************************************/
+UINT32 BoatKeystoreRecordSize(const BoatWalletInfo *wallet_info_ptr)
+{
+    if( wallet_info_ptr == NULL || wallet_info_ptr->network_info.node_url_ptr == NULL )
+    {
+        return 0;
+    }
+
+    return(  (g_keystore_kdf.type != BOAT_KEYSTORE_KDF_KECCAK ? BOAT_KEYSTORE_KDF_HEADER_SIZE : 0)
+           + BOAT_KEYSTORE_RECORD_HEADER_SIZE
+           + AES_BLOCK_SIZE
+           + ROUNDUP(KEYSTORE_SIZE_EXCLUDE_URL + strlen(wallet_info_ptr->network_info.node_url_ptr), AES_BLOCK_SIZE));
+}
+
+
+/*!*****************************************************************************
+@brief Encode a wallet account into a password protected keystore record
+
+Function: BoatKeystoreRecordEncode()
+
+    This function encodes the wallet account into a keystore record in memory.
+    The record layout is the keystore file format described in
+    BoatWalletSaveWalletEx(), i.e. IH, IL and the AES256-CBC encrypted D, I
+    and P fields.
+
+    Unless the process-level KDF (see BoatKeystoreSetKdf()) is
+    BOAT_KEYSTORE_KDF_KECCAK, the record is prefixed with a KDF header:
+
+    --------------------------------------------------------
+    | Magic | V | K | 0 | Cost | R | P | Salt | IH | IL ...
+    --------------------------------------------------------
+
+    Magic: 4 bytes BOAT_KEYSTORE_KDF_MAGIC
+    V:     1 byte format version BOAT_KEYSTORE_KDF_VERSION
+    K:     1 byte KDF, see BoatKeystoreKdfType
+    0:     2 bytes reserved, zero
+    Cost:  4 bytes PBKDF2 iteration count or scrypt N, in BigEndian
+    R, P:  2 bytes each, scrypt r and p, in BigEndian
+    Salt:  BOAT_KEYSTORE_KDF_SALT_SIZE bytes salt of the KDF
+
+    and the AES key is derived by the KDF instead of keccak_256.
+
+    This function will call BoatWalletCheckPrivkey() to check the validity of
+    the private key.
+
+@see
+    BoatKeystoreRecordDecode() BoatKeystoreRecordSize() BoatWalletSaveWalletEx()
+
+@return
+    This function returns BOAT_SUCCESS if the record is encoded.\n
+    Otherwise it returns BOAT_ERROR.
+
+@param[in] wallet_info_ptr
+    Pointer to the wallet account to encode.
+
+@param[in] passwd_ptr
+    Password to encrypt the wallet info.
+
+@param[in] passwd_len
+    Length of <passwd_ptr> in byte.
+
+@param[out] record_ptr
+    Buffer to hold the record.
+
+@param[in] record_size
+    Size of <record_ptr> in byte, at least BoatKeystoreRecordSize().
+
+@param[out] record_len_ptr
+    Length of the encoded record in byte.
+*******************************************************************************/
+BOAT_RESULT BoatKeystoreRecordEncode(const BoatWalletInfo *wallet_info_ptr,
+                                     const UINT8 *passwd_ptr,
+                                     UINT32 passwd_len,
+                                     BOAT_OUT UINT8 *record_ptr,
+                                     UINT32 record_size,
+                                     BOAT_OUT UINT32 *record_len_ptr)
+{
+    UINT8 aes256key[32];
+    UINT8 iv[16];  // Initial Vector is used for AES-CBC encryption and not for AES-ECB
+    BoatKeystoreKdf kdf;
+    UINT8 kdf_salt[BOAT_KEYSTORE_KDF_SALT_SIZE];
+    UINT8 *body_ptr;
+    UINT32 value_big;
+
+    UINT8 *plain_wallet_info_array = NULL;
+    UINT32 plain_wallet_info_len = 0;
+    UINT32 plain_wallet_info_len_big;
+    UINT32 encrypted_total_len;
+    UINT32 node_url_str_len;
+    UINT32 node_url_str_len_big;
+    UINT32 chain_id_big;
+
+    BOAT_RESULT result = BOAT_SUCCESS;
+    boat_try_declare;
+
+    if( wallet_info_ptr == NULL || passwd_ptr == NULL || passwd_len == 0
+        || record_ptr == NULL || record_len_ptr == NULL )
+    {
+        BoatLog(BOAT_LOG_NORMAL, "Arguments cannot be NULL.");
+        return BOAT_ERROR;
+    }
+
+    if( wallet_info_ptr->network_info.node_url_ptr == NULL )
+    {
+        BoatLog(BOAT_LOG_NORMAL, "Node URL cannot be NULL.");
+        return BOAT_ERROR;
+    }
+
+    if( BoatWalletCheckPrivkey(wallet_info_ptr->account_info.priv_key_array) != BOAT_SUCCESS )
+    {
+        BoatLog(BOAT_LOG_NORMAL, "Private key is not valid.");
+        return BOAT_ERROR;
+    }
+
+    node_url_str_len = strlen(wallet_info_ptr->network_info.node_url_ptr);
+
+    // Encrypted length includes D and P but not node url's NULL Terminator
+    encrypted_total_len = AES_BLOCK_SIZE + ROUNDUP(KEYSTORE_SIZE_EXCLUDE_URL + node_url_str_len, AES_BLOCK_SIZE);
+
+    plain_wallet_info_array = BoatMalloc(encrypted_total_len);
+    if( plain_wallet_info_array == NULL )
+    {
+        BoatLog(BOAT_LOG_NORMAL, "Fail to allocate memory.");
+        boat_throw(BOAT_ERROR, BoatKeystoreRecordEncode_cleanup);
+    }
+    memset(plain_wallet_info_array, 0, encrypted_total_len);
+
+    // Use random number for the initial vector
+    result = random_stream(iv, 16);
+    if( result != BOAT_SUCCESS )
+    {
+        boat_throw(BOAT_ERROR, BoatKeystoreRecordEncode_cleanup);
+    }
+
+    // Reserve beginning AES_BLOCK_SIZE bytes for IV-independent decryption
+    plain_wallet_info_len = AES_BLOCK_SIZE;
+
+    memcpy(plain_wallet_info_array + plain_wallet_info_len, &wallet_info_ptr->account_info.priv_key_array, sizeof(wallet_info_ptr->account_info.priv_key_array));
+    plain_wallet_info_len += sizeof(wallet_info_ptr->account_info.priv_key_array);
+
+    memcpy(plain_wallet_info_array + plain_wallet_info_len, &wallet_info_ptr->account_info.pub_key_array, sizeof(wallet_info_ptr->account_info.pub_key_array));
+    plain_wallet_info_len += sizeof(wallet_info_ptr->account_info.pub_key_array);
+
+    memcpy(plain_wallet_info_array + plain_wallet_info_len, &wallet_info_ptr->account_info.address, sizeof(wallet_info_ptr->account_info.address));
+    plain_wallet_info_len += sizeof(wallet_info_ptr->account_info.address);
+
+    chain_id_big = Utilityhtonl(wallet_info_ptr->network_info.chain_id);
+    memcpy(plain_wallet_info_array + plain_wallet_info_len, &chain_id_big, sizeof(UINT32));
+    plain_wallet_info_len += sizeof(UINT32);
+
+    memcpy(plain_wallet_info_array + plain_wallet_info_len, &wallet_info_ptr->network_info.eip155_compatibility, sizeof(wallet_info_ptr->network_info.eip155_compatibility));
+    plain_wallet_info_len += sizeof(wallet_info_ptr->network_info.eip155_compatibility);
+
+    node_url_str_len_big = Utilityhtonl(node_url_str_len);
+    memcpy(plain_wallet_info_array + plain_wallet_info_len, &node_url_str_len_big, sizeof(UINT32));
+    plain_wallet_info_len += sizeof(UINT32);
+
+    memcpy(plain_wallet_info_array + plain_wallet_info_len, wallet_info_ptr->network_info.node_url_ptr, node_url_str_len);
+    plain_wallet_info_len += node_url_str_len;
+
+    // Take the KDF and its salt at once, so that the header and the key agree
+    // even if another thread picks the salt or sets the KDF meanwhile
+    pthread_mutex_lock(&g_keystore_kdf_mutex);
+    kdf = g_keystore_kdf;
+    if( kdf.type != BOAT_KEYSTORE_KDF_KECCAK && g_keystore_kdf_salt_ready != BOAT_TRUE )
+    {
+        result = random_stream(g_keystore_kdf_salt, sizeof(g_keystore_kdf_salt));
+        if( result == BOAT_SUCCESS ) g_keystore_kdf_salt_ready = BOAT_TRUE;
+    }
+    memcpy(kdf_salt, g_keystore_kdf_salt, sizeof(kdf_salt));
+    pthread_mutex_unlock(&g_keystore_kdf_mutex);
+
+    if( result != BOAT_SUCCESS )
+    {
+        boat_throw(BOAT_ERROR, BoatKeystoreRecordEncode_cleanup);
+    }
+
+    // Same as BoatKeystoreRecordSize(), but with the KDF taken above
+    if( record_size <   (kdf.type != BOAT_KEYSTORE_KDF_KECCAK ? BOAT_KEYSTORE_KDF_HEADER_SIZE : 0)
+                      + BOAT_KEYSTORE_RECORD_HEADER_SIZE + encrypted_total_len )
+    {
+        BoatLog(BOAT_LOG_NORMAL, "Keystore record buffer is too small.");
+        boat_throw(BOAT_ERROR, BoatKeystoreRecordEncode_cleanup);
+    }
+
+    // KDF header
+    body_ptr = record_ptr;
+    if( kdf.type != BOAT_KEYSTORE_KDF_KECCAK )
+    {
+        memset(record_ptr, 0, BOAT_KEYSTORE_KDF_HEADER_SIZE);
+        memcpy(record_ptr, BOAT_KEYSTORE_KDF_MAGIC, 4);
+        record_ptr[4] = BOAT_KEYSTORE_KDF_VERSION;
+        record_ptr[5] = (UINT8)kdf.type;
+        value_big = Utilityhtonl(kdf.cost);
+        memcpy(record_ptr + 8, &value_big, sizeof(UINT32));
+        value_big = Utilityhtonl(((UINT32)kdf.r << 16) | kdf.p);
+        memcpy(record_ptr + 12, &value_big, sizeof(UINT32));
+        memcpy(record_ptr + 16, kdf_salt, BOAT_KEYSTORE_KDF_SALT_SIZE);
+
+        body_ptr = record_ptr + BOAT_KEYSTORE_KDF_HEADER_SIZE;
+    }
+
+    // IH: wallet info hash
+    keccak_256(plain_wallet_info_array + AES_BLOCK_SIZE, plain_wallet_info_len - AES_BLOCK_SIZE, body_ptr);
+
+    // IL: plain wallet info length (excluding padding) in big endian
+    plain_wallet_info_len_big = Utilityhtonl(plain_wallet_info_len);
+    memcpy(body_ptr + 32, &plain_wallet_info_len_big, sizeof(UINT32));
+
+    // Derive the AES key from the password
+    result = KeystoreDeriveKey(&kdf, kdf_salt, passwd_ptr, passwd_len, aes256key);
+    if( result != BOAT_SUCCESS )
+    {
+        boat_throw(BOAT_ERROR, BoatKeystoreRecordEncode_cleanup);
+    }
+
+    // Encrypted wallet info
+    result = KeystoreAes256Cbc(BOAT_TRUE,
+                               aes256key,
+                               iv,
+                               plain_wallet_info_array,
+                               body_ptr + BOAT_KEYSTORE_RECORD_HEADER_SIZE,
+                               encrypted_total_len);
+    if( result != BOAT_SUCCESS )
+    {
+        boat_throw(BOAT_ERROR, BoatKeystoreRecordEncode_cleanup);
+    }
+
+    *record_len_ptr = (UINT32)(body_ptr - record_ptr) + BOAT_KEYSTORE_RECORD_HEADER_SIZE + encrypted_total_len;
+
+    boat_catch(BoatKeystoreRecordEncode_cleanup)
+    {
+        result = boat_exception;
+    }
+
+    // Destroy sensitive information
+    memset(aes256key, 0, sizeof(aes256key));
+
+    if( plain_wallet_info_array != NULL )
+    {
+        memset(plain_wallet_info_array, 0, encrypted_total_len);
+        BoatFree(plain_wallet_info_array);
+    }
+
+    return result;
+}
+
+
+/*!*****************************************************************************
+@brief Decode a password protected keystore record into a wallet account
+
+Function: BoatKeystoreRecordDecode()
+
+    This function decrypts a keystore record encoded by
+    BoatKeystoreRecordEncode() and checks its hash and private key. Records
+    with and without KDF header are both accepted.
+
+    On success the node URL pointer field of <wallet_info_ptr> is set to a
+    newly allocated string, which the caller MUST free with BoatFree(). Any
+    previous value is overwritten without being freed. On failure
+    <wallet_info_ptr> is left untouched.
+
+@see
+    BoatKeystoreRecordEncode() BoatWalletLoadWalletEx()
+
+@return
+    This function returns BOAT_SUCCESS if the record is decoded.\n
+    Otherwise it returns BOAT_ERROR.
+
+@param[out] wallet_info_ptr
+    Pointer to the wallet account to decode into.
+
+@param[in] passwd_ptr
+    Password to decrypt the wallet info.
+
+@param[in] passwd_len
+    Length of <passwd_ptr> in byte.
+
+@param[in] record_ptr
+    The keystore record.
+
+@param[in] record_len
+    Length of <record_ptr> in byte.
+*******************************************************************************/
+BOAT_RESULT BoatKeystoreRecordDecode(BOAT_OUT BoatWalletInfo *wallet_info_ptr,
+                                     const UINT8 *passwd_ptr,
+                                     UINT32 passwd_len,
+                                     const UINT8 *record_ptr,
+                                     UINT32 record_len)
+{
+    UINT8 aes256key[32];
+    UINT8 iv[16];  // Exact value of Initial Vector is not care for IV-independent decryption
+
+    UINT8 *plain_wallet_info_array = NULL;
+    UINT32 plain_wallet_info_len_no_pad;
+    UINT32 plain_wallet_info_len_no_pad_big;
+    UINT32 plain_wallet_info_field_index;
+    UINT32 encrypted_total_len = 0;
+    UINT32 node_url_str_len;
+    UINT32 node_url_str_len_big;
+    UINT32 chain_id_big;
+    UINT8 wallet_info_hash_array[32];
+    BoatWalletInfo wallet_info;
+    BoatKeystoreKdf kdf;
+    const UINT8 *salt_ptr = NULL;
+    UINT32 value_big;
+
+    BOAT_RESULT result = BOAT_SUCCESS;
+    boat_try_declare;
+
+    if( wallet_info_ptr == NULL || passwd_ptr == NULL || passwd_len == 0 || record_ptr == NULL )
+    {
+        BoatLog(BOAT_LOG_NORMAL, "Arguments cannot be NULL.");
+        return BOAT_ERROR;
+    }
+
+    memset(iv, 0, sizeof(iv));
+
+    // Records without KDF header use keccak_256 of the password as the key
+    kdf.type = BOAT_KEYSTORE_KDF_KECCAK;
+    kdf.cost = 0;
+    kdf.r = 0;
+    kdf.p = 0;
+
+    if(    record_len >= BOAT_KEYSTORE_KDF_HEADER_SIZE + BOAT_KEYSTORE_RECORD_HEADER_SIZE
+        && memcmp(record_ptr, BOAT_KEYSTORE_KDF_MAGIC, 4) == 0
+        && record_ptr[4] == BOAT_KEYSTORE_KDF_VERSION )
+    {
+        kdf.type = (BoatKeystoreKdfType)record_ptr[5];
+        memcpy(&value_big, record_ptr + 8, sizeof(UINT32));
+        kdf.cost = Utilityntohl(value_big);
+        memcpy(&value_big, record_ptr + 12, sizeof(UINT32));
+        kdf.r = (UINT16)(Utilityntohl(value_big) >> 16);
+        kdf.p = (UINT16)Utilityntohl(value_big);
+        salt_ptr = record_ptr + 16;
+
+        if( kdf.type == BOAT_KEYSTORE_KDF_KECCAK || KeystoreCheckKdf(&kdf) != BOAT_SUCCESS )
+        {
+            BoatLog(BOAT_LOG_NORMAL, "Unsupported keystore KDF header.");
+            return BOAT_ERROR;
+        }
+
+        record_ptr += BOAT_KEYSTORE_KDF_HEADER_SIZE;
+        record_len -= BOAT_KEYSTORE_KDF_HEADER_SIZE;
+    }
+
+    // Read effective wallet info length in big endian
+    if( record_len < BOAT_KEYSTORE_RECORD_HEADER_SIZE )
+    {
+        BoatLog(BOAT_LOG_NORMAL, "Keystore record is truncated.");
+        return BOAT_ERROR;
+    }
+    memcpy(&plain_wallet_info_len_no_pad_big, record_ptr + 32, sizeof(UINT32));
+    plain_wallet_info_len_no_pad = Utilityntohl(plain_wallet_info_len_no_pad_big);
+
+    // Encrypted length (with padding) is round up to the nearest multiple of AES_BLOCK_SIZE
+    encrypted_total_len = ROUNDUP(plain_wallet_info_len_no_pad, AES_BLOCK_SIZE);
+
+    if(    plain_wallet_info_len_no_pad > BOAT_REASONABLE_MAX_LEN
+        || plain_wallet_info_len_no_pad < AES_BLOCK_SIZE + KEYSTORE_SIZE_EXCLUDE_URL
+        || record_len < BOAT_KEYSTORE_RECORD_HEADER_SIZE + encrypted_total_len )
+    {
+        BoatLog(BOAT_LOG_NORMAL, "Keystore record is truncated.");
+        return BOAT_ERROR;
+    }
+
+    plain_wallet_info_array = BoatMalloc(encrypted_total_len);
+    if( plain_wallet_info_array == NULL )
+    {
+        BoatLog(BOAT_LOG_NORMAL, "Fail to allocate memory.");
+        boat_throw(BOAT_ERROR, BoatKeystoreRecordDecode_cleanup);
+    }
+
+    // Derive the AES key from the password
+    result = KeystoreDeriveKey(&kdf, salt_ptr, passwd_ptr, passwd_len, aes256key);
+    if( result != BOAT_SUCCESS )
+    {
+        boat_throw(BOAT_ERROR, BoatKeystoreRecordDecode_cleanup);
+    }
+
+    result = KeystoreAes256Cbc(BOAT_FALSE,
+                               aes256key,
+                               iv,
+                               record_ptr + BOAT_KEYSTORE_RECORD_HEADER_SIZE,
+                               plain_wallet_info_array,
+                               encrypted_total_len);
+    if( result != BOAT_SUCCESS )
+    {
+        boat_throw(BOAT_ERROR, BoatKeystoreRecordDecode_cleanup);
+    }
+
+    // Check decrypted plain wallet info's hash
+    // NOTE: IV-independent decryption: ingore firest AES block
+    keccak_256(plain_wallet_info_array + AES_BLOCK_SIZE, plain_wallet_info_len_no_pad - AES_BLOCK_SIZE, wallet_info_hash_array);
+    if( memcmp(wallet_info_hash_array, record_ptr, sizeof(wallet_info_hash_array)) != 0 )
+    {
+        BoatLog(BOAT_LOG_NORMAL, "Load wallet info fails: bad checksum.");
+        boat_throw(BOAT_ERROR, BoatKeystoreRecordDecode_cleanup);
+    }
+
+    // Ignore the beginning 16 bytes for IV-dependent decryption
+    plain_wallet_info_field_index = AES_BLOCK_SIZE;
+
+    result = BoatWalletCheckPrivkey(plain_wallet_info_array + plain_wallet_info_field_index);
+    if( result != BOAT_SUCCESS )
+    {
+        BoatLog(BOAT_LOG_NORMAL, "Load wallet info fails: invalid private key.");
+        boat_throw(BOAT_ERROR, BoatKeystoreRecordDecode_cleanup);
+    }
+
+    memcpy(&wallet_info.account_info.priv_key_array, plain_wallet_info_array + plain_wallet_info_field_index, sizeof(wallet_info.account_info.priv_key_array));
+    plain_wallet_info_field_index += sizeof(wallet_info.account_info.priv_key_array);
+
+    memcpy(&wallet_info.account_info.pub_key_array, plain_wallet_info_array + plain_wallet_info_field_index, sizeof(wallet_info.account_info.pub_key_array));
+    plain_wallet_info_field_index += sizeof(wallet_info.account_info.pub_key_array);
+
+    memcpy(&wallet_info.account_info.address, plain_wallet_info_array + plain_wallet_info_field_index, sizeof(wallet_info.account_info.address));
+    plain_wallet_info_field_index += sizeof(wallet_info.account_info.address);
+
+    memcpy(&chain_id_big, plain_wallet_info_array + plain_wallet_info_field_index, sizeof(UINT32));
+    wallet_info.network_info.chain_id = Utilityntohl(chain_id_big);
+    plain_wallet_info_field_index += sizeof(UINT32);
+
+    memcpy(&wallet_info.network_info.eip155_compatibility, plain_wallet_info_array + plain_wallet_info_field_index, sizeof(wallet_info.network_info.eip155_compatibility));
+    plain_wallet_info_field_index += sizeof(wallet_info.network_info.eip155_compatibility);
+
+    memcpy(&node_url_str_len_big, plain_wallet_info_array + plain_wallet_info_field_index, sizeof(UINT32));
+    plain_wallet_info_field_index += sizeof(UINT32);
+
+    node_url_str_len = Utilityntohl(node_url_str_len_big);
+
+    if( node_url_str_len != plain_wallet_info_len_no_pad - plain_wallet_info_field_index )
+    {
+        BoatLog(BOAT_LOG_NORMAL, "Incorrect node url length");
+        boat_throw(BOAT_ERROR, BoatKeystoreRecordDecode_cleanup);
+    }
+
+    // +1 for NULL Terminator
+    wallet_info.network_info.node_url_ptr = BoatMalloc(node_url_str_len + 1);
+    if( wallet_info.network_info.node_url_ptr == NULL )
+    {
+        BoatLog(BOAT_LOG_NORMAL, "Fail to allocate memory.");
+        boat_throw(BOAT_ERROR, BoatKeystoreRecordDecode_cleanup);
+    }
+
+    memcpy(wallet_info.network_info.node_url_ptr, plain_wallet_info_array + plain_wallet_info_field_index, node_url_str_len);
+
+    // Add a NULL teriminator
+    wallet_info.network_info.node_url_ptr[node_url_str_len] = '\0';
+
+    *wallet_info_ptr = wallet_info;
+
+    boat_catch(BoatKeystoreRecordDecode_cleanup)
+    {
+        result = boat_exception;
+    }
+
+    // Destroy sensitive information
+    memset(aes256key, 0, sizeof(aes256key));
+    memset(&wallet_info.account_info, 0, sizeof(wallet_info.account_info));
+    memset(wallet_info_hash_array, 0, sizeof(wallet_info_hash_array));
+
+    if( plain_wallet_info_array != NULL )
+    {
+        memset(plain_wallet_info_array, 0, encrypted_total_len);
+        BoatFree(plain_wallet_info_array);
+    }
+
+    return result;
+}
+
+
+/******************************************************************************
+                          KEYSTORE CONTAINER
+
+    A keystore container file is in following format:
+
+    -------------------------------------------------------------
+    | Header | L | R | L | R | ... | Index | L | R | ... | Index |
+    -------------------------------------------------------------
+
+    Header: 16 bytes
+        4 bytes magic BOAT_KEYSTORE_CONTAINER_MAGIC
+        4 bytes version, in BigEndian
+        4 bytes file offset of the current index, in BigEndian
+        4 bytes number of entries in the current index, in BigEndian
+    L:  4 bytes length of R, in BigEndian
+    R:  A keystore record, see BoatKeystoreRecordEncode()
+    Index: One 24-byte entry per account:
+        20 bytes address
+        4 bytes file offset of L of the account's record, in BigEndian
+
+    Records are only ever appended. BoatKeystoreContainerFlush() writes a new
+    index after the last record and then updates the header to point to it,
+    so a crash before the header is updated leaves the previous index valid.
+    Replaced and removed records as well as superseded indexes remain in the
+    file as garbage until BoatKeystoreContainerCompact() is called.
+******************************************************************************/
+
+/*!*****************************************************************************
+@brief Find the index entry of an address
+
+Function: KeystoreContainerFind()
+
+@return
+    This function returns the index of the entry in <entry_array>.\n
+    If the address is not in the container, it returns -1.
+
+@param[in] container_ptr
+    The keystore container.
+
+@param[in] address
+    Address to find.
+*******************************************************************************/
+static SINT32 KeystoreContainerFind(const BoatKeystoreContainer *container_ptr, const BoatAddress address)
+{
+    UINT32 slot;
+    UINT32 entry_index;
+
+    if( container_ptr->hash_table_size == 0 )
+    {
+        return -1;
+    }
+
+    slot = BOAT_KEYSTORE_HASH_SLOT(address, container_ptr->hash_table_size);
+
+    while( (entry_index = container_ptr->hash_table[slot]) != 0 )
+    {
+        if( memcmp(container_ptr->entry_array[entry_index - 1].address, address, sizeof(BoatAddress)) == 0 )
+        {
+            return (SINT32)(entry_index - 1);
+        }
+        slot = (slot + 1) & (container_ptr->hash_table_size - 1);
+    }
+
+    return -1;
+}
+
+
+/*!*****************************************************************************
+@brief Add an index entry
+
+Function: KeystoreContainerAddEntry()
+
+    This function adds an entry for an address not yet in the container,
+    growing the entry array and the hash table as needed. The hash table is
+    kept at most half full.
+
+@return
+    This function returns BOAT_SUCCESS if the entry is added.\n
+    Otherwise it returns BOAT_ERROR.
+
+@param[in] container_ptr
+    The keystore container.
+
+@param[in] address
+    Address of the entry.
+
+@param[in] record_offset
+    File offset of the record.
+*******************************************************************************/
+static BOAT_RESULT KeystoreContainerAddEntry(BoatKeystoreContainer *container_ptr, const BoatAddress address, UINT32 record_offset)
+{
+    BoatKeystoreIndexEntry *entry_array;
+    UINT32 *hash_table;
+    UINT32 hash_table_size;
+    UINT32 capacity;
+    UINT32 slot;
+    UINT32 i;
+
+    if( container_ptr->entry_num == container_ptr->entry_capacity )
+    {
+        capacity = container_ptr->entry_capacity == 0 ? 64 : container_ptr->entry_capacity * 2;
+        entry_array = BoatMalloc(capacity * sizeof(BoatKeystoreIndexEntry));
+        if( entry_array == NULL )
+        {
+            BoatLog(BOAT_LOG_NORMAL, "Fail to allocate memory.");
+            return BOAT_ERROR;
+        }
+
+        if( container_ptr->entry_array != NULL )
+        {
+            memcpy(entry_array, container_ptr->entry_array, container_ptr->entry_num * sizeof(BoatKeystoreIndexEntry));
+            BoatFree(container_ptr->entry_array);
+        }
+        container_ptr->entry_array = entry_array;
+        container_ptr->entry_capacity = capacity;
+    }
+
+    if( (container_ptr->entry_num + 1) * 2 > container_ptr->hash_table_size )
+    {
+        hash_table_size = container_ptr->hash_table_size == 0 ? 128 : container_ptr->hash_table_size * 2;
+        hash_table = BoatMalloc(hash_table_size * sizeof(UINT32));
+        if( hash_table == NULL )
+        {
+            BoatLog(BOAT_LOG_NORMAL, "Fail to allocate memory.");
+            return BOAT_ERROR;
+        }
+        memset(hash_table, 0, hash_table_size * sizeof(UINT32));
+
+        for( i = 0; i < container_ptr->entry_num; i++ )
+        {
+            slot = BOAT_KEYSTORE_HASH_SLOT(container_ptr->entry_array[i].address, hash_table_size);
+            while( hash_table[slot] != 0 )
+            {
+                slot = (slot + 1) & (hash_table_size - 1);
+            }
+            hash_table[slot] = i + 1;
+        }
+
+        if( container_ptr->hash_table != NULL )
+        {
+            BoatFree(container_ptr->hash_table);
+        }
+        container_ptr->hash_table = hash_table;
+        container_ptr->hash_table_size = hash_table_size;
+    }
+
+    i = container_ptr->entry_num++;
+    memcpy(container_ptr->entry_array[i].address, address, sizeof(BoatAddress));
+    container_ptr->entry_array[i].record_offset = record_offset;
+
+    slot = BOAT_KEYSTORE_HASH_SLOT(address, container_ptr->hash_table_size);
+    while( container_ptr->hash_table[slot] != 0 )
+    {
+        slot = (slot + 1) & (container_ptr->hash_table_size - 1);
+    }
+    container_ptr->hash_table[slot] = i + 1;
+
+    container_ptr->live_num++;
+
+    return BOAT_SUCCESS;
+}
+
+
+// Free all memory of the container and close the file, without writing the index
+static void KeystoreContainerRelease(BoatKeystoreContainer *container_ptr)
+{
+    if( container_ptr->file_ptr != NULL )
+    {
+        fclose(container_ptr->file_ptr);
+    }
+
+    if( container_ptr->file_path_str != NULL )
+    {
+        BoatFree(container_ptr->file_path_str);
+    }
+
+    if( container_ptr->entry_array != NULL )
+    {
+        BoatFree(container_ptr->entry_array);
+    }
+
+    if( container_ptr->hash_table != NULL )
+    {
+        BoatFree(container_ptr->hash_table);
+    }
+
+    memset(container_ptr, 0, sizeof(BoatKeystoreContainer));
+}
+
+
+// Write the index of live entries at <data_end> of <file_ptr> and point the header to it
+static BOAT_RESULT KeystoreContainerWriteIndex(const BoatKeystoreContainer *container_ptr, FILE *file_ptr, UINT32 data_end)
+{
+    UINT8 header[BOAT_KEYSTORE_CONTAINER_HEADER_SIZE];
+    UINT8 index_entry[BOAT_KEYSTORE_CONTAINER_INDEX_ENTRY_SIZE];
+    UINT32 value_big;
+    UINT32 i;
+
+    if( fseek(file_ptr, data_end, SEEK_SET) != 0 )
+    {
+        return BOAT_ERROR;
+    }
+
+    for( i = 0; i < container_ptr->entry_num; i++ )
+    {
+        if( container_ptr->entry_array[i].record_offset == 0 )
+        {
+            continue;
+        }
+
+        memcpy(index_entry, container_ptr->entry_array[i].address, sizeof(BoatAddress));
+        value_big = Utilityhtonl(container_ptr->entry_array[i].record_offset);
+        memcpy(index_entry + sizeof(BoatAddress), &value_big, sizeof(UINT32));
+
+        if( fwrite(index_entry, 1, sizeof(index_entry), file_ptr) != sizeof(index_entry) )
+        {
+            return BOAT_ERROR;
+        }
+    }
+
+    // Make sure the records and the index are on disk before the header points to it
+    if( fflush(file_ptr) != 0 || fsync(fileno(file_ptr)) != 0 )
+    {
+        return BOAT_ERROR;
+    }
+
+    memcpy(header, BOAT_KEYSTORE_CONTAINER_MAGIC, 4);
+    value_big = Utilityhtonl(BOAT_KEYSTORE_CONTAINER_VERSION);
+    memcpy(header + 4, &value_big, sizeof(UINT32));
+    value_big = Utilityhtonl(data_end);
+    memcpy(header + 8, &value_big, sizeof(UINT32));
+    value_big = Utilityhtonl(container_ptr->live_num);
+    memcpy(header + 12, &value_big, sizeof(UINT32));
+
+    if(    fseek(file_ptr, 0, SEEK_SET) != 0
+        || fwrite(header, 1, sizeof(header), file_ptr) != sizeof(header)
+        || fflush(file_ptr) != 0
+        || fsync(fileno(file_ptr)) != 0 )
+    {
+        return BOAT_ERROR;
+    }
+
+    return BOAT_SUCCESS;
+}
+
+
+/*!*****************************************************************************
+@brief Open a keystore container
+
+Function: BoatKeystoreContainerOpen()
+
+    This function opens a keystore container file and loads its address index
+    into a hash table. No record is read or decrypted.
+
+    If <create> is BOAT_TRUE, an empty container is created, replacing any
+    existing file.
+
+    BoatKeystoreContainerClose() MUST be called after use of the container.
+
+@see
+    BoatKeystoreContainerClose() BoatKeystoreContainerLoad() BoatKeystoreContainerAppend()
+
+@return
+    This function returns BOAT_SUCCESS if the container is opened.\n
+    Otherwise it returns BOAT_ERROR.
+
+@param[out] container_ptr
+    The keystore container to initialize.
+
+@param[in] file_path_str
+    Container file's path.
+
+@param[in] create
+    BOAT_TRUE to create a new container, BOAT_FALSE to open an existing one.
+*******************************************************************************/
+BOAT_RESULT BoatKeystoreContainerOpen(BOAT_OUT BoatKeystoreContainer *container_ptr, const CHAR *file_path_str, BOATBOOL create)
+{
+    UINT8 header[BOAT_KEYSTORE_CONTAINER_HEADER_SIZE];
+    UINT8 *index_array = NULL;
+    UINT32 index_offset;
+    UINT32 index_num;
+    UINT32 value_big;
+    UINT32 i;
+    struct stat file_stat;
+
+    BOAT_RESULT result = BOAT_SUCCESS;
+    boat_try_declare;
+
+    if( container_ptr == NULL || file_path_str == NULL )
+    {
+        BoatLog(BOAT_LOG_NORMAL, "Arguments cannot be NULL.");
+        return BOAT_ERROR;
+    }
+
+    memset(container_ptr, 0, sizeof(BoatKeystoreContainer));
+
+    // +1 for NULL Terminator
+    container_ptr->file_path_str = BoatMalloc(strlen(file_path_str) + 1);
+    if( container_ptr->file_path_str == NULL )
+    {
+        BoatLog(BOAT_LOG_NORMAL, "Fail to allocate memory.");
+        boat_throw(BOAT_ERROR, BoatKeystoreContainerOpen_cleanup);
+    }
+    strcpy(container_ptr->file_path_str, file_path_str);
+
+    container_ptr->file_ptr = fopen(file_path_str, create ? "w+b" : "r+b");
+    if( container_ptr->file_ptr == NULL )
+    {
+        BoatLog(BOAT_LOG_NORMAL, "Unable to open keystore container: %s.", file_path_str);
+        boat_throw(BOAT_ERROR, BoatKeystoreContainerOpen_cleanup);
+    }
+
+    if( create )
+    {
+        container_ptr->data_end = BOAT_KEYSTORE_CONTAINER_HEADER_SIZE;
+        if( KeystoreContainerWriteIndex(container_ptr, container_ptr->file_ptr, container_ptr->data_end) != BOAT_SUCCESS )
+        {
+            BoatLog(BOAT_LOG_NORMAL, "Fail to write to keystore container.");
+            boat_throw(BOAT_ERROR, BoatKeystoreContainerOpen_cleanup);
+        }
+        boat_throw(BOAT_SUCCESS, BoatKeystoreContainerOpen_cleanup);
+    }
+
+    if( fread(header, 1, sizeof(header), container_ptr->file_ptr) != sizeof(header)
+        || memcmp(header, BOAT_KEYSTORE_CONTAINER_MAGIC, 4) != 0 )
+    {
+        BoatLog(BOAT_LOG_NORMAL, "Not a keystore container: %s.", file_path_str);
+        boat_throw(BOAT_ERROR, BoatKeystoreContainerOpen_cleanup);
+    }
+
+    memcpy(&value_big, header + 4, sizeof(UINT32));
+    if( Utilityntohl(value_big) != BOAT_KEYSTORE_CONTAINER_VERSION )
+    {
+        BoatLog(BOAT_LOG_NORMAL, "Unsupported keystore container version: %u.", Utilityntohl(value_big));
+        boat_throw(BOAT_ERROR, BoatKeystoreContainerOpen_cleanup);
+    }
+
+    memcpy(&value_big, header + 8, sizeof(UINT32));
+    index_offset = Utilityntohl(value_big);
+    memcpy(&value_big, header + 12, sizeof(UINT32));
+    index_num = Utilityntohl(value_big);
+
+    // The header is untrusted, the index must lie between the header and the end of file
+    if( fstat(fileno(container_ptr->file_ptr), &file_stat) != 0 )
+    {
+        BoatLog(BOAT_LOG_NORMAL, "Fail to stat keystore container: %s.", file_path_str);
+        boat_throw(BOAT_ERROR, BoatKeystoreContainerOpen_cleanup);
+    }
+
+    if(    index_offset < BOAT_KEYSTORE_CONTAINER_HEADER_SIZE
+        || (UINT64)index_offset > (UINT64)file_stat.st_size
+        || index_num > ((UINT64)file_stat.st_size - index_offset) / BOAT_KEYSTORE_CONTAINER_INDEX_ENTRY_SIZE
+        || (UINT64)index_offset + (UINT64)index_num * BOAT_KEYSTORE_CONTAINER_INDEX_ENTRY_SIZE > 0xFFFFFFFFu )
+    {
+        BoatLog(BOAT_LOG_NORMAL, "Corrupted keystore container index: %s.", file_path_str);
+        boat_throw(BOAT_ERROR, BoatKeystoreContainerOpen_cleanup);
+    }
+
+    // Read the whole index at once
+    if( index_num > 0 )
+    {
+        index_array = BoatMalloc(index_num * BOAT_KEYSTORE_CONTAINER_INDEX_ENTRY_SIZE);
+        if( index_array == NULL )
+        {
+            BoatLog(BOAT_LOG_NORMAL, "Fail to allocate memory.");
+            boat_throw(BOAT_ERROR, BoatKeystoreContainerOpen_cleanup);
+        }
+
+        if(    fseek(container_ptr->file_ptr, index_offset, SEEK_SET) != 0
+            || fread(index_array, BOAT_KEYSTORE_CONTAINER_INDEX_ENTRY_SIZE, index_num, container_ptr->file_ptr) != index_num )
+        {
+            BoatLog(BOAT_LOG_NORMAL, "Fail to read keystore container index.");
+            boat_throw(BOAT_ERROR, BoatKeystoreContainerOpen_cleanup);
+        }
+    }
+
+    for( i = 0; i < index_num; i++ )
+    {
+        memcpy(&value_big, index_array + i * BOAT_KEYSTORE_CONTAINER_INDEX_ENTRY_SIZE + sizeof(BoatAddress), sizeof(UINT32));
+        if( KeystoreContainerAddEntry(container_ptr,
+                                      index_array + i * BOAT_KEYSTORE_CONTAINER_INDEX_ENTRY_SIZE,
+                                      Utilityntohl(value_big)) != BOAT_SUCCESS )
+        {
+            boat_throw(BOAT_ERROR, BoatKeystoreContainerOpen_cleanup);
+        }
+    }
+
+    // Append after the current index so that it stays valid until the next flush
+    container_ptr->data_end = index_offset + index_num * BOAT_KEYSTORE_CONTAINER_INDEX_ENTRY_SIZE;
+
+    boat_catch(BoatKeystoreContainerOpen_cleanup)
+    {
+        result = boat_exception;
+        KeystoreContainerRelease(container_ptr);
+    }
+
+    if( index_array != NULL )
+    {
+        BoatFree(index_array);
+    }
+
+    return result;
+}
+
+
+/*!*****************************************************************************
+@brief Write the index of a keystore container to file
+
+Function: BoatKeystoreContainerFlush()
+
+    This function writes the current address index after the last record and
+    updates the file header to point to it. Records appended before a
+    successful flush survive a crash; records appended after it don't.
+
+@return
+    This function returns BOAT_SUCCESS if the index is written.\n
+    Otherwise it returns BOAT_ERROR.
+
+@param[in] container_ptr
+    The keystore container.
+*******************************************************************************/
+BOAT_RESULT BoatKeystoreContainerFlush(BoatKeystoreContainer *container_ptr)
+{
+    if( container_ptr == NULL || container_ptr->file_ptr == NULL )
+    {
+        BoatLog(BOAT_LOG_NORMAL, "Keystore container is not open.");
+        return BOAT_ERROR;
+    }
+
+    if( container_ptr->dirty != BOAT_TRUE )
+    {
+        return BOAT_SUCCESS;
+    }
+
+    if( KeystoreContainerWriteIndex(container_ptr, container_ptr->file_ptr, container_ptr->data_end) != BOAT_SUCCESS )
+    {
+        BoatLog(BOAT_LOG_NORMAL, "Fail to write to keystore container.");
+        return BOAT_ERROR;
+    }
+
+    container_ptr->data_end += container_ptr->live_num * BOAT_KEYSTORE_CONTAINER_INDEX_ENTRY_SIZE;
+    container_ptr->dirty = BOAT_FALSE;
+
+    return BOAT_SUCCESS;
+}
+
+
+/*!*****************************************************************************
+@brief Close a keystore container
+
+Function: BoatKeystoreContainerClose()
+
+    This function flushes the index if it's changed, closes the file and frees
+    all memory of the container.
+
+@return
+    This function returns BOAT_SUCCESS if the index is flushed.\n
+    Otherwise it returns BOAT_ERROR. The container is closed in either case.
+
+@param[in] container_ptr
+    The keystore container.
+*******************************************************************************/
+BOAT_RESULT BoatKeystoreContainerClose(BoatKeystoreContainer *container_ptr)
+{
+    BOAT_RESULT result;
+
+    if( container_ptr == NULL )
+    {
+        return BOAT_ERROR;
+    }
+
+    result = BoatKeystoreContainerFlush(container_ptr);
+    KeystoreContainerRelease(container_ptr);
+
+    return result;
+}
+
+
+/*!*****************************************************************************
+@brief Append a wallet account to a keystore container
+
+Function: BoatKeystoreContainerAppend()
+
+    This function encrypts the wallet account into a keystore record and
+    appends it to the container. If the address is already in the container,
+    its entry is pointed to the new record and the old record becomes garbage.
+
+    The index in file is not updated until BoatKeystoreContainerFlush() or
+    BoatKeystoreContainerClose() is called, so appending many accounts costs
+    one index write.
+
+@return
+    This function returns BOAT_SUCCESS if the account is appended.\n
+    Otherwise it returns BOAT_ERROR.
+
+@param[in] container_ptr
+    The keystore container.
+
+@param[in] wallet_info_ptr
+    Pointer to the wallet account to append.
+
+@param[in] passwd_ptr
+    Password to encrypt the wallet info.
+
+@param[in] passwd_len
+    Length of <passwd_ptr> in byte.
+*******************************************************************************/
+BOAT_RESULT BoatKeystoreContainerAppend(BoatKeystoreContainer *container_ptr,
+                                        const BoatWalletInfo *wallet_info_ptr,
+                                        const UINT8 *passwd_ptr,
+                                        UINT32 passwd_len)
+{
+    UINT8 *record_ptr = NULL;
+    UINT32 record_size;
+    UINT32 record_len = 0;
+    UINT32 record_len_big;
+    SINT32 entry_index;
+
+    BOAT_RESULT result = BOAT_SUCCESS;
+    boat_try_declare;
+
+    if( container_ptr == NULL || container_ptr->file_ptr == NULL || wallet_info_ptr == NULL )
+    {
+        BoatLog(BOAT_LOG_NORMAL, "Arguments cannot be NULL.");
+        return BOAT_ERROR;
+    }
+
+    record_size = BoatKeystoreRecordSize(wallet_info_ptr);
+    if( record_size == 0 )
+    {
+        BoatLog(BOAT_LOG_NORMAL, "Node URL cannot be NULL.");
+        return BOAT_ERROR;
+    }
+
+    record_ptr = BoatMalloc(record_size);
+    if( record_ptr == NULL )
+    {
+        BoatLog(BOAT_LOG_NORMAL, "Fail to allocate memory.");
+        boat_throw(BOAT_ERROR, BoatKeystoreContainerAppend_cleanup);
+    }
+
+    result = BoatKeystoreRecordEncode(wallet_info_ptr, passwd_ptr, passwd_len, record_ptr, record_size, &record_len);
+    if( result != BOAT_SUCCESS )
+    {
+        boat_throw(BOAT_ERROR, BoatKeystoreContainerAppend_cleanup);
+    }
+
+    record_len_big = Utilityhtonl(record_len);
+    if(    fseek(container_ptr->file_ptr, container_ptr->data_end, SEEK_SET) != 0
+        || fwrite(&record_len_big, 1, sizeof(UINT32), container_ptr->file_ptr) != sizeof(UINT32)
+        || fwrite(record_ptr, 1, record_len, container_ptr->file_ptr) != record_len )
+    {
+        BoatLog(BOAT_LOG_NORMAL, "Fail to write to keystore container.");
+        boat_throw(BOAT_ERROR, BoatKeystoreContainerAppend_cleanup);
+    }
+
+    entry_index = KeystoreContainerFind(container_ptr, wallet_info_ptr->account_info.address);
+    if( entry_index >= 0 )
+    {
+        if( container_ptr->entry_array[entry_index].record_offset == 0 )
+        {
+            container_ptr->live_num++;
+        }
+        container_ptr->entry_array[entry_index].record_offset = container_ptr->data_end;
+    }
+    else
+    {
+        result = KeystoreContainerAddEntry(container_ptr, wallet_info_ptr->account_info.address, container_ptr->data_end);
+        if( result != BOAT_SUCCESS )
+        {
+            boat_throw(BOAT_ERROR, BoatKeystoreContainerAppend_cleanup);
+        }
+    }
+
+    container_ptr->data_end += sizeof(UINT32) + record_len;
+    container_ptr->dirty = BOAT_TRUE;
+
+    boat_catch(BoatKeystoreContainerAppend_cleanup)
+    {
+        result = boat_exception;
+    }
+
+    if( record_ptr != NULL )
+    {
+        BoatFree(record_ptr);
+    }
+
+    return result;
+}
+
+
+/*!*****************************************************************************
+@brief Load a wallet account from a keystore container
+
+Function: BoatKeystoreContainerLoad()
+
+    This function looks up the address in the index hash table and reads and
+    decrypts only the record of that account.
+
+    On success the node URL pointer field of <wallet_info_ptr> is set to a
+    newly allocated string, which the caller MUST free with BoatFree().
+
+@see
+    BoatKeystoreRecordDecode()
+
+@return
+    This function returns BOAT_SUCCESS if the account is loaded.\n
+    Otherwise it returns BOAT_ERROR.
+
+@param[in] container_ptr
+    The keystore container.
+
+@param[in] address
+    Address of the account to load.
+
+@param[in] passwd_ptr
+    Password to decrypt the wallet info.
+
+@param[in] passwd_len
+    Length of <passwd_ptr> in byte.
+
+@param[out] wallet_info_ptr
+    Pointer to the wallet account to load into.
+*******************************************************************************/
+BOAT_RESULT BoatKeystoreContainerLoad(BoatKeystoreContainer *container_ptr,
+                                      const BoatAddress address,
+                                      const UINT8 *passwd_ptr,
+                                      UINT32 passwd_len,
+                                      BOAT_OUT BoatWalletInfo *wallet_info_ptr)
+{
+    UINT8 *record_ptr = NULL;
+    UINT32 record_len = 0;
+    UINT32 record_len_big;
+    SINT32 entry_index;
+
+    BOAT_RESULT result = BOAT_SUCCESS;
+    boat_try_declare;
+
+    if( container_ptr == NULL || container_ptr->file_ptr == NULL || address == NULL )
+    {
+        BoatLog(BOAT_LOG_NORMAL, "Arguments cannot be NULL.");
+        return BOAT_ERROR;
+    }
+
+    entry_index = KeystoreContainerFind(container_ptr, address);
+    if( entry_index < 0 || container_ptr->entry_array[entry_index].record_offset == 0 )
+    {
+        BoatLog(BOAT_LOG_VERBOSE, "Account is not in keystore container.");
+        return BOAT_ERROR;
+    }
+
+    if(    fseek(container_ptr->file_ptr, container_ptr->entry_array[entry_index].record_offset, SEEK_SET) != 0
+        || fread(&record_len_big, 1, sizeof(UINT32), container_ptr->file_ptr) != sizeof(UINT32) )
+    {
+        BoatLog(BOAT_LOG_NORMAL, "Fail to read from keystore container.");
+        return BOAT_ERROR;
+    }
+
+    record_len = Utilityntohl(record_len_big);
+    if( record_len > BOAT_KEYSTORE_RECORD_MAX_SIZE )
+    {
+        BoatLog(BOAT_LOG_NORMAL, "Fail to read from keystore container.");
+        return BOAT_ERROR;
+    }
+
+    record_ptr = BoatMalloc(record_len);
+    if( record_ptr == NULL )
+    {
+        BoatLog(BOAT_LOG_NORMAL, "Fail to allocate memory.");
+        boat_throw(BOAT_ERROR, BoatKeystoreContainerLoad_cleanup);
+    }
+
+    if( fread(record_ptr, 1, record_len, container_ptr->file_ptr) != record_len )
+    {
+        BoatLog(BOAT_LOG_NORMAL, "Fail to read from keystore container.");
+        boat_throw(BOAT_ERROR, BoatKeystoreContainerLoad_cleanup);
+    }
+
+    result = BoatKeystoreRecordDecode(wallet_info_ptr, passwd_ptr, passwd_len, record_ptr, record_len);
+    if( result != BOAT_SUCCESS )
+    {
+        boat_throw(BOAT_ERROR, BoatKeystoreContainerLoad_cleanup);
+    }
+
+    if( memcmp(wallet_info_ptr->account_info.address, address, sizeof(BoatAddress)) != 0 )
+    {
+        BoatLog(BOAT_LOG_NORMAL, "Keystore container index doesn't match record.");
+        memset(&wallet_info_ptr->account_info, 0, sizeof(wallet_info_ptr->account_info));
+        BoatFree(wallet_info_ptr->network_info.node_url_ptr);
+        wallet_info_ptr->network_info.node_url_ptr = NULL;
+        boat_throw(BOAT_ERROR, BoatKeystoreContainerLoad_cleanup);
+    }
+
+    boat_catch(BoatKeystoreContainerLoad_cleanup)
+    {
+        result = boat_exception;
+    }
+
+    if( record_ptr != NULL )
+    {
+        BoatFree(record_ptr);
+    }
+
+    return result;
+}
+
+
+/*!*****************************************************************************
+@brief Remove a wallet account from a keystore container
+
+Function: BoatKeystoreContainerRemove()
+
+    This function removes the address from the index. The record remains in
+    file as garbage until BoatKeystoreContainerCompact() is called.
+
+@return
+    This function returns BOAT_SUCCESS if the account is removed.\n
+    Otherwise it returns BOAT_ERROR.
+
+@param[in] container_ptr
+    The keystore container.
+
+@param[in] address
+    Address of the account to remove.
+*******************************************************************************/
+BOAT_RESULT BoatKeystoreContainerRemove(BoatKeystoreContainer *container_ptr, const BoatAddress address)
+{
+    SINT32 entry_index;
+
+    if( container_ptr == NULL || address == NULL )
+    {
+        BoatLog(BOAT_LOG_NORMAL, "Arguments cannot be NULL.");
+        return BOAT_ERROR;
+    }
+
+    entry_index = KeystoreContainerFind(container_ptr, address);
+    if( entry_index < 0 || container_ptr->entry_array[entry_index].record_offset == 0 )
+    {
+        BoatLog(BOAT_LOG_NORMAL, "Account is not in keystore container.");
+        return BOAT_ERROR;
+    }
+
+    // Keep the entry in the hash table so that probing isn't broken
+    container_ptr->entry_array[entry_index].record_offset = 0;
+    container_ptr->live_num--;
+    container_ptr->dirty = BOAT_TRUE;
+
+    return BOAT_SUCCESS;
+}
+
+
+/*!*****************************************************************************
+@brief Compact a keystore container
+
+Function: BoatKeystoreContainerCompact()
+
+    This function copies the live records and a fresh index into a new file
+    and replaces the container file with it, dropping replaced and removed
+    records as well as superseded indexes. Records are copied as they are,
+    so no password is needed.
+
+@return
+    This function returns BOAT_SUCCESS if the container is compacted.\n
+    Otherwise it returns BOAT_ERROR, and the container is left as it was,
+    unless only the rename fails to be synced. Then the container is
+    compacted but a crash may bring back the old file.
+
+@param[in] container_ptr
+    The keystore container.
+*******************************************************************************/
+BOAT_RESULT BoatKeystoreContainerCompact(BoatKeystoreContainer *container_ptr)
+{
+    FILE *compact_file_ptr = NULL;
+    CHAR *compact_path_str = NULL;
+    UINT32 *new_offset_array = NULL;
+    UINT8 *record_ptr = NULL;
+    UINT32 record_len;
+    UINT32 record_len_big;
+    UINT32 data_end;
+    UINT32 i;
+
+    BOAT_RESULT result = BOAT_SUCCESS;
+    boat_try_declare;
+
+    if( container_ptr == NULL || container_ptr->file_ptr == NULL )
+    {
+        BoatLog(BOAT_LOG_NORMAL, "Keystore container is not open.");
+        return BOAT_ERROR;
+    }
+
+    // +5 for ".tmp" and NULL Terminator
+    compact_path_str = BoatMalloc(strlen(container_ptr->file_path_str) + 5);
+    new_offset_array = BoatMalloc((container_ptr->entry_num + 1) * sizeof(UINT32));
+    record_ptr = BoatMalloc(BOAT_KEYSTORE_RECORD_MAX_SIZE);
+    if( compact_path_str == NULL || new_offset_array == NULL || record_ptr == NULL )
+    {
+        BoatLog(BOAT_LOG_NORMAL, "Fail to allocate memory.");
+        boat_throw(BOAT_ERROR, BoatKeystoreContainerCompact_cleanup);
+    }
+
+    strcpy(compact_path_str, container_ptr->file_path_str);
+    strcat(compact_path_str, ".tmp");
+
+    compact_file_ptr = fopen(compact_path_str, "w+b");
+    if( compact_file_ptr == NULL )
+    {
+        BoatLog(BOAT_LOG_NORMAL, "Unable to create file: %s.", compact_path_str);
+        boat_throw(BOAT_ERROR, BoatKeystoreContainerCompact_cleanup);
+    }
+
+    // Copy live records right after the header
+    data_end = BOAT_KEYSTORE_CONTAINER_HEADER_SIZE;
+    if( fseek(compact_file_ptr, data_end, SEEK_SET) != 0 )
+    {
+        boat_throw(BOAT_ERROR, BoatKeystoreContainerCompact_cleanup);
+    }
+
+    for( i = 0; i < container_ptr->entry_num; i++ )
+    {
+        new_offset_array[i] = 0;
+        if( container_ptr->entry_array[i].record_offset == 0 )
+        {
+            continue;
+        }
+
+        if(    fseek(container_ptr->file_ptr, container_ptr->entry_array[i].record_offset, SEEK_SET) != 0
+            || fread(&record_len_big, 1, sizeof(UINT32), container_ptr->file_ptr) != sizeof(UINT32) )
+        {
+            BoatLog(BOAT_LOG_NORMAL, "Fail to read from keystore container.");
+            boat_throw(BOAT_ERROR, BoatKeystoreContainerCompact_cleanup);
+        }
+
+        record_len = Utilityntohl(record_len_big);
+        if(    record_len > BOAT_KEYSTORE_RECORD_MAX_SIZE
+            || fread(record_ptr, 1, record_len, container_ptr->file_ptr) != record_len )
+        {
+            BoatLog(BOAT_LOG_NORMAL, "Fail to read from keystore container.");
+            boat_throw(BOAT_ERROR, BoatKeystoreContainerCompact_cleanup);
+        }
+
+        if(    fwrite(&record_len_big, 1, sizeof(UINT32), compact_file_ptr) != sizeof(UINT32)
+            || fwrite(record_ptr, 1, record_len, compact_file_ptr) != record_len )
+        {
+            BoatLog(BOAT_LOG_NORMAL, "Fail to write to file: %s.", compact_path_str);
+            boat_throw(BOAT_ERROR, BoatKeystoreContainerCompact_cleanup);
+        }
+
+        new_offset_array[i] = data_end;
+        data_end += sizeof(UINT32) + record_len;
+    }
+
+    // Swap in new offsets to write the new index, and swap back on failure
+    for( i = 0; i < container_ptr->entry_num; i++ )
+    {
+        record_len = container_ptr->entry_array[i].record_offset;
+        container_ptr->entry_array[i].record_offset = new_offset_array[i];
+        new_offset_array[i] = record_len;
+    }
+
+    if(    KeystoreContainerWriteIndex(container_ptr, compact_file_ptr, data_end) != BOAT_SUCCESS
+        || rename(compact_path_str, container_ptr->file_path_str) != 0 )
+    {
+        BoatLog(BOAT_LOG_NORMAL, "Fail to write to file: %s.", compact_path_str);
+        for( i = 0; i < container_ptr->entry_num; i++ )
+        {
+            container_ptr->entry_array[i].record_offset = new_offset_array[i];
+        }
+        boat_throw(BOAT_ERROR, BoatKeystoreContainerCompact_cleanup);
+    }
+
+    // The compacted file is now the container
+    fclose(container_ptr->file_ptr);
+    container_ptr->file_ptr = compact_file_ptr;
+    compact_file_ptr = NULL;
+    container_ptr->data_end = data_end + container_ptr->live_num * BOAT_KEYSTORE_CONTAINER_INDEX_ENTRY_SIZE;
+    container_ptr->dirty = BOAT_FALSE;
+
+    if( UtilitySyncDir(container_ptr->file_path_str) != BOAT_SUCCESS )
+    {
+        BoatLog(BOAT_LOG_NORMAL, "Fail to sync the directory of: %s.", container_ptr->file_path_str);
+        boat_throw(BOAT_ERROR, BoatKeystoreContainerCompact_cleanup);
+    }
+
+    boat_catch(BoatKeystoreContainerCompact_cleanup)
+    {
+        result = boat_exception;
+    }
+
+    if( compact_file_ptr != NULL )
+    {
+        fclose(compact_file_ptr);
+        remove(compact_path_str);
+    }
+
+    if( record_ptr != NULL )
+    {
+        BoatFree(record_ptr);
+    }
+
+    if( new_offset_array != NULL )
+    {
+        BoatFree(new_offset_array);
+    }
+
+    if( compact_path_str != NULL )
+    {
+        BoatFree(compact_path_str);
+    }
+
+    return result;
+}
@@ -0,0 +1,174 @@
+/******************************************************************************
+Copyright (C) 2018-2019 AITOS.IO
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+of the Software, and to permit persons to whom the Software is furnished to do
+so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+******************************************************************************/
+
+/*!@brief Keystore records and multi-account keystore container
+
+@file
+keystore.h is header file for keystore record encoding and the multi-account
+keystore container.
+*/
+
+#ifndef __KEYSTORE_H__
+#define __KEYSTORE_H__
+
+#include "wallet/boattypes.h"
+
+//! Size of the keystore record header, i.e. 32-byte IH plus 4-byte IL
+#define BOAT_KEYSTORE_RECORD_HEADER_SIZE 36
+
+//! Magic of the KDF header prefixed to records whose AES key is derived by a KDF
+#define BOAT_KEYSTORE_KDF_MAGIC "BKDF"
+
+//! Keystore record format version with KDF header. Records without KDF header are version 1.
+#define BOAT_KEYSTORE_KDF_VERSION 2
+
+//! Size of the KDF header
+#define BOAT_KEYSTORE_KDF_HEADER_SIZE 32
+
+//! Size of the salt in the KDF header
+#define BOAT_KEYSTORE_KDF_SALT_SIZE 16
+
+//! Maximum KDF cost accepted from a keystore record, to bound the work of loading a tampered record
+#define BOAT_KEYSTORE_KDF_COST_MAX (1u << 24)
+
+//! Maximum memory scrypt may use to load a keystore record, in byte
+#define BOAT_KEYSTORE_KDF_SCRYPT_MAX_MEM (256u * 1024u * 1024u)
+
+//! Maximum size of a keystore record
+#define BOAT_KEYSTORE_RECORD_MAX_SIZE (BOAT_KEYSTORE_KDF_HEADER_SIZE + BOAT_KEYSTORE_RECORD_HEADER_SIZE + BOAT_REASONABLE_MAX_LEN)
+
+//! Keystore container file header magic
+#define BOAT_KEYSTORE_CONTAINER_MAGIC "BKSC"
+
+//! Keystore container file format version
+#define BOAT_KEYSTORE_CONTAINER_VERSION 1
+
+//! Size of the keystore container file header
+#define BOAT_KEYSTORE_CONTAINER_HEADER_SIZE 16
+
+//! Size of one entry of the keystore container index in file
+#define BOAT_KEYSTORE_CONTAINER_INDEX_ENTRY_SIZE 24
+
+//! Hash table slot of an address in a hash table of <size> slots (power of 2).
+//! Addresses are hash values themselves, so their leading bytes are uniformly distributed.
+#define BOAT_KEYSTORE_HASH_SLOT(address, size) \
+    ((((UINT32)(address)[0] << 24) | ((UINT32)(address)[1] << 16) | ((UINT32)(address)[2] << 8) | (address)[3]) & ((size) - 1))
+
+
+//!@brief Key derivation function of keystore records
+typedef enum
+{
+    BOAT_KEYSTORE_KDF_KECCAK = 0,   //!< keccak_256 of the password, record without KDF header
+    BOAT_KEYSTORE_KDF_PBKDF2,       //!< PBKDF2-HMAC-SHA256
+    BOAT_KEYSTORE_KDF_SCRYPT        //!< scrypt, requires OpenSSL 1.1.0 or later
+}BoatKeystoreKdfType;
+
+//!@brief Key derivation function and its cost parameters
+typedef struct TBoatKeystoreKdf
+{
+    BoatKeystoreKdfType type;   //!< Key derivation function
+    UINT32 cost;                //!< PBKDF2 iteration count, or scrypt N (power of 2)
+    UINT16 r;                   //!< scrypt block size, ignored by PBKDF2
+    UINT16 p;                   //!< scrypt parallelization, ignored by PBKDF2
+}BoatKeystoreKdf;
+
+
+//!@brief Keystore container index entry
+typedef struct TBoatKeystoreIndexEntry
+{
+    BoatAddress address;    //!< Account address
+    UINT32 record_offset;   //!< File offset of the record, 0 if the entry is removed
+}BoatKeystoreIndexEntry;
+
+//!@brief Keystore container
+
+//! A keystore container holds many accounts in one file. Each account is a
+//! keystore record in the same layout as a single keystore file (see
+//! BoatWalletSaveWalletEx()), so loading one account only reads and decrypts
+//! that record. The address index is loaded into a hash table when the
+//! container is opened.
+typedef struct TBoatKeystoreContainer
+{
+    FILE *file_ptr;                         //!< Container file
+    CHAR *file_path_str;                    //!< Container file path
+    BoatKeystoreIndexEntry *entry_array;    //!< Index entries, including removed ones
+    UINT32 entry_num;                       //!< Number of entries in <entry_array>
+    UINT32 entry_capacity;                  //!< Capacity of <entry_array>
+    UINT32 live_num;                        //!< Number of entries not removed
+    UINT32 *hash_table;                     //!< Entry index + 1 of each slot, 0 for empty slot
+    UINT32 hash_table_size;                 //!< Number of slots, power of 2
+    UINT32 data_end;                        //!< File offset to append the next record at
+    BOATBOOL dirty;                         //!< BOAT_TRUE if the index in file is out of date
+}BoatKeystoreContainer;
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+BOAT_RESULT BoatKeystoreSetKdf(const BoatKeystoreKdf *kdf_ptr);
+
+void BoatKeystoreKdfCacheFlush(void);
+
+UINT32 BoatKeystoreKdfBenchmark(const BoatKeystoreKdf *kdf_ptr, UINT32 rounds);
+
+UINT32 BoatKeystoreRecordSize(const BoatWalletInfo *wallet_info_ptr);
+
+BOAT_RESULT BoatKeystoreRecordEncode(const BoatWalletInfo *wallet_info_ptr,
+                                     const UINT8 *passwd_ptr,
+                                     UINT32 passwd_len,
+                                     BOAT_OUT UINT8 *record_ptr,
+                                     UINT32 record_size,
+                                     BOAT_OUT UINT32 *record_len_ptr);
+
+BOAT_RESULT BoatKeystoreRecordDecode(BOAT_OUT BoatWalletInfo *wallet_info_ptr,
+                                     const UINT8 *passwd_ptr,
+                                     UINT32 passwd_len,
+                                     const UINT8 *record_ptr,
+                                     UINT32 record_len);
+
+BOAT_RESULT BoatKeystoreContainerOpen(BOAT_OUT BoatKeystoreContainer *container_ptr, const CHAR *file_path_str, BOATBOOL create);
+
+BOAT_RESULT BoatKeystoreContainerFlush(BoatKeystoreContainer *container_ptr);
+
+BOAT_RESULT BoatKeystoreContainerClose(BoatKeystoreContainer *container_ptr);
+
+BOAT_RESULT BoatKeystoreContainerAppend(BoatKeystoreContainer *container_ptr,
+                                        const BoatWalletInfo *wallet_info_ptr,
+                                        const UINT8 *passwd_ptr,
+                                        UINT32 passwd_len);
+
+BOAT_RESULT BoatKeystoreContainerLoad(BoatKeystoreContainer *container_ptr,
+                                      const BoatAddress address,
+                                      const UINT8 *passwd_ptr,
+                                      UINT32 passwd_len,
+                                      BOAT_OUT BoatWalletInfo *wallet_info_ptr);
+
+BOAT_RESULT BoatKeystoreContainerRemove(BoatKeystoreContainer *container_ptr, const BoatAddress address);
+
+BOAT_RESULT BoatKeystoreContainerCompact(BoatKeystoreContainer *container_ptr);
+
+#ifdef __cplusplus
+}
+#endif /* end of __cplusplus */
+
+#endif
@@ -0,0 +1,1732 @@
+/******************************************************************************
+Copyright (C) 2018-2019 AITOS.IO
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+of the Software, and to permit persons to whom the Software is furnished to do
+so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+******************************************************************************/
+
+/*!@brief Persistent transaction journal and store-and-forward outbox
+
+@file
+outbox.c journals signed transactions on disk and submits them in nonce order
+from a background flusher thread.
+*/
+
+// For flock() and pthread_condattr_setclock()
+#define _DEFAULT_SOURCE
+
+#include "wallet/boatwallet.h"
+#include "wallet/outbox.h"
+#include "rpc/rpcintf.h"
+#include "cJSON.h"
+#include "sha3.h"
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/file.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <time.h>
+#include <errno.h>
+
+#define OUTBOX_JOURNAL_MAGIC "BOXL"
+#define OUTBOX_CKPT_MAGIC "BOXC"
+#define OUTBOX_VERSION 1
+
+//! "BOXL" | version | reserved (3) | address (20)
+#define OUTBOX_HEADER_SIZE (4 + 1 + 3 + 20)
+//! length BE4 | checksum BE4 | nonce BE8
+#define OUTBOX_ENTRY_HEADER_SIZE (4 + 4 + 8)
+//! "BOXC" | version | reserved (3) | sent offset BE8 | next nonce BE8 | nonce valid | reserved (3) | checksum BE4
+#define OUTBOX_CKPT_SIZE (4 + 1 + 3 + 8 + 8 + 1 + 3 + 4)
+
+//! Size of the request buffer, *2 for HEX and some more for the JSON wrapping
+#define OUTBOX_REQUEST_BUF_SIZE (BOAT_OUTBOX_MAX_TX_SIZE * 2 + 128)
+
+//!@brief Result of submitting an entry
+typedef enum
+{
+    OUTBOX_SUBMIT_DONE = 0, //!< The node has the transaction
+    OUTBOX_SUBMIT_RETRY,    //!< The node is unreachable
+    OUTBOX_SUBMIT_REJECTED  //!< The node rejects the transaction
+}OutboxSubmitStatus;
+
+//! Substrings of node errors meaning the transaction needn't be submitted again
+static const CHAR * const g_outbox_known_errors[] =
+{
+    "nonce too low",
+    "already known",
+    "known transaction",
+    "already imported"
+};
+
+
+static UINT32 OutboxBigendToUint32(const UINT8 *from_big_ptr)
+{
+    return   ((UINT32)from_big_ptr[0] << 24) | ((UINT32)from_big_ptr[1] << 16)
+           | ((UINT32)from_big_ptr[2] << 8)  |  (UINT32)from_big_ptr[3];
+}
+
+
+static UINT64 OutboxBigendToUint64(const UINT8 *from_big_ptr)
+{
+    return ((UINT64)OutboxBigendToUint32(from_big_ptr) << 32) | OutboxBigendToUint32(from_big_ptr + 4);
+}
+
+
+static BOAT_RESULT OutboxPwriteAll(int fd, const UINT8 *data_ptr, UINT32 data_len, UINT64 offset)
+{
+    ssize_t written_len;
+
+    while( data_len > 0 )
+    {
+        written_len = pwrite(fd, data_ptr, data_len, (off_t)offset);
+        if( written_len < 0 && errno == EINTR ) continue;
+        if( written_len <= 0 ) return BOAT_ERROR_EXT_MODULE_OPERATION_FAIL;
+
+        data_ptr += written_len;
+        data_len -= written_len;
+        offset += written_len;
+    }
+
+    return BOAT_SUCCESS;
+}
+
+
+static BOAT_RESULT OutboxPreadAll(int fd, UINT8 *data_ptr, UINT32 data_len, UINT64 offset)
+{
+    ssize_t read_len;
+
+    while( data_len > 0 )
+    {
+        read_len = pread(fd, data_ptr, data_len, (off_t)offset);
+        if( read_len < 0 && errno == EINTR ) continue;
+        if( read_len <= 0 ) return BOAT_ERROR_EXT_MODULE_OPERATION_FAIL;
+
+        data_ptr += read_len;
+        data_len -= read_len;
+        offset += read_len;
+    }
+
+    return BOAT_SUCCESS;
+}
+
+
+/*!*****************************************************************************
+@brief Compute the checksum of a journal entry
+
+Function: OutboxEntryChecksum()
+
+    The checksum is the first 4 bytes of keccak_256 over nonce and transaction.
+
+@return This function doesn't return any thing.
+
+@param[in] entry_ptr
+    The entry, whose length and nonce fields are set.
+
+@param[out] checksum
+    The checksum.
+*******************************************************************************/
+static void OutboxEntryChecksum(const UINT8 *entry_ptr, BOAT_OUT UINT8 checksum[4])
+{
+    UINT8 digest[32];
+
+    keccak_256(entry_ptr + 8, 8 + OutboxBigendToUint32(entry_ptr), digest);
+    memcpy(checksum, digest, 4);
+}
+
+
+/*!*****************************************************************************
+@brief Read and verify a journal entry
+
+Function: OutboxReadEntry()
+
+@return
+    This function returns BOAT_SUCCESS if a complete entry with correct
+    checksum is read.\n
+    It returns BOAT_ERROR_INVALID_LENGTH if the entry is torn or corrupted, or
+    BOAT_ERROR_EXT_MODULE_OPERATION_FAIL if the journal can't be read.
+
+@param[in] fd
+    The journal.
+
+@param[in] offset
+    Offset of the entry.
+
+@param[in] end_offset
+    The entry must end before this offset.
+
+@param[out] entry_ptr
+    Buffer of OUTBOX_ENTRY_HEADER_SIZE + BOAT_OUTBOX_MAX_TX_SIZE bytes to read
+    the entry into.
+
+@param[out] tx_len_ptr
+    Length of the transaction.
+
+@param[out] nonce_ptr
+    Nonce of the transaction.
+*******************************************************************************/
+static BOAT_RESULT OutboxReadEntry(int fd, UINT64 offset, UINT64 end_offset,
+                                   BOAT_OUT UINT8 *entry_ptr,
+                                   BOAT_OUT UINT32 *tx_len_ptr,
+                                   BOAT_OUT UINT64 *nonce_ptr)
+{
+    UINT32 tx_len;
+    UINT8 checksum[4];
+    BOAT_RESULT result;
+
+    if( offset + OUTBOX_ENTRY_HEADER_SIZE > end_offset ) return BOAT_ERROR_INVALID_LENGTH;
+
+    result = OutboxPreadAll(fd, entry_ptr, OUTBOX_ENTRY_HEADER_SIZE, offset);
+    if( result != BOAT_SUCCESS ) return result;
+
+    tx_len = OutboxBigendToUint32(entry_ptr);
+    if(    tx_len == 0
+        || tx_len > BOAT_OUTBOX_MAX_TX_SIZE
+        || offset + OUTBOX_ENTRY_HEADER_SIZE + tx_len > end_offset )
+    {
+        return BOAT_ERROR_INVALID_LENGTH;
+    }
+
+    result = OutboxPreadAll(fd, entry_ptr + OUTBOX_ENTRY_HEADER_SIZE, tx_len, offset + OUTBOX_ENTRY_HEADER_SIZE);
+    if( result != BOAT_SUCCESS ) return result;
+
+    OutboxEntryChecksum(entry_ptr, checksum);
+    if( memcmp(checksum, entry_ptr + 4, 4) != 0 ) return BOAT_ERROR_INVALID_LENGTH;
+
+    *tx_len_ptr = tx_len;
+    *nonce_ptr = OutboxBigendToUint64(entry_ptr + 8);
+
+    return BOAT_SUCCESS;
+}
+
+
+/*!*****************************************************************************
+@brief Write the checkpoint of an outbox
+
+Function: OutboxWriteCheckpointLocked()
+
+    The checkpoint is written to a temporary file, synced and renamed over the
+    old one, and the directory is synced, so that either the old or the new
+    checkpoint survives a crash. Losing the latest checkpoint only causes some
+    sent entries to be submitted again.
+
+    The mutex of the outbox must be held.
+
+@return
+    This function returns BOAT_SUCCESS if successful. Otherwise it returns
+    BOAT_ERROR_EXT_MODULE_OPERATION_FAIL.
+
+@param[in] outbox_ptr
+    The outbox.
+*******************************************************************************/
+static BOAT_RESULT OutboxWriteCheckpointLocked(BoatOutbox *outbox_ptr)
+{
+    UINT8 ckpt[OUTBOX_CKPT_SIZE];
+    UINT8 digest[32];
+    CHAR *tmp_path_str;
+    int fd = -1;
+    UINT64 ckpt_nonce;
+
+    BOAT_RESULT result = BOAT_SUCCESS;
+    boat_try_declare;
+
+    // Entries not yet durable may be lost, so don't save their nonces
+    ckpt_nonce = (outbox_ptr->unsynced_num == 0) ? outbox_ptr->next_nonce : outbox_ptr->synced_nonce;
+
+    memset(ckpt, 0, sizeof(ckpt));
+    memcpy(ckpt, OUTBOX_CKPT_MAGIC, 4);
+    ckpt[4] = OUTBOX_VERSION;
+    UtilityUint64ToBigend(ckpt + 8, outbox_ptr->sent_offset, TRIMBIN_TRIM_NO);
+    UtilityUint64ToBigend(ckpt + 16, ckpt_nonce, TRIMBIN_TRIM_NO);
+    ckpt[24] = outbox_ptr->nonce_valid;
+    keccak_256(ckpt, OUTBOX_CKPT_SIZE - 4, digest);
+    memcpy(ckpt + OUTBOX_CKPT_SIZE - 4, digest, 4);
+
+    tmp_path_str = BoatMalloc(strlen(outbox_ptr->ckpt_path_str) + 5);
+    if( tmp_path_str == NULL ) boat_throw(BOAT_ERROR_OUT_OF_MEMORY, OutboxWriteCheckpointLocked_cleanup);
+    sprintf(tmp_path_str, "%s.tmp", outbox_ptr->ckpt_path_str);
+
+    fd = open(tmp_path_str, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+    if(    fd < 0
+        || OutboxPwriteAll(fd, ckpt, OUTBOX_CKPT_SIZE, 0) != BOAT_SUCCESS
+        || fsync(fd) != 0 )
+    {
+        BoatLog(BOAT_LOG_NORMAL, "Fail to write checkpoint %s.", tmp_path_str);
+        boat_throw(BOAT_ERROR_EXT_MODULE_OPERATION_FAIL, OutboxWriteCheckpointLocked_cleanup);
+    }
+    close(fd);
+    fd = -1;
+
+    if( rename(tmp_path_str, outbox_ptr->ckpt_path_str) != 0 )
+    {
+        BoatLog(BOAT_LOG_NORMAL, "Fail to rename checkpoint to %s.", outbox_ptr->ckpt_path_str);
+        boat_throw(BOAT_ERROR_EXT_MODULE_OPERATION_FAIL, OutboxWriteCheckpointLocked_cleanup);
+    }
+
+    // The rename itself is only durable once the directory is synced
+    if( UtilitySyncDir(outbox_ptr->ckpt_path_str) != BOAT_SUCCESS )
+    {
+        BoatLog(BOAT_LOG_NORMAL, "Fail to sync the directory of %s.", outbox_ptr->ckpt_path_str);
+        boat_throw(BOAT_ERROR_EXT_MODULE_OPERATION_FAIL, OutboxWriteCheckpointLocked_cleanup);
+    }
+
+    outbox_ptr->unsaved_num = 0;
+
+    boat_catch(OutboxWriteCheckpointLocked_cleanup)
+    {
+        BoatLog(BOAT_LOG_NORMAL, "Exception: %d", boat_exception);
+        result = boat_exception;
+    }
+
+    if( fd >= 0 ) close(fd);
+    if( tmp_path_str != NULL ) BoatFree(tmp_path_str);
+
+    return result;
+}
+
+
+/*!*****************************************************************************
+@brief Read the checkpoint of an outbox
+
+Function: OutboxReadCheckpoint()
+
+@return
+    This function returns BOAT_TRUE if a valid checkpoint is read. Otherwise
+    it returns BOAT_FALSE and the outputs are untouched.
+
+@param[in] outbox_ptr
+    The outbox.
+
+@param[out] sent_offset_ptr
+    Offset of the first entry not yet sent.
+
+@param[out] next_nonce_ptr
+    Nonce of the next enqueued transaction.
+
+@param[out] nonce_valid_ptr
+    BOAT_TRUE if <next_nonce_ptr> is known.
+*******************************************************************************/
+static BOATBOOL OutboxReadCheckpoint(const BoatOutbox *outbox_ptr,
+                                     BOAT_OUT UINT64 *sent_offset_ptr,
+                                     BOAT_OUT UINT64 *next_nonce_ptr,
+                                     BOAT_OUT BOATBOOL *nonce_valid_ptr)
+{
+    UINT8 ckpt[OUTBOX_CKPT_SIZE];
+    UINT8 digest[32];
+    int fd;
+    BOAT_RESULT result;
+
+    fd = open(outbox_ptr->ckpt_path_str, O_RDONLY | O_CLOEXEC);
+    if( fd < 0 ) return BOAT_FALSE;
+
+    result = OutboxPreadAll(fd, ckpt, OUTBOX_CKPT_SIZE, 0);
+    close(fd);
+    if( result != BOAT_SUCCESS ) return BOAT_FALSE;
+
+    keccak_256(ckpt, OUTBOX_CKPT_SIZE - 4, digest);
+    if(    memcmp(ckpt, OUTBOX_CKPT_MAGIC, 4) != 0
+        || ckpt[4] != OUTBOX_VERSION
+        || memcmp(ckpt + OUTBOX_CKPT_SIZE - 4, digest, 4) != 0 )
+    {
+        BoatLog(BOAT_LOG_NORMAL, "Ignore corrupted checkpoint %s.", outbox_ptr->ckpt_path_str);
+        return BOAT_FALSE;
+    }
+
+    *sent_offset_ptr = OutboxBigendToUint64(ckpt + 8);
+    *next_nonce_ptr = OutboxBigendToUint64(ckpt + 16);
+    *nonce_valid_ptr = (ckpt[24] != 0) ? BOAT_TRUE : BOAT_FALSE;
+
+    return BOAT_TRUE;
+}
+
+
+/*!*****************************************************************************
+@brief Make appended entries durable
+
+Function: OutboxSyncLocked()
+
+    The mutex of the outbox must be held.
+
+@return
+    This function returns BOAT_SUCCESS if successful. Otherwise it returns
+    BOAT_ERROR_EXT_MODULE_OPERATION_FAIL.
+
+@param[in] outbox_ptr
+    The outbox.
+*******************************************************************************/
+static BOAT_RESULT OutboxSyncLocked(BoatOutbox *outbox_ptr)
+{
+    if( outbox_ptr->unsynced_num != 0 )
+    {
+        if( fdatasync(outbox_ptr->fd) != 0 )
+        {
+            BoatLog(BOAT_LOG_CRITICAL, "Fail to sync transaction journal.");
+            return BOAT_ERROR_EXT_MODULE_OPERATION_FAIL;
+        }
+
+        outbox_ptr->synced_offset = outbox_ptr->end_offset;
+        outbox_ptr->unsynced_num = 0;
+
+        // The flusher only submits durable entries
+        pthread_cond_signal(&outbox_ptr->flusher_cond);
+    }
+
+    outbox_ptr->synced_nonce = outbox_ptr->next_nonce;
+    outbox_ptr->sync_requested = BOAT_FALSE;
+
+    return BOAT_SUCCESS;
+}
+
+
+/*!*****************************************************************************
+@brief Parse a JSON-RPC response received by the outbox
+
+Function: OutboxParseResponse()
+
+@return
+    This function returns BOAT_SUCCESS if the response is JSON. Otherwise it
+    returns BOAT_ERROR_JSON_PARSE_FAIL.
+
+@param[in] rpc_response_str
+    The response.
+
+@param[out] response_json_pptr
+    The parsed response. The caller must free it with cJSON_Delete().
+*******************************************************************************/
+static BOAT_RESULT OutboxParseResponse(const CHAR *rpc_response_str, BOAT_OUT cJSON **response_json_pptr)
+{
+    BoatLog(BOAT_LOG_VERBOSE, "RESPONSE: %s", rpc_response_str);
+
+    *response_json_pptr = cJSON_Parse(rpc_response_str);
+    if( *response_json_pptr == NULL )
+    {
+        BoatLog(BOAT_LOG_NORMAL, "Parsing RESPONSE as JSON fails.");
+        return BOAT_ERROR_JSON_PARSE_FAIL;
+    }
+
+    return BOAT_SUCCESS;
+}
+
+
+/*!*****************************************************************************
+@brief POST a JSON-RPC request to the node of an outbox
+
+Function: OutboxRpcCall()
+
+    The web3 interface keeps its buffers in globals and is for the main thread
+    only. The outbox constructs its own requests and calls the RPC layer, whose
+    state is per thread.
+
+@return
+    This function returns BOAT_SUCCESS if a JSON response is received.\n
+    It returns BOAT_ERROR_RPC_FAIL if the node is unreachable or
+    BOAT_ERROR_JSON_PARSE_FAIL if the response is not JSON.
+
+@param[in] outbox_ptr
+    The outbox.
+
+@param[in] request_str
+    The request.
+
+@param[in] request_len
+    Length of <request_str>.
+
+@param[out] response_json_pptr
+    The parsed response. The caller must free it with cJSON_Delete().
+*******************************************************************************/
+static BOAT_RESULT OutboxRpcCall(const BoatOutbox *outbox_ptr,
+                                 const CHAR *request_str,
+                                 UINT32 request_len,
+                                 BOAT_OUT cJSON **response_json_pptr)
+{
+    RpcOption rpc_option;
+    CHAR *rpc_response_str;
+    UINT32 rpc_response_len;
+    BOAT_RESULT result;
+
+#if RPC_OPTION_HAS_NODE_URL
+    rpc_option.node_url_str = outbox_ptr->node_url_str;
+#endif
+
+    RpcSetOpt(&rpc_option);
+
+    BoatLog(BOAT_LOG_VERBOSE, "REQUEST: %s", request_str);
+
+    result = RpcRequestSync((const UINT8 *)request_str,
+                            request_len,
+                            (BOAT_OUT UINT8 **)&rpc_response_str,
+                            &rpc_response_len);
+    if( result != BOAT_SUCCESS ) return BOAT_ERROR_RPC_FAIL;
+
+    return OutboxParseResponse(rpc_response_str, response_json_pptr);
+}
+
+
+/*!*****************************************************************************
+@brief Get the pending transaction count of the outbox's sender from the node
+
+Function: OutboxFetchNonce()
+
+@return
+    This function returns BOAT_SUCCESS if successful. Otherwise it returns
+    BOAT_ERROR_RPC_FAIL or BOAT_ERROR_JSON_PARSE_FAIL.
+
+@param[in] outbox_ptr
+    The outbox.
+
+@param[out] nonce_ptr
+    The transaction count including those pending in the node.
+*******************************************************************************/
+static BOAT_RESULT OutboxFetchNonce(const BoatOutbox *outbox_ptr, BOAT_OUT UINT64 *nonce_ptr)
+{
+    CHAR request_str[160];
+    CHAR address_str[43];
+    UINT32 request_len;
+    cJSON *response_json_ptr = NULL;
+    cJSON *result_json_ptr;
+    BOAT_RESULT result;
+
+    UtilityBin2Hex(address_str, outbox_ptr->address, 20,
+                   BIN2HEX_TRIM_NO, BIN2HEX_PREFIX_0x_YES, BOAT_FALSE);
+
+    request_len = snprintf(request_str, sizeof(request_str),
+                           "{\"jsonrpc\":\"2.0\",\"method\":\"eth_getTransactionCount\",\"params\":"
+                           "[\"%s\",\"pending\"],\"id\":0}",
+                           address_str);
+
+    result = OutboxRpcCall(outbox_ptr, request_str, request_len, &response_json_ptr);
+
+    if( result == BOAT_SUCCESS )
+    {
+        result_json_ptr = cJSON_GetObjectItem(response_json_ptr, "result");
+        if( result_json_ptr != NULL && cJSON_IsString(result_json_ptr) )
+        {
+            *nonce_ptr = strtoull(result_json_ptr->valuestring, NULL, 16);
+        }
+        else
+        {
+            BoatLog(BOAT_LOG_NORMAL, "Fail to get transaction count from network.");
+            result = BOAT_ERROR_JSON_PARSE_FAIL;
+        }
+    }
+
+    if( response_json_ptr != NULL ) cJSON_Delete(response_json_ptr);
+
+    return result;
+}
+
+
+/*!*****************************************************************************
+@brief Send a journal entry with eth_sendRawTransaction
+
+Function: OutboxSubmitSend()
+
+    The request is pipelined by RpcRequestAsync() with the nonce as its "id".
+    Its result is taken by OutboxSubmitRecv().
+
+@return
+    This function returns BOAT_SUCCESS if the request is sent. Otherwise it
+    returns the error code of RpcRequestAsync().
+
+@param[in] outbox_ptr
+    The outbox.
+
+@param[out] request_str
+    Buffer of OUTBOX_REQUEST_BUF_SIZE bytes to construct the request in.
+
+@param[in] tx_ptr
+    The signed transaction.
+
+@param[in] tx_len
+    Length of the transaction, at most BOAT_OUTBOX_MAX_TX_SIZE.
+
+@param[in] nonce
+    Nonce of the transaction.
+*******************************************************************************/
+static BOAT_RESULT OutboxSubmitSend(BoatOutbox *outbox_ptr,
+                                    BOAT_OUT CHAR *request_str,
+                                    const UINT8 *tx_ptr,
+                                    UINT32 tx_len,
+                                    UINT64 nonce)
+{
+    UINT32 request_len;
+    RpcOption rpc_option;
+
+    request_len = sprintf(request_str,
+                          "{\"jsonrpc\":\"2.0\",\"method\":\"eth_sendRawTransaction\",\"params\":[\"");
+    request_len += UtilityBin2Hex(request_str + request_len,
+                                  tx_ptr,
+                                  tx_len,
+                                  BIN2HEX_TRIM_NO,
+                                  BIN2HEX_PREFIX_0x_YES,
+                                  BOAT_FALSE);
+    request_len += sprintf(request_str + request_len, "\"],\"id\":%llu}", (unsigned long long)nonce);
+
+#if RPC_OPTION_HAS_NODE_URL
+    rpc_option.node_url_str = outbox_ptr->node_url_str;
+#endif
+
+    RpcSetOpt(&rpc_option);
+
+    BoatLog(BOAT_LOG_VERBOSE, "REQUEST: %s", request_str);
+
+    return RpcRequestAsync((const UINT8 *)request_str, request_len);
+}
+
+
+/*!*****************************************************************************
+@brief Take the result of a journal entry sent by OutboxSubmitSend()
+
+Function: OutboxSubmitRecv()
+
+@return
+    This function returns OUTBOX_SUBMIT_DONE if the node accepts the
+    transaction or already has it, OUTBOX_SUBMIT_RETRY if the node is
+    unreachable, or OUTBOX_SUBMIT_REJECTED if the node rejects it.
+
+@param[in] nonce
+    Nonce of the transaction.
+*******************************************************************************/
+static OutboxSubmitStatus OutboxSubmitRecv(UINT64 nonce)
+{
+    CHAR *rpc_response_str;
+    UINT32 rpc_response_len;
+    cJSON *response_json_ptr = NULL;
+    cJSON *item_json_ptr;
+    const CHAR *message_str;
+    UINT32 i;
+    BOAT_RESULT result;
+    OutboxSubmitStatus status;
+
+    result = RpcWaitResponse(nonce,
+                             BOAT_RPC_TIMEOUT_MS,
+                             (BOAT_OUT UINT8 **)&rpc_response_str,
+                             &rpc_response_len);
+    if( result == BOAT_SUCCESS )
+    {
+        result = OutboxParseResponse(rpc_response_str, &response_json_ptr);
+    }
+
+    if( result != BOAT_SUCCESS )
+    {
+        // A non-JSON response is typically from a proxy in front of an unreachable node
+        if( response_json_ptr != NULL ) cJSON_Delete(response_json_ptr);
+        return OUTBOX_SUBMIT_RETRY;
+    }
+
+    item_json_ptr = cJSON_GetObjectItem(response_json_ptr, "result");
+    if( item_json_ptr != NULL && cJSON_IsString(item_json_ptr) )
+    {
+        BoatLog(BOAT_LOG_VERBOSE, "Transaction of nonce %llu sent: %s",
+                (unsigned long long)nonce, item_json_ptr->valuestring);
+        status = OUTBOX_SUBMIT_DONE;
+    }
+    else
+    {
+        message_str = "unknown error";
+        item_json_ptr = cJSON_GetObjectItem(response_json_ptr, "error");
+        if( item_json_ptr != NULL )
+        {
+            item_json_ptr = cJSON_GetObjectItem(item_json_ptr, "message");
+            if( item_json_ptr != NULL && cJSON_IsString(item_json_ptr) )
+            {
+                message_str = item_json_ptr->valuestring;
+            }
+        }
+
+        status = OUTBOX_SUBMIT_REJECTED;
+        for( i = 0; i < sizeof(g_outbox_known_errors) / sizeof(g_outbox_known_errors[0]); i++ )
+        {
+            if( strstr(message_str, g_outbox_known_errors[i]) != NULL )
+            {
+                status = OUTBOX_SUBMIT_DONE;
+                break;
+            }
+        }
+
+        BoatLog(BOAT_LOG_NORMAL, "Transaction of nonce %llu %s: %s",
+                (unsigned long long)nonce,
+                status == OUTBOX_SUBMIT_DONE ? "was already sent" : "is rejected",
+                message_str);
+    }
+
+    cJSON_Delete(response_json_ptr);
+
+    return status;
+}
+
+
+/*!*****************************************************************************
+@brief Truncate a drained journal
+
+Function: OutboxCompactLocked()
+
+    The journal is truncated before the checkpoint is rewritten. If a crash
+    happens in between, the checkpointed offset is beyond the end of journal
+    and is reset on open.
+
+    The mutex of the outbox must be held.
+
+@return This function doesn't return any thing.
+
+@param[in] outbox_ptr
+    The drained outbox.
+*******************************************************************************/
+static void OutboxCompactLocked(BoatOutbox *outbox_ptr)
+{
+    if( ftruncate(outbox_ptr->fd, OUTBOX_HEADER_SIZE) != 0 || fdatasync(outbox_ptr->fd) != 0 )
+    {
+        BoatLog(BOAT_LOG_NORMAL, "Fail to truncate transaction journal.");
+        return;
+    }
+
+    BoatLog(BOAT_LOG_VERBOSE, "Transaction journal of %llu bytes is truncated.",
+            (unsigned long long)outbox_ptr->end_offset);
+
+    outbox_ptr->end_offset = OUTBOX_HEADER_SIZE;
+    outbox_ptr->synced_offset = OUTBOX_HEADER_SIZE;
+    outbox_ptr->sent_offset = OUTBOX_HEADER_SIZE;
+
+    OutboxWriteCheckpointLocked(outbox_ptr);
+}
+
+
+static void OutboxDeadline(struct timespec *deadline_ptr, UINT64 deadline_ms)
+{
+    deadline_ptr->tv_sec = deadline_ms / 1000u;
+    deadline_ptr->tv_nsec = (deadline_ms % 1000u) * 1000000u;
+}
+
+
+/*!*****************************************************************************
+@brief Flusher thread of an outbox
+
+Function: OutboxFlusherMain()
+
+    The flusher submits durable entries in journal order, i.e. in nonce order.
+    Up to BOAT_RPC_PIPELINE_DEPTH entries are sent ahead without waiting for
+    results, which are then taken one by one in the same order. An entry is
+    done if the node accepts it or already has it. Entries sent ahead of one
+    not done are given up and sent again later.
+    If the node is unreachable, the entry is retried with exponential backoff
+    from BOAT_OUTBOX_RETRY_MIN_MS up to BOAT_OUTBOX_RETRY_MAX_MS. If the node
+    rejects it BOAT_OUTBOX_MAX_REJECTS times, the outbox is stalled: nothing
+    is submitted until BoatOutboxReplace() takes the nonce, because later
+    entries couldn't be mined anyway.
+
+    The flusher also syncs entries that have not been durable for
+    BOAT_OUTBOX_SYNC_INTERVAL_MS, writes checkpoint and truncates the journal
+    once it's drained.
+
+@return This function always returns NULL.
+
+@param[in] arg
+    The outbox.
+*******************************************************************************/
+static void *OutboxFlusherMain(void *arg)
+{
+    BoatOutbox *outbox_ptr = (BoatOutbox *)arg;
+    UINT64 now_ms;
+    UINT64 deadline_ms;
+    UINT64 offset;
+    UINT64 end_offset;
+    UINT64 nonce = 0;
+    UINT32 tx_len = 0;
+    UINT64 window_nonce[BOAT_RPC_PIPELINE_DEPTH];
+    UINT64 window_end_offset[BOAT_RPC_PIPELINE_DEPTH];
+    UINT32 window_num = 0;
+    UINT64 window_offset = 0;
+    CHAR *response_str;
+    UINT32 response_len;
+    UINT32 i;
+    struct timespec deadline;
+    BOAT_RESULT result;
+    OutboxSubmitStatus status;
+
+    pthread_mutex_lock(&outbox_ptr->mutex);
+
+    while( outbox_ptr->running == BOAT_TRUE )
+    {
+        now_ms = BoatGetTimeMs();
+
+        if(    outbox_ptr->unsynced_num != 0
+            && (   outbox_ptr->sync_requested == BOAT_TRUE
+                || now_ms >= outbox_ptr->oldest_unsynced_ms + BOAT_OUTBOX_SYNC_INTERVAL_MS) )
+        {
+            OutboxSyncLocked(outbox_ptr);
+        }
+
+        if(    outbox_ptr->sent_offset < outbox_ptr->synced_offset
+            && outbox_ptr->stalled == BOAT_FALSE
+            && now_ms >= outbox_ptr->retry_at_ms )
+        {
+            // Durable entries are never modified, read and submit them unlocked
+            if( window_num == 0 ) window_offset = outbox_ptr->sent_offset;
+            end_offset = outbox_ptr->synced_offset;
+            pthread_mutex_unlock(&outbox_ptr->mutex);
+
+            // Keep the window full, so that a backlog takes about one round
+            // trip plus the transfer time of each entry
+            while( window_num < BOAT_RPC_PIPELINE_DEPTH && window_offset < end_offset )
+            {
+                result = OutboxReadEntry(outbox_ptr->fd, window_offset, end_offset, outbox_ptr->entry_buf_ptr, &tx_len, &nonce);
+                if( result != BOAT_SUCCESS )
+                {
+                    BoatLog(BOAT_LOG_CRITICAL, "Fail to read transaction journal at %llu.", (unsigned long long)window_offset);
+                    break;
+                }
+
+                result = OutboxSubmitSend(outbox_ptr,
+                                          outbox_ptr->request_buf_ptr,
+                                          outbox_ptr->entry_buf_ptr + OUTBOX_ENTRY_HEADER_SIZE,
+                                          tx_len,
+                                          nonce);
+                if( result != BOAT_SUCCESS ) break;
+
+                window_offset += OUTBOX_ENTRY_HEADER_SIZE + tx_len;
+                window_nonce[window_num] = nonce;
+                window_end_offset[window_num] = window_offset;
+                window_num++;
+            }
+
+            if( window_num != 0 )
+            {
+                nonce = window_nonce[0];
+                offset = window_end_offset[0];
+                status = OutboxSubmitRecv(nonce);
+
+                window_num--;
+                memmove(&window_nonce[0], &window_nonce[1], window_num * sizeof(UINT64));
+                memmove(&window_end_offset[0], &window_end_offset[1], window_num * sizeof(UINT64));
+            }
+            else
+            {
+                status = OUTBOX_SUBMIT_RETRY;
+            }
+
+            if( status != OUTBOX_SUBMIT_DONE )
+            {
+                for( i = 0; i < window_num; i++ )
+                {
+                    RpcWaitResponse(window_nonce[i], 0, (BOAT_OUT UINT8 **)&response_str, &response_len);
+                }
+                window_num = 0;
+            }
+
+            pthread_mutex_lock(&outbox_ptr->mutex);
+            now_ms = BoatGetTimeMs();
+
+            if( status == OUTBOX_SUBMIT_DONE )
+            {
+                outbox_ptr->sent_num++;
+            }
+            else if( status == OUTBOX_SUBMIT_REJECTED && ++outbox_ptr->reject_num >= BOAT_OUTBOX_MAX_REJECTS )
+            {
+                // Never skip the nonce, later transactions can't be mined without it
+                BoatLog(BOAT_LOG_CRITICAL, "Transaction of nonce %llu is rejected %u times. "
+                        "The outbox is stalled until it's replaced by BoatOutboxReplace().",
+                        (unsigned long long)nonce, outbox_ptr->reject_num);
+                outbox_ptr->stalled = BOAT_TRUE;
+                outbox_ptr->stalled_nonce = nonce;
+                outbox_ptr->stalled_end_offset = offset;
+                pthread_cond_broadcast(&outbox_ptr->drained_cond);
+                continue;
+            }
+
+            if( status == OUTBOX_SUBMIT_DONE )
+            {
+                outbox_ptr->sent_offset = offset;
+                outbox_ptr->pending_num--;
+                outbox_ptr->unsaved_num++;
+                outbox_ptr->reject_num = 0;
+                outbox_ptr->backoff_ms = 0;
+                outbox_ptr->retry_at_ms = 0;
+
+                if( outbox_ptr->unsaved_num >= BOAT_OUTBOX_CHECKPOINT_INTERVAL )
+                {
+                    OutboxWriteCheckpointLocked(outbox_ptr);
+                }
+            }
+            else
+            {
+                if( status == OUTBOX_SUBMIT_RETRY ) outbox_ptr->failure_num++;
+
+                if( outbox_ptr->backoff_ms == 0 )
+                {
+                    outbox_ptr->backoff_ms = BOAT_OUTBOX_RETRY_MIN_MS;
+                }
+                else if( outbox_ptr->backoff_ms < BOAT_OUTBOX_RETRY_MAX_MS / 2 )
+                {
+                    outbox_ptr->backoff_ms *= 2;
+                }
+                else
+                {
+                    outbox_ptr->backoff_ms = BOAT_OUTBOX_RETRY_MAX_MS;
+                }
+                outbox_ptr->retry_at_ms = now_ms + outbox_ptr->backoff_ms;
+            }
+
+            continue;
+        }
+
+        if( outbox_ptr->sent_offset == outbox_ptr->end_offset )
+        {
+            if( outbox_ptr->unsaved_num != 0 )
+            {
+                OutboxWriteCheckpointLocked(outbox_ptr);
+            }
+
+            if( outbox_ptr->end_offset > BOAT_OUTBOX_COMPACT_SIZE )
+            {
+                OutboxCompactLocked(outbox_ptr);
+            }
+
+            pthread_cond_broadcast(&outbox_ptr->drained_cond);
+        }
+
+        // Sleep until the current entry may be retried or the oldest entry
+        // must be synced, whichever is earlier
+        deadline_ms = 0;
+        if( outbox_ptr->sent_offset < outbox_ptr->synced_offset && outbox_ptr->stalled == BOAT_FALSE )
+        {
+            deadline_ms = outbox_ptr->retry_at_ms;
+        }
+        if(    outbox_ptr->unsynced_num != 0
+            && (   deadline_ms == 0
+                || outbox_ptr->oldest_unsynced_ms + BOAT_OUTBOX_SYNC_INTERVAL_MS < deadline_ms) )
+        {
+            deadline_ms = outbox_ptr->oldest_unsynced_ms + BOAT_OUTBOX_SYNC_INTERVAL_MS;
+        }
+
+        if( deadline_ms == 0 )
+        {
+            pthread_cond_wait(&outbox_ptr->flusher_cond, &outbox_ptr->mutex);
+        }
+        else
+        {
+            OutboxDeadline(&deadline, deadline_ms);
+            pthread_cond_timedwait(&outbox_ptr->flusher_cond, &outbox_ptr->mutex, &deadline);
+        }
+    }
+
+    pthread_mutex_unlock(&outbox_ptr->mutex);
+
+    return NULL;
+}
+
+
+/*!*****************************************************************************
+@brief Open a transaction outbox
+
+Function: BoatOutboxOpen()
+
+    This function opens or creates the journal <file_path_str> of the wallet's
+    account, recovers its state and starts the flusher thread.
+
+    Entries following the checkpointed offset are scanned. A torn or corrupted
+    entry and everything after it are truncated. The next nonce follows the
+    last entry not yet sent, or is the checkpointed one if all are sent.
+
+    The journal is locked against other processes until closed.
+
+@return
+    This function returns BOAT_SUCCESS if successful.\n
+    It returns BOAT_ERROR_INCOMPATIBLE_ARGUMENTS if the journal belongs to
+    another account. Otherwise it returns one of BOAT_ERROR_XXX.
+
+@param[out] outbox_ptr
+    The outbox to open.
+
+@param[in] file_path_str
+    Path of the journal. The checkpoint is saved in "<file_path_str>.ckpt".
+
+@param[in] boat_wallet_info_ptr
+    The wallet whose transactions are journaled. Its node URL is copied.
+*******************************************************************************/
+BOAT_RESULT BoatOutboxOpen(BOAT_OUT BoatOutbox *outbox_ptr,
+                           const CHAR *file_path_str,
+                           const BoatWalletInfo *boat_wallet_info_ptr)
+{
+    UINT8 header[OUTBOX_HEADER_SIZE];
+    struct stat file_stat;
+    UINT64 file_size;
+    UINT64 offset;
+    UINT64 nonce;
+    UINT32 tx_len;
+    pthread_condattr_t cond_attr;
+
+    BOAT_RESULT result = BOAT_SUCCESS;
+    boat_try_declare;
+
+    if(    outbox_ptr == NULL
+        || file_path_str == NULL
+        || boat_wallet_info_ptr == NULL
+        || boat_wallet_info_ptr->network_info.node_url_ptr == NULL )
+    {
+        BoatLog(BOAT_LOG_NORMAL, "Arguments cannot be NULL.");
+        return BOAT_ERROR_NULL_POINTER;
+    }
+
+    memset(outbox_ptr, 0, sizeof(BoatOutbox));
+    outbox_ptr->fd = -1;
+    memcpy(outbox_ptr->address, boat_wallet_info_ptr->account_info.address, sizeof(BoatAddress));
+
+    outbox_ptr->ckpt_path_str = BoatMalloc(strlen(file_path_str) + 6);
+    outbox_ptr->node_url_str = BoatMalloc(strlen(boat_wallet_info_ptr->network_info.node_url_ptr) + 1);
+    outbox_ptr->entry_buf_ptr = BoatMalloc(OUTBOX_ENTRY_HEADER_SIZE + BOAT_OUTBOX_MAX_TX_SIZE);
+    outbox_ptr->request_buf_ptr = BoatMalloc(OUTBOX_REQUEST_BUF_SIZE);
+    if(    outbox_ptr->ckpt_path_str == NULL
+        || outbox_ptr->node_url_str == NULL
+        || outbox_ptr->entry_buf_ptr == NULL
+        || outbox_ptr->request_buf_ptr == NULL )
+    {
+        BoatLog(BOAT_LOG_CRITICAL, "Fail to allocate outbox buffers.");
+        boat_throw(BOAT_ERROR_OUT_OF_MEMORY, BoatOutboxOpen_cleanup);
+    }
+    sprintf(outbox_ptr->ckpt_path_str, "%s.ckpt", file_path_str);
+    strcpy(outbox_ptr->node_url_str, boat_wallet_info_ptr->network_info.node_url_ptr);
+
+    outbox_ptr->fd = open(file_path_str, O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+    if( outbox_ptr->fd < 0 )
+    {
+        BoatLog(BOAT_LOG_NORMAL, "Fail to open transaction journal %s.", file_path_str);
+        boat_throw(BOAT_ERROR_EXT_MODULE_OPERATION_FAIL, BoatOutboxOpen_cleanup);
+    }
+
+    if( flock(outbox_ptr->fd, LOCK_EX | LOCK_NB) != 0 )
+    {
+        BoatLog(BOAT_LOG_NORMAL, "Transaction journal %s is used by another process.", file_path_str);
+        boat_throw(BOAT_ERROR_EXT_MODULE_OPERATION_FAIL, BoatOutboxOpen_cleanup);
+    }
+
+    if( fstat(outbox_ptr->fd, &file_stat) != 0 )
+    {
+        boat_throw(BOAT_ERROR_EXT_MODULE_OPERATION_FAIL, BoatOutboxOpen_cleanup);
+    }
+    file_size = file_stat.st_size;
+
+    if( file_size < OUTBOX_HEADER_SIZE )
+    {
+        // New journal, or one whose creation was interrupted
+        memset(header, 0, sizeof(header));
+        memcpy(header, OUTBOX_JOURNAL_MAGIC, 4);
+        header[4] = OUTBOX_VERSION;
+        memcpy(header + 8, outbox_ptr->address, sizeof(BoatAddress));
+
+        if(    ftruncate(outbox_ptr->fd, 0) != 0
+            || OutboxPwriteAll(outbox_ptr->fd, header, OUTBOX_HEADER_SIZE, 0) != BOAT_SUCCESS
+            || fdatasync(outbox_ptr->fd) != 0 )
+        {
+            BoatLog(BOAT_LOG_NORMAL, "Fail to create transaction journal %s.", file_path_str);
+            boat_throw(BOAT_ERROR_EXT_MODULE_OPERATION_FAIL, BoatOutboxOpen_cleanup);
+        }
+        file_size = OUTBOX_HEADER_SIZE;
+
+        // A checkpoint left by a deleted journal doesn't apply
+        unlink(outbox_ptr->ckpt_path_str);
+    }
+    else
+    {
+        if( OutboxPreadAll(outbox_ptr->fd, header, OUTBOX_HEADER_SIZE, 0) != BOAT_SUCCESS )
+        {
+            boat_throw(BOAT_ERROR_EXT_MODULE_OPERATION_FAIL, BoatOutboxOpen_cleanup);
+        }
+
+        if( memcmp(header, OUTBOX_JOURNAL_MAGIC, 4) != 0 || header[4] != OUTBOX_VERSION )
+        {
+            BoatLog(BOAT_LOG_NORMAL, "%s is not a transaction journal.", file_path_str);
+            boat_throw(BOAT_ERROR_INCOMPATIBLE_ARGUMENTS, BoatOutboxOpen_cleanup);
+        }
+
+        if( memcmp(header + 8, outbox_ptr->address, sizeof(BoatAddress)) != 0 )
+        {
+            BoatLog(BOAT_LOG_NORMAL, "Transaction journal %s belongs to another account.", file_path_str);
+            boat_throw(BOAT_ERROR_INCOMPATIBLE_ARGUMENTS, BoatOutboxOpen_cleanup);
+        }
+    }
+
+    // Recover from the checkpoint
+    if( OutboxReadCheckpoint(outbox_ptr,
+                             &outbox_ptr->sent_offset,
+                             &outbox_ptr->next_nonce,
+                             &outbox_ptr->nonce_valid) != BOAT_TRUE )
+    {
+        outbox_ptr->sent_offset = OUTBOX_HEADER_SIZE;
+    }
+
+    if( outbox_ptr->sent_offset < OUTBOX_HEADER_SIZE || outbox_ptr->sent_offset > file_size )
+    {
+        BoatLog(BOAT_LOG_NORMAL, "Checkpointed offset %llu is out of journal, resend all.",
+                (unsigned long long)outbox_ptr->sent_offset);
+        outbox_ptr->sent_offset = OUTBOX_HEADER_SIZE;
+    }
+
+    // Scan entries not yet sent
+    offset = outbox_ptr->sent_offset;
+    while( offset < file_size )
+    {
+        result = OutboxReadEntry(outbox_ptr->fd, offset, file_size, outbox_ptr->entry_buf_ptr, &tx_len, &nonce);
+        if( result == BOAT_ERROR_EXT_MODULE_OPERATION_FAIL )
+        {
+            boat_throw(result, BoatOutboxOpen_cleanup);
+        }
+        if( result != BOAT_SUCCESS )
+        {
+            BoatLog(BOAT_LOG_NORMAL, "Discard %llu bytes of torn entry at %llu of transaction journal.",
+                    (unsigned long long)(file_size - offset), (unsigned long long)offset);
+
+            if( ftruncate(outbox_ptr->fd, offset) != 0 || fdatasync(outbox_ptr->fd) != 0 )
+            {
+                boat_throw(BOAT_ERROR_EXT_MODULE_OPERATION_FAIL, BoatOutboxOpen_cleanup);
+            }
+            file_size = offset;
+            break;
+        }
+
+        // Entries are appended in nonce order, the one following the last
+        // entry is next
+        outbox_ptr->next_nonce = nonce + 1;
+        outbox_ptr->nonce_valid = BOAT_TRUE;
+
+        outbox_ptr->pending_num++;
+        offset += OUTBOX_ENTRY_HEADER_SIZE + tx_len;
+    }
+    result = BOAT_SUCCESS;
+
+    outbox_ptr->end_offset = file_size;
+    outbox_ptr->synced_offset = file_size;
+    outbox_ptr->synced_nonce = outbox_ptr->next_nonce;
+
+    if( outbox_ptr->pending_num != 0 )
+    {
+        BoatLog(BOAT_LOG_NORMAL, "%u transactions in journal %s to send.", outbox_ptr->pending_num, file_path_str);
+    }
+
+    // Start the flusher. The condition variables use the monotonic clock as BoatGetTimeMs().
+    pthread_condattr_init(&cond_attr);
+    pthread_condattr_setclock(&cond_attr, CLOCK_MONOTONIC);
+    pthread_mutex_init(&outbox_ptr->mutex, NULL);
+    pthread_cond_init(&outbox_ptr->flusher_cond, &cond_attr);
+    pthread_cond_init(&outbox_ptr->drained_cond, &cond_attr);
+    pthread_condattr_destroy(&cond_attr);
+
+    outbox_ptr->running = BOAT_TRUE;
+    if( pthread_create(&outbox_ptr->flusher, NULL, OutboxFlusherMain, outbox_ptr) != 0 )
+    {
+        BoatLog(BOAT_LOG_CRITICAL, "Fail to start outbox flusher.");
+        pthread_cond_destroy(&outbox_ptr->drained_cond);
+        pthread_cond_destroy(&outbox_ptr->flusher_cond);
+        pthread_mutex_destroy(&outbox_ptr->mutex);
+        boat_throw(BOAT_ERROR_EXT_MODULE_OPERATION_FAIL, BoatOutboxOpen_cleanup);
+    }
+
+    boat_catch(BoatOutboxOpen_cleanup)
+    {
+        BoatLog(BOAT_LOG_NORMAL, "Exception: %d", boat_exception);
+
+        if( outbox_ptr->fd >= 0 ) close(outbox_ptr->fd);
+        if( outbox_ptr->ckpt_path_str != NULL ) BoatFree(outbox_ptr->ckpt_path_str);
+        if( outbox_ptr->node_url_str != NULL ) BoatFree(outbox_ptr->node_url_str);
+        if( outbox_ptr->entry_buf_ptr != NULL ) BoatFree(outbox_ptr->entry_buf_ptr);
+        if( outbox_ptr->request_buf_ptr != NULL ) BoatFree(outbox_ptr->request_buf_ptr);
+        memset(outbox_ptr, 0, sizeof(BoatOutbox));
+        outbox_ptr->fd = -1;
+
+        result = boat_exception;
+    }
+
+    return result;
+}
+
+
+/*!*****************************************************************************
+@brief Close a transaction outbox
+
+Function: BoatOutboxClose()
+
+    This function stops the flusher, syncs the journal and saves the
+    checkpoint. Entries not yet sent are kept in the journal and submitted
+    after it's opened again.
+
+@return This function doesn't return any thing.
+
+@param[in] outbox_ptr
+    The outbox opened by BoatOutboxOpen().
+*******************************************************************************/
+void BoatOutboxClose(BoatOutbox *outbox_ptr)
+{
+    if( outbox_ptr == NULL || outbox_ptr->fd < 0 ) return;
+
+    pthread_mutex_lock(&outbox_ptr->mutex);
+    outbox_ptr->running = BOAT_FALSE;
+    pthread_cond_signal(&outbox_ptr->flusher_cond);
+    pthread_cond_broadcast(&outbox_ptr->drained_cond);
+    pthread_mutex_unlock(&outbox_ptr->mutex);
+
+    pthread_join(outbox_ptr->flusher, NULL);
+
+    OutboxSyncLocked(outbox_ptr);
+    OutboxWriteCheckpointLocked(outbox_ptr);
+
+    pthread_cond_destroy(&outbox_ptr->drained_cond);
+    pthread_cond_destroy(&outbox_ptr->flusher_cond);
+    pthread_mutex_destroy(&outbox_ptr->mutex);
+
+    close(outbox_ptr->fd);
+    BoatFree(outbox_ptr->ckpt_path_str);
+    BoatFree(outbox_ptr->node_url_str);
+    BoatFree(outbox_ptr->entry_buf_ptr);
+    BoatFree(outbox_ptr->request_buf_ptr);
+
+    memset(outbox_ptr, 0, sizeof(BoatOutbox));
+    outbox_ptr->fd = -1;
+}
+
+
+/*!*****************************************************************************
+@brief Set the nonce of the next enqueued transaction
+
+Function: BoatOutboxSetNonce()
+
+    A new journal learns the nonce of its first transaction from the node. If
+    the node is not reachable at that time, the caller may set it with this
+    function instead. The nonce is tracked locally afterwards.
+
+@return
+    This function returns BOAT_SUCCESS if successful.\n
+    It returns BOAT_ERROR_INCOMPATIBLE_ARGUMENTS if there are entries not yet
+    sent.
+
+@param[in] outbox_ptr
+    The outbox.
+
+@param[in] nonce
+    The nonce, i.e. transaction count of the account.
+*******************************************************************************/
+BOAT_RESULT BoatOutboxSetNonce(BoatOutbox *outbox_ptr, UINT64 nonce)
+{
+    BOAT_RESULT result = BOAT_SUCCESS;
+
+    if( outbox_ptr == NULL ) return BOAT_ERROR_NULL_POINTER;
+
+    pthread_mutex_lock(&outbox_ptr->mutex);
+
+    if( outbox_ptr->pending_num != 0 )
+    {
+        BoatLog(BOAT_LOG_NORMAL, "Cannot set nonce with %u transactions pending.", outbox_ptr->pending_num);
+        result = BOAT_ERROR_INCOMPATIBLE_ARGUMENTS;
+    }
+    else
+    {
+        outbox_ptr->next_nonce = nonce;
+        outbox_ptr->nonce_valid = BOAT_TRUE;
+        if( outbox_ptr->unsynced_num == 0 ) outbox_ptr->synced_nonce = nonce;
+    }
+
+    pthread_mutex_unlock(&outbox_ptr->mutex);
+
+    return result;
+}
+
+
+// Estimate the size of a signed transaction, whose nonce is assigned later
+static UINT32 OutboxSignSizeEstimate(const BoatTxTemplate *tx_template_ptr, BOAT_INOUT TxInfo *tx_info_ctx_ptr)
+{
+    // Estimate with the longest nonce
+    memset(tx_info_ctx_ptr->rawtx_fields.nonce.field, 0xFF, sizeof(UINT64));
+    tx_info_ctx_ptr->rawtx_fields.nonce.field_len = sizeof(UINT64);
+
+    if( tx_template_ptr == NULL )
+    {
+        return TxRlpStreamSizeEstimate(tx_info_ctx_ptr);
+    }
+    else
+    {
+        return RawtxTemplateSizeEstimate(tx_template_ptr, tx_info_ctx_ptr);
+    }
+}
+
+
+/*!*****************************************************************************
+@brief Sign a transaction of the outbox with the given nonce
+
+Function: OutboxSign()
+
+@return
+    This function returns BOAT_SUCCESS if successful.\n
+    It returns BOAT_ERROR_INVALID_LENGTH if the transaction exceeds
+    BOAT_OUTBOX_MAX_TX_SIZE, or the error code of RawtxSign() or
+    RawtxTemplateSign().
+
+@param[in] boat_wallet_info_ptr
+    The wallet to sign with.
+
+@param[in] tx_template_ptr
+    The transaction template, or NULL to encode all fields of <tx_info_ctx_ptr>.
+
+@param[in,out] tx_info_ctx_ptr
+    The transaction. Its nonce, v and signature are updated.
+
+@param[in] nonce
+    Nonce of the transaction.
+
+@param[out] tx_ptr
+    Buffer of <tx_size> bytes to hold the signed transaction.
+
+@param[in] tx_size
+    Size of <tx_ptr>, as estimated by OutboxSignSizeEstimate().
+
+@param[out] tx_len_ptr
+    Length of the signed transaction.
+*******************************************************************************/
+static BOAT_RESULT OutboxSign(const BoatWalletInfo *boat_wallet_info_ptr,
+                              const BoatTxTemplate *tx_template_ptr,
+                              BOAT_INOUT TxInfo *tx_info_ctx_ptr,
+                              UINT64 nonce,
+                              BOAT_OUT UINT8 *tx_ptr,
+                              UINT32 tx_size,
+                              BOAT_OUT UINT32 *tx_len_ptr)
+{
+    BOAT_RESULT result;
+
+    tx_info_ctx_ptr->rawtx_fields.nonce.field_len =
+        UtilityUint64ToBigend(tx_info_ctx_ptr->rawtx_fields.nonce.field, nonce, TRIMBIN_LEFTTRIM);
+
+    if( tx_template_ptr == NULL )
+    {
+        result = RawtxSign(boat_wallet_info_ptr, tx_info_ctx_ptr, tx_ptr, tx_size, tx_len_ptr);
+    }
+    else
+    {
+        result = RawtxTemplateSign(tx_template_ptr, boat_wallet_info_ptr, tx_info_ctx_ptr, tx_ptr, tx_size, tx_len_ptr);
+    }
+    if( result != BOAT_SUCCESS ) return result;
+
+    if( *tx_len_ptr > BOAT_OUTBOX_MAX_TX_SIZE )
+    {
+        BoatLog(BOAT_LOG_NORMAL, "Transaction of %u bytes exceeds BOAT_OUTBOX_MAX_TX_SIZE.", *tx_len_ptr);
+        return BOAT_ERROR_INVALID_LENGTH;
+    }
+
+    return BOAT_SUCCESS;
+}
+
+
+/*!*****************************************************************************
+@brief Sign a transaction and append it to the outbox
+
+Function: BoatOutboxEnqueue()
+
+    This function assigns the next nonce of the outbox to the transaction,
+    signs it with RawtxSign(), or RawtxTemplateSign() if <tx_template_ptr> is
+    not NULL, and appends it to the journal. It returns without waiting for the
+    transaction being sent.
+
+    Only the first transaction of a new journal needs the node, to get the
+    account's transaction count. See BoatOutboxSetNonce().
+
+    The journal is synced once BOAT_OUTBOX_SYNC_BATCH entries are appended, or
+    by the flusher BOAT_OUTBOX_SYNC_INTERVAL_MS after the oldest of them.
+    Entries not yet synced may be lost in a crash. Call BoatOutboxSync() if a
+    transaction must survive it.
+
+    This function may be called from any thread.
+
+@return
+    This function returns BOAT_SUCCESS if successful.\n
+    It returns BOAT_ERROR_RPC_FAIL if the nonce is unknown and the node is
+    unreachable. Otherwise it returns one of BOAT_ERROR_XXX.
+
+@param[in] outbox_ptr
+    The outbox.
+
+@param[in] boat_wallet_info_ptr
+    The wallet to sign with. It must be the account the outbox is opened for.
+
+@param[in] tx_template_ptr
+    The transaction template, or NULL to encode all fields of <tx_info_ctx_ptr>.
+
+@param[in,out] tx_info_ctx_ptr
+    The transaction. Its nonce, v and signature are updated.
+*******************************************************************************/
+BOAT_RESULT BoatOutboxEnqueue(BoatOutbox *outbox_ptr,
+                              const BoatWalletInfo *boat_wallet_info_ptr,
+                              const BoatTxTemplate *tx_template_ptr,
+                              BOAT_INOUT TxInfo *tx_info_ctx_ptr)
+{
+    UINT8 *entry_ptr = NULL;
+    UINT32 rlp_stream_size_estimate;
+    UINT32 tx_len;
+    UINT64 nonce;
+    BOATBOOL nonce_valid;
+    BOATBOOL locked = BOAT_FALSE;
+
+    BOAT_RESULT result = BOAT_SUCCESS;
+    boat_try_declare;
+
+    if( outbox_ptr == NULL || boat_wallet_info_ptr == NULL || tx_info_ctx_ptr == NULL )
+    {
+        BoatLog(BOAT_LOG_NORMAL, "Arguments cannot be NULL.");
+        boat_throw(BOAT_ERROR_NULL_POINTER, BoatOutboxEnqueue_cleanup);
+    }
+
+    if( memcmp(boat_wallet_info_ptr->account_info.address, outbox_ptr->address, sizeof(BoatAddress)) != 0 )
+    {
+        BoatLog(BOAT_LOG_NORMAL, "The outbox is opened for another account.");
+        boat_throw(BOAT_ERROR_INCOMPATIBLE_ARGUMENTS, BoatOutboxEnqueue_cleanup);
+    }
+
+    rlp_stream_size_estimate = OutboxSignSizeEstimate(tx_template_ptr, tx_info_ctx_ptr);
+    if( rlp_stream_size_estimate == 0 ) boat_throw(BOAT_ERROR_INVALID_LENGTH, BoatOutboxEnqueue_cleanup);
+
+    entry_ptr = BoatMalloc(OUTBOX_ENTRY_HEADER_SIZE + rlp_stream_size_estimate);
+    if( entry_ptr == NULL )
+    {
+        BoatLog(BOAT_LOG_CRITICAL, "Unable to dynamically allocate memory to store RLP stream.");
+        boat_throw(BOAT_ERROR_OUT_OF_MEMORY, BoatOutboxEnqueue_cleanup);
+    }
+
+    pthread_mutex_lock(&outbox_ptr->mutex);
+    nonce_valid = outbox_ptr->nonce_valid;
+    pthread_mutex_unlock(&outbox_ptr->mutex);
+
+    if( nonce_valid != BOAT_TRUE )
+    {
+        result = OutboxFetchNonce(outbox_ptr, &nonce);
+        if( result != BOAT_SUCCESS )
+        {
+            BoatLog(BOAT_LOG_NORMAL, "Nonce of the first transaction is unknown.");
+            boat_throw(BOAT_ERROR_RPC_FAIL, BoatOutboxEnqueue_cleanup);
+        }
+
+        pthread_mutex_lock(&outbox_ptr->mutex);
+        if( outbox_ptr->nonce_valid != BOAT_TRUE )
+        {
+            outbox_ptr->next_nonce = nonce;
+            outbox_ptr->nonce_valid = BOAT_TRUE;
+        }
+        pthread_mutex_unlock(&outbox_ptr->mutex);
+    }
+
+    // Sign and append under the lock, so that entries are in nonce order
+    pthread_mutex_lock(&outbox_ptr->mutex);
+    locked = BOAT_TRUE;
+
+    nonce = outbox_ptr->next_nonce;
+
+    result = OutboxSign(boat_wallet_info_ptr,
+                        tx_template_ptr,
+                        tx_info_ctx_ptr,
+                        nonce,
+                        entry_ptr + OUTBOX_ENTRY_HEADER_SIZE,
+                        rlp_stream_size_estimate,
+                        &tx_len);
+    if( result != BOAT_SUCCESS ) boat_throw(result, BoatOutboxEnqueue_cleanup);
+
+    UtilityUint32ToBigend(entry_ptr, tx_len, TRIMBIN_TRIM_NO);
+    UtilityUint64ToBigend(entry_ptr + 8, nonce, TRIMBIN_TRIM_NO);
+    OutboxEntryChecksum(entry_ptr, entry_ptr + 4);
+
+    result = OutboxPwriteAll(outbox_ptr->fd, entry_ptr, OUTBOX_ENTRY_HEADER_SIZE + tx_len, outbox_ptr->end_offset);
+    if( result != BOAT_SUCCESS )
+    {
+        BoatLog(BOAT_LOG_CRITICAL, "Fail to append to transaction journal.");
+        boat_throw(result, BoatOutboxEnqueue_cleanup);
+    }
+
+    outbox_ptr->end_offset += OUTBOX_ENTRY_HEADER_SIZE + tx_len;
+    outbox_ptr->next_nonce = nonce + 1;
+    outbox_ptr->pending_num++;
+
+    if( outbox_ptr->unsynced_num++ == 0 )
+    {
+        outbox_ptr->oldest_unsynced_ms = BoatGetTimeMs();
+        pthread_cond_signal(&outbox_ptr->flusher_cond);
+    }
+
+    if( outbox_ptr->unsynced_num >= BOAT_OUTBOX_SYNC_BATCH )
+    {
+        result = OutboxSyncLocked(outbox_ptr);
+    }
+
+    boat_catch(BoatOutboxEnqueue_cleanup)
+    {
+        BoatLog(BOAT_LOG_NORMAL, "Exception: %d", boat_exception);
+        result = boat_exception;
+    }
+
+    if( locked == BOAT_TRUE ) pthread_mutex_unlock(&outbox_ptr->mutex);
+    if( entry_ptr != NULL ) BoatFree(entry_ptr);
+
+    return result;
+}
+
+
+/*!*****************************************************************************
+@brief Replace the transaction a stalled outbox stops at
+
+Function: BoatOutboxReplace()
+
+    An outbox stalls when the node rejects an entry BOAT_OUTBOX_MAX_REJECTS
+    times, e.g. for an underpriced gas or a balance too low, as later entries
+    can't be mined without its nonce. See BoatOutboxGetStats().
+
+    This function signs <tx_info_ctx_ptr> with the stalled nonce, e.g. the
+    same transaction with a higher gas price or an empty transfer to the sender
+    itself just to take the nonce, and submits it at once. If the node accepts
+    it, the rejected entry is skipped and the flusher resumes with the next.
+
+    After a restart, the rejected entry may be submitted and rejected again
+    if the checkpoint was lost, which stalls the outbox again.
+
+@return
+    This function returns BOAT_SUCCESS if the replacement is accepted.\n
+    It returns BOAT_ERROR_INCOMPATIBLE_ARGUMENTS if the outbox isn't stalled,
+    BOAT_ERROR_RPC_NODE_ERROR if the node rejects the replacement, or
+    BOAT_ERROR_RPC_FAIL if the node is unreachable. The outbox stays stalled
+    on any error.
+
+@param[in] outbox_ptr
+    The outbox.
+
+@param[in] boat_wallet_info_ptr
+    The wallet to sign with. It must be the account the outbox is opened for.
+
+@param[in] tx_template_ptr
+    The transaction template, or NULL to encode all fields of <tx_info_ctx_ptr>.
+
+@param[in,out] tx_info_ctx_ptr
+    The replacing transaction. Its nonce, v and signature are updated.
+*******************************************************************************/
+BOAT_RESULT BoatOutboxReplace(BoatOutbox *outbox_ptr,
+                              const BoatWalletInfo *boat_wallet_info_ptr,
+                              const BoatTxTemplate *tx_template_ptr,
+                              BOAT_INOUT TxInfo *tx_info_ctx_ptr)
+{
+    UINT8 *tx_ptr = NULL;
+    CHAR *request_str = NULL;
+    UINT32 rlp_stream_size_estimate;
+    UINT32 tx_len;
+    UINT64 nonce;
+    BOATBOOL stalled;
+    OutboxSubmitStatus status;
+
+    BOAT_RESULT result = BOAT_SUCCESS;
+    boat_try_declare;
+
+    if( outbox_ptr == NULL || boat_wallet_info_ptr == NULL || tx_info_ctx_ptr == NULL )
+    {
+        BoatLog(BOAT_LOG_NORMAL, "Arguments cannot be NULL.");
+        boat_throw(BOAT_ERROR_NULL_POINTER, BoatOutboxReplace_cleanup);
+    }
+
+    if( memcmp(boat_wallet_info_ptr->account_info.address, outbox_ptr->address, sizeof(BoatAddress)) != 0 )
+    {
+        BoatLog(BOAT_LOG_NORMAL, "The outbox is opened for another account.");
+        boat_throw(BOAT_ERROR_INCOMPATIBLE_ARGUMENTS, BoatOutboxReplace_cleanup);
+    }
+
+    // The flusher submits nothing while stalled, so the nonce can't change until resumed here
+    pthread_mutex_lock(&outbox_ptr->mutex);
+    stalled = outbox_ptr->stalled;
+    nonce = outbox_ptr->stalled_nonce;
+    pthread_mutex_unlock(&outbox_ptr->mutex);
+
+    if( stalled != BOAT_TRUE )
+    {
+        BoatLog(BOAT_LOG_NORMAL, "The outbox is not stalled.");
+        boat_throw(BOAT_ERROR_INCOMPATIBLE_ARGUMENTS, BoatOutboxReplace_cleanup);
+    }
+
+    rlp_stream_size_estimate = OutboxSignSizeEstimate(tx_template_ptr, tx_info_ctx_ptr);
+    if( rlp_stream_size_estimate == 0 ) boat_throw(BOAT_ERROR_INVALID_LENGTH, BoatOutboxReplace_cleanup);
+
+    tx_ptr = BoatMalloc(rlp_stream_size_estimate);
+    request_str = BoatMalloc(OUTBOX_REQUEST_BUF_SIZE);
+    if( tx_ptr == NULL || request_str == NULL )
+    {
+        BoatLog(BOAT_LOG_CRITICAL, "Fail to allocate memory.");
+        boat_throw(BOAT_ERROR_OUT_OF_MEMORY, BoatOutboxReplace_cleanup);
+    }
+
+    result = OutboxSign(boat_wallet_info_ptr,
+                        tx_template_ptr,
+                        tx_info_ctx_ptr,
+                        nonce,
+                        tx_ptr,
+                        rlp_stream_size_estimate,
+                        &tx_len);
+    if( result != BOAT_SUCCESS ) boat_throw(result, BoatOutboxReplace_cleanup);
+
+    result = OutboxSubmitSend(outbox_ptr, request_str, tx_ptr, tx_len, nonce);
+    if( result != BOAT_SUCCESS ) boat_throw(BOAT_ERROR_RPC_FAIL, BoatOutboxReplace_cleanup);
+
+    status = OutboxSubmitRecv(nonce);
+    if( status == OUTBOX_SUBMIT_REJECTED ) boat_throw(BOAT_ERROR_RPC_NODE_ERROR, BoatOutboxReplace_cleanup);
+    if( status == OUTBOX_SUBMIT_RETRY ) boat_throw(BOAT_ERROR_RPC_FAIL, BoatOutboxReplace_cleanup);
+
+    BoatLog(BOAT_LOG_NORMAL, "Transaction of nonce %llu is replaced, the outbox resumes.", (unsigned long long)nonce);
+
+    pthread_mutex_lock(&outbox_ptr->mutex);
+
+    outbox_ptr->sent_offset = outbox_ptr->stalled_end_offset;
+    outbox_ptr->pending_num--;
+    outbox_ptr->sent_num++;
+    outbox_ptr->unsaved_num++;
+    outbox_ptr->reject_num = 0;
+    outbox_ptr->backoff_ms = 0;
+    outbox_ptr->retry_at_ms = 0;
+    outbox_ptr->stalled = BOAT_FALSE;
+
+    // Save at once, so that the rejected entry isn't submitted again after a restart
+    OutboxWriteCheckpointLocked(outbox_ptr);
+
+    pthread_cond_signal(&outbox_ptr->flusher_cond);
+    pthread_mutex_unlock(&outbox_ptr->mutex);
+
+    boat_catch(BoatOutboxReplace_cleanup)
+    {
+        BoatLog(BOAT_LOG_NORMAL, "Exception: %d", boat_exception);
+        result = boat_exception;
+    }
+
+    if( tx_ptr != NULL ) BoatFree(tx_ptr);
+    if( request_str != NULL ) BoatFree(request_str);
+
+    return result;
+}
+
+
+/*!*****************************************************************************
+@brief Make all enqueued transactions durable
+
+Function: BoatOutboxSync()
+
+@return
+    This function returns BOAT_SUCCESS if successful. Otherwise it returns
+    BOAT_ERROR_EXT_MODULE_OPERATION_FAIL.
+
+@param[in] outbox_ptr
+    The outbox.
+*******************************************************************************/
+BOAT_RESULT BoatOutboxSync(BoatOutbox *outbox_ptr)
+{
+    BOAT_RESULT result;
+
+    if( outbox_ptr == NULL ) return BOAT_ERROR_NULL_POINTER;
+
+    pthread_mutex_lock(&outbox_ptr->mutex);
+    result = OutboxSyncLocked(outbox_ptr);
+    pthread_mutex_unlock(&outbox_ptr->mutex);
+
+    return result;
+}
+
+
+/*!*****************************************************************************
+@brief Wait until all enqueued transactions are sent
+
+Function: BoatOutboxWaitDrained()
+
+    This function asks the flusher to sync pending entries at once and waits
+    until the node has all of them, i.e. they are accepted by the node but not
+    necessarily mined.
+
+@return
+    This function returns BOAT_SUCCESS if the outbox is drained. It returns
+    BOAT_ERROR_RPC_NODE_ERROR at once if the outbox is stalled by a rejected
+    entry (see BoatOutboxReplace()), or BOAT_ERROR on timeout.
+
+@param[in] outbox_ptr
+    The outbox.
+
+@param[in] timeout_ms
+    Maximum time to wait in millisecond.
+*******************************************************************************/
+BOAT_RESULT BoatOutboxWaitDrained(BoatOutbox *outbox_ptr, UINT32 timeout_ms)
+{
+    struct timespec deadline;
+    BOAT_RESULT result;
+
+    if( outbox_ptr == NULL ) return BOAT_ERROR_NULL_POINTER;
+
+    OutboxDeadline(&deadline, BoatGetTimeMs() + timeout_ms);
+
+    pthread_mutex_lock(&outbox_ptr->mutex);
+
+    outbox_ptr->sync_requested = BOAT_TRUE;
+    pthread_cond_signal(&outbox_ptr->flusher_cond);
+
+    while(    outbox_ptr->pending_num != 0
+           && outbox_ptr->stalled == BOAT_FALSE
+           && outbox_ptr->running == BOAT_TRUE )
+    {
+        if( pthread_cond_timedwait(&outbox_ptr->drained_cond, &outbox_ptr->mutex, &deadline) == ETIMEDOUT )
+        {
+            break;
+        }
+    }
+
+    if( outbox_ptr->pending_num == 0 )
+    {
+        result = BOAT_SUCCESS;
+    }
+    else if( outbox_ptr->stalled == BOAT_TRUE )
+    {
+        result = BOAT_ERROR_RPC_NODE_ERROR;
+    }
+    else
+    {
+        result = BOAT_ERROR;
+    }
+
+    pthread_mutex_unlock(&outbox_ptr->mutex);
+
+    return result;
+}
+
+
+/*!*****************************************************************************
+@brief Get statistics of an outbox
+
+Function: BoatOutboxGetStats()
+
+@return This function doesn't return any thing.
+
+@param[in] outbox_ptr
+    The outbox.
+
+@param[out] stats_ptr
+    The statistics.
+*******************************************************************************/
+void BoatOutboxGetStats(BoatOutbox *outbox_ptr, BOAT_OUT BoatOutboxStats *stats_ptr)
+{
+    if( outbox_ptr == NULL || stats_ptr == NULL ) return;
+
+    pthread_mutex_lock(&outbox_ptr->mutex);
+
+    stats_ptr->pending = outbox_ptr->pending_num;
+    stats_ptr->sent = outbox_ptr->sent_num;
+    stats_ptr->failures = outbox_ptr->failure_num;
+    stats_ptr->next_nonce = (outbox_ptr->nonce_valid == BOAT_TRUE) ? outbox_ptr->next_nonce : 0;
+    stats_ptr->stalled = outbox_ptr->stalled;
+    stats_ptr->stalled_nonce = (outbox_ptr->stalled == BOAT_TRUE) ? outbox_ptr->stalled_nonce : 0;
+
+    pthread_mutex_unlock(&outbox_ptr->mutex);
+}
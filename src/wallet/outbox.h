@@ -0,0 +1,142 @@
+/******************************************************************************
+Copyright (C) 2018-2019 AITOS.IO
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+of the Software, and to permit persons to whom the Software is furnished to do
+so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+******************************************************************************/
+
+/*!@brief Persistent transaction journal and store-and-forward outbox
+
+@file
+outbox.h is header file for the transaction outbox.
+
+Transactions enqueued to an outbox are signed immediately with a locally
+tracked nonce and appended to an on-disk journal. A background flusher
+submits them to the node in nonce order whenever it's reachable, so that the
+caller never blocks on the network.
+
+The journal is an append-only file:
+@verbatim
+Header:  "BOXL" | version (1) | reserved (3) | sender address (20)
+Entry:   length BE4 | checksum BE4 | nonce BE8 | signed raw transaction (length)
+@endverbatim
+where checksum is the first 4 bytes of keccak_256(nonce BE8 | transaction).
+
+Progress of the flusher is saved in "<journal>.ckpt" from time to time. After
+a crash, entries from the checkpointed offset on are re-submitted. Those the
+node already has are reported as "nonce too low" or "already known" and are
+treated as sent. A torn entry at the tail of the journal is discarded.
+
+An entry rejected BOAT_OUTBOX_MAX_REJECTS times stalls the outbox, as later
+entries can't be mined without its nonce. The flusher stops until the caller
+re-signs that nonce with BoatOutboxReplace().
+*/
+
+#ifndef __OUTBOX_H__
+#define __OUTBOX_H__
+
+#include "wallet/boattypes.h"
+#include "wallet/rawtx.h"
+
+#include <pthread.h>
+
+//!@brief Store-and-forward outbox of signed transactions
+typedef struct TBoatOutbox
+{
+    int fd;                         //!< File descriptor of the journal
+    CHAR *ckpt_path_str;            //!< Path of the checkpoint file
+    CHAR *node_url_str;             //!< URL of the blockchain node, copied from the wallet
+    BoatAddress address;            //!< Sender of all transactions in the journal
+    UINT8 *entry_buf_ptr;           //!< Flusher's buffer to read an entry
+    CHAR *request_buf_ptr;          //!< Flusher's buffer to construct a request
+
+    pthread_t flusher;              //!< Flusher thread
+    pthread_mutex_t mutex;          //!< Protects all fields below
+    pthread_cond_t flusher_cond;    //!< Wakes up the flusher
+    pthread_cond_t drained_cond;    //!< Signaled when all entries are sent
+    BOATBOOL running;               //!< BOAT_FALSE to stop the flusher
+
+    UINT64 end_offset;              //!< Offset to append next entry at
+    UINT64 synced_offset;           //!< Entries before this offset are durable
+    UINT64 sent_offset;             //!< Entries before this offset are sent
+    UINT64 oldest_unsynced_ms;      //!< Time the oldest not yet durable entry was appended
+    UINT32 unsynced_num;            //!< Number of entries not yet durable
+    BOATBOOL sync_requested;        //!< BOAT_TRUE to sync without waiting for BOAT_OUTBOX_SYNC_INTERVAL_MS
+
+    UINT64 next_nonce;              //!< Nonce of the next enqueued transaction
+    UINT64 synced_nonce;            //!< Nonce following the last durable entry
+    BOATBOOL nonce_valid;           //!< BOAT_FALSE until <next_nonce> is known
+
+    UINT32 pending_num;             //!< Number of entries not yet sent
+    UINT32 unsaved_num;             //!< Number of entries sent since last checkpoint
+    UINT32 reject_num;              //!< Times the node rejected the current entry
+    UINT32 backoff_ms;              //!< Current retry interval, 0 if the last submission succeeded
+    UINT64 retry_at_ms;             //!< Time the flusher may retry the current entry
+    BOATBOOL stalled;               //!< BOAT_TRUE if the current entry is rejected BOAT_OUTBOX_MAX_REJECTS times
+    UINT64 stalled_nonce;           //!< Nonce of the current entry if stalled
+    UINT64 stalled_end_offset;      //!< Offset following the current entry if stalled
+
+    UINT32 sent_num;                //!< Statistics, see BoatOutboxStats
+    UINT32 failure_num;
+}BoatOutbox;
+
+//!@brief Statistics of an outbox
+typedef struct TBoatOutboxStats
+{
+    UINT32 pending;         //!< Entries in the journal not yet sent
+    UINT32 sent;            //!< Entries accepted by the node since opened
+    UINT32 failures;        //!< Submissions failed because the node was unreachable
+    UINT64 next_nonce;      //!< Nonce of the next enqueued transaction, 0 if not yet known
+    BOATBOOL stalled;       //!< BOAT_TRUE if stopped at an entry rejected BOAT_OUTBOX_MAX_REJECTS times
+    UINT64 stalled_nonce;   //!< Nonce to re-sign with BoatOutboxReplace() if stalled
+}BoatOutboxStats;
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+BOAT_RESULT BoatOutboxOpen(BOAT_OUT BoatOutbox *outbox_ptr,
+                           const CHAR *file_path_str,
+                           const BoatWalletInfo *boat_wallet_info_ptr);
+
+void BoatOutboxClose(BoatOutbox *outbox_ptr);
+
+BOAT_RESULT BoatOutboxSetNonce(BoatOutbox *outbox_ptr, UINT64 nonce);
+
+BOAT_RESULT BoatOutboxEnqueue(BoatOutbox *outbox_ptr,
+                              const BoatWalletInfo *boat_wallet_info_ptr,
+                              const BoatTxTemplate *tx_template_ptr,
+                              BOAT_INOUT TxInfo *tx_info_ctx_ptr);
+
+BOAT_RESULT BoatOutboxReplace(BoatOutbox *outbox_ptr,
+                              const BoatWalletInfo *boat_wallet_info_ptr,
+                              const BoatTxTemplate *tx_template_ptr,
+                              BOAT_INOUT TxInfo *tx_info_ctx_ptr);
+
+BOAT_RESULT BoatOutboxSync(BoatOutbox *outbox_ptr);
+
+BOAT_RESULT BoatOutboxWaitDrained(BoatOutbox *outbox_ptr, UINT32 timeout_ms);
+
+void BoatOutboxGetStats(BoatOutbox *outbox_ptr, BOAT_OUT BoatOutboxStats *stats_ptr);
+
+#ifdef __cplusplus
+}
+#endif /* end of __cplusplus */
+
+#endif
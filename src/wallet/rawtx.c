@@ -34,6 +34,9 @@ perform it and wait for its receipt.
 #include "wallet/rawtx.h"
 
 
+//! Bytes reserved before the encoded fields for the outer LIST header
+#define RLP_STREAM_RESERVE_HEADER 9
+
 
 
 /*!*****************************************************************************
@@ -382,258 +385,58 @@ UINT32 TxRlpStreamSizeEstimate(TxInfo *tx_info_ctx_ptr)
 
 
 /*!*****************************************************************************
-@brief Construct a raw transacton and encodes it as per RLP rules.
-
-Function: RawtxPerform()
-
-    This function constructs a raw transacton and encodes it as per RLP rules.
-    
-    AN INTRODUCTION OF HOW RAW TRANSACTION IS CONSTRUCTED
-    
-    [FIELDS IN A RAW TRANSACTION]
-    
-    A RAW transaction consists of following 9 fields:
-        1. nonce;
-        2. gasprice;
-        3. gaslimit;
-        4. recipient;
-        5. value(optional);
-        6. data(optional);
-        7. v;
-        8. signature.r;
-        9. signature.s;
-
-    These transaction fields are encoded as elements of a LIST in above order
-    as per RLP encoding rules. "LIST" is a type of RLP field.
-
-
-    EXCEPTION:
-    
-    For Ethereum any fields (except <recipient>) having a value of zero are
-    treated as NULL stream in RLP encoding instead of 1-byte-size stream whose
-    value is 0. For example, nonce = 0 is encoded as 0x80 which represents NULL
-    instead of 0x00 which represents a 1-byte-size stream whose value is 0.
+@brief Hash and sign an RLP encoded raw transaction, then re-encode v/r/s.
 
+Function: RawtxSignEncoded()
 
-    [HOW TO CONSTRUCT A RAW TRANSACTION]
-    
-    A RAW transaction is constructed in 4 steps in different ways according to
-    the blockchain network's EIP-155 compatibility. 
-
-    See following article for details about EIP-155: 
-    https://github.com/ethereum/EIPs/blob/master/EIPS/eip-155.md
-
-    
-    CASE 1: If the blockchain network does NOT support EIP-155:
-    
-        Step 1: Encode a LIST containing only the first 6 fields.
-        Step 2: Calculate SHA3 hash of the encoded stream in Step 1.
-        Step 3: Sign the hash in Step 2. This generates r, s and parity (0 or 1) for recovery identifier.
-        Step 4: Encode a LIST containing all 9 fields, where
-                First 6 fields are same as what they are;
-                v = parity + 27, where parity is given in Step 3;
-                r and s are given in Step 3.
-
-
-    CASE 2: If the blockchain network DOES support EIP-155:
-
-        Step 1: Encode all 9 fields (a LIST containing all 9 fields), where
-                First 6 fields are same as what they are;
-                v = Chain ID;
-                r = 0;
-                s = 0;
-
-                NOTE: zero value fields other than <recipient> are encoded as NULL stream.
-
-        Step 2: Same as CASE 1.
-        Step 3: Same as CASE 1.
-
-        Step 4: Encode a LIST containing all 9 fields, where
-                First 6 fields are same as what they are;
-                v = Chain ID * 2 + parity + 35, where parity is given in Step 3;
-                r and s are given in Step 3.
+    This function performs Step 2 ~ 4 described in RawtxPerform() on a raw
+    transaction whose fields have been encoded in Step 1.
 
+    The encoded fields MUST start at <rlp_stream_ptr> + RLP_STREAM_RESERVE_HEADER,
+    with the outer LIST header not encoded yet. On return the signed RLP stream
+    is moved to the beginning of <rlp_stream_ptr>.
 
 @return
     This function returns BOAT_SUCCESS if successful. Otherwise it returns BOAT_ERROR.
-    
 
 @param[in] boat_wallet_info_ptr
         A pointer to wallet infor structure.
 
 @param[in] tx_info_ctx_ptr
-        A pointer to the context of the transaction.
+        A pointer to the context of the transaction. Its v and sig fields are
+        updated.
+
+@param[in] rlp_stream_ptr
+        Buffer holding the encoded fields.
+
+@param[in] rlp_stream_v_position_ptr
+        Position of v, i.e. the byte immediately after the encoded data field.
+
+@param[in] rlp_stream_end_ptr
+        The byte immediately after the last encoded field.
+
+@param[out] rlp_stream_len_ptr
+        Length of the signed RLP stream in byte.
 
 *******************************************************************************/
-BOAT_RESULT RawtxPerform(BoatWalletInfo *boat_wallet_info_ptr, BOAT_INOUT TxInfo *tx_info_ctx_ptr)
+static BOAT_RESULT RawtxSignEncoded(const BoatWalletInfo *boat_wallet_info_ptr,
+                                    BOAT_INOUT TxInfo *tx_info_ctx_ptr,
+                                    UINT8 *rlp_stream_ptr,
+                                    UINT8 *rlp_stream_v_position_ptr,
+                                    UINT8 *rlp_stream_end_ptr,
+                                    BOAT_OUT UINT32 *rlp_stream_len_ptr)
 {
     unsigned int chain_id_len;
-        
-    CHAR *tx_hash_str;
-    CHAR tx_hash[67];
-    CHAR *tx_status_str;
-
-    
-    #define RLP_STREAM_RESERVE_HEADER 9
-    UINT32 rlp_stream_size_estimate;
-    CHAR *rlp_stream_hex_str = NULL;    // Storage for RLP stream HEX string for use with web3 interface
-    UINT8 *rlp_stream_start_position_ptr = NULL; // Point to storeage of RLP stream binary
-    UINT8 *rlp_stream_current_position_ptr;
-    UINT8 *rlp_stream_v_position_ptr;
+    UINT8 *rlp_stream_start_position_ptr = rlp_stream_ptr;
+    UINT8 *rlp_stream_current_position_ptr = rlp_stream_end_ptr;
     UINT32 message_len;
     UINT8 message_digest[32];
     UINT8 sig_parity;
     UINT32 v;
 
-    Param_eth_sendRawTransaction param_eth_sendRawTransaction;
-    Param_eth_getTransactionReceipt param_eth_getTransactionReceipt;
-    SINT32 tx_mined_timeout;
-    
-    BOAT_RESULT result;
+    BOAT_RESULT result = BOAT_SUCCESS;
     boat_try_declare;
 
-
-    if( boat_wallet_info_ptr == NULL )
-    {
-        BoatLog(BOAT_LOG_NORMAL, "<boat_wallet_info_ptr> cannot be null.");
-        boat_throw(BOAT_ERROR_NULL_POINTER, RawtxPerform_cleanup);
-    }
-    
-    if( tx_info_ctx_ptr == NULL )
-    {
-        BoatLog(BOAT_LOG_NORMAL, "<tx_info_ctx_ptr> cannot be null.");
-        boat_throw(BOAT_ERROR_NULL_POINTER, RawtxPerform_cleanup);
-    }
-    
-    rlp_stream_size_estimate = TxRlpStreamSizeEstimate(tx_info_ctx_ptr);
-
-    // Allocate memory for RLP stream binary
-    rlp_stream_start_position_ptr = BoatMalloc(rlp_stream_size_estimate);
-    
-    if( rlp_stream_start_position_ptr == NULL )
-    {
-        BoatLog(BOAT_LOG_CRITICAL, "Unable to dynamically allocate memory to store RLP stream.");
-        boat_throw(BOAT_ERROR_OUT_OF_MEMORY, RawtxPerform_cleanup);
-    }
-
-    // Allocate memory for RLP stream HEX string
-    // It's a storage for HEX string converted from RLP stream binary. The
-    // HEX string is used as input for web3. It's in a form of "0x1234ABCD".
-    // Where *2 for binary to HEX conversion, +2 for "0x" prefix, + 1 for null terminator.
-    rlp_stream_hex_str = BoatMalloc(rlp_stream_size_estimate * 2 + 2 + 1);
-
-    if( rlp_stream_hex_str == NULL )
-    {
-        BoatLog(BOAT_LOG_CRITICAL, "Unable to dynamically allocate memory to store RLP HEX string.");
-        boat_throw(BOAT_ERROR_OUT_OF_MEMORY, RawtxPerform_cleanup);
-    }
-    
-
-    /**************************************************************************
-    * STEP 1: Construction RAW transaction without real v/r/s                 *
-    *         (See above description for details)                             *
-    **************************************************************************/
-    
-    // Reserve first 9 bytes for outer LIST's RLP header
-    rlp_stream_current_position_ptr = rlp_stream_start_position_ptr + RLP_STREAM_RESERVE_HEADER;
-
-    // Encode nonce
-    rlp_stream_current_position_ptr = RlpFieldEncode( rlp_stream_current_position_ptr,
-                                              tx_info_ctx_ptr->rawtx_fields.nonce.field,
-                                              tx_info_ctx_ptr->rawtx_fields.nonce.field_len,
-                                              RLP_FIELD_TYPE_STRING,
-                                              BOAT_FALSE);
-    if( rlp_stream_current_position_ptr == NULL )  boat_throw(BOAT_ERROR_RLP_ENCODING_FAIL, RawtxPerform_cleanup);
-
-    // Encode gasprice
-    rlp_stream_current_position_ptr = RlpFieldEncode( rlp_stream_current_position_ptr,
-                                              tx_info_ctx_ptr->rawtx_fields.gasprice.field,
-                                              tx_info_ctx_ptr->rawtx_fields.gasprice.field_len,
-                                              RLP_FIELD_TYPE_STRING,
-                                              BOAT_FALSE);
-    if( rlp_stream_current_position_ptr == NULL )  boat_throw(BOAT_ERROR_RLP_ENCODING_FAIL, RawtxPerform_cleanup);
-    
-    // Encode gaslimit
-    rlp_stream_current_position_ptr = RlpFieldEncode( rlp_stream_current_position_ptr,
-                                              tx_info_ctx_ptr->rawtx_fields.gaslimit.field,
-                                              tx_info_ctx_ptr->rawtx_fields.gaslimit.field_len,
-                                              RLP_FIELD_TYPE_STRING,
-                                              BOAT_FALSE);
-    if( rlp_stream_current_position_ptr == NULL )  boat_throw(BOAT_ERROR_RLP_ENCODING_FAIL, RawtxPerform_cleanup);
-    
-    // Encode recipient
-    rlp_stream_current_position_ptr = RlpFieldEncode( rlp_stream_current_position_ptr,
-                                              tx_info_ctx_ptr->rawtx_fields.recipient,
-                                              20,
-                                              RLP_FIELD_TYPE_STRING,
-                                              BOAT_FALSE);
-    if( rlp_stream_current_position_ptr == NULL )  boat_throw(BOAT_ERROR_RLP_ENCODING_FAIL, RawtxPerform_cleanup);
-
-    // Encode value
-    rlp_stream_current_position_ptr = RlpFieldEncode( rlp_stream_current_position_ptr,
-                                              tx_info_ctx_ptr->rawtx_fields.value.field,
-                                              tx_info_ctx_ptr->rawtx_fields.value.field_len,
-                                              RLP_FIELD_TYPE_STRING,
-                                              BOAT_FALSE);
-    if( rlp_stream_current_position_ptr == NULL )  boat_throw(BOAT_ERROR_RLP_ENCODING_FAIL, RawtxPerform_cleanup);
-
-    // Encode data
-    rlp_stream_current_position_ptr = RlpFieldEncode( rlp_stream_current_position_ptr,
-                                              tx_info_ctx_ptr->rawtx_fields.data.field_ptr,
-                                              tx_info_ctx_ptr->rawtx_fields.data.field_len,
-                                              RLP_FIELD_TYPE_STRING,
-                                              BOAT_FALSE);
-    if( rlp_stream_current_position_ptr == NULL )  boat_throw(BOAT_ERROR_RLP_ENCODING_FAIL, RawtxPerform_cleanup);
-
-
-    // Record the position of "v" for use in Step 4
-    rlp_stream_v_position_ptr = rlp_stream_current_position_ptr;
-
-
-    // If EIP-155 is required, encode v = chain id, r = s = NULL in this step
-    if( boat_wallet_info_ptr->network_info.eip155_compatibility == BOAT_TRUE )
-    {
-        // v = Chain ID
-        // Currently max chain id supported is (2^32 - 1 - 36)/2, because v is
-        // finally calculated as chain_id * 2 + 35 or 36 as per EIP-155.
-        v = boat_wallet_info_ptr->network_info.chain_id;
-        chain_id_len = UtilityUint32ToBigend(tx_info_ctx_ptr->rawtx_fields.v.field,
-                                             v,
-                                             TRIMBIN_LEFTTRIM
-                                            );
-        tx_info_ctx_ptr->rawtx_fields.v.field_len = chain_id_len;
-        
-        // r = s = NULL
-        tx_info_ctx_ptr->rawtx_fields.sig.r_len = 0;
-        tx_info_ctx_ptr->rawtx_fields.sig.s_len = 0;
-
-
-        // Encode v
-        rlp_stream_current_position_ptr = RlpFieldEncode( rlp_stream_current_position_ptr,
-                                                  tx_info_ctx_ptr->rawtx_fields.v.field,
-                                                  tx_info_ctx_ptr->rawtx_fields.v.field_len,
-                                                  RLP_FIELD_TYPE_STRING,
-                                                  BOAT_FALSE);
-        if( rlp_stream_current_position_ptr == NULL )  boat_throw(BOAT_ERROR_RLP_ENCODING_FAIL, RawtxPerform_cleanup);
-
-        // Encode r
-        rlp_stream_current_position_ptr = RlpFieldEncode( rlp_stream_current_position_ptr,
-                                                  tx_info_ctx_ptr->rawtx_fields.sig.r32B,
-                                                  tx_info_ctx_ptr->rawtx_fields.sig.r_len,
-                                                  RLP_FIELD_TYPE_STRING,
-                                                  BOAT_FALSE);
-        if( rlp_stream_current_position_ptr == NULL )  boat_throw(BOAT_ERROR_RLP_ENCODING_FAIL, RawtxPerform_cleanup);
-
-        // Encode s
-        rlp_stream_current_position_ptr = RlpFieldEncode( rlp_stream_current_position_ptr,
-                                                  tx_info_ctx_ptr->rawtx_fields.sig.s32B,
-                                                  tx_info_ctx_ptr->rawtx_fields.sig.s_len,
-                                                  RLP_FIELD_TYPE_STRING,
-                                                  BOAT_FALSE);
-        if( rlp_stream_current_position_ptr == NULL )  boat_throw(BOAT_ERROR_RLP_ENCODING_FAIL, RawtxPerform_cleanup);
-
-    }
-
     // Encode LIST header
     message_len = (UINT32)(rlp_stream_current_position_ptr - (rlp_stream_start_position_ptr + 9));
     rlp_stream_current_position_ptr = RlpFieldEncode( NULL,
@@ -641,7 +444,7 @@ BOAT_RESULT RawtxPerform(BoatWalletInfo *boat_wallet_info_ptr, BOAT_INOUT TxInfo
                                                       message_len,
                                                       RLP_FIELD_TYPE_LIST,
                                                       BOAT_TRUE);
-    if( rlp_stream_current_position_ptr == NULL )  boat_throw(BOAT_ERROR_RLP_ENCODING_FAIL, RawtxPerform_cleanup);
+    if( rlp_stream_current_position_ptr == NULL )  boat_throw(BOAT_ERROR_RLP_ENCODING_FAIL, RawtxSignEncoded_cleanup);
 
     message_len += (UINT32)(rlp_stream_start_position_ptr + RLP_STREAM_RESERVE_HEADER - rlp_stream_current_position_ptr);
 
@@ -732,7 +535,7 @@ BOAT_RESULT RawtxPerform(BoatWalletInfo *boat_wallet_info_ptr, BOAT_INOUT TxInfo
                                               tx_info_ctx_ptr->rawtx_fields.v.field_len,
                                               RLP_FIELD_TYPE_STRING,
                                               BOAT_FALSE);
-    if( rlp_stream_current_position_ptr == NULL )  boat_throw(BOAT_ERROR_RLP_ENCODING_FAIL, RawtxPerform_cleanup);
+    if( rlp_stream_current_position_ptr == NULL )  boat_throw(BOAT_ERROR_RLP_ENCODING_FAIL, RawtxSignEncoded_cleanup);
 
 
     // Re-encode r
@@ -741,7 +544,7 @@ BOAT_RESULT RawtxPerform(BoatWalletInfo *boat_wallet_info_ptr, BOAT_INOUT TxInfo
                                               tx_info_ctx_ptr->rawtx_fields.sig.r_len,
                                               RLP_FIELD_TYPE_STRING,
                                               BOAT_FALSE);
-    if( rlp_stream_current_position_ptr == NULL )  boat_throw(BOAT_ERROR_RLP_ENCODING_FAIL, RawtxPerform_cleanup);
+    if( rlp_stream_current_position_ptr == NULL )  boat_throw(BOAT_ERROR_RLP_ENCODING_FAIL, RawtxSignEncoded_cleanup);
 
     // Re-encode s
     rlp_stream_current_position_ptr = RlpFieldEncode( rlp_stream_current_position_ptr,
@@ -749,7 +552,7 @@ BOAT_RESULT RawtxPerform(BoatWalletInfo *boat_wallet_info_ptr, BOAT_INOUT TxInfo
                                               tx_info_ctx_ptr->rawtx_fields.sig.s_len,
                                               RLP_FIELD_TYPE_STRING,
                                               BOAT_FALSE);
-    if( rlp_stream_current_position_ptr == NULL )  boat_throw(BOAT_ERROR_RLP_ENCODING_FAIL, RawtxPerform_cleanup);
+    if( rlp_stream_current_position_ptr == NULL )  boat_throw(BOAT_ERROR_RLP_ENCODING_FAIL, RawtxSignEncoded_cleanup);
 
 
     // Re-encode LIST header
@@ -759,52 +562,673 @@ BOAT_RESULT RawtxPerform(BoatWalletInfo *boat_wallet_info_ptr, BOAT_INOUT TxInfo
                                                       message_len,
                                                       RLP_FIELD_TYPE_LIST,
                                                       BOAT_TRUE);
-    if( rlp_stream_current_position_ptr == NULL )  boat_throw(BOAT_ERROR_RLP_ENCODING_FAIL, RawtxPerform_cleanup);
+    if( rlp_stream_current_position_ptr == NULL )  boat_throw(BOAT_ERROR_RLP_ENCODING_FAIL, RawtxSignEncoded_cleanup);
 
     message_len += (UINT32)(rlp_stream_start_position_ptr + RLP_STREAM_RESERVE_HEADER - rlp_stream_current_position_ptr);
 
 
+    // Move the signed RLP stream to the beginning of the buffer
+    memmove(rlp_stream_ptr, rlp_stream_current_position_ptr, message_len);
+    *rlp_stream_len_ptr = message_len;
 
-    // Print transaction recipient to log
-
-    if( 0 == UtilityBin2Hex(
-        rlp_stream_hex_str,
-        tx_info_ctx_ptr->rawtx_fields.recipient,
-        20,
-        BIN2HEX_LEFTTRIM_UFMTDATA,
-        BIN2HEX_PREFIX_0x_YES,
-        BOAT_FALSE
-        ))
+    boat_catch(RawtxSignEncoded_cleanup)
     {
-        strcpy(rlp_stream_hex_str, "NULL");
+        BoatLog(BOAT_LOG_NORMAL, "Exception: %d", boat_exception);
+        result = boat_exception;
     }
 
-    BoatLog(BOAT_LOG_NORMAL, "Transaction to: %s", rlp_stream_hex_str);
+    memset(message_digest, 0, sizeof(message_digest));
 
-#ifdef DEBUG_LOG
+    return result;
+}
 
-    // To save memory, re-use rlp_stream_hex_str to print debug information
-    // As rlp_stream_hex_str's size is enough to hold the entire RLP hex string,
-    // thus it's far more than enough to hold any field of the RLP hex string,
-    // which is printed.
 
-    printf("Transaction Message:\n");
+/*!*****************************************************************************
+@brief Construct and sign a raw transaction and encode it as per RLP rules.
 
-    // Print nonce
-    if(0 == UtilityBin2Hex(
-        rlp_stream_hex_str,
-        tx_info_ctx_ptr->rawtx_fields.nonce.field,
-        tx_info_ctx_ptr->rawtx_fields.nonce.field_len,
-        BIN2HEX_LEFTTRIM_QUANTITY,
-        BIN2HEX_PREFIX_0x_YES,
-        BOAT_FALSE
-        ))
-    {
-        strcpy(rlp_stream_hex_str, "NULL");
-    }
+Function: RawtxSign()
 
-    printf("Nonce: %s\n", rlp_stream_hex_str);
-            
+    This function constructs a raw transaction, signs it with the wallet
+    account's private key and encodes the signed transaction as per RLP rules,
+    without sending it. See RawtxPerform() for how the transaction is
+    constructed.
+
+    On return the v and sig fields of <tx_info_ctx_ptr> are updated.
+
+@return
+    This function returns BOAT_SUCCESS if successful. Otherwise it returns BOAT_ERROR.
+
+@param[in] boat_wallet_info_ptr
+        A pointer to wallet infor structure.
+
+@param[in] tx_info_ctx_ptr
+        A pointer to the context of the transaction.
+
+@param[out] rlp_stream_ptr
+        Buffer to hold the signed RLP stream.
+
+@param[in] rlp_stream_size
+        Size of <rlp_stream_ptr> in byte, at least TxRlpStreamSizeEstimate().
+
+@param[out] rlp_stream_len_ptr
+        Length of the signed RLP stream in byte.
+
+*******************************************************************************/
+BOAT_RESULT RawtxSign(const BoatWalletInfo *boat_wallet_info_ptr,
+                      BOAT_INOUT TxInfo *tx_info_ctx_ptr,
+                      BOAT_OUT UINT8 *rlp_stream_ptr,
+                      UINT32 rlp_stream_size,
+                      BOAT_OUT UINT32 *rlp_stream_len_ptr)
+{
+    unsigned int chain_id_len;
+
+    UINT8 *rlp_stream_start_position_ptr = rlp_stream_ptr;
+    UINT8 *rlp_stream_current_position_ptr;
+    UINT8 *rlp_stream_v_position_ptr;
+    UINT32 v;
+
+    BOAT_RESULT result = BOAT_SUCCESS;
+    boat_try_declare;
+
+
+    if( boat_wallet_info_ptr == NULL || tx_info_ctx_ptr == NULL || rlp_stream_ptr == NULL || rlp_stream_len_ptr == NULL )
+    {
+        BoatLog(BOAT_LOG_NORMAL, "Arguments cannot be NULL.");
+        boat_throw(BOAT_ERROR_NULL_POINTER, RawtxSign_cleanup);
+    }
+
+    if( rlp_stream_size == 0 || rlp_stream_size < TxRlpStreamSizeEstimate(tx_info_ctx_ptr) )
+    {
+        BoatLog(BOAT_LOG_NORMAL, "RLP stream buffer is too small.");
+        boat_throw(BOAT_ERROR_INVALID_LENGTH, RawtxSign_cleanup);
+    }
+
+    /**************************************************************************
+    * STEP 1: Construction RAW transaction without real v/r/s                 *
+    *         (See above description for details)                             *
+    **************************************************************************/
+    
+    // Reserve first 9 bytes for outer LIST's RLP header
+    rlp_stream_current_position_ptr = rlp_stream_start_position_ptr + RLP_STREAM_RESERVE_HEADER;
+
+    // Encode nonce
+    rlp_stream_current_position_ptr = RlpFieldEncode( rlp_stream_current_position_ptr,
+                                              tx_info_ctx_ptr->rawtx_fields.nonce.field,
+                                              tx_info_ctx_ptr->rawtx_fields.nonce.field_len,
+                                              RLP_FIELD_TYPE_STRING,
+                                              BOAT_FALSE);
+    if( rlp_stream_current_position_ptr == NULL )  boat_throw(BOAT_ERROR_RLP_ENCODING_FAIL, RawtxSign_cleanup);
+
+    // Encode gasprice
+    rlp_stream_current_position_ptr = RlpFieldEncode( rlp_stream_current_position_ptr,
+                                              tx_info_ctx_ptr->rawtx_fields.gasprice.field,
+                                              tx_info_ctx_ptr->rawtx_fields.gasprice.field_len,
+                                              RLP_FIELD_TYPE_STRING,
+                                              BOAT_FALSE);
+    if( rlp_stream_current_position_ptr == NULL )  boat_throw(BOAT_ERROR_RLP_ENCODING_FAIL, RawtxSign_cleanup);
+    
+    // Encode gaslimit
+    rlp_stream_current_position_ptr = RlpFieldEncode( rlp_stream_current_position_ptr,
+                                              tx_info_ctx_ptr->rawtx_fields.gaslimit.field,
+                                              tx_info_ctx_ptr->rawtx_fields.gaslimit.field_len,
+                                              RLP_FIELD_TYPE_STRING,
+                                              BOAT_FALSE);
+    if( rlp_stream_current_position_ptr == NULL )  boat_throw(BOAT_ERROR_RLP_ENCODING_FAIL, RawtxSign_cleanup);
+    
+    // Encode recipient
+    rlp_stream_current_position_ptr = RlpFieldEncode( rlp_stream_current_position_ptr,
+                                              tx_info_ctx_ptr->rawtx_fields.recipient,
+                                              20,
+                                              RLP_FIELD_TYPE_STRING,
+                                              BOAT_FALSE);
+    if( rlp_stream_current_position_ptr == NULL )  boat_throw(BOAT_ERROR_RLP_ENCODING_FAIL, RawtxSign_cleanup);
+
+    // Encode value
+    rlp_stream_current_position_ptr = RlpFieldEncode( rlp_stream_current_position_ptr,
+                                              tx_info_ctx_ptr->rawtx_fields.value.field,
+                                              tx_info_ctx_ptr->rawtx_fields.value.field_len,
+                                              RLP_FIELD_TYPE_STRING,
+                                              BOAT_FALSE);
+    if( rlp_stream_current_position_ptr == NULL )  boat_throw(BOAT_ERROR_RLP_ENCODING_FAIL, RawtxSign_cleanup);
+
+    // Encode data
+    rlp_stream_current_position_ptr = RlpFieldEncode( rlp_stream_current_position_ptr,
+                                              tx_info_ctx_ptr->rawtx_fields.data.field_ptr,
+                                              tx_info_ctx_ptr->rawtx_fields.data.field_len,
+                                              RLP_FIELD_TYPE_STRING,
+                                              BOAT_FALSE);
+    if( rlp_stream_current_position_ptr == NULL )  boat_throw(BOAT_ERROR_RLP_ENCODING_FAIL, RawtxSign_cleanup);
+
+
+    // Record the position of "v" for use in Step 4
+    rlp_stream_v_position_ptr = rlp_stream_current_position_ptr;
+
+
+    // If EIP-155 is required, encode v = chain id, r = s = NULL in this step
+    if( boat_wallet_info_ptr->network_info.eip155_compatibility == BOAT_TRUE )
+    {
+        // v = Chain ID
+        // Currently max chain id supported is (2^32 - 1 - 36)/2, because v is
+        // finally calculated as chain_id * 2 + 35 or 36 as per EIP-155.
+        v = boat_wallet_info_ptr->network_info.chain_id;
+        chain_id_len = UtilityUint32ToBigend(tx_info_ctx_ptr->rawtx_fields.v.field,
+                                             v,
+                                             TRIMBIN_LEFTTRIM
+                                            );
+        tx_info_ctx_ptr->rawtx_fields.v.field_len = chain_id_len;
+        
+        // r = s = NULL
+        tx_info_ctx_ptr->rawtx_fields.sig.r_len = 0;
+        tx_info_ctx_ptr->rawtx_fields.sig.s_len = 0;
+
+
+        // Encode v
+        rlp_stream_current_position_ptr = RlpFieldEncode( rlp_stream_current_position_ptr,
+                                                  tx_info_ctx_ptr->rawtx_fields.v.field,
+                                                  tx_info_ctx_ptr->rawtx_fields.v.field_len,
+                                                  RLP_FIELD_TYPE_STRING,
+                                                  BOAT_FALSE);
+        if( rlp_stream_current_position_ptr == NULL )  boat_throw(BOAT_ERROR_RLP_ENCODING_FAIL, RawtxSign_cleanup);
+
+        // Encode r
+        rlp_stream_current_position_ptr = RlpFieldEncode( rlp_stream_current_position_ptr,
+                                                  tx_info_ctx_ptr->rawtx_fields.sig.r32B,
+                                                  tx_info_ctx_ptr->rawtx_fields.sig.r_len,
+                                                  RLP_FIELD_TYPE_STRING,
+                                                  BOAT_FALSE);
+        if( rlp_stream_current_position_ptr == NULL )  boat_throw(BOAT_ERROR_RLP_ENCODING_FAIL, RawtxSign_cleanup);
+
+        // Encode s
+        rlp_stream_current_position_ptr = RlpFieldEncode( rlp_stream_current_position_ptr,
+                                                  tx_info_ctx_ptr->rawtx_fields.sig.s32B,
+                                                  tx_info_ctx_ptr->rawtx_fields.sig.s_len,
+                                                  RLP_FIELD_TYPE_STRING,
+                                                  BOAT_FALSE);
+        if( rlp_stream_current_position_ptr == NULL )  boat_throw(BOAT_ERROR_RLP_ENCODING_FAIL, RawtxSign_cleanup);
+
+    }
+
+    /**************************************************************************
+    * STEP 2 ~ 4: Hash, sign and re-encode v/r/s                              *
+    **************************************************************************/
+    result = RawtxSignEncoded(boat_wallet_info_ptr,
+                              tx_info_ctx_ptr,
+                              rlp_stream_ptr,
+                              rlp_stream_v_position_ptr,
+                              rlp_stream_current_position_ptr,
+                              rlp_stream_len_ptr);
+    if( result != BOAT_SUCCESS ) boat_throw(result, RawtxSign_cleanup);
+
+    boat_catch(RawtxSign_cleanup)
+    {
+        BoatLog(BOAT_LOG_NORMAL, "Exception: %d", boat_exception);
+        result = boat_exception;
+    }
+
+    return result;
+}
+
+
+/*!*****************************************************************************
+@brief Initialize a transaction template.
+
+Function: RawtxTemplateInit()
+
+    This function encodes gasprice, gaslimit, recipient and value of
+    <rawtx_fields_ptr> as per RLP rules into the template, as well as the
+    v = chain id, r = s = NULL placeholder if the chain supports EIP-155.
+    Other fields of <rawtx_fields_ptr> are ignored.
+
+    Transactions built from the template with RawtxTemplateSign() or
+    RawtxTemplatePerform() only encode their nonce and data, and MUST be
+    signed by a wallet of the same chain.
+
+@return
+    This function returns BOAT_SUCCESS if successful. Otherwise it returns BOAT_ERROR.
+
+@param[out] tx_template_ptr
+        The template to initialize.
+
+@param[in] boat_wallet_info_ptr
+        A pointer to wallet infor structure, for chain id and EIP-155 compatibility.
+
+@param[in] rawtx_fields_ptr
+        The constant fields of the transactions.
+
+*******************************************************************************/
+BOAT_RESULT RawtxTemplateInit(BOAT_OUT BoatTxTemplate *tx_template_ptr,
+                              const BoatWalletInfo *boat_wallet_info_ptr,
+                              const RawtxFields *rawtx_fields_ptr)
+{
+    UINT8 *rlp_stream_current_position_ptr;
+    UINT8 chain_id_array[4];
+    UINT32 chain_id_len;
+
+    BOAT_RESULT result = BOAT_SUCCESS;
+    boat_try_declare;
+
+    if( tx_template_ptr == NULL || boat_wallet_info_ptr == NULL || rawtx_fields_ptr == NULL )
+    {
+        BoatLog(BOAT_LOG_NORMAL, "Arguments cannot be NULL.");
+        boat_throw(BOAT_ERROR_NULL_POINTER, RawtxTemplateInit_cleanup);
+    }
+
+    if(    rawtx_fields_ptr->gasprice.field_len > sizeof(rawtx_fields_ptr->gasprice.field)
+        || rawtx_fields_ptr->gaslimit.field_len > sizeof(rawtx_fields_ptr->gaslimit.field)
+        || rawtx_fields_ptr->value.field_len > sizeof(rawtx_fields_ptr->value.field) )
+    {
+        BoatLog(BOAT_LOG_NORMAL, "Transaction field is too long.");
+        boat_throw(BOAT_ERROR_INVALID_LENGTH, RawtxTemplateInit_cleanup);
+    }
+
+    memset(tx_template_ptr, 0, sizeof(BoatTxTemplate));
+
+    rlp_stream_current_position_ptr = tx_template_ptr->const_rlp;
+
+    // Encode gasprice
+    rlp_stream_current_position_ptr = RlpFieldEncode( rlp_stream_current_position_ptr,
+                                              (UINT8 *)rawtx_fields_ptr->gasprice.field,
+                                              rawtx_fields_ptr->gasprice.field_len,
+                                              RLP_FIELD_TYPE_STRING,
+                                              BOAT_FALSE);
+    if( rlp_stream_current_position_ptr == NULL )  boat_throw(BOAT_ERROR_RLP_ENCODING_FAIL, RawtxTemplateInit_cleanup);
+
+    // Encode gaslimit
+    rlp_stream_current_position_ptr = RlpFieldEncode( rlp_stream_current_position_ptr,
+                                              (UINT8 *)rawtx_fields_ptr->gaslimit.field,
+                                              rawtx_fields_ptr->gaslimit.field_len,
+                                              RLP_FIELD_TYPE_STRING,
+                                              BOAT_FALSE);
+    if( rlp_stream_current_position_ptr == NULL )  boat_throw(BOAT_ERROR_RLP_ENCODING_FAIL, RawtxTemplateInit_cleanup);
+
+    // Encode recipient
+    rlp_stream_current_position_ptr = RlpFieldEncode( rlp_stream_current_position_ptr,
+                                              (UINT8 *)rawtx_fields_ptr->recipient,
+                                              20,
+                                              RLP_FIELD_TYPE_STRING,
+                                              BOAT_FALSE);
+    if( rlp_stream_current_position_ptr == NULL )  boat_throw(BOAT_ERROR_RLP_ENCODING_FAIL, RawtxTemplateInit_cleanup);
+
+    // Encode value
+    rlp_stream_current_position_ptr = RlpFieldEncode( rlp_stream_current_position_ptr,
+                                              (UINT8 *)rawtx_fields_ptr->value.field,
+                                              rawtx_fields_ptr->value.field_len,
+                                              RLP_FIELD_TYPE_STRING,
+                                              BOAT_FALSE);
+    if( rlp_stream_current_position_ptr == NULL )  boat_throw(BOAT_ERROR_RLP_ENCODING_FAIL, RawtxTemplateInit_cleanup);
+
+    tx_template_ptr->const_rlp_len = (UINT32)(rlp_stream_current_position_ptr - tx_template_ptr->const_rlp);
+
+
+    // Encode v = Chain ID, r = s = NULL for EIP-155 (see Step 1 in RawtxPerform())
+    if( boat_wallet_info_ptr->network_info.eip155_compatibility == BOAT_TRUE )
+    {
+        chain_id_len = UtilityUint32ToBigend(chain_id_array,
+                                             boat_wallet_info_ptr->network_info.chain_id,
+                                             TRIMBIN_LEFTTRIM
+                                            );
+
+        rlp_stream_current_position_ptr = RlpFieldEncode( tx_template_ptr->chain_id_rlp,
+                                                  chain_id_array,
+                                                  chain_id_len,
+                                                  RLP_FIELD_TYPE_STRING,
+                                                  BOAT_FALSE);
+        if( rlp_stream_current_position_ptr == NULL )  boat_throw(BOAT_ERROR_RLP_ENCODING_FAIL, RawtxTemplateInit_cleanup);
+
+        rlp_stream_current_position_ptr = RlpFieldEncode( rlp_stream_current_position_ptr,
+                                                  NULL,
+                                                  0,
+                                                  RLP_FIELD_TYPE_STRING,
+                                                  BOAT_FALSE);
+        if( rlp_stream_current_position_ptr == NULL )  boat_throw(BOAT_ERROR_RLP_ENCODING_FAIL, RawtxTemplateInit_cleanup);
+
+        rlp_stream_current_position_ptr = RlpFieldEncode( rlp_stream_current_position_ptr,
+                                                  NULL,
+                                                  0,
+                                                  RLP_FIELD_TYPE_STRING,
+                                                  BOAT_FALSE);
+        if( rlp_stream_current_position_ptr == NULL )  boat_throw(BOAT_ERROR_RLP_ENCODING_FAIL, RawtxTemplateInit_cleanup);
+
+        tx_template_ptr->chain_id_rlp_len = (UINT32)(rlp_stream_current_position_ptr - tx_template_ptr->chain_id_rlp);
+    }
+
+    memcpy(tx_template_ptr->recipient, rawtx_fields_ptr->recipient, sizeof(BoatAddress));
+    tx_template_ptr->eip155_compatibility = boat_wallet_info_ptr->network_info.eip155_compatibility;
+    tx_template_ptr->chain_id = boat_wallet_info_ptr->network_info.chain_id;
+
+    boat_catch(RawtxTemplateInit_cleanup)
+    {
+        BoatLog(BOAT_LOG_NORMAL, "Exception: %d", boat_exception);
+        result = boat_exception;
+    }
+
+    return result;
+}
+
+
+/*!*****************************************************************************
+@brief This function estimates the encoded RLP stream's size for a transaction
+       built from a template.
+
+Function: RawtxTemplateSizeEstimate()
+
+    Similar to TxRlpStreamSizeEstimate(), but the constant fields are counted
+    with their exact encoded length in the template.
+
+@return
+    This function returns the estimated maximum size of the encoded RLP stream.\n
+    If any error is encountered, it returns 0.
+
+@param[in] tx_template_ptr
+        The template.
+
+@param[in] tx_info_ctx_ptr
+        A pointer to the transaction context, of which only nonce and data are used.
+
+*******************************************************************************/
+UINT32 RawtxTemplateSizeEstimate(const BoatTxTemplate *tx_template_ptr, const TxInfo *tx_info_ctx_ptr)
+{
+    UINT64 estimated_size;
+
+    if( tx_template_ptr == NULL || tx_info_ctx_ptr == NULL )
+    {
+        BoatLog(BOAT_LOG_NORMAL, "Arguments cannot be null.");
+        return 0;
+    }
+
+    estimated_size =   RLP_STREAM_RESERVE_HEADER
+                     + 9 + (UINT64)tx_info_ctx_ptr->rawtx_fields.nonce.field_len
+                     + tx_template_ptr->const_rlp_len
+                     + 9 + (UINT64)tx_info_ctx_ptr->rawtx_fields.data.field_len
+                     + 9 + sizeof(tx_info_ctx_ptr->rawtx_fields.v.field)
+                     + 9 + sizeof(tx_info_ctx_ptr->rawtx_fields.sig.r32B)
+                     + 9 + sizeof(tx_info_ctx_ptr->rawtx_fields.sig.s32B);
+
+    if( estimated_size > BOAT_REASONABLE_MAX_LEN )
+    {
+        BoatLog(BOAT_LOG_NORMAL, "Too big estimated_size of the transaction: %llu", estimated_size);
+        return 0;
+    }
+
+    return (UINT32)estimated_size;
+}
+
+
+/*!*****************************************************************************
+@brief Sign a transaction built from a template and encode it as per RLP rules.
+
+Function: RawtxTemplateSign()
+
+    This function does the same as RawtxSign(), except that gasprice,
+    gaslimit, recipient and value are taken pre-encoded from the template.
+    Only the nonce and data of <tx_info_ctx_ptr> are encoded.
+
+@return
+    This function returns BOAT_SUCCESS if successful. Otherwise it returns BOAT_ERROR.
+
+@param[in] tx_template_ptr
+        The template initialized by RawtxTemplateInit().
+
+@param[in] boat_wallet_info_ptr
+        A pointer to wallet infor structure. Its chain MUST be the one the
+        template was initialized for.
+
+@param[in] tx_info_ctx_ptr
+        A pointer to the context of the transaction. On return its v and sig
+        fields are updated.
+
+@param[out] rlp_stream_ptr
+        Buffer to hold the signed RLP stream.
+
+@param[in] rlp_stream_size
+        Size of <rlp_stream_ptr> in byte, at least RawtxTemplateSizeEstimate().
+
+@param[out] rlp_stream_len_ptr
+        Length of the signed RLP stream in byte.
+
+*******************************************************************************/
+BOAT_RESULT RawtxTemplateSign(const BoatTxTemplate *tx_template_ptr,
+                              const BoatWalletInfo *boat_wallet_info_ptr,
+                              BOAT_INOUT TxInfo *tx_info_ctx_ptr,
+                              BOAT_OUT UINT8 *rlp_stream_ptr,
+                              UINT32 rlp_stream_size,
+                              BOAT_OUT UINT32 *rlp_stream_len_ptr)
+{
+    UINT8 *rlp_stream_current_position_ptr;
+    UINT8 *rlp_stream_v_position_ptr;
+    UINT32 rlp_stream_size_estimate;
+
+    BOAT_RESULT result = BOAT_SUCCESS;
+    boat_try_declare;
+
+    if(    tx_template_ptr == NULL || boat_wallet_info_ptr == NULL || tx_info_ctx_ptr == NULL
+        || rlp_stream_ptr == NULL || rlp_stream_len_ptr == NULL )
+    {
+        BoatLog(BOAT_LOG_NORMAL, "Arguments cannot be NULL.");
+        boat_throw(BOAT_ERROR_NULL_POINTER, RawtxTemplateSign_cleanup);
+    }
+
+    if(    tx_template_ptr->eip155_compatibility != boat_wallet_info_ptr->network_info.eip155_compatibility
+        || (   tx_template_ptr->eip155_compatibility == BOAT_TRUE
+            && tx_template_ptr->chain_id != boat_wallet_info_ptr->network_info.chain_id) )
+    {
+        BoatLog(BOAT_LOG_NORMAL, "Transaction template is not for the wallet's chain.");
+        boat_throw(BOAT_ERROR_INCOMPATIBLE_ARGUMENTS, RawtxTemplateSign_cleanup);
+    }
+
+    rlp_stream_size_estimate = RawtxTemplateSizeEstimate(tx_template_ptr, tx_info_ctx_ptr);
+    if( rlp_stream_size_estimate == 0 || rlp_stream_size < rlp_stream_size_estimate )
+    {
+        BoatLog(BOAT_LOG_NORMAL, "RLP stream buffer is too small.");
+        boat_throw(BOAT_ERROR_INVALID_LENGTH, RawtxTemplateSign_cleanup);
+    }
+
+    // Reserve first 9 bytes for outer LIST's RLP header
+    rlp_stream_current_position_ptr = rlp_stream_ptr + RLP_STREAM_RESERVE_HEADER;
+
+    // Encode nonce
+    rlp_stream_current_position_ptr = RlpFieldEncode( rlp_stream_current_position_ptr,
+                                              tx_info_ctx_ptr->rawtx_fields.nonce.field,
+                                              tx_info_ctx_ptr->rawtx_fields.nonce.field_len,
+                                              RLP_FIELD_TYPE_STRING,
+                                              BOAT_FALSE);
+    if( rlp_stream_current_position_ptr == NULL )  boat_throw(BOAT_ERROR_RLP_ENCODING_FAIL, RawtxTemplateSign_cleanup);
+
+    // Splice in pre-encoded gasprice, gaslimit, recipient and value
+    memcpy(rlp_stream_current_position_ptr, tx_template_ptr->const_rlp, tx_template_ptr->const_rlp_len);
+    rlp_stream_current_position_ptr += tx_template_ptr->const_rlp_len;
+
+    // Encode data
+    rlp_stream_current_position_ptr = RlpFieldEncode( rlp_stream_current_position_ptr,
+                                              tx_info_ctx_ptr->rawtx_fields.data.field_ptr,
+                                              tx_info_ctx_ptr->rawtx_fields.data.field_len,
+                                              RLP_FIELD_TYPE_STRING,
+                                              BOAT_FALSE);
+    if( rlp_stream_current_position_ptr == NULL )  boat_throw(BOAT_ERROR_RLP_ENCODING_FAIL, RawtxTemplateSign_cleanup);
+
+    // Record the position of "v" and splice in pre-encoded v/r/s for EIP-155
+    rlp_stream_v_position_ptr = rlp_stream_current_position_ptr;
+    memcpy(rlp_stream_current_position_ptr, tx_template_ptr->chain_id_rlp, tx_template_ptr->chain_id_rlp_len);
+    rlp_stream_current_position_ptr += tx_template_ptr->chain_id_rlp_len;
+
+    result = RawtxSignEncoded(boat_wallet_info_ptr,
+                              tx_info_ctx_ptr,
+                              rlp_stream_ptr,
+                              rlp_stream_v_position_ptr,
+                              rlp_stream_current_position_ptr,
+                              rlp_stream_len_ptr);
+    if( result != BOAT_SUCCESS ) boat_throw(result, RawtxTemplateSign_cleanup);
+
+    boat_catch(RawtxTemplateSign_cleanup)
+    {
+        BoatLog(BOAT_LOG_NORMAL, "Exception: %d", boat_exception);
+        result = boat_exception;
+    }
+
+    return result;
+}
+
+
+/*!*****************************************************************************
+@brief Sign a raw transaction, send it and wait for its receipt.
+
+Function: RawtxSignAndSend()
+
+    This function signs the transaction with RawtxSign(), or with
+    RawtxTemplateSign() if <tx_template_ptr> is not NULL, sends it with
+    eth_sendRawTransaction and polls its receipt until it's mined or
+    BOAT_WAIT_PENDING_TX_TIMEOUT expires.
+
+@return
+    This function returns BOAT_SUCCESS if successful. Otherwise it returns BOAT_ERROR.
+
+@param[in] boat_wallet_info_ptr
+        A pointer to wallet infor structure.
+
+@param[in] tx_template_ptr
+        The transaction template, or NULL to encode all fields of <tx_info_ctx_ptr>.
+
+@param[in] tx_info_ctx_ptr
+        A pointer to the context of the transaction.
+
+*******************************************************************************/
+static BOAT_RESULT RawtxSignAndSend(BoatWalletInfo *boat_wallet_info_ptr,
+                                    const BoatTxTemplate *tx_template_ptr,
+                                    BOAT_INOUT TxInfo *tx_info_ctx_ptr)
+{
+    CHAR *tx_hash_str;
+    CHAR tx_hash[67];
+    CHAR *tx_status_str;
+
+    UINT32 rlp_stream_size_estimate;
+    CHAR *rlp_stream_hex_str = NULL;    // Storage for RLP stream HEX string for use with web3 interface
+    UINT8 *rlp_stream_start_position_ptr = NULL; // Point to storeage of RLP stream binary
+    UINT32 message_len;
+
+    Param_eth_sendRawTransaction param_eth_sendRawTransaction;
+    Param_eth_getTransactionReceipt param_eth_getTransactionReceipt;
+    SINT32 tx_mined_timeout;    // in millisecond
+    UINT32 tx_wait_interval;    // in millisecond
+    UINT64 deadline_ms;
+    UINT64 now_ms;
+
+#if RPC_SUPPORT_NOTIFICATION
+    Param_eth_subscribe param_eth_subscribe;
+    Param_eth_unsubscribe param_eth_unsubscribe;
+    CHAR *subscription_id_str;
+    CHAR subscription_id[67] = "";
+    UINT64 wait_start_ms;
+    BOAT_RESULT wait_result;
+#endif
+    
+    BOAT_RESULT result;
+    boat_try_declare;
+
+
+    if( boat_wallet_info_ptr == NULL )
+    {
+        BoatLog(BOAT_LOG_NORMAL, "<boat_wallet_info_ptr> cannot be null.");
+        boat_throw(BOAT_ERROR_NULL_POINTER, RawtxSignAndSend_cleanup);
+    }
+    
+    if( tx_info_ctx_ptr == NULL )
+    {
+        BoatLog(BOAT_LOG_NORMAL, "<tx_info_ctx_ptr> cannot be null.");
+        boat_throw(BOAT_ERROR_NULL_POINTER, RawtxSignAndSend_cleanup);
+    }
+    
+    if( tx_template_ptr == NULL )
+    {
+        rlp_stream_size_estimate = TxRlpStreamSizeEstimate(tx_info_ctx_ptr);
+    }
+    else
+    {
+        rlp_stream_size_estimate = RawtxTemplateSizeEstimate(tx_template_ptr, tx_info_ctx_ptr);
+    }
+    if( rlp_stream_size_estimate == 0 ) boat_throw(BOAT_ERROR_INVALID_LENGTH, RawtxSignAndSend_cleanup);
+
+    // Allocate memory for RLP stream binary
+    rlp_stream_start_position_ptr = BoatMalloc(rlp_stream_size_estimate);
+    
+    if( rlp_stream_start_position_ptr == NULL )
+    {
+        BoatLog(BOAT_LOG_CRITICAL, "Unable to dynamically allocate memory to store RLP stream.");
+        boat_throw(BOAT_ERROR_OUT_OF_MEMORY, RawtxSignAndSend_cleanup);
+    }
+
+    // Allocate memory for RLP stream HEX string
+    // It's a storage for HEX string converted from RLP stream binary. The
+    // HEX string is used as input for web3. It's in a form of "0x1234ABCD".
+    // Where *2 for binary to HEX conversion, +2 for "0x" prefix, + 1 for null terminator.
+    rlp_stream_hex_str = BoatMalloc(rlp_stream_size_estimate * 2 + 2 + 1);
+
+    if( rlp_stream_hex_str == NULL )
+    {
+        BoatLog(BOAT_LOG_CRITICAL, "Unable to dynamically allocate memory to store RLP HEX string.");
+        boat_throw(BOAT_ERROR_OUT_OF_MEMORY, RawtxSignAndSend_cleanup);
+    }
+    
+
+    if( tx_template_ptr == NULL )
+    {
+        result = RawtxSign(boat_wallet_info_ptr,
+                           tx_info_ctx_ptr,
+                           rlp_stream_start_position_ptr,
+                           rlp_stream_size_estimate,
+                           &message_len);
+    }
+    else
+    {
+        result = RawtxTemplateSign(tx_template_ptr,
+                                   boat_wallet_info_ptr,
+                                   tx_info_ctx_ptr,
+                                   rlp_stream_start_position_ptr,
+                                   rlp_stream_size_estimate,
+                                   &message_len);
+    }
+    if( result != BOAT_SUCCESS ) boat_throw(result, RawtxSignAndSend_cleanup);
+
+
+    // Print transaction recipient to log
+
+    if( 0 == UtilityBin2Hex(
+        rlp_stream_hex_str,
+        tx_template_ptr == NULL ? tx_info_ctx_ptr->rawtx_fields.recipient : tx_template_ptr->recipient,
+        20,
+        BIN2HEX_LEFTTRIM_UFMTDATA,
+        BIN2HEX_PREFIX_0x_YES,
+        BOAT_FALSE
+        ))
+    {
+        strcpy(rlp_stream_hex_str, "NULL");
+    }
+
+    BoatLog(BOAT_LOG_NORMAL, "Transaction to: %s", rlp_stream_hex_str);
+
+#ifdef DEBUG_LOG
+
+    // To save memory, re-use rlp_stream_hex_str to print debug information
+    // As rlp_stream_hex_str's size is enough to hold the entire RLP hex string,
+    // thus it's far more than enough to hold any field of the RLP hex string,
+    // which is printed.
+
+    printf("Transaction Message:\n");
+
+    // Print nonce
+    if(0 == UtilityBin2Hex(
+        rlp_stream_hex_str,
+        tx_info_ctx_ptr->rawtx_fields.nonce.field,
+        tx_info_ctx_ptr->rawtx_fields.nonce.field_len,
+        BIN2HEX_LEFTTRIM_QUANTITY,
+        BIN2HEX_PREFIX_0x_YES,
+        BOAT_FALSE
+        ))
+    {
+        strcpy(rlp_stream_hex_str, "NULL");
+    }
+
+    printf("Nonce: %s\n", rlp_stream_hex_str);
+            
 
     // Print Sender
 
@@ -879,7 +1303,7 @@ BOAT_RESULT RawtxPerform(BoatWalletInfo *boat_wallet_info_ptr, BOAT_INOUT TxInfo
 
     UtilityBin2Hex(
                 rlp_stream_hex_str,
-                rlp_stream_current_position_ptr,
+                rlp_stream_start_position_ptr,
                 message_len,
                 BIN2HEX_LEFTTRIM_UFMTDATA,
                 BIN2HEX_PREFIX_0x_YES,
@@ -887,11 +1311,26 @@ BOAT_RESULT RawtxPerform(BoatWalletInfo *boat_wallet_info_ptr, BOAT_INOUT TxInfo
                 );
 
     param_eth_sendRawTransaction.signedtx_str = rlp_stream_hex_str;
+
+#if RPC_SUPPORT_NOTIFICATION
+    // Subscribe to new block headers before sending the transaction, so that
+    // its receipt is checked once a block lands instead of at fixed intervals.
+    // Without the subscription, it falls back to check at BOAT_MINE_INTERVAL.
+    param_eth_subscribe.kind_str = "newHeads";
+    subscription_id_str = web3_eth_subscribe(boat_wallet_info_ptr->network_info.node_url_ptr,
+                                             &param_eth_subscribe);
+    subscription_id[0] = '\0';
+    if( subscription_id_str != NULL && strlen(subscription_id_str) < sizeof(subscription_id) )
+    {
+        strcpy(subscription_id, subscription_id_str);
+    }
+    param_eth_unsubscribe.subscription_id_str = subscription_id;
+#endif
     
     tx_hash_str = web3_eth_sendRawTransaction( boat_wallet_info_ptr->network_info.node_url_ptr,
                                                &param_eth_sendRawTransaction);
 
-    if( tx_hash_str == NULL ) boat_throw(BOAT_ERROR_RPC_FAIL, RawtxPerform_cleanup);
+    if( tx_hash_str == NULL ) boat_throw(BOAT_ERROR_RPC_FAIL, RawtxSignAndSend_cleanup);
 
     tx_info_ctx_ptr->tx_hash.field_len =
             UtilityHex2Bin(
@@ -905,22 +1344,64 @@ BOAT_RESULT RawtxPerform(BoatWalletInfo *boat_wallet_info_ptr, BOAT_INOUT TxInfo
     // NOT GOOD
     strcpy(tx_hash, tx_hash_str);
 
-    tx_mined_timeout = BOAT_WAIT_PENDING_TX_TIMEOUT;
+    tx_mined_timeout = BOAT_WAIT_PENDING_TX_TIMEOUT * 1000;
+
+    // Don't wait beyond the deadline set by RpcSetDeadline()
+    deadline_ms = RpcGetDeadline();
+    if( deadline_ms != 0 )
+    {
+        now_ms = BoatGetTimeMs();
+        if( deadline_ms <= now_ms )
+        {
+            tx_mined_timeout = 0;
+        }
+        else if( deadline_ms - now_ms < (UINT64)tx_mined_timeout )
+        {
+            tx_mined_timeout = (SINT32)(deadline_ms - now_ms);
+        }
+    }
+
     param_eth_getTransactionReceipt.tx_hash_str = tx_hash;
 
     do
     {
-        sleep(BOAT_MINE_INTERVAL); // Sleep waiting for the block being mined
+#if RPC_SUPPORT_NOTIFICATION
+        if( subscription_id[0] != '\0' )
+        {
+            // Wait for the next block. Check the receipt on timeout as well.
+            wait_start_ms = BoatGetTimeMs();
+            wait_result = web3_wait_subscription(&param_eth_unsubscribe, tx_mined_timeout);
+            tx_wait_interval = (UINT32)(BoatGetTimeMs() - wait_start_ms);
+
+            if( wait_result != BOAT_SUCCESS && wait_result != BOAT_ERROR_RPC_TIMEOUT )
+            {
+                // The subscription is lost with the connection
+                subscription_id[0] = '\0';
+            }
+        }
+        else
+#endif
+        {
+            tx_wait_interval = BOAT_MINE_INTERVAL * 1000;
+            if( tx_wait_interval > (UINT32)tx_mined_timeout ) tx_wait_interval = (UINT32)tx_mined_timeout;
+
+            BoatSleepMs(tx_wait_interval); // Sleep waiting for the block being mined
+        }
         
         tx_status_str = web3_eth_getTransactionReceiptStatus(
                                         boat_wallet_info_ptr->network_info.node_url_ptr,
                                         &param_eth_getTransactionReceipt);
-        if( tx_status_str == NULL )   boat_throw(BOAT_ERROR_RPC_FAIL, RawtxPerform_cleanup);
 
+        // tx_status_str == NULL: the receipt can't be fetched this time
         // tx_status_str == "": the transaction is pending
         // tx_status_str == "0x1": the transaction is successfully mined
         // tx_status_str == "0x0": the transaction fails
-        if( tx_status_str[0] != '\0' )
+        if( tx_status_str == NULL )
+        {
+            // The transaction is already sent, keep polling until timeout
+            BoatLog(BOAT_LOG_NORMAL, "Fail to get transaction receipt, retry in next interval.");
+        }
+        else if( tx_status_str[0] != '\0' )
         {
             if( strcmp(tx_status_str, "0x1") == 0 )
             {
@@ -934,7 +1415,7 @@ BOAT_RESULT RawtxPerform(BoatWalletInfo *boat_wallet_info_ptr, BOAT_INOUT TxInfo
             break;
         }
 
-        tx_mined_timeout -= BOAT_MINE_INTERVAL;
+        tx_mined_timeout -= tx_wait_interval;
         
     }while(tx_mined_timeout > 0);
 
@@ -945,6 +1426,13 @@ BOAT_RESULT RawtxPerform(BoatWalletInfo *boat_wallet_info_ptr, BOAT_INOUT TxInfo
 
     // Clean Up
 
+#if RPC_SUPPORT_NOTIFICATION
+    if( subscription_id[0] != '\0' )
+    {
+        web3_eth_unsubscribe(boat_wallet_info_ptr->network_info.node_url_ptr, &param_eth_unsubscribe);
+    }
+#endif
+
     // Free RLP stream buffer
     if( rlp_stream_start_position_ptr != NULL )
     {
@@ -960,10 +1448,17 @@ BOAT_RESULT RawtxPerform(BoatWalletInfo *boat_wallet_info_ptr, BOAT_INOUT TxInfo
     result = BOAT_SUCCESS;
 
     // Exceptional Clean Up
-    boat_catch(RawtxPerform_cleanup)
+    boat_catch(RawtxSignAndSend_cleanup)
     {
         BoatLog(BOAT_LOG_NORMAL, "Exception: %d", boat_exception);
 
+#if RPC_SUPPORT_NOTIFICATION
+        if( subscription_id[0] != '\0' )
+        {
+            web3_eth_unsubscribe(boat_wallet_info_ptr->network_info.node_url_ptr, &param_eth_unsubscribe);
+        }
+#endif
+
         // Free RLP stream buffer
         if( rlp_stream_start_position_ptr != NULL )
         {
@@ -984,5 +1479,132 @@ BOAT_RESULT RawtxPerform(BoatWalletInfo *boat_wallet_info_ptr, BOAT_INOUT TxInfo
 }
 
 
+/*!*****************************************************************************
+@brief Construct a raw transacton and encodes it as per RLP rules.
+
+Function: RawtxPerform()
+
+    This function constructs a raw transacton and encodes it as per RLP rules.
+    
+    AN INTRODUCTION OF HOW RAW TRANSACTION IS CONSTRUCTED
+    
+    [FIELDS IN A RAW TRANSACTION]
+    
+    A RAW transaction consists of following 9 fields:
+        1. nonce;
+        2. gasprice;
+        3. gaslimit;
+        4. recipient;
+        5. value(optional);
+        6. data(optional);
+        7. v;
+        8. signature.r;
+        9. signature.s;
+
+    These transaction fields are encoded as elements of a LIST in above order
+    as per RLP encoding rules. "LIST" is a type of RLP field.
+
+
+    EXCEPTION:
+    
+    For Ethereum any fields (except <recipient>) having a value of zero are
+    treated as NULL stream in RLP encoding instead of 1-byte-size stream whose
+    value is 0. For example, nonce = 0 is encoded as 0x80 which represents NULL
+    instead of 0x00 which represents a 1-byte-size stream whose value is 0.
+
+
+    [HOW TO CONSTRUCT A RAW TRANSACTION]
+    
+    A RAW transaction is constructed in 4 steps in different ways according to
+    the blockchain network's EIP-155 compatibility. 
+
+    See following article for details about EIP-155: 
+    https://github.com/ethereum/EIPs/blob/master/EIPS/eip-155.md
+
+    
+    CASE 1: If the blockchain network does NOT support EIP-155:
+    
+        Step 1: Encode a LIST containing only the first 6 fields.
+        Step 2: Calculate SHA3 hash of the encoded stream in Step 1.
+        Step 3: Sign the hash in Step 2. This generates r, s and parity (0 or 1) for recovery identifier.
+        Step 4: Encode a LIST containing all 9 fields, where
+                First 6 fields are same as what they are;
+                v = parity + 27, where parity is given in Step 3;
+                r and s are given in Step 3.
+
+
+    CASE 2: If the blockchain network DOES support EIP-155:
+
+        Step 1: Encode all 9 fields (a LIST containing all 9 fields), where
+                First 6 fields are same as what they are;
+                v = Chain ID;
+                r = 0;
+                s = 0;
+
+                NOTE: zero value fields other than <recipient> are encoded as NULL stream.
+
+        Step 2: Same as CASE 1.
+        Step 3: Same as CASE 1.
+
+        Step 4: Encode a LIST containing all 9 fields, where
+                First 6 fields are same as what they are;
+                v = Chain ID * 2 + parity + 35, where parity is given in Step 3;
+                r and s are given in Step 3.
+
+
+@return
+    This function returns BOAT_SUCCESS if successful. Otherwise it returns BOAT_ERROR.
+    
+
+@param[in] boat_wallet_info_ptr
+        A pointer to wallet infor structure.
+
+@param[in] tx_info_ctx_ptr
+        A pointer to the context of the transaction.
+
+*******************************************************************************/
+BOAT_RESULT RawtxPerform(BoatWalletInfo *boat_wallet_info_ptr, BOAT_INOUT TxInfo *tx_info_ctx_ptr)
+{
+    return RawtxSignAndSend(boat_wallet_info_ptr, NULL, tx_info_ctx_ptr);
+}
+
+
+/*!*****************************************************************************
+@brief Perform a transaction built from a template.
+
+Function: RawtxTemplatePerform()
+
+    This function does the same as RawtxPerform(), except that gasprice,
+    gaslimit, recipient and value are taken pre-encoded from the template
+    (see RawtxTemplateInit()). Only the nonce and data of <tx_info_ctx_ptr>
+    are used.
+
+@return
+    This function returns BOAT_SUCCESS if successful. Otherwise it returns BOAT_ERROR.
+
+@param[in] boat_wallet_info_ptr
+        A pointer to wallet infor structure.
+
+@param[in] tx_template_ptr
+        The template initialized by RawtxTemplateInit().
+
+@param[in] tx_info_ctx_ptr
+        A pointer to the context of the transaction.
+
+*******************************************************************************/
+BOAT_RESULT RawtxTemplatePerform(BoatWalletInfo *boat_wallet_info_ptr,
+                                 const BoatTxTemplate *tx_template_ptr,
+                                 BOAT_INOUT TxInfo *tx_info_ctx_ptr)
+{
+    if( tx_template_ptr == NULL )
+    {
+        BoatLog(BOAT_LOG_NORMAL, "<tx_template_ptr> cannot be null.");
+        return BOAT_ERROR_NULL_POINTER;
+    }
+
+    return RawtxSignAndSend(boat_wallet_info_ptr, tx_template_ptr, tx_info_ctx_ptr);
+}
+
+
 
 
@@ -40,12 +40,62 @@ typedef enum
     RLP_FIELD_TYPE_LIST
 }RlpFieldType;
 
+//! Maximum length of the RLP encoded gasprice, gaslimit, recipient and value
+#define BOAT_TX_TEMPLATE_CONST_RLP_MAX_LEN ((1 + 32) * 3 + (1 + 20))
+
+//! Maximum length of the RLP encoded v = chain id, r = NULL and s = NULL
+#define BOAT_TX_TEMPLATE_CHAIN_ID_RLP_MAX_LEN ((1 + 4) + 1 + 1)
+
+/*!
+@brief Transaction template
+
+    A transaction template holds the RLP encoded fields that don't change among
+    a series of transactions, i.e. gasprice, gaslimit, recipient and value,
+    together with the EIP-155 v/r/s placeholder of the chain. Transactions
+    built from a template only encode nonce and data.
+*/
+typedef struct TBoatTxTemplate
+{
+    UINT8 const_rlp[BOAT_TX_TEMPLATE_CONST_RLP_MAX_LEN];        //!< RLP of gasprice|gaslimit|recipient|value
+    UINT32 const_rlp_len;                                       //!< Length of <const_rlp>
+    UINT8 chain_id_rlp[BOAT_TX_TEMPLATE_CHAIN_ID_RLP_MAX_LEN];  //!< RLP of v|r|s for EIP-155 signing
+    UINT32 chain_id_rlp_len;                                    //!< Length of <chain_id_rlp>, 0 if EIP-155 is not supported
+    BoatAddress recipient;                                      //!< Recipient, for logging
+    BOATBOOL eip155_compatibility;                              //!< EIP-155 compatibility of the chain
+    UINT32 chain_id;                                            //!< Chain ID
+}BoatTxTemplate;
+
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+UINT32 TxRlpStreamSizeEstimate(TxInfo *tx_info_ctx_ptr);
+
+BOAT_RESULT RawtxSign(const BoatWalletInfo *boat_wallet_info_ptr,
+                      BOAT_INOUT TxInfo *tx_info_ctx_ptr,
+                      BOAT_OUT UINT8 *rlp_stream_ptr,
+                      UINT32 rlp_stream_size,
+                      BOAT_OUT UINT32 *rlp_stream_len_ptr);
+
 BOAT_RESULT RawtxPerform(BoatWalletInfo *boat_wallet_info_ptr, BOAT_INOUT TxInfo *tx_info_ctx_ptr);
 
+BOAT_RESULT RawtxTemplateInit(BOAT_OUT BoatTxTemplate *tx_template_ptr,
+                              const BoatWalletInfo *boat_wallet_info_ptr,
+                              const RawtxFields *rawtx_fields_ptr);
+
+UINT32 RawtxTemplateSizeEstimate(const BoatTxTemplate *tx_template_ptr, const TxInfo *tx_info_ctx_ptr);
+
+BOAT_RESULT RawtxTemplateSign(const BoatTxTemplate *tx_template_ptr,
+                              const BoatWalletInfo *boat_wallet_info_ptr,
+                              BOAT_INOUT TxInfo *tx_info_ctx_ptr,
+                              BOAT_OUT UINT8 *rlp_stream_ptr,
+                              UINT32 rlp_stream_size,
+                              BOAT_OUT UINT32 *rlp_stream_len_ptr);
+
+BOAT_RESULT RawtxTemplatePerform(BoatWalletInfo *boat_wallet_info_ptr,
+                                 const BoatTxTemplate *tx_template_ptr,
+                                 BOAT_INOUT TxInfo *tx_info_ctx_ptr);
+
 #ifdef __cplusplus
 }
 #endif /* end of __cplusplus */
@@ -285,7 +285,7 @@ CHAR *web3_eth_getTransactionCount(
 
     // POST the REQUEST through curl
 
-#if RPC_USE_LIBCURL == 1
+#if RPC_OPTION_HAS_NODE_URL
     rpc_option.node_url_str = node_url_str;
 #endif
 
@@ -415,7 +415,7 @@ CHAR *web3_eth_gasPrice(const char *node_url_str)
 
     // POST the REQUEST through curl
 
-#if RPC_USE_LIBCURL == 1
+#if RPC_OPTION_HAS_NODE_URL
     rpc_option.node_url_str = node_url_str;
 #endif
 
@@ -551,7 +551,7 @@ CHAR *web3_eth_getBalance(
 
     // POST the REQUEST through curl
 
-#if RPC_USE_LIBCURL == 1
+#if RPC_OPTION_HAS_NODE_URL
     rpc_option.node_url_str = node_url_str;
 #endif
 
@@ -685,7 +685,7 @@ CHAR *web3_eth_sendRawTransaction(
 
     // POST the REQUEST through curl
 
-#if RPC_USE_LIBCURL == 1
+#if RPC_OPTION_HAS_NODE_URL
     rpc_option.node_url_str = node_url_str;
 #endif
 
@@ -835,7 +835,7 @@ CHAR *web3_eth_getStorageAt(
     
     // POST the REQUEST through curl
 
-#if RPC_USE_LIBCURL == 1
+#if RPC_OPTION_HAS_NODE_URL
     rpc_option.node_url_str = node_url_str;
 #endif
 
@@ -947,7 +947,7 @@ CHAR *web3_eth_getTransactionReceiptStatus(
 {
     CHAR *rpc_response_str;
     UINT32 rpc_response_len;
-    cJSON *rpc_response_json_ptr;
+    cJSON *rpc_response_json_ptr = NULL;
     cJSON *web3_result_json_ptr;
     cJSON *web3_result_status_json_ptr;
     CHAR *web3_result_status_str;
@@ -992,7 +992,7 @@ CHAR *web3_eth_getTransactionReceiptStatus(
 
     // POST the REQUEST through curl
 
-#if RPC_USE_LIBCURL == 1
+#if RPC_OPTION_HAS_NODE_URL
     rpc_option.node_url_str = node_url_str;
 #endif
 
@@ -1037,7 +1037,10 @@ CHAR *web3_eth_getTransactionReceiptStatus(
     // Obtain result.status object from result object
     web3_result_status_json_ptr = cJSON_GetObjectItemCaseSensitive(web3_result_json_ptr, "status");
 
-    if (web3_result_status_json_ptr == NULL)
+    // "result" is null if the transaction is pending
+    g_web3_result_string_buf[0] = '\0';
+
+    if (web3_result_status_json_ptr == NULL && !cJSON_IsNull(web3_result_json_ptr))
     {
         BoatLog(BOAT_LOG_NORMAL, "Cannot find \"result.status\" item in RESPONSE.");
         boat_throw(BOAT_ERROR_JSON_PARSE_FAIL, web3_eth_getTransactionReceiptStatus_cleanup);
@@ -1074,6 +1077,7 @@ CHAR *web3_eth_getTransactionReceiptStatus(
     boat_catch(web3_eth_getTransactionReceiptStatus_cleanup)
     {
         BoatLog(BOAT_LOG_NORMAL, "Exception: %d", boat_exception);
+        if( rpc_response_json_ptr != NULL ) cJSON_Delete(rpc_response_json_ptr);
         return_value_ptr = NULL;
     }
 
@@ -1197,7 +1201,7 @@ CHAR *web3_eth_call(
 
     // POST the REQUEST through curl
 
-#if RPC_USE_LIBCURL == 1
+#if RPC_OPTION_HAS_NODE_URL
     rpc_option.node_url_str = node_url_str;
 #endif
 
@@ -1239,3 +1243,1212 @@ CHAR *web3_eth_call(
     return return_value_ptr;
 }
 
+
+
+/*!*****************************************************************************
+@brief Perform eth_blockNumber RPC method and get the number of the latest block
+
+Function: web3_eth_blockNumber()
+
+    This function calls RPC method eth_blockNumber and returns a string
+    representing the number of the most recent block.
+
+    The typical RPC REQUEST is similar to:
+    {"jsonrpc":"2.0","method":"eth_blockNumber","params":[],"id":83}
+    
+    The typical RPC RESPONSE from blockchain node is similar to:
+    {"id":83,"jsonrpc": "2.0","result": "0x4b7"}
+
+    This function returns a string representing the item "result" of the
+    RESPONSE from the RPC call. The buffer storing the string is maintained by
+    web3intf and the caller shall NOT modify it, free it or save the address
+    for later use.
+
+@return
+    This function returns a string representing the latest block number in HEX.\n
+    If any error occurs or RPC call timeouts, it returns NULL.
+    
+
+@param node_url_str
+        A string indicating the URL of blockchain node.
+
+*******************************************************************************/
+CHAR *web3_eth_blockNumber(const char *node_url_str)
+{
+    CHAR *rpc_response_str;
+    UINT32 rpc_response_len;
+
+    RpcOption rpc_option;
+
+    SINT32 expected_string_size;
+    BOAT_RESULT result;
+    CHAR *return_value_ptr;
+    
+    boat_try_declare;
+    
+
+    g_web3_message_id++;
+    
+    if( node_url_str == NULL)
+    {
+        BoatLog(BOAT_LOG_NORMAL, "Arguments cannot be NULL.");
+        boat_throw(BOAT_ERROR_NULL_POINTER, web3_eth_blockNumber_cleanup);
+    }
+    
+   
+    // Construct the REQUEST
+
+    expected_string_size = snprintf(
+             g_web3_json_string_buf,
+             WEB3_JSON_STRING_BUF_MAX_SIZE,
+             "{\"jsonrpc\":\"2.0\",\"method\":\"eth_blockNumber\",\"params\":"
+             "[],\"id\":%u}",
+             g_web3_message_id
+            );
+
+    if( expected_string_size >= WEB3_JSON_STRING_BUF_MAX_SIZE - 1)
+    {
+        boat_throw(BOAT_ERROR_RLP_ENCODING_FAIL, web3_eth_blockNumber_cleanup);
+    }
+
+    BoatLog(BOAT_LOG_VERBOSE, "REQUEST: %s", g_web3_json_string_buf);
+
+    // POST the REQUEST through curl
+
+#if RPC_OPTION_HAS_NODE_URL
+    rpc_option.node_url_str = node_url_str;
+#endif
+
+    RpcSetOpt(&rpc_option);
+    
+    result = RpcRequestSync(
+                    (const UINT8*)g_web3_json_string_buf,   // g_web3_json_string_buf stores REQUEST
+                    expected_string_size,
+                    (BOAT_OUT UINT8 **)&rpc_response_str,
+                    &rpc_response_len);
+
+    if( result != BOAT_SUCCESS )
+    {
+        BoatLog(BOAT_LOG_NORMAL, "RpcRequestSync() fails.");
+        boat_throw(result, web3_eth_blockNumber_cleanup);
+    }
+
+    BoatLog(BOAT_LOG_VERBOSE, "RESPONSE: %s", rpc_response_str);
+
+    // Parse RESPONSE and get web3_result item "result"
+    result = web3_JSON_parse_item(rpc_response_str, "result");
+
+    if (result != BOAT_SUCCESS)
+    {
+        BoatLog(BOAT_LOG_NORMAL, "Fail to parse RESPONSE as JSON.");
+        boat_throw(BOAT_ERROR_JSON_PARSE_FAIL, web3_eth_blockNumber_cleanup);
+    }
+    
+
+    return_value_ptr = g_web3_result_string_buf;
+
+    // Exceptional Clean Up
+    boat_catch(web3_eth_blockNumber_cleanup)
+    {
+        BoatLog(BOAT_LOG_NORMAL, "Exception: %d", boat_exception);
+        return_value_ptr = NULL;
+    }
+
+    return return_value_ptr;
+}
+
+
+// Skip white spaces of JSON text in [<json_str>, <end_str>)
+static const CHAR *web3_JSON_skip_ws(const CHAR *json_str, const CHAR *end_str)
+{
+    while( json_str < end_str
+           && (*json_str == ' ' || *json_str == '\t' || *json_str == '\r' || *json_str == '\n') )
+    {
+        json_str++;
+    }
+
+    return json_str;
+}
+
+
+// Skip a JSON string starting at '"', return NULL if it's unterminated
+static const CHAR *web3_JSON_skip_string(const CHAR *json_str, const CHAR *end_str)
+{
+    for( json_str++; json_str < end_str; json_str++ )
+    {
+        if( *json_str == '\\' )
+        {
+            json_str++;
+        }
+        else if( *json_str == '"' )
+        {
+            return json_str + 1;
+        }
+    }
+
+    return NULL;
+}
+
+
+/*!*****************************************************************************
+@brief Skip a JSON value without parsing it
+
+Function: web3_JSON_skip_value()
+
+@return
+    This function returns the position following the value, or NULL if the
+    value is malformed or truncated.
+
+@param[in] json_str
+    Start of the value.
+
+@param[in] end_str
+    End of the JSON text.
+*******************************************************************************/
+static const CHAR *web3_JSON_skip_value(const CHAR *json_str, const CHAR *end_str)
+{
+    UINT32 depth = 0;
+
+    do
+    {
+        json_str = web3_JSON_skip_ws(json_str, end_str);
+        if( json_str >= end_str ) return NULL;
+
+        switch( *json_str )
+        {
+            case '"':
+                json_str = web3_JSON_skip_string(json_str, end_str);
+                if( json_str == NULL ) return NULL;
+                break;
+
+            case '{':
+            case '[':
+                depth++;
+                json_str++;
+                break;
+
+            case '}':
+            case ']':
+                if( depth == 0 ) return NULL;
+                depth--;
+                json_str++;
+                break;
+
+            case ',':
+            case ':':
+                if( depth == 0 ) return NULL;
+                json_str++;
+                break;
+
+            default:
+                // Number, true, false or null
+                while(    json_str < end_str && *json_str != ',' && *json_str != '}' && *json_str != ']'
+                       && *json_str != ' ' && *json_str != '\t' && *json_str != '\r' && *json_str != '\n' )
+                {
+                    json_str++;
+                }
+                break;
+        }
+    }while( depth != 0 );
+
+    return json_str;
+}
+
+
+/*!*****************************************************************************
+@brief Convert a HEX string of given length to binary
+
+Function: web3_hex_to_bin()
+
+    Unlike UtilityHex2Bin(), the string need not be null terminated and the
+    conversion may be done in place, i.e. <to_ptr> equals <from_str>.
+
+@return
+    This function returns the length of the binary, or -1 if the string isn't
+    HEX of even length or doesn't fit in <to_size>.
+
+@param[in] from_str
+    The HEX string, with or without "0x" prefix.
+
+@param[in] from_len
+    Length of <from_str>.
+
+@param[out] to_ptr
+    The binary.
+
+@param[in] to_size
+    Size of <to_ptr>.
+*******************************************************************************/
+static SINT32 web3_hex_to_bin(const CHAR *from_str, UINT32 from_len, BOAT_OUT UINT8 *to_ptr, UINT32 to_size)
+{
+    UINT32 i;
+    UINT8 nibble[2];
+    UINT32 j;
+    CHAR c;
+
+    if( from_len >= 2 && from_str[0] == '0' && (from_str[1] == 'x' || from_str[1] == 'X') )
+    {
+        from_str += 2;
+        from_len -= 2;
+    }
+
+    if( (from_len & 1) != 0 || from_len / 2 > to_size ) return -1;
+
+    for( i = 0; i < from_len / 2; i++ )
+    {
+        // Read both digits before writing, so that it works in place
+        for( j = 0; j < 2; j++ )
+        {
+            c = from_str[2 * i + j];
+            if( c >= '0' && c <= '9' )      nibble[j] = c - '0';
+            else if( c >= 'a' && c <= 'f' ) nibble[j] = c - 'a' + 10;
+            else if( c >= 'A' && c <= 'F' ) nibble[j] = c - 'A' + 10;
+            else                            return -1;
+        }
+
+        to_ptr[i] = (nibble[0] << 4) | nibble[1];
+    }
+
+    return (SINT32)(from_len / 2);
+}
+
+
+// Convert a HEX quantity, e.g. "0x1b4", to UINT64
+static BOATBOOL web3_hex_to_uint64(const CHAR *from_str, UINT32 from_len, BOAT_OUT UINT64 *value_ptr)
+{
+    UINT64 value = 0;
+    UINT32 i;
+    CHAR c;
+
+    if( from_len < 3 || from_str[0] != '0' || from_str[1] != 'x' || from_len > 18 ) return BOAT_FALSE;
+
+    for( i = 2; i < from_len; i++ )
+    {
+        c = from_str[i];
+        if( c >= '0' && c <= '9' )      value = (value << 4) | (UINT64)(c - '0');
+        else if( c >= 'a' && c <= 'f' ) value = (value << 4) | (UINT64)(c - 'a' + 10);
+        else if( c >= 'A' && c <= 'F' ) value = (value << 4) | (UINT64)(c - 'A' + 10);
+        else                            return BOAT_FALSE;
+    }
+
+    *value_ptr = value;
+
+    return BOAT_TRUE;
+}
+
+
+/*!*****************************************************************************
+@brief Decode a log object from RPC RESPONSE
+
+Function: web3_JSON_decode_log()
+
+    Members are decoded into binary as they are scanned. "data" is decoded in
+    place, i.e. into the RESPONSE buffer itself.
+
+@return
+    This function returns the position following the log object, or NULL if
+    it's malformed.
+
+@param[in] json_str
+    Start of the log object, i.e. '{'.
+
+@param[in] end_str
+    End of the JSON text.
+
+@param[out] log_ptr
+    The decoded log.
+*******************************************************************************/
+static const CHAR *web3_JSON_decode_log(CHAR *json_str, const CHAR *end_str, BOAT_OUT Web3Log *log_ptr)
+{
+    const CHAR *key_str;
+    UINT32 key_len;
+    const CHAR *value_str;
+    UINT32 value_len;
+    const CHAR *next_str;
+    UINT64 quantity;
+    SINT32 bin_len;
+
+    memset(log_ptr, 0, sizeof(Web3Log));
+
+    if( json_str >= end_str || *json_str != '{' ) return NULL;
+    json_str++;
+
+    json_str = (CHAR *)web3_JSON_skip_ws(json_str, end_str);
+    if( json_str < end_str && *json_str == '}' ) return json_str + 1;
+
+    while( json_str < end_str )
+    {
+        // "key"
+        if( *json_str != '"' ) return NULL;
+        next_str = web3_JSON_skip_string(json_str, end_str);
+        if( next_str == NULL ) return NULL;
+        key_str = json_str + 1;
+        key_len = (UINT32)(next_str - json_str - 2);
+
+        json_str = (CHAR *)web3_JSON_skip_ws(next_str, end_str);
+        if( json_str >= end_str || *json_str != ':' ) return NULL;
+        json_str = (CHAR *)web3_JSON_skip_ws(json_str + 1, end_str);
+        if( json_str >= end_str ) return NULL;
+
+        // value
+        next_str = web3_JSON_skip_value(json_str, end_str);
+        if( next_str == NULL ) return NULL;
+        value_str = json_str + 1;
+        value_len = (*json_str == '"') ? (UINT32)(next_str - json_str - 2) : 0;
+
+        if( key_len == 7 && memcmp(key_str, "address", 7) == 0 && *json_str == '"' )
+        {
+            bin_len = web3_hex_to_bin(value_str, value_len, log_ptr->address, sizeof(log_ptr->address));
+            if( bin_len != sizeof(log_ptr->address) ) return NULL;
+        }
+        else if( key_len == 6 && memcmp(key_str, "topics", 6) == 0 && *json_str == '[' )
+        {
+            const CHAR *topic_str = web3_JSON_skip_ws(json_str + 1, next_str);
+
+            while( topic_str < next_str && *topic_str == '"' )
+            {
+                const CHAR *topic_end_str = web3_JSON_skip_string(topic_str, next_str);
+
+                if( topic_end_str == NULL || log_ptr->topic_num >= WEB3_LOG_MAX_TOPICS ) return NULL;
+
+                bin_len = web3_hex_to_bin(topic_str + 1, (UINT32)(topic_end_str - topic_str - 2),
+                                          log_ptr->topics[log_ptr->topic_num], 32);
+                if( bin_len != 32 ) return NULL;
+                log_ptr->topic_num++;
+
+                topic_str = web3_JSON_skip_ws(topic_end_str, next_str);
+                if( topic_str < next_str && *topic_str == ',' ) topic_str = web3_JSON_skip_ws(topic_str + 1, next_str);
+            }
+
+            if( topic_str != next_str - 1 || *topic_str != ']' ) return NULL;
+        }
+        else if( key_len == 4 && memcmp(key_str, "data", 4) == 0 && *json_str == '"' )
+        {
+            // In place, the decoded data never runs ahead of the HEX being read
+            bin_len = web3_hex_to_bin(value_str, value_len, (UINT8 *)json_str, value_len);
+            if( bin_len < 0 ) return NULL;
+            log_ptr->data_ptr = (const UINT8 *)json_str;
+            log_ptr->data_len = (UINT32)bin_len;
+        }
+        else if( key_len == 11 && memcmp(key_str, "blockNumber", 11) == 0 && *json_str == '"' )
+        {
+            if( web3_hex_to_uint64(value_str, value_len, &log_ptr->block_number) == BOAT_FALSE ) return NULL;
+        }
+        else if( key_len == 8 && memcmp(key_str, "logIndex", 8) == 0 && *json_str == '"' )
+        {
+            if( web3_hex_to_uint64(value_str, value_len, &quantity) == BOAT_FALSE || quantity > 0xFFFFFFFF ) return NULL;
+            log_ptr->log_index = (UINT32)quantity;
+        }
+        else if( key_len == 15 && memcmp(key_str, "transactionHash", 15) == 0 && *json_str == '"' )
+        {
+            bin_len = web3_hex_to_bin(value_str, value_len, log_ptr->tx_hash, sizeof(log_ptr->tx_hash));
+            if( bin_len != sizeof(log_ptr->tx_hash) ) return NULL;
+        }
+        else if( key_len == 7 && memcmp(key_str, "removed", 7) == 0 )
+        {
+            log_ptr->removed = (next_str - json_str == 4 && memcmp(json_str, "true", 4) == 0);
+        }
+        // Other members, or null values of pending logs, are skipped
+
+        json_str = (CHAR *)web3_JSON_skip_ws(next_str, end_str);
+        if( json_str >= end_str ) return NULL;
+
+        if( *json_str == '}' ) return json_str + 1;
+        if( *json_str != ',' ) return NULL;
+
+        json_str = (CHAR *)web3_JSON_skip_ws(json_str + 1, end_str);
+    }
+
+    return NULL;
+}
+
+
+/*!*****************************************************************************
+@brief Decode logs from RPC RESPONSE as a stream
+
+Function: web3_JSON_scan_logs()
+
+    This function scans the RESPONSE of eth_getLogs or eth_getFilterChanges
+    once and calls <log_func> for each log as soon as it's decoded. Unlike
+    web3_JSON_parse_item(), no cJSON object is built, so that memory doesn't
+    grow with the number of logs.
+
+@return
+    This function returns BOAT_SUCCESS if all logs are decoded.\n
+    It returns BOAT_ERROR_RPC_NODE_ERROR if the RESPONSE is an error, e.g. the
+    node refuses to return too many logs, BOAT_ERROR_JSON_PARSE_FAIL if it's
+    malformed, or the result of <log_func> if it stops decoding.
+
+@param[in] response_str
+    The RESPONSE, modified as "data" of logs are decoded in place.
+
+@param[in] response_len
+    Length of <response_str>.
+
+@param[in] log_func
+    The log callback.
+
+@param[in] log_ctx_ptr
+    Context passed to <log_func>.
+
+@param[out] log_num_ptr
+    Number of logs decoded.
+*******************************************************************************/
+static BOAT_RESULT web3_JSON_scan_logs(CHAR *response_str,
+                                       UINT32 response_len,
+                                       Web3LogFunc log_func,
+                                       void *log_ctx_ptr,
+                                       BOAT_OUT UINT32 *log_num_ptr)
+{
+    const CHAR *end_str = response_str + response_len;
+    CHAR *json_str;
+    const CHAR *key_str;
+    UINT32 key_len;
+    const CHAR *next_str;
+    Web3Log log;
+    BOAT_RESULT result;
+
+    *log_num_ptr = 0;
+
+    json_str = (CHAR *)web3_JSON_skip_ws(response_str, end_str);
+    if( json_str >= end_str || *json_str != '{' ) return BOAT_ERROR_JSON_PARSE_FAIL;
+    json_str = (CHAR *)web3_JSON_skip_ws(json_str + 1, end_str);
+
+    while( json_str < end_str && *json_str == '"' )
+    {
+        next_str = web3_JSON_skip_string(json_str, end_str);
+        if( next_str == NULL ) return BOAT_ERROR_JSON_PARSE_FAIL;
+        key_str = json_str + 1;
+        key_len = (UINT32)(next_str - json_str - 2);
+
+        json_str = (CHAR *)web3_JSON_skip_ws(next_str, end_str);
+        if( json_str >= end_str || *json_str != ':' ) return BOAT_ERROR_JSON_PARSE_FAIL;
+        json_str = (CHAR *)web3_JSON_skip_ws(json_str + 1, end_str);
+        if( json_str >= end_str ) return BOAT_ERROR_JSON_PARSE_FAIL;
+
+        if( key_len == 6 && memcmp(key_str, "result", 6) == 0 )
+        {
+            if( end_str - json_str >= 4 && memcmp(json_str, "null", 4) == 0 ) return BOAT_SUCCESS;
+            if( *json_str != '[' ) return BOAT_ERROR_JSON_PARSE_FAIL;
+
+            json_str = (CHAR *)web3_JSON_skip_ws(json_str + 1, end_str);
+
+            while( json_str < end_str && *json_str == '{' )
+            {
+                json_str = (CHAR *)web3_JSON_decode_log(json_str, end_str, &log);
+                if( json_str == NULL ) return BOAT_ERROR_JSON_PARSE_FAIL;
+
+                (*log_num_ptr)++;
+                if( log_func != NULL )
+                {
+                    result = log_func(log_ctx_ptr, &log);
+                    if( result != BOAT_SUCCESS ) return result;
+                }
+
+                json_str = (CHAR *)web3_JSON_skip_ws(json_str, end_str);
+                if( json_str < end_str && *json_str == ',' ) json_str = (CHAR *)web3_JSON_skip_ws(json_str + 1, end_str);
+            }
+
+            if( json_str >= end_str || *json_str != ']' ) return BOAT_ERROR_JSON_PARSE_FAIL;
+
+            return BOAT_SUCCESS;
+        }
+
+        next_str = web3_JSON_skip_value(json_str, end_str);
+        if( next_str == NULL ) return BOAT_ERROR_JSON_PARSE_FAIL;
+
+        if( key_len == 5 && memcmp(key_str, "error", 5) == 0 )
+        {
+            BoatLog(BOAT_LOG_NORMAL, "RPC error: %.*s", (int)(next_str - json_str), json_str);
+            return BOAT_ERROR_RPC_NODE_ERROR;
+        }
+
+        json_str = (CHAR *)web3_JSON_skip_ws(next_str, end_str);
+        if( json_str < end_str && *json_str == ',' ) json_str = (CHAR *)web3_JSON_skip_ws(json_str + 1, end_str);
+    }
+
+    BoatLog(BOAT_LOG_NORMAL, "Cannot find \"result\" item in RESPONSE.");
+
+    return BOAT_ERROR_JSON_PARSE_FAIL;
+}
+
+
+// POST the REQUEST in g_web3_json_string_buf and decode logs in its RESPONSE
+static BOAT_RESULT web3_request_logs(const char *node_url_str,
+                                     UINT32 request_len,
+                                     Web3LogFunc log_func,
+                                     void *log_ctx_ptr,
+                                     BOAT_OUT UINT32 *log_num_ptr)
+{
+    CHAR *rpc_response_str;
+    UINT32 rpc_response_len;
+    RpcOption rpc_option;
+    BOAT_RESULT result;
+
+    BoatLog(BOAT_LOG_VERBOSE, "REQUEST: %s", g_web3_json_string_buf);
+
+#if RPC_OPTION_HAS_NODE_URL
+    rpc_option.node_url_str = node_url_str;
+#endif
+
+    RpcSetOpt(&rpc_option);
+    
+    result = RpcRequestSync(
+                    (const UINT8*)g_web3_json_string_buf,   // g_web3_json_string_buf stores REQUEST
+                    request_len,
+                    (BOAT_OUT UINT8 **)&rpc_response_str,
+                    &rpc_response_len);
+
+    if( result != BOAT_SUCCESS )
+    {
+        BoatLog(BOAT_LOG_NORMAL, "RpcRequestSync() fails.");
+        return result;
+    }
+
+    BoatLog(BOAT_LOG_VERBOSE, "RESPONSE: %s", rpc_response_str);
+
+    return web3_JSON_scan_logs(rpc_response_str, rpc_response_len, log_func, log_ctx_ptr, log_num_ptr);
+}
+
+
+// Construct eth_getLogs or eth_newFilter REQUEST in g_web3_json_string_buf
+static SINT32 web3_construct_filter_request(const CHAR *method_str, const Param_eth_getLogs *param_ptr)
+{
+    return snprintf(
+             g_web3_json_string_buf,
+             WEB3_JSON_STRING_BUF_MAX_SIZE,
+             "{\"jsonrpc\":\"2.0\",\"method\":\"%s\",\"params\":"
+             "[{\"fromBlock\":\"%s\",\"toBlock\":\"%s\"%s%s%s%s%s}],\"id\":%u}",
+             method_str,
+             param_ptr->from_block_str,
+             param_ptr->to_block_str,
+             param_ptr->address_str != NULL ? ",\"address\":\"" : "",
+             param_ptr->address_str != NULL ? param_ptr->address_str : "",
+             param_ptr->address_str != NULL ? "\"" : "",
+             param_ptr->topics_str != NULL ? ",\"topics\":" : "",
+             param_ptr->topics_str != NULL ? param_ptr->topics_str : "",
+             g_web3_message_id
+            );
+}
+
+
+/*!*****************************************************************************
+@brief Perform eth_getLogs RPC method and decode the logs as a stream
+
+Function: web3_eth_getLogs()
+
+    This function calls RPC method eth_getLogs and calls <log_func> for each
+    log in the RESPONSE as it's decoded.
+
+    The typical RPC REQUEST is similar to:
+>    {"jsonrpc":"2.0","method":"eth_getLogs","params":[{\n
+>      "fromBlock": "0x1", "toBlock": "0x2",\n
+>      "address": "0x8888f1f195afa192cfee860698584c030f4c9db1", // Optional \n
+>      "topics": ["0x000000000000000000000000a94f5374fce5edbc8e2a8697c15331677e6ebf0b", null] // Optional \n
+>    }],"id":74}
+
+    The typical RPC RESPONSE from blockchain node is similar to:
+>    {"id":74,"jsonrpc":"2.0","result":[{"logIndex":"0x1","blockNumber":"0x1b4",\n
+>      "transactionHash":"0xdf829c5a142f1fccd7d8216c5785ac562ff41e2dcfdf5785ac562ff41e2dcf",\n
+>      "address":"0x16c5785ac562ff41e2dcfdf829c5a142f1fccd7d","data":"0x0000...",\n
+>      "topics":["0x59ebeb90bc63057b6515673c3ecf9438e5058bca0f92585014eced636878c9a5"],\n
+>      "removed":false, ...}]}
+
+    Nodes limit the number of logs or blocks of a query. A query exceeding the
+    limit fails with BOAT_ERROR_RPC_NODE_ERROR, and should be retried with a
+    smaller block range. See BoatLogSyncCatchUp() for adaptive block ranges.
+
+@return
+    This function returns BOAT_SUCCESS if all logs are decoded. Otherwise it\n
+    returns an error code.
+
+@param node_url_str
+        A string indicating the URL of blockchain node.
+
+@param param_ptr
+        The filter of logs.
+
+@param log_func
+        The log callback, or NULL to only count logs.
+
+@param log_ctx_ptr
+        Context passed to <log_func>.
+
+@param log_num_ptr
+        Number of logs decoded.
+
+*******************************************************************************/
+BOAT_RESULT web3_eth_getLogs(
+                                    const char *node_url_str,
+                                    const Param_eth_getLogs *param_ptr,
+                                    Web3LogFunc log_func,
+                                    void *log_ctx_ptr,
+                                    BOAT_OUT UINT32 *log_num_ptr)
+{
+    SINT32 expected_string_size;
+
+    g_web3_message_id++;
+    
+    if(    node_url_str == NULL || param_ptr == NULL || log_num_ptr == NULL
+        || param_ptr->from_block_str == NULL || param_ptr->to_block_str == NULL )
+    {
+        BoatLog(BOAT_LOG_NORMAL, "Arguments cannot be NULL.");
+        return BOAT_ERROR_NULL_POINTER;
+    }
+
+    // Construct the REQUEST
+    expected_string_size = web3_construct_filter_request("eth_getLogs", param_ptr);
+
+    if( expected_string_size >= WEB3_JSON_STRING_BUF_MAX_SIZE - 1)
+    {
+        return BOAT_ERROR_RLP_ENCODING_FAIL;
+    }
+
+    return web3_request_logs(node_url_str, expected_string_size, log_func, log_ctx_ptr, log_num_ptr);
+}
+
+
+/*!*****************************************************************************
+@brief Perform eth_newFilter RPC method to install a log filter on the node
+
+Function: web3_eth_newFilter()
+
+    This function calls RPC method eth_newFilter and returns the filter ID.
+    Logs matching the filter from then on could be polled with
+    web3_eth_getFilterChanges(). The node removes filters not polled for a
+    while (5 minutes for geth).
+
+    The buffer storing the string is maintained by web3intf and the caller
+    shall NOT modify it, free it or save the address for later use.
+
+@return
+    This function returns a string of the filter ID, e.g. "0x1".\n
+    If any error occurs or RPC call timeouts, it returns NULL.
+
+@param node_url_str
+        A string indicating the URL of blockchain node.
+
+@param param_ptr
+        The filter of logs.
+
+*******************************************************************************/
+CHAR *web3_eth_newFilter(
+                                    const char *node_url_str,
+                                    const Param_eth_getLogs *param_ptr)
+{
+    CHAR *rpc_response_str;
+    UINT32 rpc_response_len;
+
+    RpcOption rpc_option;
+
+    SINT32 expected_string_size;
+    BOAT_RESULT result;
+    CHAR *return_value_ptr;
+    
+    boat_try_declare;
+    
+
+    g_web3_message_id++;
+    
+    if(    node_url_str == NULL || param_ptr == NULL
+        || param_ptr->from_block_str == NULL || param_ptr->to_block_str == NULL )
+    {
+        BoatLog(BOAT_LOG_NORMAL, "Arguments cannot be NULL.");
+        boat_throw(BOAT_ERROR_NULL_POINTER, web3_eth_newFilter_cleanup);
+    }
+    
+
+    // Construct the REQUEST
+
+    expected_string_size = web3_construct_filter_request("eth_newFilter", param_ptr);
+
+    if( expected_string_size >= WEB3_JSON_STRING_BUF_MAX_SIZE - 1)
+    {
+        boat_throw(BOAT_ERROR_RLP_ENCODING_FAIL, web3_eth_newFilter_cleanup);
+    }
+
+    BoatLog(BOAT_LOG_VERBOSE, "REQUEST: %s", g_web3_json_string_buf);
+
+    // POST the REQUEST through curl
+
+#if RPC_OPTION_HAS_NODE_URL
+    rpc_option.node_url_str = node_url_str;
+#endif
+
+    RpcSetOpt(&rpc_option);
+    
+    result = RpcRequestSync(
+                    (const UINT8*)g_web3_json_string_buf,   // g_web3_json_string_buf stores REQUEST
+                    expected_string_size,
+                    (BOAT_OUT UINT8 **)&rpc_response_str,
+                    &rpc_response_len);
+
+    if( result != BOAT_SUCCESS )
+    {
+        BoatLog(BOAT_LOG_NORMAL, "RpcRequestSync() fails.");
+        boat_throw(result, web3_eth_newFilter_cleanup);
+    }
+
+    BoatLog(BOAT_LOG_VERBOSE, "RESPONSE: %s", rpc_response_str);
+
+    // Parse RESPONSE and get web3_result item "result"
+    result = web3_JSON_parse_item(rpc_response_str, "result");
+
+    if (result != BOAT_SUCCESS)
+    {
+        BoatLog(BOAT_LOG_NORMAL, "Fail to parse RESPONSE as JSON.");
+        boat_throw(BOAT_ERROR_JSON_PARSE_FAIL, web3_eth_newFilter_cleanup);
+    }
+    
+
+    return_value_ptr = g_web3_result_string_buf;
+
+    // Exceptional Clean Up
+    boat_catch(web3_eth_newFilter_cleanup)
+    {
+        BoatLog(BOAT_LOG_NORMAL, "Exception: %d", boat_exception);
+        return_value_ptr = NULL;
+    }
+
+    return return_value_ptr;
+}
+
+
+/*!*****************************************************************************
+@brief Perform eth_getFilterChanges RPC method and decode the logs as a stream
+
+Function: web3_eth_getFilterChanges()
+
+    This function calls RPC method eth_getFilterChanges for a filter installed
+    by web3_eth_newFilter() and calls <log_func> for each log matching the
+    filter since last poll. The RESPONSE is the same as that of eth_getLogs.
+
+@return
+    This function returns BOAT_SUCCESS if all logs are decoded.\n
+    It returns BOAT_ERROR_RPC_NODE_ERROR if the node doesn't know the filter,
+    e.g. it's expired. Otherwise it returns an error code.
+
+@param node_url_str
+        A string indicating the URL of blockchain node.
+
+@param param_ptr
+        The filter ID.
+
+@param log_func
+        The log callback, or NULL to only count logs.
+
+@param log_ctx_ptr
+        Context passed to <log_func>.
+
+@param log_num_ptr
+        Number of logs decoded.
+
+*******************************************************************************/
+BOAT_RESULT web3_eth_getFilterChanges(
+                                    const char *node_url_str,
+                                    const Param_eth_getFilterChanges *param_ptr,
+                                    Web3LogFunc log_func,
+                                    void *log_ctx_ptr,
+                                    BOAT_OUT UINT32 *log_num_ptr)
+{
+    SINT32 expected_string_size;
+
+    g_web3_message_id++;
+    
+    if( node_url_str == NULL || param_ptr == NULL || param_ptr->filter_id_str == NULL || log_num_ptr == NULL )
+    {
+        BoatLog(BOAT_LOG_NORMAL, "Arguments cannot be NULL.");
+        return BOAT_ERROR_NULL_POINTER;
+    }
+
+    // Construct the REQUEST
+    expected_string_size = snprintf(
+             g_web3_json_string_buf,
+             WEB3_JSON_STRING_BUF_MAX_SIZE,
+             "{\"jsonrpc\":\"2.0\",\"method\":\"eth_getFilterChanges\",\"params\":"
+             "[\"%s\"],\"id\":%u}",
+             param_ptr->filter_id_str,
+             g_web3_message_id
+            );
+
+    if( expected_string_size >= WEB3_JSON_STRING_BUF_MAX_SIZE - 1)
+    {
+        return BOAT_ERROR_RLP_ENCODING_FAIL;
+    }
+
+    return web3_request_logs(node_url_str, expected_string_size, log_func, log_ctx_ptr, log_num_ptr);
+}
+
+
+/*!*****************************************************************************
+@brief Perform eth_uninstallFilter RPC method
+
+Function: web3_eth_uninstallFilter()
+
+    This function removes a filter installed by web3_eth_newFilter().
+
+@return
+    This function returns BOAT_SUCCESS if the node removes the filter, or\n
+    BOAT_ERROR if the node doesn't know it. Otherwise it returns an error code.
+
+@param node_url_str
+        A string indicating the URL of blockchain node.
+
+@param param_ptr
+        The filter ID.
+
+*******************************************************************************/
+BOAT_RESULT web3_eth_uninstallFilter(
+                                    const char *node_url_str,
+                                    const Param_eth_getFilterChanges *param_ptr)
+{
+    CHAR *rpc_response_str;
+    UINT32 rpc_response_len;
+    RpcOption rpc_option;
+    SINT32 expected_string_size;
+    cJSON *rpc_response_json_ptr;
+    BOAT_RESULT result;
+
+    g_web3_message_id++;
+    
+    if( node_url_str == NULL || param_ptr == NULL || param_ptr->filter_id_str == NULL )
+    {
+        BoatLog(BOAT_LOG_NORMAL, "Arguments cannot be NULL.");
+        return BOAT_ERROR_NULL_POINTER;
+    }
+
+    // Construct the REQUEST
+    expected_string_size = snprintf(
+             g_web3_json_string_buf,
+             WEB3_JSON_STRING_BUF_MAX_SIZE,
+             "{\"jsonrpc\":\"2.0\",\"method\":\"eth_uninstallFilter\",\"params\":"
+             "[\"%s\"],\"id\":%u}",
+             param_ptr->filter_id_str,
+             g_web3_message_id
+            );
+
+    if( expected_string_size >= WEB3_JSON_STRING_BUF_MAX_SIZE - 1)
+    {
+        return BOAT_ERROR_RLP_ENCODING_FAIL;
+    }
+
+    BoatLog(BOAT_LOG_VERBOSE, "REQUEST: %s", g_web3_json_string_buf);
+
+#if RPC_OPTION_HAS_NODE_URL
+    rpc_option.node_url_str = node_url_str;
+#endif
+
+    RpcSetOpt(&rpc_option);
+    
+    result = RpcRequestSync(
+                    (const UINT8*)g_web3_json_string_buf,   // g_web3_json_string_buf stores REQUEST
+                    expected_string_size,
+                    (BOAT_OUT UINT8 **)&rpc_response_str,
+                    &rpc_response_len);
+
+    if( result != BOAT_SUCCESS )
+    {
+        BoatLog(BOAT_LOG_NORMAL, "RpcRequestSync() fails.");
+        return result;
+    }
+
+    BoatLog(BOAT_LOG_VERBOSE, "RESPONSE: %s", rpc_response_str);
+
+    // "result" is a boolean, which web3_JSON_parse_item() doesn't take
+    rpc_response_json_ptr = cJSON_Parse(rpc_response_str);
+    if( rpc_response_json_ptr == NULL ) return BOAT_ERROR_JSON_PARSE_FAIL;
+
+    if( cJSON_IsTrue(cJSON_GetObjectItemCaseSensitive(rpc_response_json_ptr, "result")) )
+    {
+        result = BOAT_SUCCESS;
+    }
+    else
+    {
+        result = BOAT_ERROR;
+    }
+
+    cJSON_Delete(rpc_response_json_ptr);
+
+    return result;
+}
+
+
+#if RPC_SUPPORT_NOTIFICATION
+/*!*****************************************************************************
+@brief Perform eth_subscribe RPC method
+
+Function: web3_eth_subscribe()
+
+    This function calls RPC method eth_subscribe and returns the subscription
+    ID. The node then pushes a notification over the connection for each event
+    of the kind, e.g. a block header for "newHeads", until the subscription is
+    cancelled with web3_eth_unsubscribe() or the connection is lost.
+    Notifications are received with web3_wait_subscription().
+
+    The buffer storing the string is maintained by web3intf and the caller
+    shall NOT modify it, free it or save the address for later use.
+
+@return
+    This function returns a string of the subscription ID.\n
+    If any error occurs or RPC call timeouts, it returns NULL.
+
+@param node_url_str
+        A string indicating the URL of blockchain node, e.g. "ws://127.0.0.1:8546".
+
+@param param_ptr
+        The kind of subscription.
+
+*******************************************************************************/
+CHAR *web3_eth_subscribe(
+                                    const char *node_url_str,
+                                    const Param_eth_subscribe *param_ptr)
+{
+    CHAR *rpc_response_str;
+    UINT32 rpc_response_len;
+
+    RpcOption rpc_option;
+
+    SINT32 expected_string_size;
+    BOAT_RESULT result;
+    CHAR *return_value_ptr;
+    
+    boat_try_declare;
+    
+
+    g_web3_message_id++;
+    
+    if( node_url_str == NULL || param_ptr == NULL || param_ptr->kind_str == NULL )
+    {
+        BoatLog(BOAT_LOG_NORMAL, "Arguments cannot be NULL.");
+        boat_throw(BOAT_ERROR_NULL_POINTER, web3_eth_subscribe_cleanup);
+    }
+    
+
+    // Construct the REQUEST
+    expected_string_size = snprintf(
+             g_web3_json_string_buf,
+             WEB3_JSON_STRING_BUF_MAX_SIZE,
+             "{\"jsonrpc\":\"2.0\",\"method\":\"eth_subscribe\",\"params\":"
+             "[\"%s\"],\"id\":%u}",
+             param_ptr->kind_str,
+             g_web3_message_id
+            );
+
+    if( expected_string_size >= WEB3_JSON_STRING_BUF_MAX_SIZE - 1)
+    {
+        boat_throw(BOAT_ERROR_RLP_ENCODING_FAIL, web3_eth_subscribe_cleanup);
+    }
+
+    BoatLog(BOAT_LOG_VERBOSE, "REQUEST: %s", g_web3_json_string_buf);
+
+    rpc_option.node_url_str = node_url_str;
+
+    RpcSetOpt(&rpc_option);
+    
+    result = RpcRequestSync(
+                    (const UINT8*)g_web3_json_string_buf,   // g_web3_json_string_buf stores REQUEST
+                    expected_string_size,
+                    (BOAT_OUT UINT8 **)&rpc_response_str,
+                    &rpc_response_len);
+
+    if( result != BOAT_SUCCESS )
+    {
+        BoatLog(BOAT_LOG_NORMAL, "RpcRequestSync() fails.");
+        boat_throw(result, web3_eth_subscribe_cleanup);
+    }
+
+    BoatLog(BOAT_LOG_VERBOSE, "RESPONSE: %s", rpc_response_str);
+
+    // Parse RESPONSE and get web3_result item "result"
+    result = web3_JSON_parse_item(rpc_response_str, "result");
+
+    if (result != BOAT_SUCCESS)
+    {
+        BoatLog(BOAT_LOG_NORMAL, "Fail to parse RESPONSE as JSON.");
+        boat_throw(BOAT_ERROR_JSON_PARSE_FAIL, web3_eth_subscribe_cleanup);
+    }
+    
+
+    return_value_ptr = g_web3_result_string_buf;
+
+    // Exceptional Clean Up
+    boat_catch(web3_eth_subscribe_cleanup)
+    {
+        BoatLog(BOAT_LOG_NORMAL, "Exception: %d", boat_exception);
+        return_value_ptr = NULL;
+    }
+
+    return return_value_ptr;
+}
+
+
+/*!*****************************************************************************
+@brief Perform eth_unsubscribe RPC method
+
+Function: web3_eth_unsubscribe()
+
+    This function cancels a subscription made by web3_eth_subscribe().
+    Notifications of it already received are dropped by later calls to
+    web3_wait_subscription().
+
+@return
+    This function returns BOAT_SUCCESS if the node cancels the subscription,
+    or BOAT_ERROR if the node doesn't know it. Otherwise it returns an error
+    code.
+
+@param node_url_str
+        A string indicating the URL of blockchain node.
+
+@param param_ptr
+        The subscription ID.
+
+*******************************************************************************/
+BOAT_RESULT web3_eth_unsubscribe(
+                                    const char *node_url_str,
+                                    const Param_eth_unsubscribe *param_ptr)
+{
+    CHAR *rpc_response_str;
+    UINT32 rpc_response_len;
+    RpcOption rpc_option;
+    SINT32 expected_string_size;
+    cJSON *rpc_response_json_ptr;
+    BOAT_RESULT result;
+
+    g_web3_message_id++;
+    
+    if( node_url_str == NULL || param_ptr == NULL || param_ptr->subscription_id_str == NULL )
+    {
+        BoatLog(BOAT_LOG_NORMAL, "Arguments cannot be NULL.");
+        return BOAT_ERROR_NULL_POINTER;
+    }
+
+    // Construct the REQUEST
+    expected_string_size = snprintf(
+             g_web3_json_string_buf,
+             WEB3_JSON_STRING_BUF_MAX_SIZE,
+             "{\"jsonrpc\":\"2.0\",\"method\":\"eth_unsubscribe\",\"params\":"
+             "[\"%s\"],\"id\":%u}",
+             param_ptr->subscription_id_str,
+             g_web3_message_id
+            );
+
+    if( expected_string_size >= WEB3_JSON_STRING_BUF_MAX_SIZE - 1)
+    {
+        return BOAT_ERROR_RLP_ENCODING_FAIL;
+    }
+
+    BoatLog(BOAT_LOG_VERBOSE, "REQUEST: %s", g_web3_json_string_buf);
+
+    rpc_option.node_url_str = node_url_str;
+
+    RpcSetOpt(&rpc_option);
+    
+    result = RpcRequestSync(
+                    (const UINT8*)g_web3_json_string_buf,   // g_web3_json_string_buf stores REQUEST
+                    expected_string_size,
+                    (BOAT_OUT UINT8 **)&rpc_response_str,
+                    &rpc_response_len);
+
+    if( result != BOAT_SUCCESS )
+    {
+        BoatLog(BOAT_LOG_NORMAL, "RpcRequestSync() fails.");
+        return result;
+    }
+
+    BoatLog(BOAT_LOG_VERBOSE, "RESPONSE: %s", rpc_response_str);
+
+    // "result" is a boolean, which web3_JSON_parse_item() doesn't take
+    rpc_response_json_ptr = cJSON_Parse(rpc_response_str);
+    if( rpc_response_json_ptr == NULL ) return BOAT_ERROR_JSON_PARSE_FAIL;
+
+    if( cJSON_IsTrue(cJSON_GetObjectItemCaseSensitive(rpc_response_json_ptr, "result")) )
+    {
+        result = BOAT_SUCCESS;
+    }
+    else
+    {
+        result = BOAT_ERROR;
+    }
+
+    cJSON_Delete(rpc_response_json_ptr);
+
+    return result;
+}
+
+
+/*!*****************************************************************************
+@brief Wait for a notification of a subscription
+
+Function: web3_wait_subscription()
+
+    This function waits up to <timeout_ms> for the node to push a notification
+    of the subscription made by web3_eth_subscribe(). Notifications of other
+    subscriptions received meanwhile are dropped.
+
+    It must be called from the thread that made the subscription, because the
+    notifications arrive over that thread's connection.
+
+@return
+    This function returns BOAT_SUCCESS if a notification arrives,
+    BOAT_ERROR_RPC_TIMEOUT if none arrives in time, or other error codes, e.g.
+    BOAT_ERROR_RPC_FAIL if the connection is lost and thus the subscription.
+
+@param param_ptr
+        The subscription ID.
+
+@param timeout_ms
+        Max time to wait, in millisecond.
+
+*******************************************************************************/
+BOAT_RESULT web3_wait_subscription(
+                                    const Param_eth_unsubscribe *param_ptr,
+                                    UINT32 timeout_ms)
+{
+    CHAR *notification_str;
+    UINT32 notification_len;
+    cJSON *notification_json_ptr;
+    cJSON *subscription_json_ptr;
+    UINT64 deadline_ms;
+    UINT64 now_ms;
+    BOAT_RESULT result;
+
+    if( param_ptr == NULL || param_ptr->subscription_id_str == NULL )
+    {
+        BoatLog(BOAT_LOG_NORMAL, "Arguments cannot be NULL.");
+        return BOAT_ERROR_NULL_POINTER;
+    }
+
+    deadline_ms = BoatGetTimeMs() + timeout_ms;
+
+    while( 1 )
+    {
+        now_ms = BoatGetTimeMs();
+
+        result = RpcWaitNotification(
+                    now_ms < deadline_ms ? (UINT32)(deadline_ms - now_ms) : 0,
+                    (BOAT_OUT UINT8 **)&notification_str,
+                    &notification_len);
+
+        if( result != BOAT_SUCCESS ) return result;
+
+        BoatLog(BOAT_LOG_VERBOSE, "NOTIFICATION: %s", notification_str);
+
+        // {"jsonrpc":"2.0","method":"eth_subscription","params":{"subscription":"0x...","result":{...}}}
+        notification_json_ptr = cJSON_Parse(notification_str);
+        if( notification_json_ptr == NULL ) continue;
+
+        subscription_json_ptr = cJSON_GetObjectItemCaseSensitive(
+                                    cJSON_GetObjectItemCaseSensitive(notification_json_ptr, "params"),
+                                    "subscription");
+
+        if(    cJSON_IsString(subscription_json_ptr)
+            && strcmp(subscription_json_ptr->valuestring, param_ptr->subscription_id_str) == 0 )
+        {
+            cJSON_Delete(notification_json_ptr);
+            return BOAT_SUCCESS;
+        }
+
+        cJSON_Delete(notification_json_ptr);
+    }
+}
+#endif
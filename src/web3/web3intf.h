@@ -111,6 +111,96 @@ CHAR *web3_eth_call(
                                     const char *node_url_str,
                                     const Param_eth_call *param_ptr);
 
+CHAR *web3_eth_blockNumber(const char *node_url_str);
+
+
+//!@brief Maximum topics of a log
+#define WEB3_LOG_MAX_TOPICS 4
+
+//!@brief A log decoded from RPC RESPONSE
+typedef struct TWeb3Log
+{
+    UINT8 address[20];                      //!< Contract emitting the log
+    UINT8 topics[WEB3_LOG_MAX_TOPICS][32];  //!< Topics, topics[0] is the event signature for non-anonymous events
+    UINT32 topic_num;                       //!< Number of topics
+    const UINT8 *data_ptr;                  //!< Non-indexed arguments, valid only during the log callback
+    UINT32 data_len;                        //!< Length of data
+    UINT64 block_number;                    //!< Block containing the log, 0 if pending
+    UINT32 log_index;                       //!< Position of the log in the block
+    UINT8 tx_hash[32];                      //!< Transaction emitting the log
+    BOATBOOL removed;                       //!< BOAT_TRUE if the log is removed by a chain reorganization
+}Web3Log;
+
+/*!@brief Log callback
+
+A log callback is called for each log as it's decoded from RPC RESPONSE. The
+decoding stops if it returns anything other than BOAT_SUCCESS.
+*/
+typedef BOAT_RESULT (*Web3LogFunc)(void *log_ctx_ptr, const Web3Log *log_ptr);
+
+//!@brief Parameter for web3_eth_getLogs() and web3_eth_newFilter()
+typedef struct TParam_eth_getLogs
+{
+    CHAR *from_block_str;   //!< String of either block number or one of "latest", "earliest" and "pending"
+    CHAR *to_block_str;     //!< String of either block number or one of "latest", "earliest" and "pending"
+    CHAR *address_str;      //!< String of the contract address, or NULL for any contract
+    CHAR *topics_str;       //!< JSON array of topic filters, e.g. "[\"0x1234...\",null]", or NULL for any
+}Param_eth_getLogs;
+
+BOAT_RESULT web3_eth_getLogs(
+                                    const char *node_url_str,
+                                    const Param_eth_getLogs *param_ptr,
+                                    Web3LogFunc log_func,
+                                    void *log_ctx_ptr,
+                                    BOAT_OUT UINT32 *log_num_ptr);
+
+CHAR *web3_eth_newFilter(
+                                    const char *node_url_str,
+                                    const Param_eth_getLogs *param_ptr);
+
+//!@brief Parameter for web3_eth_getFilterChanges() and web3_eth_uninstallFilter()
+typedef struct TParam_eth_getFilterChanges
+{
+    CHAR *filter_id_str;    //!< String of filter ID returned by web3_eth_newFilter()
+}Param_eth_getFilterChanges;
+
+BOAT_RESULT web3_eth_getFilterChanges(
+                                    const char *node_url_str,
+                                    const Param_eth_getFilterChanges *param_ptr,
+                                    Web3LogFunc log_func,
+                                    void *log_ctx_ptr,
+                                    BOAT_OUT UINT32 *log_num_ptr);
+
+BOAT_RESULT web3_eth_uninstallFilter(
+                                    const char *node_url_str,
+                                    const Param_eth_getFilterChanges *param_ptr);
+
+#if RPC_SUPPORT_NOTIFICATION
+//!@brief Parameter for web3_eth_subscribe()
+typedef struct TParam_eth_subscribe
+{
+    CHAR *kind_str;     //!< Kind of subscription, e.g. "newHeads" or "newPendingTransactions"
+}Param_eth_subscribe;
+
+CHAR *web3_eth_subscribe(
+                                    const char *node_url_str,
+                                    const Param_eth_subscribe *param_ptr);
+
+//!@brief Parameter for web3_eth_unsubscribe() and web3_wait_subscription()
+typedef struct TParam_eth_unsubscribe
+{
+    CHAR *subscription_id_str;  //!< String of subscription ID returned by web3_eth_subscribe()
+}Param_eth_unsubscribe;
+
+BOAT_RESULT web3_eth_unsubscribe(
+                                    const char *node_url_str,
+                                    const Param_eth_unsubscribe *param_ptr);
+
+BOAT_RESULT web3_wait_subscription(
+                                    const Param_eth_unsubscribe *param_ptr,
+                                    UINT32 timeout_ms);
+#endif
+
 #ifdef __cplusplus
 }
 #endif /* end of __cplusplus */
@@ -0,0 +1,205 @@
+/******************************************************************************
+Copyright (C) 2018-2019 AITOS.IO
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+of the Software, and to permit persons to whom the Software is furnished to do
+so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+******************************************************************************/
+
+/*!@brief Tests of the log synchronization
+
+The file is included rather than linked so that the static log callback of a
+synchronization can be fed directly, without a blockchain node.
+*/
+
+#include "wallet/eventlog.c"
+
+#include <stdio.h>
+
+
+static UINT32 g_test_failures = 0;
+
+#define TEST_CHECK(cond) \
+    do { if( !(cond) ) { printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond); g_test_failures++; } } while(0)
+
+
+typedef struct TTestLogRecord
+{
+    UINT64 block_number;
+    UINT32 log_index;
+    BOATBOOL removed;
+    UINT8 data;
+}TestLogRecord;
+
+typedef struct TTestLogSink
+{
+    TestLogRecord records[16];
+    UINT32 record_num;
+}TestLogSink;
+
+
+static BOAT_RESULT TestLogSinkOnLog(void *log_ctx_ptr, const Web3Log *log_ptr)
+{
+    TestLogSink *sink_ptr = (TestLogSink *)log_ctx_ptr;
+    TestLogRecord *record_ptr;
+
+    if( sink_ptr->record_num >= sizeof(sink_ptr->records) / sizeof(sink_ptr->records[0]) )
+    {
+        return BOAT_ERROR_OUT_OF_MEMORY;
+    }
+
+    record_ptr = &sink_ptr->records[sink_ptr->record_num++];
+    record_ptr->block_number = log_ptr->block_number;
+    record_ptr->log_index = log_ptr->log_index;
+    record_ptr->removed = log_ptr->removed;
+    record_ptr->data = log_ptr->data_len > 0 ? log_ptr->data_ptr[0] : 0;
+
+    return BOAT_SUCCESS;
+}
+
+
+static void TestLogSyncSetUp(BoatLogSync *sync_ptr, TestLogSink *sink_ptr, UINT64 from_block)
+{
+    memset(sync_ptr, 0, sizeof(BoatLogSync));
+    memset(sink_ptr, 0, sizeof(TestLogSink));
+
+    BoatLogFilterInit(&sync_ptr->filter, NULL);
+    sync_ptr->log_func = TestLogSinkOnLog;
+    sync_ptr->log_ctx_ptr = sink_ptr;
+    sync_ptr->next_block = from_block;
+}
+
+
+static void TestLogSyncFeed(BoatLogSync *sync_ptr, UINT64 block_number, UINT32 log_index,
+                            BOATBOOL removed, UINT8 data)
+{
+    Web3Log log;
+
+    memset(&log, 0, sizeof(log));
+    log.block_number = block_number;
+    log.log_index = log_index;
+    log.removed = removed;
+    log.data_ptr = &data;
+    log.data_len = 1;
+
+    TEST_CHECK(LogSyncOnLog(sync_ptr, &log) == BOAT_SUCCESS);
+}
+
+
+static void TestLogSyncReorg(void)
+{
+    BoatLogSync sync;
+    TestLogSink sink;
+    UINT32 i;
+
+    TestLogSyncSetUp(&sync, &sink, 10);
+
+    TestLogSyncFeed(&sync, 10, 0, BOAT_FALSE, 0xA0);
+    TestLogSyncFeed(&sync, 10, 1, BOAT_FALSE, 0xA1);
+    TestLogSyncFeed(&sync, 11, 0, BOAT_FALSE, 0xB0);
+    sync.next_block = 12;
+
+    // The new chain drops block 11 and reorders block 10
+    TestLogSyncFeed(&sync, 11, 0, BOAT_TRUE, 0xB0);
+    TestLogSyncFeed(&sync, 10, 1, BOAT_TRUE, 0xA1);
+    TEST_CHECK(sync.delivered_any == BOAT_TRUE);
+    TEST_CHECK(sync.last_block == 10 && sync.last_log_index == 0);
+    TEST_CHECK(sync.next_block == 10);
+
+    TestLogSyncFeed(&sync, 10, 1, BOAT_FALSE, 0xC1);
+    TestLogSyncFeed(&sync, 10, 2, BOAT_FALSE, 0xC2);
+    TestLogSyncFeed(&sync, 11, 0, BOAT_FALSE, 0xD0);
+
+    // Logs polled again are still skipped
+    TestLogSyncFeed(&sync, 10, 0, BOAT_FALSE, 0xA0);
+    TestLogSyncFeed(&sync, 10, 2, BOAT_FALSE, 0xC2);
+
+    TEST_CHECK(sink.record_num == 8);
+    TEST_CHECK(sync.stats.delivered == 8);
+    TEST_CHECK(sync.stats.duplicates == 2);
+    TEST_CHECK(sync.last_block == 11 && sync.last_log_index == 0);
+
+    for( i = 0; i < sink.record_num; i++ )
+    {
+        TEST_CHECK(sink.records[i].removed == (i == 3 || i == 4 ? BOAT_TRUE : BOAT_FALSE));
+    }
+    TEST_CHECK(sink.records[5].block_number == 10 && sink.records[5].log_index == 1 && sink.records[5].data == 0xC1);
+    TEST_CHECK(sink.records[7].block_number == 11 && sink.records[7].data == 0xD0);
+}
+
+
+static void TestLogSyncReorgBlockStart(void)
+{
+    BoatLogSync sync;
+    TestLogSink sink;
+
+    TestLogSyncSetUp(&sync, &sink, 0);
+
+    // A removed first log of a block rewinds to the end of the previous block
+    TestLogSyncFeed(&sync, 5, 0, BOAT_FALSE, 0x50);
+    TestLogSyncFeed(&sync, 5, 0, BOAT_TRUE, 0x50);
+    TEST_CHECK(sync.delivered_any == BOAT_TRUE);
+    TEST_CHECK(sync.last_block == 4 && sync.last_log_index == 0xFFFFFFFF);
+    TestLogSyncFeed(&sync, 5, 0, BOAT_FALSE, 0x51);
+
+    // A removed log of block 0 leaves nothing delivered
+    TestLogSyncSetUp(&sync, &sink, 0);
+    TestLogSyncFeed(&sync, 0, 0, BOAT_FALSE, 0x00);
+    TestLogSyncFeed(&sync, 0, 0, BOAT_TRUE, 0x00);
+    TEST_CHECK(sync.delivered_any == BOAT_FALSE);
+    TestLogSyncFeed(&sync, 0, 0, BOAT_FALSE, 0x01);
+
+    TEST_CHECK(sink.record_num == 3);
+    TEST_CHECK(sync.stats.duplicates == 0);
+    TEST_CHECK(sink.records[2].removed == BOAT_FALSE && sink.records[2].data == 0x01);
+}
+
+
+static void TestLogSyncRemovedAhead(void)
+{
+    BoatLogSync sync;
+    TestLogSink sink;
+
+    TestLogSyncSetUp(&sync, &sink, 0);
+
+    // A removed log never delivered doesn't move the position
+    TestLogSyncFeed(&sync, 7, 3, BOAT_FALSE, 0x73);
+    TestLogSyncFeed(&sync, 8, 0, BOAT_TRUE, 0x80);
+    TEST_CHECK(sync.last_block == 7 && sync.last_log_index == 3);
+    TestLogSyncFeed(&sync, 7, 3, BOAT_FALSE, 0x73);
+    TEST_CHECK(sync.stats.duplicates == 1);
+}
+
+
+int main(int argc, char *argv[])
+{
+    (void)argc;
+    (void)argv;
+
+    TestLogSyncReorg();
+    TestLogSyncReorgBlockStart();
+    TestLogSyncRemovedAhead();
+
+    if( g_test_failures != 0 )
+    {
+        printf("eventlog_test: %u failure(s)\n", g_test_failures);
+        return 1;
+    }
+
+    printf("eventlog_test: passed\n");
+    return 0;
+}
@@ -0,0 +1,180 @@
+/******************************************************************************
+Copyright (C) 2018-2019 AITOS.IO
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+of the Software, and to permit persons to whom the Software is furnished to do
+so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+******************************************************************************/
+
+
+/*!@brief Tests of the multi-buffer keccak_256
+
+keccak_256_x4() and keccak_256_x8() are checked against the scalar keccak_256()
+on random messages. sha3.c is included rather than linked so that it's built
+with the SIMD flags of this test, see test/Makefile.
+*/
+
+#include "sha3.c"
+
+#include <stdio.h>
+
+
+static unsigned int g_test_failures = 0;
+
+#define TEST_CHECK(cond) \
+    do { if( !(cond) ) { printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond); g_test_failures++; } } while(0)
+
+#define TEST_MAX_LANES    8
+#define TEST_MAX_MSG_LEN  (4 * SHA3_256_BLOCK_LENGTH + 1)
+#define TEST_ROUNDS       200
+
+
+static uint32_t g_test_random = 0x2545F491;
+
+// xorshift32, the same messages in every run
+static uint32_t TestRandom(void)
+{
+    g_test_random ^= g_test_random << 13;
+    g_test_random ^= g_test_random >> 17;
+    g_test_random ^= g_test_random << 5;
+    return g_test_random;
+}
+
+
+static void TestKeccakBatch(unsigned lanes, const size_t len[])
+{
+    static unsigned char msg[TEST_MAX_LANES][TEST_MAX_MSG_LEN];
+    unsigned char digest[TEST_MAX_LANES][32];
+    unsigned char expected[32];
+    const unsigned char *data_ptr[TEST_MAX_LANES];
+    unsigned char *digest_ptr[TEST_MAX_LANES];
+    unsigned l;
+    size_t i;
+
+    for( l = 0; l < lanes; l++ )
+    {
+        for( i = 0; i < len[l]; i++ )
+        {
+            msg[l][i] = (unsigned char)TestRandom();
+        }
+        data_ptr[l] = msg[l];
+        digest_ptr[l] = digest[l];
+    }
+
+    if( lanes == 4 )
+    {
+        keccak_256_x4(data_ptr, len, digest_ptr);
+    }
+    else
+    {
+        keccak_256_x8(data_ptr, len, digest_ptr);
+    }
+
+    for( l = 0; l < lanes; l++ )
+    {
+        keccak_256(msg[l], len[l], expected);
+        if( memcmp(digest[l], expected, sizeof(expected)) != 0 )
+        {
+            printf("FAIL x%u lane %u of %u bytes\n", lanes, l, (unsigned)len[l]);
+            g_test_failures++;
+        }
+    }
+}
+
+
+// All messages of the same length, absorbed and padded in parallel
+static void TestKeccakEqualLength(unsigned lanes)
+{
+    static const size_t lengths[] = {0, 1, 31, 32, 64, 65, 135, 136, 137, 271, 272, 273, 500};
+    size_t len[TEST_MAX_LANES];
+    unsigned i, l;
+
+    for( i = 0; i < sizeof(lengths) / sizeof(lengths[0]); i++ )
+    {
+        for( l = 0; l < lanes; l++ )
+        {
+            len[l] = lengths[i];
+        }
+        TestKeccakBatch(lanes, len);
+    }
+}
+
+
+// Same number of full blocks, different tails padded in parallel
+static void TestKeccakSameBlocks(unsigned lanes)
+{
+    size_t len[TEST_MAX_LANES];
+    unsigned round, l;
+
+    for( round = 0; round < TEST_ROUNDS; round++ )
+    {
+        size_t blocks = TestRandom() % 4;
+        for( l = 0; l < lanes; l++ )
+        {
+            len[l] = blocks * SHA3_256_BLOCK_LENGTH + TestRandom() % SHA3_256_BLOCK_LENGTH;
+        }
+        TestKeccakBatch(lanes, len);
+    }
+}
+
+
+// Lengths differing by a block or more, finished one message at a time
+static void TestKeccakMixedLength(unsigned lanes)
+{
+    size_t len[TEST_MAX_LANES];
+    unsigned round, l;
+
+    for( round = 0; round < TEST_ROUNDS; round++ )
+    {
+        for( l = 0; l < lanes; l++ )
+        {
+            len[l] = TestRandom() % TEST_MAX_MSG_LEN;
+        }
+        TestKeccakBatch(lanes, len);
+    }
+}
+
+
+int main(int argc, char *argv[])
+{
+    unsigned lanes;
+
+    (void)argc;
+    (void)argv;
+
+    for( lanes = 4; lanes <= 8; lanes += 4 )
+    {
+        TestKeccakEqualLength(lanes);
+        TestKeccakSameBlocks(lanes);
+        TestKeccakMixedLength(lanes);
+    }
+
+    if( g_test_failures != 0 )
+    {
+        printf("keccak_test: %u failure(s)\n", g_test_failures);
+        return 1;
+    }
+
+#if defined(KECCAK_MB_X8)
+    printf("keccak_test: passed (x4 and x8 SIMD)\n");
+#elif defined(KECCAK_MB_X4)
+    printf("keccak_test: passed (x4 SIMD)\n");
+#else
+    printf("keccak_test: passed (scalar)\n");
+#endif
+    return 0;
+}
@@ -0,0 +1,139 @@
+/******************************************************************************
+Copyright (C) 2018-2019 AITOS.IO
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+of the Software, and to permit persons to whom the Software is furnished to do
+so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+******************************************************************************/
+
+
+/*!@brief Tests of the memory-mapped keystore cache
+
+A container with two accounts is mapped with a single cache slot, so that
+every miss has to evict the other account.
+*/
+
+// For mkstemp()
+#define _DEFAULT_SOURCE
+
+#include "wallet/boatwallet.h"
+#include "wallet/keystore.h"
+#include "wallet/keymap.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+
+static UINT32 g_test_failures = 0;
+
+#define TEST_CHECK(cond) \
+    do { if( !(cond) ) { printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond); g_test_failures++; } } while(0)
+
+
+static CHAR g_test_node_url_str[] = "http://127.0.0.1:7545";
+
+
+static void TestKeymapAccount(UINT8 seed, BOAT_OUT BoatWalletInfo *wallet_info_ptr)
+{
+    UINT8 priv_key_array[32];
+    UINT32 i;
+
+    for( i = 0; i < sizeof(priv_key_array); i++ )
+    {
+        priv_key_array[i] = (UINT8)(seed + i);
+    }
+
+    BoatWalletSetPrivkey(priv_key_array);
+    memcpy(wallet_info_ptr, &g_boat_wallet_info, sizeof(BoatWalletInfo));
+    wallet_info_ptr->network_info.node_url_ptr = g_test_node_url_str;
+}
+
+
+// A wrong password must not evict the cached account
+static void TestKeymapWrongPassword(const CHAR *container_path_str)
+{
+    BoatKeystoreContainer container;
+    BoatKeystoreMap map;
+    BoatWalletInfo account_a;
+    BoatWalletInfo account_b;
+    const BoatWalletInfo *cached_ptr;
+
+    TestKeymapAccount(0x01, &account_a);
+    TestKeymapAccount(0x40, &account_b);
+
+    TEST_CHECK(BoatKeystoreContainerOpen(&container, container_path_str, BOAT_TRUE) == BOAT_SUCCESS);
+    TEST_CHECK(BoatKeystoreContainerAppend(&container, &account_a, (const UINT8 *)"pass-a", 6) == BOAT_SUCCESS);
+    TEST_CHECK(BoatKeystoreContainerAppend(&container, &account_b, (const UINT8 *)"pass-b", 6) == BOAT_SUCCESS);
+    BoatKeystoreContainerClose(&container);
+
+    if( BoatKeystoreMapOpen(&map, container_path_str, 1) != BOAT_SUCCESS )
+    {
+        printf("FAIL %s:%d: unable to map %s\n", __FILE__, __LINE__, container_path_str);
+        g_test_failures++;
+        return;
+    }
+
+    cached_ptr = BoatKeystoreMapGet(&map, account_a.account_info.address, (const UINT8 *)"pass-a", 6);
+    TEST_CHECK(cached_ptr != NULL);
+
+    TEST_CHECK(BoatKeystoreMapGet(&map, account_b.account_info.address, (const UINT8 *)"wrong!", 6) == NULL);
+    TEST_CHECK(map.slot_array[0].last_use != 0);
+    TEST_CHECK(memcmp(map.slot_array[0].wallet_info.account_info.address,
+                      account_a.account_info.address,
+                      sizeof(BoatAddress)) == 0);
+
+    cached_ptr = BoatKeystoreMapGet(&map, account_b.account_info.address, (const UINT8 *)"pass-b", 6);
+    TEST_CHECK(cached_ptr != NULL);
+    TEST_CHECK(cached_ptr != NULL
+               && memcmp(cached_ptr->account_info.priv_key_array,
+                         account_b.account_info.priv_key_array,
+                         sizeof(account_b.account_info.priv_key_array)) == 0);
+
+    BoatKeystoreMapClose(&map);
+}
+
+
+int main(int argc, char *argv[])
+{
+    CHAR container_path_str[] = "/tmp/keymap_test_XXXXXX";
+    int fd;
+
+    (void)argc;
+    (void)argv;
+
+    fd = mkstemp(container_path_str);
+    if( fd < 0 )
+    {
+        printf("keymap_test: unable to create a temporary file\n");
+        return 1;
+    }
+    close(fd);
+
+    TestKeymapWrongPassword(container_path_str);
+
+    unlink(container_path_str);
+
+    if( g_test_failures != 0 )
+    {
+        printf("keymap_test: %u failure(s)\n", g_test_failures);
+        return 1;
+    }
+
+    printf("keymap_test: passed\n");
+    return 0;
+}